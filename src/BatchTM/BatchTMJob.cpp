@@ -25,6 +25,7 @@
 
 #include "BatchTM/BatchTMJob.h"
 #include "Exif/ExifOperations.h"
+#include "Libpfs/bufferarena.h"
 #include "Libpfs/progress.h"
 #include "Libpfs/frame.h"
 #include "Libpfs/manip/copy.h"
@@ -61,6 +62,8 @@ void BatchTMJob::run()
 {
     pfs::Progress prog_helper;
     IOWorker io_worker;
+    // temporaries of the operators, reused by all the tone mappings of the job
+    pfs::BufferArena arena;
 
     emit add_log_message(tr("[T%1] Start processing %2").arg(m_thread_id).arg(QFileInfo(m_file_name).completeBaseName()));
 
@@ -100,6 +103,7 @@ void BatchTMJob::run()
             }
 
             QScopedPointer<TonemapOperator> tm_operator( TonemapOperator::getTonemapOperator(opts->tmoperator) );
+            tm_operator->setBufferArena(&arena);
 
             tm_operator->tonemapFrame(*temporary_frame, opts, prog_helper);
 
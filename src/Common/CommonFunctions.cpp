@@ -34,6 +34,7 @@
 #include "LuminanceOptions.h"
 #include "Exif/ExifOperations.h"
 #include <Libpfs/frame.h>
+#include <Libpfs/fftplancache.h>
 #include <Libpfs/params.h>
 #include <Libpfs/utils/msec_timer.h>
 #include <Libpfs/io/tiffwriter.h>
@@ -44,6 +45,7 @@
 #include <Libpfs/io/framewriterfactory.h>
 #include <Libpfs/exif/exifdata.hpp>
 #include <Libpfs/utils/transform.h>
+#include <Libpfs/utils/histogram.h>
 #include <Libpfs/manip/shift.h>
 #include <Libpfs/manip/rotate.h>
 #include <Libpfs/manip/copy.h>
@@ -61,19 +63,37 @@ using namespace std;
 using namespace pfs;
 using namespace pfs::io;
 
-static void build_histogram(valarray<float> &hist, const valarray<int> &src)
+namespace
 {
-    const int size = src.size();
-    for (int i = 0; i < size; i++)
+// HSL lightness, red, green and blue of each pixel
+struct AutolevelsSamples
+{
+    explicit AutolevelsSamples(const QRgb* pixels)
+        : m_pixels(pixels)
+    {}
+
+    void operator()(size_t i, float* values) const
     {
-        hist[src[i]] += 1.f;
+        const QRgb pixel = m_pixels[i];
+        values[0] = QColor::fromRgb(pixel).toHsl().lightness();
+        values[1] = qRed(pixel);
+        values[2] = qGreen(pixel);
+        values[3] = qBlue(pixel);
     }
 
-    //find max
-    float hist_max = hist.max();
+private:
+    const QRgb* m_pixels;
+};
 
-    //normalize in the range [0...1]
-    hist /= hist_max;
+valarray<float> toValarray(const utils::Histogram& hist)
+{
+    valarray<float> result(hist.bins());
+    for (size_t i = 0; i < hist.bins(); i++)
+    {
+        result[i] = static_cast<float>(hist.count(i));
+    }
+    return result;
+}
 }
 
 static void compute_histogram_minmax(const valarray<float> &hist, const float threshold, float &minHist, float &maxHist)
@@ -154,44 +174,18 @@ void computeAutolevels(const QImage* data, const float threshold, float &minHist
     float minG, maxG;
     float minB, maxB;
 
-    //Convert to lightness
-    valarray<int> lightness(ELEMENTS);
-
-    for (int i = 0;  i < ELEMENTS; i++)
+    // lightness, red, green and blue histograms in a single pass
+    utils::Histogram hist[4];
+    for (int c = 0; c < 4; c++)
     {
-        lightness[i] = QColor::fromRgb(src[i]).toHsl().lightness();
+        hist[c] = utils::Histogram(COLOR_DEPTH, 0.f, COLOR_DEPTH);
     }
-    //Build histogram
-    valarray<float> histL(0.f, COLOR_DEPTH);
-    build_histogram(histL, lightness);
-    compute_histogram_minmax(histL, threshold, minL, maxL);
-
-    //get Red, Gree, Blue
-    valarray<int> red(ELEMENTS);
-    valarray<int> green(ELEMENTS);
-    valarray<int> blue(ELEMENTS);
-
-    for (int i = 0;  i < ELEMENTS; i++)
-    {
-        red[i] = qRed(src[i]);
-        green[i] = qGreen(src[i]);
-        blue[i] = qBlue(src[i]);
-    }
-
-    //Build histogram
-    valarray<float> histR(0.f, COLOR_DEPTH);
-    build_histogram(histR, red);
-    compute_histogram_minmax(histR, threshold, minR, maxR);
-
-    //Build histogram
-    valarray<float> histG(0.f, COLOR_DEPTH);
-    build_histogram(histG, green);
-    compute_histogram_minmax(histG, threshold, minG, maxG);
+    utils::computeHistograms(ELEMENTS, hist, 4, AutolevelsSamples(src));
 
-    //Build histogram
-    valarray<float> histB(0.f, COLOR_DEPTH);
-    build_histogram(histB, blue);
-    compute_histogram_minmax(histB, threshold, minB, maxB);
+    compute_histogram_minmax(toValarray(hist[0]), threshold, minL, maxL);
+    compute_histogram_minmax(toValarray(hist[1]), threshold, minR, maxR);
+    compute_histogram_minmax(toValarray(hist[2]), threshold, minG, maxG);
+    compute_histogram_minmax(toValarray(hist[3]), threshold, minB, maxB);
 
     minHist = min(min(minL,minR), min(minG,minB));
     maxHist = max(max(maxL,maxR), max(maxG,maxB));
@@ -245,7 +239,28 @@ void LoadFile::operator()(HdrCreationItem& currentItem)
         qDebug() << QString("LoadFile: Loading data for %1").arg(filePath.constData());
 
         FrameReaderPtr reader = FrameReaderFactory::open(filePath.constData());
-        reader->read( *currentItem.frame(), getRawSettings() );
+
+        // previews are decoded at reduced resolution and kept out of the item,
+        // whose frame stays empty until LoadFullResolution runs
+        Frame preview;
+        Frame& frame = (m_previewSize > 0) ? preview : *currentItem.frame();
+        Params params = getRawSettings();
+        if (m_previewSize > 0)
+        {
+            params.set("preview_size", m_previewSize);
+        }
+        reader->read( frame, params );
+        currentItem.setEncoding(reader->encoding());
+
+        if (m_previewSize > 0)
+        {
+            // the reader rotates the image according to its orientation
+            const int rotation = pfs::exif::ExifData(filePath.constData()).getOrientationDegree();
+            if (rotation == 90 || rotation == 270)
+                currentItem.setSize(reader->height(), reader->width());
+            else
+                currentItem.setSize(reader->width(), reader->height());
+        }
 
         // read Average Luminance
         pfs::exif::ExifData exifData(currentItem.filename().toStdString());
@@ -259,8 +274,8 @@ void LoadFile::operator()(HdrCreationItem& currentItem)
                     .arg(currentItem.getAverageLuminance());
 
         // build QImage
-        QImage tempImage(currentItem.frame()->getWidth(),
-                         currentItem.frame()->getHeight(),
+        QImage tempImage(frame.getWidth(),
+                         frame.getHeight(),
                          QImage::Format_ARGB32_Premultiplied);
 
         QRgb* qimageData = reinterpret_cast<QRgb*>(tempImage.bits());
@@ -268,7 +283,7 @@ void LoadFile::operator()(HdrCreationItem& currentItem)
         Channel* red;
         Channel* green;
         Channel* blue;
-        currentItem.frame()->getXYZChannels(red, green, blue);
+        frame.getXYZChannels(red, green, blue);
 
         if (red == NULL || green == NULL || blue == NULL)
         {
@@ -300,7 +315,7 @@ void LoadFile::operator()(HdrCreationItem& currentItem)
 #endif
 
             // Let's normalize thumbnails for FitsImporter. Again, all channels are equal
-            Channel c(currentItem.frame()->getWidth(), currentItem.frame()->getHeight(), "X");
+            Channel c(frame.getWidth(), frame.getHeight(), "X");
             pfs::colorspace::Normalizer normalize(minRed, maxRed);
 
             std::transform(red->begin(), red->end(), c.begin(), normalize);
@@ -313,7 +328,23 @@ void LoadFile::operator()(HdrCreationItem& currentItem)
                              qimageData, ConvertToQRgb());
         }
 
+        if (m_previewSize > 0 &&
+            std::max(tempImage.width(), tempImage.height()) > m_previewSize)
+        {
+            tempImage = tempImage.scaled(m_previewSize, m_previewSize,
+                                         Qt::KeepAspectRatio, Qt::SmoothTransformation);
+        }
+
         currentItem.qimage().swap( tempImage );
+
+        // readers unable to decode at reduced resolution return the full
+        // image: keep it, rather than decoding it again in LoadFullResolution
+        if (m_previewSize > 0 &&
+            preview.getWidth() == currentItem.width() &&
+            preview.getHeight() == currentItem.height())
+        {
+            currentItem.frame()->swap(preview);
+        }
     }
     catch (std::runtime_error& err)
     {
@@ -324,6 +355,23 @@ void LoadFile::operator()(HdrCreationItem& currentItem)
     }
 }
 
+void LoadFullResolution::operator()(HdrCreationItem& currentItem)
+{
+    if (currentItem.isFullResolution())
+    {
+        return;
+    }
+
+    // keeps the exposure values edited while only the preview was available
+    const float averageLuminance = currentItem.getAverageLuminance();
+    const float exposureTime = currentItem.getExposureTime();
+
+    LoadFile()(currentItem);
+
+    currentItem.setAverageLuminance(averageLuminance);
+    currentItem.setExposureTime(exposureTime);
+}
+
 SaveFile::SaveFile(int mode, float minLum, float maxLum, bool deflateCompression) :
     m_mode(mode),
     m_minLum(minLum),
@@ -413,3 +461,30 @@ void RefreshPreview::operator()(HdrCreationItem& currentItem)
 }
 
 
+
+ScopedFftwWisdom::ScopedFftwWisdom()
+{
+    LuminanceOptions options;
+
+    int rigor = qBound(static_cast<int>(pfs::FFTPlanCache::PLAN_ESTIMATE),
+                       options.getFftwPlanningRigor(),
+                       static_cast<int>(pfs::FFTPlanCache::PLAN_PATIENT));
+    pfs::FFTPlanCache::global().setPlanningRigor(
+                static_cast<pfs::FFTPlanCache::PlanningRigor>(rigor));
+
+    QString filename = options.getFftwWisdomFileName();
+    if ( QFile::exists(filename) &&
+         !pfs::FFTPlanCache::global().loadWisdom(QFile::encodeName(filename).constData()) )
+    {
+        qDebug() << "ScopedFftwWisdom: cannot load" << filename;
+    }
+}
+
+ScopedFftwWisdom::~ScopedFftwWisdom()
+{
+    QString filename = LuminanceOptions().getFftwWisdomFileName();
+    if ( !pfs::FFTPlanCache::global().saveWisdom(QFile::encodeName(filename).constData()) )
+    {
+        qDebug() << "ScopedFftwWisdom: cannot save" << filename;
+    }
+}
@@ -134,13 +134,26 @@ struct ConvertToQRgb {
     void operator()(float r, float g, float b, QRgb& rgb) const;
 };
 
+//! \brief Loads an item and builds its thumbnail. With a positive
+//! \a previewSize only a reduced-resolution version, whose longest side is
+//! about \a previewSize, is decoded for the thumbnail: the frame of the item
+//! stays empty and LoadFullResolution decodes it when needed. Readers that
+//! ignore \a previewSize return the full image, which is kept as the frame
 struct LoadFile {
-    explicit LoadFile(bool fromFITS = false) : m_datamax(0.f), m_datamin(0.f) { m_fromFITS = fromFITS; }
+    explicit LoadFile(bool fromFITS = false, int previewSize = 0)
+        : m_datamax(0.f), m_datamin(0.f), m_fromFITS(fromFITS), m_previewSize(previewSize) {}
     void operator()(HdrCreationItem& currentItem);
     float normalize(float);
     float m_datamax;
     float m_datamin;
     bool m_fromFITS;
+    int m_previewSize;
+};
+
+//! \brief Decodes the full resolution data of items loaded as previews,
+//! keeping the exposure values set meanwhile
+struct LoadFullResolution {
+    void operator()(HdrCreationItem& currentItem);
 };
 
 struct SaveFile {
@@ -156,4 +169,12 @@ struct RefreshPreview {
     void operator()(HdrCreationItem& currentItem);
 };
 
+//! \brief Configures the FFT plan cache from the settings and restores the
+//! FFTW wisdom saved by previous runs. The wisdom gathered meanwhile is saved
+//! back on destruction, so it must live as long as the application
+struct ScopedFftwWisdom {
+    ScopedFftwWisdom();
+    ~ScopedFftwWisdom();
+};
+
 #endif
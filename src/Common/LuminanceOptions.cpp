@@ -188,6 +188,39 @@ QString LuminanceOptions::getDatabaseFileName()
     return filename;
 }
 
+QString LuminanceOptions::getFftwWisdomFileName()
+{
+    QString filename;
+    if (LuminanceOptions::isCurrentPortableMode)
+    {
+        filename = QDir::currentPath();
+    }
+    else
+    {
+        filename = QDir(QDir::homePath()).absolutePath() + "/" + LUMINANCE_HDR_HOME_FOLDER;
+    }
+    filename += "/fftwf_wisdom";
+
+    return filename;
+}
+
+QString LuminanceOptions::getResponseCacheDir()
+{
+    QString dirname;
+    if (LuminanceOptions::isCurrentPortableMode)
+    {
+        dirname = QDir::currentPath();
+    }
+    else
+    {
+        dirname = QDir(QDir::homePath()).absolutePath() + "/" + LUMINANCE_HDR_HOME_FOLDER;
+    }
+    dirname += "/response_curves";
+    QDir().mkpath(dirname);
+
+    return dirname;
+}
+
 QString LuminanceOptions::getGuiTheme()
 {
 #ifdef Q_OS_MAC
@@ -685,6 +718,26 @@ void LuminanceOptions::setBatchTmNumThreads(int v)
     m_settingHolder->setValue(KEY_BATCH_TM_NUM_THREADS, v);
 }
 
+int LuminanceOptions::getFftwPlanningRigor()
+{
+    return m_settingHolder->value(KEY_FFTW_PLANNING_RIGOR, 0).toInt();
+}
+
+void LuminanceOptions::setFftwPlanningRigor(int v)
+{
+    m_settingHolder->setValue(KEY_FFTW_PLANNING_RIGOR, v);
+}
+
+int LuminanceOptions::getResponseCacheMode()
+{
+    return m_settingHolder->value(KEY_HDR_RESPONSE_CACHE_MODE, 1).toInt();
+}
+
+void LuminanceOptions::setResponseCacheMode(int v)
+{
+    m_settingHolder->setValue(KEY_HDR_RESPONSE_CACHE_MODE, v);
+}
+
 namespace
 {
 #ifdef QT_DEBUG
@@ -55,6 +55,10 @@ public:
     bool doShowWindowsOnWindows64Message();
 
     QString getDatabaseFileName();
+    //! \brief file where the FFTW planner stores its wisdom between runs
+    QString getFftwWisdomFileName();
+    //! \brief directory of the response curves calibrated on each camera
+    QString getResponseCacheDir();
     void    setPortableMode(bool isPortable);
 
     bool checkForUpdate();
@@ -180,6 +184,14 @@ public Q_SLOTS:
     int     getNumThreads() { return getBatchTmNumThreads(); }
     void    setNumThreads(int i) { setBatchTmNumThreads(i); }
 
+    // FFTW planning rigor (0 = estimate, 1 = measure, 2 = patient)
+    int     getFftwPlanningRigor();
+    void    setFftwPlanningRigor(int);
+
+    // Response curve cache (0 = off, 1 = reuse, 2 = warm start)
+    int     getResponseCacheMode();
+    void    setResponseCacheMode(int);
+
     // Default Paths
     // Path to save temporary cached files
     QString getTempDir();
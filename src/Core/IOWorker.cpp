@@ -38,6 +38,8 @@
 
 #include "Core/IOWorker.h"
 #include "Libpfs/frame.h"
+#include "Libpfs/tiledframe.h"
+#include "Libpfs/frameview.h"
 
 #include "Viewers/GenericViewer.h"
 #include "Common/LuminanceOptions.h"
@@ -129,6 +131,57 @@ bool IOWorker::write_hdr_frame(pfs::Frame *hdr_frame, const QString& filename,
     return status;
 }
 
+bool IOWorker::write_hdr_frame(const pfs::TiledFrame& hdr_frame, const QString& filename,
+                               const pfs::Params& params)
+{
+    return write_hdr_frame_from(hdr_frame, filename, params);
+}
+
+bool IOWorker::write_hdr_frame(const pfs::FrameView& hdr_frame, const QString& filename,
+                               const pfs::Params& params)
+{
+    return write_hdr_frame_from(hdr_frame, filename, params);
+}
+
+template <typename FrameType>
+bool IOWorker::write_hdr_frame_from(const FrameType& hdr_frame, const QString& filename,
+                                    const pfs::Params& params)
+{
+    bool status = true;
+    emit IO_init();
+
+    QFileInfo qfi(filename);
+    QByteArray encodedName = QFile::encodeName(qfi.absoluteFilePath());
+
+    pfs::Params writerParams(params);
+    if (!writerParams.count("tiff_mode"))
+    {
+        writerParams.set("tiff_mode", 2);
+    }
+
+    try
+    {
+        FrameWriterPtr writer = FrameWriterFactory::open(encodedName.constData(), writerParams);
+        writer->write(hdr_frame, writerParams);
+    }
+    catch (pfs::io::InvalidFile& exInvalid) {
+        qDebug() << "Unsupported format for " << exInvalid.what();
+
+        EXRWriter writer(encodedName.constData());
+        writer.write(hdr_frame, writerParams);
+    }
+    catch (std::runtime_error& ex) {
+        qDebug() << ex.what();
+        status = false;
+    }
+
+    if ( !status ) {
+        emit write_hdr_failed(filename);
+    }
+    emit IO_finish();
+    return status;
+}
+
 bool IOWorker::write_ldr_frame(GenericViewer* ldr_viewer,
                                const QString& filename, /*int quality,*/
                                const QString& inputFileName,
@@ -298,6 +351,63 @@ pfs::Frame* IOWorker::read_hdr_frame(const QString& filename)
     }
 }
 
+bool IOWorker::read_hdr_frame(const QString& filename, pfs::TiledFrame& frame)
+{
+    return read_hdr_frame_into(filename, frame);
+}
+
+bool IOWorker::read_hdr_frame(const QString& filename, pfs::FrameView& frame)
+{
+    return read_hdr_frame_into(filename, frame);
+}
+
+template <typename FrameType>
+bool IOWorker::read_hdr_frame_into(const QString& filename, FrameType& frame)
+{
+    emit IO_init();
+
+    QFileInfo qfi(filename);
+    if (filename.isEmpty() || !qfi.isReadable())
+    {
+        emit read_hdr_failed(tr("IOWorker: The following file is not readable: %1").arg(filename));
+        return false;
+    }
+
+    bool status = true;
+    try
+    {
+        QByteArray encodedFileName = QFile::encodeName(qfi.absoluteFilePath());
+
+        pfs::Params params = getRawSettings();
+        FrameReaderPtr reader = FrameReaderFactory::open(encodedFileName.constData());
+        reader->read( frame, params );
+        reader->close();
+    }
+    catch (pfs::io::UnsupportedFormat& exUnsupported)
+    {
+        emit read_hdr_failed(tr("IOWorker: file %1 has unsupported extension: %2")
+                             .arg(filename)
+                             .arg(exUnsupported.what()));
+        status = false;
+    }
+    catch (std::runtime_error& err)
+    {
+        emit read_hdr_failed(tr("IOWorker: caught exception reading %1: %2")
+                             .arg(filename)
+                             .arg(err.what()));
+        status = false;
+    }
+    catch (...)
+    {
+        emit read_hdr_failed(tr("IOWorker: failed loading file: %1")
+                             .arg(filename));
+        status = false;
+    }
+
+    emit IO_finish();
+    return status;
+}
+
 void IOWorker::emitNextStep(int iteration)
 {
     emit setValue(iteration);
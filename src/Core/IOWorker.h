@@ -44,6 +44,8 @@
 
 namespace pfs {
 class Frame;
+class TiledFrame;
+class FrameView;
 }
 
 class GenericViewer;
@@ -64,6 +66,13 @@ private:
     int progress_cb(void *data, enum LibRaw_progress p, int iteration, int expected);
 
     void get_frame(QString fname);
+    //! \brief reads \a filename into a tiled or mapped frame
+    template <typename FrameType>
+    bool read_hdr_frame_into(const QString& filename, FrameType& frame);
+    //! \brief writes a tiled or mapped \a frame into \a filename
+    template <typename FrameType>
+    bool write_hdr_frame_from(const FrameType& frame, const QString& filename,
+                              const pfs::Params& params);
     void emitNextStep(int iteration);
     void emitMaximumValue(int iteration);
 
@@ -71,6 +80,22 @@ public:
     IOWorker(QObject* parent = 0);
     ~IOWorker();
 
+    //! \brief reads \a filename into the tiles of \a frame. Only the
+    //! failure signal is emitted, since the success ones carry a resident frame
+    bool read_hdr_frame(const QString& filename, pfs::TiledFrame& frame);
+    //! \brief maps \a filename in memory into \a frame, when the format
+    //! allows it (see \c pfs::io::FrameReader). Only the failure signal is
+    //! emitted, since the success ones carry a resident frame
+    bool read_hdr_frame(const QString& filename, pfs::FrameView& frame);
+    //! \brief writes \a frame (formats able to do it stream the tiles).
+    //! Only the failure signal is emitted
+    bool write_hdr_frame(const pfs::TiledFrame& frame, const QString& filename,
+                         const pfs::Params& params = pfs::Params());
+    //! \brief writes \a frame (formats able to do it read the view without
+    //! detaching it). Only the failure signal is emitted
+    bool write_hdr_frame(const pfs::FrameView& frame, const QString& filename,
+                         const pfs::Params& params = pfs::Params());
+
 public Q_SLOTS:
     pfs::Frame* read_hdr_frame(const QString& filename);
 
@@ -24,6 +24,7 @@
  */
 
 #include "Core/TMWorker.h"
+#include <memory>
 
 #ifdef QT_DEBUG
 #include <QDebug>
@@ -34,6 +35,8 @@
 #include "Core/IOWorker.h"
 
 #include "Libpfs/frame.h"
+#include "Libpfs/tiledframe.h"
+#include "Libpfs/frameview.h"
 #include "Libpfs/params.h"
 #include "Libpfs/manip/copy.h"
 #include "Libpfs/manip/cut.h"
@@ -46,7 +49,9 @@
 
 TMWorker::TMWorker(QObject* parent):
     QObject(parent),
-    m_Callback(new ProgressHelper)
+    m_Callback(new ProgressHelper),
+    m_tmEngine(NULL),
+    m_interactive(false)
 {
 #ifdef QT_DEBUG
     qDebug() << "TMWorker::TMWorker() ctor";
@@ -75,6 +80,34 @@ pfs::Frame* TMWorker::computeTonemap(/* const */ pfs::Frame* in_frame, Tonemappi
 
     pfs::Frame* working_frame = preprocessFrame(in_frame, tm_options, m);
     if (working_frame == NULL) return NULL;
+    return tonemapWorkingFrame(working_frame, tm_options);
+}
+
+pfs::Frame* TMWorker::computeTonemap(const pfs::TiledFrame& in_frame, TonemappingOptions* tm_options, InterpolationMethod m)
+{
+    pfs::Frame* working_frame = preprocessFrame(in_frame, tm_options, m);
+    if (working_frame == NULL) return NULL;
+    return tonemapWorkingFrame(working_frame, tm_options);
+}
+
+pfs::Frame* TMWorker::computeTonemap(const pfs::FrameView& in_frame, TonemappingOptions* tm_options, InterpolationMethod m)
+{
+    pfs::Frame* working_frame = preprocessFrame(in_frame, tm_options, m);
+    if (working_frame == NULL) return NULL;
+    return tonemapWorkingFrame(working_frame, tm_options);
+}
+
+pfs::Frame* TMWorker::computeTonemapInPlace(pfs::FrameView& in_frame, TonemappingOptions* tm_options, InterpolationMethod m)
+{
+    pfs::Frame* working_frame = preprocessFrame(in_frame, tm_options, m);
+    // the selection and the resized frame leave the view as it was
+    pfs::FrameView().swap(in_frame);
+    if (working_frame == NULL) return NULL;
+    return tonemapWorkingFrame(working_frame, tm_options);
+}
+
+pfs::Frame* TMWorker::tonemapWorkingFrame(pfs::Frame* working_frame, TonemappingOptions* tm_options)
+{
     try {
         tonemapFrame(working_frame, tm_options);
     }
@@ -156,19 +189,50 @@ void TMWorker::computeTonemapAndExport(/* const */ pfs::Frame* in_frame, Tonemap
     delete working_frame;
 }
 
+void TMWorker::setTonemapOperator(TonemapOperator* tmEngine)
+{
+    m_tmEngine = tmEngine;
+}
+
+void TMWorker::setInteractiveMode(bool enabled)
+{
+    m_interactive = enabled;
+    if ( !m_interactive )
+        m_interactiveEngine.reset();
+}
+
 void TMWorker::tonemapFrame(pfs::Frame* working_frame, TonemappingOptions* tm_options)
 {
     m_Callback->cancel(false);
 
     emit tonemapBegin();
-    // build tonemap object
-    TonemapOperator* tmEngine = TonemapOperator::getTonemapOperator(tm_options->tmoperator);
+    // build tonemap object, unless the one of the sequence can be used
+    std::unique_ptr<TonemapOperator> ownedEngine;
+    TonemapOperator* tmEngine = m_tmEngine;
+    if ( tmEngine == NULL || tmEngine->getType() != tm_options->tmoperator )
+    {
+        if ( !m_interactive )
+        {
+            ownedEngine.reset( TonemapOperator::getTonemapOperator(tm_options->tmoperator) );
+            tmEngine = ownedEngine.get();
+        }
+        else
+        {
+            // keeps the results of the previous calls on the same operator
+            if ( !m_interactiveEngine ||
+                 m_interactiveEngine->getType() != tm_options->tmoperator )
+            {
+                m_interactiveEngine.reset( TonemapOperator::getTonemapOperator(tm_options->tmoperator) );
+                m_interactiveEngine->setInteractiveMode(true);
+            }
+            tmEngine = m_interactiveEngine.get();
+        }
+    }
 
     // build object, pass new frame to it and collect the result
     tmEngine->tonemapFrame(*working_frame, tm_options, *m_Callback);
 
     emit tonemapEnd();
-    delete tmEngine;
 }
 
 pfs::Frame* TMWorker::preprocessFrame(pfs::Frame* input_frame, TonemappingOptions* tm_options, InterpolationMethod m)
@@ -205,6 +269,52 @@ pfs::Frame* TMWorker::preprocessFrame(pfs::Frame* input_frame, TonemappingOption
     return working_frame;
 }
 
+namespace
+{
+template <typename FrameType>
+void loadWorkingFrame(const FrameType& input_frame, pfs::Frame& working_frame)
+{
+    input_frame.copyTo(working_frame);
+}
+
+void loadWorkingFrame(pfs::FrameView& input_frame, pfs::Frame& working_frame)
+{
+    input_frame.moveTo(working_frame);
+}
+}
+
+template <typename FrameType>
+pfs::Frame* TMWorker::preprocessFrame(FrameType& input_frame, TonemappingOptions* tm_options, InterpolationMethod m)
+{
+    pfs::Frame* working_frame = NULL;
+
+    if ( tm_options->tonemapSelection )
+    {
+        working_frame = pfs::cut(input_frame,
+                                 tm_options->selection_x_up_left,
+                                 tm_options->selection_y_up_left,
+                                 tm_options->selection_x_bottom_right,
+                                 tm_options->selection_y_bottom_right);
+    }
+    else if ( tm_options->xsize != tm_options->origxsize )
+    {
+        working_frame = pfs::resize(input_frame, tm_options->xsize, m);
+    }
+    else
+    {
+        // the operators need the whole frame in memory
+        working_frame = new pfs::Frame;
+        loadWorkingFrame(input_frame, *working_frame);
+    }
+
+    if ( tm_options->pregamma != 1.0f )
+    {
+        pfs::applyGamma( working_frame, tm_options->pregamma );
+    }
+
+    return working_frame;
+}
+
 void TMWorker::postprocessFrame(pfs::Frame*, TonemappingOptions*)
 {
     // auto-level?
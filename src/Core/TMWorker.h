@@ -26,6 +26,8 @@
 #ifndef TMWORKER_H
 #define TMWORKER_H
 
+#include <memory>
+
 #include <QObject>
 #include <QString>
 
@@ -35,9 +37,12 @@
 // Forward declaration
 namespace pfs {
     class Frame;
+    class TiledFrame;
+    class FrameView;
 }
 
 class TonemappingOptions;
+class TonemapOperator;
 class ProgressHelper;
 
 class TMWorker : public QObject
@@ -48,6 +53,44 @@ public:
     TMWorker(QObject* parent = 0);
     ~TMWorker();
 
+    //!
+    //! Tonemaps with \a tmEngine, when it matches the operator of the options,
+    //! instead of building a new operator for every frame: the state of its
+    //! sequence mode then survives from one call to the next.
+    //! \note \a tmEngine is not owned; NULL restores the default
+    //!
+    void setTonemapOperator(TonemapOperator* tmEngine);
+
+    //!
+    //! In interactive mode the operator built for a call is kept, in its own
+    //! interactive mode, for the following calls with the same operator:
+    //! tone mapping the same frame again only recomputes what depends on the
+    //! changed parameters.
+    //!
+    void setInteractiveMode(bool enabled);
+
+    //!
+    //! Same as the overload taking a \c pfs::Frame, for a frame stored in
+    //! tiles: only the working frame (the selection, the resized frame or, at
+    //! full size, a copy of the whole frame) is made resident
+    //!
+    pfs::Frame* computeTonemap(const pfs::TiledFrame&, TonemappingOptions*, InterpolationMethod m);
+
+    //!
+    //! Same as the overload taking a \c pfs::Frame, for a (typically memory
+    //! mapped) view: the selection and the resized frame read only the pixels
+    //! they need, and the view is never detached
+    //!
+    pfs::Frame* computeTonemap(const pfs::FrameView&, TonemappingOptions*, InterpolationMethod m);
+
+    //!
+    //! Same as the overload taking a const \c pfs::FrameView, but consumes
+    //! the view, which is left empty: at full size its channels are moved
+    //! into the working frame, so that the ones already in memory are not
+    //! copied and the mapped ones are copied only once
+    //!
+    pfs::Frame* computeTonemapInPlace(pfs::FrameView&, TonemappingOptions*, InterpolationMethod m);
+
 public Q_SLOTS:
     //!
     //!  This function creates a copy of the input frame, tonemap the copy
@@ -64,6 +107,13 @@ public Q_SLOTS:
 
 private:
     pfs::Frame* preprocessFrame(pfs::Frame*, TonemappingOptions*, InterpolationMethod m);
+    //! \brief preprocessing of a tiled or mapped frame, copied into a resident
+    //! working frame (moved, for a non-const \c pfs::FrameView)
+    template <typename FrameType>
+    pfs::Frame* preprocessFrame(FrameType&, TonemappingOptions*, InterpolationMethod m);
+    //! \brief tonemaps and post-processes \a working_frame, which is deleted
+    //! on failure
+    pfs::Frame* tonemapWorkingFrame(pfs::Frame* working_frame, TonemappingOptions*);
     void postprocessFrame(pfs::Frame*, TonemappingOptions*);
 
 Q_SIGNALS:
@@ -79,6 +129,9 @@ Q_SIGNALS:
 
 private:
     ProgressHelper* m_Callback;
+    TonemapOperator* m_tmEngine;
+    bool m_interactive;
+    std::unique_ptr<TonemapOperator> m_interactiveEngine;
 };
 
 #endif // TMWORKER_H
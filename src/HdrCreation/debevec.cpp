@@ -26,9 +26,8 @@
 //! \author Davide Anastasia <davideanastasia@users.sourceforge.net>
 
 #include "HdrCreation/debevec.h"
-#include <Libpfs/utils/numeric.h>
+#include <Libpfs/utils/minmax.h>
 #include <Libpfs/utils/msec_timer.h>
-#include <Libpfs/colorspace/normalizer.h>
 
 #include <cmath>
 #include <cfloat>
@@ -45,7 +44,8 @@
 #include <omp.h>
 #endif
 
-#include "Libpfs/array2d.h"
+#include "Libpfs/frame.h"
+#include "Libpfs/channel.h"
 
 #ifndef NDEBUG
 #define PRINT_DEBUG(str) std::cerr << "Debevec: " << str << std::endl
@@ -56,11 +56,31 @@
 using namespace pfs;
 using namespace std;
 using namespace utils;
-using namespace colorspace;
 
 namespace libhdr {
 namespace fusion {
 
+namespace
+{
+//! \brief Per-exposure constants of the merge. Samples are normalized in the
+//! [0, 1] range through \c offset and \c scale, and then directly mapped to
+//! the bins of the response and weight lookup tables
+struct ExposureData
+{
+    const float* channel[3];
+    float offset;
+    float binScale;
+    float logTime;
+};
+
+inline
+size_t binIndex(float sample, const ExposureData& exposure)
+{
+    return std::min(size_t((sample - exposure.offset)*exposure.binScale),
+                    ResponseCurve::NUM_BINS - 1);
+}
+}
+
 void DebevecOperator::computeFusion(ResponseCurve& response, WeightFunction& weight,
                                     const vector<FrameEnhanced> &images,
                                     pfs::Frame &frame)
@@ -70,95 +90,143 @@ void DebevecOperator::computeFusion(ResponseCurve& response, WeightFunction& wei
     f_timer.start();
 #endif
     assert(images.size() != 0);
-
-    std::vector<float> times;
+    static_assert(ResponseCurve::NUM_BINS == WeightFunction::NUM_BINS,
+                  "response and weight must share the same bins");
 
     const int W = images[0].frame()->getWidth();
     const int H = images[0].frame()->getHeight();
-
-    for (size_t idx = 0; idx < images.size(); ++idx)
-    {
-        times.push_back(images[idx].averageLuminance());
+    const int channels = 3;
+    const int numExposures = images.size();
+    const size_t numBins = ResponseCurve::NUM_BINS;
+
+    // log-response, one lookup table per channel
+    vector<float> logResponse(channels*numBins);
+    for (int c = 0; c < channels; c++) {
+        const ResponseCurve::ResponseContainer& curve =
+                response.get(static_cast<ResponseChannel>(c));
+        transform(curve.begin(), curve.end(), logResponse.begin() + c*numBins, logf);
+    }
+    const WeightFunction::WeightContainer weights = weight.getWeights();
+
+    vector<ExposureData> exposures(numExposures);
+    vector<float> expMin(numExposures, boost::numeric::bounds<float>::highest());
+    vector<float> expMax(numExposures, boost::numeric::bounds<float>::lowest());
+    for (int i = 0; i < numExposures; i++) {
+        const Channel *Ch[channels];
+        static_cast<const pfs::Frame&>(*images[i].frame()).getXYZChannels(Ch[0], Ch[1], Ch[2]);
+        for (int c = 0; c < channels; c++) {
+            exposures[i].channel[c] = Ch[c]->data();
+        }
+        exposures[i].logTime = logf(images[i].averageLuminance());
     }
 
-    const int channels = 3;
-    const size_t size = W*H;
+    // each exposure is normalized between its minimum and maximum sample
+    #pragma omp parallel
+    {
+        vector<float> localMin(expMin);
+        vector<float> localMax(expMax);
+
+        #pragma omp for schedule(static)
+        for (int y = 0; y < H; y++) {
+            for (int i = 0; i < numExposures; i++) {
+                const float* r = exposures[i].channel[0] + y*W;
+                const float* g = exposures[i].channel[1] + y*W;
+                const float* b = exposures[i].channel[2] + y*W;
+
+                float rowMin = localMin[i];
+                float rowMax = localMax[i];
+                for (int x = 0; x < W; x++) {
+                    float m, M;
+                    minmax(r[x], g[x], b[x], m, M);
+                    rowMin = std::min(rowMin, m);
+                    rowMax = std::max(rowMax, M);
+                }
+                localMin[i] = rowMin;
+                localMax[i] = rowMax;
+            }
+        }
 
-    vector<float> exp_values(times);
-    transform(exp_values.begin(), exp_values.end(), exp_values.begin(), logf);
+        #pragma omp critical (debevec_range)
+        for (int i = 0; i < numExposures; i++) {
+            expMin[i] = std::min(expMin[i], localMin[i]);
+            expMax[i] = std::max(expMax[i], localMax[i]);
+        }
+    }
+    for (int i = 0; i < numExposures; i++) {
+        assert(expMax[i] != expMin[i]);
+        exposures[i].offset = expMin[i];
+        exposures[i].binScale = (numBins - 1)/(expMax[i] - expMin[i]);
+    }
 
     frame.resize(W, H);
     Channel *Ch[3];
     frame.createXYZChannels(Ch[0], Ch[1], Ch[2]);
-    Array2Df *resultCh[channels] = {Ch[0], Ch[1], Ch[2]};
-    #pragma omp parallel for
-    for(int c = 0; c < channels; c++) {
-        resultCh[c]->fill(0.f);
-    }
-    Array2Df weight_sum(W, H);
-    weight_sum.fill(0.f);
-
-    int length = images.size();
-    #pragma omp parallel for
-    for(int i = 0; i < length; i++) {
-        Channel *Ch[channels];
-        images[i].frame()->getXYZChannels(Ch[0], Ch[1], Ch[2]);
-        Array2Df *imagesCh[channels] = {Ch[0], Ch[1], Ch[2]};
-
-        float cmax[3];
-        float cmin[3];
-        for(int c = 0; c < channels; c++) {
-            cmax[c] = *max_element(Ch[c]->begin(), Ch[c]->end());
-            cmin[c] = *min_element(Ch[c]->begin(), Ch[c]->end());
-        }
-        float Max = std::max(cmax[0], std::max(cmax[1], cmax[2]));
-        float Min = std::min(cmin[0], std::min(cmin[1], cmin[2]));
+    float *resultCh[channels] = {Ch[0]->data(), Ch[1]->data(), Ch[2]->data()};
 
-        for(int c = 0; c < channels; c++) {
-            transform(Ch[c]->begin(), Ch[c]->end(), Ch[c]->begin(), Normalizer(Min, Max));
-        }
+    const float* logR = &logResponse[0];
+    const float* logG = &logResponse[numBins];
+    const float* logB = &logResponse[2*numBins];
 
-        Array2Df temp_array(W, H);
-        Array2Df splitted[channels] = {Array2Df(W, H), Array2Df(W, H), Array2Df(W, H)};
-        Array2Df response_img[channels] = {Array2Df(W, H), Array2Df(W, H), Array2Df(W, H)};
-        Array2Df w(W, H);
-        for(int c = 0; c < channels; c++) {
-            for(size_t k = 0; k < size; k++) {
-                splitted[c](k) = weight((*imagesCh[c])(k));
+    // fused pass: every row is merged over all the exposures inside
+    // per-thread accumulators, so the output is written only once
+    float Max = boost::numeric::bounds<float>::lowest();
+    #pragma omp parallel
+    {
+        vector<float> accumulator(channels*W);
+        vector<float> weightSum(W);
+        float* accR = &accumulator[0];
+        float* accG = &accumulator[W];
+        float* accB = &accumulator[2*W];
+        float localMax = boost::numeric::bounds<float>::lowest();
+
+        #pragma omp for schedule(static)
+        for (int y = 0; y < H; y++) {
+            std::fill(accumulator.begin(), accumulator.end(), 0.f);
+            std::fill(weightSum.begin(), weightSum.end(), 0.f);
+
+            for (int i = 0; i < numExposures; i++) {
+                const ExposureData& exposure = exposures[i];
+                const float* r = exposure.channel[0] + y*W;
+                const float* g = exposure.channel[1] + y*W;
+                const float* b = exposure.channel[2] + y*W;
+
+                for (int x = 0; x < W; x++) {
+                    size_t idxR = binIndex(r[x], exposure);
+                    size_t idxG = binIndex(g[x], exposure);
+                    size_t idxB = binIndex(b[x], exposure);
+
+                    float w = (weights[idxR] + weights[idxG] + weights[idxB])/channels;
+
+                    accR[x] += w*(logR[idxR] - exposure.logTime);
+                    accG[x] += w*(logG[idxG] - exposure.logTime);
+                    accB[x] += w*(logB[idxB] - exposure.logTime);
+                    weightSum[x] += w;
+                }
             }
-            vadd(&w, &splitted[c], &w, size);
-        }
-        vmul_scalar(&w, 1.f/channels, &w, size);
-        for(int c = 0; c < channels; c++) {
-            for(size_t k = 0; k < size; k++) {
-                (response_img[c])(k) = logf( response((*imagesCh[c])(k)) );
+
+            float* outR = resultCh[0] + y*W;
+            float* outG = resultCh[1] + y*W;
+            float* outB = resultCh[2] + y*W;
+            for (int x = 0; x < W; x++) {
+                float norm = 1.0f/weightSum[x];
+                outR[x] = expf(accR[x]*norm);
+                outG[x] = expf(accG[x]*norm);
+                outB[x] = expf(accB[x]*norm);
+
+                if (boost::math::isnormal(outR[x])) localMax = std::max(localMax, outR[x]);
+                if (boost::math::isnormal(outG[x])) localMax = std::max(localMax, outG[x]);
+                if (boost::math::isnormal(outB[x])) localMax = std::max(localMax, outB[x]);
             }
         }
-        for(int c = 0; c < channels; c++) {
-            vsum_scalar(&response_img[c], -logf(times.at((int)i)), &response_img[c], size);
-            vmul(&w, &response_img[c], &temp_array, size);
-            vadd(resultCh[c], &temp_array, resultCh[c], size);
-        }
-        vadd(&weight_sum, &w, &weight_sum, size);
-    }
-    vdiv_scalar(&weight_sum, 1.0f, &weight_sum, size);
-    #pragma omp parallel for
-    for(int c = 0; c < channels; c++) {
-        vmul(resultCh[c], &weight_sum, resultCh[c], size);
-    }
-    #pragma omp parallel for
-    for(int c = 0; c < channels; c++) {
-        transform(resultCh[c]->begin(), resultCh[c]->end(), resultCh[c]->begin(), expf);
-    }
-    float cmax[3];
-    #pragma omp parallel for
-    for(int c = 0; c < channels; c++) {
-        cmax[c] = *max_element(resultCh[c]->begin(), resultCh[c]->end());
+
+        #pragma omp critical (debevec_max)
+        Max = std::max(Max, localMax);
     }
-    float Max = std::max(cmax[0], std::max(cmax[1], cmax[2]));
+
+    // pixels without any trusted sample get the brightest merged value
     #pragma omp parallel for
     for(int c = 0; c < channels; c++) {
-        replace_if(resultCh[c]->begin(), resultCh[c]->end(), std::not1(std::ref(boost::math::isnormal<float>)), Max);
+        replace_if(Ch[c]->begin(), Ch[c]->end(), std::not1(std::ref(boost::math::isnormal<float>)), Max);
     }
 
 #ifdef TIMER_PROFILING
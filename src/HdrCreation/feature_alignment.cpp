@@ -0,0 +1,991 @@
+/*
+ * This file is a part of Luminance HDR package
+ * ----------------------------------------------------------------------
+ * Copyright (C) 2017 Luminance HDR developers
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+#include "feature_alignment.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <iostream>
+#include <limits>
+
+#include <boost/cstdint.hpp>
+
+#include <Libpfs/array2d.h>
+#include <Libpfs/frame.h>
+#include <Libpfs/tag.h>
+#include <Libpfs/colorspace/xyz.h>
+
+#ifndef NDEBUG
+#define PRINT_DEBUG(str) std::cerr << "FeatureAlignment: " << str << std::endl
+#else
+#define PRINT_DEBUG(str)
+#endif
+
+using namespace std;
+using namespace pfs;
+
+namespace libhdr {
+
+Homography::Homography()
+{
+    static const double identity[9] = { 1., 0., 0., 0., 1., 0., 0., 0., 1. };
+    std::copy(identity, identity + 9, m_h);
+}
+
+Homography::Homography(const double* h)
+{
+    std::copy(h, h + 9, m_h);
+}
+
+void Homography::apply(double x, double y, double& u, double& v) const
+{
+    const double w = m_h[6]*x + m_h[7]*y + m_h[8];
+    u = (m_h[0]*x + m_h[1]*y + m_h[2]) / w;
+    v = (m_h[3]*x + m_h[4]*y + m_h[5]) / w;
+}
+
+Homography Homography::operator*(const Homography& rhs) const
+{
+    Homography result;
+    for (int r = 0; r < 3; ++r)
+    {
+        for (int c = 0; c < 3; ++c)
+        {
+            double sum = 0.;
+            for (int k = 0; k < 3; ++k)
+            {
+                sum += (*this)(r, k) * rhs(k, c);
+            }
+            result(r, c) = sum;
+        }
+    }
+    return result;
+}
+
+bool Homography::inverse(Homography& inv) const
+{
+    const double* h = m_h;
+    const double det = h[0]*(h[4]*h[8] - h[5]*h[7])
+                     - h[1]*(h[3]*h[8] - h[5]*h[6])
+                     + h[2]*(h[3]*h[7] - h[4]*h[6]);
+    if ( std::fabs(det) < 1e-12 ) return false;
+
+    const double adj[9] = {
+        h[4]*h[8] - h[5]*h[7], h[2]*h[7] - h[1]*h[8], h[1]*h[5] - h[2]*h[4],
+        h[5]*h[6] - h[3]*h[8], h[0]*h[8] - h[2]*h[6], h[2]*h[3] - h[0]*h[5],
+        h[3]*h[7] - h[4]*h[6], h[1]*h[6] - h[0]*h[7], h[0]*h[4] - h[1]*h[3]
+    };
+    for (int i = 0; i < 9; ++i)
+    {
+        inv.m_h[i] = adj[i] / det;
+    }
+    return true;
+}
+
+namespace
+{
+// largest side of the images the features are detected on
+const size_t WORKING_SIZE = 2048;
+// side of the cells features are spread over, and features kept per cell
+const int CELL_SIZE = 32;
+const size_t FEATURES_PER_CELL = 2;
+// radius of the correlation patches
+const int PATCH_RADIUS = 5;
+const int PATCH_SIZE = (2*PATCH_RADIUS + 1)*(2*PATCH_RADIUS + 1);
+// minimum correlation of a match, and margin over the second best candidate
+const float MIN_CORRELATION = 0.8f;
+const float MIN_CORRELATION_MARGIN = 0.02f;
+// largest motion between adjacent frames, relative to the largest side
+const float SEARCH_RADIUS = 0.05f;
+// RANSAC reprojection threshold (working pixels) and number of iterations
+const double INLIER_THRESHOLD = 1.0;
+const int RANSAC_ITERATIONS = 2000;
+const size_t MIN_INLIERS = 12;
+
+struct Keypoint
+{
+    int x;
+    int y;
+    float response;
+};
+
+bool byResponse(const Keypoint& a, const Keypoint& b)
+{
+    return a.response > b.response;
+}
+
+struct Match
+{
+    double x1, y1;
+    double x2, y2;
+};
+
+//! \brief working image and features of a frame
+struct FeatureSet
+{
+    Array2Df image;
+    std::vector<Keypoint> keypoints;
+    //! \brief zero mean, unit norm patches around the keypoints
+    std::vector<float> patches;
+};
+
+// luminance of the frame, averaged over blocks of scale x scale pixels
+void buildWorkingImage(const Frame& frame, int scale, Array2Df& out)
+{
+    const Channel* R;
+    const Channel* G;
+    const Channel* B;
+    frame.getXYZChannels(R, G, B);
+
+    out.resize(frame.getWidth()/scale, frame.getHeight()/scale);
+
+    const float norm = 1.f/(scale*scale);
+    const colorspace::ConvertRGB2Y toY;
+#pragma omp parallel for
+    for (int y = 0; y < (int)out.getRows(); ++y)
+    {
+        for (size_t x = 0; x < out.getCols(); ++x)
+        {
+            float sum = 0.f;
+            for (int j = 0; j < scale; ++j)
+            {
+                const size_t row = y*scale + j;
+                for (int i = 0; i < scale; ++i)
+                {
+                    const size_t col = x*scale + i;
+                    float lum;
+                    toY((*R)(col, row), (*G)(col, row), (*B)(col, row), lum);
+                    sum += lum;
+                }
+            }
+            out(x, y) = sum*norm;
+        }
+    }
+}
+
+// replaces each value with its rank (in [0, 1]) in the histogram of the log
+// luminance: a change of exposure, or of the response curve, leaves it
+// unchanged but in the clipped areas
+void equalize(Array2Df& image)
+{
+    const size_t BINS = 4096;
+
+    float minVal = std::numeric_limits<float>::max();
+    float maxVal = -std::numeric_limits<float>::max();
+    for (Array2Df::iterator it = image.begin(); it != image.end(); ++it)
+    {
+        *it = std::log2(std::max(*it, 1e-8f));
+        minVal = std::min(minVal, *it);
+        maxVal = std::max(maxVal, *it);
+    }
+
+    if ( maxVal <= minVal )
+    {
+        std::fill(image.begin(), image.end(), 0.f);
+        return;
+    }
+
+    const float binScale = (BINS - 1)/(maxVal - minVal);
+    std::vector<size_t> hist(BINS, 0);
+    for (Array2Df::const_iterator it = image.begin(); it != image.end(); ++it)
+    {
+        ++hist[static_cast<size_t>((*it - minVal)*binScale)];
+    }
+
+    // the value of a bin is the middle of its span of the cdf
+    std::vector<float> rank(BINS);
+    const float norm = 1.f/image.size();
+    size_t cdf = 0;
+    for (size_t i = 0; i < BINS; ++i)
+    {
+        rank[i] = (cdf + 0.5f*hist[i])*norm;
+        cdf += hist[i];
+    }
+
+    for (Array2Df::iterator it = image.begin(); it != image.end(); ++it)
+    {
+        *it = rank[static_cast<size_t>((*it - minVal)*binScale)];
+    }
+}
+
+// 5 taps binomial blur, in place
+void blur(Array2Df& image, Array2Df& temp)
+{
+    const int cols = image.getCols();
+    const int rows = image.getRows();
+    temp.resize(cols, rows);
+
+#pragma omp parallel for
+    for (int y = 0; y < rows; ++y)
+    {
+        const float* in = image.data() + (size_t)y*cols;
+        float* out = temp.data() + (size_t)y*cols;
+        for (int x = 0; x < cols; ++x)
+        {
+            const float l2 = in[std::max(x - 2, 0)];
+            const float l1 = in[std::max(x - 1, 0)];
+            const float r1 = in[std::min(x + 1, cols - 1)];
+            const float r2 = in[std::min(x + 2, cols - 1)];
+            out[x] = (l2 + r2 + 4.f*(l1 + r1) + 6.f*in[x])*(1.f/16.f);
+        }
+    }
+
+#pragma omp parallel for
+    for (int y = 0; y < rows; ++y)
+    {
+        const float* u2 = temp.data() + (size_t)std::max(y - 2, 0)*cols;
+        const float* u1 = temp.data() + (size_t)std::max(y - 1, 0)*cols;
+        const float* c0 = temp.data() + (size_t)y*cols;
+        const float* d1 = temp.data() + (size_t)std::min(y + 1, rows - 1)*cols;
+        const float* d2 = temp.data() + (size_t)std::min(y + 2, rows - 1)*cols;
+        float* out = image.data() + (size_t)y*cols;
+        for (int x = 0; x < cols; ++x)
+        {
+            out[x] = (u2[x] + d2[x] + 4.f*(u1[x] + d1[x]) + 6.f*c0[x])*(1.f/16.f);
+        }
+    }
+}
+
+// Harris corner response
+void harrisResponse(const Array2Df& image, Array2Df& response)
+{
+    const int cols = image.getCols();
+    const int rows = image.getRows();
+
+    Array2Df Ixx(cols, rows);
+    Array2Df Iyy(cols, rows);
+    Array2Df Ixy(cols, rows);
+
+#pragma omp parallel for
+    for (int y = 1; y < rows - 1; ++y)
+    {
+        for (int x = 1; x < cols - 1; ++x)
+        {
+            const float dx = 0.5f*(image(x + 1, y) - image(x - 1, y));
+            const float dy = 0.5f*(image(x, y + 1) - image(x, y - 1));
+            Ixx(x, y) = dx*dx;
+            Iyy(x, y) = dy*dy;
+            Ixy(x, y) = dx*dy;
+        }
+    }
+
+    Array2Df temp;
+    blur(Ixx, temp);
+    blur(Iyy, temp);
+    blur(Ixy, temp);
+
+    response.resize(cols, rows);
+#pragma omp parallel for
+    for (int y = 0; y < rows; ++y)
+    {
+        for (int x = 0; x < cols; ++x)
+        {
+            const float a = Ixx(x, y);
+            const float b = Ixy(x, y);
+            const float c = Iyy(x, y);
+            response(x, y) = (a*c - b*b) - 0.04f*(a + c)*(a + c);
+        }
+    }
+}
+
+// local maxima of the Harris response, spread over a grid of cells
+void detectKeypoints(const Array2Df& image, std::vector<Keypoint>& keypoints)
+{
+    Array2Df response;
+    harrisResponse(image, response);
+
+    const int cols = image.getCols();
+    const int rows = image.getRows();
+    // patches and refinement must fit in the image
+    const int border = PATCH_RADIUS + 3;
+
+    float maxResponse = 0.f;
+    for (Array2Df::const_iterator it = response.begin(); it != response.end(); ++it)
+    {
+        maxResponse = std::max(maxResponse, *it);
+    }
+    const float threshold = 1e-3f*maxResponse;
+
+    const int cellsX = (cols + CELL_SIZE - 1)/CELL_SIZE;
+    const int cellsY = (rows + CELL_SIZE - 1)/CELL_SIZE;
+    std::vector< std::vector<Keypoint> > cells(cellsX*cellsY);
+
+#pragma omp parallel for
+    for (int cy = 0; cy < cellsY; ++cy)
+    {
+        for (int cx = 0; cx < cellsX; ++cx)
+        {
+            std::vector<Keypoint>& cell = cells[cy*cellsX + cx];
+            const int yEnd = std::min((cy + 1)*CELL_SIZE, rows - border);
+            const int xEnd = std::min((cx + 1)*CELL_SIZE, cols - border);
+            for (int y = std::max(cy*CELL_SIZE, border); y < yEnd; ++y)
+            {
+                for (int x = std::max(cx*CELL_SIZE, border); x < xEnd; ++x)
+                {
+                    const float r = response(x, y);
+                    if ( r <= threshold ) continue;
+
+                    bool isMax = true;
+                    for (int j = -1; j <= 1 && isMax; ++j)
+                    {
+                        for (int i = -1; i <= 1; ++i)
+                        {
+                            if ( (i || j) && response(x + i, y + j) >= r )
+                            {
+                                isMax = false;
+                                break;
+                            }
+                        }
+                    }
+                    if ( !isMax ) continue;
+
+                    Keypoint kp = { x, y, r };
+                    cell.push_back(kp);
+                }
+            }
+
+            if ( cell.size() > FEATURES_PER_CELL )
+            {
+                std::partial_sort(cell.begin(), cell.begin() + FEATURES_PER_CELL,
+                                  cell.end(), byResponse);
+                cell.resize(FEATURES_PER_CELL);
+            }
+        }
+    }
+
+    keypoints.clear();
+    for (size_t i = 0; i < cells.size(); ++i)
+    {
+        keypoints.insert(keypoints.end(), cells[i].begin(), cells[i].end());
+    }
+}
+
+// zero mean, unit norm patch centered in (x, y)
+void extractPatch(const Array2Df& image, int x, int y, float* patch)
+{
+    float mean = 0.f;
+    int idx = 0;
+    for (int j = -PATCH_RADIUS; j <= PATCH_RADIUS; ++j)
+    {
+        for (int i = -PATCH_RADIUS; i <= PATCH_RADIUS; ++i)
+        {
+            patch[idx] = image(x + i, y + j);
+            mean += patch[idx++];
+        }
+    }
+    mean /= PATCH_SIZE;
+
+    float norm = 0.f;
+    for (int k = 0; k < PATCH_SIZE; ++k)
+    {
+        patch[k] -= mean;
+        norm += patch[k]*patch[k];
+    }
+    norm = (norm > 0.f) ? 1.f/std::sqrt(norm) : 0.f;
+    for (int k = 0; k < PATCH_SIZE; ++k)
+    {
+        patch[k] *= norm;
+    }
+}
+
+float correlation(const float* p1, const float* p2)
+{
+    float sum = 0.f;
+    for (int k = 0; k < PATCH_SIZE; ++k)
+    {
+        sum += p1[k]*p2[k];
+    }
+    return sum;
+}
+
+void buildFeatureSet(const Frame& frame, int scale, FeatureSet& features)
+{
+    buildWorkingImage(frame, scale, features.image);
+    equalize(features.image);
+
+    detectKeypoints(features.image, features.keypoints);
+
+    const size_t numKeypoints = features.keypoints.size();
+    features.patches.resize(numKeypoints*PATCH_SIZE);
+#pragma omp parallel for
+    for (int k = 0; k < (int)numKeypoints; ++k)
+    {
+        extractPatch(features.image, features.keypoints[k].x, features.keypoints[k].y,
+                     &features.patches[k*PATCH_SIZE]);
+    }
+
+    PRINT_DEBUG("buildFeatureSet: " << numKeypoints << " keypoints");
+}
+
+// vertex of the parabola through (-1, left), (0, center), (1, right)
+double parabolaPeak(double left, double center, double right)
+{
+    const double den = left - 2.*center + right;
+    if ( den >= 0. ) return 0.;
+    return std::max(-0.5, std::min(0.5, 0.5*(left - right)/den));
+}
+
+// moves (x, y) to the local maximum of the correlation of patch with image2,
+// and returns the subpixel position of the peak
+bool refineMatch(const float* patch, const Array2Df& image2, int x, int y,
+                 double& xOut, double& yOut)
+{
+    const int cols = image2.getCols();
+    const int rows = image2.getRows();
+
+    float candidate[PATCH_SIZE];
+    float scores[3][3];
+    for (int step = 0; step < 3; ++step)
+    {
+        if ( x - PATCH_RADIUS - 1 < 0 || x + PATCH_RADIUS + 1 >= cols ||
+             y - PATCH_RADIUS - 1 < 0 || y + PATCH_RADIUS + 1 >= rows )
+        {
+            return false;
+        }
+
+        int bestI = 0;
+        int bestJ = 0;
+        for (int j = -1; j <= 1; ++j)
+        {
+            for (int i = -1; i <= 1; ++i)
+            {
+                extractPatch(image2, x + i, y + j, candidate);
+                scores[j + 1][i + 1] = correlation(patch, candidate);
+                if ( scores[j + 1][i + 1] > scores[bestJ + 1][bestI + 1] )
+                {
+                    bestI = i;
+                    bestJ = j;
+                }
+            }
+        }
+
+        if ( bestI == 0 && bestJ == 0 )
+        {
+            xOut = x + parabolaPeak(scores[1][0], scores[1][1], scores[1][2]);
+            yOut = y + parabolaPeak(scores[0][1], scores[1][1], scores[2][1]);
+            return true;
+        }
+        x += bestI;
+        y += bestJ;
+    }
+    return false;
+}
+
+// matches the keypoints of features1 with those of features2 in a radius
+void matchFeatures(const FeatureSet& features1, const FeatureSet& features2,
+                   std::vector<Match>& matches)
+{
+    const std::vector<Keypoint>& kp1 = features1.keypoints;
+    const std::vector<Keypoint>& kp2 = features2.keypoints;
+
+    const int cols = features2.image.getCols();
+    const int rows = features2.image.getRows();
+    const int radius = std::max(2*CELL_SIZE,
+                                (int)(SEARCH_RADIUS*std::max(cols, rows)));
+
+    // keypoints of the second set, bucketed in cells of the size of the radius
+    const int cellsX = cols/radius + 1;
+    const int cellsY = rows/radius + 1;
+    std::vector< std::vector<int> > grid(cellsX*cellsY);
+    for (size_t k = 0; k < kp2.size(); ++k)
+    {
+        grid[(kp2[k].y/radius)*cellsX + kp2[k].x/radius].push_back(k);
+    }
+
+    const int numKeypoints = kp1.size();
+    std::vector<int> bestMatch(numKeypoints, -1);
+    std::vector<float> bestScore(numKeypoints, 0.f);
+
+#pragma omp parallel for schedule(dynamic, 64)
+    for (int k = 0; k < numKeypoints; ++k)
+    {
+        const float* patch = &features1.patches[k*PATCH_SIZE];
+        const int cx = kp1[k].x/radius;
+        const int cy = kp1[k].y/radius;
+
+        float best = -1.f;
+        float second = -1.f;
+        int bestIdx = -1;
+        for (int gy = std::max(cy - 1, 0); gy <= std::min(cy + 1, cellsY - 1); ++gy)
+        {
+            for (int gx = std::max(cx - 1, 0); gx <= std::min(cx + 1, cellsX - 1); ++gx)
+            {
+                const std::vector<int>& cell = grid[gy*cellsX + gx];
+                for (size_t c = 0; c < cell.size(); ++c)
+                {
+                    const Keypoint& candidate = kp2[cell[c]];
+                    const int dx = candidate.x - kp1[k].x;
+                    const int dy = candidate.y - kp1[k].y;
+                    if ( dx*dx + dy*dy > radius*radius ) continue;
+
+                    const float score = correlation(patch, &features2.patches[cell[c]*PATCH_SIZE]);
+                    if ( score > best )
+                    {
+                        second = best;
+                        best = score;
+                        bestIdx = cell[c];
+                    }
+                    else if ( score > second )
+                    {
+                        second = score;
+                    }
+                }
+            }
+        }
+
+        if ( best >= MIN_CORRELATION && best - second >= MIN_CORRELATION_MARGIN )
+        {
+            bestMatch[k] = bestIdx;
+            bestScore[k] = best;
+        }
+    }
+
+    // each keypoint of the second set is matched at most once
+    std::vector<int> owner(kp2.size(), -1);
+    for (int k = 0; k < numKeypoints; ++k)
+    {
+        const int m = bestMatch[k];
+        if ( m < 0 ) continue;
+        if ( owner[m] < 0 || bestScore[owner[m]] < bestScore[k] )
+        {
+            owner[m] = k;
+        }
+    }
+
+    std::vector<int> pairs;
+    for (size_t m = 0; m < owner.size(); ++m)
+    {
+        if ( owner[m] >= 0 ) pairs.push_back(m);
+    }
+
+    std::vector<Match> refined(pairs.size());
+    std::vector<char> valid(pairs.size(), 0);
+#pragma omp parallel for
+    for (int p = 0; p < (int)pairs.size(); ++p)
+    {
+        const int m = pairs[p];
+        const int k = owner[m];
+        Match& match = refined[p];
+        match.x1 = kp1[k].x;
+        match.y1 = kp1[k].y;
+        valid[p] = refineMatch(&features1.patches[k*PATCH_SIZE], features2.image,
+                               kp2[m].x, kp2[m].y, match.x2, match.y2);
+    }
+
+    matches.clear();
+    for (size_t p = 0; p < refined.size(); ++p)
+    {
+        if ( valid[p] ) matches.push_back(refined[p]);
+    }
+
+    PRINT_DEBUG("matchFeatures: " << matches.size() << " matches");
+}
+
+// solves the n x n system A x = b (row major) with partial pivoting
+bool solveLinearSystem(std::vector<double>& A, std::vector<double>& b, int n)
+{
+    for (int col = 0; col < n; ++col)
+    {
+        int pivot = col;
+        for (int r = col + 1; r < n; ++r)
+        {
+            if ( std::fabs(A[r*n + col]) > std::fabs(A[pivot*n + col]) ) pivot = r;
+        }
+        if ( std::fabs(A[pivot*n + col]) < 1e-12 ) return false;
+
+        if ( pivot != col )
+        {
+            for (int c = 0; c < n; ++c) std::swap(A[col*n + c], A[pivot*n + c]);
+            std::swap(b[col], b[pivot]);
+        }
+
+        for (int r = col + 1; r < n; ++r)
+        {
+            const double f = A[r*n + col]/A[col*n + col];
+            for (int c = col; c < n; ++c) A[r*n + c] -= f*A[col*n + c];
+            b[r] -= f*b[col];
+        }
+    }
+
+    for (int r = n - 1; r >= 0; --r)
+    {
+        double sum = b[r];
+        for (int c = r + 1; c < n; ++c) sum -= A[r*n + c]*b[c];
+        b[r] = sum/A[r*n + r];
+    }
+    return true;
+}
+
+// similarity moving the centroid of the points in the origin, at an average
+// distance of sqrt(2) (Hartley's normalization)
+Homography normalization(const std::vector<Match>& matches,
+                         const std::vector<size_t>& idx, bool first)
+{
+    double cx = 0.;
+    double cy = 0.;
+    for (size_t i = 0; i < idx.size(); ++i)
+    {
+        const Match& m = matches[idx[i]];
+        cx += first ? m.x1 : m.x2;
+        cy += first ? m.y1 : m.y2;
+    }
+    cx /= idx.size();
+    cy /= idx.size();
+
+    double dist = 0.;
+    for (size_t i = 0; i < idx.size(); ++i)
+    {
+        const Match& m = matches[idx[i]];
+        const double dx = (first ? m.x1 : m.x2) - cx;
+        const double dy = (first ? m.y1 : m.y2) - cy;
+        dist += std::sqrt(dx*dx + dy*dy);
+    }
+    dist /= idx.size();
+    const double s = (dist > 0.) ? std::sqrt(2.)/dist : 1.;
+
+    const double h[9] = { s, 0., -s*cx, 0., s, -s*cy, 0., 0., 1. };
+    return Homography(h);
+}
+
+// least squares fit of the model over the matches in idx
+bool fitModel(const std::vector<Match>& matches, const std::vector<size_t>& idx,
+              FeatureAlignmentModel model, Homography& H)
+{
+    const Homography T1 = normalization(matches, idx, true);
+    const Homography T2 = normalization(matches, idx, false);
+
+    const int n = (model == FEATURE_ALIGN_HOMOGRAPHY) ? 8 : 6;
+    std::vector<double> AtA(n*n, 0.);
+    std::vector<double> Atb(n, 0.);
+
+    double rows[2][8];
+    double rhs[2];
+    for (size_t i = 0; i < idx.size(); ++i)
+    {
+        const Match& m = matches[idx[i]];
+        double x, y, u, v;
+        T1.apply(m.x1, m.y1, x, y);
+        T2.apply(m.x2, m.y2, u, v);
+
+        if ( model == FEATURE_ALIGN_HOMOGRAPHY )
+        {
+            // u (h6 x + h7 y + 1) = h0 x + h1 y + h2, and the same for v
+            const double r0[8] = { x, y, 1., 0., 0., 0., -u*x, -u*y };
+            const double r1[8] = { 0., 0., 0., x, y, 1., -v*x, -v*y };
+            std::copy(r0, r0 + 8, rows[0]);
+            std::copy(r1, r1 + 8, rows[1]);
+        }
+        else
+        {
+            const double r0[6] = { x, y, 1., 0., 0., 0. };
+            const double r1[6] = { 0., 0., 0., x, y, 1. };
+            std::copy(r0, r0 + 6, rows[0]);
+            std::copy(r1, r1 + 6, rows[1]);
+        }
+        rhs[0] = u;
+        rhs[1] = v;
+
+        for (int e = 0; e < 2; ++e)
+        {
+            for (int r = 0; r < n; ++r)
+            {
+                for (int c = 0; c < n; ++c) AtA[r*n + c] += rows[e][r]*rows[e][c];
+                Atb[r] += rows[e][r]*rhs[e];
+            }
+        }
+    }
+
+    if ( !solveLinearSystem(AtA, Atb, n) ) return false;
+
+    double h[9] = { Atb[0], Atb[1], Atb[2], Atb[3], Atb[4], Atb[5], 0., 0., 1. };
+    if ( model == FEATURE_ALIGN_HOMOGRAPHY )
+    {
+        h[6] = Atb[6];
+        h[7] = Atb[7];
+    }
+
+    Homography T2inv;
+    if ( !T2.inverse(T2inv) ) return false;
+    H = T2inv*Homography(h)*T1;
+    return true;
+}
+
+double reprojectionError(const Homography& H, const Match& m)
+{
+    double u, v;
+    H.apply(m.x1, m.y1, u, v);
+    return (u - m.x2)*(u - m.x2) + (v - m.y2)*(v - m.y2);
+}
+
+void findInliers(const std::vector<Match>& matches, const Homography& H,
+                 std::vector<size_t>& inliers)
+{
+    const double threshold = INLIER_THRESHOLD*INLIER_THRESHOLD;
+    inliers.clear();
+    for (size_t i = 0; i < matches.size(); ++i)
+    {
+        if ( reprojectionError(H, matches[i]) < threshold ) inliers.push_back(i);
+    }
+}
+
+bool ransac(const std::vector<Match>& matches, FeatureAlignmentModel model,
+            Homography& H)
+{
+    const size_t sampleSize = (model == FEATURE_ALIGN_HOMOGRAPHY) ? 4 : 3;
+    if ( matches.size() < std::max(sampleSize, MIN_INLIERS) ) return false;
+
+    // xorshift generator with a fixed seed: the result is reproducible
+    boost::uint32_t state = 2463534242u;
+
+    std::vector<size_t> sample(sampleSize);
+    std::vector<size_t> inliers;
+    std::vector<size_t> bestInliers;
+    int iterations = RANSAC_ITERATIONS;
+    for (int it = 0; it < iterations; ++it)
+    {
+        for (size_t s = 0; s < sampleSize; ++s)
+        {
+            bool unique;
+            do
+            {
+                state ^= state << 13;
+                state ^= state >> 17;
+                state ^= state << 5;
+                sample[s] = state % matches.size();
+
+                unique = true;
+                for (size_t t = 0; t < s; ++t) unique &= (sample[t] != sample[s]);
+            } while ( !unique );
+        }
+
+        Homography candidate;
+        if ( !fitModel(matches, sample, model, candidate) ) continue;
+
+        findInliers(matches, candidate, inliers);
+        if ( inliers.size() > bestInliers.size() )
+        {
+            bestInliers.swap(inliers);
+
+            // enough iterations to draw an outlier free sample with
+            // probability 0.999
+            const double ratio = double(bestInliers.size())/matches.size();
+            const double p = std::pow(ratio, double(sampleSize));
+            if ( p > 1. - 1e-9 )
+            {
+                iterations = 0;
+            }
+            else if ( p > 0. )
+            {
+                const double needed = std::log(1e-3)/std::log(1. - p);
+                iterations = std::min<double>(iterations, needed + 1.);
+            }
+        }
+    }
+
+    if ( bestInliers.size() < MIN_INLIERS ) return false;
+
+    // least squares refinement over the inliers
+    for (int refine = 0; refine < 2; ++refine)
+    {
+        if ( !fitModel(matches, bestInliers, model, H) ) return false;
+        findInliers(matches, H, inliers);
+        if ( inliers.size() < MIN_INLIERS ) return false;
+        bestInliers.swap(inliers);
+    }
+
+    PRINT_DEBUG("ransac: " << bestInliers.size() << " inliers over " << matches.size());
+    return true;
+}
+
+// working image pixel (x, y) covers the full resolution pixels
+// [scale*x, scale*x + scale[, whose center is scale*x + (scale - 1)/2
+Homography toFullResolution(const Homography& H, int scale)
+{
+    const double offset = 0.5*(scale - 1);
+    const double s[9] = { double(scale), 0., offset, 0., double(scale), offset, 0., 0., 1. };
+    const double sInv[9] = { 1./scale, 0., -offset/scale, 0., 1./scale, -offset/scale, 0., 0., 1. };
+    return Homography(s)*H*Homography(sInv);
+}
+
+int workingScale(size_t width, size_t height)
+{
+    int scale = 1;
+    while ( std::max(width, height)/scale > WORKING_SIZE )
+    {
+        scale *= 2;
+    }
+    return scale;
+}
+
+bool estimatePair(const FeatureSet& features1, const FeatureSet& features2,
+                  FeatureAlignmentModel model, Homography& H)
+{
+    std::vector<Match> matches;
+    matchFeatures(features1, features2, matches);
+    return ransac(matches, model, H);
+}
+}
+
+bool estimateTransform(const pfs::Frame& image1, const pfs::Frame& image2,
+                       Homography& H, FeatureAlignmentModel model)
+{
+    const int scale = workingScale(image1.getWidth(), image1.getHeight());
+
+    FeatureSet features1;
+    FeatureSet features2;
+    buildFeatureSet(image1, scale, features1);
+    buildFeatureSet(image2, scale, features2);
+
+    Homography Hw;
+    if ( !estimatePair(features1, features2, model, Hw) ) return false;
+
+    H = toFullResolution(Hw, scale);
+    return true;
+}
+
+void warpFrame(const pfs::Frame& in, const Homography& H, pfs::Frame& out)
+{
+    const int cols = in.getWidth();
+    const int rows = in.getHeight();
+
+    out.resize(cols, rows);
+
+    const ChannelContainer& channels = in.getChannels();
+    std::vector<const Channel*> inChannels;
+    std::vector<Channel*> outChannels;
+    for (ChannelContainer::const_iterator it = channels.begin(); it != channels.end(); ++it)
+    {
+        inChannels.push_back(*it);
+        outChannels.push_back(out.createChannel((*it)->getName()));
+    }
+
+#pragma omp parallel
+    {
+        // source positions of a row, shared by all the channels
+        std::vector<int> offsets(cols);
+        std::vector<float> fx(cols);
+        std::vector<float> fy(cols);
+
+#pragma omp for schedule(dynamic)
+        for (int y = 0; y < rows; ++y)
+        {
+            // the homogeneous coordinates are linear along the row
+            double X = H(0, 1)*y + H(0, 2);
+            double Y = H(1, 1)*y + H(1, 2);
+            double W = H(2, 1)*y + H(2, 2);
+            for (int x = 0; x < cols; ++x)
+            {
+                const double u = X/W;
+                const double v = Y/W;
+                X += H(0, 0);
+                Y += H(1, 0);
+                W += H(2, 0);
+
+                if ( !(u >= 0. && u <= cols - 1 && v >= 0. && v <= rows - 1) )
+                {
+                    offsets[x] = -1;
+                    continue;
+                }
+
+                const int u0 = std::min((int)u, cols - 2);
+                const int v0 = std::min((int)v, rows - 2);
+                offsets[x] = v0*cols + u0;
+                fx[x] = u - u0;
+                fy[x] = v - v0;
+            }
+
+            for (size_t c = 0; c < inChannels.size(); ++c)
+            {
+                const float* src = inChannels[c]->data();
+                float* dst = outChannels[c]->data() + (size_t)y*cols;
+                for (int x = 0; x < cols; ++x)
+                {
+                    if ( offsets[x] < 0 )
+                    {
+                        dst[x] = 0.f;
+                        continue;
+                    }
+                    const float* p = src + offsets[x];
+                    const float top = p[0] + fx[x]*(p[1] - p[0]);
+                    const float bottom = p[cols] + fx[x]*(p[cols + 1] - p[cols]);
+                    dst[x] = top + fy[x]*(bottom - top);
+                }
+            }
+        }
+    }
+}
+
+bool feature_alignment(std::vector<pfs::FramePtr>& framePtrList,
+                       FeatureAlignmentModel model)
+{
+    if ( framePtrList.size() <= 1 ) return true;
+
+    const int numFrames = framePtrList.size();
+    const int scale = workingScale(framePtrList[0]->getWidth(),
+                                   framePtrList[0]->getHeight());
+    PRINT_DEBUG("working scale " << scale);
+
+    std::vector<FeatureSet> features(numFrames);
+#pragma omp parallel for schedule(dynamic)
+    for (int i = 0; i < numFrames; ++i)
+    {
+        buildFeatureSet(*framePtrList[i], scale, features[i]);
+    }
+
+    // transform from frame i to frame i+1
+    std::vector<Homography> pairs(numFrames - 1);
+    std::vector<char> found(numFrames - 1, 0);
+#pragma omp parallel for schedule(dynamic)
+    for (int i = 0; i < numFrames - 1; ++i)
+    {
+        found[i] = estimatePair(features[i], features[i + 1], model, pairs[i]);
+        if ( !found[i] )
+        {
+            PRINT_DEBUG("no transform found between frames " << i << " and " << i + 1);
+            pairs[i] = Homography();
+        }
+    }
+    features.clear();
+
+    bool success = true;
+    Homography chain;
+    for (int i = 1; i < numFrames; ++i)
+    {
+        success &= (found[i - 1] != 0);
+        chain = pairs[i - 1]*chain;
+
+        const Homography H = toFullResolution(chain, scale);
+        PRINT_DEBUG("frame " << i << ": [" << H(0, 0) << " " << H(0, 1) << " " << H(0, 2)
+                    << "; " << H(1, 0) << " " << H(1, 1) << " " << H(1, 2)
+                    << "; " << H(2, 0) << " " << H(2, 1) << " " << H(2, 2) << "]");
+
+        Frame warped;
+        warpFrame(*framePtrList[i], H, warped);
+        pfs::copyTags(framePtrList[i].get(), &warped);
+
+        framePtrList[i]->swap(warped);
+    }
+
+    return success;
+}
+
+}   // libhdr
@@ -0,0 +1,91 @@
+/*
+ * This file is a part of Luminance HDR package
+ * ----------------------------------------------------------------------
+ * Copyright (C) 2017 Luminance HDR developers
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+#ifndef LIBHDR_FEATURE_ALIGNMENT_H
+#define LIBHDR_FEATURE_ALIGNMENT_H
+
+//! \brief In-process feature based alignment of the frames of a bracket.
+//! Corners are detected on a rank-equalized log luminance, which does not
+//! change with the exposure, and matched across frames by normalized cross
+//! correlation. The transform between each pair of adjacent frames is
+//! estimated with RANSAC, then the frames are resampled in memory on the
+//! grid of the first one.
+
+#include <vector>
+
+#include <Libpfs/frame.h>
+
+namespace libhdr {
+
+//! \brief transform estimated between the frames
+enum FeatureAlignmentModel
+{
+    FEATURE_ALIGN_AFFINE,       //!< translation, rotation, scale and shear
+    FEATURE_ALIGN_HOMOGRAPHY    //!< full projective transform
+};
+
+//! \brief projective transform of the plane, as a row major 3x3 matrix
+class Homography
+{
+public:
+    //! \brief identity transform
+    Homography();
+    explicit Homography(const double* h);
+
+    double& operator()(int row, int col)        { return m_h[3*row + col]; }
+    double operator()(int row, int col) const   { return m_h[3*row + col]; }
+
+    //! \brief maps (x, y) into (u, v)
+    void apply(double x, double y, double& u, double& v) const;
+
+    //! \brief composition: (A*B).apply(p) == A.apply(B.apply(p))
+    Homography operator*(const Homography& rhs) const;
+
+    //! \return false if the matrix is singular
+    bool inverse(Homography& inv) const;
+
+private:
+    double m_h[9];
+};
+
+//! \brief estimates the transform \a H mapping the pixel coordinates of
+//! \a image1 onto those of \a image2
+//! \return false if not enough features could be matched
+bool estimateTransform(const pfs::Frame& image1, const pfs::Frame& image2,
+                       Homography& H,
+                       FeatureAlignmentModel model = FEATURE_ALIGN_HOMOGRAPHY);
+
+//! \brief resamples (bilinear) all the channels of \a in, such that
+//! out(x, y) = in(H(x, y)). Pixels mapped outside of \a in are set to zero.
+//! \a out is resized to the size of \a in
+void warpFrame(const pfs::Frame& in, const Homography& H, pfs::Frame& out);
+
+//! \brief aligns all the frames to the first one. The transforms are
+//! estimated between adjacent frames (concurrently), which have the most
+//! similar exposures, and chained.
+//! \return false if some pair could not be matched: the frames past it are
+//! then aligned as if the pair did not move
+bool feature_alignment(std::vector<pfs::FramePtr>& framePtrList,
+                       FeatureAlignmentModel model = FEATURE_ALIGN_HOMOGRAPHY);
+
+}   // libhdr
+
+#endif // LIBHDR_FEATURE_ALIGNMENT_H
@@ -24,12 +24,15 @@
 #include "mtb_alignment.h"
 
 #include <boost/lexical_cast.hpp>
+#include <boost/predef/other/endian.h>
 #include <cmath>
 #include <iso646.h>
 #include <cassert>
+#include <cstring>
 #include <vector>
 #include <cmath>
 #include <iostream>
+#include <limits>
 
 #include <Common/global.h>
 #include <Libpfs/array2d.h>
@@ -37,12 +40,13 @@
 #include <Libpfs/utils/transform.h>
 #include <Libpfs/colorspace/convert.h>
 #include <Libpfs/colorspace/xyz.h>
-#include <Libpfs/manip/resize.h>
 #include <Libpfs/manip/shift.h>
 
 #include <Libpfs/io/jpegwriter.h>
 #include "arch/math.h"
 
+#include "packedbitmap.h"
+
 using namespace std;
 using namespace pfs;
 
@@ -53,115 +57,166 @@ using namespace pfs;
 #endif
 
 typedef Array2D<uint8_t> Array2D8u;
-typedef Array2D<bool> Array2Db;
 
 namespace libhdr {
 
-long XORimages(const Array2Db& img1, const Array2Db& mask1,
-               const Array2Db& img2, const Array2Db& mask2)
+//! \brief threshold and exclusion bitmaps of a frame, from the full
+//! resolution (level 0) to the coarsest level
+struct MtbPyramid
 {
-    long err = 0;
-    for (size_t i = 0; i < img1.getRows(); i++)
-    {
-        Array2Db::const_iterator p1 = img1.row_begin(i);
-        Array2Db::const_iterator p2 = img2.row_begin(i);
-        Array2Db::const_iterator m1 = mask1.row_begin(i);
-        Array2Db::const_iterator m2 = mask2.row_begin(i);
+    std::vector<PackedBitmap> thresholds;
+    std::vector<PackedBitmap> masks;
+};
 
-        for (size_t j = 0; j < img1.getCols(); j++)
-        {
-            err += (long)((*p1++ xor *p2++) and *m1++ and *m2++);
-        }
+// packs 64 flags (bytes valued 0 or 1) in a word, the first flag in the
+// least significant bit
+inline PackedBitmap::Word packFlags(const uint8_t* flags)
+{
+    typedef PackedBitmap::Word Word;
+
+    Word word = 0;
+#if BOOST_ENDIAN_LITTLE_BYTE
+    for (size_t k = 0; k < PackedBitmap::BITS/8; k++)
+    {
+        Word group;
+        std::memcpy(&group, flags + 8*k, sizeof(group));
+        // moves the lowest bit of each byte of group into the top byte, with
+        // the first byte in the lowest position
+        word |= ((group * 0x0102040810204080ULL) >> 56) << (8*k);
     }
-    return err;
+#else
+    for (size_t k = 0; k < PackedBitmap::BITS; k++)
+    {
+        word |= Word(flags[k]) << k;
+    }
+#endif
+    return word;
 }
 
-
 // setThreshold gets the data from the input image and creates the threshold
 // and mask images.
 // Those are bitmap (0,1 valued) with depth()=1
 void setThreshold(const Array2D8u& in, const int threshold, const int noise,
-                  Array2Db& threshold_out, Array2Db& mask_out)
+                  PackedBitmap& threshold_out, PackedBitmap& mask_out)
 {
-    assert(in.getCols() == threshold_out.getCols());
-    assert(in.getRows() == threshold_out.getRows());
-    assert(in.getCols() == mask_out.getCols());
-    assert(in.getRows() == mask_out.getRows());
+    typedef PackedBitmap::Word Word;
+
+    threshold_out.resize(in.getCols(), in.getRows());
+    mask_out.resize(in.getCols(), in.getRows());
+
+    const size_t cols = in.getCols();
+    const size_t words = threshold_out.getWordsPerRow();
+    const int low = threshold - noise;
+    const int high = threshold + noise;
+
+    // one byte (0 or 1) per pixel, padded to a whole number of words
+    vector<uint8_t> outFlags(words*PackedBitmap::BITS, 0);
+    vector<uint8_t> maskFlags(words*PackedBitmap::BITS, 0);
 
     for (size_t i = 0; i < in.getRows(); i++)
     {
         Array2D8u::const_iterator inp = in.row_begin(i);
 
-        Array2Db::iterator outp = threshold_out.row_begin(i);
-        Array2Db::iterator maskp = mask_out.row_begin(i);
+        // branchless, so that the compiler can vectorize it
+        for (size_t j = 0; j < cols; j++)
+        {
+            const int value = inp[j];
+            outFlags[j] = (value >= threshold);
+            maskFlags[j] = (value <= low) | (value >= high);
+        }
 
-        for (size_t j = 0; j < in.getCols(); j++)
+        Word* outp = threshold_out.row(i);
+        Word* maskp = mask_out.row(i);
+        for (size_t w = 0; w < words; w++)
         {
-            *outp++ = *inp < threshold ? 0 : 1;
-            *maskp++ = (*inp > (threshold-noise)) && (*inp < (threshold+noise)) ? 0 : 1;
-            ++inp;
+            outp[w] = packFlags(&outFlags[w*PackedBitmap::BITS]);
+            maskp[w] = packFlags(&maskFlags[w*PackedBitmap::BITS]);
         }
     }
 }
 
-void getExpShift(const Array2D8u& img1, const int median1,
-                 const Array2D8u& img2, const int median2,
-                 const int noise, const int shift_bits,
-                 int &shift_x, int &shift_y)
+// halves the size of in, averaging blocks of 2x2 pixels
+void halfSize(const Array2D8u& in, Array2D8u& out)
 {
-    assert(img1.getCols() == img2.getCols());
-    assert(img1.getRows() == img2.getRows());
-
-    int curr_x = 0;
-    int curr_y = 0;
+    assert(out.getCols() == in.getCols()/2);
+    assert(out.getRows() == in.getRows()/2);
 
-    if (shift_bits > 0)
+    for (size_t i = 0; i < out.getRows(); i++)
     {
-        Array2D8u img1small(img1.getCols()/2, img1.getRows()/2);
-        Array2D8u img2small(img2.getCols()/2, img2.getRows()/2);
-
-        pfs::resize(img1, img1small, BilinearInterp);
-        pfs::resize(img2, img2small, BilinearInterp);
+        Array2D8u::const_iterator in0 = in.row_begin(2*i);
+        Array2D8u::const_iterator in1 = in.row_begin(2*i + 1);
+        Array2D8u::iterator outp = out.row_begin(i);
 
-        getExpShift(img1small, median1, img2small, median2,
-                    noise, shift_bits-1, curr_x, curr_y);
-        curr_x *= 2;
-        curr_y *= 2;
+        for (size_t j = 0; j < out.getCols(); j++)
+        {
+            *outp++ = (in0[0] + in0[1] + in1[0] + in1[1] + 2) / 4;
+            in0 += 2;
+            in1 += 2;
+        }
     }
+}
 
-    Array2Db img1threshold(img1.getCols(), img1.getRows());
-    Array2Db img1mask(img1.getCols(), img1.getRows());
-    Array2Db img2threshold(img2.getCols(), img2.getRows());
-    Array2Db img2mask(img2.getCols(), img2.getRows());
+// the bitmaps of each level are compared against the other image shifted by
+// one pixel in each direction, around the (doubled) shift of the previous
+// level
+void getExpShift(const MtbPyramid& pyramid1, const MtbPyramid& pyramid2,
+                 int &shift_x, int &shift_y)
+{
+    assert(pyramid1.thresholds.size() == pyramid2.thresholds.size());
 
-    setThreshold(img1, median1, noise, img1threshold, img1mask);
-    setThreshold(img2, median2, noise, img2threshold, img2mask);
+    int curr_x = 0;
+    int curr_y = 0;
 
-    Array2Db img2_shifted(img2.getCols(), img2.getRows());
-    Array2Db img2mask_shifted(img2.getCols(), img2.getRows());
+    PackedBitmap img2_shifted;
+    PackedBitmap img2mask_shifted;
 
-    int minerr = img1.size();
-    for (int i = -1; i <= 1; i++)
+    for (int level = pyramid1.thresholds.size() - 1; level >= 0; level--)
     {
-        for (int j = -1; j <= 1; j++)
+        const PackedBitmap& img1threshold = pyramid1.thresholds[level];
+        const PackedBitmap& img1mask = pyramid1.masks[level];
+        const PackedBitmap& img2threshold = pyramid2.thresholds[level];
+        const PackedBitmap& img2mask = pyramid2.masks[level];
+
+        img2_shifted.resize(img2threshold.getCols(), img2threshold.getRows());
+        img2mask_shifted.resize(img2mask.getCols(), img2mask.getRows());
+
+        size_t minerr = std::numeric_limits<size_t>::max();
+        int best_x = curr_x;
+        int best_y = curr_y;
+        for (int i = -1; i <= 1; i++)
         {
-            int dx = curr_x + i;
-            int dy = curr_y + j;
-
-            pfs::shift(img2threshold, dx, dy, img2_shifted);
-            pfs::shift(img2mask, dx, dy, img2mask_shifted);
+            for (int j = -1; j <= 1; j++)
+            {
+                int dx = curr_x + i;
+                int dy = curr_y + j;
+
+                shift(img2threshold, dx, dy, img2_shifted);
+                shift(img2mask, dx, dy, img2mask_shifted);
+
+                size_t err = countDifferences(img1threshold, img1mask,
+                                              img2_shifted, img2mask_shifted);
+
+                if ( err < minerr ) {
+                    minerr = err;
+                    best_x = dx;
+                    best_y = dy;
+                }
+            }
+        }
 
-            long err = XORimages(img1threshold, img1mask, img2_shifted, img2mask_shifted);
+        PRINT_DEBUG("getExpShift::Level " << level << " shift (" << best_x << "," << best_y << ")");
 
-            if ( err < minerr ) {
-                minerr = err;
-                shift_x = dx;
-                shift_y = dy;
-            }
+        curr_x = best_x;
+        curr_y = best_y;
+        if ( level > 0 )
+        {
+            curr_x *= 2;
+            curr_y *= 2;
         }
     }
 
-    PRINT_DEBUG("getExpShift::Level " << shift_bits    << " shift (" << shift_x << "," << shift_y << ")");
+    shift_x = curr_x;
+    shift_y = curr_y;
 }
 
 int getLum(const Frame& in, Array2D8u& out, double quantile)
@@ -204,20 +259,43 @@ int getLum(const Frame& in, Array2D8u& out, double quantile)
     return idx;
 }
 
+// computes the luminance of the frame and its bitmaps for shift_bits
+// downsampled levels, all thresholded with the median of the full resolution
+void buildPyramid(const pfs::Frame& image, const double quantile,
+                  const int noise, const int shift_bits, MtbPyramid& pyramid)
+{
+    Array2D8u lum;
+    int median = getLum(image, lum, quantile);
+
+    PRINT_DEBUG("buildPyramid::median " << median);
+
+    pyramid.thresholds.resize(shift_bits + 1);
+    pyramid.masks.resize(shift_bits + 1);
+    for (int level = 0; level <= shift_bits; level++)
+    {
+        setThreshold(lum, median, noise,
+                     pyramid.thresholds[level], pyramid.masks[level]);
+
+        if ( level < shift_bits )
+        {
+            Array2D8u lumSmall(lum.getCols()/2, lum.getRows()/2);
+            halfSize(lum, lumSmall);
+            lum.swap(lumSmall);
+        }
+    }
+}
+
 void mtbalign(const pfs::Frame& image1, const pfs::Frame& image2,
               const double quantile, const int noise, const int shift_bits,
               int &shift_x, int &shift_y)
 {
-    Array2D8u img1lum;
-    Array2D8u img2lum;
+    MtbPyramid pyramid1;
+    MtbPyramid pyramid2;
 
-    int median1 = getLum(image1, img1lum, quantile);
-    int median2 = getLum(image2, img2lum, quantile);
+    buildPyramid(image1, quantile, noise, shift_bits, pyramid1);
+    buildPyramid(image2, quantile, noise, shift_bits, pyramid2);
 
-    PRINT_DEBUG("align::medians, image 1: " << median1 << ", image 2: " << median2);
-    getExpShift(img1lum, median1,
-                img2lum, median2,
-                noise, shift_bits, shift_x, shift_y);
+    getExpShift(pyramid1, pyramid2, shift_x, shift_y);
 
     PRINT_DEBUG("align::done, final shift is (" << shift_x << "," << shift_y <<")");
 }
@@ -238,35 +316,50 @@ void mtb_alignment(std::vector<pfs::FramePtr> &framePtrList)
                     ) - 6, 0);
     PRINT_DEBUG("width=" << width << ", height=" << height << ", shift_bits=" << shift_bits);
 
+    const int numFrames = framePtrList.size();
+
+    // each frame takes part in two pairs: its bitmaps are built only once
+    vector<MtbPyramid> pyramids(numFrames);
+#pragma omp parallel for schedule(dynamic)
+    for (int i = 0; i < numFrames; i++)
+    {
+        buildPyramid(*framePtrList[i], quantile, noise, shift_bits, pyramids[i]);
+    }
+
     // these arrays contain the shifts of each image (except the 0-th) wrt the previous one
-    vector<int> shiftsX(framePtrList.size()-1);
-    vector<int> shiftsY(framePtrList.size()-1);
+    vector<int> shiftsX(numFrames-1);
+    vector<int> shiftsY(numFrames-1);
 
     // find the shitfs
-    for (size_t i = 0; i < framePtrList.size()-1; i++)
+#pragma omp parallel for schedule(dynamic)
+    for (int i = 0; i < numFrames-1; i++)
     {
-        mtbalign(*framePtrList[i], *framePtrList[i+1],
-                quantile, noise, shift_bits, shiftsX[i], shiftsY[i]);
+        getExpShift(pyramids[i], pyramids[i+1], shiftsX[i], shiftsY[i]);
     }
+    pyramids.clear();
 
     PRINT_DEBUG("shifting the images");
-    int originalsize = framePtrList.size();
 
-    int cumulativeX = 0;
-    int cumulativeY = 0;
-    // shift the images (apply the shifts starting from the second (index=1))
-    for (int i = 1; i < originalsize; i++)
+    // cumulative shifts (apply the shifts starting from the second (index=1))
+    vector<int> cumulativeX(numFrames, 0);
+    vector<int> cumulativeY(numFrames, 0);
+    for (int i = 1; i < numFrames; i++)
     {
-        cumulativeX += shiftsX[i - 1];
-        cumulativeY += shiftsY[i - 1];
+        cumulativeX[i] = cumulativeX[i - 1] + shiftsX[i - 1];
+        cumulativeY[i] = cumulativeY[i - 1] + shiftsY[i - 1];
+    }
 
+#pragma omp parallel for schedule(dynamic)
+    for (int i = 1; i < numFrames; i++)
+    {
         // avoid shifting if cumulativeX and cumulativeY are zero
-        if ( cumulativeX || cumulativeY )
+        if ( cumulativeX[i] || cumulativeY[i] )
         {
-            PRINT_DEBUG("Cumulative shift for image " << i << " = (" << cumulativeX
-                        << "," <<cumulativeY << ")");
+            PRINT_DEBUG("Cumulative shift for image " << i << " = (" << cumulativeX[i]
+                        << "," << cumulativeY[i] << ")");
 
-            FramePtr shiftedFrame( pfs::shift(*framePtrList[i], cumulativeX, cumulativeY) );
+            // pfs::shift() moves the content of the frame by (dx, dy)
+            FramePtr shiftedFrame( pfs::shift(*framePtrList[i], -cumulativeX[i], -cumulativeY[i]) );
 
             framePtrList[i]->swap( *shiftedFrame );
         }
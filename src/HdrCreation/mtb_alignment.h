@@ -34,6 +34,18 @@
 
 namespace libhdr {
 
+//! \brief finds the translation that aligns \a image2 to \a image1, such
+//! that image2(x + shift_x, y + shift_y) matches image1(x, y)
+//! \param quantile quantile of the luminance used as threshold (0.5: median)
+//! \param noise pixels closer than \a noise to the threshold are ignored
+//! \param shift_bits number of downsampled levels: the largest shift found is
+//! 2^(shift_bits + 1) - 1 pixels
+void mtbalign(const pfs::Frame& image1, const pfs::Frame& image2,
+              const double quantile, const int noise, const int shift_bits,
+              int &shift_x, int &shift_y);
+
+//! \brief aligns each frame to the previous one. The pairs of adjacent frames
+//! are aligned concurrently
 void mtb_alignment(std::vector<pfs::FramePtr>& framePtrList);
 
 }   // libhdr
@@ -0,0 +1,170 @@
+/*
+ * This file is a part of Luminance HDR package
+ * ----------------------------------------------------------------------
+ * Copyright (C) 2017 Luminance HDR developers
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+#include "packedbitmap.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace libhdr {
+
+PackedBitmap::PackedBitmap()
+    : m_cols(0)
+    , m_rows(0)
+    , m_wordsPerRow(0)
+{}
+
+PackedBitmap::PackedBitmap(size_t cols, size_t rows)
+    : m_cols(0)
+    , m_rows(0)
+    , m_wordsPerRow(0)
+{
+    resize(cols, rows);
+}
+
+void PackedBitmap::resize(size_t cols, size_t rows)
+{
+    m_cols = cols;
+    m_rows = rows;
+    m_wordsPerRow = (cols + BITS - 1)/BITS;
+    m_words.assign(m_wordsPerRow*rows, Word(0));
+}
+
+void PackedBitmap::reset()
+{
+    std::fill(m_words.begin(), m_words.end(), Word(0));
+}
+
+size_t PackedBitmap::count() const
+{
+    size_t total = 0;
+    for (size_t i = 0; i < m_words.size(); ++i)
+    {
+        total += popcount(m_words[i]);
+    }
+    return total;
+}
+
+PackedBitmap::Word PackedBitmap::lastWordMask() const
+{
+    const size_t tail = m_cols%BITS;
+    return tail ? ((Word(1) << tail) - 1) : ~Word(0);
+}
+
+void PackedBitmap::swap(PackedBitmap& other)
+{
+    std::swap(m_cols, other.m_cols);
+    std::swap(m_rows, other.m_rows);
+    std::swap(m_wordsPerRow, other.m_wordsPerRow);
+    m_words.swap(other.m_words);
+}
+
+namespace
+{
+typedef PackedBitmap::Word Word;
+
+inline Word wordAt(const Word* src, long idx, long size)
+{
+    return (idx >= 0 && idx < size) ? src[idx] : Word(0);
+}
+
+// out[x] = in[x + dx] over a row of \a size words
+void shiftRow(const Word* src, Word* dst, long size, int dx)
+{
+    const long bits = PackedBitmap::BITS;
+    if ( dx >= 0 )
+    {
+        const long q = dx/bits;
+        const int r = dx%bits;
+        for (long w = 0; w < size; ++w)
+        {
+            const Word lo = wordAt(src, w + q, size);
+            dst[w] = r ? (lo >> r) | (wordAt(src, w + q + 1, size) << (bits - r))
+                       : lo;
+        }
+    }
+    else
+    {
+        const long q = (-dx)/bits;
+        const int r = (-dx)%bits;
+        for (long w = 0; w < size; ++w)
+        {
+            const Word hi = wordAt(src, w - q, size);
+            dst[w] = r ? (hi << r) | (wordAt(src, w - q - 1, size) >> (bits - r))
+                       : hi;
+        }
+    }
+}
+}
+
+void shift(const PackedBitmap& in, int dx, int dy, PackedBitmap& out)
+{
+    assert(&in != &out);
+    assert(in.getCols() == out.getCols());
+    assert(in.getRows() == out.getRows());
+
+    const long rows = in.getRows();
+    const long words = in.getWordsPerRow();
+    if ( words == 0 ) return;
+
+    const Word lastMask = in.lastWordMask();
+    for (long y = 0; y < rows; ++y)
+    {
+        Word* dst = out.row(y);
+        const long sy = y + dy;
+        if ( sy < 0 || sy >= rows )
+        {
+            std::fill(dst, dst + words, Word(0));
+            continue;
+        }
+
+        shiftRow(in.row(sy), dst, words, dx);
+        // bits moved past the last column
+        dst[words - 1] &= lastMask;
+    }
+}
+
+size_t countDifferences(const PackedBitmap& img1, const PackedBitmap& mask1,
+                        const PackedBitmap& img2, const PackedBitmap& mask2)
+{
+    assert(img1.getCols() == img2.getCols());
+    assert(img1.getRows() == img2.getRows());
+    assert(img1.getCols() == mask1.getCols() && img1.getCols() == mask2.getCols());
+    assert(img1.getRows() == mask1.getRows() && img1.getRows() == mask2.getRows());
+
+    const size_t words = img1.getWordsPerRow();
+    size_t err = 0;
+    for (size_t y = 0; y < img1.getRows(); ++y)
+    {
+        const Word* i1 = img1.row(y);
+        const Word* i2 = img2.row(y);
+        const Word* m1 = mask1.row(y);
+        const Word* m2 = mask2.row(y);
+
+        for (size_t w = 0; w < words; ++w)
+        {
+            err += popcount((i1[w] ^ i2[w]) & m1[w] & m2[w]);
+        }
+    }
+    return err;
+}
+
+}   // libhdr
@@ -0,0 +1,111 @@
+/*
+ * This file is a part of Luminance HDR package
+ * ----------------------------------------------------------------------
+ * Copyright (C) 2017 Luminance HDR developers
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+#ifndef LIBHDR_PACKEDBITMAP_H
+#define LIBHDR_PACKEDBITMAP_H
+
+//! \brief Binary image stored as 64 bits words, used by the MTB alignment
+
+#include <cstddef>
+#include <vector>
+
+#include <boost/cstdint.hpp>
+
+namespace libhdr {
+
+//! \brief Bitmap packing 64 pixels per word.
+//! Each row starts on a new word, with bit \c x%64 of word \c x/64 holding
+//! the pixel \c x. The bits past the last column are always zero, so that
+//! the words can be combined and counted without masking the tails.
+class PackedBitmap
+{
+public:
+    typedef boost::uint64_t Word;
+    static const size_t BITS = 64;
+
+    PackedBitmap();
+    PackedBitmap(size_t cols, size_t rows);
+
+    //! \brief resizes the bitmap, which is cleared
+    void resize(size_t cols, size_t rows);
+
+    size_t getCols() const          { return m_cols; }
+    size_t getRows() const          { return m_rows; }
+    size_t getWordsPerRow() const   { return m_wordsPerRow; }
+
+    Word* row(size_t y)             { return &m_words[y*m_wordsPerRow]; }
+    const Word* row(size_t y) const { return &m_words[y*m_wordsPerRow]; }
+
+    bool get(size_t x, size_t y) const
+    { return (row(y)[x/BITS] >> (x%BITS)) & 1u; }
+
+    void set(size_t x, size_t y, bool value)
+    {
+        const Word bit = Word(1) << (x%BITS);
+        Word& word = row(y)[x/BITS];
+        word = value ? (word | bit) : (word & ~bit);
+    }
+
+    //! \brief sets all the bits to zero
+    void reset();
+
+    //! \brief number of bits set
+    size_t count() const;
+
+    //! \brief mask of the valid bits of the last word of each row
+    Word lastWordMask() const;
+
+    void swap(PackedBitmap& other);
+
+private:
+    size_t m_cols;
+    size_t m_rows;
+    size_t m_wordsPerRow;
+    std::vector<Word> m_words;
+};
+
+//! \brief number of bits set in \a word
+inline size_t popcount(PackedBitmap::Word word)
+{
+#if defined(__GNUC__)
+    return __builtin_popcountll(word);
+#else
+    word = word - ((word >> 1) & 0x5555555555555555ULL);
+    word = (word & 0x3333333333333333ULL) + ((word >> 2) & 0x3333333333333333ULL);
+    word = (word + (word >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    return (word * 0x0101010101010101ULL) >> 56;
+#endif
+}
+
+//! \brief translates \a in by (\a dx, \a dy): out(x, y) = in(x + dx, y + dy),
+//! the bits shifted in from outside the bitmap are zero. Same convention as
+//! \c pfs::shift()
+//! \note \a out must have the same size of \a in, and cannot be \a in
+void shift(const PackedBitmap& in, int dx, int dy, PackedBitmap& out);
+
+//! \brief number of pixels that differ in \a img1 and \a img2 and are set in
+//! both \a mask1 and \a mask2: popcount((img1 ^ img2) & mask1 & mask2)
+size_t countDifferences(const PackedBitmap& img1, const PackedBitmap& mask1,
+                        const PackedBitmap& img2, const PackedBitmap& mask2);
+
+}   // libhdr
+
+#endif // LIBHDR_PACKEDBITMAP_H
@@ -0,0 +1,212 @@
+/*
+ * This file is a part of Luminance HDR package
+ * ----------------------------------------------------------------------
+ * Copyright (C) 2017 Luminance HDR developers
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+#include <HdrCreation/responsecache.h>
+
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <sstream>
+#include <stdexcept>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+#include <Libpfs/frame.h>
+#include <Libpfs/exif/exifdata.hpp>
+
+namespace libhdr {
+namespace fusion {
+
+namespace
+{
+// keeps the characters that are safe in a file name on every platform
+void appendSanitized(std::string& out, const std::string& str)
+{
+    for (std::string::const_iterator it = str.begin(); it != str.end(); ++it)
+    {
+        unsigned char c = static_cast<unsigned char>(*it);
+        if ( std::isalnum(c) || c == '-' || c == '.' )
+        {
+            out.push_back(static_cast<char>(c));
+        }
+        else if ( !out.empty() && out[out.size() - 1] != '_' )
+        {
+            out.push_back('_');
+        }
+    }
+    while ( !out.empty() && out[out.size() - 1] == '_' )
+    {
+        out.erase(out.size() - 1);
+    }
+}
+
+long getCurrentProcessId()
+{
+#if defined(_WIN32)
+    return static_cast<long>(GetCurrentProcessId());
+#else
+    return static_cast<long>(getpid());
+#endif
+}
+
+// renames \a from to \a to, atomically replacing \a to if it exists
+bool replaceFile(const std::string& from, const std::string& to)
+{
+#if defined(_WIN32)
+    return MoveFileExA(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    return std::rename(from.c_str(), to.c_str()) == 0;
+#endif
+}
+
+bool fileExists(const std::string& fileName)
+{
+    FILE* file = std::fopen(fileName.c_str(), "r");
+    if ( file == NULL ) return false;
+    std::fclose(file);
+    return true;
+}
+}
+
+ResponseCurveCache::ResponseCurveCache(const std::string& directory)
+    : m_directory(directory)
+{}
+
+std::string ResponseCurveCache::key(const std::string& make,
+                                    const std::string& model,
+                                    float isoSpeed,
+                                    const std::string& encoding)
+{
+    std::string result;
+    appendSanitized(result, make);
+    if ( !result.empty() ) result.push_back('_');
+    appendSanitized(result, model);
+    if ( model.empty() || result.empty() )
+    {
+        return std::string();
+    }
+
+    std::string suffix;
+    appendSanitized(suffix, encoding);
+    if ( suffix.empty() )
+    {
+        return std::string();
+    }
+
+    std::ostringstream iso;
+    iso << "_ISO" << static_cast<long>(std::floor(isoSpeed + 0.5f));
+    return result + iso.str() + "_" + suffix;
+}
+
+std::string ResponseCurveCache::key(const pfs::exif::ExifData& exifData,
+                                    const std::string& encoding)
+{
+    return key(exifData.getCameraMake(), exifData.getCameraModel(),
+               exifData.getIsoSpeed(), encoding);
+}
+
+std::string ResponseCurveCache::fileName(const std::string& key) const
+{
+    return m_directory + "/" + key + ".m";
+}
+
+bool ResponseCurveCache::load(const std::string& key, ResponseCurve& response)
+{
+    if ( key.empty() ) return false;
+
+    boost::mutex::scoped_lock lock(m_mutex);
+
+    CurveMap::const_iterator it = m_curves.find(key);
+    if ( it == m_curves.end() )
+    {
+        const std::string file = fileName(key);
+        if ( !fileExists(file) ) return false;
+
+        ResponseCurve curve(RESPONSE_LINEAR);
+        try
+        {
+            curve.readFromFile(file);
+        }
+        catch (std::runtime_error&)
+        {
+            return false;
+        }
+        it = m_curves.insert(CurveMap::value_type(key, curve)).first;
+    }
+
+    response = it->second;
+    return true;
+}
+
+void ResponseCurveCache::store(const std::string& key, const ResponseCurve& response)
+{
+    if ( key.empty() ) return;
+
+    boost::mutex::scoped_lock lock(m_mutex);
+
+    // write and rename over the previous curve, so that a concurrent reader
+    // never sees half a curve, nor a missing one. The temporary file is
+    // unique to this process and cache, so concurrent writers do not clash
+    const std::string file = fileName(key);
+    std::ostringstream tempFile;
+    tempFile << file << "." << getCurrentProcessId() << "." << this << ".tmp";
+    FILE* probe = std::fopen(tempFile.str().c_str(), "w");
+    if ( probe == NULL ) return;
+    std::fclose(probe);
+
+    response.writeToFile(tempFile.str());
+    if ( !replaceFile(tempFile.str(), file) )
+    {
+        std::remove(tempFile.str().c_str());
+        return;
+    }
+
+    m_curves[key] = response;
+}
+
+pfs::Frame* ResponseCurveCache::computeFusion(const std::string& key, ResponseCacheMode mode,
+                                              FusionOperator type,
+                                              ResponseCurve& response, WeightFunction& weight,
+                                              const std::vector<FrameEnhanced>& frames)
+{
+    if ( type != ROBERTSON_AUTO || mode == RESPONSE_CACHE_OFF || key.empty() )
+    {
+        return IFusionOperator::build(type)->computeFusion(response, weight, frames);
+    }
+
+    // the calibration starts from the curve it receives, so a stored curve
+    // is also a warm start
+    if ( load(key, response) && mode == RESPONSE_CACHE_REUSE )
+    {
+        return IFusionOperator::build(ROBERTSON)->computeFusion(response, weight, frames);
+    }
+
+    pfs::Frame* frame = IFusionOperator::build(ROBERTSON_AUTO)->computeFusion(response, weight, frames);
+    store(key, response);
+    return frame;
+}
+
+}   // fusion
+}   // libhdr
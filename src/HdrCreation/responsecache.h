@@ -0,0 +1,103 @@
+/*
+ * This file is a part of Luminance HDR package
+ * ----------------------------------------------------------------------
+ * Copyright (C) 2017 Luminance HDR developers
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+//! \brief Persistent store of calibrated response curves, keyed by the
+//! camera body, the ISO setting and the input encoding they were calibrated on
+
+#ifndef LIBHDR_FUSION_RESPONSECACHE_H
+#define LIBHDR_FUSION_RESPONSECACHE_H
+
+#include <map>
+#include <string>
+#include <boost/thread/mutex.hpp>
+
+#include <HdrCreation/fusionoperator.h>
+
+namespace pfs {
+class Frame;
+namespace exif {
+class ExifData;
+}
+}
+
+namespace libhdr {
+namespace fusion {
+
+//! \brief How HDR creation uses the curves of the cache
+enum ResponseCacheMode
+{
+    RESPONSE_CACHE_OFF = 0,         //!< always calibrate from scratch
+    RESPONSE_CACHE_REUSE = 1,       //!< use the stored curve, calibrate if missing
+    RESPONSE_CACHE_WARM_START = 2   //!< calibrate starting from the stored curve
+};
+
+//! \brief Saves the response curves calibrated by the Robertson operator in
+//! a directory, one file per camera make, model, ISO and input encoding, so
+//! that later merges of brackets shot with the same body and decoded the same
+//! way can skip the calibration (or use the stored curve as the starting
+//! point of the calibration). The encoding tells apart the curve of 8 bit
+//! JPEG brackets from those of RAW or 16 bit TIFF brackets of the same body.
+//! Files are in the same format of ResponseCurve::writeToFile().
+class ResponseCurveCache
+{
+public:
+    //! \param directory where the curves are stored: it must exist
+    explicit ResponseCurveCache(const std::string& directory);
+
+    //! \brief key of the curve of a camera, for brackets stored with
+    //! \c encoding (see pfs::io::FrameReader::encoding()). Empty when the
+    //! model or the encoding are unknown
+    static std::string key(const std::string& make, const std::string& model,
+                           float isoSpeed, const std::string& encoding);
+    //! \brief key of the curve of the camera that produced \c exifData
+    static std::string key(const pfs::exif::ExifData& exifData,
+                           const std::string& encoding);
+
+    //! \brief file the curve of \c key is stored in
+    std::string fileName(const std::string& key) const;
+
+    //! \brief fills \c response with the curve stored for \c key
+    //! \return false if no (valid) curve is stored, \c response is untouched
+    bool load(const std::string& key, ResponseCurve& response);
+
+    //! \brief stores \c response for \c key, replacing the previous one
+    void store(const std::string& key, const ResponseCurve& response);
+
+    //! \brief merges \c frames with \c type. When \c type is ROBERTSON_AUTO,
+    //! the curve stored for \c key replaces or seeds the calibration (as
+    //! \c mode says), and a newly calibrated curve is stored back
+    pfs::Frame* computeFusion(const std::string& key, ResponseCacheMode mode,
+                              FusionOperator type,
+                              ResponseCurve& response, WeightFunction& weight,
+                              const std::vector<FrameEnhanced>& frames);
+
+private:
+    typedef std::map<std::string, ResponseCurve> CurveMap;
+
+    std::string m_directory;
+    CurveMap m_curves;
+    boost::mutex m_mutex;
+};
+
+}   // fusion
+}   // libhdr
+
+#endif // LIBHDR_FUSION_RESPONSECACHE_H
@@ -68,6 +68,7 @@ void RobertsonOperator::applyResponse(
     size_t saturatedPixels = 0;
 
     int numPixels = (int) width*height;
+#pragma omp parallel for reduction(+:saturatedPixels)
     for (int j = 0; j < numPixels; ++j)
     {
         // all exposures for each pixel
@@ -201,6 +202,74 @@ const int MAXIT = 35; //500;
 // maximum accepted error
 const float MAX_DELTA = 1e-3f; //1e-5f;
 
+// samples of each bin of each exposure that the calibration subset includes,
+// when the image has them
+const int MIN_SAMPLES_PER_BIN = 4;
+
+// selects the pixels the response is calibrated on: a regular stride over
+// the image, plus the pixels falling in bins the stride does not cover enough,
+// so that the tails of the response are estimated as well
+void selectCalibrationPixels(const DataList* const channels[3], size_t numPixels,
+                             size_t maxSamples, std::vector<size_t>& pixels)
+{
+    const size_t numExposures = channels[0]->size();
+    const size_t stride = std::max<size_t>(numPixels/maxSamples, 1);
+
+    std::vector<unsigned char> coverage(3*numExposures*ResponseCurve::NUM_BINS, 0);
+
+    pixels.clear();
+    for (size_t j = 0; j < numPixels; ++j)
+    {
+        bool keep = (j % stride == 0);
+        for (size_t c = 0; c < 3 && !keep; ++c)
+        {
+            for (size_t i = 0; i < numExposures; ++i)
+            {
+                const size_t sample = ResponseCurve::getIdx((*channels[c])[i][j]);
+                if ( sample < ResponseCurve::NUM_BINS &&
+                     coverage[(c*numExposures + i)*ResponseCurve::NUM_BINS + sample] < MIN_SAMPLES_PER_BIN )
+                {
+                    keep = true;
+                    break;
+                }
+            }
+        }
+        if ( !keep ) continue;
+
+        pixels.push_back(j);
+        for (size_t c = 0; c < 3; ++c)
+        {
+            for (size_t i = 0; i < numExposures; ++i)
+            {
+                const size_t sample = ResponseCurve::getIdx((*channels[c])[i][j]);
+                if ( sample < ResponseCurve::NUM_BINS )
+                {
+                    unsigned char& count = coverage[(c*numExposures + i)*ResponseCurve::NUM_BINS + sample];
+                    if ( count < 255 ) ++count;
+                }
+            }
+        }
+    }
+}
+
+// copies the selected pixels of each exposure in storage, and points subset
+// to them
+void gatherPixels(const DataList& channel, const std::vector<size_t>& pixels,
+                  std::vector<float>& storage, DataList& subset)
+{
+    const size_t numSamples = pixels.size();
+    storage.resize(channel.size()*numSamples);
+    subset.resize(channel.size());
+    for (size_t i = 0; i < channel.size(); ++i)
+    {
+        subset[i] = &storage[i*numSamples];
+        for (size_t s = 0; s < numSamples; ++s)
+        {
+            subset[i][s] = channel[i][pixels[s]];
+        }
+    }
+}
+
 float normalizeI(ResponseCurve::ResponseContainer& I)
 {
     size_t M = I.size();
@@ -417,21 +486,60 @@ void RobertsonOperatorAuto::computeFusion(
                    std::back_inserter(averageLuminances),
                    boost::bind(&FrameEnhanced::averageLuminance, _1));
 
-    // red
-    computeResponse(response, weight, RESPONSE_CHANNEL_RED, redChannels, outputRed->data(),
-                    tempFrame.getWidth(), tempFrame.getHeight(),
-                    minAllowedValue, maxAllowedValue,
-                    averageLuminances.data());
-    // green
-    computeResponse(response, weight, RESPONSE_CHANNEL_GREEN, greenChannels, outputGreen->data(),
-                    tempFrame.getWidth(), tempFrame.getHeight(),
-                    minAllowedValue, maxAllowedValue,
-                    averageLuminances.data());
-    // blue
-    computeResponse(response, weight, RESPONSE_CHANNEL_BLUE, blueChannels, outputBlue->data(),
-                    tempFrame.getWidth(), tempFrame.getHeight(),
-                    minAllowedValue, maxAllowedValue,
-                    averageLuminances.data());
+    const size_t width = tempFrame.getWidth();
+    const size_t height = tempFrame.getHeight();
+    const DataList* const channels[3] = { &redChannels, &greenChannels, &blueChannels };
+    const ResponseChannel responseChannels[3] = {
+        RESPONSE_CHANNEL_RED, RESPONSE_CHANNEL_GREEN, RESPONSE_CHANNEL_BLUE
+    };
+    Channel* const outputs[3] = { outputRed, outputGreen, outputBlue };
+
+    // the channels are calibrated concurrently: each one only touches its own
+    // response
+    if ( m_maxCalibrationSamples == 0 || width*height <= m_maxCalibrationSamples )
+    {
+#pragma omp parallel for
+        for (int c = 0; c < 3; ++c)
+        {
+            computeResponse(response, weight, responseChannels[c], *channels[c], outputs[c]->data(),
+                            width, height,
+                            minAllowedValue, maxAllowedValue,
+                            averageLuminances.data());
+        }
+    }
+    else
+    {
+        std::vector<size_t> pixels;
+        selectCalibrationPixels(channels, width*height, m_maxCalibrationSamples, pixels);
+        PRINT_DEBUG("calibrating on " << pixels.size() << " pixels of " << width*height);
+
+        std::vector<float> storage[3];
+        DataList subsets[3];
+        std::vector<float> subsetOutputs[3];
+        for (int c = 0; c < 3; ++c)
+        {
+            gatherPixels(*channels[c], pixels, storage[c], subsets[c]);
+            subsetOutputs[c].resize(pixels.size());
+        }
+
+#pragma omp parallel for
+        for (int c = 0; c < 3; ++c)
+        {
+            computeResponse(response, weight, responseChannels[c], subsets[c], subsetOutputs[c].data(),
+                            pixels.size(), 1,
+                            minAllowedValue, maxAllowedValue,
+                            averageLuminances.data());
+        }
+
+        // final merge, at full resolution
+        for (int c = 0; c < 3; ++c)
+        {
+            applyResponse(response, weight, responseChannels[c], *channels[c], outputs[c]->data(),
+                          width, height,
+                          minAllowedValue, maxAllowedValue,
+                          averageLuminances.data());
+        }
+    }
 
     float cmax[3];
     cmax[0] = *max_element(outputRed->begin(), outputRed->end());
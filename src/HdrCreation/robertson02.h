@@ -68,8 +68,16 @@ protected:
 class RobertsonOperatorAuto : public RobertsonOperator
 {
 public:
-    RobertsonOperatorAuto()
+    //! \brief default number of pixels the response is calibrated on
+    static const size_t DEFAULT_CALIBRATION_SAMPLES = 1 << 18;
+
+    //! \param maxCalibrationSamples the iterations of the calibration run on
+    //! a subset of about this many pixels (plus the ones needed to cover
+    //! all the bins of the response), only the final merge runs on the whole
+    //! image. 0 calibrates on all the pixels
+    explicit RobertsonOperatorAuto(size_t maxCalibrationSamples = DEFAULT_CALIBRATION_SAMPLES)
         : RobertsonOperator()
+        , m_maxCalibrationSamples(maxCalibrationSamples)
     {}
 
     FusionOperator getType() const
@@ -91,6 +99,8 @@ private:
             size_t width, size_t height,
             float minAllowedValue, float maxAllowedValue,
             const float* arrayofexptime);
+
+    size_t m_maxCalibrationSamples;
 };
 
 }   // fusion
@@ -28,6 +28,7 @@
 #include <boost/bind.hpp>
 #include <boost/math/constants/constants.hpp>
 #include <cmath>
+#include <limits>
 #include <stdlib.h>
 #ifdef _OPENMP
 #include <omp.h>
@@ -40,7 +41,7 @@
 #include <Libpfs/utils/minmax.h>
 #include "Libpfs/utils/msec_timer.h"
 
-#include <fftw3.h>
+#include <Libpfs/fftplancache.h>
 
 #include "AutoAntighosting.h"
 // --- LEGACY CODE ---
@@ -63,65 +64,67 @@ void solve_pde_dct(Array2Df &F, Array2Df &U)
     msec_timer stop_watch;
     stop_watch.start();
 #endif
-  // activate parallel execution of fft routines
-  fftwf_init_threads();
-#ifdef _OPENMP
-  fftwf_plan_with_nthreads( omp_get_max_threads() );
-#else
-  fftwf_plan_with_nthreads( 2 );
-#endif
-
     const int width = U.getCols();
     const int height = U.getRows();
     assert((int)F.getCols()==width && (int)F.getRows()==height);
 
     Array2Df Ftr(width, height);
 
-    fftwf_plan p = NULL; // Let's see if this blocks compiler warnings
-    #pragma omp parallel for private(p) schedule(static)
-    for ( int j = 0; j < height; j++ ) {
-        #pragma omp critical (make_plan)
-        p = fftwf_plan_r2r_1d(width, F.data()+width*j, Ftr.data()+width*j, FFTW_REDFT00, FFTW_ESTIMATE);
-        fftwf_execute(p);
-    }
+    // DCT of all the rows, as a single batched plan
+    FFTPlanCache::global().r2rRows(height, width, FFTW_REDFT00, F.data(), Ftr.data());
 
+    // tridiagonal solve along the columns: blocks of adjacent columns are
+    // swept together, so that every row is read contiguously
+    const int blockSize = 64;
   #pragma omp parallel
   {
-    vector<float> c(height);
-    #pragma omp for
-    for ( int i = 0; i < width; i++ ) {
-        for (int j = 0; j < height; j++) {
-            c[j] = 1.0f;
+    vector<float> c(blockSize*height);
+    vector<float> b(blockSize);
+    #pragma omp for schedule(static)
+    for ( int i0 = 0; i0 < width; i0 += blockSize ) {
+        const int n = std::min(blockSize, width - i0);
+        float* f0 = Ftr.data() + i0;
+        for (int k = 0; k < n; k++) {
+            b[k] = 2.0f*(cos(boost::math::double_constants::pi*(i0 + k)/width) - 2.0f);
+            c[k] = 1.0f/b[k];
+            f0[k] /= b[k];
         }
-        float b = 2.0f*(cos(boost::math::double_constants::pi*i/width) - 2.0f);
-        c[0] /= b;
-        Ftr(i, 0) /= b;
         for (int j = 1; j < height - 1; j++ ) {
-            float m = (b - c[j-1]);
-            c[j] /= m;
-            Ftr(i, j) = (Ftr(i, j) - Ftr(i, j-1))/m;
+            float* fj = Ftr.data() + width*j + i0;
+            const float* fp = fj - width;
+            float* cj = &c[blockSize*j];
+            const float* cp = cj - blockSize;
+            for (int k = 0; k < n; k++) {
+                float m = (b[k] - cp[k]);
+                cj[k] = 1.0f/m;
+                fj[k] = (fj[k] - fp[k])/m;
+            }
+        }
+        float* fl = Ftr.data() + width*(height - 1) + i0;
+        float* ul = U.data() + width*(height - 1) + i0;
+        const float* cl = &c[blockSize*(height - 2)];
+        for (int k = 0; k < n; k++) {
+            fl[k] = (fl[k] - fl[k - width])/(b[k] - cl[k]);
+            ul[k] = fl[k];
         }
-        Ftr(i, height - 1) = (Ftr(i, height - 1) - Ftr(i, height - 2))/(b - c[height - 2]);
-        U(i, height - 1) = Ftr(i, height - 1);
         for (int j = height - 2; j >= 0; j--) {
-            U(i, j) = Ftr(i, j) - c[j]*U(i, j+1);
+            const float* fj = Ftr.data() + width*j + i0;
+            float* uj = U.data() + width*j + i0;
+            const float* cj = &c[blockSize*j];
+            for (int k = 0; k < n; k++) {
+                uj[k] = fj[k] - cj[k]*uj[k + width];
+            }
         }
     }
   }
 
+    FFTPlanCache::global().r2rRows(height, width, FFTW_REDFT00, U.data(), U.data());
+
     const float invDivisor = 1.0f / (2.0f*(width-1));
-    #pragma omp parallel for schedule(static) lastprivate(p)
-    for ( int j = 0; j < height; j++ ) {
-        #pragma omp critical (make_plan)
-        p = fftwf_plan_r2r_1d(width, U.data()+width*j, U.data()+width*j, FFTW_REDFT00, FFTW_ESTIMATE);
-        fftwf_execute(p);
-
-        for ( int i = 0; i < width; i++ ) {
-            U(i, j) *= invDivisor;
-        }
+    #pragma omp parallel for schedule(static)
+    for ( int i = 0; i < width*height; i++ ) {
+        U(i) *= invDivisor;
     }
-
-    fftwf_destroy_plan(p);
 #ifdef TIMER_PROFILING
     stop_watch.stop_and_update();
     std::cout << "solve_pde_dct = " << stop_watch.get_time() << " msec" << std::endl;
@@ -143,148 +146,142 @@ int findIndex(const float* data, int size)
     return idx;
 }
 
-typedef vector<float> BufferF;
-
-inline
-float hueMean(const BufferF& data)
-{
-    return std::accumulate(data.begin(), data.end(), 0.0f)/data.size();
-}
-
 void hueSquaredMean(const HdrCreationItemContainer& data,
                     vector<float>& HE)
 {
-    size_t width = data[0].frame()->getWidth();
-    size_t height = data[0].frame()->getHeight();
-    size_t numItems = data.size();
-
-    float r, g, b, h, s, l;
+    const int width = data[0].frame()->getWidth();
+    const int height = data[0].frame()->getHeight();
+    const int numItems = data.size();
 
-    BufferF hues(numItems, 0.f);
-    BufferF HS(numItems, 0.f);
+    vector<const Channel*> X(numItems), Y(numItems), Z(numItems);
+    for (int w = 0; w < numItems; w++) {
+        data[w].frame()->getXYZChannels( X[w], Y[w], Z[w] );
+    }
 
-    const Channel *X, *Y, *Z;
+    vector<double> HS(numItems, 0.0);
 
-    for (size_t j = 0; j < height; j++) {
-        for (size_t i = 0; i < width; i++) {
-            for (size_t w = 0; w < numItems; w++) {
-                data[w].frame()->getXYZChannels( X, Y, Z );
+  #pragma omp parallel
+  {
+    vector<float> hues(numItems);
+    vector<double> partialHS(numItems, 0.0);
+    float s, l;
 
-                r = (*X)(i, j);
-                g = (*Y)(i, j);
-                b = (*Z)(i, j);
-                rgb2hsl(r, g, b, h, s, l);
-                hues[w] = h;
+    #pragma omp for schedule(static)
+    for (int j = 0; j < height; j++) {
+        for (int i = 0; i < width; i++) {
+            float hueSum = 0.0f;
+            for (int w = 0; w < numItems; w++) {
+                rgb2hsl((*X[w])(i, j), (*Y[w])(i, j), (*Z[w])(i, j), hues[w], s, l);
+                hueSum += hues[w];
             }
 
-            float hueMean_ = hueMean(hues);
-
-            for (size_t w = 0; w < numItems; w++) {
-                float H = hueMean_ - hues[w];
-                HS[w] += H*H;
+            const float hueMean = hueSum/numItems;
+            for (int w = 0; w < numItems; w++) {
+                float H = hueMean - hues[w];
+                partialHS[w] += H*H;
             }
         }
     }
 
-    for (size_t w = 0; w < numItems; w++) {
-        HE[w] = HS[w] / (width*height);
+    #pragma omp critical (hue_squared_mean)
+    for (int w = 0; w < numItems; w++) {
+        HS[w] += partialHS[w];
+    }
+  }
+
+    for (int w = 0; w < numItems; w++) {
+        HE[w] = HS[w] / (static_cast<double>(width)*height);
 
         qDebug() << "HE[" << w << "]: " << HE[w];
     }
 }
 
-void sdv(const HdrCreationItem& item1,
-          const HdrCreationItem& item2,
-          const float deltaEV,
-          const int dx, const int dy,
-          float &sR, float &sG, float &sB)
+AgLogImage::AgLogImage(const HdrCreationItem& item)
+    : R(item.frame()->getWidth(), item.frame()->getHeight())
+    , G(item.frame()->getWidth(), item.frame()->getHeight())
+    , B(item.frame()->getWidth(), item.frame()->getHeight())
+{
+    compute(item);
+}
+
+void AgLogImage::compute(const HdrCreationItem& item)
 {
-    Channel *X1, *Y1, *Z1, *X2, *Y2, *Z2;
-    item1.frame()->getXYZChannels( X1, Y1, Z1 );
-    item2.frame()->getXYZChannels( X2, Y2, Z2 );
-    Array2Df& R1 = *X1;
-    Array2Df& G1 = *Y1;
-    Array2Df& B1 = *Z1;
-    Array2Df& R2 = *X2;
-    Array2Df& G2 = *Y2;
-    Array2Df& B2 = *Z2;
-
-    const int W = item1.frame()->getWidth();
-    const int H = item1.frame()->getHeight();
-
-    vector<float> logRed(W*H);
-    vector<float> logGreen(W*H);
-    vector<float> logBlue(W*H);
+    const Channel *X, *Y, *Z;
+    item.frame()->getXYZChannels( X, Y, Z );
+
+    const int size = X->size();
+    R.resize(X->getCols(), X->getRows());
+    G.resize(X->getCols(), X->getRows());
+    B.resize(X->getCols(), X->getRows());
+
+    #pragma omp parallel for schedule(static)
+    for (int i = 0; i < size; i++) {
+        R(i) = log((*X)(i));
+        G(i) = log((*Y)(i));
+        B(i) = log((*Z)(i));
+    }
+}
+
+namespace
+{
+// the logarithm of a sample in ]0, 1[ is finite and negative: saturated and
+// black samples are left out of the statistics
+inline
+bool isWellExposed(float logR, float logG, float logB)
+{
+    const float minusInf = -std::numeric_limits<float>::infinity();
+    return (logR < 0.0f && logR > minusInf &&
+            logG < 0.0f && logG > minusInf &&
+            logB < 0.0f && logB > minusInf);
+}
+
+// log(item1) - log(item2) is compared against the exposure difference
+inline
+float logDeltaEVOffset(float deltaEV)
+{
+    const float logDeltaEV = log(std::abs(deltaEV));
+    return (deltaEV > 0) ? -logDeltaEV : logDeltaEV;
+}
+}
+
+void sdv(const AgLogImage& log1, const AgLogImage& log2,
+         const float deltaEV,
+         const int dx, const int dy,
+         float &sR, float &sG, float &sB)
+{
+    const int W = log1.R.getCols();
+    const int H = log1.R.getRows();
 
     qDebug() << "deltaEV " << deltaEV;
 
-    float logDeltaEV = log(std::abs(deltaEV));
+    const float offset = logDeltaEVOffset(deltaEV);
+
+    const int y0 = std::max(0, -dy);
+    const int y1 = std::min(H, H - dy);
+    const int x0 = std::max(0, -dx);
+    const int x1 = std::min(W, W - dx);
+
+    // first pass: mean of the absolute differences. Samples that are not well
+    // exposed are counted with a difference of zero
+    long count = 0;
+    long wellExposed = 0;
+    double mR = 0.0;
+    double mG = 0.0;
+    double mB = 0.0;
+    #pragma omp parallel for schedule(static) reduction(+:count, wellExposed, mR, mG, mB)
+    for (int y = y0; y < y1; y++) {
+        for (int x = x0; x < x1; x++) {
+            count++;
 
-    int count = 0;
-    float mR = 0.0f;
-    float mG = 0.0f;
-    float mB = 0.0f;
-    for (int y = 0; y < H; y++) {
-        if (y+dy < 0 || y+dy > H-1)
-            continue;
-        for (int x = 0; x < W; x++) {
-            if (x+dx < 0 || x+dx > W-1)
+            const float r1 = log1.R(x, y), g1 = log1.G(x, y), b1 = log1.B(x, y);
+            const float r2 = log2.R(x+dx, y+dy), g2 = log2.G(x+dx, y+dy), b2 = log2.B(x+dx, y+dy);
+            if (!isWellExposed(r1, g1, b1) || !isWellExposed(r2, g2, b2))
                 continue;
-            if (R1(x, y) >= 1.0f || R2(x+dx, y+dy) >= 1.0f) {
-                    logRed[count] = 0.0f;
-                    logGreen[count] = 0.0f;
-                    logBlue[count++] = 0.0f;
-                    continue;
-            }
-            if (G1(x, y) >= 1.0f || G2(x+dx, y+dy) >= 1.0f) {
-                    logRed[count] = 0.0f;
-                    logGreen[count] = 0.0f;
-                    logBlue[count++] = 0.0f;
-                    continue;
-            }
-            if (B1(x, y) >= 1.0f || B2(x+dx, y+dy) >= 1.0f) {
-                    logRed[count] = 0.0f;
-                    logGreen[count] = 0.0f;
-                    logBlue[count++] = 0.0f;
-                    continue;
-            }
-            if (R1(x, y) <= 0.0f || R2(x+dx, y+dy) <= 0.0f) {
-                    logRed[count] = 0.0f;
-                    logGreen[count] = 0.0f;
-                    logBlue[count++] = 0.0f;
-                    continue;
-            }
-            if (G1(x, y) <= 0.0f || G2(x+dx, y+dy) <= 0.0f) {
-                    logRed[count] = 0.0f;
-                    logGreen[count] = 0.0f;
-                    logBlue[count++] = 0.0f;
-                    continue;
-            }
-            if (B1(x, y) <= 0.0f || B2(x+dx, y+dy) <= 0.0f) {
-                    logRed[count] = 0.0f;
-                    logGreen[count] = 0.0f;
-                    logBlue[count++] = 0.0f;
-                    continue;
-            }
 
-            if (deltaEV > 0) {
-                logRed[count] = log(R1(x, y)) - log(R2(x+dx, y+dy)) - logDeltaEV;
-                logGreen[count] = log(G1(x, y)) - log(G2(x+dx, y+dy)) - logDeltaEV;
-                logBlue[count] = log(B1(x, y)) - log(B2(x+dx, y+dy)) - logDeltaEV;
-                mR += std::abs(logRed[count]);
-                mG += std::abs(logGreen[count]);
-                mB += std::abs(logBlue[count]);
-                count++;
-            }
-            else {
-                logRed[count] = log(R1(x, y)) - log(R2(x+dx, y+dy)) + logDeltaEV;
-                logGreen[count] = log(G1(x, y)) - log(G2(x+dx, y+dy)) + logDeltaEV;
-                logBlue[count] = log(B1(x, y)) - log(B2(x+dx, y+dy)) + logDeltaEV;
-                mR += std::abs(logRed[count]);
-                mG += std::abs(logGreen[count]);
-                mB += std::abs(logBlue[count]);
-                count++;
-            }
+            wellExposed++;
+            mR += std::abs(r1 - r2 + offset);
+            mG += std::abs(g1 - g2 + offset);
+            mB += std::abs(b1 - b2 + offset);
         }
     }
     mR /= count;
@@ -295,52 +292,49 @@ void sdv(const HdrCreationItem& item1,
     qDebug() << "mG" << mG;
     qDebug() << "mB" << mB;
 
-    sR = 0.0f;
-    sG = 0.0f;
-    sB = 0.0f;
-    for (int i = 0; i < count; i++) {
-        sR += std::pow(std::abs(logRed[i]) - mR, 2.0f);
-        sG += std::pow(std::abs(logGreen[i]) - mG, 2.0f);
-        sB += std::pow(std::abs(logBlue[i]) - mB, 2.0f);
+    // second pass: standard deviation of the absolute differences
+    double vR = 0.0;
+    double vG = 0.0;
+    double vB = 0.0;
+    #pragma omp parallel for schedule(static) reduction(+:vR, vG, vB)
+    for (int y = y0; y < y1; y++) {
+        for (int x = x0; x < x1; x++) {
+            const float r1 = log1.R(x, y), g1 = log1.G(x, y), b1 = log1.B(x, y);
+            const float r2 = log2.R(x+dx, y+dy), g2 = log2.G(x+dx, y+dy), b2 = log2.B(x+dx, y+dy);
+            if (!isWellExposed(r1, g1, b1) || !isWellExposed(r2, g2, b2))
+                continue;
+
+            const double dR = std::abs(r1 - r2 + offset) - mR;
+            const double dG = std::abs(g1 - g2 + offset) - mG;
+            const double dB = std::abs(b1 - b2 + offset) - mB;
+            vR += dR*dR;
+            vG += dG*dG;
+            vB += dB*dB;
+        }
     }
-    sR /= count;
-    sG /= count;
-    sB /= count;
+    const long notWellExposed = count - wellExposed;
+    vR = (vR + notWellExposed*mR*mR) / count;
+    vG = (vG + notWellExposed*mG*mG) / count;
+    vB = (vB + notWellExposed*mB*mB) / count;
 
-    sR = mR + std::sqrt(sR);
-    sG = mG + std::sqrt(sG);
-    sB = mB + std::sqrt(sB);
+    sR = mR + std::sqrt(vR);
+    sG = mG + std::sqrt(vG);
+    sB = mB + std::sqrt(vB);
 
     qDebug() << "sR" << sR;
     qDebug() << "sG" << sG;
     qDebug() << "sB" << sB;
 }
 
-bool comparePatches(const HdrCreationItem& item1,
-                     const HdrCreationItem& item2,
-                     const int i, const int j,
-                     const int gridX, const int gridY,
-                     const float threshold,
-                     const float sR, const float sG, const float sB,
-                     const float deltaEV,
-                     const int dx, const int dy)
+bool comparePatches(const AgLogImage& log1, const AgLogImage& log2,
+                    const int i, const int j,
+                    const int gridX, const int gridY,
+                    const float threshold,
+                    const float sR, const float sG, const float sB,
+                    const float deltaEV,
+                    const int dx, const int dy)
 {
-    const int gridSize = gridX * gridY;
-    vector<float> logRed(gridSize);
-    vector<float> logGreen(gridSize);
-    vector<float> logBlue(gridSize);
-
-    Channel *X1, *Y1, *Z1, *X2, *Y2, *Z2;
-    item1.frame()->getXYZChannels( X1, Y1, Z1 );
-    item2.frame()->getXYZChannels( X2, Y2, Z2 );
-    Array2Df& R1 = *X1;
-    Array2Df& G1 = *Y1;
-    Array2Df& B1 = *Z1;
-    Array2Df& R2 = *X2;
-    Array2Df& G2 = *Y2;
-    Array2Df& B2 = *Z2;
-
-    float logDeltaEV = log(std::abs(deltaEV));
+    const float offset = logDeltaEVOffset(deltaEV);
 
     const int width = gridX*agGridSize;
     const int height = gridY*agGridSize;
@@ -351,25 +345,13 @@ bool comparePatches(const HdrCreationItem& item1,
         for (int x = i * gridX; x < (i+1) * gridX; x++) {
             if (x+dx < 0 || x+dx > width-1)
                 continue;
-            if (deltaEV > 0) {
-                logRed[count] = log(R1(x, y)) - log(R2(x+dx, y+dy)) - logDeltaEV;
-                logGreen[count] = log(G1(x, y)) - log(G2(x+dx, y+dy)) - logDeltaEV;
-                logBlue[count++] = log(B1(x, y)) - log(B2(x+dx, y+dy)) - logDeltaEV;
-            }
-            else {
-                logRed[count] = log(R1(x, y)) - log(R2(x+dx, y+dy)) + logDeltaEV;
-                logGreen[count] = log(G1(x, y)) - log(G2(x+dx, y+dy)) + logDeltaEV;
-                logBlue[count++] = log(B1(x, y)) - log(B2(x+dx, y+dy)) + logDeltaEV;
-            }
+            if (std::abs(log1.R(x, y) - log2.R(x+dx, y+dy) + offset) > 2.0f*sR ||
+                std::abs(log1.G(x, y) - log2.G(x+dx, y+dy) + offset) > 2.0f*sG ||
+                std::abs(log1.B(x, y) - log2.B(x+dx, y+dy) + offset) > 2.0f*sB)
+                count++;
         }
     }
 
-    count = 0;
-    for (int h = 0; h < gridSize; h++) {
-        if (std::abs(logRed[h]) > 2.0f*sR || std::abs(logGreen[h]) > 2.0f*sG || std::abs(logBlue[h]) > 2.0f*sB)
-            count++;
-    }
-
     return (static_cast<float>(count) / static_cast<float>(gridX*gridY)) > threshold;
 }
 
@@ -37,20 +37,31 @@ void clampToZero(Array2Df &R, Array2Df &G, Array2Df &B, float m);
 int findIndex(const float* data, int size);
 void hueSquaredMean(const HdrCreationItemContainer& data,
                     vector<float>& HE);
-void sdv(const HdrCreationItem& item1,
-         const HdrCreationItem& item2,
+//! \brief natural logarithm of the channels of an exposure: computed once
+//! per exposure and shared by all the comparisons of the auto anti-ghosting
+struct AgLogImage
+{
+    explicit AgLogImage(const HdrCreationItem& item);
+    //! \brief recomputes the logarithms for \c item, reusing the storage
+    void compute(const HdrCreationItem& item);
+
+    Array2Df R;
+    Array2Df G;
+    Array2Df B;
+};
+
+void sdv(const AgLogImage& log1, const AgLogImage& log2,
          const float deltaEV,
          const int dx, const int dy,
          float &sR, float &sG, float &sB);
 
-bool comparePatches(const HdrCreationItem& item1,
-                     const HdrCreationItem& item2,
-                     const int i, const int j,
-                     const int gridX, const int gridY,
-                     const float threshold,
-                     const float sR, const float sG, const float sB,
-                     const float deltaEV,
-                     const int dx, const int dy);
+bool comparePatches(const AgLogImage& log1, const AgLogImage& log2,
+                    const int i, const int j,
+                    const int gridX, const int gridY,
+                    const float threshold,
+                    const float sR, const float sG, const float sB,
+                    const float deltaEV,
+                    const int dx, const int dy);
 
 void computeIrradiance(Array2Df& irradiance, const Array2Df& in);
 void computeLogIrradiance(Array2Df &logIrradiance, const Array2Df& u);
@@ -36,6 +36,8 @@ HdrCreationItem::HdrCreationItem(const QString &filename)
     , m_exposureTime(-1.f)
     , m_datamin(0.f)
     , m_datamax(1.f)
+    , m_width(0)
+    , m_height(0)
     , m_frame(std::make_shared<pfs::Frame>())
     , m_thumbnail(new QImage())
 {
@@ -50,6 +52,8 @@ HdrCreationItem::HdrCreationItem(const QString &filename, const QString& convert
     , m_exposureTime(-1.f)
     , m_datamin(0.f)
     , m_datamax(1.f)
+    , m_width(0)
+    , m_height(0)
     , m_frame(std::make_shared<pfs::Frame>())
     , m_thumbnail(new QImage())
 {
@@ -30,6 +30,7 @@
 #include <Libpfs/frame.h>
 
 #include <cmath>
+#include <string>
 #include "arch/math.h"
 
 // defines an element that contains all the informations for this particular
@@ -49,7 +50,18 @@ public:
 
     const pfs::FramePtr& frame() const  { return m_frame; }
     pfs::FramePtr& frame()              { return m_frame; }
-    bool isValid() const                { return m_frame->isValid(); }
+    bool isValid() const                { return m_frame->isValid() || !m_thumbnail->isNull(); }
+
+    //! \brief false while only the preview in qimage() has been decoded
+    bool isFullResolution() const       { return m_frame->isValid(); }
+    //! \brief size of the full resolution image, known before decoding it
+    size_t width() const                { return isFullResolution() ? m_frame->getWidth() : m_width; }
+    size_t height() const               { return isFullResolution() ? m_frame->getHeight() : m_height; }
+    void setSize(size_t w, size_t h)    { m_width = w; m_height = h; }
+
+    //! \brief encoding of the decoded file, as reported by its reader
+    const std::string& encoding() const { return m_encoding; }
+    void setEncoding(const std::string& e) { m_encoding = e; }
 
     bool hasAverageLuminance() const    { return (m_averageLuminance != -1.f); }
     void setAverageLuminance(float avl) { m_averageLuminance = avl; }
@@ -79,6 +91,9 @@ private:
     float                   m_exposureTime;
     float                   m_datamin;
     float                   m_datamax;
+    size_t                  m_width;
+    size_t                  m_height;
+    std::string             m_encoding;
     pfs::FramePtr           m_frame;
     QSharedPointer<QImage>  m_thumbnail;
 };
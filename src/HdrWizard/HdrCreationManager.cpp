@@ -61,11 +61,13 @@
 #include <Libpfs/colorspace/convert.h>
 #include <Libpfs/colorspace/colorspace.h>
 #include <Libpfs/colorspace/normalizer.h>
+#include <Libpfs/exif/exifdata.hpp>
 
 #include "arch/math.h"
 #include "TonemappingOperators/fattal02/pde.h"
 #include "Exif/ExifOperations.h"
 #include "HdrCreation/mtb_alignment.h"
+#include "HdrCreation/feature_alignment.h"
 #include "WhiteBalance.h"
 
 using namespace std;
@@ -88,6 +90,9 @@ const FusionOperatorConfig predef_confs[6] =
 // --- NEW CODE ---
 namespace
 {
+//! \brief longest side of the previews decoded by loadFiles()
+const int PREVIEW_SIZE = 1024;
+
 
 QImage* shiftQImage(const QImage *in, int dx, int dy)
 {
@@ -150,7 +155,17 @@ void HdrCreationManager::loadFiles(const QStringList &filenames)
     connect(&m_futureWatcher, SIGNAL(finished()), this, SLOT(loadFilesDone()), Qt::DirectConnection);
 
     // Start the computation.
-    m_futureWatcher.setFuture( QtConcurrent::map(m_tmpdata.begin(), m_tmpdata.end(), LoadFile()) );
+    // only previews are decoded here (see loadFullResolution()), unless no
+    // preview is ever shown
+    m_futureWatcher.setFuture( QtConcurrent::map(m_tmpdata.begin(), m_tmpdata.end(),
+                                                 LoadFile(false, fromCommandLine ? 0 : PREVIEW_SIZE)) );
+}
+
+void HdrCreationManager::loadFullResolution()
+{
+    QFutureWatcher<void> futureWatcher;
+    futureWatcher.setFuture( QtConcurrent::map(m_data.begin(), m_data.end(), LoadFullResolution()) );
+    futureWatcher.waitForFinished();
 }
 
 void HdrCreationManager::loadFilesDone()
@@ -286,6 +301,8 @@ HdrCreationManager::HdrCreationManager(bool fromCommandLine)
     , m_ais_crop_flag(false)
     , fromCommandLine(fromCommandLine)
     , m_isLoadResponseCurve(false)
+    , m_responseCacheMode(m_luminance_options.getResponseCacheMode())
+    , m_responseCache(QFile::encodeName(m_luminance_options.getResponseCacheDir()).constData())
 {
     // setConfig(predef_confs[0]);
     setFusionOperator(predef_confs[0].fusionOperator);
@@ -332,11 +349,11 @@ QVector<float> HdrCreationManager::getExpotimes() const
 
 bool HdrCreationManager::framesHaveSameSize()
 {
-    size_t width = m_data[0].frame()->getWidth();
-    size_t height = m_data[0].frame()->getHeight();
+    size_t width = m_data[0].width();
+    size_t height = m_data[0].height();
     for ( HdrCreationItemContainer::const_iterator it = m_data.begin() + 1,
           itEnd = m_data.end(); it != itEnd; ++it) {
-        if (it->frame()->getWidth() != width || it->frame()->getHeight() != height)
+        if (it->width() != width || it->height() != height)
             return false;
     }
     return true;
@@ -344,6 +361,8 @@ bool HdrCreationManager::framesHaveSameSize()
 
 void HdrCreationManager::align_with_mtb()
 {
+    loadFullResolution();
+
     // build temporary container...
     vector<FramePtr> frames;
     for (size_t i = 0; i < m_data.size(); ++i) {
@@ -362,6 +381,30 @@ void HdrCreationManager::align_with_mtb()
     emit finishedAligning(0);
 }
 
+void HdrCreationManager::align_with_features()
+{
+    loadFullResolution();
+
+    // build temporary container...
+    vector<FramePtr> frames;
+    for (size_t i = 0; i < m_data.size(); ++i) {
+        frames.push_back( m_data[i].frame() );
+    }
+
+    // estimate the transforms and warp the frames in memory
+    if ( !libhdr::feature_alignment(frames) ) {
+        qDebug() << "HdrCreationManager::align_with_features(): some frames could not be matched";
+    }
+
+    // rebuild previews
+    QFutureWatcher<void> futureWatcher;
+    futureWatcher.setFuture( QtConcurrent::map(m_data.begin(), m_data.end(), RefreshPreview()) );
+    futureWatcher.waitForFinished();
+
+    // emit finished
+    emit finishedAligning(0);
+}
+
 void HdrCreationManager::set_ais_crop_flag(bool flag)
 {
     m_ais_crop_flag = flag;
@@ -369,6 +412,8 @@ void HdrCreationManager::set_ais_crop_flag(bool flag)
 
 void HdrCreationManager::align_with_ais()
 {
+    loadFullResolution();
+
     m_align.reset(new Align(m_data, fromCommandLine, 1));
     connect(m_align.get(), SIGNAL(finishedAligning(int)), this, SIGNAL(finishedAligning(int)));
     connect(m_align.get(), SIGNAL(failedAligning(QProcess::ProcessError)), this, SIGNAL(ais_failed(QProcess::ProcessError)));
@@ -387,6 +432,8 @@ void HdrCreationManager::ais_failed_slot(QProcess::ProcessError error)
 
 pfs::Frame* HdrCreationManager::createHdr()
 {
+    loadFullResolution();
+
     std::vector<FrameEnhanced> frames;
 
     for (size_t idx = 0; idx < m_data.size(); ++idx)
@@ -399,8 +446,21 @@ pfs::Frame* HdrCreationManager::createHdr()
                     );
     }
 
-    libhdr::fusion::FusionOperatorPtr fusionOperatorPtr = IFusionOperator::build(m_fusionOperator);
-    pfs::Frame* outputFrame(fusionOperatorPtr->computeFusion(*m_response, *m_weight, frames));
+    // a curve calibrated earlier on the same camera body replaces (or seeds)
+    // the calibration, unless the user loaded a curve from file
+    std::string cacheKey;
+    if ( m_fusionOperator == ROBERTSON_AUTO &&
+         m_responseCacheMode != RESPONSE_CACHE_OFF &&
+         m_responseCurveInputFilename.isEmpty() && !m_data.empty() )
+    {
+        cacheKey = ResponseCurveCache::key(
+                    pfs::exif::ExifData(QFile::encodeName(m_data[0].filename()).constData()),
+                    m_data[0].encoding());
+    }
+
+    pfs::Frame* outputFrame(m_responseCache.computeFusion(
+                                cacheKey, static_cast<ResponseCacheMode>(m_responseCacheMode),
+                                m_fusionOperator, *m_response, *m_weight, frames));
 
     if (!m_responseCurveOutputFilename.isEmpty())
     {
@@ -412,6 +472,8 @@ pfs::Frame* HdrCreationManager::createHdr()
 
 void HdrCreationManager::applyShiftsToItems(const QList<QPair<int,int> >& hvOffsets)
 {
+    loadFullResolution();
+
     int size = m_data.size();
     //shift the frames and images
     for (int i = 0; i < size; i++)
@@ -429,6 +491,8 @@ void HdrCreationManager::applyShiftsToItems(const QList<QPair<int,int> >& hvOffs
 
 void HdrCreationManager::cropItems(const QRect& ca)
 {
+    loadFullResolution();
+
     // crop all frames and images
     int size = m_data.size();
     for (int idx = 0; idx < size; idx++)
@@ -462,6 +526,8 @@ HdrCreationManager::~HdrCreationManager()
 
 void HdrCreationManager::saveImages(const QString& prefix)
 {
+    loadFullResolution();
+
     int idx = 0;
     for ( HdrCreationItemContainer::const_iterator it = m_data.begin(),
           itEnd = m_data.end(); it != itEnd; ++it) {
@@ -487,6 +553,8 @@ int HdrCreationManager::computePatches(float threshold, bool patches[][agGridSiz
     msec_timer stop_watch;
     stop_watch.start();
 #endif
+    loadFullResolution();
+
     const int width = m_data[0].frame()->getWidth();
     const int height = m_data[0].frame()->getHeight();
     const int gridX = width / agGridSize;
@@ -507,22 +575,29 @@ int HdrCreationManager::computePatches(float threshold, bool patches[][agGridSiz
         }
     }
 
+    const AgLogImage goodLog(m_data[m_agGoodImageIndex]);
+    std::unique_ptr<AgLogImage> otherLog;
     for (int h = 0; h < size; h++) {
         if (h == m_agGoodImageIndex)
             continue;
+        if (otherLog)
+            otherLog->compute(m_data[h]);
+        else
+            otherLog.reset(new AgLogImage(m_data[h]));
+
         float deltaEV = log2(m_data[m_agGoodImageIndex].getAverageLuminance()) - log2(m_data[h].getAverageLuminance());
         int dx = HV_offset[m_agGoodImageIndex].first - HV_offset[h].first;
         int dy = HV_offset[m_agGoodImageIndex].second - HV_offset[h].second;
         float sR, sG, sB;
-        sdv(m_data[m_agGoodImageIndex], m_data[h], deltaEV, dx, dy, sR, sG, sB);
-        //#pragma omp parallel for schedule(static)
-        for (int j = 0; j < agGridSize; j++) {
-            for (int i = 0; i < agGridSize; i++) {
-                if (comparePatches(m_data[m_agGoodImageIndex],
-                                   m_data[h],
-                                   i, j, gridX, gridY, threshold, sR, sG, sB, deltaEV, dx, dy)) {
-                    m_patches[i][j] = true;
-                }
+        sdv(goodLog, *otherLog, deltaEV, dx, dy, sR, sG, sB);
+        // every patch writes its own cell of m_patches
+        #pragma omp parallel for schedule(dynamic)
+        for (int p = 0; p < agGridSize*agGridSize; p++) {
+            const int i = p % agGridSize;
+            const int j = p / agGridSize;
+            if (comparePatches(goodLog, *otherLog,
+                               i, j, gridX, gridY, threshold, sR, sG, sB, deltaEV, dx, dy)) {
+                m_patches[i][j] = true;
             }
         }
     }
@@ -552,6 +627,8 @@ pfs::Frame *HdrCreationManager::doAntiGhosting(bool patches[][agGridSize], int h
     msec_timer stop_watch;
     stop_watch.start();
 #endif
+    loadFullResolution();
+
     const int width = m_data[0].frame()->getWidth();
     const int height = m_data[0].frame()->getHeight();
     const int gridX = width / agGridSize;
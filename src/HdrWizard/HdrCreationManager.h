@@ -39,6 +39,7 @@
 #include <Libpfs/frame.h>
 #include <HdrCreation/fusionoperator.h>
 #include <HdrCreation/createhdr.h>
+#include <HdrCreation/responsecache.h>
 
 #include "Alignment/Align.h"
 #include "Common/LuminanceOptions.h"
@@ -66,7 +67,13 @@ public:
     HdrCreationItem& getFile(size_t idx)                { return m_data[idx]; }
     const HdrCreationItem& getFile(size_t idx) const    { return m_data[idx]; }
 
+    //! \brief loads the files in the background. Only previews are decoded:
+    //! the full resolution data is decoded by loadFullResolution()
     void loadFiles(const QStringList& filenames);
+    //! \brief decodes the full resolution data of the items still holding
+    //! only a preview. Every function of the manager working on the frames
+    //! calls it, views working on qimage() at full resolution must call it
+    void loadFullResolution();
     void removeFile(int idx);
     void clearFiles()                   { m_data.clear(); m_tmpdata.clear(); }
     size_t availableInputFiles() const  { return m_data.size(); }
@@ -97,6 +104,11 @@ public:
     void setFusionOperator(libhdr::fusion::FusionOperator fo)       { m_fusionOperator = fo; }
     libhdr::fusion::FusionOperator getFusionOperator()              { return m_fusionOperator; }
 
+    //! \brief how the automatic Robertson operator uses the curves calibrated
+    //! on earlier brackets of the same camera (see ResponseCacheMode)
+    void setResponseCacheMode(int mode)                             { m_responseCacheMode = mode; }
+    int getResponseCacheMode() const                                { return m_responseCacheMode; }
+
     void setResponseCurveOutputFile(const QString& filename)        { m_responseCurveOutputFilename = filename; }
     const QString& responseCurveOutputFile() const                  { return m_responseCurveOutputFilename; }
 
@@ -107,6 +119,7 @@ public:
     void set_ais_crop_flag(bool flag);
     void align_with_ais();
     void align_with_mtb();
+    void align_with_features();
 
     const HdrCreationItemContainer& getData() const         { return m_data; }
     //const QList<QImage*>& getAntiGhostingMasksList() const  { return m_antiGhostingMasksList; }
@@ -177,6 +190,8 @@ private:
     int m_agGoodImageIndex;
     bool m_patches[agGridSize][agGridSize];
     bool m_isLoadResponseCurve;
+    int m_responseCacheMode;
+    libhdr::fusion::ResponseCurveCache m_responseCache;
 
 private slots:
     void ais_failed_slot(QProcess::ProcessError);
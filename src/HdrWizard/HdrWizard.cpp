@@ -746,6 +746,10 @@ void HdrWizard::NextFinishButtonClicked()
                 m_hdrCreationManager->set_ais_crop_flag(m_Ui->autoCropCheckBox->isChecked());
                 m_hdrCreationManager->align_with_ais();
             }
+            else if (m_Ui->features_radioButton->isChecked())
+            {
+                m_hdrCreationManager->align_with_features();
+            }
             else
             {
                 m_hdrCreationManager->align_with_mtb();
@@ -850,6 +854,10 @@ void HdrWizard::currentPageChangedInto(int newindex)
         //if (m_hdrCreationManager->inputImageType() == HdrCreationManager::LDR_INPUT_TYPE && numldrs >= 2) {
         if (m_Ui->checkBoxEditingTools->isChecked() && num_images >= 2) {
             this->setDisabled(true);
+            // the editing tools work on the images at full resolution
+            QApplication::setOverrideCursor(QCursor(Qt::BusyCursor));
+            m_hdrCreationManager->loadFullResolution();
+            QApplication::restoreOverrideCursor();
             EditingTools *editingtools = new EditingTools(m_hdrCreationManager.data(), m_Ui->autoAG_checkBox->isChecked());
             if (editingtools->exec() == QDialog::Accepted) {
                 m_doAutoAntighosting = editingtools->isAutoAntighostingEnabled();
@@ -13,6 +13,7 @@
 #include <Libpfs/utils/transform.h>
 #include <Libpfs/utils/chain.h>
 #include <Libpfs/utils/clamp.h>
+#include <Libpfs/utils/histogram.h>
 #include <Libpfs/colorspace/colorspace.h>
 #include <Libpfs/colorspace/normalizer.h>
 #include "Libpfs/utils/msec_timer.h"
@@ -21,55 +22,19 @@ using namespace pfs;
 using namespace pfs::colorspace;
 using namespace pfs::utils;
 
-void computeHistogram(const pfs::Array2Df& data, std::vector<size_t>& histogram,
-                      float min, float max)
-{
-    Normalizer norm(min, max);
-    for (pfs::Array2Df::const_iterator it = data.begin(), itEnd = data.end(); it != itEnd; ++it)
-    {
-        // 1.0f -> histogram.size() - 1
-
-        size_t bin = static_cast<size_t>(norm(*it)*(histogram.size()-1)+0.5f);
-        ++histogram[bin];
-    }
-}
-
 std::pair<float, float> quantiles(const pfs::Array2Df& data,
                                   float nb_min, float nb_max,
                                   float min, float max)
 {
     // compute histogram (less expensive than sorting the entire sequence...
-    std::vector<size_t> hist(65535, 0);
-    computeHistogram(data, hist, min, max);
-
-    // normalize percentiles to image size...
-    size_t lb_percentile = static_cast<size_t>(nb_min*data.size() + 0.5f);
-    size_t ub_percentile = static_cast<size_t>(nb_max*data.size() + 0.5f);
-
-    size_t counter = 0;
-    std::pair<float, float> minmax;
-    for (size_t idx = 0; idx < hist.size(); ++idx)
-    {
-        counter += hist[idx];
-        if (counter >= lb_percentile) {
-            minmax.first = static_cast<float>(idx)/(hist.size()-1)*(max - min) + min;
-            break;
-        }
-    }
+    Histogram hist(65535, min, max);
+    computeHistogram(data, hist);
 
-    counter = 0;
-    for (size_t idx = 0; idx < hist.size(); ++idx)
-    {
-        counter += hist[idx];
-        if (counter >= ub_percentile) {
-            minmax.second = static_cast<float>(idx)/(hist.size()-1)*(max - min) + min;
-            break;
-        }
-    }
+    std::pair<float, float> minmax(hist.quantile(nb_min), hist.quantile(nb_max));
 
 #ifndef NDEBUG
-    std::cout << "([" << nb_min << ", " << min << ", " << lb_percentile << "]"
-                 ", [" << nb_max << ", " << max << ", " << ub_percentile << "])" << std::endl;
+    std::cout << "([" << nb_min << ", " << min << ", " << minmax.first << "]"
+                 ", [" << nb_max << ", " << max << ", " << minmax.second << "])" << std::endl;
 #endif
 
     return minmax;
@@ -317,6 +282,7 @@ void whiteBalance(Frame& frame, WhiteBalanceType type)
     frame.getXYZChannels(r, g, b);
 
     whiteBalance(*r, *g, *b, type);
+    frame.invalidateCache();
 }
 
 void whiteBalance(pfs::Array2Df& R, pfs::Array2Df& G, pfs::Array2Df& B, WhiteBalanceType type)
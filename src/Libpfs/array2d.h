@@ -38,6 +38,8 @@
 
 namespace pfs
 {
+class BufferArena;
+
 //!
 //! \brief Two dimensional array of data
 //!
@@ -60,6 +62,13 @@ public:
     //! \brief init \c Array2D with a matrix of \a cols times \a rows
     Array2D(size_t cols, size_t rows); // (width, height)
 
+    //! \brief init \c Array2D with a matrix of \a cols times \a rows, whose
+    //! storage is taken from \a arena and given back to it by the destructor
+    //! \param arena arena supplying the storage (NULL: regular allocation)
+    //! \param initialize if false, the content of a reused buffer is left as
+    //! it is: use it for temporaries that are fully written before being read
+    Array2D(size_t cols, size_t rows, BufferArena* arena, bool initialize = true);
+
     //! \brief copy ctor
     //! \note If you want to build an empty \c Array2D with the same size of the
     //! source, use the ctor that takes dimension and you will spare the copy
@@ -69,7 +78,7 @@ public:
     self& operator=(const self& other);
 
     //! \brief virtual destructor
-    virtual ~Array2D() {}
+    virtual ~Array2D();
 
     //! Access an element of the array.
     //! Whether the given row and column are checked against
@@ -163,6 +172,9 @@ private:
 
     size_t     m_cols;
     size_t     m_rows;
+
+    //! \brief arena of the storage, kept by the instance across swap()
+    BufferArena* m_arena;
 };
 
 //! \brief typedef provided for backward compatibility with the old API
@@ -31,6 +31,7 @@
 #include <cassert>
 
 #include <Libpfs/array2d.h>
+#include <Libpfs/bufferarena.h>
 #include <Libpfs/utils/numeric.h>
 
 using namespace std;
@@ -41,7 +42,8 @@ template <typename Type>
 Array2D<Type>::Array2D()
     : m_data()
     , m_cols(0)
-    , m_rows(0) 
+    , m_rows(0)
+    , m_arena(NULL)
 {}
 
 template <typename Type>
@@ -49,19 +51,53 @@ Array2D<Type>::Array2D(size_t cols, size_t rows)
     : m_data(cols*rows)
     , m_cols(cols)
     , m_rows(rows)
+    , m_arena(NULL)
 {
     assert( m_data.size() >= m_cols*m_rows);
 }
 
+template <typename Type>
+Array2D<Type>::Array2D(size_t cols, size_t rows, BufferArena* arena, bool initialize)
+    : m_data()
+    , m_cols(cols)
+    , m_rows(rows)
+    , m_arena(arena)
+{
+    if ( m_arena )
+    {
+        m_arena->acquire(cols*rows, m_data);
+        if ( initialize )
+        {
+            reset();
+        }
+    }
+    else
+    {
+        m_data.resize(cols*rows);
+    }
+
+    assert( m_data.size() >= m_cols*m_rows);
+}
+
 template <typename Type>
 Array2D<Type>::Array2D(const self& rhs)
     : m_data(rhs.m_data)
     , m_cols(rhs.m_cols)
     , m_rows(rhs.m_rows)
+    , m_arena(NULL)
 {
     assert( m_data.size() >= m_cols*m_rows);
 }
 
+template <typename Type>
+Array2D<Type>::~Array2D()
+{
+    if ( m_arena )
+    {
+        m_arena->release(m_data);
+    }
+}
+
 template <typename Type>
 Array2D<Type>& Array2D<Type>::operator=(const Array2D<Type>& other)
 {
@@ -0,0 +1,127 @@
+/*
+ * This file is a part of Luminance HDR package
+ * ----------------------------------------------------------------------
+ * Copyright (C) 2017 Luminance HDR developers
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+#ifndef PFS_ARRAY2DVIEW_H
+#define PFS_ARRAY2DVIEW_H
+
+#include <cstddef>
+#include <memory>
+
+#include <Libpfs/array2d.h>
+
+//! \file array2dview.h
+//! \brief non-owning, copy-on-write 2d array
+
+namespace pfs
+{
+//!
+//! \brief Read-only view over a 2d array of data stored somewhere else
+//! (i.e. inside a memory mapped file), in row-major order.
+//!
+//! Consecutive elements of a row are \c getStride() elements apart, so the
+//! view can describe a single component of interleaved data (like the red
+//! channel of an RGB scanline).
+//! The storage is kept alive through a shared owner handle. The first
+//! non-const access makes a private, contiguous copy of the data
+//! (copy-on-write): after that, the view behaves exactly like an \c Array2D.
+//!
+//! \note A view has a single writer: \c detach() is not synchronized, so a
+//! non-const access must not race with any other access to the same view.
+//! Threads that write into a shared view need \c detach() to be called once
+//! before they start. Distinct views over the same storage are independent.
+//!
+template <typename Type>
+class Array2DView
+{
+public:
+    typedef std::shared_ptr<const void> Owner;
+    typedef Array2DView<Type>           self;
+
+    //! \brief empty view
+    Array2DView();
+
+    //! \brief view over \a cols times \a rows elements starting at \a data,
+    //! kept alive by \a owner
+    Array2DView(const Type* data, size_t cols, size_t rows,
+                size_t stride, const Owner& owner);
+
+    //! \brief takes ownership of the content of \a array (no copy)
+    explicit Array2DView(Array2D<Type>& array);
+
+    Array2DView(const self& other);
+    self& operator=(const self& other);
+
+    //! \brief Swap the content of the current instance with \a other
+    void swap(self& other);
+
+    size_t getCols() const      { return m_cols; }
+    size_t getRows() const      { return m_rows; }
+    size_t size() const         { return m_rows*m_cols; }
+    size_t getStride() const    { return m_stride; }
+
+    //! \brief true if the data still lives in the external storage
+    bool isShared() const       { return !m_copy; }
+    //! \brief true if elements are contiguous in memory
+    bool isContiguous() const   { return m_stride == 1; }
+
+    const Type& operator()(size_t col, size_t row) const
+    { return m_data[(row*m_cols + col)*m_stride]; }
+    const Type& operator()(size_t index) const
+    { return m_data[index*m_stride]; }
+
+    //! \brief non-const access: detaches the view from the external storage
+    //! (not thread safe, see the class documentation)
+    Type& operator()(size_t col, size_t row)
+    { return detach()(col, row); }
+    Type& operator()(size_t index)
+    { return detach()(index); }
+
+    //! \brief direct access to the data. Valid only if \c isContiguous()
+    const Type* data() const    { return m_data; }
+
+    //! \brief returns the private copy of the data, creating it if necessary
+    Array2D<Type>& detach();
+
+    //! \brief copies the content of the view inside \a dst (resized if
+    //! necessary)
+    void copyTo(Array2D<Type>& dst) const;
+
+    //! \brief moves the content of the view inside \a dst and empties the
+    //! view: a private copy is handed over as is, external data is copied
+    void moveTo(Array2D<Type>& dst);
+
+private:
+    const Type* m_data;
+    size_t      m_cols;
+    size_t      m_rows;
+    size_t      m_stride;
+    Owner       m_owner;
+
+    std::unique_ptr< Array2D<Type> > m_copy;
+};
+
+typedef Array2DView<float> Array2DViewf;
+
+} // namespace pfs
+
+#include <Libpfs/array2dview.hxx>
+
+#endif // PFS_ARRAY2DVIEW_H
@@ -0,0 +1,150 @@
+/*
+ * This file is a part of Luminance HDR package
+ * ----------------------------------------------------------------------
+ * Copyright (C) 2017 Luminance HDR developers
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+#ifndef PFS_ARRAY2DVIEW_HXX
+#define PFS_ARRAY2DVIEW_HXX
+
+#include <algorithm>
+
+#include <Libpfs/array2dview.h>
+#include <Libpfs/strideiterator.h>
+
+namespace pfs
+{
+
+template <typename Type>
+Array2DView<Type>::Array2DView()
+    : m_data(NULL)
+    , m_cols(0)
+    , m_rows(0)
+    , m_stride(1)
+    , m_owner()
+{}
+
+template <typename Type>
+Array2DView<Type>::Array2DView(const Type* data, size_t cols, size_t rows,
+                               size_t stride, const Owner& owner)
+    : m_data(data)
+    , m_cols(cols)
+    , m_rows(rows)
+    , m_stride(stride)
+    , m_owner(owner)
+{}
+
+template <typename Type>
+Array2DView<Type>::Array2DView(Array2D<Type>& array)
+    : m_data(NULL)
+    , m_cols(array.getCols())
+    , m_rows(array.getRows())
+    , m_stride(1)
+    , m_owner()
+    , m_copy(new Array2D<Type>())
+{
+    m_copy->swap(array);
+    m_data = m_copy->data();
+}
+
+template <typename Type>
+Array2DView<Type>::Array2DView(const self& other)
+    : m_data(other.m_data)
+    , m_cols(other.m_cols)
+    , m_rows(other.m_rows)
+    , m_stride(other.m_stride)
+    , m_owner(other.m_owner)
+{
+    if ( other.m_copy )
+    {
+        m_copy.reset( new Array2D<Type>(*other.m_copy) );
+        m_data = m_copy->data();
+    }
+}
+
+template <typename Type>
+Array2DView<Type>& Array2DView<Type>::operator=(const self& other)
+{
+    self temp(other);
+    swap(temp);
+    return *this;
+}
+
+template <typename Type>
+void Array2DView<Type>::swap(self& other)
+{
+    std::swap(m_data, other.m_data);
+    std::swap(m_cols, other.m_cols);
+    std::swap(m_rows, other.m_rows);
+    std::swap(m_stride, other.m_stride);
+    m_owner.swap(other.m_owner);
+    m_copy.swap(other.m_copy);
+}
+
+template <typename Type>
+Array2D<Type>& Array2DView<Type>::detach()
+{
+    if ( !m_copy )
+    {
+        std::unique_ptr< Array2D<Type> > copy(new Array2D<Type>());
+        copyTo(*copy);
+
+        m_copy.swap(copy);
+        m_data = m_copy->data();
+        m_stride = 1;
+        // release the external storage
+        m_owner.reset();
+    }
+    return *m_copy;
+}
+
+template <typename Type>
+void Array2DView<Type>::copyTo(Array2D<Type>& dst) const
+{
+    dst.resize(m_cols, m_rows);
+    if ( m_stride == 1 )
+    {
+        std::copy(m_data, m_data + size(), dst.begin());
+    }
+    else
+    {
+        std::copy(StrideIterator<const Type*>(m_data, m_stride),
+                  StrideIterator<const Type*>(m_data + size()*m_stride, m_stride),
+                  dst.begin());
+    }
+}
+
+template <typename Type>
+void Array2DView<Type>::moveTo(Array2D<Type>& dst)
+{
+    if ( m_copy )
+    {
+        dst.swap(*m_copy);
+    }
+    else
+    {
+        copyTo(dst);
+    }
+
+    self temp;
+    swap(temp);
+}
+
+} // namespace pfs
+
+#endif // PFS_ARRAY2DVIEW_HXX
@@ -0,0 +1,71 @@
+/*
+ * This file is a part of Luminance HDR package
+ * ----------------------------------------------------------------------
+ * Copyright (C) 2017 Luminance HDR developers
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+#include <Libpfs/bufferarena.h>
+
+namespace pfs
+{
+
+BufferArena::BufferArena(size_t maxBytes)
+    : m_maxBytes(maxBytes)
+    , m_bytes(0)
+    , m_hits(0)
+    , m_misses(0)
+{}
+
+BufferArena::~BufferArena()
+{
+    for (PoolMap::iterator it = m_pools.begin(); it != m_pools.end(); ++it)
+    {
+        delete it->second;
+    }
+}
+
+size_t BufferArena::bytes() const
+{
+    boost::mutex::scoped_lock lock(m_mutex);
+    return m_bytes;
+}
+
+size_t BufferArena::hits() const
+{
+    boost::mutex::scoped_lock lock(m_mutex);
+    return m_hits;
+}
+
+size_t BufferArena::misses() const
+{
+    boost::mutex::scoped_lock lock(m_mutex);
+    return m_misses;
+}
+
+void BufferArena::clear()
+{
+    boost::mutex::scoped_lock lock(m_mutex);
+
+    for (PoolMap::iterator it = m_pools.begin(); it != m_pools.end(); ++it)
+    {
+        it->second->clear();
+    }
+    m_bytes = 0;
+}
+
+} // namespace pfs
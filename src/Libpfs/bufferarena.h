@@ -0,0 +1,111 @@
+/*
+ * This file is a part of Luminance HDR package
+ * ----------------------------------------------------------------------
+ * Copyright (C) 2017 Luminance HDR developers
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+#ifndef PFS_BUFFERARENA_H
+#define PFS_BUFFERARENA_H
+
+#include <cstddef>
+#include <list>
+#include <map>
+#include <typeinfo>
+#include <typeindex>
+#include <vector>
+
+#include <boost/thread/mutex.hpp>
+
+//! \file bufferarena.h
+//! \brief Pool of buffers reused by the temporaries of the operators
+
+namespace pfs
+{
+//!
+//! \brief Scoped pool of the buffers backing \c Array2D temporaries.
+//!
+//! An \c Array2D built on an arena takes a buffer released by a previous
+//! temporary of the same type, if one is large enough, and gives it back
+//! when it is destroyed. The same memory is then reused across the
+//! temporaries of an operator and across consecutive calls of the operator
+//! (i.e. repeated previews or the items of a batch), without page faults.
+//! Reused buffers are not cleared, unless requested.
+//!
+//! The arena is thread-safe, and must outlive all the arrays built on it.
+//!
+class BufferArena
+{
+public:
+    //! \param maxBytes maximum amount of memory kept by the arena when the
+    //! buffers are released (0: no limit)
+    explicit BufferArena(size_t maxBytes = 0);
+    ~BufferArena();
+
+    //! \brief stores in \a buffer a vector of \a size elements, reusing the
+    //! smallest released buffer large enough. The content of a reused buffer
+    //! is undefined.
+    template <typename Type>
+    void acquire(size_t size, std::vector<Type>& buffer);
+
+    //! \brief gives the storage of \a buffer back to the arena. \a buffer is
+    //! left empty
+    template <typename Type>
+    void release(std::vector<Type>& buffer);
+
+    //! \brief memory (in bytes) held by the released buffers
+    size_t bytes() const;
+    //! \brief number of requests served with a released buffer
+    size_t hits() const;
+    //! \brief number of requests that needed a new allocation
+    size_t misses() const;
+
+    //! \brief frees all the released buffers
+    void clear();
+
+private:
+    BufferArena(const BufferArena&);
+    BufferArena& operator=(const BufferArena&);
+
+    struct PoolBase
+    {
+        virtual ~PoolBase() {}
+        virtual size_t bytes() const = 0;
+        virtual void clear() = 0;
+    };
+
+    template <typename Type>
+    struct Pool;
+
+    typedef std::map<std::type_index, PoolBase*> PoolMap;
+
+    template <typename Type>
+    Pool<Type>& pool();
+
+    mutable boost::mutex m_mutex;
+    PoolMap m_pools;
+    size_t m_maxBytes;
+    size_t m_bytes;
+    size_t m_hits;
+    size_t m_misses;
+};
+
+} // namespace pfs
+
+#include <Libpfs/bufferarena.hxx>
+
+#endif // PFS_BUFFERARENA_H
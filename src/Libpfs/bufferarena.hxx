@@ -0,0 +1,134 @@
+/*
+ * This file is a part of Luminance HDR package
+ * ----------------------------------------------------------------------
+ * Copyright (C) 2017 Luminance HDR developers
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+#ifndef PFS_BUFFERARENA_HXX
+#define PFS_BUFFERARENA_HXX
+
+#include <Libpfs/bufferarena.h>
+
+namespace pfs
+{
+
+template <typename Type>
+struct BufferArena::Pool : public PoolBase
+{
+    typedef std::vector<Type> Buffer;
+    typedef std::list<Buffer> BufferList;
+
+    size_t bytes() const
+    {
+        size_t total = 0;
+        for (typename BufferList::const_iterator it = buffers.begin();
+             it != buffers.end(); ++it)
+        {
+            total += it->capacity()*sizeof(Type);
+        }
+        return total;
+    }
+
+    void clear()
+    {
+        buffers.clear();
+    }
+
+    //! released buffers, sorted by capacity
+    BufferList buffers;
+};
+
+template <typename Type>
+BufferArena::Pool<Type>& BufferArena::pool()
+{
+    PoolBase*& p = m_pools[std::type_index(typeid(Type))];
+    if ( !p )
+    {
+        p = new Pool<Type>();
+    }
+    return static_cast<Pool<Type>&>(*p);
+}
+
+template <typename Type>
+void BufferArena::acquire(size_t size, std::vector<Type>& buffer)
+{
+    typedef typename Pool<Type>::BufferList BufferList;
+
+    {
+        boost::mutex::scoped_lock lock(m_mutex);
+
+        BufferList& buffers = pool<Type>().buffers;
+        typename BufferList::iterator it = buffers.begin();
+        while ( it != buffers.end() && it->capacity() < size )
+        {
+            ++it;
+        }
+
+        if ( it != buffers.end() )
+        {
+            m_bytes -= it->capacity()*sizeof(Type);
+            ++m_hits;
+
+            buffer.swap(*it);
+            buffers.erase(it);
+        }
+        else
+        {
+            ++m_misses;
+        }
+    }
+
+    // shrinking keeps the storage and the values: only the elements above
+    // the previous size of a reused buffer are initialized
+    buffer.resize(size);
+}
+
+template <typename Type>
+void BufferArena::release(std::vector<Type>& buffer)
+{
+    typedef typename Pool<Type>::BufferList BufferList;
+
+    const size_t bytes = buffer.capacity()*sizeof(Type);
+    if ( bytes == 0 )
+    {
+        return;
+    }
+
+    boost::mutex::scoped_lock lock(m_mutex);
+
+    if ( m_maxBytes && m_bytes + bytes > m_maxBytes )
+    {
+        // over budget: the buffer is freed with its owner
+        return;
+    }
+
+    BufferList& buffers = pool<Type>().buffers;
+    typename BufferList::iterator it = buffers.begin();
+    while ( it != buffers.end() && it->capacity() < buffer.capacity() )
+    {
+        ++it;
+    }
+
+    it = buffers.insert(it, std::vector<Type>());
+    it->swap(buffer);
+    m_bytes += bytes;
+}
+
+} // namespace pfs
+
+#endif // PFS_BUFFERARENA_HXX
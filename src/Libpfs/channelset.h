@@ -0,0 +1,83 @@
+/*
+ * This file is a part of Luminance HDR package
+ * ----------------------------------------------------------------------
+ * Copyright (C) 2017 Luminance HDR developers
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+#ifndef PFS_CHANNELSET_H
+#define PFS_CHANNELSET_H
+
+#include <string>
+#include <vector>
+
+//! \file channelset.h
+//! \brief named channels owned by a frame
+
+namespace pfs
+{
+//!
+//! \brief Owning, ordered collection of named channels: the channel
+//! management shared by \c TiledFrame and \c FrameView.
+//!
+//! \c ChannelType needs a \c getName() member. Channels are built by the
+//! owning frame, which knows how to size and store them, and passed to
+//! \c create() as a factory.
+//!
+template <typename ChannelType>
+class ChannelSet
+{
+public:
+    typedef std::vector<ChannelType*> Container;
+
+    ChannelSet() {}
+    ~ChannelSet();
+
+    ChannelType* get(const std::string& name);
+    const ChannelType* get(const std::string& name) const;
+
+    //! \brief returns the channel named \a name, adding the one returned by
+    //! \a factory(name) if there is none
+    template <typename Factory>
+    ChannelType* create(const std::string& name, Factory factory);
+
+    void remove(const std::string& name);
+
+    //! \brief gets the X, Y and Z channels: all NULL if one of them is missing
+    void getXYZ(ChannelType* &X, ChannelType* &Y, ChannelType* &Z);
+
+    template <typename Factory>
+    void createXYZ(ChannelType* &X, ChannelType* &Y, ChannelType* &Z,
+                   Factory factory);
+
+    Container& channels()               { return m_channels; }
+    const Container& channels() const   { return m_channels; }
+
+    void swap(ChannelSet& other)        { m_channels.swap(other.m_channels); }
+
+private:
+    ChannelSet(const ChannelSet&);
+    ChannelSet& operator=(const ChannelSet&);
+
+    Container m_channels;
+};
+
+} // namespace pfs
+
+#include <Libpfs/channelset.hxx>
+
+#endif // PFS_CHANNELSET_H
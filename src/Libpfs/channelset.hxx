@@ -0,0 +1,132 @@
+/*
+ * This file is a part of Luminance HDR package
+ * ----------------------------------------------------------------------
+ * Copyright (C) 2017 Luminance HDR developers
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+#ifndef PFS_CHANNELSET_HXX
+#define PFS_CHANNELSET_HXX
+
+#include <cstddef>
+#include <algorithm>
+
+#include <Libpfs/channelset.h>
+
+namespace pfs
+{
+namespace detail
+{
+template <typename ChannelType>
+struct FindChannelByName
+{
+    explicit FindChannelByName(const std::string& nameChannel)
+        : nameChannel_(nameChannel)
+    {}
+
+    inline
+    bool operator()(const ChannelType* channel) const
+    {
+        return !(channel->getName().compare( nameChannel_ ));
+    }
+
+private:
+    std::string nameChannel_;
+};
+}
+
+template <typename ChannelType>
+ChannelSet<ChannelType>::~ChannelSet()
+{
+    for (size_t idx = 0; idx < m_channels.size(); ++idx)
+    {
+        delete m_channels[idx];
+    }
+}
+
+template <typename ChannelType>
+const ChannelType* ChannelSet<ChannelType>::get(const std::string& name) const
+{
+    typename Container::const_iterator it =
+            std::find_if(m_channels.begin(), m_channels.end(),
+                         detail::FindChannelByName<ChannelType>(name));
+    if ( it == m_channels.end() )
+        return NULL;
+    else
+        return *it;
+}
+
+template <typename ChannelType>
+ChannelType* ChannelSet<ChannelType>::get(const std::string& name)
+{
+    return const_cast<ChannelType*>(
+                static_cast<const ChannelSet&>(*this).get(name));
+}
+
+template <typename ChannelType>
+template <typename Factory>
+ChannelType* ChannelSet<ChannelType>::create(const std::string& name, Factory factory)
+{
+    ChannelType* ch = get(name);
+    if ( ch == NULL )
+    {
+        ch = factory(name);
+        m_channels.push_back( ch );
+    }
+    return ch;
+}
+
+template <typename ChannelType>
+void ChannelSet<ChannelType>::remove(const std::string& name)
+{
+    typename Container::iterator it =
+            std::find_if(m_channels.begin(), m_channels.end(),
+                         detail::FindChannelByName<ChannelType>(name));
+    if ( it != m_channels.end() )
+    {
+        ChannelType* ch = *it;
+        m_channels.erase( it );
+        delete ch;
+    }
+}
+
+template <typename ChannelType>
+void ChannelSet<ChannelType>::getXYZ(ChannelType* &X, ChannelType* &Y, ChannelType* &Z)
+{
+    X = get("X");
+    Y = get("Y");
+    Z = get("Z");
+
+    if ( X == NULL || Y == NULL || Z == NULL )
+    {
+        X = Y = Z = NULL;
+    }
+}
+
+template <typename ChannelType>
+template <typename Factory>
+void ChannelSet<ChannelType>::createXYZ(ChannelType* &X, ChannelType* &Y, ChannelType* &Z,
+                                        Factory factory)
+{
+    X = create("X", factory);
+    Y = create("Y", factory);
+    Z = create("Z", factory);
+}
+
+} // namespace pfs
+
+#endif // PFS_CHANNELSET_HXX
@@ -37,9 +37,12 @@
 
 #include "Libpfs/pfs.h"
 #include "Libpfs/array2d.h"
+#include "Libpfs/tiledarray2d.h"
 #include "Libpfs/utils/msec_timer.h"
 
 #include "Libpfs/utils/transform.h"
+#include "Libpfs/utils/chain.h"
+#include "Libpfs/colorspace/pipeline.h"
 #include "Libpfs/colorspace/rgb.h"
 #include "Libpfs/colorspace/xyz.h"
 #include "Libpfs/colorspace/yuv.h"
@@ -51,27 +54,153 @@ using namespace boost::assign;
 
 namespace pfs {
 
-//-----------------------------------------------------------
-// sRGB conversion functions
-//-----------------------------------------------------------
-void transformSRGB2XYZ(const Array2Df *inC1, const Array2Df *inC2, const Array2Df *inC3,
-                       Array2Df *outC1, Array2Df *outC2, Array2Df *outC3)
+namespace
 {
+typedef colorspace::NoTransform Identity;
+typedef colorspace::MatrixTransform<colorspace::rgb2xyzD65Mat> RGB2XYZ;
+typedef colorspace::MatrixTransform<colorspace::xyz2rgbD65Mat> XYZ2RGB;
+typedef colorspace::MatrixTransform<colorspace::rgb2yuvMat> RGB2YUV;
+typedef colorspace::MatrixTransform<colorspace::yuv2rgbMat> YUV2RGB;
+
+//! \brief Conversion made of three stages: \a Decode brings the input into a
+//! linear space, \a Matrix moves it into the linear space of the output, and
+//! \a Encode applies the output representation. All of them are inlined in
+//! a single sweep over the image.
+template <typename Decode, typename Matrix, typename Encode>
+struct CSPipeline
+{
+    static void planar(const Array2Df *inC1, const Array2Df *inC2, const Array2Df *inC3,
+                       Array2Df *outC1, Array2Df *outC2, Array2Df *outC3)
+    {
 #ifdef TIMER_PROFILING
-    msec_timer f_timer;
-    f_timer.start();
+        msec_timer f_timer;
+        f_timer.start();
 #endif
 
-    utils::transform(inC1->begin(), inC1->end(), inC2->begin(), inC3->begin(),
-                     outC1->begin(), outC2->begin(), outC3->begin(),
-                     colorspace::ConvertSRGB2XYZ());
+        buffers(inC1->data(), inC2->data(), inC3->data(), inC1->size(),
+                outC1->data(), outC2->data(), outC3->data());
 
 #ifdef TIMER_PROFILING
-    f_timer.stop_and_update();
-    std::cout << "transformSRGB2XYZ() = " << f_timer.get_time() << " msec" << std::endl;
+        f_timer.stop_and_update();
+        std::cout << "transformColorSpace() = " << f_timer.get_time() << " msec" << std::endl;
 #endif
+    }
 
+    static void buffers(const float *in1, const float *in2, const float *in3, size_t size,
+                        float *out1, float *out2, float *out3)
+    {
+        colorspace::runPipeline(in1, in2, in3, size, out1, out2, out3, 1,
+                                utils::chain(Decode(), Matrix(), Encode()));
+    }
+
+    template <typename TypeOut>
+    static void interleaved(const Array2Df *inC1, const Array2Df *inC2, const Array2Df *inC3,
+                            TypeOut *out)
+    {
+        colorspace::runPipeline(inC1->data(), inC2->data(), inC3->data(), inC1->size(),
+                                out, out + 1, out + 2, 3,
+                                utils::chain(Decode(), Matrix(),
+                                             utils::chain(Encode(), colorspace::Quantize<TypeOut>())));
+    }
+};
+
+typedef void (*CSTransformFunc)(const Array2Df *inC1, const Array2Df *inC2, const Array2Df *inC3,
+                                Array2Df *outC1, Array2Df *outC2, Array2Df *outC3 );
+typedef void (*CSTransformBufferFunc)(const float *in1, const float *in2, const float *in3,
+                                     size_t size, float *out1, float *out2, float *out3);
+typedef void (*CSTransform8Func)(const Array2Df *inC1, const Array2Df *inC2, const Array2Df *inC3,
+                                 uint8_t *out);
+typedef void (*CSTransform16Func)(const Array2Df *inC1, const Array2Df *inC2, const Array2Df *inC3,
+                                  uint16_t *out);
+
+struct CSTransform
+{
+    CSTransformFunc planar;
+    CSTransformBufferFunc buffers;
+    CSTransform8Func interleaved8;
+    CSTransform16Func interleaved16;
+};
+
+template <typename Decode, typename Matrix, typename Encode>
+CSTransform csTransform()
+{
+    typedef CSPipeline<Decode, Matrix, Encode> Pipeline;
+
+    CSTransform transform = {
+        &Pipeline::planar,
+        &Pipeline::buffers,
+        &Pipeline::template interleaved<uint8_t>,
+        &Pipeline::template interleaved<uint16_t>
+    };
+    return transform;
 }
+
+typedef std::pair<ColorSpace, ColorSpace> CSTransformProfile;
+typedef std::map<CSTransformProfile, CSTransform> CSTransformMap;
+
+//! \brief Transforms between all the pairs of colorspaces. CS_YUV always
+//! holds the u'v' chromaticities: the YUV matrices of transformRGB2Yuv() and
+//! transformYuv2RGB() are not part of this table.
+const CSTransform& findTransform(ColorSpace inCS, ColorSpace outCS)
+{
+    // static dictionary... I already know in advance the subscription I want
+    // to perform, hence this approach is far easier than try to create
+    // automatic subscription to the factory
+    static const CSTransformMap s_csTransformMap =
+            map_list_of
+            // XYZ -> *
+            (CSTransformProfile(CS_XYZ, CS_XYZ), csTransform<Identity, Identity, Identity>())
+            (CSTransformProfile(CS_XYZ, CS_RGB), csTransform<Identity, XYZ2RGB, Identity>())
+            (CSTransformProfile(CS_XYZ, CS_SRGB), csTransform<Identity, XYZ2RGB, colorspace::ConvertRGB2SRGB>())
+            (CSTransformProfile(CS_XYZ, CS_YUV), csTransform<Identity, Identity, colorspace::ConvertXYZ2Yuv>())
+            (CSTransformProfile(CS_XYZ, CS_Yxy), csTransform<Identity, Identity, colorspace::ConvertXYZ2Yxy>())
+            // RGB -> *
+            (CSTransformProfile(CS_RGB, CS_XYZ), csTransform<Identity, RGB2XYZ, Identity>())
+            (CSTransformProfile(CS_RGB, CS_RGB), csTransform<Identity, Identity, Identity>())
+            (CSTransformProfile(CS_RGB, CS_SRGB), csTransform<Identity, Identity, colorspace::ConvertRGB2SRGB>())
+            (CSTransformProfile(CS_RGB, CS_YUV), csTransform<Identity, RGB2XYZ, colorspace::ConvertXYZ2Yuv>())
+            (CSTransformProfile(CS_RGB, CS_Yxy), csTransform<Identity, RGB2XYZ, colorspace::ConvertXYZ2Yxy>())
+            // sRGB -> *
+            (CSTransformProfile(CS_SRGB, CS_XYZ), csTransform<colorspace::ConvertSRGB2RGB, RGB2XYZ, Identity>())
+            (CSTransformProfile(CS_SRGB, CS_RGB), csTransform<colorspace::ConvertSRGB2RGB, Identity, Identity>())
+            (CSTransformProfile(CS_SRGB, CS_SRGB), csTransform<Identity, Identity, Identity>())
+            (CSTransformProfile(CS_SRGB, CS_YUV), csTransform<colorspace::ConvertSRGB2RGB, RGB2XYZ, colorspace::ConvertXYZ2Yuv>())
+            (CSTransformProfile(CS_SRGB, CS_Yxy), csTransform<colorspace::ConvertSRGB2RGB, RGB2XYZ, colorspace::ConvertXYZ2Yxy>())
+            // Yuv -> *
+            (CSTransformProfile(CS_YUV, CS_XYZ), csTransform<colorspace::ConvertYuv2XYZ, Identity, Identity>())
+            (CSTransformProfile(CS_YUV, CS_RGB), csTransform<colorspace::ConvertYuv2XYZ, XYZ2RGB, Identity>())
+            (CSTransformProfile(CS_YUV, CS_SRGB), csTransform<colorspace::ConvertYuv2XYZ, XYZ2RGB, colorspace::ConvertRGB2SRGB>())
+            (CSTransformProfile(CS_YUV, CS_YUV), csTransform<Identity, Identity, Identity>())
+            (CSTransformProfile(CS_YUV, CS_Yxy), csTransform<colorspace::ConvertYuv2XYZ, Identity, colorspace::ConvertXYZ2Yxy>())
+            // Yxy -> *
+            (CSTransformProfile(CS_Yxy, CS_XYZ), csTransform<colorspace::ConvertYxy2XYZ, Identity, Identity>())
+            (CSTransformProfile(CS_Yxy, CS_RGB), csTransform<colorspace::ConvertYxy2XYZ, XYZ2RGB, Identity>())
+            (CSTransformProfile(CS_Yxy, CS_SRGB), csTransform<colorspace::ConvertYxy2XYZ, XYZ2RGB, colorspace::ConvertRGB2SRGB>())
+            (CSTransformProfile(CS_Yxy, CS_YUV), csTransform<colorspace::ConvertYxy2XYZ, Identity, colorspace::ConvertXYZ2Yuv>())
+            (CSTransformProfile(CS_Yxy, CS_Yxy), csTransform<Identity, Identity, Identity>())
+            ;
+
+    CSTransformMap::const_iterator itTransform =
+            s_csTransformMap.find( CSTransformProfile(inCS, outCS) );
+
+    if ( itTransform == s_csTransformMap.end() )
+    {
+        throw Exception( "Unsupported color tranform" );
+    }
+    return itTransform->second;
+}
+}
+
+//-----------------------------------------------------------
+// sRGB conversion functions
+//-----------------------------------------------------------
+void transformSRGB2XYZ(const Array2Df *inC1, const Array2Df *inC2, const Array2Df *inC3,
+                       Array2Df *outC1, Array2Df *outC2, Array2Df *outC3)
+{
+    CSPipeline<colorspace::ConvertSRGB2RGB, RGB2XYZ, Identity>::planar(
+                inC1, inC2, inC3, outC1, outC2, outC3);
+}
+
 void transformSRGB2Y(const Array2Df *inC1, const Array2Df *inC2, const Array2Df *inC3,
                      Array2Df *outC1)
 {
@@ -85,19 +214,8 @@ void transformSRGB2Y(const Array2Df *inC1, const Array2Df *inC2, const Array2Df
 void transformRGB2XYZ(const Array2Df *inC1, const Array2Df *inC2, const Array2Df *inC3,
                       Array2Df *outC1, Array2Df *outC2, Array2Df *outC3)
 {
-#ifdef TIMER_PROFILING
-    msec_timer f_timer;
-    f_timer.start();
-#endif
-
-    utils::transform(inC1->begin(), inC1->end(), inC2->begin(), inC3->begin(),
-                     outC1->begin(), outC2->begin(), outC3->begin(),
-                     colorspace::ConvertRGB2XYZ());
-
-#ifdef TIMER_PROFILING
-    f_timer.stop_and_update();
-    std::cout << "transformRGB2XYZ() = " << f_timer.get_time() << " msec" << std::endl;
-#endif
+    CSPipeline<Identity, RGB2XYZ, Identity>::planar(
+                inC1, inC2, inC3, outC1, outC2, outC3);
 }
 
 void transformRGB2Y(const Array2Df *inC1, const Array2Df *inC2, const Array2Df *inC3,
@@ -110,151 +228,65 @@ void transformRGB2Y(const Array2Df *inC1, const Array2Df *inC2, const Array2Df *
 void transformRGB2Yuv(const Array2Df *inC1, const Array2Df *inC2, const Array2Df *inC3,
                       Array2Df *outC1, Array2Df *outC2, Array2Df *outC3)
 {
-#ifdef TIMER_PROFILING
-    msec_timer f_timer;
-    f_timer.start();
-#endif
-
-    utils::transform(inC1->begin(), inC1->end(), inC2->begin(), inC3->begin(),
-                     outC1->begin(), outC2->begin(), outC3->begin(),
-                     colorspace::ConvertRGB2YUV());
-
-#ifdef TIMER_PROFILING
-    f_timer.stop_and_update();
-    std::cout << "transformRGB2Yuv() = " << f_timer.get_time() << " msec" << std::endl;
-#endif
+    CSPipeline<Identity, RGB2YUV, Identity>::planar(
+                inC1, inC2, inC3, outC1, outC2, outC3);
 }
 
+//-----------------------------------------------------------
+// XYZ conversion functions
+//-----------------------------------------------------------
 void transformXYZ2SRGB(const Array2Df *inC1, const Array2Df *inC2, const Array2Df *inC3,
                        Array2Df *outC1, Array2Df *outC2, Array2Df *outC3)
 {
-#ifdef TIMER_PROFILING
-    msec_timer f_timer;
-    f_timer.start();
-#endif
-
-    utils::transform(inC1->begin(), inC1->end(), inC2->begin(), inC3->begin(),
-                     outC1->begin(), outC2->begin(), outC3->begin(),
-                     colorspace::ConvertXYZ2SRGB());
-
-#ifdef TIMER_PROFILING
-    f_timer.stop_and_update();
-    std::cout << "transformXYZ2SRGB() = " << f_timer.get_time() << " msec" << std::endl;
-#endif
+    CSPipeline<Identity, XYZ2RGB, colorspace::ConvertRGB2SRGB>::planar(
+                inC1, inC2, inC3, outC1, outC2, outC3);
 }
 
 void transformXYZ2RGB(const Array2Df *inC1, const Array2Df *inC2, const Array2Df *inC3,
                       Array2Df *outC1, Array2Df *outC2, Array2Df *outC3 )
 {
-#ifdef TIMER_PROFILING
-    msec_timer f_timer;
-    f_timer.start();
-#endif
-
-    utils::transform(inC1->begin(), inC1->end(), inC2->begin(), inC3->begin(),
-                     outC1->begin(), outC2->begin(), outC3->begin(),
-                     colorspace::ConvertXYZ2RGB());
-
-#ifdef TIMER_PROFILING
-    f_timer.stop_and_update();
-    std::cout << "transformXYZ2RGB() = " << f_timer.get_time() << " msec" << std::endl;
-#endif
+    CSPipeline<Identity, XYZ2RGB, Identity>::planar(
+                inC1, inC2, inC3, outC1, outC2, outC3);
 }
 
 void transformXYZ2Yuv( const Array2Df *inC1, const Array2Df *inC2, const Array2Df *inC3,
                        Array2Df *outC1, Array2Df *outC2, Array2Df *outC3 )
 {
-    const int elems = inC1->getRows()*inC1->getCols();
-    for ( int idx = 0; idx < elems; idx++ )
-    {
-        const float &X = (*inC1)(idx), Y = (*inC2)(idx), &Z = (*inC3)(idx);
-        float &outY = (*outC1)(idx), &u = (*outC2)(idx), &v = (*outC3)(idx);
-
-        float x = X/(X+Y+Z);
-        float y = Y/(X+Y+Z);
-
-        // assert((4.f*nx / (-2.f*nx + 12.f*ny + 3.f)) <= 0.62 );
-        // assert( (9.f*ny / (-2.f*nx + 12.f*ny + 3.f)) <= 0.62 );
-
-        u = 4.f*x / (-2.f*x + 12.f*y + 3.f);
-        v = 9.f*y / (-2.f*x + 12.f*y + 3.f);
-        outY = Y;
-    }
+    CSPipeline<Identity, Identity, colorspace::ConvertXYZ2Yuv>::planar(
+                inC1, inC2, inC3, outC1, outC2, outC3);
+}
 
+void transformXYZ2Yxy( const Array2Df *inC1, const Array2Df *inC2, const Array2Df *inC3,
+                       Array2Df *outC1, Array2Df *outC2, Array2Df *outC3 )
+{
+    CSPipeline<Identity, Identity, colorspace::ConvertXYZ2Yxy>::planar(
+                inC1, inC2, inC3, outC1, outC2, outC3);
 }
 
+//-----------------------------------------------------------
+// Yuv and Yxy conversion functions
+//-----------------------------------------------------------
 void transformYuv2XYZ( const Array2Df *inC1, const Array2Df *inC2, const Array2Df *inC3,
                        Array2Df *outC1, Array2Df *outC2, Array2Df *outC3 )
 {
-    const int elems = inC1->getRows()*inC1->getCols();
-    for( int idx = 0; idx < elems ; idx++ )
-    {
-        const float Y = (*inC1)(idx), &u = (*inC2)(idx), &v = (*inC3)(idx);
-        float &X = (*outC1)(idx), &outY = (*outC2)(idx), &Z = (*outC3)(idx);
-
-        float x = 9.f*u / (6.f*u - 16.f*v + 12.f);
-        float y = 4.f*v / (6.f*u - 16.f*v + 12.f);
-
-        X = x/y * Y;
-        Z = (1.f-x-y)/y * Y;
-        outY = Y;
-    }
+    CSPipeline<colorspace::ConvertYuv2XYZ, Identity, Identity>::planar(
+                inC1, inC2, inC3, outC1, outC2, outC3);
 }
 
 void transformYuv2RGB(const Array2Df *inC1, const Array2Df *inC2, const Array2Df *inC3,
                       Array2Df *outC1, Array2Df *outC2, Array2Df *outC3 )
 {
-#ifdef TIMER_PROFILING
-    msec_timer f_timer;
-    f_timer.start();
-#endif
-
-    utils::transform(inC1->begin(), inC1->end(), inC2->begin(), inC3->begin(),
-                     outC1->begin(), outC2->begin(), outC3->begin(),
-                     colorspace::ConvertYUV2RGB());
-
-#ifdef TIMER_PROFILING
-    f_timer.stop_and_update();
-    std::cout << "transformYuv2RGB() = " << f_timer.get_time() << " msec" << std::endl;
-#endif
+    CSPipeline<Identity, YUV2RGB, Identity>::planar(
+                inC1, inC2, inC3, outC1, outC2, outC3);
 }
 
 void transformYxy2XYZ( const Array2Df *inC1, const Array2Df *inC2, const Array2Df *inC3,
                        Array2Df *outC1, Array2Df *outC2, Array2Df *outC3 )
 {
-    const int elems = inC1->getRows()*inC1->getCols();
-    for( int idx = 0; idx < elems; idx++ )
-    {
-        const float Y = (*inC1)(idx), x = (*inC2)(idx), y = (*inC3)(idx);
-        float &X = (*outC1)(idx), &outY = (*outC2)(idx), &Z = (*outC3)(idx);
-
-        X = x/y * Y;
-        Z = (1.f-x-y)/y * Y;
-        outY = Y;
-    }
+    CSPipeline<colorspace::ConvertYxy2XYZ, Identity, Identity>::planar(
+                inC1, inC2, inC3, outC1, outC2, outC3);
 }
 
-void transformXYZ2Yxy( const Array2Df *inC1, const Array2Df *inC2, const Array2Df *inC3,
-                       Array2Df *outC1, Array2Df *outC2, Array2Df *outC3 )
-{
-    const int elems = inC1->getRows()*inC1->getCols();
-    for( int idx = 0; idx < elems; idx++ )
-    {
-        const float X = (*inC1)(idx), Y = (*inC2)(idx), Z = (*inC3)(idx);
-        float &outY = (*outC1)(idx), &x = (*outC2)(idx), &y = (*outC3)(idx);
-
-        x = X/(X+Y+Z);
-        y = Y/(X+Y+Z);
-
-        outY = Y;
-    }
-}
-
-typedef void (*CSTransformFunc)(const Array2Df *inC1, const Array2Df *inC2, const Array2Df *inC3,
-                                Array2Df *outC1, Array2Df *outC2, Array2Df *outC3 );
-typedef std::pair<ColorSpace, ColorSpace> CSTransformProfile;
-typedef std::map<CSTransformProfile, CSTransformFunc> CSTransformMap;
-
 void transformColorSpace(ColorSpace inCS, const Array2Df *inC1, const Array2Df *inC2, const Array2Df *inC3,
                            ColorSpace outCS, Array2Df *outC1, Array2Df *outC2, Array2Df *outC3)
 {
@@ -270,39 +302,55 @@ void transformColorSpace(ColorSpace inCS, const Array2Df *inC1, const Array2Df *
             outC1->getRows() == outC2->getRows() &&
             outC2->getRows() == outC3->getRows() );
 
-    // static dictionary... I already know in advance the subscription I want
-    // to perform, hence this approach is far easier than try to create
-    // automatic subscription to the factory
-    static CSTransformMap s_csTransformMap =
-            map_list_of
-            // XYZ -> *
-            (CSTransformProfile(CS_XYZ, CS_SRGB), transformXYZ2SRGB)
-            (CSTransformProfile(CS_XYZ, CS_RGB), transformXYZ2RGB)
-            (CSTransformProfile(CS_XYZ, CS_YUV), transformXYZ2Yuv)
-            (CSTransformProfile(CS_XYZ, CS_Yxy), transformXYZ2Yxy)
-            // sRGB -> *
-            (CSTransformProfile(CS_SRGB, CS_XYZ), transformSRGB2XYZ)
-            // RGB -> *
-            (CSTransformProfile(CS_RGB, CS_XYZ), transformRGB2XYZ)
-            (CSTransformProfile(CS_RGB, CS_YUV), transformRGB2Yuv)
-            // Yuv -> *
-            (CSTransformProfile(CS_YUV, CS_XYZ), transformYuv2XYZ)
-            (CSTransformProfile(CS_YUV, CS_RGB), transformYuv2RGB)
-            // Yxy -> *
-            (CSTransformProfile(CS_Yxy, CS_XYZ), transformYxy2XYZ)
-            ;
+    const CSTransform& transform = findTransform(inCS, outCS);
 
-    CSTransformMap::const_iterator itTransform =
-            s_csTransformMap.find( CSTransformProfile(inCS, outCS) );
+    // in-place identity: nothing to do
+    if ( inCS == outCS && inC1 == outC1 && inC2 == outC2 && inC3 == outC3 )
+    {
+        return;
+    }
+    transform.planar( inC1, inC2, inC3, outC1, outC2, outC3 );
+}
 
-    if ( itTransform == s_csTransformMap.end() )
+void transformColorSpace(ColorSpace inCS, const Array2Df *inC1, const Array2Df *inC2, const Array2Df *inC3,
+                         ColorSpace outCS, uint8_t *out)
+{
+    assert( inC1->size() == inC2->size() && inC2->size() == inC3->size() );
+
+    findTransform(inCS, outCS).interleaved8( inC1, inC2, inC3, out );
+}
+
+void transformColorSpace(ColorSpace inCS, const Array2Df *inC1, const Array2Df *inC2, const Array2Df *inC3,
+                         ColorSpace outCS, uint16_t *out)
+{
+    assert( inC1->size() == inC2->size() && inC2->size() == inC3->size() );
+
+    findTransform(inCS, outCS).interleaved16( inC1, inC2, inC3, out );
+}
+
+void transformColorSpace(ColorSpace inCS,
+                         TiledArray2Df *C1, TiledArray2Df *C2, TiledArray2Df *C3,
+                         ColorSpace outCS)
+{
+    assert( C1->getCols() == C2->getCols() && C2->getCols() == C3->getCols() );
+    assert( C1->getRows() == C2->getRows() && C2->getRows() == C3->getRows() );
+    assert( C1->getStripRows() == C2->getStripRows() &&
+            C2->getStripRows() == C3->getStripRows() );
+
+    const CSTransform& transform = findTransform(inCS, outCS);
+    if ( inCS == outCS ) return;
+
+    const int numStrips = C1->getStripCount();
+#pragma omp parallel for schedule(dynamic)
+    for (int s = 0; s < numStrips; ++s)
     {
-        throw Exception( "Unsupported color tranform" );
+        TiledArray2Df::Strip S1(C1->strip(s));
+        TiledArray2Df::Strip S2(C2->strip(s));
+        TiledArray2Df::Strip S3(C3->strip(s));
+
+        transform.buffers( S1.data(), S2.data(), S3.data(), S1.size(),
+                           S1.data(), S2.data(), S3.data() );
     }
-#ifndef NDEBUG
-    std::cerr << __FUNCTION__ << ": Found right match for colorspace conversion\n";
-#endif
-    // CSTransformFunc func =
-    (itTransform->second)( inC1, inC2, inC3, outC1, outC2, outC3 );
 }
+
 } // namespace pfs
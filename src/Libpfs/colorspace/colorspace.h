@@ -32,11 +32,13 @@
 #ifndef COLORSPACE_H
 #define COLORSPACE_H
 
+#include <stdint.h>
 #include <Libpfs/array2d_fwd.h>
 #include <Libpfs/exception.h>
 
 namespace pfs
 {
+template <typename Type> class TiledArray2D;
 
 //! This enum is used to specify color spaces for transformColorSpace function
 enum ColorSpace
@@ -105,6 +107,27 @@ void transformColorSpace(ColorSpace inCS,
                          ColorSpace outCS,
                          Array2Df *outC1, Array2Df *outC2, Array2Df *outC3 );
 
+//! \brief Transform color channels from one color space into another and
+//! quantise the result in the interleaved buffer \a out (3 samples per
+//! pixel), in a single pass. Converted values are clamped in [0, 1].
+//!
+//! \param out buffer of 3*width*height samples
+//!
+void transformColorSpace(ColorSpace inCS,
+                         const Array2Df *inC1, const Array2Df *inC2, const Array2Df *inC3,
+                         ColorSpace outCS, uint8_t *out);
+
+//! \copydoc transformColorSpace(ColorSpace, const Array2Df*, const Array2Df*, const Array2Df*, ColorSpace, uint8_t*)
+void transformColorSpace(ColorSpace inCS,
+                         const Array2Df *inC1, const Array2Df *inC2, const Array2Df *inC3,
+                         ColorSpace outCS, uint16_t *out);
+
+//! \brief Transform in place the color channels of a tiled image from one
+//! color space into another, one strip at the time
+void transformColorSpace(ColorSpace inCS,
+                         TiledArray2D<float> *C1, TiledArray2D<float> *C2, TiledArray2D<float> *C3,
+                         ColorSpace outCS);
+
 }
 
 #endif // COLORSPACE_H
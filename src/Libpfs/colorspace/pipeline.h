@@ -0,0 +1,74 @@
+/*
+ * This file is a part of Luminance HDR package
+ * ----------------------------------------------------------------------
+ * Copyright (C) 2017 Luminance HDR developers
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+//! \brief Fused colorspace conversion pipeline.
+//!
+//! A conversion is expressed as a chain of triplet functors (decode the
+//! transfer curve, apply a 3x3 matrix, encode the transfer curve, quantise)
+//! that the compiler inlines into a single per-pixel function: the image is
+//! then converted with one parallel pass over memory, without temporaries.
+
+#ifndef PFS_COLORSPACE_PIPELINE_H
+#define PFS_COLORSPACE_PIPELINE_H
+
+#include <cstddef>
+
+namespace pfs {
+namespace colorspace {
+
+//! \brief Identity stage
+struct NoTransform {
+    void operator()(float i1, float i2, float i3,
+                    float& o1, float& o2, float& o3) const;
+};
+
+//! \brief Multiplies the triplet by the matrix \a M. The matrix is a template
+//! argument, so that its coefficients are known at compile time.
+template <const float (&M)[3][3]>
+struct MatrixTransform {
+    void operator()(float i1, float i2, float i3,
+                    float& o1, float& o2, float& o3) const;
+};
+
+//! \brief Clamps the triplet in [0, 1] and quantises it into \a TypeOut
+template <typename TypeOut>
+struct Quantize {
+    void operator()(float i1, float i2, float i3,
+                    TypeOut& o1, TypeOut& o2, TypeOut& o3) const;
+};
+
+//! \brief Number of pixels converted by each parallel block
+const size_t PIPELINE_BLOCK_SIZE = 4096;
+
+//! \brief Runs \a pipeline on \a size pixels of the planar input.
+//! Output samples are \a outStride elements apart, so that the same sweep
+//! fills planar (stride 1) and interleaved (stride 3) buffers.
+//! Input and output may point to the same memory for in-place conversion.
+template <typename TypeOut, typename Pipeline>
+void runPipeline(const float* in1, const float* in2, const float* in3, size_t size,
+                 TypeOut* out1, TypeOut* out2, TypeOut* out3, size_t outStride,
+                 const Pipeline& pipeline);
+
+}   // colorspace
+}   // pfs
+
+#include <Libpfs/colorspace/pipeline.hxx>
+#endif // PFS_COLORSPACE_PIPELINE_H
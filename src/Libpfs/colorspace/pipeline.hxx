@@ -0,0 +1,90 @@
+/*
+ * This file is a part of Luminance HDR package
+ * ----------------------------------------------------------------------
+ * Copyright (C) 2017 Luminance HDR developers
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+//! \brief Fused colorspace conversion pipeline
+
+#ifndef PFS_COLORSPACE_PIPELINE_HXX
+#define PFS_COLORSPACE_PIPELINE_HXX
+
+#include <Libpfs/colorspace/pipeline.h>
+#include <Libpfs/colorspace/convert.h>
+#include <Libpfs/utils/clamp.h>
+
+#include <algorithm>
+
+namespace pfs {
+namespace colorspace {
+
+inline
+void NoTransform::operator()(float i1, float i2, float i3,
+                             float& o1, float& o2, float& o3) const
+{
+    o1 = i1;
+    o2 = i2;
+    o3 = i3;
+}
+
+template <const float (&M)[3][3]>
+inline
+void MatrixTransform<M>::operator()(float i1, float i2, float i3,
+                                    float& o1, float& o2, float& o3) const
+{
+    o1 = M[0][0]*i1 + M[0][1]*i2 + M[0][2]*i3;
+    o2 = M[1][0]*i1 + M[1][1]*i2 + M[1][2]*i3;
+    o3 = M[2][0]*i1 + M[2][1]*i2 + M[2][2]*i3;
+}
+
+template <typename TypeOut>
+inline
+void Quantize<TypeOut>::operator()(float i1, float i2, float i3,
+                                   TypeOut& o1, TypeOut& o2, TypeOut& o3) const
+{
+    o1 = convertSample<TypeOut>(utils::CLAMP_F32(i1));
+    o2 = convertSample<TypeOut>(utils::CLAMP_F32(i2));
+    o3 = convertSample<TypeOut>(utils::CLAMP_F32(i3));
+}
+
+template <typename TypeOut, typename Pipeline>
+void runPipeline(const float* in1, const float* in2, const float* in3, size_t size,
+                 TypeOut* out1, TypeOut* out2, TypeOut* out3, size_t outStride,
+                 const Pipeline& pipeline)
+{
+    const int numBlocks = static_cast<int>((size + PIPELINE_BLOCK_SIZE - 1)/PIPELINE_BLOCK_SIZE);
+
+#pragma omp parallel for schedule(static)
+    for (int block = 0; block < numBlocks; ++block)
+    {
+        const size_t begin = block*PIPELINE_BLOCK_SIZE;
+        const size_t end = std::min(begin + PIPELINE_BLOCK_SIZE, size);
+
+        for (size_t idx = begin; idx < end; ++idx)
+        {
+            const size_t outIdx = idx*outStride;
+            pipeline(in1[idx], in2[idx], in3[idx],
+                     out1[outIdx], out2[outIdx], out3[outIdx]);
+        }
+    }
+}
+
+}   // colorspace
+}   // pfs
+
+#endif // PFS_COLORSPACE_PIPELINE_HXX
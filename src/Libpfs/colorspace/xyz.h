@@ -60,6 +60,30 @@ struct ConvertXYZ2SRGB {
                     float& o1, float& o2, float& o3) const;
 };
 
+//! \brief XYZ -> Y u' v' (CIE 1976 UCS chromaticities)
+struct ConvertXYZ2Yuv {
+    void operator()(float i1, float i2, float i3,
+                    float& o1, float& o2, float& o3) const;
+};
+
+//! \brief Y u' v' -> XYZ
+struct ConvertYuv2XYZ {
+    void operator()(float i1, float i2, float i3,
+                    float& o1, float& o2, float& o3) const;
+};
+
+//! \brief XYZ -> Y x y
+struct ConvertXYZ2Yxy {
+    void operator()(float i1, float i2, float i3,
+                    float& o1, float& o2, float& o3) const;
+};
+
+//! \brief Y x y -> XYZ
+struct ConvertYxy2XYZ {
+    void operator()(float i1, float i2, float i3,
+                    float& o1, float& o2, float& o3) const;
+};
+
 }
 }
 
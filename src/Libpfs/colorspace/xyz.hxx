@@ -65,6 +65,50 @@ void ConvertSRGB2Y::operator()(float i1, float i2, float i3, float& o) const
     colorspace::ConvertRGB2Y()(i1, i2, i3, o);
 }
 
+inline
+void ConvertXYZ2Yuv::operator()(float i1, float i2, float i3,
+                                float& o1, float& o2, float& o3) const
+{
+    const float x = i1/(i1 + i2 + i3);
+    const float y = i2/(i1 + i2 + i3);
+
+    o1 = i2;
+    o2 = 4.f*x / (-2.f*x + 12.f*y + 3.f);
+    o3 = 9.f*y / (-2.f*x + 12.f*y + 3.f);
+}
+
+inline
+void ConvertYuv2XYZ::operator()(float i1, float i2, float i3,
+                                float& o1, float& o2, float& o3) const
+{
+    const float x = 9.f*i2 / (6.f*i2 - 16.f*i3 + 12.f);
+    const float y = 4.f*i3 / (6.f*i2 - 16.f*i3 + 12.f);
+
+    o1 = x/y * i1;
+    o2 = i1;
+    o3 = (1.f - x - y)/y * i1;
+}
+
+inline
+void ConvertXYZ2Yxy::operator()(float i1, float i2, float i3,
+                                float& o1, float& o2, float& o3) const
+{
+    const float sum = i1 + i2 + i3;
+
+    o1 = i2;
+    o2 = i1/sum;
+    o3 = i2/sum;
+}
+
+inline
+void ConvertYxy2XYZ::operator()(float i1, float i2, float i3,
+                                float& o1, float& o2, float& o3) const
+{
+    o1 = i2/i3 * i1;
+    o2 = i1;
+    o3 = (1.f - i2 - i3)/i3 * i1;
+}
+
 }   // namespace
 }   // pfs
 
@@ -48,6 +48,18 @@ float log_base(float value, float base)
    return (std::log(value) / std::log(base));
 }
 
+// Make and Model are ASCII tags, often padded with blanks or NULs
+std::string trim(const std::string& str)
+{
+    const char* blanks = " \t\r\n";
+    std::string::size_type end = str.find('\0');
+    if (end == std::string::npos) end = str.size();
+    std::string::size_type first = str.find_first_not_of(blanks);
+    if (first == std::string::npos || first >= end) return std::string();
+    std::string::size_type last = str.find_last_not_of(blanks, end - 1);
+    return str.substr(first, last - first + 1);
+}
+
 }
 
 ExifData::ExifData()
@@ -120,6 +132,15 @@ void ExifData::fromFile(const std::string& filename)
             m_EVCompensation = it->toFloat();
         }
 
+        if ((it = exifData.findKey(Exiv2::ExifKey("Exif.Image.Make"))) != exifData.end())
+        {
+            m_cameraMake = trim(it->toString());
+        }
+        if ((it = exifData.findKey(Exiv2::ExifKey("Exif.Image.Model"))) != exifData.end())
+        {
+            m_cameraModel = trim(it->toString());
+        }
+
         // exif orientation --------
         /*
          *           http://jpegclub.org/exif_orientation.html
@@ -211,6 +232,19 @@ bool ExifData::hasExposureValue() const
     return (getExposureValue() != INVALID_EV_VALUE);
 }
 
+const std::string& ExifData::getCameraMake() const
+{
+    return m_cameraMake;
+}
+const std::string& ExifData::getCameraModel() const
+{
+    return m_cameraModel;
+}
+bool ExifData::hasCameraModel() const
+{
+    return !m_cameraModel.empty();
+}
+
 const float& ExifData::getExposureValueCompensation() const
 {
     return m_EVCompensation;
@@ -246,6 +280,8 @@ void ExifData::reset()
     m_FNumber = INVALID_VALUE;
     m_EVCompensation = DEFAULT_EVCOMP;
     m_orientation = 0;
+    m_cameraMake.clear();
+    m_cameraModel.clear();
 }
 
 bool ExifData::isValid() const
@@ -255,6 +291,7 @@ bool ExifData::isValid() const
 
 std::ostream& operator<<(std::ostream& out, const ExifData& exifData)
 {
+    out << "Camera = " << exifData.m_cameraMake << " " << exifData.m_cameraModel << ", ";
     out << "Exposure time = " << exifData.m_exposureTime << ", ";
     out << "F value = " << exifData.m_FNumber << ", ";
     out << "ISO = " << exifData.m_isoSpeed << ", ";
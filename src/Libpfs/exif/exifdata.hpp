@@ -64,6 +64,12 @@ public:
     float getExposureValue() const;
     bool hasExposureValue() const;
 
+    //! \brief camera manufacturer (Exif.Image.Make), empty if not available
+    const std::string& getCameraMake() const;
+    //! \brief camera model (Exif.Image.Model), empty if not available
+    const std::string& getCameraModel() const;
+    bool hasCameraModel() const;
+
     const float& getExposureValueCompensation() const;
     bool hasExposureValueCompensation() const;
     void setExposureValueCompensation(float evcomp);
@@ -116,6 +122,8 @@ private:
     float m_FNumber;
     float m_EVCompensation;
     short m_orientation;
+    std::string m_cameraMake;
+    std::string m_cameraModel;
 };
 
 std::ostream& operator<<(std::ostream& out, const ExifData& exifdata);
@@ -0,0 +1,296 @@
+/*
+ * This file is a part of Luminance HDR package
+ * ----------------------------------------------------------------------
+ * Copyright (C) 2017 Luminance HDR developers
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+#include <Libpfs/fftplancache.h>
+#include <Libpfs/exception.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace pfs
+{
+namespace
+{
+//! \brief serializes the calls to the FFTW planner (creation and destruction
+//! of the plans, wisdom), that is shared by all the caches
+boost::mutex& plannerMutex()
+{
+    static boost::mutex s_mutex;
+    return s_mutex;
+}
+
+//! \brief destroys a plan once the cache and all the transforms release it
+struct PlanDeleter
+{
+    void operator()(fftwf_plan p) const
+    {
+        boost::mutex::scoped_lock lock(plannerMutex());
+        fftwf_destroy_plan(p);
+    }
+};
+
+unsigned plannerFlags(FFTPlanCache::PlanningRigor rigor)
+{
+    switch (rigor)
+    {
+    case FFTPlanCache::PLAN_PATIENT:
+        return FFTW_PATIENT;
+    case FFTPlanCache::PLAN_MEASURE:
+        return FFTW_MEASURE;
+    case FFTPlanCache::PLAN_ESTIMATE:
+    default:
+        return FFTW_ESTIMATE;
+    }
+}
+
+// FFTW can execute a plan on new arrays only if they have the same
+// alignment of the arrays used at planning time, which are always aligned
+inline
+bool isAligned(float* in, float* out)
+{
+    return (fftwf_alignment_of(in) == 0 && fftwf_alignment_of(out) == 0);
+}
+
+//! \brief planning buffer, released as soon as the plan is ready
+class ScratchBuffer
+{
+public:
+    explicit ScratchBuffer(size_t size)
+        : m_data(fftwf_alloc_real(size))
+    {}
+
+    ~ScratchBuffer()
+    { fftwf_free(m_data); }
+
+    float* data()
+    { return m_data; }
+
+private:
+    ScratchBuffer(const ScratchBuffer&);
+    ScratchBuffer& operator=(const ScratchBuffer&);
+
+    float* m_data;
+};
+}
+
+bool FFTPlanCache::PlanKey::operator<(const PlanKey& other) const
+{
+    if ( kind != other.kind ) return kind < other.kind;
+    if ( rows != other.rows ) return rows < other.rows;
+    if ( cols != other.cols ) return cols < other.cols;
+    if ( r2rRows != other.r2rRows ) return r2rRows < other.r2rRows;
+    if ( r2rCols != other.r2rCols ) return r2rCols < other.r2rCols;
+    if ( inPlace != other.inPlace ) return inPlace < other.inPlace;
+    return aligned < other.aligned;
+}
+
+FFTPlanCache::FFTPlanCache()
+    : m_rigor(PLAN_ESTIMATE)
+{
+    // constructed first, the planner lock outlives the global cache
+    boost::mutex::scoped_lock lock(plannerMutex());
+    // activate parallel execution of fft routines
+    fftwf_init_threads();
+}
+
+FFTPlanCache::~FFTPlanCache()
+{
+    clearUnlocked();
+}
+
+FFTPlanCache& FFTPlanCache::global()
+{
+    static FFTPlanCache s_cache;
+    return s_cache;
+}
+
+FFTPlanCache::PlanningRigor FFTPlanCache::planningRigor() const
+{
+    boost::mutex::scoped_lock lock(m_mutex);
+    return m_rigor;
+}
+
+void FFTPlanCache::setPlanningRigor(PlanningRigor rigor)
+{
+    boost::mutex::scoped_lock lock(m_mutex);
+    if ( rigor != m_rigor )
+    {
+        clearUnlocked();
+        m_rigor = rigor;
+    }
+}
+
+size_t FFTPlanCache::size() const
+{
+    boost::mutex::scoped_lock lock(m_mutex);
+    return m_plans.size();
+}
+
+void FFTPlanCache::clear()
+{
+    boost::mutex::scoped_lock lock(m_mutex);
+    clearUnlocked();
+}
+
+void FFTPlanCache::clearUnlocked()
+{
+    // plans still executing are destroyed by the last transform using them
+    m_plans.clear();
+}
+
+bool FFTPlanCache::loadWisdom(const std::string& filename)
+{
+    boost::mutex::scoped_lock lock(plannerMutex());
+    return (fftwf_import_wisdom_from_filename(filename.c_str()) != 0);
+}
+
+bool FFTPlanCache::saveWisdom(const std::string& filename) const
+{
+    boost::mutex::scoped_lock lock(plannerMutex());
+    return (fftwf_export_wisdom_to_filename(filename.c_str()) != 0);
+}
+
+FFTPlanCache::PlanPtr FFTPlanCache::plan(const PlanKey& key)
+{
+    boost::mutex::scoped_lock lock(m_mutex);
+
+    PlanMap::const_iterator it = m_plans.find(key);
+    if ( it != m_plans.end() )
+    {
+        return it->second;
+    }
+
+    fftwf_plan p = createPlan(key);
+    if ( p == NULL )
+    {
+        throw pfs::Exception("FFTPlanCache: cannot create FFTW plan");
+    }
+    PlanPtr shared(p, PlanDeleter());
+    m_plans.insert( PlanMap::value_type(key, shared) );
+    return shared;
+}
+
+fftwf_plan FFTPlanCache::createPlan(const PlanKey& key) const
+{
+    boost::mutex::scoped_lock lock(plannerMutex());
+
+#ifdef _OPENMP
+    fftwf_plan_with_nthreads( omp_get_max_threads() );
+#else
+    fftwf_plan_with_nthreads( 2 );
+#endif
+
+    unsigned flags = plannerFlags(m_rigor);
+    if ( !key.aligned )
+    {
+        flags |= FFTW_UNALIGNED;
+    }
+
+    // MEASURE and PATIENT overwrite the arrays while planning, so plans are
+    // always made on private buffers
+    const size_t realSize = static_cast<size_t>(key.rows)*key.cols;
+    const size_t complexSize = static_cast<size_t>(key.rows)*(key.cols/2 + 1);
+
+    switch (key.kind)
+    {
+    case TRANSFORM_R2C:
+    {
+        ScratchBuffer in(key.inPlace ? 2*complexSize : realSize);
+        ScratchBuffer out(key.inPlace ? 0 : 2*complexSize);
+        fftwf_complex* outData = reinterpret_cast<fftwf_complex*>(
+                    key.inPlace ? in.data() : out.data());
+        return fftwf_plan_dft_r2c_2d(key.rows, key.cols, in.data(), outData, flags);
+    }
+    case TRANSFORM_C2R:
+    {
+        ScratchBuffer in(2*complexSize);
+        ScratchBuffer out(key.inPlace ? 0 : realSize);
+        float* outData = key.inPlace ? in.data() : out.data();
+        return fftwf_plan_dft_c2r_2d(key.rows, key.cols,
+                                     reinterpret_cast<fftwf_complex*>(in.data()),
+                                     outData, flags);
+    }
+    case TRANSFORM_R2R_ROWS:
+    {
+        ScratchBuffer in(realSize);
+        ScratchBuffer out(key.inPlace ? 0 : realSize);
+        float* outData = key.inPlace ? in.data() : out.data();
+        const int n[1] = { key.cols };
+        const fftwf_r2r_kind kind[1] = { static_cast<fftwf_r2r_kind>(key.r2rCols) };
+        return fftwf_plan_many_r2r(1, n, key.rows,
+                                   in.data(), NULL, 1, key.cols,
+                                   outData, NULL, 1, key.cols,
+                                   kind, flags);
+    }
+    case TRANSFORM_R2R:
+    default:
+    {
+        ScratchBuffer in(realSize);
+        ScratchBuffer out(key.inPlace ? 0 : realSize);
+        float* outData = key.inPlace ? in.data() : out.data();
+        return fftwf_plan_r2r_2d(key.rows, key.cols, in.data(), outData,
+                                 static_cast<fftwf_r2r_kind>(key.r2rRows),
+                                 static_cast<fftwf_r2r_kind>(key.r2rCols),
+                                 flags);
+    }
+    }
+}
+
+void FFTPlanCache::r2c(int rows, int cols, float* in, fftwf_complex* out)
+{
+    float* outData = reinterpret_cast<float*>(out);
+    PlanKey key = { TRANSFORM_R2C, rows, cols, 0, 0,
+                    in == outData, isAligned(in, outData) };
+    // the plan stays alive until the transform is over, even if cleared
+    const PlanPtr p = plan(key);
+    fftwf_execute_dft_r2c(p.get(), in, out);
+}
+
+void FFTPlanCache::c2r(int rows, int cols, fftwf_complex* in, float* out)
+{
+    float* inData = reinterpret_cast<float*>(in);
+    PlanKey key = { TRANSFORM_C2R, rows, cols, 0, 0,
+                    inData == out, isAligned(inData, out) };
+    const PlanPtr p = plan(key);
+    fftwf_execute_dft_c2r(p.get(), in, out);
+}
+
+void FFTPlanCache::r2r(int rows, int cols,
+                       fftwf_r2r_kind kindRows, fftwf_r2r_kind kindCols,
+                       float* in, float* out)
+{
+    PlanKey key = { TRANSFORM_R2R, rows, cols, kindRows, kindCols,
+                    in == out, isAligned(in, out) };
+    const PlanPtr p = plan(key);
+    fftwf_execute_r2r(p.get(), in, out);
+}
+
+void FFTPlanCache::r2rRows(int rows, int cols, fftwf_r2r_kind kind,
+                           float* in, float* out)
+{
+    PlanKey key = { TRANSFORM_R2R_ROWS, rows, cols, 0, kind,
+                    in == out, isAligned(in, out) };
+    const PlanPtr p = plan(key);
+    fftwf_execute_r2r(p.get(), in, out);
+}
+
+} // namespace pfs
@@ -0,0 +1,147 @@
+/*
+ * This file is a part of Luminance HDR package
+ * ----------------------------------------------------------------------
+ * Copyright (C) 2017 Luminance HDR developers
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+#ifndef PFS_FFTPLANCACHE_H
+#define PFS_FFTPLANCACHE_H
+
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <string>
+#include <type_traits>
+
+#include <boost/thread/mutex.hpp>
+#include <fftw3.h>
+
+//! \file fftplancache.h
+//! \brief Thread-safe cache of FFTW plans shared by the FFT based operators
+
+namespace pfs
+{
+//!
+//! \brief Process-wide store of single precision FFTW plans.
+//!
+//! Plans are created once for every combination of transform kind and size,
+//! and then executed on the buffers supplied by the caller through the FFTW
+//! "new-array execute" interface. Since the creation of a plan is the only
+//! operation of FFTW that is not thread-safe, it is serialized here, so
+//! operators no longer need to lock each other out.
+//!
+//! Plans are made with the chosen \c PlanningRigor: more rigorous planning
+//! is slower the first time a size is seen, but it pays off when many frames
+//! of the same size are processed. The knowledge accumulated by the planner
+//! can be saved to (and restored from) a wisdom file.
+//!
+//! Plans are reference counted: a transform keeps its plan alive while it
+//! runs, so clear() and setPlanningRigor() can be called at any time and
+//! the discarded plans are destroyed as soon as the last transform using
+//! them is over.
+//!
+class FFTPlanCache
+{
+public:
+    enum PlanningRigor
+    {
+        PLAN_ESTIMATE = 0,
+        PLAN_MEASURE,
+        PLAN_PATIENT
+    };
+
+    FFTPlanCache();
+    ~FFTPlanCache();
+
+    //! \brief returns the process-wide cache
+    static FFTPlanCache& global();
+
+    PlanningRigor planningRigor() const;
+    //! \brief changes the planning rigor. Plans made with a different rigor
+    //! are discarded (transforms in flight complete with their old plan)
+    void setPlanningRigor(PlanningRigor rigor);
+
+    //! \brief forward real to complex 2d transform of \a rows x \a cols
+    //! samples. \a out holds \a rows x (\a cols/2 + 1) elements
+    void r2c(int rows, int cols, float* in, fftwf_complex* out);
+    //! \brief backward complex to real 2d transform (unnormalized).
+    //! \note the content of \a in is destroyed
+    void c2r(int rows, int cols, fftwf_complex* in, float* out);
+    //! \brief real to real 2d transform (i.e. FFTW_REDFT00 for a DCT-I)
+    void r2r(int rows, int cols, fftwf_r2r_kind kindRows, fftwf_r2r_kind kindCols,
+             float* in, float* out);
+    //! \brief real to real 1d transform of each of the \a rows rows of
+    //! \a cols samples, executed as a single batched plan
+    void r2rRows(int rows, int cols, fftwf_r2r_kind kind, float* in, float* out);
+
+    //! \brief merges the wisdom stored in \a filename into the planner
+    //! \return false if the file does not exist or is not valid
+    bool loadWisdom(const std::string& filename);
+    //! \brief saves the accumulated wisdom in \a filename
+    bool saveWisdom(const std::string& filename) const;
+
+    //! \brief number of plans currently in the cache
+    size_t size() const;
+    //! \brief discards all the plans (transforms in flight complete with
+    //! the plan they hold)
+    void clear();
+
+private:
+    FFTPlanCache(const FFTPlanCache&);
+    FFTPlanCache& operator=(const FFTPlanCache&);
+
+    enum TransformKind
+    {
+        TRANSFORM_R2C = 0,
+        TRANSFORM_C2R,
+        TRANSFORM_R2R,
+        TRANSFORM_R2R_ROWS
+    };
+
+    struct PlanKey
+    {
+        int kind;
+        int rows;
+        int cols;
+        int r2rRows;
+        int r2rCols;
+        bool inPlace;
+        bool aligned;
+
+        bool operator<(const PlanKey& other) const;
+    };
+
+    //! \brief shared plan, destroyed with the planner lock held
+    typedef std::shared_ptr< std::remove_pointer<fftwf_plan>::type > PlanPtr;
+    typedef std::map<PlanKey, PlanPtr> PlanMap;
+
+    //! \brief returns the plan for \a key, creating it if necessary
+    PlanPtr plan(const PlanKey& key);
+    fftwf_plan createPlan(const PlanKey& key) const;
+    void clearUnlocked();
+
+    //! \brief guards the map and the rigor (the FFTW planner has its own
+    //! process-wide lock)
+    mutable boost::mutex m_mutex;
+    PlanningRigor m_rigor;
+    PlanMap m_plans;
+};
+
+} // namespace pfs
+
+#endif // PFS_FFTPLANCACHE_H
@@ -28,7 +28,9 @@
 
 #include <iostream>
 #include <algorithm>
+#include <list>
 #include <boost/bind.hpp>
+#include <boost/thread/mutex.hpp>
 
 #include "frame.h"
 #include "channel.h"
@@ -37,12 +39,36 @@ using namespace std;
 
 namespace pfs
 {
+namespace
+{
+// histograms kept by each frame, the least recently used are dropped first
+const size_t MAX_CACHED_HISTOGRAMS = 16;
+}
+
+struct Frame::Cache
+{
+    struct HistogramEntry
+    {
+        std::string channel;
+        size_t bins;
+        float min;
+        float max;
+        utils::HistogramScale scale;
+        size_t step;
+        std::shared_ptr<const utils::Histogram> histogram;
+    };
+
+    boost::mutex mutex;
+    std::list<HistogramEntry> histograms;
+};
+
 Frame::Frame(size_t width, size_t height )
     : m_width( width )
     , m_height( height )
     , m_X(NULL)
     , m_Y(NULL)
     , m_Z(NULL)
+    , m_cache(new Cache)
 {}
 
 namespace
@@ -73,6 +99,8 @@ void Frame::resize(size_t width, size_t height)
 
     m_width = width;
     m_height = height;
+
+    invalidateCache();
 }
 
 namespace
@@ -205,6 +233,9 @@ Channel* Frame::createChannel(const string& name)
         m_Z = ch;
     }
 
+    // callers usually overwrite the channel they ask for
+    invalidateCache();
+
     return ch;
 }
 
@@ -226,6 +257,7 @@ void Frame::removeChannel(const string& channel)
         } else if (channel == "Z") {
             m_Z = NULL;
         }
+        invalidateCache();
     }
 }
 
@@ -261,6 +293,51 @@ void Frame::swap(Frame& other)
     swap(m_X, other.m_X);
     swap(m_Y, other.m_Y);
     swap(m_Z, other.m_Z);
+
+    invalidateCache();
+    other.invalidateCache();
+}
+
+std::shared_ptr<const utils::Histogram> Frame::getHistogram(
+        const std::string& name, size_t bins, float min, float max,
+        utils::HistogramScale scale, size_t step) const
+{
+    const Channel* channel = getChannel(name);
+    if ( channel == NULL )
+    {
+        return std::shared_ptr<const utils::Histogram>();
+    }
+
+    boost::mutex::scoped_lock lock(m_cache->mutex);
+    std::list<Cache::HistogramEntry>& entries = m_cache->histograms;
+    for (std::list<Cache::HistogramEntry>::iterator it = entries.begin();
+         it != entries.end(); ++it)
+    {
+        if ( it->channel == name && it->bins == bins && it->min == min &&
+             it->max == max && it->scale == scale && it->step == step )
+        {
+            entries.splice(entries.begin(), entries, it);
+            return entries.front().histogram;
+        }
+    }
+
+    std::shared_ptr<utils::Histogram> histogram(
+                new utils::Histogram(bins, min, max, scale));
+    utils::computeHistogram(*channel, *histogram, step);
+
+    Cache::HistogramEntry entry = { name, bins, min, max, scale, step, histogram };
+    entries.push_front(entry);
+    if ( entries.size() > MAX_CACHED_HISTOGRAMS )
+    {
+        entries.pop_back();
+    }
+    return histogram;
+}
+
+void Frame::invalidateCache()
+{
+    boost::mutex::scoped_lock lock(m_cache->mutex);
+    m_cache->histograms.clear();
 }
 
 } // namespace pfs
@@ -36,6 +36,7 @@
 
 #include <Libpfs/channel.h>
 #include <Libpfs/tag.h>
+#include <Libpfs/utils/histogram.h>
 
 namespace pfs
 {
@@ -129,6 +130,20 @@ public:
 
     void swap(Frame& other);
 
+    //! \brief Histogram of the channel \a name, computed on first use and
+    //! kept until the frame changes. Returns an empty pointer if the channel
+    //! does not exist.
+    //! \note thread safe
+    std::shared_ptr<const utils::Histogram> getHistogram(
+            const std::string& name, size_t bins, float min, float max,
+            utils::HistogramScale scale = utils::HISTOGRAM_LINEAR,
+            size_t step = 1) const;
+
+    //! \brief Drops the data cached from the content of the channels. Code
+    //! changing the channels in place must call it before the frame is
+    //! used again.
+    void invalidateCache();
+
 private:
     size_t m_width;
     size_t m_height;
@@ -140,6 +155,9 @@ private:
     Channel* m_X;
     Channel* m_Y;
     Channel* m_Z;
+
+    struct Cache;
+    std::unique_ptr<Cache> m_cache;
 };
 
 typedef std::shared_ptr< pfs::Frame > FramePtr;
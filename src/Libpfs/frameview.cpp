@@ -0,0 +1,139 @@
+/*
+ * This file is a part of Luminance HDR package
+ * ----------------------------------------------------------------------
+ * Copyright (C) 2017 Luminance HDR developers
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+#include "frameview.h"
+#include "frame.h"
+
+#include <algorithm>
+
+namespace pfs
+{
+
+FrameView::FrameView(size_t width, size_t height)
+    : m_width(width)
+    , m_height(height)
+{}
+
+FrameView::~FrameView()
+{}
+
+namespace
+{
+struct NewChannelView
+{
+    ChannelView* operator()(const std::string& name) const
+    {
+        return new ChannelView(name);
+    }
+};
+}
+
+const ChannelView* FrameView::getChannel(const std::string& name) const
+{
+    return m_channels.get(name);
+}
+
+ChannelView* FrameView::getChannel(const std::string& name)
+{
+    return m_channels.get(name);
+}
+
+ChannelView* FrameView::createChannel(const std::string& name)
+{
+    return m_channels.create(name, NewChannelView());
+}
+
+void FrameView::removeChannel(const std::string& name)
+{
+    m_channels.remove(name);
+}
+
+void FrameView::getXYZChannels(ChannelView* &X, ChannelView* &Y, ChannelView* &Z)
+{
+    m_channels.getXYZ(X, Y, Z);
+}
+
+void FrameView::createXYZChannels(ChannelView* &X, ChannelView* &Y, ChannelView* &Z)
+{
+    m_channels.createXYZ(X, Y, Z, NewChannelView());
+}
+
+void FrameView::adopt(Frame& frame)
+{
+    FrameView temp(frame.getWidth(), frame.getHeight());
+
+    copyTags(frame.getTags(), temp.m_tags);
+
+    ChannelContainer& channels = frame.getChannels();
+    for (size_t idx = 0; idx < channels.size(); ++idx)
+    {
+        ChannelView* ch = temp.createChannel( channels[idx]->getName() );
+        copyTags(channels[idx]->getTags(), ch->getTags());
+        Array2DViewf view(*channels[idx]);
+        ch->setView(view);
+    }
+
+    swap(temp);
+}
+
+void FrameView::copyTo(Frame& frame) const
+{
+    Frame temp(m_width, m_height);
+
+    copyTags(m_tags, temp.getTags());
+    const ChannelViewContainer& channels = getChannels();
+    for (size_t idx = 0; idx < channels.size(); ++idx)
+    {
+        Channel* ch = temp.createChannel( channels[idx]->getName() );
+        copyTags(channels[idx]->getTags(), ch->getTags());
+        channels[idx]->copyTo( *ch );
+    }
+
+    frame.swap(temp);
+}
+
+void FrameView::moveTo(Frame& frame)
+{
+    Frame temp(m_width, m_height);
+
+    copyTags(m_tags, temp.getTags());
+    ChannelViewContainer& channels = getChannels();
+    for (size_t idx = 0; idx < channels.size(); ++idx)
+    {
+        Channel* ch = temp.createChannel( channels[idx]->getName() );
+        copyTags(channels[idx]->getTags(), ch->getTags());
+        channels[idx]->moveTo( *ch );
+    }
+
+    FrameView empty;
+    swap(empty);
+    frame.swap(temp);
+}
+
+void FrameView::swap(FrameView& other)
+{
+    std::swap(m_width, other.m_width);
+    std::swap(m_height, other.m_height);
+    m_tags.swap(other.m_tags);
+    m_channels.swap(other.m_channels);
+}
+
+} // namespace pfs
@@ -0,0 +1,129 @@
+/*
+ * This file is a part of Luminance HDR package
+ * ----------------------------------------------------------------------
+ * Copyright (C) 2017 Luminance HDR developers
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+//! \brief PFS library - Frame made of copy-on-write channel views
+
+#ifndef PFS_FRAMEVIEW_H
+#define PFS_FRAMEVIEW_H
+
+#include <string>
+#include <vector>
+#include <memory>
+
+#include <Libpfs/array2dview.h>
+#include <Libpfs/channelset.h>
+#include <Libpfs/tag.h>
+
+namespace pfs
+{
+class Frame;
+
+//! \brief Named \c Array2DViewf with associated tags: the view counterpart
+//! of \c Channel
+class ChannelView : public Array2DViewf
+{
+public:
+    explicit ChannelView(const std::string& channelName)
+        : m_name(channelName)
+    {}
+
+    const std::string& getName() const      { return m_name; }
+    size_t getWidth() const                 { return getCols(); }
+    size_t getHeight() const                { return getRows(); }
+
+    TagContainer& getTags()                 { return m_tags; }
+    const TagContainer& getTags() const     { return m_tags; }
+
+    //! \brief replaces the data of the channel with \a view (no copy: \a view
+    //! receives the previous content of the channel)
+    void setView(Array2DViewf& view)
+    { swap(view); }
+
+private:
+    std::string     m_name;
+    TagContainer    m_tags;
+};
+
+typedef ChannelSet<ChannelView>::Container ChannelViewContainer;
+
+//! \brief Frame whose channels are \c ChannelView, typically pointing inside
+//! a memory mapped file. Loading such a frame costs only page faults, while
+//! channels are copied in memory only when modified.
+//! \note Like \c Array2DView, channels have a single writer: detach them
+//! before modifying them from several threads.
+class FrameView
+{
+public:
+    FrameView(size_t width = 0, size_t height = 0);
+    ~FrameView();
+
+    bool isValid() const {
+        return (getWidth() > 0 && getHeight() > 0);
+    }
+
+    size_t getWidth() const     { return m_width; }
+    size_t getHeight() const    { return m_height; }
+    size_t size() const         { return m_height*m_width; }
+
+    void getXYZChannels(ChannelView* &X, ChannelView* &Y, ChannelView* &Z);
+    void createXYZChannels(ChannelView* &X, ChannelView* &Y, ChannelView* &Z);
+
+    ChannelView* getChannel(const std::string& name);
+    const ChannelView* getChannel(const std::string& name) const;
+
+    //! \brief Creates a named (empty) channel. If the channel already exists,
+    //! returns existing channel.
+    ChannelView* createChannel(const std::string& name);
+    void removeChannel(const std::string& name);
+
+    ChannelViewContainer& getChannels()                 { return m_channels.channels(); }
+    const ChannelViewContainer& getChannels() const     { return m_channels.channels(); }
+
+    TagContainer& getTags()                 { return m_tags; }
+    const TagContainer& getTags() const     { return m_tags; }
+
+    //! \brief takes ownership of the content of \a frame (no copy)
+    void adopt(Frame& frame);
+    //! \brief Makes \a frame a resident copy of this frame
+    void copyTo(Frame& frame) const;
+    //! \brief Moves the content of this frame inside \a frame, leaving this
+    //! frame empty: only the channels still shared with the external storage
+    //! are copied, one at the time
+    void moveTo(Frame& frame);
+
+    void swap(FrameView& other);
+
+private:
+    FrameView(const FrameView&);
+    FrameView& operator=(const FrameView&);
+
+    size_t m_width;
+    size_t m_height;
+
+    TagContainer m_tags;
+    ChannelSet<ChannelView> m_channels;
+};
+
+typedef std::shared_ptr< pfs::FrameView > FrameViewPtr;
+
+} // namespace pfs
+
+#endif // PFS_FRAMEVIEW_H
@@ -36,8 +36,10 @@
 #include <cstdlib>
 #include <iostream>
 #include <string>
+#include <vector>
 
 #include <Libpfs/frame.h>
+#include <Libpfs/tiledframe.h>
 #include <Libpfs/io/ioexception.h>
 #include <Libpfs/io/exrreader.h>
 
@@ -141,44 +143,126 @@ void EXRReader::close()
     setHeight(0);
 }
 
-void EXRReader::read(Frame & frame, const Params &/*params*/)
+namespace {
+TagContainer* channelTags(pfs::Frame& frame, const std::string& name)
 {
-    if ( !isOpen() ) open();
+    pfs::Channel* ch = frame.getChannel( name );
+    return ch ? &ch->getTags() : NULL;
+}
 
-    // helpers...
-    InputFile& file = m_data->file_;
-    Box2i& dtw = m_data->dtw_;
+TagContainer* channelTags(pfs::TiledFrame& frame, const std::string& name)
+{
+    pfs::TiledChannel* ch = frame.getChannel( name );
+    return ch ? &ch->getTags() : NULL;
+}
 
-    pfs::Frame tempFrame( width(), height() );
-    pfs::Channel *X, *Y, *Z;
-    tempFrame.createXYZChannels( X, Y, Z );
+//! \brief copies the string attributes of \a header to the tags of \a frame
+//! and of its channels
+template <typename FrameType>
+void readAttributes(const Header& header, FrameType& frame)
+{
+    for ( Header::ConstIterator it = header.begin(), itEnd = header.end();
+          it != itEnd; ++it )
+    {
+        const char *attribName = it.name();
+        const StringAttribute *attrib =
+                header.findTypedAttribute<StringAttribute>(attribName);
 
-    FrameBuffer frameBuffer;
-    frameBuffer.insert( "R",                                    // name
-                        Slice( FLOAT,                           // type
-                               (char*)(X->data() - dtw.min.x - dtw.min.y * width()),
-                               sizeof(float),                   // xStride
-                               sizeof(float) * width(),         // yStride
-                               1, 1,                            // x/y sampling
-                               0.0));                           // fillValue
+        if ( attrib == NULL ) continue; // Skip if type is not String
 
-    frameBuffer.insert( "G",                                    // name
-                        Slice( FLOAT,                           // type
-                               (char*)(Y->data() - dtw.min.x - dtw.min.y * width()),
-                               sizeof(float),                   // xStride
-                               sizeof(float) * width(),         // yStride
-                               1, 1,                            // x/y sampling
-                               0.0));                           // fillValue
+        // fprintf( stderr, "Tag: %s = %s\n", attribName, attrib->value().c_str() );
+
+        const char *colon = strstr( attribName, ":" );
+        if ( colon == NULL )    // frame tag
+        {
+            frame.getTags().setTag( attribName,
+                                    escapeString(attrib->value()) );
+        }
+        else  // channel tag
+        {
+            std::string channelName = string( attribName, colon-attribName );
+            TagContainer* tags = channelTags( frame, channelName );
+            if ( tags == NULL ) {
+                std::cerr << " Warning! Can not set tag for "
+                          << channelName
+                          << " channel because it does not exist\n";
+            } else {
+                tags->setTag(colon + 1,
+                             escapeString( attrib->value() ));
+            }
+        }
+    }
+}
 
-    frameBuffer.insert( "B",                                    // name
-                        Slice( FLOAT,                           // type
-                               (char*)(Z->data() - dtw.min.x - dtw.min.y * width()),
+//! \brief inserts in \a frameBuffer the slice of the channel \a name, whose
+//! row \a y0 of the data window starts at \a data
+void insertSlice(FrameBuffer& frameBuffer, const char* name, float* data,
+                 const Box2i& dtw, int y0, size_t width)
+{
+    frameBuffer.insert( name,
+                        Slice( FLOAT,
+                               (char*)(data - dtw.min.x - y0 * width),
                                sizeof(float),                   // xStride
-                               sizeof(float) * width(),         // yStride
+                               sizeof(float) * width,           // yStride
                                1, 1,                            // x/y sampling
                                0.0));                           // fillValue
+}
 
+//! \brief reads one row and one column every \a step, decoding only the
+//! line blocks holding the rows needed
+void readSubsampled(InputFile& file, const Box2i& dtw, size_t step,
+                    pfs::Channel* X, pfs::Channel* Y, pfs::Channel* Z)
+{
+    const int width = dtw.max.x - dtw.min.x + 1;
+    std::vector<float> rowBuffer(3*width);
 
+    // a zero yStride makes every row land in the same buffer
+    FrameBuffer frameBuffer;
+    const char* names[] = { "R", "G", "B" };
+    for (int c = 0; c < 3; ++c)
+    {
+        frameBuffer.insert( names[c],
+                            Slice( FLOAT,
+                                   (char*)(rowBuffer.data() + c*width - dtw.min.x),
+                                   sizeof(float), 0,
+                                   1, 1,
+                                   0.0));
+    }
+    file.setFrameBuffer( frameBuffer );
+
+    for (size_t row = 0; row < X->getRows(); ++row)
+    {
+        const int y = dtw.min.y + static_cast<int>(row*step);
+        file.readPixels( y, y );
+
+        for (size_t col = 0; col < X->getCols(); ++col)
+        {
+            (*X)(col, row) = rowBuffer[col*step];
+            (*Y)(col, row) = rowBuffer[width + col*step];
+            (*Z)(col, row) = rowBuffer[2*width + col*step];
+        }
+    }
+}
+}
+
+void EXRReader::read(Frame & frame, const Params &params)
+{
+    if ( !isOpen() ) open();
+
+    // helpers...
+    InputFile& file = m_data->file_;
+    Box2i& dtw = m_data->dtw_;
+
+    const size_t step = previewSubsampling(width(), height(), params);
+
+    pfs::Frame tempFrame( (width() + step - 1)/step, (height() + step - 1)/step );
+    pfs::Channel *X, *Y, *Z;
+    tempFrame.createXYZChannels( X, Y, Z );
+
+    FrameBuffer frameBuffer;
+    insertSlice( frameBuffer, "R", X->data(), dtw, dtw.min.y, width() );
+    insertSlice( frameBuffer, "G", Y->data(), dtw, dtw.min.y, width() );
+    insertSlice( frameBuffer, "B", Z->data(), dtw, dtw.min.y, width() );
 
     // I know I have the channels I need because I have checked that I have the
     // RGB channels. Hence, I don't load any further that that...
@@ -204,41 +288,17 @@ void EXRReader::read(Frame & frame, const Params &/*params*/)
     }
     */
 
-    // Copy attributes to tags
-    for ( Header::ConstIterator it = file.header().begin(), itEnd = file.header().end();
-          it != itEnd; ++it )
-    {
-        const char *attribName = it.name();
-        const StringAttribute *attrib =
-                file.header().findTypedAttribute<StringAttribute>(attribName);
-
-        if ( attrib == NULL ) continue; // Skip if type is not String
-
-        // fprintf( stderr, "Tag: %s = %s\n", attribName, attrib->value().c_str() );
+    readAttributes( file.header(), tempFrame );
 
-        const char *colon = strstr( attribName, ":" );
-        if ( colon == NULL )    // frame tag
-        {
-            tempFrame.getTags().setTag( attribName,
-                                        escapeString(attrib->value()) );
-        }
-        else  // channel tag
-        {
-            std::string channelName = string( attribName, colon-attribName );
-            pfs::Channel *ch = tempFrame.getChannel( channelName );
-            if ( ch == NULL ) {
-                std::cerr << " Warning! Can not set tag for "
-                          << channelName
-                          << " channel because it does not exist\n";
-            } else {
-                ch->getTags().setTag(colon + 1,
-                                     escapeString( attrib->value() ));
-            }
-        }
+    if ( step > 1 )
+    {
+        readSubsampled( file, dtw, step, X, Y, Z );
+    }
+    else
+    {
+        file.setFrameBuffer( frameBuffer );
+        file.readPixels( dtw.min.y, dtw.max.y );
     }
-
-    file.setFrameBuffer( frameBuffer );
-    file.readPixels( dtw.min.y, dtw.max.y );
 
     // Rescale values if WhiteLuminance is present
     if ( hasWhiteLuminance( file.header() ) )
@@ -268,5 +328,68 @@ void EXRReader::read(Frame & frame, const Params &/*params*/)
     frame.swap( tempFrame );
 }
 
+void EXRReader::read(TiledFrame &frame, const Params &params)
+{
+    if ( !isOpen() ) open();
+
+    // previews are small enough to be read in memory
+    if ( previewSubsampling(width(), height(), params) > 1 )
+    {
+        FrameReader::read(frame, params);
+        return;
+    }
+
+    InputFile& file = m_data->file_;
+    const Box2i& dtw = m_data->dtw_;
+
+    pfs::TiledFrame tempFrame( width(), height(), frame.getStripRows(), frame.cache() );
+    pfs::TiledChannel* channels[3];
+    tempFrame.createXYZChannels( channels[0], channels[1], channels[2] );
+
+    readAttributes( file.header(), tempFrame );
+
+    const bool rescale = hasWhiteLuminance( file.header() );
+    const float scaleFactor = rescale ? whiteLuminance( file.header() ) : 1.f;
+
+    // the scanlines of every strip are decoded straight into its tiles
+    const char* names[] = { "R", "G", "B" };
+    for (size_t s = 0; s < channels[0]->getStripCount(); ++s)
+    {
+        const int y0 = dtw.min.y + static_cast<int>(s*tempFrame.getStripRows());
+
+        TiledArray2Df::Strip stripX( channels[0]->strip(s) );
+        TiledArray2Df::Strip stripY( channels[1]->strip(s) );
+        TiledArray2Df::Strip stripZ( channels[2]->strip(s) );
+        float* data[] = { stripX.data(), stripY.data(), stripZ.data() };
+
+        FrameBuffer frameBuffer;
+        for (int c = 0; c < 3; ++c)
+        {
+            insertSlice( frameBuffer, names[c], data[c], dtw, y0, width() );
+        }
+        file.setFrameBuffer( frameBuffer );
+        file.readPixels( y0, y0 + static_cast<int>(stripX.getRows()) - 1 );
+
+        if ( rescale )
+        {
+            for (int c = 0; c < 3; ++c)
+            {
+                for (size_t i = 0; i < stripX.size(); ++i)
+                {
+                    data[c][i] *= scaleFactor;
+                }
+            }
+        }
+    }
+
+    if ( rescale && tempFrame.getTags().getTag("LUMINANCE").empty() )
+    {
+        tempFrame.getTags().setTag("LUMINANCE", "ABSOLUTE");
+    }
+    tempFrame.getTags().setTag( "FILE_NAME", filename() );
+
+    frame.swap( tempFrame );
+}
+
 }   // io
 }   // pfs
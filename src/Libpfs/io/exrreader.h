@@ -37,7 +37,11 @@ public:
 
     void close();
     void open();
+    using FrameReader::read;
     void read(Frame &frame, const Params &params);
+    //! \brief decodes the scanlines straight into the strips of \a frame, so
+    //! that it is never resident as a whole
+    void read(TiledFrame &frame, const Params &params);
 
 protected:
     class EXRReaderData;
@@ -39,6 +39,7 @@ class EXRWriter : public FrameWriter {
 public:
     EXRWriter(const std::string& filename);
 
+    using FrameWriter::write;
     bool write(const Frame &frame, const Params &params);
 };
 
@@ -52,6 +52,7 @@ public:
 
     void open();
     void close();
+    using FrameReader::read;
     void read(Frame &frame, const Params &);
 
 private:
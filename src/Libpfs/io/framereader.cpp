@@ -22,9 +22,13 @@
 #include <Libpfs/io/framereader.h>
 
 #include <Libpfs/frame.h>
+#include <Libpfs/tiledframe.h>
+#include <Libpfs/frameview.h>
 #include <Libpfs/exif/exifdata.hpp>
 #include <Libpfs/manip/rotate.h>
 
+#include <algorithm>
+
 namespace pfs {
 namespace io {
 
@@ -56,5 +60,30 @@ void FrameReader::read(pfs::Frame& frame, const pfs::Params& params)
     }
 }
 
+void FrameReader::read(pfs::TiledFrame& frame, const pfs::Params& params)
+{
+    pfs::Frame resident;
+    read(resident, params);
+    frame.copyFrom(resident);
+}
+
+void FrameReader::read(pfs::FrameView& frame, const pfs::Params& params)
+{
+    pfs::Frame resident;
+    read(resident, params);
+    frame.adopt(resident);
+}
+
+size_t FrameReader::previewSubsampling(size_t width, size_t height,
+                                       const pfs::Params& params)
+{
+    int previewSize = 0;
+    if ( !params.get("preview_size", previewSize) || previewSize <= 0 )
+    {
+        return 1;
+    }
+    return std::max<size_t>(1, std::max(width, height)/previewSize);
+}
+
 }   // io
 }   // pfs
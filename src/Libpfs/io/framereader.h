@@ -32,6 +32,8 @@
 
 namespace pfs {
 class Frame;
+class TiledFrame;
+class FrameView;
 
 namespace io {
 
@@ -48,20 +50,45 @@ public:
     size_t width() const                    { return m_width; }
     //! \brief return the height of the file being read
     size_t height() const                   { return m_height; }
+    //! \brief how the camera samples are stored in the file being read (e.g.
+    //! "JPEG8", "TIFF16", "RAW"). Empty for the formats that are not a camera
+    //! output
+    const std::string& encoding() const     { return m_encoding; }
 
     virtual void open() = 0;
     virtual bool isOpen() const = 0;
     virtual void close() = 0;
+    //! \brief reads the image into \a frame. When \a params holds a positive
+    //! "preview_size" (int), readers able to decode at reduced resolution
+    //! (JPEG, RAW, TIFF, OpenEXR) return an image whose longest side is not
+    //! smaller than it, without decoding the full resolution data. The others
+    //! ignore it
     virtual void read(pfs::Frame& frame, const pfs::Params& params);
+    //! \brief reads the image into the strips of \a frame, which keeps its
+    //! strip height and tile cache. Readers unable to stream decode the whole
+    //! image in memory first and then move it into the strips
+    virtual void read(pfs::TiledFrame& frame, const pfs::Params& params);
+    //! \brief reads the image into \a frame, mapping the file in memory when
+    //! the format allows it (PFS, float TIFF). The other readers decode the
+    //! image in memory and hand it over to \a frame, without copies
+    virtual void read(pfs::FrameView& frame, const pfs::Params& params);
 
 protected:
     void setWidth(size_t width)     { m_width = width; }
     void setHeight(size_t height)   { m_height = height; }
+    void setEncoding(const std::string& encoding) { m_encoding = encoding; }
+
+    //! \brief largest subsampling factor that keeps the longest side of the
+    //! image not smaller than the "preview_size" parameter
+    //! \return 1 if the parameter is not set
+    static size_t previewSubsampling(size_t width, size_t height,
+                                     const pfs::Params& params);
 
 private:
     std::string m_filename;
     size_t m_width;
     size_t m_height;
+    std::string m_encoding;
 };
 
 typedef std::shared_ptr<FrameReader> FrameReaderPtr;
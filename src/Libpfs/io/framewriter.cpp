@@ -21,6 +21,10 @@
 
 #include <Libpfs/io/framewriter.h>
 
+#include <Libpfs/frame.h>
+#include <Libpfs/tiledframe.h>
+#include <Libpfs/frameview.h>
+
 namespace pfs {
 namespace io {
 
@@ -35,6 +39,20 @@ FrameWriter::FrameWriter()
 FrameWriter::~FrameWriter()
 {}
 
+bool FrameWriter::write(const pfs::TiledFrame& frame, const pfs::Params& params)
+{
+    pfs::Frame resident;
+    frame.copyTo(resident);
+    return write(resident, params);
+}
+
+bool FrameWriter::write(const pfs::FrameView& frame, const pfs::Params& params)
+{
+    pfs::Frame resident;
+    frame.copyTo(resident);
+    return write(resident, params);
+}
+
 }   // io
 }   // pfs
 
@@ -33,6 +33,8 @@
 
 namespace pfs {
 class Frame;
+class TiledFrame;
+class FrameView;
 
 namespace io {
 
@@ -44,6 +46,12 @@ public:
     virtual ~FrameWriter();
 
     virtual bool write(const pfs::Frame& frame, const pfs::Params& params) = 0;
+    //! \brief writes the strips of \a frame. Writers unable to stream copy
+    //! the whole image in memory first and then write it
+    virtual bool write(const pfs::TiledFrame& frame, const pfs::Params& params);
+    //! \brief writes the channels of \a frame without detaching them. Writers
+    //! unable to do it copy the whole image in memory first and then write it
+    virtual bool write(const pfs::FrameView& frame, const pfs::Params& params);
 
     const std::string& filename() const
     { return m_filename; }
@@ -34,6 +34,7 @@
 #include <cassert>
 #include <iostream>
 #include <jpeglib.h>
+#include <boost/lexical_cast.hpp>
 
 using namespace pfs;
 
@@ -290,6 +291,7 @@ void JpegReader::open()
 
     setWidth(m_data->cinfo()->image_width);
     setHeight(m_data->cinfo()->image_height);
+    setEncoding("JPEG" + boost::lexical_cast<std::string>(m_data->cinfo()->data_precision));
 }
 
 static
@@ -361,7 +363,7 @@ void read3Components(j_decompress_ptr cinfo, Frame& frame, const Converter& conv
 
     frame.createXYZChannels(red, green, blue);
 
-    std::vector<JSAMPLE> scanLineBuffer(cinfo->image_width * cinfo->num_components);
+    std::vector<JSAMPLE> scanLineBuffer(cinfo->output_width * cinfo->num_components);
     JSAMPROW scanLineBufferArray[1] = { scanLineBuffer.data() };
 
     for (int i = 0; cinfo->output_scanline < cinfo->output_height; ++i)
@@ -369,7 +371,7 @@ void read3Components(j_decompress_ptr cinfo, Frame& frame, const Converter& conv
         jpeg_read_scanlines(cinfo, scanLineBufferArray, 1);
 
         utils::transform(FixedStrideIterator<JSAMPLE*, 3>(scanLineBuffer.data()),
-                         FixedStrideIterator<JSAMPLE*, 3>(scanLineBuffer.data() + cinfo->image_width*3),
+                         FixedStrideIterator<JSAMPLE*, 3>(scanLineBuffer.data() + cinfo->output_width*3),
                          FixedStrideIterator<JSAMPLE*, 3>(scanLineBuffer.data() + 1),
                          FixedStrideIterator<JSAMPLE*, 3>(scanLineBuffer.data() + 2),
                          red->row_begin(i), green->row_begin(i), blue->row_begin(i),
@@ -388,7 +390,7 @@ void read4Components(j_decompress_ptr cinfo, Frame& frame, const Converter& conv
 
     frame.createXYZChannels(red, green, blue);
 
-    std::vector<JSAMPLE> scanLineBuffer(cinfo->image_width * cinfo->num_components);
+    std::vector<JSAMPLE> scanLineBuffer(cinfo->output_width * cinfo->num_components);
     JSAMPROW scanLineBufferArray[1] = { scanLineBuffer.data() };
 
     for (int i = 0; cinfo->output_scanline < cinfo->output_height; ++i)
@@ -396,7 +398,7 @@ void read4Components(j_decompress_ptr cinfo, Frame& frame, const Converter& conv
         jpeg_read_scanlines(cinfo, scanLineBufferArray, 1);
 
         utils::transform(FixedStrideIterator<JSAMPLE*, 4>(scanLineBuffer.data()),               // C
-                         FixedStrideIterator<JSAMPLE*, 4>(scanLineBuffer.data() + cinfo->image_width*4),   // end C
+                         FixedStrideIterator<JSAMPLE*, 4>(scanLineBuffer.data() + cinfo->output_width*4),   // end C
                          FixedStrideIterator<JSAMPLE*, 4>(scanLineBuffer.data() + 1),           // M
                          FixedStrideIterator<JSAMPLE*, 4>(scanLineBuffer.data() + 2),           // Y
                          FixedStrideIterator<JSAMPLE*, 4>(scanLineBuffer.data() + 3),           // K
@@ -409,7 +411,14 @@ void JpegReader::read(Frame &frame, const Params &params)
 {
     try
     {
-        Frame tempFrame(width(), height());
+        // previews are decoded at 1/2, 1/4 or 1/8 of the resolution by
+        // scaling the DCT, without decoding the full image
+        const size_t subsampling = previewSubsampling(width(), height(), params);
+        unsigned int scaleDenom = 1;
+        while ( scaleDenom < 8 && 2*scaleDenom <= subsampling ) scaleDenom *= 2;
+
+        m_data->cinfo()->scale_num = 1;
+        m_data->cinfo()->scale_denom = scaleDenom;
 
         jpeg_start_decompress(m_data->cinfo());
 
@@ -417,8 +426,13 @@ void JpegReader::read(Frame &frame, const Params &params)
         assert( m_data->cinfo()->image_width != 0 );
         assert( m_data->cinfo()->output_height != 0 );
         assert( m_data->cinfo()->output_width != 0 );
-        assert( m_data->cinfo()->image_height == m_data->cinfo()->output_height );
-        assert( m_data->cinfo()->image_width == m_data->cinfo()->output_width );
+        assert( scaleDenom != 1 ||
+                m_data->cinfo()->image_height == m_data->cinfo()->output_height );
+        assert( scaleDenom != 1 ||
+                m_data->cinfo()->image_width == m_data->cinfo()->output_width );
+
+        Frame tempFrame(m_data->cinfo()->output_width,
+                        m_data->cinfo()->output_height);
 
         utils::ScopedCmsTransform xform( getColorSpaceTransform(m_data->cinfo()) );
 
@@ -44,6 +44,7 @@ public:
     void open();
     bool isOpen() const;
     void close();
+    using FrameReader::read;
     void read(Frame &frame, const Params &params);
 
 private:
@@ -51,6 +51,7 @@ public:
     JpegWriter();
     ~JpegWriter();
 
+    using FrameWriter::write;
     //! \brief write a pfs::Frame into file or memory
     bool write(const pfs::Frame& frame, const pfs::Params& params);
 
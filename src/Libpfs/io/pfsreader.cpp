@@ -22,6 +22,9 @@
 #include <Libpfs/io/pfsreader.h>
 #include <Libpfs/io/pfscommon.h>
 #include <Libpfs/frame.h>
+#include <Libpfs/tiledframe.h>
+#include <Libpfs/frameview.h>
+#include <Libpfs/utils/mappedfile.h>
 
 #include <list>
 
@@ -114,20 +117,19 @@ void PfsReader::close()
     m_channelCount = 0;
 }
 
-void PfsReader::read(Frame &frame, const Params &/*params*/)
+namespace
 {
-    if ( !isOpen() ) open();
-
-    Frame tempFrame(width(), height());
-
-    readTags(tempFrame.getTags(), m_file.data());
+template <typename FrameType, typename ChannelType>
+void readHeader(FrameType& frame, FILE* in, size_t channelCount,
+                std::list<ChannelType*>& orderedChannel)
+{
+    readTags(frame.getTags(), in);
 
     // read channel IDs and tags
-    std::list<Channel*> orderedChannel;
-    for ( size_t i = 0; i < m_channelCount; i++ )
+    for ( size_t i = 0; i < channelCount; i++ )
     {
         char channelName[MAX_CHANNEL_NAME+1], *rs;
-        rs = fgets( channelName, MAX_CHANNEL_NAME, m_file.data() );
+        rs = fgets( channelName, MAX_CHANNEL_NAME, in );
         if ( rs == NULL ) {
             throw ReadException( "Corrupted PFS file: missing channel name" );
         }
@@ -139,16 +141,27 @@ void PfsReader::read(Frame &frame, const Params &/*params*/)
         }
 
         channelName[len-1] = 0;
-        Channel *ch = tempFrame.createChannel( channelName );
-        readTags(ch->getTags(), m_file.data());
+        ChannelType *ch = frame.createChannel( channelName );
+        readTags(ch->getTags(), in);
         orderedChannel.push_back( ch );
     }
 
     char buf[5];
-    size_t read = fread( buf, 1, 4, m_file.data() );
+    size_t read = fread( buf, 1, 4, in );
     if ( read == 0 || memcmp( buf, "ENDH", 4 ) ) {
         throw ReadException( "Corrupted PFS file: missing end of header (ENDH) token" );
     }
+}
+}
+
+void PfsReader::read(Frame &frame, const Params &/*params*/)
+{
+    if ( !isOpen() ) open();
+
+    Frame tempFrame(width(), height());
+
+    std::list<Channel*> orderedChannel;
+    readHeader(tempFrame, m_file.data(), m_channelCount, orderedChannel);
 
     //Read channels
     std::list<Channel*>::iterator it;
@@ -156,7 +169,7 @@ void PfsReader::read(Frame &frame, const Params &/*params*/)
     {
         Channel *ch = *it;
         unsigned int size = tempFrame.getWidth()*tempFrame.getHeight();
-        read = fread( ch->data(), sizeof( float ), size, m_file.data() );
+        size_t read = fread( ch->data(), sizeof( float ), size, m_file.data() );
         if ( read != size ) {
             throw ReadException( "Corrupted PFS file: missing channel data" );
         }
@@ -168,5 +181,75 @@ void PfsReader::read(Frame &frame, const Params &/*params*/)
     frame.swap( tempFrame );
 }
 
+void PfsReader::read(TiledFrame &frame, const Params &/*params*/)
+{
+    if ( !isOpen() ) open();
+
+    TiledFrame tempFrame(width(), height(),
+                         frame.getStripRows(), frame.cache());
+
+    std::list<TiledChannel*> orderedChannel;
+    readHeader(tempFrame, m_file.data(), m_channelCount, orderedChannel);
+
+    // channels are stored one after the other, so every channel can be read
+    // straight into its strips, without ever having the whole frame in memory
+    std::list<TiledChannel*>::iterator it;
+    for ( it = orderedChannel.begin(); it != orderedChannel.end(); ++it )
+    {
+        TiledChannel *ch = *it;
+        for ( size_t s = 0; s < ch->getStripCount(); ++s )
+        {
+            TiledArray2Df::Strip strip( ch->strip(s) );
+            size_t read = fread( strip.data(), sizeof( float ), strip.size(), m_file.data() );
+            if ( read != strip.size() ) {
+                throw ReadException( "Corrupted PFS file: missing channel data" );
+            }
+        }
+    }
+
+    frame.swap( tempFrame );
+}
+
+void PfsReader::read(FrameView &frame, const Params &params)
+{
+    if ( !isOpen() ) open();
+
+    FrameView tempFrame(width(), height());
+
+    std::list<ChannelView*> orderedChannel;
+    readHeader(tempFrame, m_file.data(), m_channelCount, orderedChannel);
+
+    const size_t dataOffset = ftell( m_file.data() );
+    const size_t channelSize = tempFrame.size();
+
+    // channels are stored as planar float32 in native order: map them,
+    // unless the header leaves the data misaligned
+    if ( dataOffset % sizeof(float) != 0 )
+    {
+        Frame resident;
+        close();
+        read(resident, params);
+        frame.adopt(resident);
+        return;
+    }
+
+    utils::MappedFilePtr mappedFile( new utils::MappedFile(filename()) );
+    if ( mappedFile->size() < dataOffset + m_channelCount*channelSize*sizeof(float) ) {
+        throw ReadException( "Corrupted PFS file: missing channel data" );
+    }
+
+    const float* data = reinterpret_cast<const float*>(mappedFile->data() + dataOffset);
+
+    std::list<ChannelView*>::iterator it;
+    for ( it = orderedChannel.begin(); it != orderedChannel.end(); ++it )
+    {
+        Array2DViewf view(data, width(), height(), 1, mappedFile);
+        (*it)->setView(view);
+        data += channelSize;
+    }
+
+    frame.swap( tempFrame );
+}
+
 }   // io
 }   // pfs
@@ -34,6 +34,8 @@
 
 namespace pfs {
 class Frame;
+class TiledFrame;
+class FrameView;
 
 namespace io {
 
@@ -48,6 +50,11 @@ public:
     void open();
     void close();
     void read(pfs::Frame &frame, const pfs::Params &);
+    //! \brief reads the file one strip at the time into \a frame (which
+    //! keeps its strip height and tile cache)
+    void read(pfs::TiledFrame &frame, const pfs::Params &);
+    //! \brief maps the channels of the file in memory, without reading them
+    void read(pfs::FrameView &frame, const pfs::Params &);
 
 private:
     utils::ScopedStdIoFile m_file;
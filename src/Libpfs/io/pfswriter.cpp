@@ -21,8 +21,11 @@
 
 #include <cstdio>
 #include <cstdlib>
+#include <vector>
 
 #include <Libpfs/frame.h>
+#include <Libpfs/tiledframe.h>
+#include <Libpfs/frameview.h>
 #include <Libpfs/tag.h>
 #include <Libpfs/io/pfswriter.h>
 #include <Libpfs/io/pfscommon.h>
@@ -43,6 +46,29 @@ void writeTags(const TagContainer& tags, FILE *out)
     }
 }
 
+//! \brief writes the header of the file, shared by \c Frame, \c TiledFrame
+//! and \c FrameView
+template <typename FrameType>
+static void writeHeader(const FrameType& frame, FILE *out)
+{
+    // Write header ID
+    fwrite( PFSFILEID, 1, 5, out );
+
+    fprintf(out, "%d %d" PFSEOL, (int)frame.getWidth(), (int)frame.getHeight());
+    fprintf(out, "%d" PFSEOL, (int)frame.getChannels().size());
+
+    writeTags(frame.getTags(), out);
+
+    // Write channel IDs and tags
+    for (size_t idx = 0; idx < frame.getChannels().size(); ++idx)
+    {
+        fprintf(out, "%s" PFSEOL, frame.getChannels()[idx]->getName().c_str());
+        writeTags(frame.getChannels()[idx]->getTags(), out);
+    }
+
+    fprintf( out, "ENDH");
+}
+
 PfsWriter::PfsWriter(const std::string &filename)
     : FrameWriter(filename)
 {}
@@ -59,38 +85,98 @@ bool PfsWriter::write(const Frame &frame, const Params &/*params*/)
     int old_mode = setmode( fileno( outputStream.data() ), _O_BINARY );
 #endif
 
-    // Write header ID
-    fwrite( PFSFILEID, 1, 5, outputStream.data() );
+    writeHeader(frame, outputStream.data());
 
     const ChannelContainer& channels = frame.getChannels();
 
-    fprintf(outputStream.data(), "%d %d" PFSEOL,
-            (int)frame.getWidth(), (int)frame.getHeight());
-    fprintf(outputStream.data(), "%d" PFSEOL, (int)channels.size());
+    // Write channels
+    for (ChannelContainer::const_iterator it = channels.begin();
+         it != channels.end();
+         ++it)
+    {
+        int size = frame.getWidth()*frame.getHeight();
+        fwrite( (*it)->data(), sizeof( float ), size, outputStream.data() );
+    }
 
-    writeTags(frame.getTags(), outputStream.data());
+    // Very important for pfsoutavi !!!
+    fflush( outputStream.data() );
+#ifdef HAVE_SETMODE
+    setmode( fileno( outputStream.data() ), old_mode );
+#endif
+    return true;
+}
 
-    // Write channel IDs and tags
-    for (ChannelContainer::const_iterator it = channels.begin();
+bool PfsWriter::write(const TiledFrame &frame, const Params &/*params*/)
+{
+    utils::ScopedStdIoFile outputStream(fopen(filename().c_str(), "wb"));
+    if (!outputStream) {
+        throw pfs::io::InvalidFile("PfsWriter: cannot open " + filename());
+    }
+
+#ifdef HAVE_SETMODE
+    // Needed under MS windows (text translation IO for stdin/out)
+    int old_mode = setmode( fileno( outputStream.data() ), _O_BINARY );
+#endif
+
+    writeHeader(frame, outputStream.data());
+
+    // Write channels, one strip at the time
+    const TiledChannelContainer& channels = frame.getChannels();
+    for (TiledChannelContainer::const_iterator it = channels.begin();
          it != channels.end();
          ++it)
     {
-        fprintf(outputStream.data(), "%s" PFSEOL, (*it)->getName().c_str());
-        writeTags((*it)->getTags(), outputStream.data());
+        for (size_t s = 0; s < (*it)->getStripCount(); ++s)
+        {
+            const TiledArray2Df::Strip strip = (*it)->readStrip(s);
+            fwrite( strip.data(), sizeof( float ), strip.size(), outputStream.data() );
+        }
     }
 
-    fprintf( outputStream.data(), "ENDH");
+    fflush( outputStream.data() );
+#ifdef HAVE_SETMODE
+    setmode( fileno( outputStream.data() ), old_mode );
+#endif
+    return true;
+}
 
-    // Write channels
-    for (ChannelContainer::const_iterator it = channels.begin();
+bool PfsWriter::write(const FrameView &frame, const Params &/*params*/)
+{
+    utils::ScopedStdIoFile outputStream(fopen(filename().c_str(), "wb"));
+    if (!outputStream) {
+        throw pfs::io::InvalidFile("PfsWriter: cannot open " + filename());
+    }
+
+#ifdef HAVE_SETMODE
+    // Needed under MS windows (text translation IO for stdin/out)
+    int old_mode = setmode( fileno( outputStream.data() ), _O_BINARY );
+#endif
+
+    writeHeader(frame, outputStream.data());
+
+    // Write channels through the const interface, which never detaches
+    std::vector<float> row(frame.getWidth());
+    const ChannelViewContainer& channels = frame.getChannels();
+    for (ChannelViewContainer::const_iterator it = channels.begin();
          it != channels.end();
          ++it)
     {
-        int size = frame.getWidth()*frame.getHeight();
-        fwrite( (*it)->data(), sizeof( float ), size, outputStream.data() );
+        const ChannelView& channel = **it;
+        if ( channel.isContiguous() )
+        {
+            fwrite( channel.data(), sizeof( float ), channel.size(), outputStream.data() );
+            continue;
+        }
+        for (size_t r = 0; r < channel.getRows(); ++r)
+        {
+            for (size_t c = 0; c < channel.getCols(); ++c)
+            {
+                row[c] = channel(c, r);
+            }
+            fwrite( row.data(), sizeof( float ), row.size(), outputStream.data() );
+        }
     }
 
-    // Very important for pfsoutavi !!!
     fflush( outputStream.data() );
 #ifdef HAVE_SETMODE
     setmode( fileno( outputStream.data() ), old_mode );
@@ -33,6 +33,8 @@
 
 namespace pfs {
 class Frame;
+class TiledFrame;
+class FrameView;
 
 namespace io {
 
@@ -41,6 +43,11 @@ public:
     PfsWriter(const std::string& filename);
 
     bool write(const pfs::Frame& frame, const pfs::Params& params);
+    //! \brief writes the channels of \a frame one strip at the time
+    bool write(const pfs::TiledFrame& frame, const pfs::Params& params);
+    //! \brief writes the channels of \a frame from the view, one row at the
+    //! time when they are not contiguous
+    bool write(const pfs::FrameView& frame, const pfs::Params& params);
 };
 
 } // io
@@ -49,6 +49,7 @@ public:
     PngWriter();
     ~PngWriter();
 
+    using FrameWriter::write;
     bool write(const pfs::Frame& frame, const pfs::Params& params);
 
     size_t getFileSize() const;
@@ -423,6 +423,7 @@ void RAWReader::open()
     }
     setWidth(S.width);
     setHeight(S.height);
+    setEncoding("RAW");
 }
 
 bool RAWReader::isOpen() const
@@ -443,6 +444,9 @@ void RAWReader::read(Frame &frame, const Params &params)
     //std::cout << p << std::endl;
 
     setParams(m_processor, p);
+    // previews skip the demosaicing: every 2x2 block of the sensor becomes
+    // one pixel, at half the resolution
+    OUT.half_size = (previewSubsampling(width(), height(), params) >= 2) ? 1 : 0;
     // m_processor.set_progress_handler(cb, callback_data);
 
     open();
@@ -51,6 +51,7 @@ public:
     bool isOpen() const;
     void close();
 
+    using FrameReader::read;
     void read(Frame &frame, const Params &params);
 
 private:
@@ -28,6 +28,7 @@
 
 #include <Libpfs/frame.h>
 #include <Libpfs/array2d.h>
+#include <Libpfs/tiledframe.h>
 #include <Libpfs/io/rgbereader.h>
 #include <Libpfs/io/rgbecommon.h>
 #include <Libpfs/colorspace/colorspace.h>
@@ -178,6 +179,66 @@ void RLERead(FILE* file, Trgbe* scanline, int size)
 }
 
 
+//! \brief reads the next scanline of the file, using \a scanline (of 4 times
+//! \a width elements) as buffer, and writes it in the rows \a X, \a Y and \a Z
+static void readRadianceScanline(FILE *file, int width, float exposure,
+                                 std::vector<Trgbe>& scanline,
+                                 float* X, float* Y, float* Z)
+{
+    // read rle header
+    Trgbe header[4];
+    if ( fread(header, sizeof(header), 1, file) == sizeof(header) ) {
+        throw pfs::io::ReadException("RGBE: invalid data size");
+    }
+    if ( header[0] != 2 || header[1] != 2 || (header[2]<<8) + header[3] != width )
+    {
+        //--- simple scanline (not rle)
+        size_t rez = fread(scanline.data()+4, sizeof(Trgbe), 4*width-4, file);
+        if ( rez != (size_t)4*width-4 )
+        {
+            throw pfs::Exception( "RGBE: not enough data to read "
+                                  "in the simple format." );
+        }
+        //--- yes, we've read one pixel as a header
+        scanline[0] = header[0];
+        scanline[1] = header[1];
+        scanline[2] = header[2];
+        scanline[3] = header[3];
+
+        //--- write scanline to the image
+        for (int x=0 ; x<width ; ++x)
+        {
+            Trgbe_pixel rgbe;
+            rgbe.r = scanline[4*x+0];
+            rgbe.g = scanline[4*x+1];
+            rgbe.b = scanline[4*x+2];
+            rgbe.e = scanline[4*x+3];
+
+            rgbe2rgb(rgbe, exposure, X[x], Y[x], Z[x]);
+        }
+    }
+    else
+    {
+        //--- rle scanline
+        //--- each channel is encoded separately
+        for (int ch = 0; ch < 4 ; ++ch) {
+            RLERead(file, scanline.data()+width*ch, width);
+        }
+
+        //--- write scanline to the image
+        for (int x = 0; x < width; ++x)
+        {
+            Trgbe_pixel rgbe;
+            rgbe.r = scanline[x+width*0];
+            rgbe.g = scanline[x+width*1];
+            rgbe.b = scanline[x+width*2];
+            rgbe.e = scanline[x+width*3];
+
+            rgbe2rgb(rgbe, exposure, X[x], Y[x], Z[x]);
+        }
+    }
+}
+
 void readRadiance(FILE *file, int width, int height, float exposure,
                   pfs::Array2Df &X, pfs::Array2Df &Y, pfs::Array2Df &Z)
 {
@@ -187,59 +248,29 @@ void readRadiance(FILE *file, int width, int height, float exposure,
 
     for (int y = 0; y < height; ++y)
     {
-        // read rle header
-        Trgbe header[4];
-        if ( fread(header, sizeof(header), 1, file) == sizeof(header) ) {
-            throw pfs::io::ReadException("RGBE: invalid data size");
-        }
-        if ( header[0] != 2 || header[1] != 2 || (header[2]<<8) + header[3] != width )
-        {
-            //--- simple scanline (not rle)
-            size_t rez = fread(scanline.data()+4, sizeof(Trgbe), 4*width-4, file);
-            if ( rez != (size_t)4*width-4 )
-            {
-                //     DEBUG_STR << "RGBE: scanline " << y
-                //           << "(" << (int)rez << "/" << width << ")" <<endl;
-                throw pfs::Exception( "RGBE: not enough data to read "
-                                      "in the simple format." );
-            }
-            //--- yes, we've read one pixel as a header
-            scanline[0] = header[0];
-            scanline[1] = header[1];
-            scanline[2] = header[2];
-            scanline[3] = header[3];
-
-            //--- write scanline to the image
-            for (int x=0 ; x<width ; ++x)
-            {
-                Trgbe_pixel rgbe;
-                rgbe.r = scanline[4*x+0];
-                rgbe.g = scanline[4*x+1];
-                rgbe.b = scanline[4*x+2];
-                rgbe.e = scanline[4*x+3];
+        readRadianceScanline(file, width, exposure, scanline,
+                             X.data() + y*width, Y.data() + y*width,
+                             Z.data() + y*width);
+    }
+}
 
-                rgbe2rgb(rgbe, exposure, X(x,y), Y(x,y), Z(x,y));
-            }
-        }
-        else
-        {
-            //--- rle scanline
-            //--- each channel is encoded separately
-            for (int ch = 0; ch < 4 ; ++ch) {
-                RLERead(file, scanline.data()+width*ch, width);
-            }
+//! \brief same as above, but the scanlines are decoded straight into the
+//! strips of \a X, \a Y and \a Z, so only one strip per channel is pinned
+void readRadiance(FILE *file, int width, float exposure,
+                  pfs::TiledArray2Df &X, pfs::TiledArray2Df &Y, pfs::TiledArray2Df &Z)
+{
+    std::vector<Trgbe> scanline(width*4);
 
-            //--- write scanline to the image
-            for (int x = 0; x < width; ++x)
-            {
-                Trgbe_pixel rgbe;
-                rgbe.r = scanline[x+width*0];
-                rgbe.g = scanline[x+width*1];
-                rgbe.b = scanline[x+width*2];
-                rgbe.e = scanline[x+width*3];
+    for (size_t s = 0; s < X.getStripCount(); ++s)
+    {
+        TiledArray2Df::Strip sX = X.strip(s);
+        TiledArray2Df::Strip sY = Y.strip(s);
+        TiledArray2Df::Strip sZ = Z.strip(s);
 
-                rgbe2rgb(rgbe, exposure, X(x,y), Y(x,y), Z(x,y));
-            }
+        for (size_t r = 0; r < sX.getRows(); ++r)
+        {
+            readRadianceScanline(file, width, exposure, scanline,
+                                 sX[r], sY[r], sZ[r]);
         }
     }
 }
@@ -303,6 +334,26 @@ void RGBEReader::read(Frame &frame, const Params &/*params*/)
     frame.swap( tempFrame );
 }
 
+void RGBEReader::read(TiledFrame &frame, const Params &/*params*/)
+{
+    if ( !isOpen() ) open();
+
+    TiledFrame tempFrame(width(), height(), frame.getStripRows(), frame.cache());
+
+    pfs::TiledChannel *X, *Y, *Z;
+    tempFrame.createXYZChannels(X, Y, Z);
+
+    readRadiance(m_file.data(), width(), m_exposure, *X, *Y, *Z);
+
+    if (m_colorspace == XYZ)
+        pfs::transformColorSpace(pfs::CS_XYZ, X, Y, Z, pfs::CS_RGB);
+
+    tempFrame.getTags().setTag("LUMINANCE", "RELATIVE");
+    tempFrame.getTags().setTag("FILE_NAME", filename());
+
+    frame.swap( tempFrame );
+}
+
 }   // io
 }   // pfs
 
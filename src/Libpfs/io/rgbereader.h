@@ -51,7 +51,10 @@ public:
 
     void open();
     void close();
+    using FrameReader::read;
     void read(pfs::Frame &frame, const pfs::Params &params);
+    //! \brief decodes the scanlines straight into the strips of \a frame
+    void read(pfs::TiledFrame &frame, const pfs::Params &params);
 
 private:
     utils::ScopedStdIoFile m_file;
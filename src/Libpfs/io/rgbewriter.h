@@ -44,6 +44,7 @@ class RGBEWriter : public FrameWriter
 public:
     RGBEWriter(const std::string& filename);
 
+    using FrameWriter::write;
     bool write(const pfs::Frame &frame, const pfs::Params &params);
 };
 
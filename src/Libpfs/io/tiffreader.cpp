@@ -23,6 +23,10 @@
 #include <Libpfs/io/tiffcommon.h>
 
 #include <Libpfs/frame.h>
+#include <Libpfs/frameview.h>
+#include <Libpfs/tiledframe.h>
+#include <Libpfs/exif/exifdata.hpp>
+#include <Libpfs/utils/mappedfile.h>
 #include <Libpfs/fixedstrideiterator.h>
 #include <Libpfs/strideiterator.h>
 
@@ -36,6 +40,7 @@
 
 #include <tiffio.h>
 
+#include <algorithm>
 #include <cmath>
 #include <iostream>
 #include <vector>
@@ -148,7 +153,21 @@ cmsHPROFILE GetTIFFProfile(TIFF* in, uint16 bps)
 namespace pfs {
 namespace io {
 
-struct TiffReaderParams {};
+struct TiffReaderParams
+{
+    TiffReaderParams()
+        : subsampling_(1)
+        , firstRow_(0)
+        , rowCount_(0)
+    {}
+
+    //! \brief only one row and one column every subsampling_ are read
+    uint32 subsampling_;
+    //! \brief first row read, counted among the subsampled ones
+    uint32 firstRow_;
+    //! \brief number of rows read (0 reads up to the last row)
+    uint32 rowCount_;
+};
 
 struct TiffReaderData
 {
@@ -186,9 +205,9 @@ struct TiffReaderData
     inline
     TIFF* handle() { return file_.data(); }
 
-    void read(Frame &frame, const Params& /*params*/)
+    void read(Frame &frame, const TiffReaderParams& params)
     {
-        currentCallback_(this, frame, TiffReaderParams());
+        currentCallback_(this, frame, params);
     }
 
     void initReader()
@@ -216,6 +235,67 @@ struct TiffReaderData
         currentCallback_ = it->second;
     }
 
+    //! \brief maps uncompressed float RGB data straight into \a frame
+    //! \return false if the layout of the file does not allow it
+    bool mapRGBFloat(FrameView& frame, const std::string& filename)
+    {
+        uint16 sampleFormat = SAMPLEFORMAT_UINT;
+        TIFFGetFieldDefaulted(handle(), TIFFTAG_SAMPLEFORMAT, &sampleFormat);
+
+        if ( photometricType_ != PHOTOMETRIC_RGB ||
+             bitsPerSample_ != 32 ||
+             sampleFormat != SAMPLEFORMAT_IEEEFP ||
+             compressionType_ != COMPRESSION_NONE ||
+             hIn_ ||                        // needs a color transform
+             TIFFIsTiled(handle()) ||
+             TIFFIsByteSwapped(handle()) )
+        {
+            return false;
+        }
+
+        // scanlines must be stored one after the other
+        toff_t* stripOffsets = NULL;
+        toff_t* stripByteCounts = NULL;
+        if ( !TIFFGetField(handle(), TIFFTAG_STRIPOFFSETS, &stripOffsets) ||
+             !TIFFGetField(handle(), TIFFTAG_STRIPBYTECOUNTS, &stripByteCounts) )
+        {
+            return false;
+        }
+        const tstrip_t numStrips = TIFFNumberOfStrips(handle());
+        for (tstrip_t s = 1; s < numStrips; ++s)
+        {
+            if ( stripOffsets[s] != stripOffsets[s - 1] + stripByteCounts[s - 1] ) {
+                return false;
+            }
+        }
+
+        const uint64 dataOffset = stripOffsets[0];
+        const uint64 dataSize = uint64(width_)*height_*samplesPerPixel_*sizeof(float);
+        if ( dataOffset % sizeof(float) != 0 ) {
+            return false;
+        }
+
+        utils::MappedFilePtr mappedFile( new utils::MappedFile(filename) );
+        if ( mappedFile->size() < dataOffset + dataSize ) {
+            return false;
+        }
+
+        FrameView tempFrame(width_, height_);
+        ChannelView* channels[3];
+        tempFrame.createXYZChannels(channels[0], channels[1], channels[2]);
+
+        // every channel is a strided view over the interleaved samples
+        const float* data = reinterpret_cast<const float*>(mappedFile->data() + dataOffset);
+        for (int c = 0; c < 3; ++c)
+        {
+            Array2DViewf view(data + c, width_, height_, samplesPerPixel_, mappedFile);
+            channels[c]->setView(view);
+        }
+
+        frame.swap(tempFrame);
+        return true;
+    }
+
     // private stuff...
 private:
     cmsHTRANSFORM getColorSpaceTransform()
@@ -282,26 +362,33 @@ private:
     void doNothing(Frame &/*frame*/, const TiffReaderParams& /*params*/) {}
 
     template <typename InputDataType, typename Converter>
-    void read3Components(Frame& frame, const TiffReaderParams& /*params*/,
+    void read3Components(Frame& frame, const TiffReaderParams& params,
                          const Converter& conv)
     {
         assert(samplesPerPixel_ >= 3);
-        Frame tempFrame(width_, height_);
+        const uint32 step = params.subsampling_;
+        const uint32 width = (width_ + step - 1)/step;
+        const uint32 height = params.rowCount_ ? params.rowCount_
+                                               : (height_ + step - 1)/step - params.firstRow_;
+        const uint32 stride = samplesPerPixel_*step;
+
+        Frame tempFrame(width, height);
 
         pfs::Channel* Xc;
         pfs::Channel* Yc;
         pfs::Channel* Zc;
         tempFrame.createXYZChannels(Xc, Yc, Zc);
 
-        std::vector<InputDataType> tempBuffer(width_*samplesPerPixel_);
-        for (uint32 row = 0; row < height_; row++)
+        std::vector<InputDataType> tempBuffer(width*stride);
+        for (uint32 row = 0; row < height; row++)
         {
-            TIFFReadScanline(handle(), tempBuffer.data(), row);
+            // libtiff seeks over the skipped rows of uncompressed strips
+            TIFFReadScanline(handle(), tempBuffer.data(), (params.firstRow_ + row)*step);
 
-            utils::transform(StrideIterator<InputDataType*>(tempBuffer.data(), samplesPerPixel_),
-                             StrideIterator<InputDataType*>(tempBuffer.data() + width_*samplesPerPixel_, samplesPerPixel_),
-                             StrideIterator<InputDataType*>(tempBuffer.data() + 1, samplesPerPixel_),
-                             StrideIterator<InputDataType*>(tempBuffer.data() + 2, samplesPerPixel_),
+            utils::transform(StrideIterator<InputDataType*>(tempBuffer.data(), stride),
+                             StrideIterator<InputDataType*>(tempBuffer.data() + width*stride, stride),
+                             StrideIterator<InputDataType*>(tempBuffer.data() + 1, stride),
+                             StrideIterator<InputDataType*>(tempBuffer.data() + 2, stride),
                              Xc->row_begin(row),
                              Yc->row_begin(row),
                              Zc->row_begin(row),
@@ -312,27 +399,33 @@ private:
     }
 
     template <typename InputDataType, typename Converter>
-    void read4Components(Frame& frame, const TiffReaderParams& /*params*/,
+    void read4Components(Frame& frame, const TiffReaderParams& params,
                          const Converter& conv)
     {
         assert(samplesPerPixel_ >= 4);
-        Frame tempFrame(width_, height_);
+        const uint32 step = params.subsampling_;
+        const uint32 width = (width_ + step - 1)/step;
+        const uint32 height = params.rowCount_ ? params.rowCount_
+                                               : (height_ + step - 1)/step - params.firstRow_;
+        const uint32 stride = samplesPerPixel_*step;
+
+        Frame tempFrame(width, height);
 
         pfs::Channel* Xc;
         pfs::Channel* Yc;
         pfs::Channel* Zc;
         tempFrame.createXYZChannels(Xc, Yc, Zc);
 
-        std::vector<InputDataType> tempBuffer(width_*samplesPerPixel_);
-        for (uint32 row = 0; row < height_; row++)
+        std::vector<InputDataType> tempBuffer(width*stride);
+        for (uint32 row = 0; row < height; row++)
         {
-            TIFFReadScanline(handle(), tempBuffer.data(), row);
+            TIFFReadScanline(handle(), tempBuffer.data(), (params.firstRow_ + row)*step);
 
-            utils::transform(StrideIterator<InputDataType*>(tempBuffer.data(), samplesPerPixel_),
-                             StrideIterator<InputDataType*>(tempBuffer.data() + width_*samplesPerPixel_, samplesPerPixel_),
-                             StrideIterator<InputDataType*>(tempBuffer.data() + 1, samplesPerPixel_),
-                             StrideIterator<InputDataType*>(tempBuffer.data() + 2, samplesPerPixel_),
-                             StrideIterator<InputDataType*>(tempBuffer.data() + 3, samplesPerPixel_),
+            utils::transform(StrideIterator<InputDataType*>(tempBuffer.data(), stride),
+                             StrideIterator<InputDataType*>(tempBuffer.data() + width*stride, stride),
+                             StrideIterator<InputDataType*>(tempBuffer.data() + 1, stride),
+                             StrideIterator<InputDataType*>(tempBuffer.data() + 2, stride),
+                             StrideIterator<InputDataType*>(tempBuffer.data() + 3, stride),
                              Xc->row_begin(row),
                              Yc->row_begin(row),
                              Zc->row_begin(row),
@@ -461,6 +554,7 @@ void TiffReader::open()
                                      boost::lexical_cast<std::string>(m_data->bitsPerSample_) +
                                      ")");
     }
+    setEncoding("TIFF" + boost::lexical_cast<std::string>(m_data->bitsPerSample_));
 
     // samples per pixel
     if (!TIFFGetField(m_data->handle(), TIFFTAG_SAMPLESPERPIXEL, &m_data->samplesPerPixel_) ) {
@@ -517,9 +611,72 @@ void TiffReader::read(Frame &frame, const Params &params)
         open();
     }
 
-    m_data->read(frame, params);
+    TiffReaderParams p;
+    p.subsampling_ = previewSubsampling(width(), height(), params);
+
+    m_data->read(frame, p);
     FrameReader::read(frame, params);
 }
 
+void TiffReader::read(FrameView &frame, const Params &params)
+{
+    if ( !isOpen() ) {
+        open();
+    }
+
+    // mapped data cannot be rotated
+    pfs::exif::ExifData exifData(filename());
+    if ( exifData.getOrientationDegree() == 0 &&
+         m_data->mapRGBFloat(frame, filename()) )
+    {
+        return;
+    }
+
+    Frame resident;
+    read(resident, params);
+    frame.adopt(resident);
+}
+
+void TiffReader::read(TiledFrame &frame, const Params &params)
+{
+    if ( !isOpen() ) {
+        open();
+    }
+
+    // previews are small, and rotations need the whole image
+    pfs::exif::ExifData exifData(filename());
+    if ( previewSubsampling(width(), height(), params) > 1 ||
+         exifData.getOrientationDegree() != 0 )
+    {
+        FrameReader::read(frame, params);
+        return;
+    }
+
+    TiledFrame tempFrame(width(), height(), frame.getStripRows(), frame.cache());
+    TiledChannel* channels[3];
+    tempFrame.createXYZChannels(channels[0], channels[1], channels[2]);
+
+    // scanlines are decoded one strip at the time, in order, so that
+    // compressed strips of the file are never decoded twice
+    TiffReaderParams p;
+    Frame rows;
+    for (size_t s = 0; s < channels[0]->getStripCount(); ++s)
+    {
+        p.firstRow_ = s*tempFrame.getStripRows();
+        p.rowCount_ = std::min(tempFrame.getStripRows(), height() - p.firstRow_);
+        m_data->read(rows, p);
+
+        Channel* rowChannels[3];
+        rows.getXYZChannels(rowChannels[0], rowChannels[1], rowChannels[2]);
+        for (int c = 0; c < 3; ++c)
+        {
+            TiledArray2Df::Strip strip( channels[c]->strip(s) );
+            std::copy(rowChannels[c]->begin(), rowChannels[c]->end(), strip.data());
+        }
+    }
+
+    frame.swap(tempFrame);
+}
+
 }   // io
 }   // pfs
@@ -29,6 +29,9 @@
 #include <Libpfs/io/ioexception.h>
 
 namespace pfs {
+class FrameView;
+class TiledFrame;
+
 namespace io {
 
 // sort of private implementation for TiffReader
@@ -44,7 +47,15 @@ public:
     bool isOpen() const;
     void close();
 
+    using FrameReader::read;
     void read(Frame &frame, const Params &params);
+    //! \brief maps uncompressed float RGB files in memory, without reading
+    //! them. Any other file is read and then moved inside \a frame
+    void read(FrameView &frame, const Params &params);
+    //! \brief decodes the file one strip of \a frame at the time, so that it
+    //! is never resident as a whole. Previews and rotated images are read in
+    //! memory first
+    void read(TiledFrame &frame, const Params &params);
 
 private:
     std::unique_ptr<TiffReaderData> m_data;
@@ -48,6 +48,7 @@ public:
     TiffWriter(const std::string& filename);
     ~TiffWriter();
 
+    using FrameWriter::write;
     //! \brief write a pfs::Frame into a properly formatted TIFF file
     //!  \c params can take:
     //!   tiff_mode (int): 0 = 8bit uint, 1 = 16bit uint, 2 = 32bit float, 3 = logluv
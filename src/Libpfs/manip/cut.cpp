@@ -37,6 +37,8 @@
 
 #include "Libpfs/utils/msec_timer.h"
 #include "Libpfs/frame.h"
+#include "Libpfs/tiledframe.h"
+#include "Libpfs/frameview.h"
 
 namespace pfs
 {
@@ -87,4 +89,78 @@ pfs::Frame *cut(const pfs::Frame *inFrame,
     return outFrame;
 }
 
+pfs::Frame *cut(const pfs::TiledFrame& inFrame,
+                size_t x_ul, size_t y_ul, size_t x_br, size_t y_br)
+{
+    if (x_br > inFrame.getWidth()) x_br = inFrame.getWidth();
+    if (y_br > inFrame.getHeight()) y_br = inFrame.getHeight();
+
+    pfs::Frame *outFrame = new pfs::Frame((x_br-x_ul), (y_br-y_ul));
+
+    const TiledChannelContainer& channels = inFrame.getChannels();
+    for ( TiledChannelContainer::const_iterator it = channels.begin();
+          it != channels.end();
+          ++it)
+    {
+        const pfs::TiledChannel* inCh = *it;
+
+        pfs::Channel *outCh = outFrame->createChannel(inCh->getName());
+        copyTags(inCh->getTags(), outCh->getTags());
+
+        for (size_t s = inCh->stripOf(y_ul);
+             s < inCh->getStripCount() && s*inCh->getStripRows() < y_br;
+             ++s)
+        {
+            const TiledArray2Df::Strip strip = inCh->readStrip(s);
+            const size_t rBegin = std::max(y_ul, strip.firstRow());
+            const size_t rEnd = std::min(y_br, strip.firstRow() + strip.getRows());
+
+            for (size_t r = rBegin; r < rEnd; ++r)
+            {
+                const float* row = strip[r - strip.firstRow()];
+                std::copy(row + x_ul, row + x_br, outCh->row_begin(r - y_ul));
+            }
+        }
+    }
+
+    copyTags(inFrame.getTags(), outFrame->getTags());
+
+    return outFrame;
+}
+
+pfs::Frame *cut(const pfs::FrameView& inFrame,
+                size_t x_ul, size_t y_ul, size_t x_br, size_t y_br)
+{
+    if (x_br > inFrame.getWidth()) x_br = inFrame.getWidth();
+    if (y_br > inFrame.getHeight()) y_br = inFrame.getHeight();
+
+    pfs::Frame *outFrame = new pfs::Frame((x_br-x_ul), (y_br-y_ul));
+
+    const ChannelViewContainer& channels = inFrame.getChannels();
+    for ( ChannelViewContainer::const_iterator it = channels.begin();
+          it != channels.end();
+          ++it)
+    {
+        const pfs::ChannelView* inCh = *it;
+
+        pfs::Channel *outCh = outFrame->createChannel(inCh->getName());
+        copyTags(inCh->getTags(), outCh->getTags());
+
+        int rEnd = (int)outCh->getRows();
+#pragma omp parallel for shared(rEnd)
+        for (int r = 0; r < rEnd; r++)
+        {
+            Channel::iterator out = outCh->row_begin(r);
+            for (size_t x = x_ul; x < x_br; ++x, ++out)
+            {
+                *out = (*inCh)(x, r + y_ul);
+            }
+        }
+    }
+
+    copyTags(inFrame.getTags(), outFrame->getTags());
+
+    return outFrame;
+}
+
 } // pfs
@@ -34,10 +34,22 @@
 namespace pfs
 {
 class Frame;
+class TiledFrame;
+class FrameView;
 
 Frame *cut(const Frame *inFrame,
            size_t x_ul, size_t y_ul, size_t x_br, size_t y_br);
 
+//! \brief cuts the selection out of \a inFrame into a resident frame, pinning
+//! only the strips overlapping the selection
+Frame *cut(const TiledFrame& inFrame,
+           size_t x_ul, size_t y_ul, size_t x_br, size_t y_br);
+
+//! \brief cuts the selection out of \a inFrame into a resident frame, reading
+//! only the selected pixels of its channels (which are not detached)
+Frame *cut(const FrameView& inFrame,
+           size_t x_ul, size_t y_ul, size_t x_br, size_t y_br);
+
 template <typename Type>
 void cut(const Array2D<Type> *from, Array2D<Type> *to,
          size_t x_ul, size_t y_ul, size_t x_br, size_t y_br);
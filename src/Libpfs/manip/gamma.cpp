@@ -32,8 +32,39 @@
 
 #include "Libpfs/array2d.h"
 #include "Libpfs/frame.h"
+#include "Libpfs/tiledframe.h"
 #include "Libpfs/colorspace/colorspace.h"
 #include "Libpfs/utils/msec_timer.h"
+#include "Libpfs/utils/numeric.h"
+
+namespace
+{
+// x = (x > 0) ? (x*multiplier)^exponent : 0, for a positive multiplier
+void gammaSamples(float* data, size_t size, float exponent, float multiplier)
+{
+    if ( multiplier != 1.0f )
+    {
+        pfs::utils::vsmul(data, multiplier, data, size);
+    }
+    pfs::utils::vpow(data, exponent, data, size);
+}
+
+struct GammaStrip
+{
+    GammaStrip(float exponent, float multiplier)
+        : m_exponent(exponent)
+        , m_multiplier(multiplier)
+    {}
+
+    void operator()(pfs::TiledArray2Df::Strip& strip) const
+    {
+        gammaSamples(strip.data(), strip.size(), m_exponent, m_multiplier);
+    }
+
+    float m_exponent;
+    float m_multiplier;
+};
+}
 
 namespace pfs
 {
@@ -60,21 +91,7 @@ void applyGamma(pfs::Array2Df *array, const float exponent, const float multipli
     f_timer.start();
 #endif
 
-    float* Vin  = array->data();
-
-    int V_ELEMS = array->getRows()*array->getCols();
-#pragma omp parallel for
-    for (int idx = 0; idx < V_ELEMS; idx++)
-    {
-        if (Vin[idx] > 0.0f)
-        {
-            Vin[idx] = powf(Vin[idx]*multiplier, exponent);
-        }
-        else
-        {
-            Vin[idx] = 0.0f;
-        }
-    }
+    gammaSamples(array->data(), array->size(), exponent, multiplier);
 
 #ifdef TIMER_PROFILING
     f_timer.stop_and_update();
@@ -82,5 +99,21 @@ void applyGamma(pfs::Array2Df *array, const float exponent, const float multipli
 #endif
 }
 
+void applyGamma(pfs::TiledFrame* frame, float gamma)
+{
+    if ( gamma == 1.0f ) return;
+
+    pfs::TiledChannel *X, *Y, *Z;
+    frame->getXYZChannels( X, Y, Z );
+
+    applyGamma(X, 1.0f/gamma);
+    applyGamma(Y, 1.0f/gamma);
+    applyGamma(Z, 1.0f/gamma);
+}
+
+void applyGamma(pfs::TiledArray2Df *array, const float exponent, const float multiplier)
+{
+    array->forEachStrip( GammaStrip(exponent, multiplier) );
 }
 
+}
@@ -32,6 +32,8 @@
 namespace pfs
 {
 class Frame;
+class TiledFrame;
+template <typename Type> class TiledArray2D;
 
 //! \brief Apply \c gamma on the input \c frame
 void applyGamma(pfs::Frame* frame, float gamma);
@@ -39,6 +41,12 @@ void applyGamma(pfs::Frame* frame, float gamma);
 //! \brief Apply gamma on the input \c array
 void applyGamma(pfs::Array2Df *array, float exponent, float multiplier = 1.0f);
 
+//! \brief Apply \c gamma on the input \c frame, one strip at the time
+void applyGamma(pfs::TiledFrame* frame, float gamma);
+
+//! \brief Apply gamma on the input \c array, one strip at the time
+void applyGamma(pfs::TiledArray2D<float>* array, float exponent, float multiplier = 1.0f);
+
 }
 
 #endif // PFSGAMMA_H
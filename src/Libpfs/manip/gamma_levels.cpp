@@ -27,6 +27,7 @@
 
 #include "Libpfs/frame.h"
 #include "Libpfs/channel.h"
+#include "Libpfs/tiledframe.h"
 #include "Libpfs/utils/msec_timer.h"
 
 namespace
@@ -82,6 +83,42 @@ inline T clamp(const T& v, const T& lower_bound, const T& upper_bound)
 //    }
 //}
 
+
+void gammaAndLevelsKernel(const float* R_i, const float* G_i, const float* B_i,
+                          float* R_o, float* G_o, float* B_o, int size,
+                          float black_in, float white_in,
+                          float black_out, float white_out,
+                          float gamma)
+{
+    // float exp_gamma = 1.f/gamma;
+#pragma omp parallel for
+    for (int idx = 0; idx < size; ++idx)
+    {
+        float red = R_i[idx];
+        float green = G_i[idx];
+        float blue = B_i[idx];
+
+        float L = 0.2126f * red
+                + 0.7152f * green
+                + 0.0722f * blue; // number between [0..1]
+
+        float c = powf(L, gamma - 1.0f);
+
+        red = (red - black_in) / (white_in - black_in);
+        red *= c;
+
+        green = (green - black_in) / (white_in - black_in);
+        green *= c;
+
+        blue = (blue - black_in) / (white_in - black_in);
+        blue *= c;
+
+        R_o[idx] = clamp(black_out + red * (white_out - black_out), 0.f, 1.f);
+        G_o[idx] = clamp(black_out + green * (white_out - black_out), 0.f, 1.f);
+        B_o[idx] = clamp(black_out + blue * (white_out - black_out), 0.f, 1.f);
+    }
+}
+
 }
 
 namespace pfs
@@ -111,41 +148,10 @@ void gammaAndLevels(pfs::Frame* inFrame,
     inFrame->getXYZChannels( Xc, Yc, Zc );
     assert( Xc != NULL && Yc != NULL && Zc != NULL );
 
-    const float* R_i = Xc->data();
-    const float* G_i = Yc->data();
-    const float* B_i = Zc->data();
-
-    float* R_o = Xc->data();
-    float* G_o = Yc->data();
-    float* B_o = Zc->data();
-
-    // float exp_gamma = 1.f/gamma;
-#pragma omp parallel for
-    for (int idx = 0; idx < outWidth*outHeight; ++idx)
-    {
-        float red = R_i[idx];
-        float green = G_i[idx];
-        float blue = B_i[idx];
-
-        float L = 0.2126f * red
-                + 0.7152f * green
-                + 0.0722f * blue; // number between [0..1]
-
-        float c = powf(L, gamma - 1.0f);
-
-        red = (red - black_in) / (white_in - black_in);
-        red *= c;
-
-        green = (green - black_in) / (white_in - black_in);
-        green *= c;
-
-        blue = (blue - black_in) / (white_in - black_in);
-        blue *= c;
-
-        R_o[idx] = clamp(black_out + red * (white_out - black_out), 0.f, 1.f);
-        G_o[idx] = clamp(black_out + green * (white_out - black_out), 0.f, 1.f);
-        B_o[idx] = clamp(black_out + blue * (white_out - black_out), 0.f, 1.f);
-    }
+    gammaAndLevelsKernel(Xc->data(), Yc->data(), Zc->data(),
+                         Xc->data(), Yc->data(), Zc->data(),
+                         outWidth*outHeight,
+                         black_in, white_in, black_out, white_out, gamma);
 
 #ifdef TIMER_PROFILING
     f_timer.stop_and_update();
@@ -153,4 +159,28 @@ void gammaAndLevels(pfs::Frame* inFrame,
 #endif
 }
 
+void gammaAndLevels(pfs::TiledFrame* inFrame,
+                    float black_in, float white_in,
+                    float black_out, float white_out,
+                    float gamma)
+{
+    pfs::TiledChannel *Xc, *Yc, *Zc;
+    inFrame->getXYZChannels( Xc, Yc, Zc );
+    assert( Xc != NULL && Yc != NULL && Zc != NULL );
+
+    // channels of the same frame share the same strip layout
+    const int numStrips = Xc->getStripCount();
+#pragma omp parallel for schedule(dynamic)
+    for (int s = 0; s < numStrips; ++s)
+    {
+        pfs::TiledArray2Df::Strip X(Xc->strip(s));
+        pfs::TiledArray2Df::Strip Y(Yc->strip(s));
+        pfs::TiledArray2Df::Strip Z(Zc->strip(s));
+
+        gammaAndLevelsKernel(X.data(), Y.data(), Z.data(),
+                             X.data(), Y.data(), Z.data(), X.size(),
+                             black_in, white_in, black_out, white_out, gamma);
+    }
+}
+
 }
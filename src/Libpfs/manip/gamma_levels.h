@@ -25,10 +25,17 @@
 namespace pfs
 {
 class Frame;
+class TiledFrame;
 
 void gammaAndLevels(pfs::Frame* in,
                     float black_in, float white_in,
                     float black_out, float white_out,
                     float gamma = 1.0f);
 
+//! \brief same as above, but processes the frame one strip at the time
+void gammaAndLevels(pfs::TiledFrame* in,
+                    float black_in, float white_in,
+                    float black_out, float white_out,
+                    float gamma = 1.0f);
+
 }
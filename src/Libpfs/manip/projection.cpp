@@ -25,9 +25,12 @@
 #include "projection.h"
 
 #include <boost/math/constants/constants.hpp>
+#include <boost/math/special_functions/fpclassify.hpp>
 
+#include <algorithm>
 #include <cmath>
 #include <cstring>
+#include <vector>
 // #include <stdio.h>
 // #include <stdlib.h>
 
@@ -46,101 +49,104 @@ MirrorBallProjection MirrorBallProjection::singleton(true);
 
 const double EPSILON=1e-7;
 
-class Vector3D
+namespace
 {
-  public:
-  double x, y, z;
-
-  Vector3D(double phi, double theta)
-  {
-    x = cos(phi) * sin(theta);
-    y = sin(phi) * sin(theta);
-    z = cos(theta);
-  }
-
-  Vector3D(double x, double y, double z)
-  {
-    this->x = x;
-    this->y = y;
-    this->z = z;
-
-    normalize();
-  }
+//! \brief Rotation of the environment, with the rotations around the three
+//! axes composed in a single matrix
+class Rotation
+{
+  double m[3][3];
+  bool identity;
 
-  double magnitude(void)
+  public:
+  Rotation(double xRotate, double yRotate, double zRotate)
+    : identity(xRotate == 0 && yRotate == 0 && zRotate == 0)
   {
-    return sqrt( x * x + y * y + z * z );
+    // angles are negated, because we want to rotate the environment
+    // around us, not us within the environment.
+    const double ax = -xRotate * boost::math::double_constants::degree;
+    const double ay = -yRotate * boost::math::double_constants::degree;
+    const double az = -zRotate * boost::math::double_constants::degree;
+
+    const double cx = cos(ax), sx = sin(ax);
+    const double cy = cos(ay), sy = sin(ay);
+    const double cz = cos(az), sz = sin(az);
+
+    // Rz * Ry * Rx: the X rotation is applied first
+    m[0][0] = cz * cy;
+    m[0][1] = cz * sy * sx - sz * cx;
+    m[0][2] = cz * sy * cx + sz * sx;
+    m[1][0] = sz * cy;
+    m[1][1] = sz * sy * sx + cz * cx;
+    m[1][2] = sz * sy * cx - cz * sx;
+    m[2][0] = -sy;
+    m[2][1] = cy * sx;
+    m[2][2] = cy * cx;
   }
 
-  void normalize(void)
+  void apply(Vector3D *directions, size_t n) const
   {
-    double len = magnitude();
+    if ( identity )
+      return;
 
-    x = x / len;
-    y = y / len;
-    z = z / len;
-  }
+    for (size_t i = 0; i < n; ++i)
+    {
+      const Vector3D d = directions[i];
 
-  double dot(Vector3D *v)
-  {
-    return x * v->x + y * v->y + z * v->z;
+      directions[i].x = m[0][0] * d.x + m[0][1] * d.y + m[0][2] * d.z;
+      directions[i].y = m[1][0] * d.x + m[1][1] * d.y + m[1][2] * d.z;
+      directions[i].z = m[2][0] * d.x + m[2][1] * d.y + m[2][2] * d.z;
+    }
   }
+};
 
-  //TODO: optimize rotations by precomputing sines and cosines
-  void rotateX(double angle)
-  {
-    angle *= boost::math::double_constants::degree;
-
-    double c = cos(angle);
-    double s = sin(angle);
-
-    double y2 =  c * y + -s * z;
-    double z2 =  s * y + c * z;
+//! \brief direction of a sample with the longitude in \a column (see
+//! prepareLongitudes()) and the colatitude \a theta, with the pole along y
+inline
+Vector3D sphericalDirection(const Vector3D &column, double theta)
+{
+  const double s = sin(theta);
 
-    y = y2;
-    z = z2;
-  }
+  Vector3D direction;
+  direction.x = column.x * s;
+  direction.y = cos(theta);
+  direction.z = column.z * s;
+  return direction;
+}
 
-  void rotateY(double angle)
+//! \brief cosine and sine of the longitudes of cylindrical and polar
+//! projections, which only depend on u
+void prepareLongitudes(const double *u, size_t n, ColumnTable &table)
+{
+  table.resize(n);
+  for (size_t i = 0; i < n; ++i)
   {
-    angle *= boost::math::double_constants::degree;
-
-    double c = cos(angle);
-    double s = sin(angle);
-
-    double x2 =  c * x + s * z;
-    double z2 = -s * x + c * z;
+    const double phi = (0.75 - u[i]) * boost::math::double_constants::two_pi;
 
-    x = x2;
-    z = z2;
+    table[i].x = cos(phi);
+    table[i].y = 0;
+    table[i].z = sin(phi);
   }
+}
+}
 
-  void rotateZ(double angle)
-  {
-    angle *= boost::math::double_constants::degree;
-
-    double c = cos(angle);
-    double s = sin(angle);
-
-    double x2 =  c * x + -s * y;
-    double y2 =  s * x + c * y;
 
-    x = x2;
-    y = y2;
-  }
-};
+///PROJECTION
+void Projection::prepareColumns(const double *, size_t, ColumnTable &table) const {
+    table.clear();
+}
 
-class Point2D
-{
-  public:
-    double x, y;
+void Projection::uvToDirections(const double *u, size_t n, double v,
+                                const ColumnTable &, Vector3D *directions) const {
+    for (size_t i = 0; i < n; ++i)
+      directions[i] = uvToDirection(u[i], v);
+}
 
-  Point2D(double x, double y)
-  {
-    this->x = x;
-    this->y = y;
-  }
-};
+void Projection::directionsToUV(const Vector3D *directions, size_t n, Point2D *uv) const {
+    for (size_t i = 0; i < n; ++i)
+      uv[i] = directionToUV(directions[i]);
+}
+///END PROJECTION
 
 
 ///PROJECTIONFACTORY
@@ -208,7 +214,7 @@ double MirrorBallProjection::getSizeRatio(void) {
     return 1;
 }
 
-bool MirrorBallProjection::isValidPixel(double u, double v) {
+bool MirrorBallProjection::isValidPixel(double u, double v) const {
     // check if we are not in a boundary region (outside a circle)
     if((u - 0.5) * (u - 0.5) + (v - 0.5) * (v - 0.5) > 0.25)
       return false;
@@ -216,41 +222,42 @@ bool MirrorBallProjection::isValidPixel(double u, double v) {
       return true;
 }
 
-Vector3D* MirrorBallProjection::uvToDirection(double u, double v) {
+Vector3D MirrorBallProjection::uvToDirection(double u, double v) const {
     u = 2 * u - 1;
     v = 2 * v - 1;
 
     double phi = atan2( v, u );
     double theta = 2 * asin( sqrt( u * u + v * v ) );
 
-    Vector3D *direction = new Vector3D(phi, theta);
+    Vector3D direction(phi, theta);
 //     double t;
 
-    direction->y = -direction->y;
+    direction.y = -direction.y;
 
     return direction;
 }
 
-Point2D* MirrorBallProjection::directionToUV(Vector3D *direction) {
+Point2D MirrorBallProjection::directionToUV(const Vector3D& dir) const {
     double u, v;
 
-    direction->y = -direction->y;
+    Vector3D direction(dir);
+    direction.y = -direction.y;
 
-    if(fabs(direction->x) > 0 || fabs(direction->y) > 0)
+    if(fabs(direction.x) > 0 || fabs(direction.y) > 0)
     {
-      double distance = sqrt(direction->x * direction->x + direction->y * direction->y);
+      double distance = sqrt(direction.x * direction.x + direction.y * direction.y);
 
-      double r = 0.5 * (sin(acos(direction->z) / 2)) / distance;
+      double r = 0.5 * (sin(acos(direction.z) / 2)) / distance;
 
-      u = direction->x * r + 0.5;
-      v = direction->y * r + 0.5;
+      u = direction.x * r + 0.5;
+      v = direction.y * r + 0.5;
     }
     else
     {
       u = v = 0.5;
     }
 
-    return new Point2D(u, v);
+    return Point2D(u, v);
 }
 ///END MIRRORBALL
 
@@ -308,7 +315,7 @@ double AngularProjection::getSizeRatio(void) {
     return 1;
 }
 
-bool AngularProjection::isValidPixel(double u, double v) {
+bool AngularProjection::isValidPixel(double u, double v) const {
     // check if we are not in a boundary region (outside a circle)
     if((u - 0.5) * (u - 0.5) + (v - 0.5) * (v - 0.5) > 0.25)
       return false;
@@ -316,7 +323,7 @@ bool AngularProjection::isValidPixel(double u, double v) {
       return true;
 }
 
-Vector3D* AngularProjection::uvToDirection(double u, double v) {
+Vector3D AngularProjection::uvToDirection(double u, double v) const {
     u = 2 * u - 1;
     v = 2 * v - 1;
 
@@ -326,87 +333,82 @@ Vector3D* AngularProjection::uvToDirection(double u, double v) {
     double phi = atan2( v, u );
     double theta = boost::math::double_constants::pi * sqrt( u * u + v * v );
 
-    Vector3D *direction = new Vector3D(phi, theta);
+    Vector3D direction(phi, theta);
 //     double t;
 
-    direction->y = -direction->y;
+    direction.y = -direction.y;
 
     return direction;
 }
 
-Point2D* AngularProjection::directionToUV(Vector3D *direction) {
+Point2D AngularProjection::directionToUV(const Vector3D& dir) const {
     double u, v;
 
-    direction->y = -direction->y;
+    Vector3D direction(dir);
+    direction.y = -direction.y;
 
-    if(fabs(direction->x) > 0 || fabs(direction->y) > 0)
+    if(fabs(direction.x) > 0 || fabs(direction.y) > 0)
     {
-      double distance = sqrt(direction->x * direction->x + direction->y * direction->y);
+      double distance = sqrt(direction.x * direction.x + direction.y * direction.y);
 
-      double r = (boost::math::double_constants::one_div_two_pi) * acos(direction->z) / distance;
+      double r = (boost::math::double_constants::one_div_two_pi) * acos(direction.z) / distance;
 
-      u = direction->x * r + 0.5;
-      v = direction->y * r + 0.5;
+      u = direction.x * r + 0.5;
+      v = direction.y * r + 0.5;
     }
     else
     {
       u = v = 0.5;
     }
 
-    return new Point2D(u, v);
+    return Point2D(u, v);
 }
 ///END ANGULAR
 
 
 ///CYLINDRICAL
-CylindricalProjection::CylindricalProjection(bool initialization) {
+CylindricalProjection::CylindricalProjection(bool initialization)
+    : pole(0, 1, 0)
+    , equator(0, 0, -1)
+    , cross(1, 0, 0)
+{
     name = "cylindrical";
 
     if(initialization)
       ProjectionFactory::registerProjection(name, this->create);
-
-    pole = new Vector3D(0, 1, 0);
-    equator = new Vector3D(0, 0, -1);
-    cross = new Vector3D(1, 0, 0);
 }
 
 Projection* CylindricalProjection::create()  {
     return new CylindricalProjection(false);
 }
 
-CylindricalProjection::~CylindricalProjection() {
-    delete pole;
-    delete equator;
-    delete cross;
-}
-
 double CylindricalProjection::getSizeRatio(void) {
     return 2;
 }
 
-bool CylindricalProjection::isValidPixel(double /*u*/, double /*v*/) {
+bool CylindricalProjection::isValidPixel(double /*u*/, double /*v*/) const {
     return true;
 }
 
-Vector3D* CylindricalProjection::uvToDirection(double u, double v) {
+Vector3D CylindricalProjection::uvToDirection(double u, double v) const {
     u = 0.75 - u;
 
     u *= boost::math::double_constants::two_pi;
 
     v = acos( 1 - 2 * v );
 
-    Vector3D *direction = new Vector3D(u, v);
+    Vector3D direction(u, v);
 
-    double temp = direction->z;
-    direction->z = direction->y;
-    direction->y = temp;
+    double temp = direction.z;
+    direction.z = direction.y;
+    direction.y = temp;
 
     return direction;
 }
 
-Point2D* CylindricalProjection::directionToUV(Vector3D *direction) {
+Point2D CylindricalProjection::directionToUV(const Vector3D& direction) const {
     double u, v;
-    double lat = direction->dot(pole);
+    double lat = direction.dot(pole);
 
     v = ( 1 - lat ) / 2;
 
@@ -414,7 +416,7 @@ Point2D* CylindricalProjection::directionToUV(Vector3D *direction) {
       u = 0;
     else
     {
-      double ratio = equator->dot( direction ) / sin( acos( lat ) );
+      double ratio = equator.dot( direction ) / sin( acos( lat ) );
 
       if(ratio < -1)
         ratio = -1;
@@ -424,7 +426,7 @@ Point2D* CylindricalProjection::directionToUV(Vector3D *direction) {
 
       double lon = acos(ratio) / (boost::math::double_constants::two_pi);
 
-      if(cross->dot(direction) < 0)
+      if(cross.dot(direction) < 0)
         u = lon;
       else
         u = 1 - lon;
@@ -439,59 +441,65 @@ Point2D* CylindricalProjection::directionToUV(Vector3D *direction) {
   //  if ( 0 > v || v >= 1 ) fprintf(stderr, "u: %f (%f,%f,%f)\n", v, direction->x, direction->y, direction->z);
   //  assert ( -0. <= u && u < 1 );
   //  assert ( -0. <= v && v < 1 );
-    return new Point2D(u, v);
+    return Point2D(u, v);
+}
+
+void CylindricalProjection::prepareColumns(const double *u, size_t n, ColumnTable &table) const {
+    prepareLongitudes(u, n, table);
+}
+
+void CylindricalProjection::uvToDirections(const double *, size_t n, double v,
+                                           const ColumnTable &table, Vector3D *directions) const {
+    const double theta = acos( 1 - 2 * v );
+
+    for (size_t i = 0; i < n; ++i)
+      directions[i] = sphericalDirection(table[i], theta);
 }
 ///END CYLINDRICAL
 
 
 ///POLAR
-PolarProjection::PolarProjection(bool initialization) {
+PolarProjection::PolarProjection(bool initialization)
+    : pole(0, 1, 0)
+    , equator(0, 0, -1)
+    , cross(1, 0, 0)
+{
     name = "polar";
 
     if(initialization)
       ProjectionFactory::registerProjection(name, this->create);
-
-    pole = new Vector3D(0, 1, 0);
-    equator = new Vector3D(0, 0, -1);
-    cross = new Vector3D(1, 0, 0);
 }
 
 Projection* PolarProjection::create() {
     return new PolarProjection(false);
 }
 
-PolarProjection::~PolarProjection() {
-    delete pole;
-    delete equator;
-    delete cross;
-}
-
 double PolarProjection::getSizeRatio(void) {
     return 2;
 }
 
-bool PolarProjection::isValidPixel(double /*u*/, double /*v*/) {
+bool PolarProjection::isValidPixel(double /*u*/, double /*v*/) const {
     return true;
 }
 
-Vector3D* PolarProjection::uvToDirection(double u, double v) {
+Vector3D PolarProjection::uvToDirection(double u, double v) const {
     u = 0.75 - u;
 
     u *= boost::math::double_constants::two_pi;
     v *= boost::math::double_constants::pi;
 
-    Vector3D *direction = new Vector3D(u, v);
+    Vector3D direction(u, v);
 
-    double temp = direction->z;
-    direction->z = direction->y;
-    direction->y = temp;
+    double temp = direction.z;
+    direction.z = direction.y;
+    direction.y = temp;
 
     return direction;
 }
 
-Point2D* PolarProjection::directionToUV(Vector3D *direction) {
+Point2D PolarProjection::directionToUV(const Vector3D& direction) const {
     double u, v;
-    double lat = acos(direction->dot(pole));
+    double lat = acos(direction.dot(pole));
 
     v = lat * (1 / boost::math::double_constants::pi);
 
@@ -499,7 +507,7 @@ Point2D* PolarProjection::directionToUV(Vector3D *direction) {
       u = 0;
     else
     {
-      double ratio = equator->dot(direction) / sin(lat);
+      double ratio = equator.dot(direction) / sin(lat);
 
       if(ratio < -1)
         ratio = -1;
@@ -509,7 +517,7 @@ Point2D* PolarProjection::directionToUV(Vector3D *direction) {
 
       double lon = acos(ratio) / (boost::math::double_constants::two_pi);
 
-      if(cross->dot(direction) < 0)
+      if(cross.dot(direction) < 0)
         u = lon;
       else
         u = 1 - lon;
@@ -524,105 +532,157 @@ Point2D* PolarProjection::directionToUV(Vector3D *direction) {
   //  if ( 0 > v || v >= 1 ) fprintf(stderr, "u: %f (%f,%f,%f)\n", v, direction->x, direction->y, direction->z);
   //  assert ( -0. <= u && u < 1 );
   //  assert ( -0. <= v && v < 1 );
-    return new Point2D(u, v);
+    return Point2D(u, v);
 }
-///END POLAR
 
+void PolarProjection::prepareColumns(const double *u, size_t n, ColumnTable &table) const {
+    prepareLongitudes(u, n, table);
+}
 
-void transformArray( const pfs::Array2Df *in, pfs::Array2Df *out, TransformInfo *transformInfo)
-{
-  const double delta = 1. / transformInfo->oversampleFactor;
-  const double offset = 0.5 / transformInfo->oversampleFactor;
-  const double scaler = 1. / ( transformInfo->oversampleFactor * transformInfo->oversampleFactor );
-
-  const int outRows = out->getRows();
-  const int outCols = out->getCols();
-
-  const int inRows = in->getRows();
-  const int inCols = in->getCols();
+void PolarProjection::uvToDirections(const double *, size_t n, double v,
+                                     const ColumnTable &table, Vector3D *directions) const {
+    const double theta = v * boost::math::double_constants::pi;
 
+    for (size_t i = 0; i < n; ++i)
+      directions[i] = sphericalDirection(table[i], theta);
+}
+///END POLAR
 
-  for( int y = 0; y < outRows; y++ )
-    for( int x = 0; x < outCols; x++ ) {
-      double pixVal = 0;
 
-      if( transformInfo->dstProjection->isValidPixel(( x + 0.5 ) / outCols, ( y + 0.5 ) / outCols ) == true )
-      {
-        for( double sy = 0, oy = 0; oy < transformInfo->oversampleFactor; sy += delta, oy++ )
-          for( double sx = 0, ox = 0; ox < transformInfo->oversampleFactor; sx += delta, ox++ )
-          {
-            Vector3D *direction = transformInfo->dstProjection->uvToDirection(
-                ( x + offset + sx ) / outCols, ( y + offset + sy ) / outRows );
+namespace
+{
+inline
+double sample(const pfs::Array2Df &in, const Point2D &uv, bool interpolate)
+{
+  const int inRows = in.getRows();
+  const int inCols = in.getCols();
 
-            if(direction == NULL)
-              continue;
+  const double px = uv.x * inCols;
+  const double py = uv.y * inRows;
 
-            // angles below are negated, because we want to rotate
-            // the environment around us, not us within the environment.
-            if( transformInfo->xRotate != 0 )
-              direction->rotateX( -transformInfo->xRotate );
+  if( interpolate == true )
+  {
+    int ix = (int)floor( px );
+    int iy = (int)floor( py );
+
+    double i = px - ix;
+    double j = py - iy;
+
+    // compute pixel weights for interpolation
+    double w1 = i * j;
+    double w2 = (1 - i) * j;
+    double w3 = (1 - i) * (1 - j);
+    double w4 = i * (1 - j);
+
+    int dx = ix + 1;
+    if(dx >= inCols)
+      dx = inCols - 1;
+
+    int dy = iy + 1;
+    if(dy >= inRows)
+      dy = inRows - 1;
+
+    return w3 * in(ix, iy) +
+           w4 * in(dx, iy) +
+           w1 * in(dx, dy) +
+           w2 * in(ix, dy);
+  }
+  else
+  {
+    int ix = (int)floor(px + 0.5);
+    int iy = (int)floor(py + 0.5);
 
-            if( transformInfo->yRotate != 0 )
-              direction->rotateY( -transformInfo->yRotate );
+    if(ix >= inCols)
+      ix = inCols - 1;
 
-            if( transformInfo->zRotate != 0 )
-              direction->rotateZ( -transformInfo->zRotate );
+    if(iy >= inRows)
+      iy = inRows - 1;
 
-            Point2D *p = transformInfo->srcProjection->directionToUV( direction );
+    return in(ix, iy);
+  }
+}
+}
 
-            p->x *= inCols;
-            p->y *= inRows;
+void transformArray( const pfs::Array2Df *in, pfs::Array2Df *out, TransformInfo *transformInfo)
+{
+  const int oversample = transformInfo->oversampleFactor;
+  const double delta = 1. / oversample;
+  const double offset = 0.5 / oversample;
+  const double scaler = 1. / ( oversample * oversample );
 
-            if( transformInfo->interpolate == true )
-            {
-              int ix = (int)floor( p->x );
-              int iy = (int)floor( p->y );
+  const int outRows = out->getRows();
+  const int outCols = out->getCols();
 
-              double i = p->x - ix;
-              double j = p->y - iy;
+  const Projection *dstProjection = transformInfo->dstProjection;
+  const Projection *srcProjection = transformInfo->srcProjection;
+  const Rotation rotation(transformInfo->xRotate,
+                          transformInfo->yRotate,
+                          transformInfo->zRotate);
+  const bool interpolate = transformInfo->interpolate;
 
-              // compute pixel weights for interpolation
-              double w1 = i * j;
-              double w2 = (1 - i) * j;
-              double w3 = (1 - i) * (1 - j);
-              double w4 = i * (1 - j);
+  // horizontal coordinates of the samples of a row: the same for every row
+  const size_t rowSamples = static_cast<size_t>(outCols) * oversample;
+  std::vector<double> u(rowSamples);
+  for( int x = 0; x < outCols; x++ )
+    for( int ox = 0; ox < oversample; ox++ )
+      u[x * oversample + ox] = ( x + offset + ox * delta ) / outCols;
 
-              int dx = ix + 1;
-              if(dx >= inCols)
-                dx = inCols - 1;
+  ColumnTable columns;
+  dstProjection->prepareColumns(u.data(), rowSamples, columns);
 
-              int dy = iy + 1;
-              if(dy >= inRows)
-                dy = inRows - 1;
+#pragma omp parallel
+  {
+    std::vector<char> valid(outCols);
+    std::vector<double> pixVal(outCols);
+    std::vector<Vector3D> directions(rowSamples);
+    std::vector<Point2D> uv(rowSamples);
 
-              pixVal += w3 * (*in)(ix, iy) +
-                        w4 * (*in)(dx, iy) +
-                        w1 * (*in)(dx, dy) +
-                        w2 * (*in)(ix, dy);
-            }
-            else
-            {
-              int ix = (int)floor(p->x + 0.5);
-              int iy = (int)floor(p->y + 0.5);
+#pragma omp for schedule(dynamic)
+    for( int y = 0; y < outRows; y++ )
+    {
+      bool any = false;
+      for( int x = 0; x < outCols; x++ )
+      {
+        valid[x] = dstProjection->isValidPixel(( x + 0.5 ) / outCols, ( y + 0.5 ) / outCols );
+        any = any || valid[x];
+      }
+      if ( !any )
+        continue;
 
-              if(ix >= inCols)
-                ix = inCols - 1;
+      std::fill(pixVal.begin(), pixVal.end(), 0.);
 
-              if(iy >= inRows)
-                iy = inRows - 1;
+      for( int oy = 0; oy < oversample; oy++ )
+      {
+        dstProjection->uvToDirections(u.data(), rowSamples,
+                                      ( y + offset + oy * delta ) / outRows,
+                                      columns, directions.data());
+        rotation.apply(directions.data(), rowSamples);
+        srcProjection->directionsToUV(directions.data(), rowSamples, uv.data());
 
-              pixVal += (*in)(ix, iy);
-            }
+        for( int x = 0; x < outCols; x++ )
+        {
+          if( !valid[x] )
+            continue;
 
+          for( int ox = 0; ox < oversample; ox++ )
+          {
+            const Point2D &p = uv[x * oversample + ox];
 
-            delete direction;
-            delete p;
+            // oversamples of the pixels on the border of mirrorball and
+            // angular projections fall outside of the sphere
+            if( !boost::math::isfinite(p.x) || !boost::math::isfinite(p.y) )
+              continue;
 
-            (*out)(x,y) = pixVal * scaler;
+            pixVal[x] += sample(*in, p, interpolate);
           }
+        }
+      }
+
+      for( int x = 0; x < outCols; x++ )
+      {
+        if( valid[x] )
+          (*out)(x,y) = pixVal[x] * scaler;
       }
     }
+  }
 }
-
-
-
@@ -29,28 +29,107 @@
 //! \author Giuseppe Rota <grota@users.sourceforge.net>
 //! \author Miloslaw Smyk, <thorgal@wfmh.org.pl>
 
+#include <cmath>
+#include <cstddef>
 #include <map>
 #include <string>
+#include <vector>
 
 #include "Libpfs/array2d_fwd.h"
 
-class Vector3D;
-class Point2D;
+class Vector3D
+{
+  public:
+  double x, y, z;
+
+  Vector3D()
+    : x(0), y(0), z(0)
+  {
+  }
+
+  Vector3D(double phi, double theta)
+  {
+    x = std::cos(phi) * std::sin(theta);
+    y = std::sin(phi) * std::sin(theta);
+    z = std::cos(theta);
+  }
+
+  Vector3D(double x, double y, double z)
+    : x(x), y(y), z(z)
+  {
+    normalize();
+  }
+
+  double magnitude(void) const
+  {
+    return std::sqrt( x * x + y * y + z * z );
+  }
+
+  void normalize(void)
+  {
+    double len = magnitude();
+
+    x = x / len;
+    y = y / len;
+    z = z / len;
+  }
 
+  double dot(const Vector3D& v) const
+  {
+    return x * v.x + y * v.y + z * v.z;
+  }
+};
+
+class Point2D
+{
+  public:
+    double x, y;
+
+  Point2D()
+    : x(0), y(0)
+  {
+  }
+
+  Point2D(double x, double y)
+    : x(x), y(y)
+  {
+  }
+};
+
+//! \brief Terms of the directions that depend only on the horizontal
+//! coordinate, filled by Projection::prepareColumns()
+typedef std::vector<Vector3D> ColumnTable;
+
+//! \brief A projection maps the normalized image coordinates (u, v) to
+//! directions and back. Directions and points are returned by value, and all
+//! the const members can be called concurrently.
 class Projection
 {
   protected:
   const char *name;
   public:
 
-    virtual Vector3D *uvToDirection(double u, double v) = 0;
-    virtual Point2D *directionToUV(Vector3D *direction) = 0;
-    virtual bool isValidPixel(double u, double v) = 0;
+    virtual Vector3D uvToDirection(double u, double v) const = 0;
+    virtual Point2D directionToUV(const Vector3D& direction) const = 0;
+    virtual bool isValidPixel(double u, double v) const = 0;
     virtual double getSizeRatio(void) = 0;
     virtual ~Projection()
     {
     }
 
+    //! \brief precomputes the part of the directions of the samples \a u
+    //! that does not change from row to row. Projections that are not
+    //! separable leave \a table empty.
+    virtual void prepareColumns(const double *u, size_t n, ColumnTable &table) const;
+
+    //! \brief fills \a directions with the directions of the samples
+    //! (u[i], v), with \a table computed by prepareColumns() on the same \a u
+    virtual void uvToDirections(const double *u, size_t n, double v,
+                                const ColumnTable &table, Vector3D *directions) const;
+
+    //! \brief fills \a uv with the coordinates of \a n directions
+    virtual void directionsToUV(const Vector3D *directions, size_t n, Point2D *uv) const;
+
     virtual void setOptions(char *)
     {
     }
@@ -83,9 +162,9 @@ class MirrorBallProjection : public Projection
   static Projection* create();
   const char *getName(void);
   double getSizeRatio(void);
-  bool isValidPixel(double u, double v);
-  Vector3D* uvToDirection(double u, double v);
-  Point2D* directionToUV(Vector3D *direction);
+  bool isValidPixel(double u, double v) const;
+  Vector3D uvToDirection(double u, double v) const;
+  Point2D directionToUV(const Vector3D& direction) const;
 };
 
 class AngularProjection : public Projection
@@ -98,43 +177,47 @@ class AngularProjection : public Projection
   void setOptions(char *opts);
   const char *getName(void);
   double getSizeRatio(void);
-  bool isValidPixel(double u, double v);
-  Vector3D* uvToDirection(double u, double v);
-  Point2D* directionToUV(Vector3D *direction);
+  bool isValidPixel(double u, double v) const;
+  Vector3D uvToDirection(double u, double v) const;
+  Point2D directionToUV(const Vector3D& direction) const;
   void setAngle(double v) {totalAngle=v;}
 };
 
 
 class CylindricalProjection : public Projection
 {
-  Vector3D *pole;
-  Vector3D *equator;
-  Vector3D *cross;
+  Vector3D pole;
+  Vector3D equator;
+  Vector3D cross;
   explicit CylindricalProjection(bool initialization);
   public:
   static CylindricalProjection singleton;
   static Projection* create();
-  ~CylindricalProjection();
   double getSizeRatio(void);
-  bool isValidPixel(double /*u*/, double /*v*/);
-  Vector3D* uvToDirection(double u, double v);
-  Point2D* directionToUV(Vector3D *direction);
+  bool isValidPixel(double /*u*/, double /*v*/) const;
+  Vector3D uvToDirection(double u, double v) const;
+  Point2D directionToUV(const Vector3D& direction) const;
+  void prepareColumns(const double *u, size_t n, ColumnTable &table) const;
+  void uvToDirections(const double *u, size_t n, double v,
+                      const ColumnTable &table, Vector3D *directions) const;
 };
 
 class PolarProjection : public Projection
 {
-  Vector3D *pole;
-  Vector3D *equator;
-  Vector3D *cross;
+  Vector3D pole;
+  Vector3D equator;
+  Vector3D cross;
   explicit PolarProjection(bool initialization);
   public:
   static PolarProjection singleton;
   static Projection* create();
-  ~PolarProjection();
   double getSizeRatio(void);
-  bool isValidPixel(double /*u*/, double /*v*/);
-  Vector3D* uvToDirection(double u, double v);
-  Point2D* directionToUV(Vector3D *direction);
+  bool isValidPixel(double /*u*/, double /*v*/) const;
+  Vector3D uvToDirection(double u, double v) const;
+  Point2D directionToUV(const Vector3D& direction) const;
+  void prepareColumns(const double *u, size_t n, ColumnTable &table) const;
+  void uvToDirections(const double *u, size_t n, double v,
+                      const ColumnTable &table, Vector3D *directions) const;
 };
 
 
@@ -158,6 +241,9 @@ class TransformInfo
   }
 };
 
+//! \brief Resamples \a in, seen through \a transformInfo->srcProjection,
+//! into \a out, seen through \a transformInfo->dstProjection. The rows of
+//! \a out are processed in parallel, a whole row of samples at a time.
 void transformArray( const pfs::Array2Df *in, pfs::Array2Df *out, TransformInfo *transformInfo);
 
 #endif // PFS_PROJECTION_H
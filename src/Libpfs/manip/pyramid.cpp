@@ -0,0 +1,453 @@
+/*
+ * This file is a part of Luminance HDR package
+ * ----------------------------------------------------------------------
+ * Copyright (C) 2017 Luminance HDR developers
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+#include <Libpfs/manip/pyramid.h>
+
+#include <algorithm>
+#include <cassert>
+
+#include <Libpfs/array2d.h>
+#include <Libpfs/utils/simd.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace pfs
+{
+namespace
+{
+// columns of the output processed at once by the vertical pass: the partial
+// sums of a block stay in L1 across the taps
+const size_t BLOCK_COLS = 2048;
+
+// index of the sample \a i of a line of \a size samples, or -1 for a zero
+inline long borderIndex(long i, long size, PyramidBorder border)
+{
+    if ( i >= 0 && i < size ) return i;
+
+    switch (border)
+    {
+    case BORDER_ZERO:
+        return -1;
+    case BORDER_MIRROR:
+    {
+        if ( size == 1 ) return 0;
+        // the reflection is periodic: kernels wider than the line are
+        // reflected more than once
+        const long period = 2*(size - 1);
+        i = (i < 0 ? -i : i) % period;
+        return (i < size) ? i : period - i;
+    }
+    case BORDER_CLAMP:
+    default:
+        return (i < 0) ? 0 : size - 1;
+    }
+}
+
+// sum of the taps at \a index of \a src, skipping the zero border
+inline float filterTaps(const float* src, const long* index,
+                        const float* weights, long taps)
+{
+    float sum = 0.f;
+    for (long i = 0; i < taps; ++i)
+    {
+        if ( index[i] >= 0 ) sum += weights[i]*src[index[i]];
+    }
+    return sum;
+}
+
+PyramidKernel makeKernel(const float* taps, size_t size, int origin)
+{
+    PyramidKernel kernel;
+    kernel.taps.assign(taps, taps + size);
+    kernel.origin = origin;
+    return kernel;
+}
+
+void downsampleFull(size_t inCols, size_t inRows,
+                    const float* inputData, float* outputData)
+{
+    const size_t outRows = inRows / 2;
+    const size_t outCols = inCols / 2;
+
+    const float dx = static_cast<float>(inCols) / outCols;
+    const float dy = static_cast<float>(inRows) / outRows;
+    const float normalize = 1.0f/(dx*dy);
+
+    // New downsampling by Ed Brambley:
+    // Experimental downsampling that assumes pixels are square and
+    // integrates over each new pixel to find the average value of the
+    // underlying pixels.
+    //
+    // Consider the original pixels laid out, and the new (larger)
+    // pixels layed out over the top of them.  Then the new value for
+    // the larger pixels is just the integral over that pixel of what
+    // shows through; i.e., the values of the pixels underneath
+    // multiplied by how much of that pixel is showing.
+    //
+    // (ix1, iy1) is the coordinate of the top left visible pixel.
+    // (ix2, iy2) is the coordinate of the bottom right visible pixel.
+    // (fx1, fy1) is the fraction of the top left pixel showing.
+    // (fx2, fy2) is the fraction of the bottom right pixel showing.
+
+#pragma omp parallel for
+    for (int y = 0; y < static_cast<int>(outRows); y++)
+    {
+        const size_t iy1 = (  y   * inRows) / outRows;
+        const size_t iy2 = ((y+1) * inRows) / outRows;
+        const float fy1 = (iy1+1) - y * dy;
+        const float fy2 = (y+1) * dy - iy2;
+
+        for (size_t x = 0; x < outCols; x++)
+        {
+            const size_t ix1 = (  x   * inCols) / outCols;
+            const size_t ix2 = ((x+1) * inCols) / outCols;
+            const float fx1 = (ix1+1) - x * dx;
+            const float fx2 = (x+1) * dx - ix2;
+
+            float pixVal = 0.0f;
+            float factorx, factory;
+            for (size_t i = iy1; i <= iy2 && i < inRows; i++)
+            {
+                if (i == iy1)
+                    factory = fy1;  // We're just getting the bottom edge of this pixel
+                else if (i == iy2)
+                    factory = fy2;  // We're just gettting the top edge of this pixel
+                else
+                    factory = 1.0f; // We've got the full height of this pixel
+                for (size_t j = ix1; j <= ix2 && j < inCols; j++)
+                {
+                    if (j == ix1)
+                        factorx = fx1;  // We've just got the right edge of this pixel
+                    else if (j == ix2)
+                        factorx = fx2; // We've just got the left edge of this pixel
+                    else
+                        factorx = 1.0f; // We've got the full width of this pixel
+
+                    pixVal += inputData[j + i*inCols] * factorx * factory;
+                }
+            }
+
+            outputData[x + y * outCols] = pixVal * normalize;  // Normalize by the area of the new pixel
+        }
+    }
+}
+
+void downsampleSimple(size_t inCols, size_t inRows,
+                      const float* inputData, float* outputData)
+{
+    const size_t outRows = inRows / 2;
+    const size_t outCols = inCols / 2;
+
+    // Simplified downsampling by Bruce Guenter:
+    //
+    // Follows exactly the same math as the full downsampling above,
+    // except that inRows and inCols are known to be even.  This allows
+    // for all of the boundary cases to be eliminated, reducing the
+    // sampling to a simple average.
+
+#pragma omp parallel for
+    for (int y = 0; y < static_cast<int>(outRows); y++)
+    {
+        const int iy1 = y * 2;
+        const float* datap = inputData + iy1 * inCols;
+        float* resp = outputData + y * outCols;
+
+        for (size_t x = 0; x < outCols; x++)
+        {
+            const size_t ix1 = x*2;
+
+            resp[x] = ( datap[ix1] +
+                        datap[(ix1+1)] +
+                        datap[ix1     + inCols] +
+                        datap[(ix1+1) + inCols]) * 0.25f; // / 4.0f;
+        }
+    }
+}
+
+void upsampleFull(const size_t outCols, const size_t outRows,
+                  const float* inputData, float* outputData)
+{
+    const size_t inRows = outRows/2;
+    const size_t inCols = outCols/2;
+
+    // Transpose of experimental downsampling matrix (theoretically the correct thing to do)
+    const float dx = static_cast<float>(inCols)/outCols;
+    const float dy = static_cast<float>(inRows)/outRows;
+
+    // This gives a genuine upsampling matrix, not the transpose of the downsampling matrix
+    const float factor = 1.0f / (dx*dy);
+    // Theoretically, this should be the best.
+    // const float factor = 1.0f;
+
+#pragma omp parallel for
+    for (int y = 0; y < static_cast<int>(outRows); y++)
+    {
+        const float sy = y * dy;
+        const int iy1 =      (  y   * inRows) / outRows;
+        const int iy2 = std::min(((y+1) * inRows) / outRows, inRows-1);
+
+        for (size_t x = 0; x < outCols; x++)
+        {
+            const float sx = x * dx;
+            const int ix1 =      (  x   * inCols) / outCols;
+            const int ix2 = std::min(((x+1) * inCols) / outCols, inCols-1);
+
+            outputData[x + y*outCols] = (((ix1+1) - sx)*((iy1+1 - sy)) * inputData[ix1 + iy1*inCols] +
+                                         ((ix1+1) - sx)*(sy+dy - (iy1+1)) * inputData[ix1 + iy2*inCols] +
+                                         (sx+dx - (ix1+1))*((iy1+1 - sy)) * inputData[ix2 + iy1*inCols] +
+                                         (sx+dx - (ix1+1))*(sy+dx - (iy1+1)) * inputData[ix2 + iy2*inCols])*factor;
+        }
+    }
+}
+
+void upsampleSimple(const int outCols, const int outRows,
+                    const float* const inputData, float* const outputData)
+{
+#pragma omp parallel for
+    for (int y = 0; y < outRows; y++)
+    {
+        const int iy1 = y / 2;
+        float* outp = outputData + y*outCols;
+        const float* inp = inputData + iy1*(outCols/2);
+        for (int x = 0; x < outCols; x+=2)
+        {
+            const int ix1 = x / 2;
+            outp[x] = outp[x+1] = inp[ix1];
+        }
+    }
+}
+}
+
+PyramidKernel PyramidKernel::binomial()
+{
+    const float taps[] = { 0.25f, 0.5f, 0.25f };
+    return makeKernel(taps, 3, -1);
+}
+
+PyramidKernel PyramidKernel::binomialBox()
+{
+    const float taps[] = { 0.125f, 0.375f, 0.375f, 0.125f };
+    return makeKernel(taps, 4, -1);
+}
+
+PyramidKernel PyramidKernel::burtAdelson(float a)
+{
+    const float taps[] = { 0.25f - a/2.f, 0.25f, a, 0.25f, 0.25f - a/2.f };
+    return makeKernel(taps, 5, -2);
+}
+
+void separableFilter(const Array2Df& in, Array2Df& out,
+                     const PyramidKernel& kernel, PyramidBorder border,
+                     size_t step, size_t dilation, BufferArena* arena)
+{
+    assert( !kernel.taps.empty() );
+    assert( step > 0 && dilation > 0 );
+
+    const long inCols = in.getCols();
+    const long inRows = in.getRows();
+    const long outCols = out.getCols();
+    const long outRows = out.getRows();
+    const long taps = kernel.taps.size();
+    const float* weights = kernel.taps.data();
+    const long origin = kernel.origin*static_cast<long>(dilation);
+    const long stride = step;
+    const long spacing = dilation;
+
+    if ( outCols == 0 || outRows == 0 ) return;
+    if ( inCols == 0 || inRows == 0 )
+    {
+        out.fill(0.f);
+        return;
+    }
+
+    const utils::simd::Kernels& k = utils::simd::kernels();
+
+    // source column of every tap of every output column
+    std::vector<long> colIndex(outCols*taps);
+    for (long x = 0; x < outCols; ++x)
+    {
+        for (long i = 0; i < taps; ++i)
+        {
+            colIndex[x*taps + i] = borderIndex(x*stride + origin + i*spacing,
+                                               inCols, border);
+        }
+    }
+
+    // source row of every tap of every output row
+    std::vector<long> rowIndex(outRows*taps);
+    for (long y = 0; y < outRows; ++y)
+    {
+        for (long i = 0; i < taps; ++i)
+        {
+            rowIndex[y*taps + i] = borderIndex(y*stride + origin + i*spacing,
+                                               inRows, border);
+        }
+    }
+
+    // output columns whose taps are all inside the row: without subsampling
+    // they are filtered with the vector kernels on shifted rows
+    long interiorBegin = 0;
+    long interiorEnd = 0;
+    if ( step == 1 )
+    {
+        interiorBegin = std::min(std::max(-origin, 0L), outCols);
+        interiorEnd = std::max(std::min(inCols - origin - (taps - 1)*spacing,
+                                        outCols),
+                               interiorBegin);
+    }
+
+    // the horizontal pass reads every row of the input before the vertical
+    // pass writes the output, that can then be the input itself
+    Array2Df temp(outCols, inRows, arena, false);
+    float* tempData = temp.data();
+    const float* inData = in.data();
+
+#pragma omp parallel for
+    for (long y = 0; y < inRows; ++y)
+    {
+        const float* src = inData + y*inCols;
+        float* dst = tempData + y*outCols;
+
+        for (long x = 0; x < interiorBegin; ++x)
+        {
+            dst[x] = filterTaps(src, &colIndex[x*taps], weights, taps);
+        }
+        for (long x = interiorEnd; x < outCols; ++x)
+        {
+            dst[x] = filterTaps(src, &colIndex[x*taps], weights, taps);
+        }
+
+        const long size = interiorEnd - interiorBegin;
+        if ( size > 0 )
+        {
+            const float* first = src + interiorBegin + origin;
+            k.smul(first, weights[0], dst + interiorBegin, size);
+            for (long i = 1; i < taps; ++i)
+            {
+                k.adds(dst + interiorBegin, weights[i], first + i*spacing,
+                       dst + interiorBegin, size);
+            }
+        }
+    }
+
+    float* outData = out.data();
+
+#pragma omp parallel for
+    for (long y = 0; y < outRows; ++y)
+    {
+        float* dst = outData + y*outCols;
+        const long* index = &rowIndex[y*taps];
+
+        for (long x = 0; x < outCols; x += BLOCK_COLS)
+        {
+            const long size = std::min<long>(BLOCK_COLS, outCols - x);
+            bool first = true;
+            for (long i = 0; i < taps; ++i)
+            {
+                if ( index[i] < 0 ) continue;
+
+                const float* row = tempData + index[i]*outCols + x;
+                if ( first ) k.smul(row, weights[i], dst + x, size);
+                else k.adds(dst + x, weights[i], row, dst + x, size);
+                first = false;
+            }
+            // every tap falls in the zero border
+            if ( first ) std::fill(dst + x, dst + x + size, 0.f);
+        }
+    }
+}
+
+void downsample(size_t inCols, size_t inRows,
+                const float* inputData, float* outputData)
+{
+    if ( !(inCols % 2) && !(inRows % 2) )
+    {
+        downsampleSimple(inCols, inRows, inputData, outputData);
+    }
+    else
+    {
+        downsampleFull(inCols, inRows, inputData, outputData);
+    }
+}
+
+void upsample(size_t outCols, size_t outRows,
+              const float* inputData, float* outputData)
+{
+    if ( !(outRows%2) && !(outCols%2) )
+    {
+        upsampleSimple(outCols, outRows, inputData, outputData);
+    }
+    else
+    {
+        upsampleFull(outCols, outRows, inputData, outputData);
+    }
+}
+
+GaussianPyramid::GaussianPyramid(BufferArena* arena)
+    : m_arena(arena)
+{}
+
+void GaussianPyramid::build(const Array2Df& image, size_t levels,
+                            const PyramidKernel& kernel, PyramidBorder border)
+{
+    levels = std::max(levels, size_t(1));
+
+    bool reuse = (m_levels.size() == levels);
+    size_t cols = image.getCols();
+    size_t rows = image.getRows();
+    for (size_t l = 0; reuse && l < levels; ++l)
+    {
+        reuse = (m_levels[l].getCols() == cols && m_levels[l].getRows() == rows);
+        cols /= 2;
+        rows /= 2;
+    }
+
+    if ( !reuse )
+    {
+        // the capacity is reserved upfront: the levels are never copied
+        clear();
+        m_levels.reserve(levels);
+
+        cols = image.getCols();
+        rows = image.getRows();
+        for (size_t l = 0; l < levels; ++l)
+        {
+            m_levels.emplace_back(cols, rows, m_arena, false);
+            cols /= 2;
+            rows /= 2;
+        }
+    }
+
+    std::copy(image.begin(), image.end(), m_levels[0].begin());
+    for (size_t l = 1; l < levels; ++l)
+    {
+        gaussianReduce(m_levels[l-1], m_levels[l], kernel, border, m_arena);
+    }
+}
+
+void GaussianPyramid::clear()
+{
+    m_levels.clear();
+}
+
+} // pfs
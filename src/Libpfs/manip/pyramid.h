@@ -0,0 +1,143 @@
+/*
+ * This file is a part of Luminance HDR package
+ * ----------------------------------------------------------------------
+ * Copyright (C) 2017 Luminance HDR developers
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+//! \brief Separable blurs and Gaussian pyramids shared by the tone mapping
+//! operators
+
+#ifndef PFS_PYRAMID_H
+#define PFS_PYRAMID_H
+
+#include <cstddef>
+#include <vector>
+
+#include <Libpfs/array2d.h>
+
+namespace pfs
+{
+class BufferArena;
+
+//! \brief Values of the samples lying outside of the image
+enum PyramidBorder
+{
+    //! replicates the nearest edge sample
+    BORDER_CLAMP = 0,
+    //! reflects around the edge sample, which is not repeated
+    BORDER_MIRROR = 1,
+    //! zero
+    BORDER_ZERO = 2
+};
+
+//! \brief 1D kernel of a separable filter
+struct PyramidKernel
+{
+    //! \brief weights of the taps
+    std::vector<float> taps;
+    //! \brief offset of the first tap from the filtered sample
+    int origin;
+
+    //! \brief [1 2 1]/4
+    static PyramidKernel binomial();
+    //! \brief [1 3 3 1]/8: with a step of 2, this is the [1 2 1]/4 blur
+    //! followed by the average of 2x2 blocks
+    static PyramidKernel binomialBox();
+    //! \brief 5 taps generating kernel of Burt and Adelson (1983)
+    //! [1/4-a/2, 1/4, a, 1/4, 1/4-a/2]
+    static PyramidKernel burtAdelson(float a = 0.4f);
+};
+
+//! \brief Separable filter of \a in, sampled every \a step pixels:
+//! out(x,y) = \sum_{i,j} k_i k_j in(step*x + dilation*(origin+i),
+//!                                   step*y + dilation*(origin+j))
+//!
+//! The size of \a out is not changed, and sets the number of output samples.
+//! Rows are filtered in parallel, with the SIMD kernels of the library on
+//! blocks of columns small enough to stay in cache. \a in and \a out can be
+//! the same array.
+//! \param arena arena of the intermediate buffer (NULL: regular allocation)
+void separableFilter(const Array2Df& in, Array2Df& out,
+                     const PyramidKernel& kernel, PyramidBorder border,
+                     size_t step = 1, size_t dilation = 1,
+                     BufferArena* arena = NULL);
+
+//! \brief Blur of \a in into \a out, of the same size
+inline
+void gaussianBlur(const Array2Df& in, Array2Df& out,
+                  const PyramidKernel& kernel, PyramidBorder border,
+                  BufferArena* arena = NULL)
+{
+    separableFilter(in, out, kernel, border, 1, 1, arena);
+}
+
+//! \brief Blur of \a in sampled on the even pixels: \a out is usually half
+//! the size of \a in
+inline
+void gaussianReduce(const Array2Df& in, Array2Df& out,
+                    const PyramidKernel& kernel, PyramidBorder border,
+                    BufferArena* arena = NULL)
+{
+    separableFilter(in, out, kernel, border, 2, 1, arena);
+}
+
+//! \brief Area average of \a inputData (inCols x inRows) into \a outputData,
+//! of size (inCols/2 x inRows/2). Odd sizes are resampled by integrating the
+//! underlying pixels.
+void downsample(size_t inCols, size_t inRows,
+                const float* inputData, float* outputData);
+
+//! \brief Inverse of \c downsample: \a inputData (outCols/2 x outRows/2) is
+//! upsampled into \a outputData (outCols x outRows)
+void upsample(size_t outCols, size_t outRows,
+              const float* inputData, float* outputData);
+
+//! \brief Gaussian pyramid whose levels are kept across builds
+//!
+//! Level 0 is a copy of the image, and every other level is the reduction
+//! of the previous one, with the size halved (rounded down).
+//! Building a pyramid of the same size again reuses the storage of the
+//! levels, which otherwise comes from the arena given to the constructor.
+class GaussianPyramid
+{
+public:
+    explicit GaussianPyramid(BufferArena* arena = NULL);
+
+    //! \brief builds \a levels levels (at least one) from \a image
+    void build(const Array2Df& image, size_t levels,
+               const PyramidKernel& kernel, PyramidBorder border);
+
+    size_t levels() const                           { return m_levels.size(); }
+
+    Array2Df& operator[](size_t level)              { return m_levels[level]; }
+    const Array2Df& operator[](size_t level) const  { return m_levels[level]; }
+
+    //! \brief releases the storage of the levels
+    void clear();
+
+private:
+    GaussianPyramid(const GaussianPyramid&);
+    GaussianPyramid& operator=(const GaussianPyramid&);
+
+    BufferArena* m_arena;
+    std::vector<Array2Df> m_levels;
+};
+
+} // pfs
+
+#endif // PFS_PYRAMID_H
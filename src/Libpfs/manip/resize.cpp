@@ -36,6 +36,8 @@
 #include "Libpfs/utils/msec_timer.h"
 
 #include "Libpfs/frame.h"
+#include "Libpfs/tiledframe.h"
+#include "Libpfs/frameview.h"
 
 namespace pfs
 {
@@ -72,4 +74,193 @@ Frame* resize(Frame* frame, int xSize, InterpolationMethod m)
     return resizedFrame;
 }
 
+//! \brief computes the row \a output (\a w2 pixels) with the same sampling as
+//! \c detail::resizeBilinearGray, from the source rows above (\a rowA) and
+//! below (\a rowC) it
+static inline void resizeBilinearRow(const float* rowA, const float* rowC,
+                                     float x_ratio, float y_diff,
+                                     float* output, size_t w2)
+{
+    for (size_t j = 0; j < w2; ++j)
+    {
+        const size_t x = static_cast<size_t>(x_ratio * j);
+        const float x_diff = (x_ratio * j) - x;
+
+        const float A = rowA[x];
+        const float B = rowA[x + 1];
+        const float C = rowC[x];
+        const float D = rowC[x + 1];
+
+        output[j] = static_cast<float>(
+                    A*(1-x_diff)*(1-y_diff) +
+                    B*(x_diff)*(1-y_diff) +
+                    C*(y_diff)*(1-x_diff) +
+                    D*(x_diff*y_diff) );
+    }
+}
+
+//! \brief same sampling as \c detail::resizeBilinearGray, but reading the rows
+//! of \a in one strip at the time
+static void resizeBilinear(const TiledArray2Df& in, Array2Df& out)
+{
+    const size_t w = in.getCols();
+    const size_t h = in.getRows();
+    const size_t w2 = out.getCols();
+    const size_t h2 = out.getRows();
+
+    const float x_ratio = static_cast<float>(w - 1)/w2;
+    const float y_ratio = static_cast<float>(h - 1)/h2;
+
+    std::vector<float> nextRow(w);
+
+    size_t iBegin = 0;
+    for (size_t s = 0; s < in.getStripCount() && iBegin < h2; ++s)
+    {
+        const TiledArray2Df::Strip strip = in.readStrip(s);
+        const size_t firstRow = strip.firstRow();
+        const size_t lastRow = firstRow + strip.getRows() - 1;
+
+        // output rows whose top sample falls inside this strip
+        size_t iEnd = iBegin;
+        while ( iEnd < h2 && static_cast<size_t>(y_ratio * iEnd) <= lastRow ) {
+            ++iEnd;
+        }
+        if ( iEnd == iBegin ) continue;
+
+        // the bottom sample of the last row may be in the next strip
+        if ( static_cast<size_t>(y_ratio * (iEnd - 1)) == lastRow )
+        {
+            if ( lastRow + 1 < h ) {
+                const TiledArray2Df::Strip next = in.readStrip(s + 1);
+                std::copy(next[0], next[0] + w, nextRow.begin());
+            }
+            else {
+                std::copy(strip[lastRow - firstRow], strip[lastRow - firstRow] + w,
+                          nextRow.begin());
+            }
+        }
+
+#pragma omp parallel for schedule(static)
+        for (int io = static_cast<int>(iBegin); io < static_cast<int>(iEnd); ++io)
+        {
+            const size_t i = io;
+            const size_t y = static_cast<size_t>(y_ratio * i);
+            const float y_diff = (y_ratio * i) - y;
+
+            const float* rowA = strip[y - firstRow];
+            const float* rowC = (y < lastRow) ? rowA + w : nextRow.data();
+
+            resizeBilinearRow(rowA, rowC, x_ratio, y_diff, out.data() + i*w2, w2);
+        }
+
+        iBegin = iEnd;
+    }
+}
+
+Frame* resize(const TiledFrame& frame, int xSize, InterpolationMethod m)
+{
+    if ( m != BilinearInterp )
+    {
+        Frame resident;
+        frame.copyTo(resident);
+        return resize(&resident, xSize, m);
+    }
+
+    int new_x = xSize;
+    int new_y = (int)((float)frame.getHeight() * (float)xSize / (float)frame.getWidth());
+
+    pfs::Frame *resizedFrame = new pfs::Frame( new_x, new_y );
+
+    const TiledChannelContainer& channels = frame.getChannels();
+    for ( TiledChannelContainer::const_iterator it = channels.begin();
+          it != channels.end();
+          ++it)
+    {
+        pfs::Channel* newCh = resizedFrame->createChannel( (*it)->getName() );
+        copyTags( (*it)->getTags(), newCh->getTags() );
+
+        if ( (*it)->getCols() == newCh->getCols() &&
+             (*it)->getRows() == newCh->getRows() )
+        {
+            (*it)->copyTo(*newCh);
+        }
+        else
+        {
+            resizeBilinear(**it, *newCh);
+        }
+    }
+    copyTags( frame.getTags(), resizedFrame->getTags() );
+
+    return resizedFrame;
+}
+
+//! \brief same sampling as \c detail::resizeBilinearGray, reading only the
+//! rows of the (contiguous) view \a in that are sampled
+static void resizeBilinear(const Array2DViewf& in, Array2Df& out)
+{
+    const size_t w = in.getCols();
+    const size_t h = in.getRows();
+    const size_t w2 = out.getCols();
+    const size_t h2 = out.getRows();
+
+    const float x_ratio = static_cast<float>(w - 1)/w2;
+    const float y_ratio = static_cast<float>(h - 1)/h2;
+
+#pragma omp parallel for schedule(static)
+    for (int io = 0; io < static_cast<int>(h2); ++io)
+    {
+        const size_t i = io;
+        const size_t y = static_cast<size_t>(y_ratio * i);
+        const float y_diff = (y_ratio * i) - y;
+
+        const float* rowA = in.data() + y*w;
+        resizeBilinearRow(rowA, rowA + w, x_ratio, y_diff, out.data() + i*w2, w2);
+    }
+}
+
+Frame* resize(const FrameView& frame, int xSize, InterpolationMethod m)
+{
+    if ( m != BilinearInterp )
+    {
+        Frame resident;
+        frame.copyTo(resident);
+        return resize(&resident, xSize, m);
+    }
+
+    int new_x = xSize;
+    int new_y = (int)((float)frame.getHeight() * (float)xSize / (float)frame.getWidth());
+
+    pfs::Frame *resizedFrame = new pfs::Frame( new_x, new_y );
+
+    const ChannelViewContainer& channels = frame.getChannels();
+    for ( ChannelViewContainer::const_iterator it = channels.begin();
+          it != channels.end();
+          ++it)
+    {
+        const pfs::ChannelView* ch = *it;
+        pfs::Channel* newCh = resizedFrame->createChannel( ch->getName() );
+        copyTags( ch->getTags(), newCh->getTags() );
+
+        if ( ch->getCols() == newCh->getCols() &&
+             ch->getRows() == newCh->getRows() )
+        {
+            ch->copyTo(*newCh);
+        }
+        else if ( ch->isContiguous() )
+        {
+            resizeBilinear(*ch, *newCh);
+        }
+        else
+        {
+            // components of interleaved data are gathered first
+            Array2Df gathered;
+            ch->copyTo(gathered);
+            resize(&gathered, newCh, m);
+        }
+    }
+    copyTags( frame.getTags(), resizedFrame->getTags() );
+
+    return resizedFrame;
+}
+
 } // pfs
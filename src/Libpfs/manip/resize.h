@@ -35,9 +35,21 @@ namespace pfs
 {
 // forward declaration
 class Frame;
+class TiledFrame;
+class FrameView;
 
 Frame* resize(Frame* frame, int xSize, InterpolationMethod m);
 
+//! \brief resizes \a frame into a resident frame, \a xSize pixels wide.
+//! Bilinear interpolation reads \a frame one strip at the time, Lanczos needs
+//! a resident copy of it
+Frame* resize(const TiledFrame& frame, int xSize, InterpolationMethod m);
+
+//! \brief resizes \a frame into a resident frame, \a xSize pixels wide.
+//! Bilinear interpolation reads only the rows it samples out of contiguous
+//! channels, without detaching them
+Frame* resize(const FrameView& frame, int xSize, InterpolationMethod m);
+
 template <typename Type>
 void resize(const Array2D<Type> *from, Array2D<Type> *to, InterpolationMethod m);
 
@@ -0,0 +1,281 @@
+/*
+ * This file is a part of Luminance HDR package
+ * ----------------------------------------------------------------------
+ * Copyright (C) 2017 Luminance HDR developers
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+#include "tilecache.h"
+#include "exception.h"
+
+#include <cassert>
+#include <algorithm>
+
+namespace pfs
+{
+namespace
+{
+// large file aware seek on the swap file
+int seekSwap(FILE* file, long long offset)
+{
+#if defined(_WIN32)
+    return _fseeki64(file, offset, SEEK_SET);
+#else
+    return fseeko(file, static_cast<off_t>(offset), SEEK_SET);
+#endif
+}
+}
+
+const size_t TileCache::DEFAULT_BUDGET;
+
+TileCache::TileCache(size_t memoryBudget)
+    : m_budget(memoryBudget)
+    , m_resident(0)
+    , m_spilled(0)
+    , m_clock(0)
+    , m_swap()
+    , m_swapSize(0)
+{}
+
+TileCache::~TileCache()
+{}
+
+TileCache& TileCache::global()
+{
+    static TileCache s_cache;
+    return s_cache;
+}
+
+size_t TileCache::memoryBudget() const
+{
+    boost::mutex::scoped_lock lock(m_mutex);
+    return m_budget;
+}
+
+void TileCache::setMemoryBudget(size_t bytes)
+{
+    boost::mutex::scoped_lock lock(m_mutex);
+    m_budget = bytes;
+    evict(0);
+}
+
+size_t TileCache::residentBytes() const
+{
+    boost::mutex::scoped_lock lock(m_mutex);
+    return m_resident;
+}
+
+size_t TileCache::spilledBytes() const
+{
+    boost::mutex::scoped_lock lock(m_mutex);
+    return m_spilled;
+}
+
+TileCache::Tile& TileCache::tile(TileId id)
+{
+    assert( id < m_tiles.size() );
+    assert( m_tiles[id].m_used );
+    return m_tiles[id];
+}
+
+TileCache::TileId TileCache::allocate(size_t bytes)
+{
+    boost::mutex::scoped_lock lock(m_mutex);
+
+    TileId id;
+    if ( !m_freeSlots.empty() )
+    {
+        id = m_freeSlots.back();
+        m_freeSlots.pop_back();
+    }
+    else
+    {
+        id = m_tiles.size();
+        m_tiles.push_back( Tile() );
+    }
+
+    Tile& t = m_tiles[id];
+    t = Tile();
+    t.m_bytes = bytes;
+    t.m_used = true;
+
+    return id;
+}
+
+void TileCache::release(TileId id)
+{
+    boost::mutex::scoped_lock lock(m_mutex);
+
+    Tile& t = tile(id);
+    assert( t.m_pins == 0 );
+
+    if ( isResident(t) )
+    {
+        m_resident -= t.m_bytes;
+    }
+    else if ( t.m_swapOffset >= 0 )
+    {
+        m_spilled -= t.m_bytes;
+    }
+    if ( t.m_swapOffset >= 0 )
+    {
+        m_freeExtents.push_back( std::make_pair(t.m_swapOffset, t.m_bytes) );
+    }
+
+    t = Tile();
+    m_freeSlots.push_back(id);
+}
+
+void* TileCache::lock(TileId id)
+{
+    boost::mutex::scoped_lock lock(m_mutex);
+
+    Tile& t = tile(id);
+    if ( !isResident(t) )
+    {
+        evict(t.m_bytes);
+        reload( tile(id) );
+    }
+
+    Tile& curr = tile(id);
+    curr.m_pins++;
+    curr.m_lastUse = ++m_clock;
+
+    return curr.m_data.data();
+}
+
+void TileCache::unlock(TileId id, bool dirty)
+{
+    boost::mutex::scoped_lock lock(m_mutex);
+
+    Tile& t = tile(id);
+    assert( t.m_pins > 0 );
+
+    t.m_pins--;
+    t.m_dirty = t.m_dirty || dirty;
+
+    evict(0);
+}
+
+void TileCache::evict(size_t bytesNeeded)
+{
+    while ( m_resident + bytesNeeded > m_budget )
+    {
+        // find the least recently used tile that can be evicted
+        Tile* victim = NULL;
+        for (size_t idx = 0; idx < m_tiles.size(); ++idx)
+        {
+            Tile& t = m_tiles[idx];
+            if ( !t.m_used || t.m_pins > 0 || !isResident(t) ) continue;
+
+            if ( victim == NULL || t.m_lastUse < victim->m_lastUse )
+            {
+                victim = &t;
+            }
+        }
+        // everything is pinned: allow the budget to be exceeded
+        if ( victim == NULL ) return;
+
+        spill(*victim);
+    }
+}
+
+void TileCache::spill(Tile& t)
+{
+    if ( t.m_dirty || t.m_swapOffset < 0 )
+    {
+        FILE* file = swapFile();
+
+        if ( t.m_swapOffset < 0 )
+        {
+            // reuse a released extent if possible, append otherwise
+            std::vector< std::pair<long long, size_t> >::iterator it =
+                    m_freeExtents.begin();
+            while ( it != m_freeExtents.end() && it->second < t.m_bytes )
+            {
+                ++it;
+            }
+
+            if ( it != m_freeExtents.end() )
+            {
+                t.m_swapOffset = it->first;
+                if ( it->second > t.m_bytes )
+                {
+                    it->first += t.m_bytes;
+                    it->second -= t.m_bytes;
+                }
+                else
+                {
+                    m_freeExtents.erase(it);
+                }
+            }
+            else
+            {
+                t.m_swapOffset = m_swapSize;
+                m_swapSize += t.m_bytes;
+            }
+        }
+
+        if ( seekSwap(file, t.m_swapOffset) != 0 ||
+             fwrite(t.m_data.data(), 1, t.m_bytes, file) != t.m_bytes )
+        {
+            throw pfs::Exception("TileCache: cannot write to the swap file");
+        }
+    }
+
+    std::vector<char>().swap(t.m_data);
+    t.m_dirty = false;
+
+    m_resident -= t.m_bytes;
+    m_spilled += t.m_bytes;
+}
+
+void TileCache::reload(Tile& t)
+{
+    t.m_data.resize(t.m_bytes);
+    m_resident += t.m_bytes;
+
+    if ( t.m_swapOffset < 0 )
+    {
+        // first use: the buffer is already zero-initialised
+        return;
+    }
+
+    FILE* file = swapFile();
+    if ( seekSwap(file, t.m_swapOffset) != 0 ||
+         fread(t.m_data.data(), 1, t.m_bytes, file) != t.m_bytes )
+    {
+        throw pfs::Exception("TileCache: cannot read from the swap file");
+    }
+    m_spilled -= t.m_bytes;
+}
+
+FILE* TileCache::swapFile()
+{
+    if ( !m_swap )
+    {
+        // tmpfile() is removed automatically when closed
+        m_swap.reset( tmpfile() );
+        if ( !m_swap )
+        {
+            throw pfs::Exception("TileCache: cannot create the swap file");
+        }
+    }
+    return m_swap.data();
+}
+
+} // namespace pfs
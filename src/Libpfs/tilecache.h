@@ -0,0 +1,141 @@
+/*
+ * This file is a part of Luminance HDR package
+ * ----------------------------------------------------------------------
+ * Copyright (C) 2017 Luminance HDR developers
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+#ifndef PFS_TILECACHE_H
+#define PFS_TILECACHE_H
+
+#include <cstddef>
+#include <cstdio>
+#include <vector>
+#include <utility>
+
+#include <boost/thread/mutex.hpp>
+
+#include <Libpfs/utils/resourcehandlerstdio.h>
+
+//! \file tilecache.h
+//! \brief Memory-bounded store of fixed-size blocks that spills to disk
+
+namespace pfs
+{
+//!
+//! \brief Store of fixed-size memory blocks (tiles) with a memory budget.
+//!
+//! Tiles are pinned in memory through \c lock() and released through
+//! \c unlock(). Whenever the amount of resident memory exceeds the budget,
+//! the least recently used unpinned tiles are written to a temporary swap
+//! file and their memory is released. A spilled tile is transparently
+//! reloaded at the next \c lock().
+//!
+//! All the methods are thread-safe, so distinct tiles can be processed
+//! concurrently (i.e. inside an OpenMP loop).
+//!
+class TileCache
+{
+public:
+    typedef size_t TileId;
+
+    //! \brief default memory budget (1 GB)
+    static const size_t DEFAULT_BUDGET = size_t(1) << 30;
+
+    explicit TileCache(size_t memoryBudget = DEFAULT_BUDGET);
+    ~TileCache();
+
+    //! \brief returns the process-wide cache used by default by \c TiledArray2D
+    static TileCache& global();
+
+    size_t memoryBudget() const;
+    //! \brief changes the memory budget, evicting tiles if necessary
+    void setMemoryBudget(size_t bytes);
+
+    //! \brief number of bytes currently held in memory
+    size_t residentBytes() const;
+    //! \brief number of bytes currently stored only in the swap file
+    size_t spilledBytes() const;
+
+    //! \brief creates a new tile of \a bytes bytes. The content of the tile is
+    //! zero-initialised on the first \c lock()
+    TileId allocate(size_t bytes);
+    //! \brief frees the tile \a id (memory and swap space)
+    void release(TileId id);
+
+    //! \brief pins the tile \a id in memory and returns its address. The
+    //! address is valid until the matching \c unlock()
+    void* lock(TileId id);
+    //! \brief unpins the tile \a id. If \a dirty is true, the content will be
+    //! written to the swap file before being evicted
+    void unlock(TileId id, bool dirty = true);
+
+private:
+    TileCache(const TileCache&);
+    TileCache& operator=(const TileCache&);
+
+    struct Tile
+    {
+        Tile()
+            : m_bytes(0)
+            , m_swapOffset(-1)
+            , m_pins(0)
+            , m_lastUse(0)
+            , m_dirty(false)
+            , m_used(false)
+        {}
+
+        std::vector<char> m_data;
+        size_t  m_bytes;
+        long long m_swapOffset; // -1 if the tile has never been spilled
+        int     m_pins;
+        size_t  m_lastUse;
+        bool    m_dirty;        // memory content newer than the swap file
+        bool    m_used;         // false if the slot is free
+    };
+
+    bool isResident(const Tile& tile) const
+    { return !tile.m_data.empty(); }
+
+    Tile& tile(TileId id);
+
+    // these functions expect m_mutex to be locked by the caller
+    void evict(size_t bytesNeeded);
+    void spill(Tile& tile);
+    void reload(Tile& tile);
+    FILE* swapFile();
+
+    mutable boost::mutex m_mutex;
+
+    std::vector<Tile>   m_tiles;
+    std::vector<TileId> m_freeSlots;
+
+    size_t m_budget;
+    size_t m_resident;
+    size_t m_spilled;
+    size_t m_clock;
+
+    // swap file, created on the first spill
+    utils::ScopedStdIoFile m_swap;
+    long long m_swapSize;
+    // extents of the swap file left by released tiles (offset, size)
+    std::vector< std::pair<long long, size_t> > m_freeExtents;
+};
+
+} // namespace pfs
+
+#endif // PFS_TILECACHE_H
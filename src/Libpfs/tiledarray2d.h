@@ -0,0 +1,158 @@
+/*
+ * This file is a part of Luminance HDR package
+ * ----------------------------------------------------------------------
+ * Copyright (C) 2017 Luminance HDR developers
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+#ifndef PFS_TILEDARRAY2D_H
+#define PFS_TILEDARRAY2D_H
+
+#include <cstddef>
+#include <vector>
+
+#include <Libpfs/array2d.h>
+#include <Libpfs/tilecache.h>
+
+//! \file tiledarray2d.h
+//! \brief 2d array stored as horizontal strips inside a \c TileCache
+
+namespace pfs
+{
+//!
+//! \brief Two dimensional array of data, stored as a sequence of horizontal
+//! strips (tiles spanning the full width of the array).
+//!
+//! Unlike \c Array2D, the data is never required to be resident in memory all
+//! at once: every strip lives inside a \c TileCache, which spills the least
+//! recently used strips to disk when its memory budget is exceeded.
+//! Data is accessed one strip at a time through \c Strip (or using
+//! \c forEachStrip), which keeps the strip pinned in memory while in scope.
+//!
+template <typename Type>
+class TiledArray2D
+{
+public:
+    typedef Type                value_type;
+    typedef TiledArray2D<Type>  self;
+
+    //! \brief default height of a strip, in rows
+    static const size_t DEFAULT_STRIP_ROWS = 64;
+
+    //! \brief pinned view over the rows of a strip
+    class Strip
+    {
+    public:
+        Strip(self& array, size_t strip, bool dirty = true);
+        Strip(Strip&& other);
+        ~Strip();
+
+        Type*   data()              { return m_data; }
+        const Type* data() const    { return m_data; }
+
+        //! \brief returns the row \a r of the strip, relative to \c firstRow()
+        Type*   operator[](size_t r)             { return m_data + r*m_cols; }
+        const Type* operator[](size_t r) const   { return m_data + r*m_cols; }
+
+        //! \brief index of the first row of the strip inside the array
+        size_t firstRow() const     { return m_firstRow; }
+        //! \brief number of rows inside the strip
+        size_t getRows() const      { return m_rows; }
+        size_t getCols() const      { return m_cols; }
+        size_t size() const         { return m_rows*m_cols; }
+
+    private:
+        Strip(const Strip&);
+        Strip& operator=(const Strip&);
+
+        TileCache*          m_cache;
+        TileCache::TileId   m_tile;
+        Type*   m_data;
+        size_t  m_firstRow;
+        size_t  m_rows;
+        size_t  m_cols;
+        bool    m_dirty;
+    };
+
+    //! \brief init \c TiledArray2D with a matrix of \a cols times \a rows,
+    //! stored in strips of \a stripRows rows inside \a cache
+    TiledArray2D(size_t cols, size_t rows,
+                 size_t stripRows = DEFAULT_STRIP_ROWS,
+                 TileCache& cache = TileCache::global());
+
+    ~TiledArray2D();
+
+    //! \brief Get number of columns or, in case of an image, width.
+    size_t getCols() const      { return m_cols; }
+    //! \brief Get number of rows or, in case of an image, height.
+    size_t getRows() const      { return m_rows; }
+    size_t size() const         { return m_rows*m_cols; }
+
+    //! \brief nominal height of a strip (the last strip can be shorter)
+    size_t getStripRows() const { return m_stripRows; }
+    //! \brief number of strips
+    size_t getStripCount() const { return m_tiles.size(); }
+    //! \brief index of the strip containing \a row
+    size_t stripOf(size_t row) const { return row/m_stripRows; }
+
+    TileCache& cache() const    { return *m_cache; }
+
+    //! \brief pins strip \a n for writing
+    Strip strip(size_t n)               { return Strip(*this, n, true); }
+    //! \brief pins strip \a n for reading: the strip is not marked as dirty,
+    //! so it won't be written again to the swap file when evicted
+    Strip readStrip(size_t n) const
+    { return Strip(const_cast<self&>(*this), n, false); }
+
+    //! \brief calls \a func(strip) on every strip. When compiled with OpenMP,
+    //! strips are processed in parallel
+    template <typename Func>
+    void forEachStrip(Func func);
+
+    //! \brief same as \c forEachStrip, for read-only operations
+    template <typename Func>
+    void forEachStrip(Func func) const;
+
+    //! \brief fill the entire array with \a value
+    void fill(const Type& value);
+
+    //! \brief copy the content of \a src (same size) inside the strips
+    void copyFrom(const Array2D<Type>& src);
+    //! \brief copy the content of the strips inside \a dst (resized if
+    //! necessary). \a dst needs to be fully resident in memory
+    void copyTo(Array2D<Type>& dst) const;
+
+private:
+    TiledArray2D(const self&);
+    self& operator=(const self&);
+
+    friend class Strip;
+
+    TileCache*  m_cache;
+    size_t      m_cols;
+    size_t      m_rows;
+    size_t      m_stripRows;
+    std::vector<TileCache::TileId> m_tiles;
+};
+
+typedef TiledArray2D<float> TiledArray2Df;
+
+} // namespace pfs
+
+#include <Libpfs/tiledarray2d.hxx>
+
+#endif // PFS_TILEDARRAY2D_H
@@ -0,0 +1,176 @@
+/*
+ * This file is a part of Luminance HDR package
+ * ----------------------------------------------------------------------
+ * Copyright (C) 2017 Luminance HDR developers
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+#ifndef PFS_TILEDARRAY2D_HXX
+#define PFS_TILEDARRAY2D_HXX
+
+#include <cassert>
+#include <algorithm>
+
+#include <Libpfs/tiledarray2d.h>
+
+namespace pfs
+{
+
+template <typename Type>
+const size_t TiledArray2D<Type>::DEFAULT_STRIP_ROWS;
+
+template <typename Type>
+TiledArray2D<Type>::Strip::Strip(self& array, size_t strip, bool dirty)
+    : m_cache(array.m_cache)
+    , m_tile(array.m_tiles[strip])
+    , m_data(static_cast<Type*>(m_cache->lock(m_tile)))
+    , m_firstRow(strip*array.m_stripRows)
+    , m_rows(std::min(array.m_stripRows, array.m_rows - m_firstRow))
+    , m_cols(array.m_cols)
+    , m_dirty(dirty)
+{}
+
+template <typename Type>
+TiledArray2D<Type>::Strip::Strip(Strip&& other)
+    : m_cache(other.m_cache)
+    , m_tile(other.m_tile)
+    , m_data(other.m_data)
+    , m_firstRow(other.m_firstRow)
+    , m_rows(other.m_rows)
+    , m_cols(other.m_cols)
+    , m_dirty(other.m_dirty)
+{
+    other.m_cache = NULL;
+}
+
+template <typename Type>
+TiledArray2D<Type>::Strip::~Strip()
+{
+    if ( m_cache ) m_cache->unlock(m_tile, m_dirty);
+}
+
+template <typename Type>
+TiledArray2D<Type>::TiledArray2D(size_t cols, size_t rows,
+                                 size_t stripRows, TileCache& cache)
+    : m_cache(&cache)
+    , m_cols(cols)
+    , m_rows(rows)
+    , m_stripRows(std::max(stripRows, size_t(1)))
+{
+    size_t numStrips = (m_rows + m_stripRows - 1)/m_stripRows;
+    m_tiles.reserve(numStrips);
+    for (size_t s = 0; s < numStrips; ++s)
+    {
+        size_t stripSize = std::min(m_stripRows, m_rows - s*m_stripRows)*m_cols;
+        m_tiles.push_back( m_cache->allocate(stripSize*sizeof(Type)) );
+    }
+}
+
+template <typename Type>
+TiledArray2D<Type>::~TiledArray2D()
+{
+    for (size_t s = 0; s < m_tiles.size(); ++s)
+    {
+        m_cache->release(m_tiles[s]);
+    }
+}
+
+template <typename Type>
+template <typename Func>
+void TiledArray2D<Type>::forEachStrip(Func func)
+{
+    int numStrips = static_cast<int>(getStripCount());
+#pragma omp parallel for schedule(dynamic)
+    for (int s = 0; s < numStrips; ++s)
+    {
+        Strip curr(*this, s, true);
+        func(curr);
+    }
+}
+
+template <typename Type>
+template <typename Func>
+void TiledArray2D<Type>::forEachStrip(Func func) const
+{
+    int numStrips = static_cast<int>(getStripCount());
+#pragma omp parallel for schedule(dynamic)
+    for (int s = 0; s < numStrips; ++s)
+    {
+        const Strip curr(readStrip(s));
+        func(curr);
+    }
+}
+
+namespace detail
+{
+template <typename Type>
+struct FillStrip
+{
+    FillStrip(const Type& value)
+        : m_value(value)
+    {}
+
+    void operator()(typename TiledArray2D<Type>::Strip& strip) const
+    {
+        std::fill(strip.data(), strip.data() + strip.size(), m_value);
+    }
+
+    Type m_value;
+};
+}
+
+template <typename Type>
+void TiledArray2D<Type>::fill(const Type& value)
+{
+    forEachStrip(detail::FillStrip<Type>(value));
+}
+
+template <typename Type>
+void TiledArray2D<Type>::copyFrom(const Array2D<Type>& src)
+{
+    assert( src.getCols() == m_cols );
+    assert( src.getRows() == m_rows );
+
+    int numStrips = static_cast<int>(getStripCount());
+#pragma omp parallel for schedule(dynamic)
+    for (int s = 0; s < numStrips; ++s)
+    {
+        Strip curr(*this, s, true);
+        std::copy(src.row_begin(curr.firstRow()),
+                  src.row_begin(curr.firstRow()) + curr.size(),
+                  curr.data());
+    }
+}
+
+template <typename Type>
+void TiledArray2D<Type>::copyTo(Array2D<Type>& dst) const
+{
+    dst.resize(m_cols, m_rows);
+
+    int numStrips = static_cast<int>(getStripCount());
+#pragma omp parallel for schedule(dynamic)
+    for (int s = 0; s < numStrips; ++s)
+    {
+        const Strip curr(readStrip(s));
+        std::copy(curr.data(), curr.data() + curr.size(),
+                  dst.row_begin(curr.firstRow()));
+    }
+}
+
+} // namespace pfs
+
+#endif // PFS_TILEDARRAY2D_HXX
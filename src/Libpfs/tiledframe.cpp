@@ -0,0 +1,143 @@
+/*
+ * This file is a part of Luminance HDR package
+ * ----------------------------------------------------------------------
+ * Copyright (C) 2017 Luminance HDR developers
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+#include "tiledframe.h"
+#include "frame.h"
+
+#include <algorithm>
+
+namespace pfs
+{
+
+TiledChannel::TiledChannel(size_t width, size_t height,
+                           const std::string& channelName,
+                           size_t stripRows, TileCache& cache)
+    : TiledArray2Df(width, height, stripRows, cache)
+    , m_name(channelName)
+    , m_tags()
+{}
+
+TiledFrame::TiledFrame(size_t width, size_t height,
+                       size_t stripRows, TileCache& cache)
+    : m_width(width)
+    , m_height(height)
+    , m_stripRows(stripRows)
+    , m_cache(&cache)
+{}
+
+TiledFrame::~TiledFrame()
+{}
+
+namespace
+{
+struct NewTiledChannel
+{
+    NewTiledChannel(size_t width, size_t height, size_t stripRows, TileCache& cache)
+        : width_(width), height_(height), stripRows_(stripRows), cache_(cache)
+    {}
+
+    TiledChannel* operator()(const std::string& name) const
+    {
+        return new TiledChannel(width_, height_, name, stripRows_, cache_);
+    }
+
+private:
+    size_t width_;
+    size_t height_;
+    size_t stripRows_;
+    TileCache& cache_;
+};
+}
+
+const TiledChannel* TiledFrame::getChannel(const std::string& name) const
+{
+    return m_channels.get(name);
+}
+
+TiledChannel* TiledFrame::getChannel(const std::string& name)
+{
+    return m_channels.get(name);
+}
+
+TiledChannel* TiledFrame::createChannel(const std::string& name)
+{
+    return m_channels.create(name, NewTiledChannel(m_width, m_height, m_stripRows, *m_cache));
+}
+
+void TiledFrame::removeChannel(const std::string& name)
+{
+    m_channels.remove(name);
+}
+
+void TiledFrame::getXYZChannels(TiledChannel* &X, TiledChannel* &Y, TiledChannel* &Z)
+{
+    m_channels.getXYZ(X, Y, Z);
+}
+
+void TiledFrame::createXYZChannels(TiledChannel* &X, TiledChannel* &Y, TiledChannel* &Z)
+{
+    m_channels.createXYZ(X, Y, Z, NewTiledChannel(m_width, m_height, m_stripRows, *m_cache));
+}
+
+void TiledFrame::copyFrom(const Frame& frame)
+{
+    TiledFrame temp(frame.getWidth(), frame.getHeight(), m_stripRows, *m_cache);
+
+    copyTags(frame.getTags(), temp.m_tags);
+
+    const ChannelContainer& channels = frame.getChannels();
+    for (size_t idx = 0; idx < channels.size(); ++idx)
+    {
+        TiledChannel* ch = temp.createChannel( channels[idx]->getName() );
+        copyTags(channels[idx]->getTags(), ch->getTags());
+        ch->copyFrom( *channels[idx] );
+    }
+
+    swap(temp);
+}
+
+void TiledFrame::swap(TiledFrame& other)
+{
+    std::swap(m_width, other.m_width);
+    std::swap(m_height, other.m_height);
+    std::swap(m_stripRows, other.m_stripRows);
+    std::swap(m_cache, other.m_cache);
+    m_tags.swap(other.m_tags);
+    m_channels.swap(other.m_channels);
+}
+
+void TiledFrame::copyTo(Frame& frame) const
+{
+    Frame temp(m_width, m_height);
+
+    copyTags(m_tags, temp.getTags());
+    const TiledChannelContainer& channels = getChannels();
+    for (size_t idx = 0; idx < channels.size(); ++idx)
+    {
+        Channel* ch = temp.createChannel( channels[idx]->getName() );
+        copyTags(channels[idx]->getTags(), ch->getTags());
+        channels[idx]->copyTo( *ch );
+    }
+
+    frame.swap(temp);
+}
+
+} // namespace pfs
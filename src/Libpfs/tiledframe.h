@@ -0,0 +1,128 @@
+/*
+ * This file is a part of Luminance HDR package
+ * ----------------------------------------------------------------------
+ * Copyright (C) 2017 Luminance HDR developers
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+//! \brief PFS library - Frame with tiled (out-of-core) storage
+
+#ifndef PFS_TILEDFRAME_H
+#define PFS_TILEDFRAME_H
+
+#include <string>
+#include <vector>
+#include <memory>
+
+#include <Libpfs/tiledarray2d.h>
+#include <Libpfs/channelset.h>
+#include <Libpfs/tag.h>
+
+namespace pfs
+{
+class Frame;
+
+//! \brief Named \c TiledArray2Df with associated tags: the tiled counterpart
+//! of \c Channel
+class TiledChannel : public TiledArray2Df
+{
+public:
+    TiledChannel(size_t width, size_t height, const std::string& channelName,
+                 size_t stripRows, TileCache& cache);
+
+    const std::string& getName() const      { return m_name; }
+    size_t getWidth() const                 { return getCols(); }
+    size_t getHeight() const                { return getRows(); }
+
+    TagContainer& getTags()                 { return m_tags; }
+    const TagContainer& getTags() const     { return m_tags; }
+
+private:
+    std::string     m_name;
+    TagContainer    m_tags;
+};
+
+typedef ChannelSet<TiledChannel>::Container TiledChannelContainer;
+
+//! \brief Frame whose channels are stored inside a \c TileCache, so that its
+//! memory footprint is bounded by the budget of the cache rather than by the
+//! size of the image. It mirrors the interface of \c Frame, but channels can
+//! only be accessed one strip at the time.
+class TiledFrame
+{
+public:
+    TiledFrame(size_t width = 0, size_t height = 0,
+               size_t stripRows = TiledArray2Df::DEFAULT_STRIP_ROWS,
+               TileCache& cache = TileCache::global());
+    ~TiledFrame();
+
+    bool isValid() const {
+        return (getWidth() > 0 && getHeight() > 0);
+    }
+
+    size_t getWidth() const     { return m_width; }
+    size_t getHeight() const    { return m_height; }
+    size_t size() const         { return m_height*m_width; }
+
+    size_t getStripRows() const { return m_stripRows; }
+    TileCache& cache() const    { return *m_cache; }
+
+    //! \brief Gets color channels in XYZ color space. May return NULLs
+    //! if such channels do not exist.
+    void getXYZChannels(TiledChannel* &X, TiledChannel* &Y, TiledChannel* &Z);
+    void createXYZChannels(TiledChannel* &X, TiledChannel* &Y, TiledChannel* &Z);
+
+    TiledChannel* getChannel(const std::string& name);
+    const TiledChannel* getChannel(const std::string& name) const;
+
+    //! \brief Creates a named channel. If the channel already exists, returns
+    //! existing channel.
+    TiledChannel* createChannel(const std::string& name);
+    void removeChannel(const std::string& name);
+
+    TiledChannelContainer& getChannels()                { return m_channels.channels(); }
+    const TiledChannelContainer& getChannels() const    { return m_channels.channels(); }
+
+    TagContainer& getTags()                 { return m_tags; }
+    const TagContainer& getTags() const     { return m_tags; }
+
+    //! \brief Loads a resident \c Frame into the tiles
+    void copyFrom(const Frame& frame);
+    //! \brief Makes \a frame a resident copy of this frame.
+    //! \note \a frame must fit in memory
+    void copyTo(Frame& frame) const;
+
+    void swap(TiledFrame& other);
+
+private:
+    TiledFrame(const TiledFrame&);
+    TiledFrame& operator=(const TiledFrame&);
+
+    size_t m_width;
+    size_t m_height;
+    size_t m_stripRows;
+    TileCache* m_cache;
+
+    TagContainer m_tags;
+    ChannelSet<TiledChannel> m_channels;
+};
+
+typedef std::shared_ptr< pfs::TiledFrame > TiledFramePtr;
+
+} // namespace pfs
+
+#endif // PFS_TILEDFRAME_H
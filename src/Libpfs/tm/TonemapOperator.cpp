@@ -30,10 +30,14 @@
  */
 
 #include <map>
+#include <memory>
 #include <boost/assign.hpp>
-#include <boost/thread/mutex.hpp>
 
 #include "TonemappingOperators/pfstmo.h"
+#include "TonemappingOperators/mantiuk06/contrast_domain.h"
+#include "TonemappingOperators/mantiuk08/display_adaptive_tmo.h"
+#include "TonemappingOperators/pattanaik00/tmo_pattanaik00.h"
+#include "TonemappingOperators/reinhard02/tmo_reinhard02.h"
 
 #include "Libpfs/frame.h"
 #include "Libpfs/channel.h"
@@ -72,14 +76,26 @@ public:
                              opts->operator_options.mantiuk06options.saturationfactor,
                              opts->operator_options.mantiuk06options.detailfactor,
                              opts->operator_options.mantiuk06options.contrastequalization,
-                             ph);
+                             ph, bufferArena(), m_session.get());
         }
         catch (...)
         {
+            // the stages could be partially updated
+            if ( m_session ) m_session->clear();
             throw std::runtime_error("Tonemap Failed");
         }
     }
 
+    void resetSession()
+    {
+        if ( interactiveMode() )
+            m_session.reset(new Mantiuk06Session());
+        else
+            m_session.reset();
+    }
+
+private:
+    std::unique_ptr<Mantiuk06Session> m_session;
 };
 
 struct TonemapOperatorMantiuk08
@@ -89,22 +105,24 @@ struct TonemapOperatorMantiuk08
     {
         ph.setMaximum(100);
 
-        // Convert to CS_XYZ: tm operator now use this colorspace
-        pfs::Channel *X, *Y, *Z;
-        workingframe.getXYZChannels( X, Y, Z );
-        pfs::transformColorSpace(pfs::CS_RGB, X, Y, Z,
-                                 pfs::CS_XYZ, X, Y, Z);
-
         pfstmo_mantiuk08(workingframe,
                          opts->operator_options.mantiuk08options.colorsaturation,
                          opts->operator_options.mantiuk08options.contrastenhancement,
                          opts->operator_options.mantiuk08options.luminancelevel,
                          opts->operator_options.mantiuk08options.setluminance,
-                         ph);
+                         ph, m_sequenceState.get());
+    }
 
-        pfs::transformColorSpace(pfs::CS_XYZ, X, Y, Z,
-                                 pfs::CS_RGB, X, Y, Z);
+    void resetSequence()
+    {
+        if ( sequenceMode() )
+            m_sequenceState.reset(new datmoSequenceState(sequenceFps()));
+        else
+            m_sequenceState.reset();
     }
+
+private:
+    std::unique_ptr<datmoSequenceState> m_sequenceState;
 };
 
 struct TonemapOperatorFattal02
@@ -137,7 +155,7 @@ struct TonemapOperatorFattal02
                         opts->operator_options.fattaloptions.newfattal,
                         opts->operator_options.fattaloptions.fftsolver,
                         detail_level,
-                        ph);
+                        ph, bufferArena());
     }
 };
 
@@ -148,20 +166,13 @@ struct TonemapOperatorFerradans11
     {
         ph.setMaximum(100);
 
-        m_mutex.lock();
         pfstmo_ferradans11(workingframe,
                         opts->operator_options.ferradansoptions.rho,
                         opts->operator_options.ferradansoptions.inv_alpha,
                         ph);
-        m_mutex.unlock();
     }
-
-private:
-    static boost::mutex m_mutex;
 };
 
-boost::mutex TonemapOperatorFerradans11::m_mutex;
-
 struct TonemapOperatorMai11
         : public TonemapOperatorRegister<mai, TonemapOperatorMai11>
 {
@@ -193,30 +204,21 @@ class TonemapOperatorDurand02
     {
         ph.setMaximum(100);
 
-        // pfstmo_durand02 not reentrant
-        m_mutex.lock();
         try
         {
             pfstmo_durand02(workingframe,
                             opts->operator_options.durandoptions.spatial,
                             opts->operator_options.durandoptions.range,
                             opts->operator_options.durandoptions.base,
-                            ph);
+                            ph, bufferArena());
         }
         catch (...)
         {
-            m_mutex.unlock();
             throw std::runtime_error("Tonemap Failed");
         }
-        m_mutex.unlock();
     }
-
-private:
-    static boost::mutex m_mutex;
 };
 
-boost::mutex TonemapOperatorDurand02::m_mutex;
-
 
 struct TonemapOperatorReinhard02
         : public TonemapOperatorRegister<reinhard02, TonemapOperatorReinhard02>
@@ -231,7 +233,6 @@ struct TonemapOperatorReinhard02
         pfs::transformColorSpace(pfs::CS_RGB, X, Y, Z,
                                  pfs::CS_XYZ, X, Y, Z);
 
-        m_mutex.lock();
         try {
             pfstmo_reinhard02(workingframe,
                               opts->operator_options.reinhard02options.key,
@@ -240,24 +241,28 @@ struct TonemapOperatorReinhard02
                               opts->operator_options.reinhard02options.lower,
                               opts->operator_options.reinhard02options.upper,
                               opts->operator_options.reinhard02options.scales,
-                              ph);
+                              ph, m_temporalState.get());
         }
         catch (...) {
-            m_mutex.unlock();
             throw std::runtime_error("Tonemap Failed");
         }
-        m_mutex.unlock();
 
         pfs::transformColorSpace(pfs::CS_XYZ, X, Y, Z,
                                  pfs::CS_SRGB, X, Y, Z);
     }
 
+    void resetSequence()
+    {
+        if ( sequenceMode() )
+            m_temporalState.reset(new Reinhard02TemporalState());
+        else
+            m_temporalState.reset();
+    }
+
 private:
-    static boost::mutex m_mutex;
+    std::unique_ptr<Reinhard02TemporalState> m_temporalState;
 };
 
-boost::mutex TonemapOperatorReinhard02::m_mutex;
-
 struct TonemapOperatorReinhard05
         : public TonemapOperatorRegister<reinhard05, TonemapOperatorReinhard05>
 {
@@ -291,6 +296,10 @@ struct TonemapOperatorAshikhmin02
 struct TonemapOperatorPattanaik00
         : public TonemapOperatorRegister<pattanaik, TonemapOperatorPattanaik00>
 {
+    TonemapOperatorPattanaik00()
+        : m_dt(0.f)
+    {}
+
     void tonemapFrame(pfs::Frame& workingframe, TonemappingOptions* opts, pfs::Progress& ph)
     {
         ph.setMaximum(100);
@@ -307,12 +316,27 @@ struct TonemapOperatorPattanaik00
                            opts->operator_options.pattanaikoptions.cone*1000,
                            opts->operator_options.pattanaikoptions.rod*1000,
                            opts->operator_options.pattanaikoptions.autolum,
-                           ph);
-
+                           ph, m_sequenceModel.get(), m_dt);
+        // the following frames of the sequence adapt from this one
+        if ( m_sequenceModel )
+            m_dt = 1.0f/sequenceFps();
 
         pfs::transformColorSpace(pfs::CS_XYZ, X, Y, Z,
                                  pfs::CS_RGB, X, Y, Z);
     }
+
+    void resetSequence()
+    {
+        m_dt = 0.f;
+        if ( sequenceMode() )
+            m_sequenceModel.reset(new VisualAdaptationModel());
+        else
+            m_sequenceModel.reset();
+    }
+
+private:
+    std::unique_ptr<VisualAdaptationModel> m_sequenceModel;
+    float m_dt;
 };
 
 typedef TonemapOperator* (*TonemapOperatorCreator)();
@@ -340,11 +364,34 @@ const TonemapOperatorCreatorMap& registry()
 }
 
 TonemapOperator::TonemapOperator()
+    : m_arena(NULL)
+    , m_sequenceMode(false)
+    , m_sequenceFps(25.f)
+    , m_interactiveMode(false)
 {}
 
 TonemapOperator::~TonemapOperator()
 {}
 
+void TonemapOperator::setSequenceMode(bool enabled, float fps)
+{
+    m_sequenceMode = enabled;
+    m_sequenceFps = fps;
+    resetSequence();
+}
+
+void TonemapOperator::resetSequence()
+{}
+
+void TonemapOperator::setInteractiveMode(bool enabled)
+{
+    m_interactiveMode = enabled;
+    resetSession();
+}
+
+void TonemapOperator::resetSession()
+{}
+
 TonemapOperator* TonemapOperator::getTonemapOperator(const TMOperator tmo)
 {
     TonemapOperatorCreatorMap::const_iterator it = registry().find(tmo);
@@ -38,6 +38,7 @@
 // Forward declaration
 namespace pfs
 {
+class BufferArena;
 class Progress;
 class Frame;
 }
@@ -60,8 +61,54 @@ public:
     //!
     virtual void tonemapFrame(pfs::Frame&, TonemappingOptions*, pfs::Progress& ph) = 0;
 
+    //!
+    //! Operators that support it take the storage of their temporaries from
+    //! \a arena, so that consecutive calls reuse the same memory.
+    //! \note \a arena is not owned, and must outlive tonemapFrame()
+    //!
+    void setBufferArena(pfs::BufferArena* arena)    { m_arena = arena; }
+    pfs::BufferArena* bufferArena() const           { return m_arena; }
+
+    //!
+    //! In sequence mode consecutive calls to tonemapFrame() process the
+    //! frames of a video at \a fps frames per second: operators with a
+    //! temporal model (Pattanaik00, Reinhard02, Mantiuk08) carry their state
+    //! from one frame to the next instead of treating each as a still image.
+    //! Enabling or disabling the mode restarts the sequence.
+    //!
+    void setSequenceMode(bool enabled, float fps = 25.f);
+    bool sequenceMode() const                       { return m_sequenceMode; }
+    float sequenceFps() const                       { return m_sequenceFps; }
+
+    //!
+    //! Forgets the state carried across the frames, so that the next frame
+    //! starts a new sequence
+    //!
+    virtual void resetSequence();
+
+    //!
+    //! In interactive mode operators that support it (Mantiuk06) keep the
+    //! intermediate results of the last frame, so that tone mapping the same
+    //! frame again with other parameters (i.e. tweaking a slider) only
+    //! recomputes what depends on the changed ones. Disabling the mode frees
+    //! them.
+    //!
+    void setInteractiveMode(bool enabled);
+    bool interactiveMode() const                    { return m_interactiveMode; }
+
+    //!
+    //! Forgets the intermediate results kept in interactive mode
+    //!
+    virtual void resetSession();
+
 protected:
     TonemapOperator();
+
+private:
+    pfs::BufferArena* m_arena;
+    bool m_sequenceMode;
+    float m_sequenceFps;
+    bool m_interactiveMode;
 };
 
 #endif // TONEMAPOPERATOR_H
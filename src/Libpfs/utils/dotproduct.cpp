@@ -0,0 +1,70 @@
+/*
+ * This file is a part of Luminance HDR package
+ * ----------------------------------------------------------------------
+ * Copyright (C) 2017 Luminance HDR developers
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+
+#include <Libpfs/utils/dotproduct.h>
+#include <Libpfs/utils/simd.h>
+
+#include <algorithm>
+
+namespace pfs {
+namespace utils {
+
+namespace
+{
+const size_t CHUNK_SIZE = 1 << 14;
+}
+
+float dotProduct(const float* v1, const float* v2, size_t N)
+{
+    const simd::Kernels& k = simd::kernels();
+    if ( N <= CHUNK_SIZE ) return static_cast<float>(k.dot(v1, v2, N));
+
+    const int chunks = static_cast<int>((N + CHUNK_SIZE - 1)/CHUNK_SIZE);
+    double dotProd = 0.0;
+#pragma omp parallel for schedule(static) reduction(+:dotProd)
+    for (int chunk = 0; chunk < chunks; ++chunk)
+    {
+        const size_t offset = chunk*CHUNK_SIZE;
+        dotProd += k.dot(v1 + offset, v2 + offset,
+                         std::min(CHUNK_SIZE, N - offset));
+    }
+    return static_cast<float>(dotProd);
+}
+
+float dotProduct(const float* v1, size_t N)
+{
+    const simd::Kernels& k = simd::kernels();
+    if ( N <= CHUNK_SIZE ) return static_cast<float>(k.dotSelf(v1, N));
+
+    const int chunks = static_cast<int>((N + CHUNK_SIZE - 1)/CHUNK_SIZE);
+    double dotProd = 0.0;
+#pragma omp parallel for schedule(static) reduction(+:dotProd)
+    for (int chunk = 0; chunk < chunks; ++chunk)
+    {
+        const size_t offset = chunk*CHUNK_SIZE;
+        dotProd += k.dotSelf(v1 + offset, std::min(CHUNK_SIZE, N - offset));
+    }
+    return static_cast<float>(dotProd);
+}
+
+}   // utils
+}   // pfs
@@ -46,6 +46,11 @@ _Type dotProduct(const _Type* v1, const _Type* v2, size_t N);
 template <typename _Type>
 _Type dotProduct(const _Type* v1, size_t N);
 
+// Overloads for float vectors, running the SIMD kernels of simd.h. The sum
+// is accumulated in double precision.
+float dotProduct(const float* v1, const float* v2, size_t N);
+float dotProduct(const float* v1, size_t N);
+
 }   // utils
 }   // pfs
 
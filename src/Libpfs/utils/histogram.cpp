@@ -0,0 +1,145 @@
+/*
+ * This file is a part of Luminance HDR package
+ * ----------------------------------------------------------------------
+ * Copyright (C) 2017 Luminance HDR developers
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+#include <Libpfs/utils/histogram.h>
+
+#include <algorithm>
+#include <cmath>
+
+#include <Libpfs/array2d.h>
+
+namespace pfs {
+namespace utils {
+
+Histogram::Histogram(size_t bins, float min, float max, HistogramScale scale)
+    : m_min(min)
+    , m_max(max)
+    , m_scale(scale)
+    , m_binsPerUnit(max > min ? bins/(max - min) : 0.f)
+    , m_counts(bins, 0)
+    , m_total(0)
+{
+    assert(bins > 0);
+}
+
+size_t Histogram::bin(float sample) const
+{
+    if ( m_scale == HISTOGRAM_LOG10 )
+    {
+        if ( !(sample > 0.f) ) return bins();
+        sample = std::log10(sample);
+    }
+    // also skips NaNs
+    if ( !(sample >= m_min && sample <= m_max) ) return bins();
+
+    const size_t b = static_cast<size_t>((sample - m_min)*m_binsPerUnit);
+    return std::min(b, bins() - 1);
+}
+
+float Histogram::sample(size_t bin) const
+{
+    const float value = m_min + (m_max - m_min)*bin/bins();
+    return (m_scale == HISTOGRAM_LOG10) ? std::pow(10.f, value) : value;
+}
+
+size_t Histogram::maxCount() const
+{
+    return *std::max_element(m_counts.begin(), m_counts.end());
+}
+
+float Histogram::quantile(float q) const
+{
+    const size_t target = static_cast<size_t>(std::max(q, 0.f)*m_total + 0.5f);
+
+    size_t counter = 0;
+    for (size_t b = 0; b < bins(); ++b)
+    {
+        counter += m_counts[b];
+        if ( counter >= target && counter > 0 )
+        {
+            return sample(b);
+        }
+    }
+    return sample(bins() - 1);
+}
+
+void Histogram::merge(const Histogram& other)
+{
+    assert(other.bins() == bins());
+    for (size_t b = 0; b < bins(); ++b)
+    {
+        m_counts[b] += other.m_counts[b];
+    }
+    m_total += other.m_total;
+}
+
+void Histogram::clear()
+{
+    std::fill(m_counts.begin(), m_counts.end(), 0);
+    m_total = 0;
+}
+
+namespace
+{
+struct ChannelSamples
+{
+    ChannelSamples(const float* c0, const float* c1 = NULL, const float* c2 = NULL)
+    {
+        channels[0] = c0;
+        channels[1] = c1;
+        channels[2] = c2;
+    }
+
+    void operator()(size_t i, float* values) const
+    {
+        for (int c = 0; c < 3 && channels[c] != NULL; ++c)
+        {
+            values[c] = channels[c][i];
+        }
+    }
+
+    const float* channels[3];
+};
+}
+
+void computeHistogram(const Array2Df& channel, Histogram& histogram, size_t step)
+{
+    computeHistograms(channel.size(), &histogram, 1,
+                      ChannelSamples(channel.data()), step);
+}
+
+void computeHistograms(const Array2Df& R, const Array2Df& G, const Array2Df& B,
+                       Histogram& histR, Histogram& histG, Histogram& histB,
+                       size_t step)
+{
+    assert(R.size() == G.size() && R.size() == B.size());
+
+    Histogram histograms[3] = { histR, histG, histB };
+    computeHistograms(R.size(), histograms, 3,
+                      ChannelSamples(R.data(), G.data(), B.data()), step);
+
+    histR = histograms[0];
+    histG = histograms[1];
+    histB = histograms[2];
+}
+
+}   // utils
+}   // pfs
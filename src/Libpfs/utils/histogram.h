@@ -0,0 +1,121 @@
+/*
+ * This file is a part of Luminance HDR package
+ * ----------------------------------------------------------------------
+ * Copyright (C) 2017 Luminance HDR developers
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+//! \brief Histograms of channels and of interleaved samples, computed in a
+//! single parallel pass, with quantile queries
+
+#ifndef PFS_UTILS_HISTOGRAM_H
+#define PFS_UTILS_HISTOGRAM_H
+
+#include <cstddef>
+#include <vector>
+
+#include <Libpfs/array2d_fwd.h>
+
+namespace pfs {
+namespace utils {
+
+enum HistogramScale
+{
+    HISTOGRAM_LINEAR = 0,
+    //! bins are uniform in log10 of the samples: non positive samples are
+    //! skipped, and the range is given in log10 units
+    HISTOGRAM_LOG10 = 1
+};
+
+//! \brief Histogram of the samples falling in [min, max]
+class Histogram
+{
+public:
+    Histogram(size_t bins = 256, float min = 0.f, float max = 1.f,
+              HistogramScale scale = HISTOGRAM_LINEAR);
+
+    size_t bins() const             { return m_counts.size(); }
+    float min() const               { return m_min; }
+    float max() const               { return m_max; }
+    HistogramScale scale() const    { return m_scale; }
+
+    //! \return bin of \a sample, or bins() if the sample is out of range
+    size_t bin(float sample) const;
+
+    //! \return sample at the lower bound of \a bin
+    float sample(size_t bin) const;
+
+    size_t count(size_t bin) const  { return m_counts[bin]; }
+    const std::vector<size_t>& counts() const { return m_counts; }
+
+    //! \return number of samples in range
+    size_t total() const            { return m_total; }
+
+    //! \return count of the fullest bin
+    size_t maxCount() const;
+
+    //! \return sample below which falls the fraction \a q of the samples,
+    //! with the accuracy of a bin
+    float quantile(float q) const;
+
+    void add(float sample)
+    {
+        const size_t b = bin(sample);
+        if ( b < bins() )
+        {
+            ++m_counts[b];
+            ++m_total;
+        }
+    }
+
+    //! \brief adds the counts of \a other, which must have the same range
+    //! and number of bins
+    void merge(const Histogram& other);
+
+    void clear();
+
+private:
+    float m_min;
+    float m_max;
+    HistogramScale m_scale;
+    float m_binsPerUnit;
+    std::vector<size_t> m_counts;
+    size_t m_total;
+};
+
+//! \brief Fills \a numHistograms histograms in one parallel pass over the
+//! elements [0, size[, visiting one element every \a step.
+//! \a samples(i, values) stores in values[h] the sample of the element i
+//! for the histogram h (at most 4 histograms).
+template <typename SampleOp>
+void computeHistograms(size_t size, Histogram* histograms, size_t numHistograms,
+                       const SampleOp& samples, size_t step = 1);
+
+//! \brief histogram of \a channel, from one sample every \a step
+void computeHistogram(const Array2Df& channel, Histogram& histogram,
+                      size_t step = 1);
+
+//! \brief histograms of three channels in one pass
+void computeHistograms(const Array2Df& R, const Array2Df& G, const Array2Df& B,
+                       Histogram& histR, Histogram& histG, Histogram& histB,
+                       size_t step = 1);
+
+}   // utils
+}   // pfs
+
+#include <Libpfs/utils/histogram.hxx>
+#endif // PFS_UTILS_HISTOGRAM_H
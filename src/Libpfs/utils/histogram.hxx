@@ -0,0 +1,77 @@
+/*
+ * This file is a part of Luminance HDR package
+ * ----------------------------------------------------------------------
+ * Copyright (C) 2017 Luminance HDR developers
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+#ifndef PFS_UTILS_HISTOGRAM_HXX
+#define PFS_UTILS_HISTOGRAM_HXX
+
+#include <Libpfs/utils/histogram.h>
+
+#include <cassert>
+
+namespace pfs {
+namespace utils {
+
+template <typename SampleOp>
+void computeHistograms(size_t size, Histogram* histograms, size_t numHistograms,
+                       const SampleOp& samples, size_t step)
+{
+    assert(numHistograms <= 4);
+    if ( step < 1 ) step = 1;
+
+    for (size_t h = 0; h < numHistograms; ++h)
+    {
+        histograms[h].clear();
+    }
+    const long numSamples = static_cast<long>((size + step - 1)/step);
+    // empty histograms with the same range and bins: the threads must not
+    // copy \a histograms, that the faster ones already merge into
+    const std::vector<Histogram> empty(histograms, histograms + numHistograms);
+
+#pragma omp parallel
+    {
+        // every thread counts in its own copy, merged at the end
+        std::vector<Histogram> local(empty);
+        float values[4];
+
+#pragma omp for schedule(static) nowait
+        for (long s = 0; s < numSamples; ++s)
+        {
+            samples(static_cast<size_t>(s)*step, values);
+            for (size_t h = 0; h < numHistograms; ++h)
+            {
+                local[h].add(values[h]);
+            }
+        }
+
+#pragma omp critical
+        {
+            for (size_t h = 0; h < numHistograms; ++h)
+            {
+                histograms[h].merge(local[h]);
+            }
+        }
+    }
+}
+
+}   // utils
+}   // pfs
+
+#endif // PFS_UTILS_HISTOGRAM_HXX
@@ -0,0 +1,115 @@
+/*
+ * This file is a part of Luminance HDR package
+ * ----------------------------------------------------------------------
+ * Copyright (C) 2017 Luminance HDR developers
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+#include <Libpfs/utils/mappedfile.h>
+#include <Libpfs/exception.h>
+
+#ifdef _WIN32
+#define _WINSOCKAPI_    // stops windows.h including winsock.h
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace pfs {
+namespace utils {
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const std::string& filename)
+    : m_data(NULL)
+    , m_size(0)
+    , m_file(INVALID_HANDLE_VALUE)
+    , m_mapping(NULL)
+{
+    m_file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                         NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if ( m_file == INVALID_HANDLE_VALUE ) {
+        throw pfs::Exception("MappedFile: cannot open " + filename);
+    }
+
+    LARGE_INTEGER fileSize;
+    if ( !GetFileSizeEx(m_file, &fileSize) || fileSize.QuadPart == 0 ) {
+        CloseHandle(m_file);
+        throw pfs::Exception("MappedFile: cannot map empty file " + filename);
+    }
+    m_size = static_cast<size_t>(fileSize.QuadPart);
+
+    m_mapping = CreateFileMappingA(m_file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if ( m_mapping == NULL ) {
+        CloseHandle(m_file);
+        throw pfs::Exception("MappedFile: cannot map " + filename);
+    }
+
+    m_data = static_cast<const char*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+    if ( m_data == NULL ) {
+        CloseHandle(m_mapping);
+        CloseHandle(m_file);
+        throw pfs::Exception("MappedFile: cannot map " + filename);
+    }
+}
+
+MappedFile::~MappedFile()
+{
+    UnmapViewOfFile(m_data);
+    CloseHandle(m_mapping);
+    CloseHandle(m_file);
+}
+
+#else
+
+MappedFile::MappedFile(const std::string& filename)
+    : m_data(NULL)
+    , m_size(0)
+{
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if ( fd < 0 ) {
+        throw pfs::Exception("MappedFile: cannot open " + filename);
+    }
+
+    struct stat fileStat;
+    if ( fstat(fd, &fileStat) != 0 || fileStat.st_size == 0 ) {
+        ::close(fd);
+        throw pfs::Exception("MappedFile: cannot map empty file " + filename);
+    }
+    m_size = static_cast<size_t>(fileStat.st_size);
+
+    void* addr = mmap(NULL, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // the mapping stays valid after the descriptor is closed
+    ::close(fd);
+    if ( addr == MAP_FAILED ) {
+        throw pfs::Exception("MappedFile: cannot map " + filename);
+    }
+    m_data = static_cast<const char*>(addr);
+}
+
+MappedFile::~MappedFile()
+{
+    munmap(const_cast<char*>(m_data), m_size);
+}
+
+#endif
+
+}   // utils
+}   // pfs
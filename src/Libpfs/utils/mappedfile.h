@@ -0,0 +1,65 @@
+/*
+ * This file is a part of Luminance HDR package
+ * ----------------------------------------------------------------------
+ * Copyright (C) 2017 Luminance HDR developers
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+#ifndef PFS_UTILS_MAPPEDFILE_H
+#define PFS_UTILS_MAPPEDFILE_H
+
+//! \file mappedfile.h
+//! \brief Read-only memory mapping of a file
+
+#include <string>
+#include <cstddef>
+#include <memory>
+
+namespace pfs {
+namespace utils {
+
+//! \brief Maps the whole content of a file in memory, read-only.
+//! The mapping is released when the object is destroyed.
+class MappedFile
+{
+public:
+    //! \brief maps \a filename
+    //! \throw pfs::Exception if the file cannot be opened or mapped
+    explicit MappedFile(const std::string& filename);
+    ~MappedFile();
+
+    const char* data() const    { return m_data; }
+    size_t size() const         { return m_size; }
+
+private:
+    MappedFile(const MappedFile&);
+    MappedFile& operator=(const MappedFile&);
+
+    const char* m_data;
+    size_t      m_size;
+#ifdef _WIN32
+    void*       m_file;
+    void*       m_mapping;
+#endif
+};
+
+typedef std::shared_ptr<MappedFile> MappedFilePtr;
+
+}   // utils
+}   // pfs
+
+#endif // PFS_UTILS_MAPPEDFILE_H
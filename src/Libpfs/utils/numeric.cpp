@@ -0,0 +1,177 @@
+/*
+ * This file is a part of Luminance HDR package
+ * ----------------------------------------------------------------------
+ * Copyright (C) 2017 Luminance HDR developers
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+
+#include <Libpfs/utils/numeric.h>
+#include <Libpfs/utils/simd.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace pfs {
+namespace utils {
+
+namespace
+{
+// Below this size the cost of waking up the threads is larger than the
+// gain. Chunks are a multiple of the widest vector (16 floats).
+const size_t MIN_PARALLEL_SIZE = 1 << 15;
+const size_t CHUNK_SIZE = 1 << 14;
+
+typedef void (*BinaryKernel)(const float*, const float*, float*, size_t);
+typedef void (*ScalarKernel)(const float*, float, float*, size_t);
+
+int numChunks(size_t size)
+{
+    return static_cast<int>((size + CHUNK_SIZE - 1)/CHUNK_SIZE);
+}
+
+void run(BinaryKernel kernel, const float* A, const float* B, float* C, size_t size)
+{
+    if ( size < MIN_PARALLEL_SIZE )
+    {
+        kernel(A, B, C, size);
+        return;
+    }
+#pragma omp parallel for schedule(static)
+    for (int chunk = 0; chunk < numChunks(size); ++chunk)
+    {
+        const size_t offset = chunk*CHUNK_SIZE;
+        kernel(A + offset, B + offset, C + offset,
+               std::min(CHUNK_SIZE, size - offset));
+    }
+}
+
+void run(ScalarKernel kernel, const float* A, float s, float* B, size_t size)
+{
+    if ( size < MIN_PARALLEL_SIZE )
+    {
+        kernel(A, s, B, size);
+        return;
+    }
+#pragma omp parallel for schedule(static)
+    for (int chunk = 0; chunk < numChunks(size); ++chunk)
+    {
+        const size_t offset = chunk*CHUNK_SIZE;
+        kernel(A + offset, s, B + offset, std::min(CHUNK_SIZE, size - offset));
+    }
+}
+
+void runAdds(const float* A, float s, const float* B, float* C, size_t size)
+{
+    const simd::Kernels& k = simd::kernels();
+    if ( size < MIN_PARALLEL_SIZE )
+    {
+        k.adds(A, s, B, C, size);
+        return;
+    }
+#pragma omp parallel for schedule(static)
+    for (int chunk = 0; chunk < numChunks(size); ++chunk)
+    {
+        const size_t offset = chunk*CHUNK_SIZE;
+        k.adds(A + offset, s, B + offset, C + offset,
+               std::min(CHUNK_SIZE, size - offset));
+    }
+}
+
+// log2(e) and log2(10)
+const float LOG2_E = 1.44269504088896340736f;
+const float LOG2_10 = 3.32192809488736234787f;
+}
+
+void vmul(const float* A, const float* B, float* C, size_t size)
+{
+    run(simd::kernels().mul, A, B, C, size);
+}
+
+void vdiv(const float* A, const float* B, float* C, size_t size)
+{
+    run(simd::kernels().div, A, B, C, size);
+}
+
+void vadd(const float* A, const float* B, float* C, size_t size)
+{
+    run(simd::kernels().add, A, B, C, size);
+}
+
+void vsadd(const float* A, const float s, float* B, size_t size)
+{
+    run(simd::kernels().sadd, A, s, B, size);
+}
+
+void vadds(const float* A, const float& s, const float* B, float* C, size_t size)
+{
+    runAdds(A, s, B, C, size);
+}
+
+void vsub(const float* A, const float* B, float* C, size_t size)
+{
+    run(simd::kernels().sub, A, B, C, size);
+}
+
+void vsubs(const float* A, const float& s, const float* B, float* C, size_t size)
+{
+    runAdds(A, -s, B, C, size);
+}
+
+void vsmul(const float* I, const float c, float* O, size_t size)
+{
+    run(simd::kernels().smul, I, c, O, size);
+}
+
+void vlog(const float* A, float* B, size_t size)
+{
+    // ln(x) = log2(x)/log2(e)
+    run(simd::kernels().log2s, A, 1.f/LOG2_E, B, size);
+}
+
+void vlog2(const float* A, float* B, size_t size)
+{
+    run(simd::kernels().log2s, A, 1.f, B, size);
+}
+
+void vlog10(const float* A, float* B, size_t size)
+{
+    run(simd::kernels().log2s, A, 1.f/LOG2_10, B, size);
+}
+
+void vexp(const float* A, float* B, size_t size)
+{
+    run(simd::kernels().exp2s, A, LOG2_E, B, size);
+}
+
+void vexp2(const float* A, float* B, size_t size)
+{
+    run(simd::kernels().exp2s, A, 1.f, B, size);
+}
+
+void vexp10(const float* A, float* B, size_t size)
+{
+    run(simd::kernels().exp2s, A, LOG2_10, B, size);
+}
+
+void vpow(const float* A, float e, float* B, size_t size)
+{
+    run(simd::kernels().pow, A, e, B, size);
+}
+
+}   // utils
+}   // pfs
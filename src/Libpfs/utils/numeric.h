@@ -113,6 +113,34 @@ void vmul_scalar(const _Type* I, const float c, _Type* O, size_t size);
 
 template <typename _Type>
 void vdiv_scalar(const _Type* I, float c, _Type* O, size_t size);
+
+// Overloads for float vectors: they are preferred to the templates above and
+// run the SIMD kernels of simd.h, split among the OpenMP threads
+void vmul(const float* A, const float* B, float* C, size_t size);
+void vdiv(const float* A, const float* B, float* C, size_t size);
+void vadd(const float* A, const float* B, float* C, size_t size);
+void vsadd(const float* A, const float s, float* B, size_t size);
+void vadds(const float* A, const float& s, const float* B, float* C, size_t size);
+void vsub(const float* A, const float* B, float* C, size_t size);
+void vsubs(const float* A, const float& s, const float* B, float* C, size_t size);
+void vsmul(const float* I, const float c, float* O, size_t size);
+
+//! \brief B[i] = log(A[i]) (natural logarithm), for positive \c A[i]
+//! \note the vectorised versions of the transcendental functions have a
+//! relative error lower than 1e-5
+void vlog(const float* A, float* B, size_t size);
+//! \brief B[i] = log2(A[i]), for positive \c A[i]
+void vlog2(const float* A, float* B, size_t size);
+//! \brief B[i] = log10(A[i]), for positive \c A[i]
+void vlog10(const float* A, float* B, size_t size);
+//! \brief B[i] = exp(A[i])
+void vexp(const float* A, float* B, size_t size);
+//! \brief B[i] = 2^A[i]
+void vexp2(const float* A, float* B, size_t size);
+//! \brief B[i] = 10^A[i]
+void vexp10(const float* A, float* B, size_t size);
+//! \brief B[i] = A[i]^e for positive \c A[i], 0 otherwise
+void vpow(const float* A, float e, float* B, size_t size);
 }   // utils
 }   // pfs
 
@@ -53,7 +53,7 @@ void vmul(const _Type* A, const _Type* B, _Type* C, size_t size)
 #pragma omp parallel for
     for (int idx = 0; idx < static_cast<int>(size); idx++)
     {
-        (*C)(idx) = (*A)(idx) * (*B)(idx);
+        C[idx] = A[idx] * B[idx];
     }
 }
 
@@ -70,7 +70,7 @@ void vadd(const _Type* A, const _Type* B, _Type* C, size_t size)
 #pragma omp parallel for
     for (int idx = 0; idx < static_cast<int>(size); idx++)
     {
-        (*C)(idx) = (*A)(idx) + (*B)(idx);
+        C[idx] = A[idx] + B[idx];
     }
 }
 
@@ -0,0 +1,243 @@
+/*
+ * This file is a part of Luminance HDR package
+ * ----------------------------------------------------------------------
+ * Copyright (C) 2017 Luminance HDR developers
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+#include <Libpfs/utils/simd.h>
+#include <Libpfs/utils/simd_p.h>
+
+#include <algorithm>
+#include <cmath>
+
+#ifdef PFS_SIMD_X86
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+namespace pfs {
+namespace utils {
+
+namespace
+{
+#ifdef PFS_SIMD_X86
+void cpuid(int leaf, int subleaf, unsigned info[4])
+{
+#if defined(_MSC_VER)
+    int regs[4];
+    __cpuidex(regs, leaf, subleaf);
+    for (int i = 0; i < 4; ++i) info[i] = static_cast<unsigned>(regs[i]);
+#else
+    __cpuid_count(leaf, subleaf, info[0], info[1], info[2], info[3]);
+#endif
+}
+
+// register state enabled by the OS (XCR0)
+unsigned long long xgetbv0()
+{
+#if defined(_MSC_VER)
+    return _xgetbv(0);
+#else
+    unsigned eax, edx;
+    __asm__ __volatile__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return (static_cast<unsigned long long>(edx) << 32) | eax;
+#endif
+}
+
+SimdInstructionSet detectInstructionSet()
+{
+    unsigned info[4];
+    cpuid(0, 0, info);
+    const unsigned maxLeaf = info[0];
+
+    cpuid(1, 0, info);
+    const bool sse2 = (info[3] & (1u << 26)) != 0;
+    const bool fma = (info[2] & (1u << 12)) != 0;
+    const bool osxsave = (info[2] & (1u << 27)) != 0;
+    const bool avx = (info[2] & (1u << 28)) != 0;
+    if ( !sse2 ) return SIMD_SCALAR;
+    if ( !(osxsave && avx && fma) || maxLeaf < 7 ) return SIMD_SSE2;
+
+    const unsigned long long xcr0 = xgetbv0();
+    // XMM and YMM state
+    if ( (xcr0 & 0x6) != 0x6 ) return SIMD_SSE2;
+
+    cpuid(7, 0, info);
+    const bool avx2 = (info[1] & (1u << 5)) != 0;
+    const bool avx512f = (info[1] & (1u << 16)) != 0;
+    if ( !avx2 ) return SIMD_SSE2;
+    // opmask, upper ZMM0-15 and ZMM16-31 state
+    if ( !avx512f || (xcr0 & 0xE0) != 0xE0 ) return SIMD_AVX2;
+
+    return SIMD_AVX512;
+}
+#else
+SimdInstructionSet detectInstructionSet()
+{
+    return SIMD_SCALAR;
+}
+#endif
+
+struct SimdState
+{
+    SimdState()
+        : supported(detectInstructionSet())
+        , current(supported)
+    {}
+
+    const SimdInstructionSet supported;
+    SimdInstructionSet current;
+};
+
+SimdState& state()
+{
+    static SimdState s_state;
+    return s_state;
+}
+}
+
+SimdInstructionSet simdSupportedInstructionSet()
+{
+    return state().supported;
+}
+
+SimdInstructionSet simdInstructionSet()
+{
+    return state().current;
+}
+
+SimdInstructionSet setSimdInstructionSet(SimdInstructionSet isa)
+{
+    state().current = std::min(isa, state().supported);
+    return state().current;
+}
+
+const char* simdInstructionSetName(SimdInstructionSet isa)
+{
+    switch (isa)
+    {
+    case SIMD_SSE2:     return "SSE2";
+    case SIMD_AVX2:     return "AVX2";
+    case SIMD_AVX512:   return "AVX-512";
+    case SIMD_SCALAR:
+    default:            return "scalar";
+    }
+}
+
+namespace simd {
+
+namespace
+{
+void add(const float* A, const float* B, float* C, size_t size)
+{
+    for (size_t i = 0; i < size; ++i) C[i] = A[i] + B[i];
+}
+
+void sub(const float* A, const float* B, float* C, size_t size)
+{
+    for (size_t i = 0; i < size; ++i) C[i] = A[i] - B[i];
+}
+
+void mul(const float* A, const float* B, float* C, size_t size)
+{
+    for (size_t i = 0; i < size; ++i) C[i] = A[i] * B[i];
+}
+
+void div(const float* A, const float* B, float* C, size_t size)
+{
+    for (size_t i = 0; i < size; ++i) C[i] = A[i] / B[i];
+}
+
+void sadd(const float* A, float s, float* B, size_t size)
+{
+    for (size_t i = 0; i < size; ++i) B[i] = A[i] + s;
+}
+
+void smul(const float* A, float s, float* B, size_t size)
+{
+    for (size_t i = 0; i < size; ++i) B[i] = A[i] * s;
+}
+
+void adds(const float* A, float s, const float* B, float* C, size_t size)
+{
+    for (size_t i = 0; i < size; ++i) C[i] = A[i] + s*B[i];
+}
+
+double dot(const float* A, const float* B, size_t size)
+{
+    double result = 0.0;
+    for (size_t i = 0; i < size; ++i) result += A[i] * B[i];
+    return result;
+}
+
+double dotSelf(const float* A, size_t size)
+{
+    double result = 0.0;
+    for (size_t i = 0; i < size; ++i) result += A[i] * A[i];
+    return result;
+}
+
+void log2s(const float* A, float s, float* B, size_t size)
+{
+    for (size_t i = 0; i < size; ++i) B[i] = s*std::log2(A[i]);
+}
+
+void exp2s(const float* A, float s, float* B, size_t size)
+{
+    for (size_t i = 0; i < size; ++i) B[i] = std::exp2(s*A[i]);
+}
+
+void pow(const float* A, float e, float* B, size_t size)
+{
+    for (size_t i = 0; i < size; ++i) B[i] = (A[i] > 0.f) ? std::pow(A[i], e) : 0.f;
+}
+}
+
+const Kernels& scalarKernels()
+{
+    static const Kernels s_kernels = {
+        add, sub, mul, div, sadd, smul, adds, dot, dotSelf, log2s, exp2s, pow
+    };
+    return s_kernels;
+}
+
+const Kernels& kernels(SimdInstructionSet isa)
+{
+    switch (isa)
+    {
+#ifdef PFS_SIMD_X86
+    case SIMD_AVX512:   return avx512Kernels();
+    case SIMD_AVX2:     return avx2Kernels();
+    case SIMD_SSE2:     return sse2Kernels();
+#endif
+    case SIMD_SCALAR:
+    default:            return scalarKernels();
+    }
+}
+
+const Kernels& kernels()
+{
+    return kernels(state().current);
+}
+
+}   // simd
+}   // utils
+}   // pfs
@@ -0,0 +1,103 @@
+/*
+ * This file is a part of Luminance HDR package
+ * ----------------------------------------------------------------------
+ * Copyright (C) 2017 Luminance HDR developers
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+#ifndef PFS_UTILS_SIMD_H
+#define PFS_UTILS_SIMD_H
+
+#include <cstddef>
+
+//! \file simd.h
+//! \brief Vectorised kernels for float arrays, with the instruction set
+//! chosen at runtime
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define PFS_SIMD_X86
+#endif
+
+namespace pfs {
+namespace utils {
+
+enum SimdInstructionSet
+{
+    SIMD_SCALAR = 0,
+    SIMD_SSE2,
+    SIMD_AVX2,
+    SIMD_AVX512
+};
+
+//! \brief best instruction set supported by the running CPU
+SimdInstructionSet simdSupportedInstructionSet();
+
+//! \brief instruction set currently used by the kernels
+SimdInstructionSet simdInstructionSet();
+
+//! \brief forces the kernels to use \a isa (i.e. to compare results or
+//! timings). Requests above the supported instruction set are lowered.
+//! \return the instruction set actually selected
+SimdInstructionSet setSimdInstructionSet(SimdInstructionSet isa);
+
+const char* simdInstructionSetName(SimdInstructionSet isa);
+
+namespace simd {
+
+//! \brief Table of kernels for a single instruction set. Every kernel works
+//! on one contiguous range in the calling thread: multithreaded versions are
+//! provided by numeric.h and dotproduct.h.
+//! Input and output arrays may be the same; no alignment is required.
+struct Kernels
+{
+    //! C[i] = A[i] + B[i]
+    void (*add)(const float* A, const float* B, float* C, size_t size);
+    //! C[i] = A[i] - B[i]
+    void (*sub)(const float* A, const float* B, float* C, size_t size);
+    //! C[i] = A[i] * B[i]
+    void (*mul)(const float* A, const float* B, float* C, size_t size);
+    //! C[i] = A[i] / B[i]
+    void (*div)(const float* A, const float* B, float* C, size_t size);
+    //! B[i] = A[i] + s
+    void (*sadd)(const float* A, float s, float* B, size_t size);
+    //! B[i] = A[i] * s
+    void (*smul)(const float* A, float s, float* B, size_t size);
+    //! C[i] = A[i] + s*B[i]
+    void (*adds)(const float* A, float s, const float* B, float* C, size_t size);
+    //! \sum{A[i]*B[i]}, accumulated in double precision
+    double (*dot)(const float* A, const float* B, size_t size);
+    //! \sum{A[i]*A[i]}, accumulated in double precision
+    double (*dotSelf)(const float* A, size_t size);
+    //! B[i] = s*log2(A[i]), for positive \c A[i]
+    void (*log2s)(const float* A, float s, float* B, size_t size);
+    //! B[i] = 2^(s*A[i])
+    void (*exp2s)(const float* A, float s, float* B, size_t size);
+    //! B[i] = A[i]^e for positive \c A[i], 0 otherwise
+    void (*pow)(const float* A, float e, float* B, size_t size);
+};
+
+//! \brief kernels of the current instruction set
+const Kernels& kernels();
+
+//! \brief kernels of \a isa, which must be supported by the CPU
+const Kernels& kernels(SimdInstructionSet isa);
+
+}   // simd
+}   // utils
+}   // pfs
+
+#endif // PFS_UTILS_SIMD_H
@@ -0,0 +1,243 @@
+/*
+ * This file is a part of Luminance HDR package
+ * ----------------------------------------------------------------------
+ * Copyright (C) 2017 Luminance HDR developers
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+//! \brief AVX2 + FMA kernels (8 floats per vector)
+
+#include <Libpfs/utils/simd_p.h>
+
+#ifdef PFS_SIMD_X86
+
+#include <cmath>
+#include <immintrin.h>
+
+#define AVX2_TARGET PFS_SIMD_TARGET("avx2,fma")
+
+namespace pfs {
+namespace utils {
+namespace simd {
+
+namespace
+{
+AVX2_TARGET inline
+__m256 exp2_ps(__m256 x)
+{
+    x = _mm256_min_ps(x, _mm256_set1_ps(EXP2_MAX));
+    x = _mm256_max_ps(x, _mm256_set1_ps(EXP2_MIN));
+
+    __m256i ipart = _mm256_cvtps_epi32(_mm256_sub_ps(x, _mm256_set1_ps(0.5f)));
+    __m256 fpart = _mm256_sub_ps(x, _mm256_cvtepi32_ps(ipart));
+    __m256 expipart = _mm256_castsi256_ps(
+                _mm256_slli_epi32(_mm256_add_epi32(ipart, _mm256_set1_epi32(127)), 23));
+
+    __m256 p = _mm256_set1_ps(EXP2_P5);
+    p = _mm256_fmadd_ps(p, fpart, _mm256_set1_ps(EXP2_P4));
+    p = _mm256_fmadd_ps(p, fpart, _mm256_set1_ps(EXP2_P3));
+    p = _mm256_fmadd_ps(p, fpart, _mm256_set1_ps(EXP2_P2));
+    p = _mm256_fmadd_ps(p, fpart, _mm256_set1_ps(EXP2_P1));
+    p = _mm256_fmadd_ps(p, fpart, _mm256_set1_ps(EXP2_P0));
+
+    return _mm256_mul_ps(expipart, p);
+}
+
+AVX2_TARGET inline
+__m256 log2_ps(__m256 x)
+{
+    const __m256i expMask = _mm256_set1_epi32(0x7F800000);
+    const __m256i mantMask = _mm256_set1_epi32(0x007FFFFF);
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 half = _mm256_set1_ps(0.5f);
+
+    __m256i i = _mm256_castps_si256(x);
+    __m256 e = _mm256_cvtepi32_ps(
+                _mm256_sub_epi32(_mm256_srli_epi32(_mm256_and_si256(i, expMask), 23),
+                                 _mm256_set1_epi32(127)));
+    __m256 m = _mm256_or_ps(_mm256_castsi256_ps(_mm256_and_si256(i, mantMask)), one);
+
+    // moves the mantissa in [sqrt(0.5), sqrt(2)[
+    __m256 big = _mm256_cmp_ps(m, _mm256_set1_ps(SQRT_2), _CMP_GT_OQ);
+    e = _mm256_add_ps(e, _mm256_and_ps(big, one));
+    m = _mm256_sub_ps(m, _mm256_and_ps(big, _mm256_mul_ps(m, half)));
+    m = _mm256_sub_ps(m, one);
+
+    __m256 p = _mm256_set1_ps(LOG_P0);
+    p = _mm256_fmadd_ps(p, m, _mm256_set1_ps(LOG_P1));
+    p = _mm256_fmadd_ps(p, m, _mm256_set1_ps(LOG_P2));
+    p = _mm256_fmadd_ps(p, m, _mm256_set1_ps(LOG_P3));
+    p = _mm256_fmadd_ps(p, m, _mm256_set1_ps(LOG_P4));
+    p = _mm256_fmadd_ps(p, m, _mm256_set1_ps(LOG_P5));
+    p = _mm256_fmadd_ps(p, m, _mm256_set1_ps(LOG_P6));
+    p = _mm256_fmadd_ps(p, m, _mm256_set1_ps(LOG_P7));
+    p = _mm256_fmadd_ps(p, m, _mm256_set1_ps(LOG_P8));
+
+    __m256 m2 = _mm256_mul_ps(m, m);
+    p = _mm256_fnmadd_ps(half, m2, _mm256_mul_ps(_mm256_mul_ps(p, m), m2));
+
+    // log2(x) = e + log(m)*log2(e)
+    return _mm256_fmadd_ps(_mm256_add_ps(m, p), _mm256_set1_ps(LOG2_E), e);
+}
+
+AVX2_TARGET inline
+double hsum_pd(__m256d v)
+{
+    __m128d s = _mm_add_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+    return _mm_cvtsd_f64(_mm_add_sd(s, _mm_unpackhi_pd(s, s)));
+}
+
+AVX2_TARGET
+void add(const float* A, const float* B, float* C, size_t size)
+{
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8)
+        _mm256_storeu_ps(C + i, _mm256_add_ps(_mm256_loadu_ps(A + i), _mm256_loadu_ps(B + i)));
+    for (; i < size; ++i) C[i] = A[i] + B[i];
+}
+
+AVX2_TARGET
+void sub(const float* A, const float* B, float* C, size_t size)
+{
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8)
+        _mm256_storeu_ps(C + i, _mm256_sub_ps(_mm256_loadu_ps(A + i), _mm256_loadu_ps(B + i)));
+    for (; i < size; ++i) C[i] = A[i] - B[i];
+}
+
+AVX2_TARGET
+void mul(const float* A, const float* B, float* C, size_t size)
+{
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8)
+        _mm256_storeu_ps(C + i, _mm256_mul_ps(_mm256_loadu_ps(A + i), _mm256_loadu_ps(B + i)));
+    for (; i < size; ++i) C[i] = A[i] * B[i];
+}
+
+AVX2_TARGET
+void div(const float* A, const float* B, float* C, size_t size)
+{
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8)
+        _mm256_storeu_ps(C + i, _mm256_div_ps(_mm256_loadu_ps(A + i), _mm256_loadu_ps(B + i)));
+    for (; i < size; ++i) C[i] = A[i] / B[i];
+}
+
+AVX2_TARGET
+void sadd(const float* A, float s, float* B, size_t size)
+{
+    const __m256 vs = _mm256_set1_ps(s);
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8)
+        _mm256_storeu_ps(B + i, _mm256_add_ps(_mm256_loadu_ps(A + i), vs));
+    for (; i < size; ++i) B[i] = A[i] + s;
+}
+
+AVX2_TARGET
+void smul(const float* A, float s, float* B, size_t size)
+{
+    const __m256 vs = _mm256_set1_ps(s);
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8)
+        _mm256_storeu_ps(B + i, _mm256_mul_ps(_mm256_loadu_ps(A + i), vs));
+    for (; i < size; ++i) B[i] = A[i] * s;
+}
+
+AVX2_TARGET PFS_SIMD_NO_FMA
+void adds(const float* A, float s, const float* B, float* C, size_t size)
+{
+    const __m256 vs = _mm256_set1_ps(s);
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8)
+        _mm256_storeu_ps(C + i, _mm256_add_ps(_mm256_loadu_ps(A + i),
+                                              _mm256_mul_ps(vs, _mm256_loadu_ps(B + i))));
+    for (; i < size; ++i) C[i] = A[i] + s*B[i];
+}
+
+AVX2_TARGET
+double dot(const float* A, const float* B, size_t size)
+{
+    __m256d acc0 = _mm256_setzero_pd();
+    __m256d acc1 = _mm256_setzero_pd();
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8)
+    {
+        __m256 p = _mm256_mul_ps(_mm256_loadu_ps(A + i), _mm256_loadu_ps(B + i));
+        acc0 = _mm256_add_pd(acc0, _mm256_cvtps_pd(_mm256_castps256_ps128(p)));
+        acc1 = _mm256_add_pd(acc1, _mm256_cvtps_pd(_mm256_extractf128_ps(p, 1)));
+    }
+    double result = hsum_pd(_mm256_add_pd(acc0, acc1));
+    for (; i < size; ++i) result += A[i] * B[i];
+    return result;
+}
+
+AVX2_TARGET
+double dotSelf(const float* A, size_t size)
+{
+    return dot(A, A, size);
+}
+
+AVX2_TARGET
+void log2s(const float* A, float s, float* B, size_t size)
+{
+    const __m256 vs = _mm256_set1_ps(s);
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8)
+        _mm256_storeu_ps(B + i, _mm256_mul_ps(vs, log2_ps(_mm256_loadu_ps(A + i))));
+    for (; i < size; ++i) B[i] = s*std::log2(A[i]);
+}
+
+AVX2_TARGET
+void exp2s(const float* A, float s, float* B, size_t size)
+{
+    const __m256 vs = _mm256_set1_ps(s);
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8)
+        _mm256_storeu_ps(B + i, exp2_ps(_mm256_mul_ps(vs, _mm256_loadu_ps(A + i))));
+    for (; i < size; ++i) B[i] = std::exp2(s*A[i]);
+}
+
+AVX2_TARGET
+void pow(const float* A, float e, float* B, size_t size)
+{
+    const __m256 ve = _mm256_set1_ps(e);
+    const __m256 zero = _mm256_setzero_ps();
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8)
+    {
+        __m256 x = _mm256_loadu_ps(A + i);
+        __m256 positive = _mm256_cmp_ps(x, zero, _CMP_GT_OQ);
+        __m256 r = exp2_ps(_mm256_mul_ps(ve, log2_ps(x)));
+        _mm256_storeu_ps(B + i, _mm256_and_ps(positive, r));
+    }
+    for (; i < size; ++i) B[i] = (A[i] > 0.f) ? std::pow(A[i], e) : 0.f;
+}
+}
+
+const Kernels& avx2Kernels()
+{
+    static const Kernels s_kernels = {
+        add, sub, mul, div, sadd, smul, adds, dot, dotSelf, log2s, exp2s, pow
+    };
+    return s_kernels;
+}
+
+}   // simd
+}   // utils
+}   // pfs
+
+#endif // PFS_SIMD_X86
@@ -0,0 +1,272 @@
+/*
+ * This file is a part of Luminance HDR package
+ * ----------------------------------------------------------------------
+ * Copyright (C) 2017 Luminance HDR developers
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+//! \brief AVX-512F kernels (16 floats per vector). Tails are processed
+//! with masked loads and stores.
+
+#include <Libpfs/utils/simd_p.h>
+
+#ifdef PFS_SIMD_X86
+
+#include <immintrin.h>
+
+// the _mm512_undefined_* helpers of GCC's headers trigger false positives
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+#define AVX512_TARGET PFS_SIMD_TARGET("avx512f")
+
+namespace pfs {
+namespace utils {
+namespace simd {
+
+namespace
+{
+AVX512_TARGET inline
+__mmask16 tailMask(size_t remaining)
+{
+    return (remaining >= 16) ? __mmask16(0xFFFF)
+                             : __mmask16((1u << remaining) - 1);
+}
+
+AVX512_TARGET inline
+__m512 load(const float* p, __mmask16 mask)
+{
+    return _mm512_maskz_loadu_ps(mask, p);
+}
+
+AVX512_TARGET inline
+void store(float* p, __m512 v, __mmask16 mask)
+{
+    _mm512_mask_storeu_ps(p, mask, v);
+}
+
+AVX512_TARGET inline
+__m512 exp2_ps(__m512 x)
+{
+    x = _mm512_min_ps(x, _mm512_set1_ps(EXP2_MAX));
+    x = _mm512_max_ps(x, _mm512_set1_ps(EXP2_MIN));
+
+    __m512i ipart = _mm512_cvtps_epi32(_mm512_sub_ps(x, _mm512_set1_ps(0.5f)));
+    __m512 fpart = _mm512_sub_ps(x, _mm512_cvtepi32_ps(ipart));
+    __m512 expipart = _mm512_castsi512_ps(
+                _mm512_slli_epi32(_mm512_add_epi32(ipart, _mm512_set1_epi32(127)), 23));
+
+    __m512 p = _mm512_set1_ps(EXP2_P5);
+    p = _mm512_fmadd_ps(p, fpart, _mm512_set1_ps(EXP2_P4));
+    p = _mm512_fmadd_ps(p, fpart, _mm512_set1_ps(EXP2_P3));
+    p = _mm512_fmadd_ps(p, fpart, _mm512_set1_ps(EXP2_P2));
+    p = _mm512_fmadd_ps(p, fpart, _mm512_set1_ps(EXP2_P1));
+    p = _mm512_fmadd_ps(p, fpart, _mm512_set1_ps(EXP2_P0));
+
+    return _mm512_mul_ps(expipart, p);
+}
+
+AVX512_TARGET inline
+__m512 log2_ps(__m512 x)
+{
+    const __m512i expMask = _mm512_set1_epi32(0x7F800000);
+    const __m512i mantMask = _mm512_set1_epi32(0x007FFFFF);
+    const __m512 one = _mm512_set1_ps(1.0f);
+    const __m512 half = _mm512_set1_ps(0.5f);
+
+    __m512i i = _mm512_castps_si512(x);
+    __m512 e = _mm512_cvtepi32_ps(
+                _mm512_sub_epi32(_mm512_srli_epi32(_mm512_and_si512(i, expMask), 23),
+                                 _mm512_set1_epi32(127)));
+    __m512 m = _mm512_castsi512_ps(_mm512_or_si512(_mm512_and_si512(i, mantMask),
+                                                   _mm512_castps_si512(one)));
+
+    // moves the mantissa in [sqrt(0.5), sqrt(2)[
+    __mmask16 big = _mm512_cmp_ps_mask(m, _mm512_set1_ps(SQRT_2), _CMP_GT_OQ);
+    e = _mm512_mask_add_ps(e, big, e, one);
+    m = _mm512_mask_mul_ps(m, big, m, half);
+    m = _mm512_sub_ps(m, one);
+
+    __m512 p = _mm512_set1_ps(LOG_P0);
+    p = _mm512_fmadd_ps(p, m, _mm512_set1_ps(LOG_P1));
+    p = _mm512_fmadd_ps(p, m, _mm512_set1_ps(LOG_P2));
+    p = _mm512_fmadd_ps(p, m, _mm512_set1_ps(LOG_P3));
+    p = _mm512_fmadd_ps(p, m, _mm512_set1_ps(LOG_P4));
+    p = _mm512_fmadd_ps(p, m, _mm512_set1_ps(LOG_P5));
+    p = _mm512_fmadd_ps(p, m, _mm512_set1_ps(LOG_P6));
+    p = _mm512_fmadd_ps(p, m, _mm512_set1_ps(LOG_P7));
+    p = _mm512_fmadd_ps(p, m, _mm512_set1_ps(LOG_P8));
+
+    __m512 m2 = _mm512_mul_ps(m, m);
+    p = _mm512_fnmadd_ps(half, m2, _mm512_mul_ps(_mm512_mul_ps(p, m), m2));
+
+    // log2(x) = e + log(m)*log2(e)
+    return _mm512_fmadd_ps(_mm512_add_ps(m, p), _mm512_set1_ps(LOG2_E), e);
+}
+
+AVX512_TARGET
+void add(const float* A, const float* B, float* C, size_t size)
+{
+    for (size_t i = 0; i < size; i += 16)
+    {
+        __mmask16 k = tailMask(size - i);
+        store(C + i, _mm512_add_ps(load(A + i, k), load(B + i, k)), k);
+    }
+}
+
+AVX512_TARGET
+void sub(const float* A, const float* B, float* C, size_t size)
+{
+    for (size_t i = 0; i < size; i += 16)
+    {
+        __mmask16 k = tailMask(size - i);
+        store(C + i, _mm512_sub_ps(load(A + i, k), load(B + i, k)), k);
+    }
+}
+
+AVX512_TARGET
+void mul(const float* A, const float* B, float* C, size_t size)
+{
+    for (size_t i = 0; i < size; i += 16)
+    {
+        __mmask16 k = tailMask(size - i);
+        store(C + i, _mm512_mul_ps(load(A + i, k), load(B + i, k)), k);
+    }
+}
+
+AVX512_TARGET
+void div(const float* A, const float* B, float* C, size_t size)
+{
+    for (size_t i = 0; i < size; i += 16)
+    {
+        __mmask16 k = tailMask(size - i);
+        store(C + i, _mm512_maskz_div_ps(k, load(A + i, k), load(B + i, k)), k);
+    }
+}
+
+AVX512_TARGET
+void sadd(const float* A, float s, float* B, size_t size)
+{
+    const __m512 vs = _mm512_set1_ps(s);
+    for (size_t i = 0; i < size; i += 16)
+    {
+        __mmask16 k = tailMask(size - i);
+        store(B + i, _mm512_add_ps(load(A + i, k), vs), k);
+    }
+}
+
+AVX512_TARGET
+void smul(const float* A, float s, float* B, size_t size)
+{
+    const __m512 vs = _mm512_set1_ps(s);
+    for (size_t i = 0; i < size; i += 16)
+    {
+        __mmask16 k = tailMask(size - i);
+        store(B + i, _mm512_mul_ps(load(A + i, k), vs), k);
+    }
+}
+
+AVX512_TARGET PFS_SIMD_NO_FMA
+void adds(const float* A, float s, const float* B, float* C, size_t size)
+{
+    const __m512 vs = _mm512_set1_ps(s);
+    for (size_t i = 0; i < size; i += 16)
+    {
+        __mmask16 k = tailMask(size - i);
+        store(C + i, _mm512_add_ps(load(A + i, k), _mm512_mul_ps(vs, load(B + i, k))), k);
+    }
+}
+
+AVX512_TARGET
+double dot(const float* A, const float* B, size_t size)
+{
+    __m512d acc0 = _mm512_setzero_pd();
+    __m512d acc1 = _mm512_setzero_pd();
+    for (size_t i = 0; i < size; i += 16)
+    {
+        __mmask16 k = tailMask(size - i);
+        __m512 p = _mm512_mul_ps(load(A + i, k), load(B + i, k));
+        __m256 lo = _mm512_castps512_ps256(p);
+        __m256 hi = _mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(p), 1));
+        acc0 = _mm512_add_pd(acc0, _mm512_cvtps_pd(lo));
+        acc1 = _mm512_add_pd(acc1, _mm512_cvtps_pd(hi));
+    }
+    return _mm512_reduce_add_pd(_mm512_add_pd(acc0, acc1));
+}
+
+AVX512_TARGET
+double dotSelf(const float* A, size_t size)
+{
+    return dot(A, A, size);
+}
+
+AVX512_TARGET
+void log2s(const float* A, float s, float* B, size_t size)
+{
+    const __m512 vs = _mm512_set1_ps(s);
+    const __m512 one = _mm512_set1_ps(1.0f);
+    for (size_t i = 0; i < size; i += 16)
+    {
+        __mmask16 k = tailMask(size - i);
+        // masked lanes are loaded as 1, whose logarithm is well defined
+        __m512 x = _mm512_mask_loadu_ps(one, k, A + i);
+        store(B + i, _mm512_mul_ps(vs, log2_ps(x)), k);
+    }
+}
+
+AVX512_TARGET
+void exp2s(const float* A, float s, float* B, size_t size)
+{
+    const __m512 vs = _mm512_set1_ps(s);
+    for (size_t i = 0; i < size; i += 16)
+    {
+        __mmask16 k = tailMask(size - i);
+        store(B + i, exp2_ps(_mm512_mul_ps(vs, load(A + i, k))), k);
+    }
+}
+
+AVX512_TARGET
+void pow(const float* A, float e, float* B, size_t size)
+{
+    const __m512 ve = _mm512_set1_ps(e);
+    const __m512 zero = _mm512_setzero_ps();
+    for (size_t i = 0; i < size; i += 16)
+    {
+        __mmask16 k = tailMask(size - i);
+        __m512 x = load(A + i, k);
+        __mmask16 positive = _mm512_mask_cmp_ps_mask(k, x, zero, _CMP_GT_OQ);
+        __m512 r = exp2_ps(_mm512_mul_ps(ve, log2_ps(x)));
+        store(B + i, _mm512_maskz_mov_ps(positive, r), k);
+    }
+}
+}
+
+const Kernels& avx512Kernels()
+{
+    static const Kernels s_kernels = {
+        add, sub, mul, div, sadd, smul, adds, dot, dotSelf, log2s, exp2s, pow
+    };
+    return s_kernels;
+}
+
+}   // simd
+}   // utils
+}   // pfs
+
+#endif // PFS_SIMD_X86
@@ -0,0 +1,88 @@
+/*
+ * This file is a part of Luminance HDR package
+ * ----------------------------------------------------------------------
+ * Copyright (C) 2017 Luminance HDR developers
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+//! \brief Private declarations shared by the implementations of simd.h
+
+#ifndef PFS_UTILS_SIMD_P_H
+#define PFS_UTILS_SIMD_P_H
+
+#include <Libpfs/utils/simd.h>
+
+// GCC and Clang only emit AVX2/AVX-512 code inside functions marked with the
+// matching target, so that the rest of the library keeps the baseline flags.
+// MSVC always accepts the intrinsics.
+#if defined(__GNUC__)
+#define PFS_SIMD_TARGET(isa) __attribute__((target(isa)))
+#else
+#define PFS_SIMD_TARGET(isa)
+#endif
+
+// GCC fuses multiplications and additions when FMA is available: kernels that
+// must round exactly as the scalar code opt out of it
+#if defined(__GNUC__) && !defined(__clang__)
+#define PFS_SIMD_NO_FMA __attribute__((optimize("fp-contract=off")))
+#else
+#define PFS_SIMD_NO_FMA
+#endif
+
+namespace pfs {
+namespace utils {
+namespace simd {
+
+const Kernels& scalarKernels();
+
+#ifdef PFS_SIMD_X86
+const Kernels& sse2Kernels();
+const Kernels& avx2Kernels();
+const Kernels& avx512Kernels();
+#endif
+
+// Minimax polynomial fit of 2^x in [0, 1[, from
+// http://jrfonseca.blogspot.com/2008/09/fast-sse2-pow-tables-or-polynomials.html
+const float EXP2_P0 = 9.9999994e-1f;
+const float EXP2_P1 = 6.9315308e-1f;
+const float EXP2_P2 = 2.4015361e-1f;
+const float EXP2_P3 = 5.5826318e-2f;
+const float EXP2_P4 = 8.9893397e-3f;
+const float EXP2_P5 = 1.8775767e-3f;
+
+// Polynomial of logf() from the Cephes library, valid for a mantissa in
+// [sqrt(0.5), sqrt(2)[
+const float LOG_P0 = 7.0376836292e-2f;
+const float LOG_P1 = -1.1514610310e-1f;
+const float LOG_P2 = 1.1676998740e-1f;
+const float LOG_P3 = -1.2420140846e-1f;
+const float LOG_P4 = 1.4249322787e-1f;
+const float LOG_P5 = -1.6668057665e-1f;
+const float LOG_P6 = 2.0000714765e-1f;
+const float LOG_P7 = -2.4999993993e-1f;
+const float LOG_P8 = 3.3333331174e-1f;
+const float SQRT_2 = 1.41421356237f;
+const float LOG2_E = 1.44269504088896340736f;
+
+const float EXP2_MAX = 129.00000f;
+const float EXP2_MIN = -126.99999f;
+
+}   // simd
+}   // utils
+}   // pfs
+
+#endif // PFS_UTILS_SIMD_P_H
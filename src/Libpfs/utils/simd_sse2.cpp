@@ -0,0 +1,243 @@
+/*
+ * This file is a part of Luminance HDR package
+ * ----------------------------------------------------------------------
+ * Copyright (C) 2017 Luminance HDR developers
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+//! \brief SSE2 kernels (4 floats per vector)
+
+#include <Libpfs/utils/simd_p.h>
+
+#ifdef PFS_SIMD_X86
+
+#include <cmath>
+#include <emmintrin.h>
+
+#define SSE2_TARGET PFS_SIMD_TARGET("sse2")
+
+namespace pfs {
+namespace utils {
+namespace simd {
+
+namespace
+{
+SSE2_TARGET inline
+__m128 exp2_ps(__m128 x)
+{
+    x = _mm_min_ps(x, _mm_set1_ps(EXP2_MAX));
+    x = _mm_max_ps(x, _mm_set1_ps(EXP2_MIN));
+
+    __m128i ipart = _mm_cvtps_epi32(_mm_sub_ps(x, _mm_set1_ps(0.5f)));
+    __m128 fpart = _mm_sub_ps(x, _mm_cvtepi32_ps(ipart));
+    __m128 expipart = _mm_castsi128_ps(
+                _mm_slli_epi32(_mm_add_epi32(ipart, _mm_set1_epi32(127)), 23));
+
+    __m128 p = _mm_set1_ps(EXP2_P5);
+    p = _mm_add_ps(_mm_mul_ps(p, fpart), _mm_set1_ps(EXP2_P4));
+    p = _mm_add_ps(_mm_mul_ps(p, fpart), _mm_set1_ps(EXP2_P3));
+    p = _mm_add_ps(_mm_mul_ps(p, fpart), _mm_set1_ps(EXP2_P2));
+    p = _mm_add_ps(_mm_mul_ps(p, fpart), _mm_set1_ps(EXP2_P1));
+    p = _mm_add_ps(_mm_mul_ps(p, fpart), _mm_set1_ps(EXP2_P0));
+
+    return _mm_mul_ps(expipart, p);
+}
+
+SSE2_TARGET inline
+__m128 log2_ps(__m128 x)
+{
+    const __m128i expMask = _mm_set1_epi32(0x7F800000);
+    const __m128i mantMask = _mm_set1_epi32(0x007FFFFF);
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 half = _mm_set1_ps(0.5f);
+
+    __m128i i = _mm_castps_si128(x);
+    __m128 e = _mm_cvtepi32_ps(
+                _mm_sub_epi32(_mm_srli_epi32(_mm_and_si128(i, expMask), 23),
+                              _mm_set1_epi32(127)));
+    __m128 m = _mm_or_ps(_mm_castsi128_ps(_mm_and_si128(i, mantMask)), one);
+
+    // moves the mantissa in [sqrt(0.5), sqrt(2)[
+    __m128 big = _mm_cmpgt_ps(m, _mm_set1_ps(SQRT_2));
+    e = _mm_add_ps(e, _mm_and_ps(big, one));
+    m = _mm_sub_ps(m, _mm_and_ps(big, _mm_mul_ps(m, half)));
+    m = _mm_sub_ps(m, one);
+
+    __m128 p = _mm_set1_ps(LOG_P0);
+    p = _mm_add_ps(_mm_mul_ps(p, m), _mm_set1_ps(LOG_P1));
+    p = _mm_add_ps(_mm_mul_ps(p, m), _mm_set1_ps(LOG_P2));
+    p = _mm_add_ps(_mm_mul_ps(p, m), _mm_set1_ps(LOG_P3));
+    p = _mm_add_ps(_mm_mul_ps(p, m), _mm_set1_ps(LOG_P4));
+    p = _mm_add_ps(_mm_mul_ps(p, m), _mm_set1_ps(LOG_P5));
+    p = _mm_add_ps(_mm_mul_ps(p, m), _mm_set1_ps(LOG_P6));
+    p = _mm_add_ps(_mm_mul_ps(p, m), _mm_set1_ps(LOG_P7));
+    p = _mm_add_ps(_mm_mul_ps(p, m), _mm_set1_ps(LOG_P8));
+
+    __m128 m2 = _mm_mul_ps(m, m);
+    p = _mm_mul_ps(_mm_mul_ps(p, m), m2);
+    p = _mm_sub_ps(p, _mm_mul_ps(half, m2));
+
+    // log2(x) = e + log(m)*log2(e)
+    return _mm_add_ps(e, _mm_mul_ps(_mm_add_ps(m, p), _mm_set1_ps(LOG2_E)));
+}
+
+SSE2_TARGET inline
+double hsum_pd(__m128d v)
+{
+    return _mm_cvtsd_f64(_mm_add_sd(v, _mm_unpackhi_pd(v, v)));
+}
+
+SSE2_TARGET
+void add(const float* A, const float* B, float* C, size_t size)
+{
+    size_t i = 0;
+    for (; i + 4 <= size; i += 4)
+        _mm_storeu_ps(C + i, _mm_add_ps(_mm_loadu_ps(A + i), _mm_loadu_ps(B + i)));
+    for (; i < size; ++i) C[i] = A[i] + B[i];
+}
+
+SSE2_TARGET
+void sub(const float* A, const float* B, float* C, size_t size)
+{
+    size_t i = 0;
+    for (; i + 4 <= size; i += 4)
+        _mm_storeu_ps(C + i, _mm_sub_ps(_mm_loadu_ps(A + i), _mm_loadu_ps(B + i)));
+    for (; i < size; ++i) C[i] = A[i] - B[i];
+}
+
+SSE2_TARGET
+void mul(const float* A, const float* B, float* C, size_t size)
+{
+    size_t i = 0;
+    for (; i + 4 <= size; i += 4)
+        _mm_storeu_ps(C + i, _mm_mul_ps(_mm_loadu_ps(A + i), _mm_loadu_ps(B + i)));
+    for (; i < size; ++i) C[i] = A[i] * B[i];
+}
+
+SSE2_TARGET
+void div(const float* A, const float* B, float* C, size_t size)
+{
+    size_t i = 0;
+    for (; i + 4 <= size; i += 4)
+        _mm_storeu_ps(C + i, _mm_div_ps(_mm_loadu_ps(A + i), _mm_loadu_ps(B + i)));
+    for (; i < size; ++i) C[i] = A[i] / B[i];
+}
+
+SSE2_TARGET
+void sadd(const float* A, float s, float* B, size_t size)
+{
+    const __m128 vs = _mm_set1_ps(s);
+    size_t i = 0;
+    for (; i + 4 <= size; i += 4)
+        _mm_storeu_ps(B + i, _mm_add_ps(_mm_loadu_ps(A + i), vs));
+    for (; i < size; ++i) B[i] = A[i] + s;
+}
+
+SSE2_TARGET
+void smul(const float* A, float s, float* B, size_t size)
+{
+    const __m128 vs = _mm_set1_ps(s);
+    size_t i = 0;
+    for (; i + 4 <= size; i += 4)
+        _mm_storeu_ps(B + i, _mm_mul_ps(_mm_loadu_ps(A + i), vs));
+    for (; i < size; ++i) B[i] = A[i] * s;
+}
+
+SSE2_TARGET
+void adds(const float* A, float s, const float* B, float* C, size_t size)
+{
+    const __m128 vs = _mm_set1_ps(s);
+    size_t i = 0;
+    for (; i + 4 <= size; i += 4)
+        _mm_storeu_ps(C + i, _mm_add_ps(_mm_loadu_ps(A + i),
+                                        _mm_mul_ps(vs, _mm_loadu_ps(B + i))));
+    for (; i < size; ++i) C[i] = A[i] + s*B[i];
+}
+
+SSE2_TARGET
+double dot(const float* A, const float* B, size_t size)
+{
+    __m128d acc0 = _mm_setzero_pd();
+    __m128d acc1 = _mm_setzero_pd();
+    size_t i = 0;
+    for (; i + 4 <= size; i += 4)
+    {
+        __m128 p = _mm_mul_ps(_mm_loadu_ps(A + i), _mm_loadu_ps(B + i));
+        acc0 = _mm_add_pd(acc0, _mm_cvtps_pd(p));
+        acc1 = _mm_add_pd(acc1, _mm_cvtps_pd(_mm_movehl_ps(p, p)));
+    }
+    double result = hsum_pd(_mm_add_pd(acc0, acc1));
+    for (; i < size; ++i) result += A[i] * B[i];
+    return result;
+}
+
+SSE2_TARGET
+double dotSelf(const float* A, size_t size)
+{
+    return dot(A, A, size);
+}
+
+SSE2_TARGET
+void log2s(const float* A, float s, float* B, size_t size)
+{
+    const __m128 vs = _mm_set1_ps(s);
+    size_t i = 0;
+    for (; i + 4 <= size; i += 4)
+        _mm_storeu_ps(B + i, _mm_mul_ps(vs, log2_ps(_mm_loadu_ps(A + i))));
+    for (; i < size; ++i) B[i] = s*std::log2(A[i]);
+}
+
+SSE2_TARGET
+void exp2s(const float* A, float s, float* B, size_t size)
+{
+    const __m128 vs = _mm_set1_ps(s);
+    size_t i = 0;
+    for (; i + 4 <= size; i += 4)
+        _mm_storeu_ps(B + i, exp2_ps(_mm_mul_ps(vs, _mm_loadu_ps(A + i))));
+    for (; i < size; ++i) B[i] = std::exp2(s*A[i]);
+}
+
+SSE2_TARGET
+void pow(const float* A, float e, float* B, size_t size)
+{
+    const __m128 ve = _mm_set1_ps(e);
+    const __m128 zero = _mm_setzero_ps();
+    size_t i = 0;
+    for (; i + 4 <= size; i += 4)
+    {
+        __m128 x = _mm_loadu_ps(A + i);
+        __m128 positive = _mm_cmpgt_ps(x, zero);
+        __m128 r = exp2_ps(_mm_mul_ps(ve, log2_ps(x)));
+        _mm_storeu_ps(B + i, _mm_and_ps(positive, r));
+    }
+    for (; i < size; ++i) B[i] = (A[i] > 0.f) ? std::pow(A[i], e) : 0.f;
+}
+}
+
+const Kernels& sse2Kernels()
+{
+    static const Kernels s_kernels = {
+        add, sub, mul, div, sadd, smul, adds, dot, dotSelf, log2s, exp2s, pow
+    };
+    return s_kernels;
+}
+
+}   // simd
+}   // utils
+}   // pfs
+
+#endif // PFS_SIMD_X86
@@ -0,0 +1,608 @@
+/*
+ * This file is a part of Luminance HDR package
+ * ----------------------------------------------------------------------
+ * Copyright (C) 2017 Luminance HDR developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+
+#include "BatchScheduler.h"
+
+#include <QDebug>
+#include <QFile>
+#include <QFileInfo>
+#include <QImage>
+#include <QImageReader>
+#include <QMutexLocker>
+#include <QRunnable>
+#include <QScopedPointer>
+#include <QThread>
+#include <QVector>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "Common/CommonFunctions.h"
+#include "Common/LuminanceOptions.h"
+#include "Core/IOWorker.h"
+#include "Core/TMWorker.h"
+#include "Fileformat/pfsoutldrimage.h"
+#include "HdrCreation/fusionoperator.h"
+#include "HdrCreation/mtb_alignment.h"
+#include "HdrCreation/feature_alignment.h"
+#include "HdrWizard/HdrCreationItem.h"
+#include "Libpfs/frame.h"
+#include "Libpfs/tiledframe.h"
+#include "Libpfs/frameview.h"
+#include "Libpfs/exif/exifdata.hpp"
+#include "Libpfs/manip/gamma_levels.h"
+
+using namespace libhdr::fusion;
+
+namespace
+{
+// bytes per pixel of a loaded input: float RGB frame plus its ARGB preview
+const qint64 INPUT_BYTES_PER_PIXEL = 3*sizeof(float) + 4;
+// bytes per pixel of the HDR and of the tonemapped frame
+const qint64 FRAME_BYTES_PER_PIXEL = 3*sizeof(float);
+
+//! \brief Number of pixels of \a filename. Formats that QImageReader doesn't
+//! know (raw, EXR, ...) are assumed to store 2 bytes per pixel, which
+//! overestimates compressed files.
+qint64 estimatePixels(const QString& filename)
+{
+    QImageReader reader(filename);
+    const QSize size = reader.size();
+    if ( size.isValid() )
+    {
+        return qint64(size.width())*size.height();
+    }
+    return std::max(QFileInfo(filename).size()/2, qint64(1));
+}
+
+//! \brief Memory of the HDR (and of the tonemapped frame) of \a job
+qint64 estimateFrameMemory(const BatchJob& job)
+{
+    const qint64 pixels = job.loadHdrFilename.isEmpty()
+            ? (job.inputFiles.isEmpty() ? 0 : estimatePixels(job.inputFiles.first()))
+            : estimatePixels(job.loadHdrFilename);
+    return pixels*FRAME_BYTES_PER_PIXEL;
+}
+
+//! \brief true if the HDR loaded by \a job stays next to the working frame
+//! of the tonemap, because the job saves it as well
+bool keepsLoadedHdr(const BatchJob& job, bool tiledHdrs)
+{
+    return !tiledHdrs && !job.loadHdrFilename.isEmpty() && !job.saveHdrFilename.isEmpty();
+}
+
+//! \brief true if all the channels of \a frame still point inside the file
+bool isMapped(const pfs::FrameView& frame)
+{
+    const pfs::ChannelViewContainer& channels = frame.getChannels();
+    for (size_t idx = 0; idx < channels.size(); ++idx)
+    {
+        if ( !channels[idx]->isShared() )
+        {
+            return false;
+        }
+    }
+    return !channels.empty();
+}
+
+qint64 estimateInputMemory(const BatchJob& job)
+{
+    qint64 bytes = 0;
+    for (int idx = 0; idx < job.inputFiles.size(); ++idx)
+    {
+        bytes += estimatePixels(job.inputFiles[idx])*INPUT_BYTES_PER_PIXEL;
+    }
+    return bytes;
+}
+
+float medianEV(const std::vector<HdrCreationItem>& items)
+{
+    std::vector<float> evs;
+    for (size_t idx = 0; idx < items.size(); ++idx)
+    {
+        evs.push_back(items[idx].getEV());
+    }
+    std::sort(evs.begin(), evs.end());
+    return evs[(evs.size() + 1)/2 - 1];
+}
+
+void printIfVerbose(const QString& str, bool verbose)
+{
+    if ( verbose )
+    {
+        std::cout << qPrintable(str) << std::endl;
+    }
+}
+}
+
+BatchJob::BatchJob()
+    : line(0)
+    , mtbAlign(false)
+    , featureAlign(false)
+    , responseCacheMode(RESPONSE_CACHE_OFF)
+    , autolevels(false)
+{
+    fusionConfig.weightFunction = WEIGHT_TRIANGULAR;
+    fusionConfig.responseCurve = RESPONSE_LINEAR;
+    fusionConfig.fusionOperator = DEBEVEC;
+}
+
+struct BatchScheduler::JobState
+{
+    explicit JobState(const BatchJob& job)
+        : job(job)
+        , inputMemory(0)
+        , hdrMemory(0)
+        , memory(0)
+    {}
+
+    BatchJob job;
+    qint64 inputMemory;     //!< part of memory released after the merge
+    qint64 hdrMemory;       //!< part of memory released if the loaded HDR is mapped
+    qint64 memory;          //!< memory still reserved by the job
+    std::vector<HdrCreationItem> items;
+    QVector<float> expoTimes;
+    QScopedPointer<pfs::Frame> hdr;
+    QScopedPointer<pfs::TiledFrame> tiledHdr;   //!< loaded or merged HDR, with tiles
+    QScopedPointer<pfs::FrameView> mappedHdr;   //!< loaded HDR, otherwise
+    QScopedPointer<pfs::Frame> ldr;
+    QString error;
+};
+
+class BatchScheduler::StageTask : public QRunnable
+{
+public:
+    StageTask(BatchScheduler* scheduler, JobState* state, Stage stage)
+        : m_scheduler(scheduler)
+        , m_state(state)
+        , m_stage(stage)
+    {}
+
+    void run()
+    {
+        m_scheduler->runStage(m_state, m_stage);
+    }
+
+private:
+    BatchScheduler* m_scheduler;
+    JobState* m_state;
+    Stage m_stage;
+};
+
+BatchScheduler::BatchScheduler(int cpuJobs, int ioJobs, qint64 memoryBudget,
+                               bool tiledHdrs, bool verbose)
+    : m_cpuJobs(std::max(cpuJobs, 1))
+    , m_memoryBudget(memoryBudget)
+    , m_tiledHdrs(tiledHdrs)
+    , m_verbose(verbose)
+    , m_memoryInUse(0)
+    , m_running(0)
+    , m_failed(0)
+    , m_responseCache(QFile::encodeName(LuminanceOptions().getResponseCacheDir()).constData())
+{
+    m_cpuPool.setMaxThreadCount(m_cpuJobs);
+    m_ioPool.setMaxThreadCount(std::max(ioJobs, 1));
+}
+
+BatchScheduler::~BatchScheduler()
+{
+    m_ioPool.waitForDone();
+    m_cpuPool.waitForDone();
+}
+
+qint64 BatchScheduler::estimateMemory(const BatchJob& job) const
+{
+    // a merged HDR is copied into the working frame (with tiles, it is
+    // resident only until the end of the merge). A tiled HDR is accounted by
+    // the budget of the tile cache, while a loaded one is moved into the
+    // working frame, unless the job saves it as well
+    qint64 frames = 2;
+    if ( !job.loadHdrFilename.isEmpty() )
+    {
+        frames = keepsLoadedHdr(job, m_tiledHdrs) ? 2 : 1;
+    }
+    return estimateInputMemory(job) + frames*estimateFrameMemory(job);
+}
+
+int BatchScheduler::run(const QList<BatchJob>& jobs)
+{
+    for (int idx = 0; idx < jobs.size(); ++idx)
+    {
+        JobState* state = new JobState(jobs[idx]);
+        state->memory = estimateMemory(state->job);
+        state->inputMemory = estimateInputMemory(state->job);
+        if ( keepsLoadedHdr(state->job, m_tiledHdrs) )
+        {
+            state->hdrMemory = estimateFrameMemory(state->job);
+        }
+
+        {
+            QMutexLocker lock(&m_mutex);
+            // a job bigger than the budget runs alone
+            while ( m_running > 0 && m_memoryInUse + state->memory > m_memoryBudget )
+            {
+                m_released.wait(&m_mutex);
+            }
+            m_memoryInUse += state->memory;
+            ++m_running;
+        }
+
+        printIfVerbose(QObject::tr("Starting job at line %1 (%2 MB estimated)")
+                       .arg(state->job.line).arg(state->memory >> 20), m_verbose);
+        schedule(state, STAGE_READ);
+    }
+
+    QMutexLocker lock(&m_mutex);
+    while ( m_running > 0 )
+    {
+        m_released.wait(&m_mutex);
+    }
+    return m_failed;
+}
+
+void BatchScheduler::schedule(JobState* state, Stage stage)
+{
+    // later stages go first, so that the jobs in flight release their memory
+    switch (stage)
+    {
+    case STAGE_READ:
+        m_ioPool.start(new StageTask(this, state, stage), 0);
+        break;
+    case STAGE_WRITE:
+        m_ioPool.start(new StageTask(this, state, stage), 1);
+        break;
+    case STAGE_MERGE:
+        m_cpuPool.start(new StageTask(this, state, stage), 0);
+        break;
+    case STAGE_TONEMAP:
+        m_cpuPool.start(new StageTask(this, state, stage), 1);
+        break;
+    }
+}
+
+void BatchScheduler::runStage(JobState* state, Stage stage)
+{
+    try
+    {
+        switch (stage)
+        {
+        case STAGE_READ:
+            read(*state);
+            break;
+        case STAGE_MERGE:
+            merge(*state);
+            break;
+        case STAGE_TONEMAP:
+            tonemap(*state);
+            break;
+        case STAGE_WRITE:
+            write(*state);
+            break;
+        }
+    }
+    catch (std::exception& e)
+    {
+        state->error = QString::fromLocal8Bit(e.what());
+    }
+    catch (...)
+    {
+        state->error = QObject::tr("Unknown error");
+    }
+
+    if ( !state->error.isEmpty() || stage == STAGE_WRITE )
+    {
+        finish(state);
+        return;
+    }
+    schedule(state, static_cast<Stage>(stage + 1));
+}
+
+void BatchScheduler::release(JobState* state, qint64 bytes)
+{
+    QMutexLocker lock(&m_mutex);
+    bytes = std::min(bytes, state->memory);
+    state->memory -= bytes;
+    m_memoryInUse -= bytes;
+    m_released.wakeAll();
+}
+
+void BatchScheduler::finish(JobState* state)
+{
+    if ( state->error.isEmpty() )
+    {
+        printIfVerbose(QObject::tr("Job at line %1 completed").arg(state->job.line), m_verbose);
+    }
+    else
+    {
+        std::cerr << qPrintable(QObject::tr("Job at line %1 failed: %2")
+                                .arg(state->job.line).arg(state->error)) << std::endl;
+    }
+
+    QMutexLocker lock(&m_mutex);
+    m_memoryInUse -= state->memory;
+    if ( !state->error.isEmpty() )
+    {
+        ++m_failed;
+    }
+    --m_running;
+    m_released.wakeAll();
+    lock.unlock();
+
+    delete state;
+}
+
+void BatchScheduler::read(JobState& state)
+{
+    const BatchJob& job = state.job;
+
+    if ( !job.loadHdrFilename.isEmpty() && m_tiledHdrs )
+    {
+        state.tiledHdr.reset( new pfs::TiledFrame );
+        if ( !IOWorker().read_hdr_frame(job.loadHdrFilename, *state.tiledHdr) )
+        {
+            throw std::runtime_error(QObject::tr("Load file %1 failed")
+                                     .arg(job.loadHdrFilename).toStdString());
+        }
+        return;
+    }
+    if ( !job.loadHdrFilename.isEmpty() )
+    {
+        // PFS and float TIFF files are mapped rather than read: the tonemap
+        // stage only touches the pixels it needs
+        state.mappedHdr.reset( new pfs::FrameView );
+        if ( !IOWorker().read_hdr_frame(job.loadHdrFilename, *state.mappedHdr) )
+        {
+            throw std::runtime_error(QObject::tr("Load file %1 failed")
+                                     .arg(job.loadHdrFilename).toStdString());
+        }
+        if ( state.hdrMemory > 0 && isMapped(*state.mappedHdr) )
+        {
+            // mapped pages are backed by the file, only the working frame is
+            // resident
+            printIfVerbose(QObject::tr("Job at line %1 maps %2 MB")
+                           .arg(job.line).arg(state.hdrMemory >> 20), m_verbose);
+            release(&state, state.hdrMemory);
+        }
+        return;
+    }
+
+    LoadFile loadFile;
+    for (int idx = 0; idx < job.inputFiles.size(); ++idx)
+    {
+        state.items.push_back( HdrCreationItem(job.inputFiles[idx]) );
+        loadFile(state.items.back());
+        if ( !state.items.back().isValid() )
+        {
+            throw std::runtime_error(QObject::tr("Failed loading %1")
+                                     .arg(job.inputFiles[idx]).toStdString());
+        }
+    }
+}
+
+void BatchScheduler::merge(JobState& state)
+{
+    if ( state.items.empty() )
+    {
+        return;
+    }
+
+    const BatchJob& job = state.job;
+    std::vector<HdrCreationItem>& items = state.items;
+
+    for (size_t idx = 0; idx < items.size(); ++idx)
+    {
+        if ( !job.ev.isEmpty() )
+        {
+            items[idx].setEV(job.ev.at(idx));
+        }
+        else if ( !items[idx].hasEV() )
+        {
+            throw std::runtime_error(QObject::tr("Exif data missing in %1 and EV values not specified")
+                                     .arg(items[idx].filename()).toStdString());
+        }
+        if ( items[idx].frame()->getWidth() != items[0].frame()->getWidth() ||
+             items[idx].frame()->getHeight() != items[0].frame()->getHeight() )
+        {
+            throw std::runtime_error(QObject::tr("The images have different size").toStdString());
+        }
+    }
+
+#ifdef _OPENMP
+    // share the cores among the jobs running on the CPU pool
+    omp_set_num_threads(std::max(QThread::idealThreadCount()/m_cpuJobs, 1));
+#endif
+
+    if ( job.mtbAlign || job.featureAlign )
+    {
+        std::vector<pfs::FramePtr> frames;
+        for (size_t idx = 0; idx < items.size(); ++idx)
+        {
+            frames.push_back( items[idx].frame() );
+        }
+        if ( job.mtbAlign )
+        {
+            libhdr::mtb_alignment(frames);
+        }
+        else if ( !libhdr::feature_alignment(frames) )
+        {
+            // the frames past an unmatched pair are left unaligned
+            throw std::runtime_error(QObject::tr("Feature based alignment failed: some images could not be matched")
+                                     .toStdString());
+        }
+    }
+
+    ResponseCurve response(job.fusionConfig.responseCurve);
+    if ( !job.fusionConfig.inputResponseCurveFilename.isEmpty() )
+    {
+        response.readFromFile(
+                    QFile::encodeName(job.fusionConfig.inputResponseCurveFilename).constData());
+    }
+    WeightFunction weight(job.fusionConfig.weightFunction);
+
+    const float evOffset = medianEV(items);
+    std::vector<FrameEnhanced> frames;
+    for (size_t idx = 0; idx < items.size(); ++idx)
+    {
+        frames.push_back( FrameEnhanced(items[idx].frame(),
+                                        std::pow(2.f, items[idx].getEV() - evOffset)) );
+        state.expoTimes.push_back( items[idx].getEV() );
+    }
+
+    std::string cacheKey;
+    if ( job.fusionConfig.fusionOperator == ROBERTSON_AUTO &&
+         job.responseCacheMode != RESPONSE_CACHE_OFF &&
+         job.fusionConfig.inputResponseCurveFilename.isEmpty() )
+    {
+        cacheKey = ResponseCurveCache::key(
+                    pfs::exif::ExifData(QFile::encodeName(items[0].filename()).constData()),
+                    items[0].encoding());
+    }
+    state.hdr.reset( m_responseCache.computeFusion(
+                         cacheKey, static_cast<ResponseCacheMode>(job.responseCacheMode),
+                         job.fusionConfig.fusionOperator, response, weight, frames) );
+
+    // inputs are not needed anymore
+    frames.clear();
+    items.clear();
+    qint64 released = state.inputMemory;
+    if ( m_tiledHdrs )
+    {
+        // the HDR goes into the tiles, like a loaded one
+        state.tiledHdr.reset( new pfs::TiledFrame );
+        state.tiledHdr->copyFrom(*state.hdr);
+        state.hdr.reset();
+        released += estimateFrameMemory(job);
+    }
+    release(&state, released);
+}
+
+void BatchScheduler::tonemap(JobState& state)
+{
+    const BatchJob& job = state.job;
+    if ( job.saveLdrFilename.isEmpty() )
+    {
+        return;
+    }
+
+#ifdef _OPENMP
+    omp_set_num_threads(std::max(QThread::idealThreadCount()/m_cpuJobs, 1));
+#endif
+
+    int width = 0;
+    if ( state.tiledHdr )
+    {
+        width = state.tiledHdr->getWidth();
+    }
+    else if ( state.mappedHdr )
+    {
+        width = state.mappedHdr->getWidth();
+    }
+    else
+    {
+        width = state.hdr->getWidth();
+    }
+    TonemappingOptions* tmopts = job.tmopts.data();
+    tmopts->origxsize = width;
+    if ( tmopts->xsize == -2 )
+    {
+        tmopts->xsize = width;
+    }
+
+    if ( state.tiledHdr )
+    {
+        state.ldr.reset( TMWorker().computeTonemap(*state.tiledHdr, tmopts, BilinearInterp) );
+    }
+    else if ( state.mappedHdr && job.saveHdrFilename.isEmpty() )
+    {
+        // the HDR is not needed anymore: its channels are moved into the
+        // working frame
+        state.ldr.reset( TMWorker().computeTonemapInPlace(*state.mappedHdr, tmopts, BilinearInterp) );
+    }
+    else if ( state.mappedHdr )
+    {
+        state.ldr.reset( TMWorker().computeTonemap(*state.mappedHdr, tmopts, BilinearInterp) );
+    }
+    else
+    {
+        state.ldr.reset( TMWorker().computeTonemap(state.hdr.data(), tmopts, BilinearInterp) );
+    }
+    if ( state.ldr.isNull() )
+    {
+        throw std::runtime_error(QObject::tr("Tonemap failed").toStdString());
+    }
+
+    if ( job.autolevels )
+    {
+        float minL, maxL, gammaL;
+        QScopedPointer<QImage> image( fromLDRPFStoQImage(state.ldr.data()) );
+        computeAutolevels(image.data(), 0.985f, minL, maxL, gammaL);
+        pfs::gammaAndLevels(state.ldr.data(), minL, maxL, 0.f, 1.f, gammaL);
+    }
+}
+
+void BatchScheduler::write(JobState& state)
+{
+    const BatchJob& job = state.job;
+
+    if ( !job.saveHdrFilename.isEmpty() )
+    {
+        bool saved = false;
+        if ( state.tiledHdr )
+        {
+            saved = IOWorker().write_hdr_frame(*state.tiledHdr, job.saveHdrFilename);
+        }
+        else if ( state.mappedHdr )
+        {
+            saved = IOWorker().write_hdr_frame(*state.mappedHdr, job.saveHdrFilename);
+        }
+        else
+        {
+            saved = IOWorker().write_hdr_frame(state.hdr.data(), job.saveHdrFilename);
+        }
+        if ( !saved )
+        {
+            throw std::runtime_error(QObject::tr("Could not save %1")
+                                     .arg(job.saveHdrFilename).toStdString());
+        }
+        printIfVerbose(QObject::tr("Image %1 saved successfully").arg(job.saveHdrFilename), m_verbose);
+    }
+
+    if ( !job.saveLdrFilename.isEmpty() )
+    {
+        const QString inputFilename = job.inputFiles.isEmpty() ? QString() : job.inputFiles.first();
+        if ( !IOWorker().write_ldr_frame(state.ldr.data(), job.saveLdrFilename,
+                                         inputFilename, state.expoTimes,
+                                         job.tmopts.data(), job.ldrParams) )
+        {
+            throw std::runtime_error(QObject::tr("Cannot save to file: %1")
+                                     .arg(job.saveLdrFilename).toStdString());
+        }
+        printIfVerbose(QObject::tr("Image %1 successfully saved").arg(job.saveLdrFilename), m_verbose);
+    }
+}
@@ -0,0 +1,130 @@
+/*
+ * This file is a part of Luminance HDR package
+ * ----------------------------------------------------------------------
+ * Copyright (C) 2017 Luminance HDR developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+
+//! \brief Scheduler of the batch mode of the command line interface
+
+#ifndef BATCHSCHEDULER_H
+#define BATCHSCHEDULER_H
+
+#include <QList>
+#include <QMutex>
+#include <QSharedPointer>
+#include <QString>
+#include <QStringList>
+#include <QThreadPool>
+#include <QWaitCondition>
+
+#include "Core/TonemappingOptions.h"
+#include "HdrCreation/createhdr.h"
+#include "HdrCreation/responsecache.h"
+#include "Libpfs/params.h"
+
+//! \brief Settings of one job of the batch mode: the same that a single
+//! invocation of the command line interface accepts
+struct BatchJob
+{
+    BatchJob();
+
+    int line;                       //!< line of the manifest
+    QStringList inputFiles;
+    QList<float> ev;
+    bool mtbAlign;
+    bool featureAlign;
+    FusionOperatorConfig fusionConfig;
+    int responseCacheMode;          //!< see libhdr::fusion::ResponseCacheMode
+    QString loadHdrFilename;
+    QString saveHdrFilename;
+    QString saveLdrFilename;
+    QSharedPointer<TonemappingOptions> tmopts;
+    pfs::Params ldrParams;
+    bool autolevels;
+};
+
+//! \brief Runs batch jobs through a bounded pipeline of four stages: read,
+//! merge, tonemap and write.
+//!
+//! Read and write run on the I/O pool, merge and tonemap on the CPU pool, so
+//! that decoding and encoding of some jobs overlap with the computation of
+//! others. A job is admitted only when its estimated memory fits in the
+//! budget, unless no other job is running.
+//! With \a tiledHdrs, the HDRs loaded or merged by the jobs are kept in the
+//! tiles of \c pfs::TileCache::global(), whose own budget bounds their
+//! footprint: past the merge, only the tonemapped frame is resident.
+//! Otherwise they are loaded as \c pfs::FrameView, which maps PFS and float
+//! TIFF files in memory instead of reading them: mapped pages are backed by
+//! the file, so they don't count against the budget.
+class BatchScheduler
+{
+public:
+    BatchScheduler(int cpuJobs, int ioJobs, qint64 memoryBudget, bool tiledHdrs, bool verbose);
+    ~BatchScheduler();
+
+    //! \brief Runs all the \a jobs and waits for their completion
+    //! \return number of failed jobs
+    int run(const QList<BatchJob>& jobs);
+
+    //! \brief Resident memory (in bytes) estimated for \a job, used by the
+    //! admission. A loaded HDR that the job saves as well is reserved until
+    //! it is known to be mapped
+    qint64 estimateMemory(const BatchJob& job) const;
+
+private:
+    struct JobState;
+    class StageTask;
+
+    enum Stage {
+        STAGE_READ,
+        STAGE_MERGE,
+        STAGE_TONEMAP,
+        STAGE_WRITE
+    };
+
+    void runStage(JobState* state, Stage stage);
+    void schedule(JobState* state, Stage stage);
+    void release(JobState* state, qint64 bytes);
+    void finish(JobState* state);
+
+    void read(JobState& state);
+    void merge(JobState& state);
+    void tonemap(JobState& state);
+    void write(JobState& state);
+
+    QThreadPool m_cpuPool;
+    QThreadPool m_ioPool;
+    const int m_cpuJobs;
+    const qint64 m_memoryBudget;
+    const bool m_tiledHdrs;
+    const bool m_verbose;
+
+    QMutex m_mutex;
+    QWaitCondition m_released;
+    qint64 m_memoryInUse;
+    int m_running;
+    int m_failed;
+
+    // curves calibrated by the jobs, shared among them
+    libhdr::fusion::ResponseCurveCache m_responseCache;
+
+    Q_DISABLE_COPY(BatchScheduler)
+};
+
+#endif // BATCHSCHEDULER_H
@@ -0,0 +1,255 @@
+/*
+ * This file is a part of Luminance HDR package
+ * ----------------------------------------------------------------------
+ * Copyright (C) 2017 Luminance HDR developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+#include "SequenceTonemapper.h"
+
+#include <QFile>
+#include <QFuture>
+#include <QImage>
+#include <QObject>
+#include <QRegExp>
+#include <QVector>
+#include <QtConcurrentRun>
+
+#include <cmath>
+#include <iostream>
+#include <stdexcept>
+
+#include "Common/CommonFunctions.h"
+#include "Core/IOWorker.h"
+#include "Core/TMWorker.h"
+#include "Fileformat/pfsoutldrimage.h"
+#include "Libpfs/frame.h"
+#include "Libpfs/manip/gamma_levels.h"
+#include "Libpfs/tm/TonemapOperator.h"
+
+namespace
+{
+void printIfVerbose(const QString& str, bool verbose)
+{
+    if ( verbose )
+    {
+        std::cout << qPrintable(str) << std::endl;
+    }
+}
+
+//! \return the frame, or NULL if \a filename is missing or cannot be read
+//! \note runs in a worker thread, errors are reported by the caller
+pfs::Frame* readFrame(const QString& filename)
+{
+    if ( !QFile::exists(filename) )
+    {
+        return NULL;
+    }
+    return IOWorker().read_hdr_frame(filename);
+}
+
+//! \note takes the ownership of \a frame
+bool writeFrame(pfs::Frame* frame, const QString& filename,
+                const TonemappingOptions& tmopts, const pfs::Params& params)
+{
+    QScopedPointer<pfs::Frame> ldr(frame);
+    TonemappingOptions options(tmopts);
+    return IOWorker().write_ldr_frame(ldr.data(), filename, QString(),
+                                      QVector<float>(), &options, params);
+}
+}
+
+SequenceTonemapper::SequenceTonemapper(const TonemappingOptions& tmopts,
+                                       const pfs::Params& ldrParams,
+                                       float fps, bool autolevels, bool verbose)
+    : m_tmopts(tmopts)
+    , m_ldrParams(ldrParams)
+    , m_fps(fps)
+    , m_autolevels(autolevels)
+    , m_verbose(verbose)
+    , m_operator(TonemapOperator::getTonemapOperator(tmopts.tmoperator))
+    , m_minL(-1.f)
+    , m_maxL(-1.f)
+    , m_gammaL(-1.f)
+{
+    m_operator->setSequenceMode(true, m_fps);
+}
+
+SequenceTonemapper::~SequenceTonemapper()
+{}
+
+QString SequenceTonemapper::frameFileName(const QString& pattern, int index)
+{
+    QRegExp conversion("%(0?)(\\d*)d");
+    const int pos = conversion.indexIn(pattern);
+    if ( pos < 0 || pattern.count('%') != 1 )
+    {
+        return QString();
+    }
+
+    const QChar fill = conversion.cap(1).isEmpty() ? QChar(' ') : QChar('0');
+    return pattern.left(pos)
+            + QString("%1").arg(index, conversion.cap(2).toInt(), 10, fill)
+            + pattern.mid(pos + conversion.matchedLength());
+}
+
+int SequenceTonemapper::run(const QString& inputPattern,
+                            const QString& outputPattern,
+                            int first, int last)
+{
+    if ( frameFileName(inputPattern, 0).isEmpty() ||
+         frameFileName(outputPattern, 0).isEmpty() )
+    {
+        throw std::runtime_error(QObject::tr("Sequence patterns must contain a single %d conversion")
+                                 .toStdString());
+    }
+
+    if ( first < 0 )
+    {
+        first = QFile::exists(frameFileName(inputPattern, 0)) ? 0 : 1;
+    }
+
+    QFuture<pfs::Frame*> nextHdr = QtConcurrent::run(readFrame, frameFileName(inputPattern, first));
+    bool reading = true;
+    QFuture<bool> pendingWrite;
+    bool writing = false;
+    QString pendingFilename;
+    int written = 0;
+
+    try
+    {
+        for (int index = first; reading; ++index)
+        {
+            QScopedPointer<pfs::Frame> hdr(nextHdr.result());
+            reading = false;
+            if ( hdr.isNull() )
+            {
+                const QString filename = frameFileName(inputPattern, index);
+                if ( QFile::exists(filename) )
+                {
+                    throw std::runtime_error(QObject::tr("Load file %1 failed")
+                                             .arg(filename).toStdString());
+                }
+                if ( index == first || last >= 0 )
+                {
+                    throw std::runtime_error(QObject::tr("Missing frame %1")
+                                             .arg(filename).toStdString());
+                }
+                break;
+            }
+            printIfVerbose(QObject::tr("Tonemapping frame %1").arg(frameFileName(inputPattern, index)), m_verbose);
+
+            // decode the next frame while this one is tone mapped...
+            if ( last < 0 || index < last )
+            {
+                nextHdr = QtConcurrent::run(readFrame, frameFileName(inputPattern, index + 1));
+                reading = true;
+            }
+
+            pfs::Frame* ldr = tonemap(hdr.data());
+            hdr.reset();
+
+            // ... and encode it while the next one is tone mapped
+            if ( writing )
+            {
+                writing = false;
+                if ( !pendingWrite.result() )
+                {
+                    delete ldr;
+                    throw std::runtime_error(QObject::tr("Cannot save to file: %1")
+                                             .arg(pendingFilename).toStdString());
+                }
+                ++written;
+            }
+            pendingFilename = frameFileName(outputPattern, index);
+            pendingWrite = QtConcurrent::run(writeFrame, ldr, pendingFilename,
+                                             m_tmopts, m_ldrParams);
+            writing = true;
+        }
+    }
+    catch (...)
+    {
+        // let the stages in flight complete before leaving
+        if ( writing )
+        {
+            pendingWrite.waitForFinished();
+        }
+        if ( reading )
+        {
+            delete nextHdr.result();
+        }
+        throw;
+    }
+
+    if ( writing )
+    {
+        if ( !pendingWrite.result() )
+        {
+            throw std::runtime_error(QObject::tr("Cannot save to file: %1")
+                                     .arg(pendingFilename).toStdString());
+        }
+        ++written;
+    }
+    return written;
+}
+
+pfs::Frame* SequenceTonemapper::tonemap(pfs::Frame* hdr)
+{
+    TonemappingOptions tmopts(m_tmopts);
+    tmopts.origxsize = hdr->getWidth();
+    if ( tmopts.xsize == -2 )
+    {
+        tmopts.xsize = hdr->getWidth();
+    }
+
+    TMWorker worker;
+    worker.setTonemapOperator(m_operator.data());
+    pfs::Frame* ldr = worker.computeTonemap(hdr, &tmopts, BilinearInterp);
+    if ( ldr == NULL )
+    {
+        throw std::runtime_error(QObject::tr("Tonemap failed").toStdString());
+    }
+
+    if ( m_autolevels )
+    {
+        applyAutolevels(ldr);
+    }
+    return ldr;
+}
+
+void SequenceTonemapper::applyAutolevels(pfs::Frame* ldr)
+{
+    float minL, maxL, gammaL;
+    QScopedPointer<QImage> image( fromLDRPFStoQImage(ldr) );
+    computeAutolevels(image.data(), 0.985f, minL, maxL, gammaL);
+
+    if ( m_gammaL < 0.f )
+    {
+        m_minL = minL;
+        m_maxL = maxL;
+        m_gammaL = gammaL;
+    }
+    else
+    {
+        // exponential smoothing with a time constant of one second
+        const float alpha = 1.f - std::exp(-1.f/m_fps);
+        m_minL += alpha*(minL - m_minL);
+        m_maxL += alpha*(maxL - m_maxL);
+        m_gammaL += alpha*(gammaL - m_gammaL);
+    }
+    pfs::gammaAndLevels(ldr, m_minL, m_maxL, 0.f, 1.f, m_gammaL);
+}
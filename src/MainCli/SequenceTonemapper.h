@@ -0,0 +1,91 @@
+/*
+ * This file is a part of Luminance HDR package
+ * ----------------------------------------------------------------------
+ * Copyright (C) 2017 Luminance HDR developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+//! \brief Tone mapping of a numbered sequence of HDR frames (i.e. a
+//! timelapse) in the command line interface
+
+#ifndef SEQUENCETONEMAPPER_H
+#define SEQUENCETONEMAPPER_H
+
+#include <QScopedPointer>
+#include <QString>
+
+#include "Core/TonemappingOptions.h"
+#include "Libpfs/params.h"
+
+namespace pfs
+{
+class Frame;
+}
+class TonemapOperator;
+
+//! \brief Tone maps the frames of a sequence with a single operator in
+//! sequence mode, so that operators with a temporal model carry their state
+//! from one frame to the next (see TonemapOperator::setSequenceMode()).
+//!
+//! The frames go through a pipeline of three stages: the next frame is
+//! decoded and the previous one is encoded while the current one is tone
+//! mapped. Autolevels, when requested, are smoothed over the sequence to
+//! avoid flickering.
+class SequenceTonemapper
+{
+public:
+    SequenceTonemapper(const TonemappingOptions& tmopts,
+                       const pfs::Params& ldrParams,
+                       float fps, bool autolevels, bool verbose);
+    ~SequenceTonemapper();
+
+    //! \brief Tone maps the frames from \a first to \a last (included) of
+    //! \a inputPattern and saves them with \a outputPattern
+    //! \param first first frame; if negative the sequence starts from 0, or
+    //! from 1 when there is no frame 0
+    //! \param last last frame; if negative the sequence ends at the first
+    //! missing frame
+    //! \return number of frames saved
+    //! \throw std::runtime_error if a frame cannot be read, tone mapped or
+    //! saved
+    int run(const QString& inputPattern, const QString& outputPattern,
+            int first, int last);
+
+    //! \brief name of the frame \a index of \a pattern, which must contain
+    //! a single decimal conversion like %d or %04d
+    //! \return empty string if \a pattern is not valid
+    static QString frameFileName(const QString& pattern, int index);
+
+private:
+    pfs::Frame* tonemap(pfs::Frame* hdr);
+    void applyAutolevels(pfs::Frame* ldr);
+
+    TonemappingOptions m_tmopts;
+    const pfs::Params m_ldrParams;
+    const float m_fps;
+    const bool m_autolevels;
+    const bool m_verbose;
+
+    QScopedPointer<TonemapOperator> m_operator;
+
+    // autolevels smoothed over the sequence; negative before the first frame
+    float m_minL;
+    float m_maxL;
+    float m_gammaL;
+};
+
+#endif // SEQUENCETONEMAPPER_H
@@ -27,9 +27,14 @@
 
 #include <QTimer>
 #include <QDebug>
+#include <QFile>
+#include <QTextStream>
 #include <iostream>
+#include <vector>
 
 #include "commandline.h"
+#include "BatchScheduler.h"
+#include "SequenceTonemapper.h"
 
 #include "Common/GitSHA1.h"
 #include "Common/config.h"
@@ -81,6 +86,40 @@ void printErrorAndExit(const QString& error_str)
     exit(-1);
 }
 
+//! \brief Splits a line of the batch manifest in arguments, separated by
+//! white spaces. Double quotes group arguments that contain spaces.
+QStringList splitArguments(const QString& line)
+{
+    QStringList arguments;
+    QString current;
+    bool quoted = false;
+    bool pending = false;
+    for (int i = 0; i < line.size(); i++)
+    {
+        const QChar c = line.at(i);
+        if (c == '"')
+        {
+            quoted = !quoted;
+            pending = true;
+        }
+        else if (c.isSpace() && !quoted)
+        {
+            if (pending)
+                arguments << current;
+            current.clear();
+            pending = false;
+        }
+        else
+        {
+            current += c;
+            pending = true;
+        }
+    }
+    if (pending)
+        arguments << current;
+    return arguments;
+}
+
 float toFloatWithErrMsg(const QString &str)
 {
     bool ok;
@@ -112,8 +151,16 @@ CommandLineInterfaceManager::CommandLineInterfaceManager(const int argc, char **
     htmlQuality(2),
     pageName(),
     imagesDir(),
-    saveAlignedImagesPrefix("")
+    saveAlignedImagesPrefix(""),
+    batchCpuJobs(1),
+    batchIoJobs(2),
+    batchMemory(2048),
+    tileMemory(0),
+    sequenceFirst(-1),
+    sequenceLast(-1),
+    sequenceFps(25.f)
 {
+    responseCacheMode = LuminanceOptions().getResponseCacheMode();
 
     hdrcreationconfig.weightFunction = WEIGHT_TRIANGULAR;
     hdrcreationconfig.responseCurve = RESPONSE_LINEAR;
@@ -123,6 +170,21 @@ CommandLineInterfaceManager::CommandLineInterfaceManager(const int argc, char **
 }
 
 int CommandLineInterfaceManager::execCommandLineParams()
+{
+    int result = parseCommandLine();
+    if (result != 0)
+        return result;
+
+    if (!batchFilename.isEmpty())
+        QTimer::singleShot(0, this, SLOT(execBatchSlot()));
+    else if (!sequencePattern.isEmpty())
+        QTimer::singleShot(0, this, SLOT(execSequenceSlot()));
+    else
+        QTimer::singleShot(0, this, SLOT(execCommandLineParamsSlot()));
+    return 0;
+}
+
+int CommandLineInterfaceManager::parseCommandLine()
 {
     // Declare the supported options.
     namespace po = boost::program_options;
@@ -134,12 +196,13 @@ int CommandLineInterfaceManager::execCommandLineParams()
         ("version,V", tr("Display program version.").toUtf8().constData())
         ("verbose,v", tr("Print more messages during execution.").toUtf8().constData())
         ("cameras,c", tr("Print a list of all supported cameras.").toUtf8().constData())
-        ("align,a", po::value<std::string>(),    tr("[AIS|MTB]   Align Engine to use during HDR creation (default: no alignment).").toUtf8().constData())
+        ("align,a", po::value<std::string>(),    tr("[AIS|MTB|FEATURE]   Align Engine to use during HDR creation (default: no alignment).").toUtf8().constData())
         ("ev,e", po::value<std::string>(),       tr("EV1,EV2,... Specify numerical EV values (as many as INPUTFILES).").toUtf8().constData())
         ("savealigned,d", po::value<std::string>(),       tr("prefix Save aligned images to files which names start with prefix").toUtf8().constData())
         //
         ("load,l", po::value<std::string>(),       tr("HDR_FILE Load an HDR instead of creating a new one.").toUtf8().constData())
         ("save,s", po::value<std::string>(),       tr("HDR_FILE Save to a HDR file format. (default: don't save)").toUtf8().constData())
+        ("tileMemory", po::value<int>(&tileMemory),       tr("MB     Keep the HDR, loaded with --load or merged, in tiles, spilling them to disk beyond MB of memory. Web pages are not supported. (default: 0, keep it in memory)").toUtf8().constData())
         ("gamma,g", po::value<float>(&tmopts->pregamma),       tr("VALUE        Gamma value to use during tone mapping. (default: 1) ").toUtf8().constData())
         ("resize,r", po::value<int>(&tmopts->xsize),       tr("VALUE       Width you want to resize your HDR to (resized before gamma and tone mapping)").toUtf8().constData())
 
@@ -155,6 +218,7 @@ int CommandLineInterfaceManager::execCommandLineParams()
         ("hdrResponseCurve", po::value<std::string>(),       tr("response curve = from_file|linear|gamma|log|srgb (Default is linear)").toUtf8().constData())
         ("hdrModel", po::value<std::string>(),       tr("model: robertson|robertsonauto|debevec (Default is debevec)").toUtf8().constData())
         ("hdrCurveFilename", po::value<std::string>(),       tr("curve filename = your_file_here.m").toUtf8().constData())
+        ("hdrResponseCache", po::value<std::string>(),       tr("cached curves of robertsonauto = off|reuse|warmstart (Default is reuse)").toUtf8().constData())
     ;
 
     po::options_description ldr_desc(tr("LDR output parameters").toUtf8().constData());
@@ -182,6 +246,21 @@ directory must exist.  Useful to avoid clutter in the current directory. \
 (Default is current working directory)").toUtf8().constData())
         ;
 
+    po::options_description batch_desc(tr("Batch mode parameters").toUtf8().constData());
+    batch_desc.add_options()
+        ("batch", po::value<std::string>(), tr("MANIFEST    Run the jobs listed in MANIFEST, one per line. Each line holds the options and INPUTFILES of a single invocation (AIS alignment, anti-ghosting and web pages are not supported). Empty lines and lines starting with # are skipped.").toUtf8().constData())
+        ("batchCpuJobs", po::value<int>(&batchCpuJobs), tr("VALUE      Jobs merged or tone mapped at the same time (default: 1)").toUtf8().constData())
+        ("batchIoJobs", po::value<int>(&batchIoJobs), tr("VALUE      Jobs read or written at the same time (default: 2)").toUtf8().constData())
+        ("batchMemory", po::value<int>(&batchMemory), tr("MB     Memory available to the jobs in flight (default: 2048)").toUtf8().constData())
+    ;
+    po::options_description sequence_desc(tr("Sequence mode parameters").toUtf8().constData());
+    sequence_desc.add_options()
+        ("sequence", po::value<std::string>(), tr("PATTERN    Tone map the numbered HDR frames matching PATTERN (e.g. frame_%04d.exr) with the same operator, carrying its adaptation state from one frame to the next. --output is the pattern of the LDR frames.").toUtf8().constData())
+        ("sequenceFirst", po::value<int>(&sequenceFirst), tr("VALUE     First frame (default: 0, or 1 if there is no frame 0)").toUtf8().constData())
+        ("sequenceLast", po::value<int>(&sequenceLast), tr("VALUE      Last frame (default: last consecutive frame)").toUtf8().constData())
+        ("sequenceFps", po::value<float>(&sequenceFps), tr("VALUE       Frame rate of the sequence (default: 25)").toUtf8().constData())
+        ;
+
     po::options_description tmo_desc(tr("Tone mapping parameters  - no tonemapping is performed unless -o is specified").toUtf8().constData());
     tmo_desc.add_options()
         ("tmo", po::value<std::string>(),       tr("Tone mapping operator. Legal values are: [ashikhmin|drago|durand|fattal|ferradans|pattanaik|reinhard02|reinhard05|mai|mantiuk06|mantiuk08] (Default is mantiuk06)").toUtf8().constData())
@@ -276,10 +355,10 @@ directory must exist.  Useful to avoid clutter in the current directory. \
     p.add("input-file", -1);
 
     po::options_description cmdline_options;
-    cmdline_options.add(desc).add(hdr_desc).add(ldr_desc).add(html_desc).add(tmo_desc).add(hidden);
+    cmdline_options.add(desc).add(hdr_desc).add(ldr_desc).add(html_desc).add(batch_desc).add(sequence_desc).add(tmo_desc).add(hidden);
 
     po::options_description cmdvisible_options;
-    cmdvisible_options.add(desc).add(hdr_desc).add(ldr_desc).add(html_desc).add(tmo_desc);
+    cmdvisible_options.add(desc).add(hdr_desc).add(ldr_desc).add(html_desc).add(batch_desc).add(sequence_desc).add(tmo_desc);
 
     try
     {
@@ -330,6 +409,8 @@ directory must exist.  Useful to avoid clutter in the current directory. \
                 alignMode = AIS_ALIGN;
             else if (strcmp(value,"MTB")==0)
                 alignMode = MTB_ALIGN;
+            else if (strcmp(value,"FEATURE")==0)
+                alignMode = FEATURE_ALIGN;
             else
                 printErrorAndExit(tr("Error: Alignment engine not recognized."));
         }
@@ -379,6 +460,17 @@ directory must exist.  Useful to avoid clutter in the current directory. \
         }
         if (vm.count("hdrCurveFilename"))
             hdrcreationconfig.inputResponseCurveFilename = QString::fromStdString(vm["hdrCurveFilename"].as<std::string>());
+        if (vm.count("hdrResponseCache")) {
+            const char* value = vm["hdrResponseCache"].as<std::string>().c_str();
+            if (strcmp(value,"off")==0)
+                responseCacheMode = RESPONSE_CACHE_OFF;
+            else if (strcmp(value,"reuse")==0)
+                responseCacheMode = RESPONSE_CACHE_REUSE;
+            else if (strcmp(value,"warmstart")==0)
+                responseCacheMode = RESPONSE_CACHE_WARM_START;
+            else
+                printErrorAndExit(tr("Error: Unknown response cache mode specified."));
+        }
         if (vm.count("tmo")) {
             const char* value = vm["tmo"].as<std::string>().c_str();
             if (strcmp(value,"ashikhmin")==0)
@@ -458,6 +550,18 @@ directory must exist.  Useful to avoid clutter in the current directory. \
             saveLdrFilename = QString::fromStdString(vm["output"].as<std::string>());
         if (vm.count("savealigned"))
             saveAlignedImagesPrefix = QString::fromStdString(vm["savealigned"].as<std::string>());
+        if (vm.count("batch"))
+            batchFilename = QString::fromStdString(vm["batch"].as<std::string>());
+        if (batchCpuJobs < 1 || batchIoJobs < 1 || batchMemory < 1)
+            printErrorAndExit(tr("Error: Batch jobs and memory must be positive."));
+        if (tileMemory < 0)
+            printErrorAndExit(tr("Error: Tile memory cannot be negative."));
+        if (tileMemory > 0 && isHtml)
+            printErrorAndExit(tr("Error: Web pages cannot be generated from a tiled HDR."));
+        if (vm.count("sequence"))
+            sequencePattern = QString::fromStdString(vm["sequence"].as<std::string>());
+        if (sequenceFps <= 0.0f)
+            printErrorAndExit(tr("Error: The frame rate must be positive."));
         if (threshold < 0.0f || threshold > 1.0f)
             printErrorAndExit(tr("Error: Threshold must be in the range [0..1]."));
 
@@ -484,13 +588,11 @@ directory must exist.  Useful to avoid clutter in the current directory. \
         }
     }
 
-    if (loadHdrFilename.isEmpty() && inputFiles.size() == 0)
+    if (loadHdrFilename.isEmpty() && inputFiles.size() == 0 && batchFilename.isEmpty() && sequencePattern.isEmpty())
     {
         cout << cmdvisible_options << endl;
         return 1;
     }
-
-    QTimer::singleShot(0, this, SLOT(execCommandLineParamsSlot()));
     return 0;
 }
 
@@ -537,6 +639,7 @@ void CommandLineInterfaceManager::execCommandLineParamsSlot()
         try
         {
             hdrCreationManager->setConfig(hdrcreationconfig);
+            hdrCreationManager->setResponseCacheMode(responseCacheMode);
             hdrCreationManager->loadFiles(inputFiles);
         }
         catch(std::runtime_error &e)
@@ -552,6 +655,22 @@ void CommandLineInterfaceManager::execCommandLineParamsSlot()
     {
         printIfVerbose(QObject::tr("Loading file %1").arg(loadHdrFilename), verbose);
 
+        if ( tileMemory > 0 )
+        {
+            pfs::TileCache::global().setMemoryBudget(size_t(tileMemory) << 20);
+            tiledHDR.reset( new pfs::TiledFrame );
+            if ( IOWorker().read_hdr_frame(loadHdrFilename, *tiledHDR) )
+            {
+                printIfVerbose(QObject::tr("Successfully loaded file %1 in tiles.").arg(loadHdrFilename), verbose);
+                saveHDR();
+            }
+            else
+            {
+                printErrorAndExit(tr("Load file %1 failed").arg(loadHdrFilename));
+            }
+            return;
+        }
+
         HDR.reset( IOWorker().read_hdr_frame(loadHdrFilename) );
 
         if ( HDR != NULL )
@@ -566,6 +685,105 @@ void CommandLineInterfaceManager::execCommandLineParamsSlot()
     }
 }
 
+BatchJob CommandLineInterfaceManager::toBatchJob(int line)
+{
+    if (!batchFilename.isEmpty() || alignMode == AIS_ALIGN || threshold > 0 || isHtml || tileMemory > 0 || !saveAlignedImagesPrefix.isEmpty())
+        printErrorAndExit(tr("Error: Line %1 uses options not supported in batch mode.").arg(line));
+    if (!ev.isEmpty() && ev.count() != inputFiles.count())
+        printErrorAndExit(tr("Error: The number of EV values specified is different from the number of input files."));
+    if (!loadHdrFilename.isEmpty() && !inputFiles.isEmpty())
+        printErrorAndExit(tr("Error: Line %1 both loads an HDR and lists input files.").arg(line));
+
+    BatchJob job;
+    job.line = line;
+    job.inputFiles = inputFiles;
+    job.ev = ev;
+    job.mtbAlign = (alignMode == MTB_ALIGN);
+    job.featureAlign = (alignMode == FEATURE_ALIGN);
+    job.fusionConfig = hdrcreationconfig;
+    job.responseCacheMode = responseCacheMode;
+    job.loadHdrFilename = loadHdrFilename;
+    job.saveHdrFilename = saveHdrFilename;
+    job.saveLdrFilename = saveLdrFilename;
+    job.tmopts = QSharedPointer<TonemappingOptions>(tmopts.take());
+    job.ldrParams = *tmofileparams;
+    job.autolevels = isAutolevels;
+    return job;
+}
+
+void CommandLineInterfaceManager::execBatchSlot()
+{
+    if (!inputFiles.isEmpty() || !loadHdrFilename.isEmpty())
+        printErrorAndExit(tr("Error: Input files must be listed in the batch manifest."));
+
+    QFile manifest(batchFilename);
+    if (!manifest.open(QIODevice::ReadOnly | QIODevice::Text))
+        printErrorAndExit(tr("Error: Cannot open the batch manifest %1").arg(batchFilename));
+
+    // parse the whole manifest first, so that errors show up before any job runs
+    QList<BatchJob> jobs;
+    QTextStream stream(&manifest);
+    for (int line = 1; !stream.atEnd(); ++line)
+    {
+        const QString text = stream.readLine().trimmed();
+        if (text.isEmpty() || text.startsWith('#'))
+            continue;
+
+        QList<QByteArray> arguments;
+        arguments << QByteArray(argv[0]);
+        foreach (const QString& argument, splitArguments(text))
+            arguments << argument.toLocal8Bit();
+
+        std::vector<char*> jobArgv;
+        for (int i = 0; i < arguments.size(); i++)
+            jobArgv.push_back(arguments[i].data());
+
+        CommandLineInterfaceManager jobParser(jobArgv.size(), jobArgv.data());
+        if (jobParser.parseCommandLine() != 0)
+            printErrorAndExit(tr("Error: Cannot parse line %1 of %2").arg(line).arg(batchFilename));
+        jobs << jobParser.toBatchJob(line);
+    }
+    printIfVerbose(tr("Running %1 batch jobs.").arg(jobs.size()), verbose);
+
+    // the tiles of the loaded and merged HDRs are accounted apart from the
+    // batch memory
+    if (tileMemory > 0)
+        pfs::TileCache::global().setMemoryBudget(size_t(tileMemory) << 20);
+
+    BatchScheduler scheduler(batchCpuJobs, batchIoJobs, qint64(batchMemory) << 20, tileMemory > 0, verbose);
+    const int failed = scheduler.run(jobs);
+    if (failed != 0)
+        printErrorAndExit(tr("Error: %1 of %2 batch jobs failed.").arg(failed).arg(jobs.size()));
+
+    emit finishedParsing();
+}
+
+void CommandLineInterfaceManager::execSequenceSlot()
+{
+    if (!inputFiles.isEmpty() || !loadHdrFilename.isEmpty())
+        printErrorAndExit(tr("Error: Input files cannot be used in sequence mode."));
+    if (saveLdrFilename.isEmpty())
+        printErrorAndExit(tr("Error: Sequence mode needs an output pattern."));
+    if (SequenceTonemapper::frameFileName(sequencePattern, 0).isEmpty() ||
+        SequenceTonemapper::frameFileName(saveLdrFilename, 0).isEmpty())
+        printErrorAndExit(tr("Error: Sequence patterns must contain a single %d conversion (e.g. %04d)."));
+    if (sequenceLast >= 0 && sequenceLast < sequenceFirst)
+        printErrorAndExit(tr("Error: The last frame comes before the first one."));
+
+    try
+    {
+        SequenceTonemapper tonemapper(*tmopts, *tmofileparams, sequenceFps, isAutolevels, verbose);
+        const int frames = tonemapper.run(sequencePattern, saveLdrFilename, sequenceFirst, sequenceLast);
+        printIfVerbose(tr("Tonemapped %1 frames.").arg(frames), verbose);
+    }
+    catch (const std::exception& e)
+    {
+        printErrorAndExit(tr("Error: %1").arg(QString::fromStdString(e.what())));
+    }
+
+    emit finishedParsing();
+}
+
 void CommandLineInterfaceManager::finishedLoadingInputFiles()
 {
     QStringList filesLackingExif = hdrCreationManager->getFilesWithoutExif();
@@ -591,6 +809,11 @@ void CommandLineInterfaceManager::finishedLoadingInputFiles()
         printIfVerbose( tr("Starting aligning...") , verbose);
         hdrCreationManager->align_with_mtb();
     }
+    else if (alignMode == FEATURE_ALIGN)
+    {
+        printIfVerbose( tr("Starting aligning...") , verbose);
+        hdrCreationManager->align_with_features();
+    }
     else if (alignMode == NO_ALIGN)
     {
         createHDR(0);
@@ -629,6 +852,18 @@ void CommandLineInterfaceManager::createHDR(int errorcode)
     else {
         HDR.reset( hdrCreationManager->createHdr() );
     }
+
+    expoTimes = hdrCreationManager->getExpotimes();
+    if ( tileMemory > 0 && HDR )
+    {
+        // the inputs are not needed anymore, and the merged HDR goes into the
+        // tiles like a loaded one
+        hdrCreationManager->clearFiles();
+        pfs::TileCache::global().setMemoryBudget(size_t(tileMemory) << 20);
+        tiledHDR.reset( new pfs::TiledFrame );
+        tiledHDR->copyFrom(*HDR);
+        HDR.reset();
+    }
     saveHDR();
 }
 
@@ -639,7 +874,10 @@ void CommandLineInterfaceManager::saveHDR()
         printIfVerbose( tr("Saving to file %1.").arg(saveHdrFilename) , verbose);
 
         // write_hdr_frame by default saves to EXR, if it doesn't find a supported file type
-        if ( IOWorker().write_hdr_frame(HDR.data(), saveHdrFilename) )
+        const bool saved = tiledHDR
+                ? IOWorker().write_hdr_frame(*tiledHDR, saveHdrFilename)
+                : IOWorker().write_hdr_frame(HDR.data(), saveHdrFilename);
+        if ( saved )
         {
             printIfVerbose( tr("Image %1 saved successfully").arg(saveHdrFilename) , verbose);
         }
@@ -688,12 +926,13 @@ void  CommandLineInterfaceManager::startTonemap()
 
         //now check if user wants to resize (create thread with either -2 or true original size as first argument in ctor, see options.cpp).
         //TODO
-        tmopts->origxsize = HDR->getWidth();
+        const int width = tiledHDR ? tiledHDR->getWidth() : HDR->getWidth();
+        tmopts->origxsize = width;
 #ifdef QT_DEBUG
         qDebug() << "XSIZE:" << tmopts->xsize;
 #endif
         if (tmopts->xsize == -2)
-            tmopts->xsize = HDR->getWidth();
+            tmopts->xsize = width;
         else
             printIfVerbose( tr("Resizing to width %1.").arg(tmopts->xsize) , verbose);
 
@@ -707,7 +946,9 @@ void  CommandLineInterfaceManager::startTonemap()
 
         // Build a new TM frame
         // The scoped pointer will free the memory automatically later on
-        QScopedPointer<pfs::Frame> tm_frame( tm_worker.computeTonemap(HDR.data(), tmopts.data(), BilinearInterp) );
+        QScopedPointer<pfs::Frame> tm_frame( tiledHDR
+                ? tm_worker.computeTonemap(*tiledHDR, tmopts.data(), BilinearInterp)
+                : tm_worker.computeTonemap(HDR.data(), tmopts.data(), BilinearInterp) );
 
         QString inputfname; // to copy EXIF tags from 1st input image to saved LDR
         if (inputFiles.isEmpty())
@@ -726,7 +967,7 @@ void  CommandLineInterfaceManager::startTonemap()
         // Create an ad-hoc IOWorker to save the file
         if ( IOWorker().write_ldr_frame(tm_frame.data(), saveLdrFilename,
                                         inputfname,
-                                        hdrCreationManager.data() ? hdrCreationManager->getExpotimes(): QVector<float>(),
+                                        expoTimes,
                                         tmopts.data(),
                                         *tmofileparams ) )
         {
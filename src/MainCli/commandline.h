@@ -32,13 +32,17 @@
 #include <QProcess>
 #include <QDir>
 #include <QScopedPointer>
+#include <QVector>
 
 #include "Core/TonemappingOptions.h"
 #include "HdrWizard/HdrCreationManager.h"
 #include "Libpfs/frame.h"
+#include "Libpfs/tiledframe.h"
 #include "Libpfs/params.h"
 #include "ezETAProgressBar.hpp"
 
+struct BatchJob;
+
 class CommandLineInterfaceManager : public QObject
 {
     Q_OBJECT
@@ -59,6 +63,7 @@ private:
     enum align_mode {
         AIS_ALIGN,
         MTB_ALIGN,
+        FEATURE_ALIGN,
         NO_ALIGN
     } alignMode;
 
@@ -67,12 +72,17 @@ private:
     QString saveHdrFilename;
     QString saveLdrFilename;
     QScopedPointer<pfs::Frame> HDR;
+    //! \brief loaded or merged HDR, when it is kept in tiles (see --tileMemory)
+    QScopedPointer<pfs::TiledFrame> tiledHDR;
+    //! \brief exposures of the merged inputs, kept after they are released
+    QVector<float> expoTimes;
     void saveHDR();
     void printHelp(char *progname);
     QScopedPointer<TonemappingOptions> tmopts;
     QScopedPointer<pfs::Params> tmofileparams;
     bool verbose;
     FusionOperatorConfig hdrcreationconfig;
+    int responseCacheMode;
     QString loadHdrFilename;
     QStringList inputFiles;
     ez::ezETAProgressBar progressBar;
@@ -87,7 +97,18 @@ private:
     std::string pageName;
     std::string imagesDir;
     QString saveAlignedImagesPrefix;
+    QString batchFilename;
+    int batchCpuJobs;
+    int batchIoJobs;
+    int batchMemory;
+    int tileMemory;
+    QString sequencePattern;
+    int sequenceFirst;
+    int sequenceLast;
+    float sequenceFps;
 
+    int parseCommandLine();
+    BatchJob toBatchJob(int line);
     void generateHTML();
     void startTonemap();
 
@@ -97,6 +118,8 @@ private slots:
     void errorWhileLoading(QString);
     void createHDR(int);
     void execCommandLineParamsSlot();
+    void execBatchSlot();
+    void execSequenceSlot();
     void setProgressBar(int);
     void updateProgressBar(int);
     void readData(QByteArray);
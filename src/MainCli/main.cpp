@@ -26,6 +26,7 @@
 #include "Common/config.h"
 #include "Common/TranslatorManager.h"
 #include "Common/LuminanceOptions.h"
+#include "Common/CommonFunctions.h"
 
 #include "MainCli/commandline.h"
 
@@ -39,6 +40,8 @@ int main( int argc, char ** argv )
 
     TranslatorManager::setLanguage( lumOpts.getGuiLang(), false );
 
+    ScopedFftwWisdom fftwWisdom;
+
     CommandLineInterfaceManager cli( argc, argv );
 
     try
@@ -33,6 +33,7 @@
 #include "Common/global.h"
 #include "Common/config.h"
 #include "Common/TranslatorManager.h"
+#include "Common/CommonFunctions.h"
 #include "MainWindow/MainWindow.h"
 #include "MainWindow/DonationDialog.h"
 
@@ -126,6 +127,8 @@ int main( int argc, char ** argv )
 
     LuminanceOptions().applyTheme(true);
 
+    ScopedFftwWisdom fftwWisdom;
+
     DonationDialog::showDonationDialog();
 
     // TODO: create update checker...
@@ -1539,6 +1539,8 @@ void MainWindow::setupTM()
     connect(this, SIGNAL(destroyed()), m_TMProgressBar, SLOT(deleteLater()));
 
     m_TMWorker = new TMWorker;
+    // tweaking the parameters of an operator reuses its previous results
+    m_TMWorker->setInteractiveMode(true);
     m_TMThread = new QThread;
 
     m_TMWorker->moveToThread(m_TMThread);
@@ -0,0 +1,184 @@
+/*
+ * This file is a part of Luminance HDR package
+ * ----------------------------------------------------------------------
+ * Copyright (C) 2017 Luminance HDR developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+
+#include "PreviewScheduler.h"
+
+#include <QDebug>
+#include <QImage>
+#include <QRunnable>
+#include <QScopedPointer>
+#include <QThread>
+
+#include <algorithm>
+#include <exception>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "Core/TonemappingOptions.h"
+#include "Fileformat/pfsoutldrimage.h"
+#include "Libpfs/frame.h"
+#include "Libpfs/manip/copy.h"
+#include "Libpfs/progress.h"
+#include "Libpfs/tm/TonemapOperator.h"
+#include "PreviewPanel/PreviewLabel.h"
+
+namespace // anonymous namespace
+{
+//! \brief Progress of a job: canceled as soon as the job is stale
+class JobProgress : public pfs::Progress
+{
+public:
+    JobProgress(const QAtomicInt& generation, int current)
+        : m_generation(generation)
+        , m_current(current)
+    {}
+
+    bool canceled() const
+    {
+        return m_generation.loadAcquire() != m_current;
+    }
+
+private:
+    const QAtomicInt& m_generation;
+    int m_current;
+};
+}
+
+class PreviewScheduler::Job : public QRunnable
+{
+public:
+    Job(PreviewScheduler* scheduler, int generation, int index,
+        QSharedPointer<const pfs::Frame> frame,
+        const TonemappingOptions& options, int threads)
+        : m_scheduler(scheduler)
+        , m_generation(generation)
+        , m_index(index)
+        , m_frame(frame)
+        , m_options(options)
+        , m_threads(threads)
+    {}
+
+    void run()
+    {
+        if ( !m_scheduler->isCurrent(m_generation) ) return;
+
+#ifdef _OPENMP
+        omp_set_num_threads(m_threads);
+#endif
+
+        // the operators work in place: each job tonemaps its own copy
+        QScopedPointer<pfs::Frame> frame( pfs::copy(m_frame.data()) );
+        JobProgress progress(m_scheduler->m_generation, m_generation);
+        try
+        {
+            QScopedPointer<TonemapOperator> tm_operator(
+                        TonemapOperator::getTonemapOperator(m_options.tmoperator) );
+            tm_operator->setBufferArena(&m_scheduler->m_arena);
+            tm_operator->tonemapFrame(*frame, &m_options, progress);
+        }
+        catch (const std::exception& e)
+        {
+            // the thumbnail keeps its previous content
+            qDebug() << "PreviewScheduler: TM" << static_cast<int>(m_options.tmoperator)
+                     << "failed:" << e.what();
+            return;
+        }
+
+        if ( progress.canceled() ) return;
+
+        QSharedPointer<QImage> image( fromLDRPFStoQImage(frame.data()) );
+
+        //! \note the labels must be updated in the GUI thread
+        QMetaObject::invokeMethod(m_scheduler, "deliver", Qt::QueuedConnection,
+                                  Q_ARG(int, m_generation),
+                                  Q_ARG(int, m_index),
+                                  Q_ARG(QSharedPointer<QImage>, image));
+    }
+
+private:
+    PreviewScheduler* m_scheduler;
+    int m_generation;
+    int m_index;
+    QSharedPointer<const pfs::Frame> m_frame;
+    TonemappingOptions m_options;
+    int m_threads;
+};
+
+PreviewScheduler::PreviewScheduler(QObject* parent)
+    : QObject(parent)
+    , m_generation(0)
+{
+    qRegisterMetaType< QSharedPointer<QImage> >("QSharedPointer<QImage>");
+}
+
+PreviewScheduler::~PreviewScheduler()
+{
+    // the running jobs use the arena and the generation
+    cancel();
+    m_pool.waitForDone();
+}
+
+bool PreviewScheduler::isCurrent(int generation) const
+{
+    return m_generation.loadAcquire() == generation;
+}
+
+void PreviewScheduler::cancel()
+{
+    m_generation.fetchAndAddOrdered(1);
+    m_pool.clear();
+    m_labels.clear();
+}
+
+void PreviewScheduler::render(QSharedPointer<const pfs::Frame> frame,
+                              const QList<PreviewLabel*>& labels)
+{
+    cancel();
+    if ( frame.isNull() || labels.isEmpty() ) return;
+
+    const int generation = m_generation.loadAcquire();
+
+    // the thumbnails already run in parallel among themselves
+    const int threads = std::max(QThread::idealThreadCount()/labels.size(), 1);
+
+    for (int index = 0; index < labels.size(); ++index)
+    {
+        PreviewLabel* label = labels.at(index);
+        m_labels.append(label);
+        m_pool.start(new Job(this, generation, index, frame,
+                             *label->getTonemappingOptions(), threads));
+    }
+}
+
+void PreviewScheduler::deliver(int generation, int index,
+                               QSharedPointer<QImage> image)
+{
+    if ( !isCurrent(generation) ) return;
+
+    PreviewLabel* label = m_labels.value(index);
+    if ( label != NULL )
+    {
+        label->assignNewQImage(image);
+    }
+}
@@ -0,0 +1,84 @@
+/*
+ * This file is a part of Luminance HDR package
+ * ----------------------------------------------------------------------
+ * Copyright (C) 2017 Luminance HDR developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+
+//! \brief Concurrent renderer of the thumbnails of \c PreviewSettings
+
+#ifndef PREVIEWSCHEDULER_H
+#define PREVIEWSCHEDULER_H
+
+#include <QAtomicInt>
+#include <QList>
+#include <QObject>
+#include <QPointer>
+#include <QSharedPointer>
+#include <QThreadPool>
+
+#include "Libpfs/bufferarena.h"
+
+// forward declaration
+namespace pfs {
+    class Frame;            // #include "Libpfs/frame.h"
+}
+
+class QImage;
+class PreviewLabel;         // #include "PreviewPanel/PreviewLabel.h"
+
+//! \brief Tonemaps one thumbnail per \c PreviewLabel on a thread pool.
+//!
+//! All the jobs of a render() read the same downsampled frame and recycle
+//! their temporaries through the same arena. Each render() (or cancel())
+//! makes the jobs of the previous one stale: the queued ones are dropped, the
+//! running ones are canceled through their progress and their result is
+//! discarded.
+class PreviewScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit PreviewScheduler(QObject* parent = 0);
+    ~PreviewScheduler();
+
+    //! \brief Renders \a frame with the options of each of \a labels
+    //! \note \a frame is never written: it must not be modified afterwards
+    void render(QSharedPointer<const pfs::Frame> frame,
+                const QList<PreviewLabel*>& labels);
+
+    //! \brief Drops the jobs of the last render()
+    void cancel();
+
+private Q_SLOTS:
+    void deliver(int generation, int index, QSharedPointer<QImage> image);
+
+private:
+    class Job;
+
+    bool isCurrent(int generation) const;
+
+    QThreadPool m_pool;
+    QAtomicInt m_generation;
+    QList< QPointer<PreviewLabel> > m_labels;
+    pfs::BufferArena m_arena;
+
+    Q_DISABLE_COPY(PreviewScheduler)
+};
+
+#endif // PREVIEWSCHEDULER_H
@@ -22,21 +22,15 @@
  */
 
 #include <QDebug>
-#include <QtConcurrentMap>
 #include <QSharedPointer>
 #include <QAction>
 
 #include "PreviewSettings.h"
+#include "PreviewScheduler.h"
 
 #include "Libpfs/frame.h"
-#include "Libpfs/manip/cut.h"
-#include "Libpfs/manip/copy.h"
 #include "Libpfs/manip/resize.h"
-#include "Libpfs/progress.h"
-#include "Libpfs/tm/TonemapOperator.h"
 
-#include "Core/TMWorker.h"
-#include "Fileformat/pfsoutldrimage.h"
 #include "PreviewPanel/PreviewLabel.h"
 #include "Common/LuminanceOptions.h"
 
@@ -45,8 +39,6 @@ namespace // anoymous namespace
 const int PREVIEW_WIDTH = 120;
 const int PREVIEW_HEIGHT = 100;
 
-//! \note It is not the most efficient way to do this thing, but I will fix it later
-//! this function get calls multiple time
 void resetTonemappingOptions(TonemappingOptions* tm_options, const pfs::Frame* frame)
 {
     tm_options->origxsize          = frame->getWidth();
@@ -54,73 +46,13 @@ void resetTonemappingOptions(TonemappingOptions* tm_options, const pfs::Frame* f
     tm_options->pregamma           = 1.0f;
     tm_options->tonemapSelection   = false;
 }
-
-class PreviewLabelUpdater
-{
-public:
-    explicit PreviewLabelUpdater(QSharedPointer<pfs::Frame> reference_frame):
-        m_ReferenceFrame(reference_frame)
-    {}
-
-    //! \brief QRunnable::run() definition
-    //! \caption I use shared pointer in this function, so I don't have to worry about memory allocation
-    //! in case something wrong happens, it shouldn't leak
-    void operator()(PreviewLabel* to_update)
-    {
-#ifdef QT_DEBUG
-        //qDebug() << QThread::currentThread() << "running...";
-#endif
-
-        // retrieve TM parameters
-        TonemappingOptions* tm_options = to_update->getTonemappingOptions();
-        resetTonemappingOptions(tm_options, m_ReferenceFrame.data());
-
-        if ( m_ReferenceFrame.isNull() )
-        {
-#ifdef QT_DEBUG
-            qDebug() << "operator()() for TM" << static_cast<int>(tm_options->tmoperator) << " received a NULL pointer";
-            return;
-#endif
-        }
-
-        pfs::Progress fake_progress;
-
-        // Copy Reference Frame
-        QSharedPointer<pfs::Frame> temp_frame( pfs::copy(m_ReferenceFrame.data()) );
-
-        // Tone Mapping
-        QScopedPointer<TonemapOperator> tm_operator( TonemapOperator::getTonemapOperator(tm_options->tmoperator));
-        tm_operator->tonemapFrame(*temp_frame, tm_options, fake_progress);
-
-        // Create QImage from pfs::Frame into QSharedPointer, and I give it to the preview panel
-        QSharedPointer<QImage> qimage(fromLDRPFStoQImage(temp_frame.data()));
-
-        //! \note I cannot use these 2 functions, because setPixmap must run in the GUI thread
-        //m_PreviewLabel->setPixmap( QPixmap::fromImage(*qimage) );
-        //m_PreviewLabel->adjustSize();
-        //! \note So I queue a SLOT request on the m_PreviewSettings
-        QMetaObject::invokeMethod(to_update, "assignNewQImage", Qt::QueuedConnection,
-                                  Q_ARG(QSharedPointer<QImage>, qimage));
-
-#ifdef QT_DEBUG
-        //qDebug() << QThread::currentThread() << "done!";
-#endif
-    }
-
-private:
-    QSharedPointer<pfs::Frame> m_ReferenceFrame;
-};
-
 }
 
 PreviewSettings::PreviewSettings(QWidget *parent):
     QWidget(parent),
     m_original_width_frame(0)
 {
-    //! \note I need to register the new object to pass this class as parameter inside invokeMethod()
-    //! see run() inside PreviewLabelUpdater
-    qRegisterMetaType< QSharedPointer<QImage> >("QSharedPointer<QImage>");
-
+    m_scheduler = new PreviewScheduler(this);
     m_flowLayout = new FlowLayout;
 
     setLayout(m_flowLayout);
@@ -157,17 +89,15 @@ void PreviewSettings::updatePreviews(pfs::Frame* frame)
         float ratio = ((float)frame_width)/frame_height;
         resized_width = PREVIEW_HEIGHT*ratio;
     }
-    // 1. make a resized copy
-    QSharedPointer<pfs::Frame> current_frame( pfs::resize(frame, resized_width, BilinearInterp) );
+    // 1. make a resized copy, shared (read-only) by all the thumbnails
+    QSharedPointer<const pfs::Frame> current_frame( pfs::resize(frame, resized_width, BilinearInterp) );
 
-    // 2. (non concurrent) for each PreviewLabel, call PreviewLabelUpdater::operator()
+    // 2. (concurrent) tonemap it with the settings of each PreviewLabel
     foreach (PreviewLabel* current_label, m_ListPreviewLabel)
     {
-        PreviewLabelUpdater updater(current_frame);
-        updater(current_label);
+        resetTonemappingOptions(current_label->getTonemappingOptions(), current_frame.data());
     }
-    // 2. (concurrent) for each PreviewLabel, call PreviewLabelUpdater::operator()
-    //QtConcurrent::map (m_ListPreviewLabel, PreviewLabelUpdater(current_frame) );
+    m_scheduler->render(current_frame, m_ListPreviewLabel);
 }
 
 void PreviewSettings::tonemapPreview(TonemappingOptions* opts)
@@ -219,6 +149,7 @@ PreviewLabel * PreviewSettings::getPreviewLabel(int index) {
 }
 
 void PreviewSettings::clear() {
+    m_scheduler->cancel();
     int size = m_flowLayout->getSize();
     for (int i = 0; i < size; i++) {
         m_flowLayout->takeAt(i);
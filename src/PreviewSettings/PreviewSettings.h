@@ -35,6 +35,7 @@ namespace pfs {
 
 class TonemappingOptions;   // #include "Core/TonemappingOptions.h"
 class PreviewLabel;         // #include "PreviewSettings/PreviewLabel.h"
+class PreviewScheduler;     // #include "PreviewSettings/PreviewScheduler.h"
 
 class PreviewSettings : public QWidget
 {
@@ -66,5 +67,6 @@ private:
     int m_original_width_frame;
     QList<PreviewLabel*> m_ListPreviewLabel;
     FlowLayout *m_flowLayout;
+    PreviewScheduler *m_scheduler;
 };
 #endif
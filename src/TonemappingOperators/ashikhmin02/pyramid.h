@@ -30,7 +30,8 @@
 
 #include <stdio.h>
 
-#include "Libpfs/array2d_fwd.h"
+#include "Libpfs/array2d.h"
+#include "Libpfs/manip/pyramid.h"
 
 class Pyramid { // each level of a Gaussian pyramid
  public:
@@ -72,28 +73,6 @@ class GaussianPyramid
 
   GaussianPyramid(pfs::Array2Df* lum_map, int im_height, int im_width)
   {
-    // set a=0.4 (considered by Burt and Adelson, 1983).
-    // obtained by Outer((0.05, 0.25, 0.4, 0.25, 0.05),(0.05, 0.25, 0.4, 0.25, 0.05))
-    g_weights[0][0] = g_weights[0][4] = 0.0025;
-    g_weights[0][1] = g_weights[0][3] = 0.0125;
-    g_weights[0][2] = 0.0200;
-
-    g_weights[1][0] = g_weights[1][4] = 0.0125;
-    g_weights[1][1] = g_weights[1][3] = 0.0625;
-    g_weights[1][2] = 0.1000;
-
-    g_weights[2][0] = g_weights[2][4] = 0.0200;
-    g_weights[2][1] = g_weights[2][3] = 0.1000;
-    g_weights[2][2] = 0.1600;
-
-    g_weights[3][0] = g_weights[3][4] = 0.0125;
-    g_weights[3][1] = g_weights[3][3] = 0.0625;
-    g_weights[3][2] = 0.1000;
-
-    g_weights[4][0] = g_weights[4][4] = 0.0025;
-    g_weights[4][1] = g_weights[4][3] = 0.0125;
-    g_weights[4][2] = 0.0200;
-
     constructPyramid(lum_map, im_width, im_height);
   }
 
@@ -191,34 +170,10 @@ class GaussianPyramid
     double new_lambda = p[current_index].lambda * 0.5;
     initializeNewLevel(next_index, w, h, k_size, new_lambda);
 
-    // apply 5*5 kernel
-    int X, Y;
-    for(int y=0; y<h; y++) {
-      for(int x=0; x<w; x++) {
-    double sum = 0.0;
-    for(int n=-2; n<3; n++) {
-      for(int m=-2; m<3; m++) {
-        if(2*x+m >= 0 && 2*x+m < p[current_index].width)
-          X = 2*x+m;
-        else if(2*x+m < 0)
-          X = 0;
-        else
-          X = p[current_index].width-1;
-
-        if(2*y+n >= 0 && 2*y+n < p[current_index].height)
-          Y = 2*y+n;
-        else if(2*y+n < 0)
-          Y = 0;
-        else
-          Y = p[current_index].height-1;
-
-        sum += g_weights[m+2][n+2] * p[current_index].getPixel(X, Y);
-      }
-    }
+    // apply 5*5 kernel, with a=0.4 (considered by Burt and Adelson, 1983)
+    pfs::gaussianReduce(*p[current_index].GP, *p[next_index].GP,
+                        pfs::PyramidKernel::burtAdelson(0.4f), pfs::BORDER_CLAMP);
 
-    p[next_index].setPixel(x, y, sum);
-      }
-    }
     return next_index;
   }
 
@@ -255,7 +210,6 @@ class GaussianPyramid
 
   static const int PYRAMID = 20;
   Pyramid p[PYRAMID];
-  double g_weights[5][5];
 
 };
 
@@ -35,6 +35,7 @@
 #include "TonemappingOperators/pfstmo.h"
 #include "Libpfs/array2d.h"
 #include "Libpfs/progress.h"
+#include "bilateral.h"
 
 #ifdef BRANCH_PREDICTION
 #define likely(x)       __builtin_expect((x),1)
@@ -104,7 +105,14 @@ void bilateralFilter(const pfs::Array2Df *I, pfs::Array2Df *J,
                      float sigma_s, float sigma_r,
                      pfs::Progress& ph)
 {
-    const pfs::Array2Df *X1 = I;     // intensity data     // DAVIDE : CHECK THIS!
+    // intensity data, with the non-finite values replaced once rather than
+    // at every tap
+    pfs::Array2Df X1(I->getCols(), I->getRows());
+    for (size_t i = 0; i < X1.size(); i++ )
+    {
+        float I_i = (*I)(i);
+        X1(i) = boost::math::isfinite( I_i ) ? I_i : 0.0f;
+    }
 
     // x +- sigma_s*2 should contain 95% of the Gaussian distrib
     int sKernelSize = (int)( sigma_s*4 + 0.5 ) + 1;
@@ -122,10 +130,7 @@ void bilateralFilter(const pfs::Array2Df *I, pfs::Array2Df *J,
         {
             float val = 0;
             float k = 0;
-            float I_s = (*X1)(x,y);    //!! previously 'I' not 'X1'
-
-            if( unlikely( !boost::math::isfinite( I_s ) ) )
-                I_s = 0.0f;
+            float I_s = X1(x,y);
 
             for( int py = max( 0, y - sKernelSize_2), pymax = min( I->getRows(), y + sKernelSize_2);
                 py < pymax; py++ )
@@ -133,18 +138,12 @@ void bilateralFilter(const pfs::Array2Df *I, pfs::Array2Df *J,
                 for( int px = max( 0, x - sKernelSize_2), pxmax = min( I->getCols(), x + sKernelSize_2);
                     px < pxmax; px++ )
                 {
-                    float I_p = (*X1)(px, py);    //!! previously 'I' not 'X1'
-                    if( unlikely( !boost::math::isfinite( I_p ) ) )
-                        I_p = 0.0f;
+                    float I_p = X1(px, py);
 
                     float mult = sKernel(px-x + sKernelSize_2, py-y + sKernelSize_2) *
                         gauss.getValue( I_p - I_s );
 
-                    float Ixy = (*I)(px, py);
-                    if( unlikely( !boost::math::isfinite( Ixy ) ) )
-                        Ixy = 0.0f;
-
-                    val += Ixy * mult;    //!! but here we want 'I'
+                    val += I_p * mult;
                     k += mult;
                 }
             }
@@ -34,6 +34,7 @@
 
 #include "Libpfs/array2d.h"
 #include "Libpfs/progress.h"
+#include "Libpfs/fftplancache.h"
 #include "fastbilateral.h"
 
 #ifdef BRANCH_PREDICTION
@@ -52,8 +53,6 @@ class GaussianBlur
 {
   float* source;
   fftwf_complex* freq;
-  fftwf_plan fplan_fw;
-  fftwf_plan fplan_in;
 
   float sigma;
 
@@ -67,8 +66,6 @@ public:
     freq = (fftwf_complex*) fftwf_malloc(sizeof(fftwf_complex) * osize);
 //    if( source == NULL || freq == NULL )
     //TODO: throw exception
-    fplan_fw = fftwf_plan_dft_r2c_2d(nx, ny, source, freq, FFTW_ESTIMATE);
-    fplan_in = fftwf_plan_dft_c2r_2d(nx, ny, freq, source, FFTW_ESTIMATE);
   }
 
 
@@ -87,7 +84,7 @@ public:
       for( x=0 ; x<nx ; x++ )
         source[x*ny+y] = I(x,y);
 
-    fftwf_execute(fplan_fw);
+    pfs::FFTPlanCache::global().r2c(nx, ny, source, freq);
 
     // filter
     float sig = nx/(2.0f*sigma);
@@ -104,7 +101,7 @@ public:
         freq[(ox-x-1)*oy+y][1] *= kernel;
       }
 
-    fftwf_execute(fplan_in);
+    pfs::FFTPlanCache::global().c2r(nx, ny, freq, source);
 
     for( x=0 ; x<nx ; x++ )
       for( y=0 ; y<ny ; y++ )
@@ -115,8 +112,6 @@ public:
   {
     fftwf_free(source);
     fftwf_free(freq);
-    fftwf_destroy_plan(fplan_fw);
-    fftwf_destroy_plan(fplan_in);
   }
 
 
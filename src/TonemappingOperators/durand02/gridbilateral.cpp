@@ -0,0 +1,283 @@
+/*
+ * This file is a part of Luminance HDR package
+ * ----------------------------------------------------------------------
+ * Copyright (C) 2017 Luminance HDR developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include <boost/math/special_functions/fpclassify.hpp>
+
+#include "Libpfs/array2d.h"
+#include "Libpfs/progress.h"
+#include "Libpfs/utils/simd.h"
+#include "gridbilateral.h"
+
+namespace
+{
+// radius (in cells) of the Gaussian used to blur the grid: the grid is
+// sampled at sigma, so the kernel has a unit standard deviation
+const int BLUR_RADIUS = 2;
+// empty cells around the data, so that blurring and slicing never need to
+// clamp their coordinates
+const int PADDING = BLUR_RADIUS;
+
+//! \brief Homogeneous bilateral grid: every cell stores the sum of the
+//! intensities splatted into it and their count
+class BilateralGrid
+{
+public:
+    BilateralGrid(int width, int height, int depth)
+        : m_width(width)
+        , m_height(height)
+        , m_depth(depth)
+        , m_data(static_cast<size_t>(width)*height*depth*2, 0.f)
+        , m_buffer(m_data.size())
+    {
+        for (int k = -BLUR_RADIUS; k <= BLUR_RADIUS; ++k)
+        {
+            m_kernel[k + BLUR_RADIUS] = std::exp(-0.5f*k*k);
+        }
+    }
+
+    int width() const   { return m_width; }
+    int height() const  { return m_height; }
+    int depth() const   { return m_depth; }
+
+    float* cell(int x, int y, int z)
+    {
+        return &m_data[((static_cast<size_t>(y)*m_width + x)*m_depth + z)*2];
+    }
+
+    const float* cell(int x, int y, int z) const
+    {
+        return &m_data[((static_cast<size_t>(y)*m_width + x)*m_depth + z)*2];
+    }
+
+    //! \brief Gaussian blur along the three axes
+    void blur()
+    {
+        const size_t column = static_cast<size_t>(m_depth)*2;
+
+        // y: the lines are whole (x, z) planes
+        blurSpatial(1, m_height, column*m_width);
+        // x: the lines are the (z) columns of every plane
+        blurSpatial(m_height, m_width, column);
+        blurRange();
+    }
+
+private:
+    //! \brief Blurs \c count independent blocks of \c n lines of \c stride
+    //! values each. Every line is a contiguous vector, so the taps are
+    //! accumulated with the SIMD kernels.
+    void blurSpatial(int count, int n, size_t stride)
+    {
+        const pfs::utils::simd::Kernels& simd = pfs::utils::simd::kernels();
+        const float* in = m_data.data();
+        float* out = m_buffer.data();
+        const int lines = count*n;
+
+#pragma omp parallel for schedule(static)
+        for (int l = 0; l < lines; ++l)
+        {
+            const int i = l % n;
+            const float* src = in + static_cast<size_t>(l - i)*stride;
+            float* dst = out + static_cast<size_t>(l)*stride;
+
+            const int kMin = std::max(-BLUR_RADIUS, -i);
+            const int kMax = std::min(BLUR_RADIUS, n - 1 - i);
+
+            simd.smul(src + (i + kMin)*stride, m_kernel[kMin + BLUR_RADIUS],
+                      dst, stride);
+            for (int k = kMin + 1; k <= kMax; ++k)
+            {
+                simd.adds(dst, m_kernel[k + BLUR_RADIUS],
+                          src + (i + k)*stride, dst, stride);
+            }
+        }
+        m_data.swap(m_buffer);
+    }
+
+    //! \brief Blurs along the intensity axis, whose (value, weight) pairs are
+    //! interleaved
+    void blurRange()
+    {
+        const int columns = m_width*m_height;
+        const int depth = m_depth;
+        const float* in = m_data.data();
+        float* out = m_buffer.data();
+
+#pragma omp parallel for schedule(static)
+        for (int c = 0; c < columns; ++c)
+        {
+            const float* src = in + static_cast<size_t>(c)*depth*2;
+            float* dst = out + static_cast<size_t>(c)*depth*2;
+
+            for (int z = 0; z < depth; ++z)
+            {
+                const int kMin = std::max(-BLUR_RADIUS, -z);
+                const int kMax = std::min(BLUR_RADIUS, depth - 1 - z);
+
+                float value = 0.f;
+                float weight = 0.f;
+                for (int k = kMin; k <= kMax; ++k)
+                {
+                    value += m_kernel[k + BLUR_RADIUS]*src[(z + k)*2];
+                    weight += m_kernel[k + BLUR_RADIUS]*src[(z + k)*2 + 1];
+                }
+                dst[z*2] = value;
+                dst[z*2 + 1] = weight;
+            }
+        }
+        m_data.swap(m_buffer);
+    }
+
+    int m_width;
+    int m_height;
+    int m_depth;
+    std::vector<float> m_data;
+    std::vector<float> m_buffer;
+    float m_kernel[2*BLUR_RADIUS + 1];
+};
+
+inline
+float sanitize(float value)
+{
+    return boost::math::isfinite(value) ? value : 0.f;
+}
+
+inline
+int nearest(float value)
+{
+    return static_cast<int>(value + 0.5f);
+}
+}
+
+void gridBilateralFilter(const pfs::Array2Df& I, pfs::Array2Df& J,
+                         float sigma_s, float sigma_r,
+                         pfs::Progress& ph)
+{
+    const int w = I.getCols();
+    const int h = I.getRows();
+    const int size = w*h;
+
+    // finer samplings than one pixel or one intensity level bring no accuracy
+    const float samplingS = std::max(sigma_s, 1.f);
+    const float samplingR = std::max(sigma_r, 1e-3f);
+
+    float minI = 0.f;
+    float maxI = 0.f;
+    if ( size > 0 )
+    {
+        minI = maxI = sanitize(I(0));
+        for (int i = 1; i < size; ++i)
+        {
+            const float v = sanitize(I(i));
+            minI = std::min(minI, v);
+            maxI = std::max(maxI, v);
+        }
+    }
+
+    BilateralGrid grid(
+                static_cast<int>(std::ceil((w - 1)/samplingS)) + 1 + 2*PADDING,
+                static_cast<int>(std::ceil((h - 1)/samplingS)) + 1 + 2*PADDING,
+                static_cast<int>(std::ceil((maxI - minI)/samplingR)) + 1 + 2*PADDING);
+
+    // every plane of the grid is filled by a contiguous range of rows, so
+    // that the planes can be splatted concurrently
+    std::vector<int> firstRow(grid.height() + 1, h);
+    for (int y = h - 1; y >= 0; --y)
+    {
+        firstRow[nearest(y/samplingS) + PADDING] = y;
+    }
+    for (int gy = grid.height() - 1; gy >= 0; --gy)
+    {
+        firstRow[gy] = std::min(firstRow[gy], firstRow[gy + 1]);
+    }
+
+    ph.setValue(5);
+
+#pragma omp parallel for schedule(dynamic)
+    for (int gy = 0; gy < grid.height(); ++gy)
+    {
+        for (int y = firstRow[gy]; y < firstRow[gy + 1]; ++y)
+        {
+            for (int x = 0; x < w; ++x)
+            {
+                const float v = sanitize(I(x, y));
+                float* c = grid.cell(nearest(x/samplingS) + PADDING, gy,
+                                     nearest((v - minI)/samplingR) + PADDING);
+                c[0] += v;
+                c[1] += 1.f;
+            }
+        }
+    }
+
+    ph.setValue(30);
+    if ( ph.canceled() ) return;
+
+    grid.blur();
+
+    ph.setValue(70);
+    if ( ph.canceled() ) return;
+
+    // trilinear interpolation of the blurred grid
+    const int strideX = grid.depth()*2;
+    const int strideY = grid.width()*strideX;
+
+#pragma omp parallel for schedule(static)
+    for (int y = 0; y < h; ++y)
+    {
+        const float fy = y/samplingS + PADDING;
+        const int gy = static_cast<int>(fy);
+        const float ty = fy - gy;
+
+        for (int x = 0; x < w; ++x)
+        {
+            const float v = sanitize(I(x, y));
+
+            const float fx = x/samplingS + PADDING;
+            const float fz = (v - minI)/samplingR + PADDING;
+            const int gx = static_cast<int>(fx);
+            const int gz = static_cast<int>(fz);
+            const float tx = fx - gx;
+            const float tz = fz - gz;
+
+            const float* c = grid.cell(gx, gy, gz);
+
+            float value = 0.f;
+            float weight = 0.f;
+            for (int dy = 0; dy <= 1; ++dy)
+            {
+                const float wy = dy ? ty : 1.f - ty;
+                for (int dx = 0; dx <= 1; ++dx)
+                {
+                    const float wxy = wy*(dx ? tx : 1.f - tx);
+                    const float* p = c + dy*strideY + dx*strideX;
+
+                    value += wxy*((1.f - tz)*p[0] + tz*p[2]);
+                    weight += wxy*((1.f - tz)*p[1] + tz*p[3]);
+                }
+            }
+
+            J(x, y) = (weight > 0.f) ? value/weight : v;
+        }
+    }
+}
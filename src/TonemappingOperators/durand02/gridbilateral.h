@@ -1,7 +1,7 @@
 /*
  * This file is a part of Luminance HDR package
  * ----------------------------------------------------------------------
- * Copyright (C) 2011 Davide Anastasia
+ * Copyright (C) 2017 Luminance HDR developers
  *
  *  This program is free software; you can redistribute it and/or modify
  *  it under the terms of the GNU General Public License as published by
@@ -19,41 +19,32 @@
  * ----------------------------------------------------------------------
  */
 
-//! @brief SSE for high performance vector operations
-//! @author Davide Anastasia, <davideanastasia@users.sourceforge.net>
-
-#ifndef PFS_UTILS_SSE_H
-#define PFS_UTILS_SSE_H
-
-namespace pfs {
-namespace utils {
-
-#ifdef __SSE__
-
-//#if __ppc__ || __ppc7400__ || __ppc64__ || __ppc970__
-//#include <ppc_intrinsics.h>
-#if __i386__ || __x86_64__
-// #define LUMINANCE_USE_SSE
-#include <mm_malloc.h>
-#include <xmmintrin.h>
-#include <mm_malloc.h>
-//#include <pmmintrin.h>
-//#include <tmmintrin.h>
-
-#else
-#error unsupported architecture
-#endif
-
-#endif // __SSE__
-
-#ifdef LUMINANCE_USE_SSE
-typedef __v4sf v4sf;
-v4sf _mm_log2_ps(v4sf);
-v4sf _mm_exp2_ps(v4sf);
-v4sf _mm_pow_ps(v4sf, v4sf);
-#endif
-
-}   // utils
-}   // pfs
-
-#endif // PFS_UTILS_SSE_H
+#ifndef GRIDBILATERAL_H
+#define GRIDBILATERAL_H
+
+#include <Libpfs/array2d_fwd.h>
+
+namespace pfs
+{
+class Progress;
+}
+
+//!
+//! @brief Bilateral filtering on a bilateral grid
+//!
+//! The image is splatted into a 3D grid (x, y, intensity) sampled every
+//! \c sigma_s pixels and every \c sigma_r intensity levels, blurred with a
+//! separable Gaussian and sliced back with trilinear interpolation
+//! (Paris and Durand, 2006). The cost is linear in the number of pixels and
+//! decreases as the kernels grow.
+//!
+//! \param I [in] input array
+//! \param J [out] filtered array
+//! \param sigma_s sigma value for spatial kernel
+//! \param sigma_r sigma value for range kernel
+//!
+void gridBilateralFilter(const pfs::Array2Df& I, pfs::Array2Df& J,
+                         float sigma_s, float sigma_r,
+                         pfs::Progress& ph);
+
+#endif // GRIDBILATERAL_H
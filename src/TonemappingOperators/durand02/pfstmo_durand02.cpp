@@ -45,6 +45,7 @@ namespace
 {
 const int downsample = 1;
 const bool original_algorithm = false;
+const Durand02Filter filter = DURAND02_PIECEWISE_LINEAR;
 }
 
 //--- default tone mapping parameters;
@@ -58,7 +59,7 @@ const bool original_algorithm = false;
 
 void pfstmo_durand02(pfs::Frame& frame,
                      float sigma_s, float sigma_r, float baseContrast,
-                     pfs::Progress &ph)
+                     pfs::Progress &ph, pfs::BufferArena* arena)
 {
 #ifndef NDEBUG
     std::stringstream ss;
@@ -89,7 +90,7 @@ void pfstmo_durand02(pfs::Frame& frame,
 
   tmo_durand02(*X, *Y, *Z,
                sigma_s, sigma_r, baseContrast, downsample, !original_algorithm,
-               ph);
+               ph, filter, arena);
 
   if ( !ph.canceled() )
       ph.setValue(100);
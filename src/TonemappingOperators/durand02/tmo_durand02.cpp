@@ -40,14 +40,15 @@
 #include "Libpfs/array2d.h"
 #include "Libpfs/progress.h"
 #include "TonemappingOperators/pfstmo.h"
+#include "tmo_durand02.h"
 
 //#undef HAVE_FFTW3F
 
 #ifdef HAVE_FFTW3F
 #include "fastbilateral.h"
-#else
-#include "bilateral.h"
 #endif
+#include "bilateral.h"
+#include "gridbilateral.h"
 
 namespace
 {
@@ -107,15 +108,18 @@ R output = r*exp(log(output intensity)), etc.
 void tmo_durand02(pfs::Array2Df& R, pfs::Array2Df& G, pfs::Array2Df& B,
                   float sigma_s, float sigma_r, float baseContrast, int downsample,
                   bool color_correction,
-                  pfs::Progress &ph)
+                  pfs::Progress &ph,
+                  Durand02Filter filter,
+                  pfs::BufferArena* arena)
 {
     int w = R.getCols();
     int h = R.getRows();
     int size = w*h;
 
-    pfs::Array2Df I(w,h); // intensities
-    pfs::Array2Df BASE(w,h); // base layer
-    pfs::Array2Df DETAIL(w,h); // detail layer
+    // all the temporaries are fully written before being read
+    pfs::Array2Df I(w,h,arena,false); // intensities
+    pfs::Array2Df BASE(w,h,arena,false); // base layer
+    pfs::Array2Df DETAIL(w,h,arena,false); // detail layer
 
     float min_pos = 1e10f; // minimum positive value (to avoid log(0))
     for (int i = 0 ; i < size ; i++)
@@ -142,11 +146,25 @@ void tmo_durand02(pfs::Array2Df& R, pfs::Array2Df& G, pfs::Array2Df& B,
         I(i) = std::log( L );
     }
 
+    switch ( filter )
+    {
+    case DURAND02_BRUTE_FORCE:
+        bilateralFilter( &I, &BASE, sigma_s, sigma_r, ph );
+        break;
 #ifdef HAVE_FFTW3F
-    fastBilateralFilter( I, BASE, sigma_s, sigma_r, downsample, ph );
-#else
-    bilateralFilter( &I, &BASE, sigma_s, sigma_r, ph );
+    case DURAND02_PIECEWISE_LINEAR:
+        fastBilateralFilter( I, BASE, sigma_s, sigma_r, downsample, ph );
+        break;
 #endif
+    default:
+        gridBilateralFilter( I, BASE, sigma_s, sigma_r, ph );
+        break;
+    }
+
+    if ( ph.canceled() )
+    {
+        return;
+    }
 
     //!! FIX: find minimum and maximum luminance, but skip 1% of outliers
     float maxB;
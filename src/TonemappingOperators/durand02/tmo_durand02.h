@@ -35,13 +35,26 @@
 #ifndef TMO_DURAND02_H
 #define TMO_DURAND02_H
 
+#include <cstddef>
 #include <Libpfs/array2d_fwd.h>
 
 namespace pfs
 {
+class BufferArena;
 class Progress;
 }
 
+//! \brief Implementations of the bilateral filter that computes the base layer
+enum Durand02Filter
+{
+    //! conventional algorithm, O(N*sigma_s^2)
+    DURAND02_BRUTE_FORCE = 0,
+    //! piecewise linear approximation, based on FFTW
+    DURAND02_PIECEWISE_LINEAR,
+    //! bilateral grid, linear in the number of pixels
+    DURAND02_BILATERAL_GRID
+};
+
 //!
 //! \brief Fast bilateral filtering
 //!
@@ -55,11 +68,16 @@ class Progress;
 //! \param baseContrast contrast of the base layer
 //! \param color_correction enable automatic color correction
 //! \param downsample down sampling factor for speeding up fast-bilateral (1..20)
+//! \param filter implementation of the bilateral filter. The piecewise
+//! linear one falls back to the bilateral grid when FFTW is not available.
+//! \param arena arena supplying the temporaries (NULL: regular allocations)
 //!
 void tmo_durand02(pfs::Array2Df& R, pfs::Array2Df& G, pfs::Array2Df& B,
                   float sigma_s, float sigma_r, float baseContrast, int downsample,
                   bool color_correction /*= true*/,
-                  pfs::Progress &ph);
+                  pfs::Progress &ph,
+                  Durand02Filter filter = DURAND02_PIECEWISE_LINEAR,
+                  pfs::BufferArena* arena = NULL);
 
 
 #endif // TMO_DURAND02_H
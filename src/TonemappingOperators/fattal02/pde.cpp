@@ -7,8 +7,6 @@
  * @author Grzegorz Krawczyk, <krawczyk@mpi-sb.mpg.de>
  * @author Rafal Mantiuk, <mantiuk@mpi-sb.mpg.de>
  *
- * Some code from Numerical Recipes in C
- *
  *
  * This file is a part of LuminanceHDR package, based on pfstmo.
  * ----------------------------------------------------------------------
@@ -34,17 +32,15 @@
 
 #include "pde.h"
 
-#include <iostream>
+#include <algorithm>
 #include <cassert>
-#include <stdio.h>
-#include <stdlib.h>
-#include <math.h>
+#include <cmath>
+#include <vector>
 
 #include "Libpfs/progress.h"
 #include "Libpfs/utils/numeric.h"
-#include "Libpfs/utils/sse.h"
+#include "Libpfs/utils/dotproduct.h"
 #include "Libpfs/array2d.h"
-#include "Libpfs/manip/copy.h"
 
 #include "TonemappingOperators/pfstmo.h"
 
@@ -53,592 +49,483 @@ using namespace std;
 //////////////////////////////////////////////////////////////////////
 
 // tune the multi-level solver
-#define MODYF 0 /* 1 or 0 (1 is better) */
-#define MINS 16 /* minimum size 4 6 or 100 */
-//#define MODYF_SQRT -1.0f /* -1 or 0 */
-#define SMOOTH_IT 1              // orig: 1
-#define BCG_STEPS 20             // orig: 20
-#define BCG_TOL 1e-3             // orig: 1e-3
-#define V_CYCLE 2                // orig: 2
-// post improvement of the solution using additional cg-iterations
-#define BCG_POST_IMPROVE false
-#define BCG_POST_STEPS 1000      // very slow if > 100, only use on small image
-#define BCG_POST_TOL 1e-7
-
-
-// precision
-#define EPS 1.0e-12
+#define COARSEST_SIZE 64    // levels up to this number of samples are solved by relaxation
+#define COARSEST_TOL 1e-4   // relative residual of the solution of the coarsest level
+
+// levels smaller than this are processed by a single thread
+#define OMP_THRESHOLD 32768
+
+MultigridParams::MultigridParams()
+    : cycle(MULTIGRID_V_CYCLE)
+    , preSmoothing(2)
+    , postSmoothing(2)
+    // best smoothing factor of red-black SOR on the 5 points Laplacian
+    // (Yavneh, 1996)
+    , omega(1.15f)
+    , tolerance(1e-4f)
+    , maxCycles(30)
+{}
 
-#define OMP_THRESHOLD 1000000
-
-static void linbcg(unsigned long n, const float b[], float x[], float tol,
-  int itmax, int *iter, float *err, int rows, int cols);
+//////////////////////////////////////////////////////////////////////
+// Multigrid solver of the Poisson equation
+//
+// The fine level is the 5 points Laplacian with reflected boundaries,
+// (A u)(p) = sum over the neighbours q of p of u(q) - u(p).
+// The coarse levels are finite volume discretisations of the same equation:
+// a coarse sample is the union of up to 2x2 samples of the level below, its
+// right hand side is the sum of their residuals, and the coupling of two
+// adjacent samples is the length of their interface over the distance of
+// their centers. It is 1 inside every level, and only differs on the last
+// row and column when the size of a level is odd.
+//////////////////////////////////////////////////////////////////////
 
-inline float max( float a, float b )
+namespace
 {
-  return a > b ? a : b;
-}
-
-inline float min( float a, float b )
+inline int coarser(int size)
 {
-  return a < b ? a : b;
+    return (size + 1)/2;
 }
 
-//!! TODO: for debugging purposes
-// #define PFSEOL "\x0a"
-// static void dumpPFS( const char *fileName, const pfs::Array2D *data, const char *channelName )
-// {
-//   FILE *fh = fopen( fileName, "wb" );
-//   assert( fh != NULL );
-
-//   int width = data->getCols();
-//   int height = data->getRows();
+// sizes of the columns and rows of a level, in samples of the finest level,
+// and couplings of adjacent columns and rows per unit of interface
+struct Geometry
+{
+    explicit Geometry(int cols, int rows)
+        : widths(cols, 1.f)
+        , heights(rows, 1.f)
+    {
+        update();
+    }
 
-//   fprintf( fh, "PFS1" PFSEOL "%d %d" PFSEOL "1" PFSEOL "0" PFSEOL
-//     "%s" PFSEOL "0" PFSEOL "ENDH", width, height, channelName );
+    // geometry of the next coarser level
+    Geometry coarser() const
+    {
+        Geometry next(::coarser(widths.size()), ::coarser(heights.size()));
+        merge(widths, next.widths);
+        merge(heights, next.heights);
+        next.update();
+        return next;
+    }
 
-//   for( int y = 0; y < height; y++ )
-//     for( int x = 0; x < width; x++ ) {
-//       fwrite( &((*data)(x,y)), sizeof( float ), 1, fh );
-//     }
+    std::vector<float> widths;
+    std::vector<float> heights;
+    std::vector<float> gx;          // between the columns i and i+1
+    std::vector<float> gy;          // between the rows j and j+1
+    bool uniform;                   // couplings inside the level are 1
 
-//   fclose( fh );
-// }
+private:
+    static void merge(const std::vector<float>& in, std::vector<float>& out)
+    {
+        for ( size_t i = 0; i < out.size(); i++ )
+        {
+            out[i] = in[2*i] + ((2*i + 1 < in.size()) ? in[2*i + 1] : 0.f);
+        }
+    }
 
-//////////////////////////////////////////////////////////////////////
-// Full Multigrid Algorithm for solving partial differential equations
-//////////////////////////////////////////////////////////////////////
+    void update()
+    {
+        gx.resize(widths.size());
+        gy.resize(heights.size());
+        for ( size_t i = 0; i + 1 < widths.size(); i++ )
+            gx[i] = 2.f/(widths[i] + widths[i+1]);
+        for ( size_t j = 0; j + 1 < heights.size(); j++ )
+            gy[j] = 2.f/(heights[j] + heights[j+1]);
+
+        // only the last row and column can be smaller than the others
+        uniform = (widths.front() == heights.front());
+    }
+};
 
-static void restrict( const pfs::Array2Df *in, pfs::Array2Df *out )
+// neighbours of the sample x of a row, weighted by their coupling
+inline void neighbours(const Geometry& g, const float* row, const float* up,
+                       const float* down, int x, int y, int cols,
+                       float& sum, float& weight)
 {
-    const float inRows = in->getRows();
-    const float inCols = in->getCols();
-
-    const int outRows = out->getRows();
-    const int outCols = out->getCols();
+    sum = weight = 0.f;
 
-    const float dx = (float)in->getCols() / (float)out->getCols();
-    const float dy = (float)in->getRows() / (float)out->getRows();
-
-    const float filterSize = 0.5;
-
-    float sx, sy;
-    int x, y;
+    const float h = g.heights[y];
+    if ( x > 0 )
+    {
+        const float c = h*g.gx[x-1];
+        sum += c*row[x-1];
+        weight += c;
+    }
+    if ( x+1 < cols )
+    {
+        const float c = h*g.gx[x];
+        sum += c*row[x+1];
+        weight += c;
+    }
 
-    for( y = 0, sy = dy/2-0.5; y < outRows; y++, sy += dy )
+    const float w = g.widths[x];
+    if ( up )
     {
-        for( x = 0, sx = dx/2-0.5; x < outCols; x++, sx += dx ) {
-
-            float pixVal = 0;
-            float w = 0;
-            for( float ix = max( 0, ceilf( sx-dx*filterSize ) ); ix <= min( floorf( sx+dx*filterSize ), inCols-1 ); ix++ )
-                for( float iy = max( 0, ceilf( sy-dx*filterSize ) ); iy <= min( floorf( sy+dx*filterSize), inRows-1 ); iy++ ) {
-                pixVal += (*in)( (int)ix, (int)iy );
-                w += 1;
-            }
-            (*out)(x,y) = pixVal/w;
-        }
+        const float c = w*g.gy[y-1];
+        sum += c*up[x];
+        weight += c;
+    }
+    if ( down )
+    {
+        const float c = w*g.gy[y];
+        sum += c*down[x];
+        weight += c;
     }
 }
 
-// from_level>to_level, from_size>to_size
-// void restrict( pfs::Array2D *F, pfs::Array2D *T )
-// {
-// //   DEBUG_STR << "restrict" << endl;
-
-//   int sxt = T->getCols();
-//   int syt = T->getRows();
-//   int sxf = F->getCols();
-//   int syf = F->getRows();
-//   int x,y;
-
-//   float w[] = {.25, .5, .25};
-//   for( int x=0 ; x<sxt ; x++ )
-//     for( int y=0 ; y<syt ; y++ )
-//     {
-//       float sum=0.0; float norm=0.0f;
-//       for( int m=-1 ; m<=1 ; m++ )
-//     for( int n=-1 ; n<=1 ; n++ )
-//         {
-//           int xf = 2*x+m;
-//           int yf = 2*y+n;
-//           if( xf>=0 && yf>=0 && xf<sxf && yf<syf )
-//           {
-//             sum += w[1+m]*w[1+n] * (*F)(xf,yf);
-//             norm += w[1+m]*w[1+n];
-//           }
-//         }
-//       assert(norm!=0.0f);
-//       (*T)(x,y)=sum/norm;
-//     }
-// }
-
-
-static void prolongate( const pfs::Array2Df *in, pfs::Array2Df *out )
+// red-black SOR sweep of A u = f: the samples of a color only depend on the
+// samples of the other color, so that the rows are relaxed in parallel
+void relax(const Geometry& g, pfs::Array2Df& U, const pfs::Array2Df& F, float omega)
 {
-  float dx = (float)in->getCols() / (float)out->getCols();
-  float dy = (float)in->getRows() / (float)out->getRows();
+    const int cols = U.getCols();
+    const int rows = U.getRows();
+    float* u = U.data();
+    const float* f = F.data();
 
-  const int outRows = out->getRows();
-  const int outCols = out->getCols();
+    const float keep = 1.f - omega;
+    const float weight = 0.25f*omega;
 
-  const float inRows = in->getRows();
-  const float inCols = in->getCols();
-
-  const float filterSize = 1;
+    for ( int color = 0; color < 2; color++ )
+    {
+#pragma omp parallel for if (cols*rows > OMP_THRESHOLD) schedule(static)
+        for ( int y = 0; y < rows; y++ )
+        {
+            float* row = u + y*cols;
+            const float* up = (y > 0) ? row - cols : NULL;
+            const float* down = (y+1 < rows) ? row + cols : NULL;
+            const float* frow = f + y*cols;
 
-  float sx, sy;
-  int x, y;
-  for( y = 0, sy = -dy/2; y < outRows; y++, sy += dy )
-    for( x = 0, sx = -dx/2; x < outCols; x++, sx += dx ) {
+            // the couplings are 1 away from the last two rows and columns
+            const int end = (g.uniform && y > 0 && y+2 < rows) ? cols-2 : 0;
 
-      float pixVal = 0;
-      float weight = 0;
+            int x = (y + color) % 2;
+            if ( x == 0 && end > 0 )
+            {
+                float sum, total;
+                neighbours(g, row, up, down, 0, y, cols, sum, total);
+                row[0] += omega*((sum - frow[0])/total - row[0]);
+                x = 2;
+            }
+            for ( ; x < end; x += 2 )
+            {
+                row[x] = keep*row[x] +
+                        weight*(row[x-1] + row[x+1] + up[x] + down[x] - frow[x]);
+            }
+            for ( ; x < cols; x += 2 )
+            {
+                float sum, total;
+                neighbours(g, row, up, down, x, y, cols, sum, total);
+                // a level of a single sample has no equation
+                if ( total > 0.f )
+                {
+                    row[x] += omega*((sum - frow[x])/total - row[x]);
+                }
+            }
+        }
+    }
+}
 
-      for( float ix = max( 0, ceilf( sx-filterSize ) ); ix <= min( floorf(sx+filterSize), inCols-1 ); ix++ )
-        for( float iy = max( 0, ceilf( sy-filterSize ) ); iy <= min( floorf( sy+filterSize), inRows-1 ); iy++ ) {
-          float fx = fabs( sx - ix );
-          float fy = fabs( sy - iy );
+// R = F - A U
+void calculate_defect(const Geometry& g, pfs::Array2Df& R,
+                      const pfs::Array2Df& U, const pfs::Array2Df& F)
+{
+    const int cols = U.getCols();
+    const int rows = U.getRows();
+    const float* u = U.data();
+    const float* f = F.data();
+    float* r = R.data();
+
+#pragma omp parallel for if (cols*rows > OMP_THRESHOLD) schedule(static)
+    for ( int y = 0; y < rows; y++ )
+    {
+        const float* row = u + y*cols;
+        const float* up = (y > 0) ? row - cols : NULL;
+        const float* down = (y+1 < rows) ? row + cols : NULL;
+        const float* frow = f + y*cols;
+        float* rrow = r + y*cols;
 
-          const float fval = (1-fx)*(1-fy);
+        const int end = (g.uniform && y > 0 && y+2 < rows) ? cols-2 : 0;
 
-          pixVal += (*in)( (int)ix, (int)iy ) * fval;
-          weight += fval;
+        int x = 0;
+        if ( end > 0 )
+        {
+            float sum, total;
+            neighbours(g, row, up, down, 0, y, cols, sum, total);
+            rrow[0] = frow[0] - (sum - total*row[0]);
+            x = 1;
+        }
+        for ( ; x < end; x++ )
+        {
+            rrow[x] = frow[x] - (row[x-1] + row[x+1] + up[x] + down[x] - 4.f*row[x]);
+        }
+        for ( ; x < cols; x++ )
+        {
+            float sum, total;
+            neighbours(g, row, up, down, x, y, cols, sum, total);
+            rrow[x] = frow[x] - (sum - total*row[x]);
         }
+    }
+}
 
-      assert( weight != 0 );
-      (*out)(x,y) = pixVal / weight;
+float mean(const pfs::Array2Df& A)
+{
+    const int size = A.size();
+    const float* a = A.data();
 
+    double sum = 0.0;
+#pragma omp parallel for reduction(+:sum) if (size > OMP_THRESHOLD) schedule(static)
+    for ( int i = 0; i < size; i++ )
+    {
+        sum += a[i];
     }
+    return static_cast<float>(sum / size);
 }
 
-static void exact_sollution( pfs::Array2Df */*F*/, pfs::Array2Df *U )
+// removes the mean of \a A, i.e. the component in the kernel of the operator
+void remove_mean(pfs::Array2Df& A)
 {
-//   DEBUG_STR << "exact sollution" << endl;
-
-/*  int sx = F->getCols();
-  int sy = F->getRows();
-  int x,y;
-
-  float h = 1.0/sqrt(sx*sy*1.0f);
-  float h2 = h*h;
-*/
-    U->reset();
-
-    /* also works well?? */
-    return;
-
-//   if( sx==3 && sy==3 )
-//   {
-//     (*U)(1,1) = -h2* (*F)(1,1) / 4.0f;
-
-//     // boundary points
-//     for( x=0 ; x<sx ; x++ )
-//       (*U)(x,0) = (*U)(x,sy-1) = 0.0f;
-//     for( y=0 ; y<sy ; y++ )
-//       (*U)(0,y) = (*U)(sx-1,y) = 0.0f;
-//   }
-//   else
-//   {
-//     U.fill(0.0f); return;   /* also works well?? */
-
-//     // TODO: this produces incorrect results
-// //     solve_pde_sor(F,U);
-// //     for( y=0 ; y<sy ; y++ )
-// //       for( x=0 ; x<sx ; x++ )
-// //         (*U)(x,y) *= h2;
-//   }
+    pfs::utils::vsadd(A.data(), -mean(A), A.data(), A.size());
 }
 
-//static int rows, cols;
-
-// smooth u using f at level
-static void smooth( pfs::Array2Df *U, const pfs::Array2Df *F )
+// right hand side of the coarse level: sum of the fine residuals it covers
+void restrict(const pfs::Array2Df& in, pfs::Array2Df& out)
 {
-//   DEBUG_STR << "smooth" << endl;
-
-  int rows = U->getRows();
-  int cols = U->getCols();
-
-  const int n = rows*cols;
-
-  int iter;
-  float err;
-
-  linbcg( n, F->data(), U->data(), BCG_TOL, BCG_STEPS, &iter, &err, rows, cols);
+    const int inCols = in.getCols();
+    const int inRows = in.getRows();
+    const int outCols = out.getCols();
+    const int outRows = out.getRows();
 
-//   fprintf( stderr, "." );
-
-  // Gauss relaxation is too slow
-
-//   int sx = F->getCols();
-//   int sy = F->getRows();
-//   int x,y,i;
-//   int shx;    shift x
-
-//   float h = 1.0f/sqrt(sx*sy*1.0f);
-//   float h2 = h*h;
-
-//   h2 = 1;
-
-//   for( int pass=0 ; pass<2 ; pass++ )
-//   {
-//     shx=pass;
-//     for( y=0; y<sy ; y++ )
-//     {
-//       shx= (y+pass)%2;
-//       for( x=shx ; x<sx ; x+=2 )
-//       {
-//         int w, n, e, s;
-//         w = (x == 0 ? 0 : x-1);
-//         n = (y == 0 ? 0 : y-1);
-//         s = (y+1 == sy ? y : y+1);
-//         e = (x+1 == sx ? x : x+1);
+#pragma omp parallel for if (inCols*inRows > OMP_THRESHOLD) schedule(static)
+    for ( int y = 0; y < outRows; y++ )
+    {
+        const int y1 = std::min(2*y + 1, inRows - 1);
+        for ( int x = 0; x < outCols; x++ )
+        {
+            const int x1 = std::min(2*x + 1, inCols - 1);
 
-//     (*U)(x,y) = .25 * ( (*U)(e,y) + (*U)(w,y) + (*U)(x,s) + (*U)(x,n)
-//           - h2 * (*F)(x,y) );
-//       }
-//     }
-//   }
+            float sum = 0.f;
+            for ( int iy = 2*y; iy <= y1; iy++ )
+                for ( int ix = 2*x; ix <= x1; ix++ )
+                    sum += in(ix, iy);
+            out(x, y) = sum;
+        }
+    }
 }
 
-static void calculate_defect( pfs::Array2Df *D, const pfs::Array2Df *U, const pfs::Array2Df *F )
+// linear interpolation between the centers of the coarse samples: indices
+// and weight of the first of the two coarse samples around every fine sample
+struct Interpolation
 {
-//   DEBUG_STR << "calculate defect" << endl;
-
-  int sx = F->getCols();
-  int sy = F->getRows();
+    Interpolation(const std::vector<float>& fine, const std::vector<float>& coarse)
+        : first(fine.size()), second(fine.size()), weight(fine.size(), 1.f)
+    {
+        const std::vector<float> fineCenters = centers(fine);
+        const std::vector<float> coarseCenters = centers(coarse);
 
-  // float h = 1.0f/sqrt(sx*sy*1.0f);
-  // float h2i = 1.0/(h*h);
+        for ( size_t i = 0; i < fine.size(); i++ )
+        {
+            // a line of a single sample is not coarsened
+            const int p = (fine.size() == coarse.size()) ? i : i/2;
+            const float d = fineCenters[i] - coarseCenters[p];
+            const int n = (d > 0.f) ? p + 1 : p - 1;
 
-  // h2i = 1;
+            first[i] = second[i] = p;
+            if ( d != 0.f && n >= 0 && n < static_cast<int>(coarse.size()) )
+            {
+                second[i] = n;
+                weight[i] = 1.f - std::fabs(d/(coarseCenters[n] - coarseCenters[p]));
+            }
+        }
+    }
 
-  for( int y=0 ; y<sy ; y++ )
-    for( int x=0 ; x<sx ; x++ ) {
-        int w, n, e, s;
-        w = (x == 0 ? 0 : x-1);
-        n = (y == 0 ? 0 : y-1);
-        s = (y+1 == sy ? y : y+1);
-        e = (x+1 == sx ? x : x+1);
+    std::vector<int> first;
+    std::vector<int> second;
+    std::vector<float> weight;
 
-        (*D)(x,y) = (*F)(x,y) -( (*U)(e,y) + (*U)(w,y) + (*U)(x,n) + (*U)(x,s)
-          - 4.0 * (*U)(x,y) );
+private:
+    static std::vector<float> centers(const std::vector<float>& sizes)
+    {
+        std::vector<float> result(sizes.size());
+        float position = 0.f;
+        for ( size_t i = 0; i < sizes.size(); i++ )
+        {
+            result[i] = position + 0.5f*sizes[i];
+            position += sizes[i];
+        }
+        return result;
     }
+};
 
-}
-
-static void add_correction( pfs::Array2Df *U, const pfs::Array2Df *C )
+// U += interpolation of the coarse correction C
+void add_correction(const Geometry& fine, const Geometry& coarse,
+                    pfs::Array2Df& U, const pfs::Array2Df& C)
 {
-//   DEBUG_STR << "add_correction" << endl;
+    const int cols = U.getCols();
+    const int rows = U.getRows();
 
-  int sx = C->getCols();
-  int sy = C->getRows();
+    const Interpolation ix(fine.widths, coarse.widths);
+    const Interpolation iy(fine.heights, coarse.heights);
 
-  for( int i=0 ; i<sx*sy ; i++ )
-    (*U)(i) += (*C)(i);
-}
-
-void solve_pde_multigrid( pfs::Array2Df *F, pfs::Array2Df *U, pfs::Progress &ph)
-{
-  int xmax = F->getCols();
-  int ymax = F->getRows();
-
-  int i;    // index for simple loops
-  int k;    // index for iterating through levels
-  int k2;    // index for iterating through levels in V-cycles
-
-  // 1. restrict f to coarse-grid (by the way count the number of levels)
-  //      k=0: fine-grid = f
-  //      k=levels: coarsest-grid
-  int levels = 0;
-  int mins = (xmax<ymax) ? xmax : ymax;
-  while( mins>=MINS )
-  {
-    levels++;
-    mins = mins/2+MODYF;
-  }
-
-  // given function f restricted on levels
-  pfs::Array2Df** RHS = new pfs::Array2Df*[levels+1];
-
-  // approximate initial sollutions on levels
-  pfs::Array2Df** IU = new pfs::Array2Df*[levels+1];
-  // target functions in cycles (approximate sollution error (uh - ~uh) )
-  pfs::Array2Df** VF = new pfs::Array2Df*[levels+1];
-
-  VF[0] = new pfs::Array2Df(xmax,ymax);
-  RHS[0] = F;
-  IU[0] = new pfs::Array2Df(xmax,ymax);
-  pfs::copy( U, IU[0] );
-
-  int sx=xmax;
-  int sy=ymax;
-  for( k=0 ; k<levels ; k++ )
-  {
-    // calculate size of next level
-    sx=sx/2+MODYF;
-    sy=sy/2+MODYF;
-
-    RHS[k+1] = new pfs::Array2Df(sx,sy);
-    IU[k+1] = new pfs::Array2Df(sx,sy);
-    VF[k+1] = new pfs::Array2Df(sx,sy);
-
-    // restrict from level k to level k+1 (coarser-grid)
-    restrict( RHS[k], RHS[k+1] );
-  }
-
-  // 2. find exact sollution at the coarsest-grid (k=levels)
-  exact_sollution( RHS[levels], IU[levels] );
-
-  // 3. nested iterations
-  for( k=levels-1; k>=0 ; k-- )
-  {
-    ph.setValue(20+70*(levels - k)/(levels+1));
-    // 4. interpolate sollution from last coarse-grid to finer-grid
-    // interpolate from level k+1 to level k (finer-grid)
-    prolongate( IU[k+1], IU[k] );
-
-    // 4.1. first target function is the equation target function
-    //      (following target functions are the defect)
-    pfs::copy( RHS[k], VF[k] );
-
-    // 5. V-cycle (twice repeated)
-    for( int cycle=0 ; cycle<V_CYCLE ; cycle++ )
+#pragma omp parallel for if (cols*rows > OMP_THRESHOLD) schedule(static)
+    for ( int y = 0; y < rows; y++ )
     {
-      // 6. downward stroke of V
-      for( k2=k ; k2<levels ; k2++ )
-      {
-        // 7. pre-smoothing of initial sollution using target function
-        //    zero for initial guess at smoothing
-        //    (except for level k when iu contains prolongated result)
-    if( k2!=k )
-        IU[k2]->reset();
-
-//        fprintf( stderr, "Level: %d --------\n", k2 );
-
-    for( i=0 ; i<SMOOTH_IT ; i++ )
-          smooth( IU[k2], VF[k2] );
-
-        // 8. calculate defect at level
-        //    d[k2] = Lh * ~u[k2] - f[k2]
-        pfs::Array2Df* D = new pfs::Array2Df(IU[k2]->getCols(), IU[k2]->getRows());
-    calculate_defect( D, IU[k2], VF[k2] );
-
-        // 9. restrict deffect as target function for next coarser-grid
-        //    def -> f[k2+1]
-    restrict( D, VF[k2+1] );
-    delete D;
-      }
-
-      // 10. solve on coarsest-grid (target function is the deffect)
-      //     iu[levels] should contain sollution for
-      //     the f[levels] - last deffect, iu will now be the correction
-      exact_sollution(VF[levels], IU[levels] );
-
-      // 11. upward stroke of V
-      for( k2=levels-1 ; k2>=k ; k2-- )
-      {
-        // 12. interpolate correction from last coarser-grid to finer-grid
-        //     iu[k2+1] -> cor
-        pfs::Array2Df* C = new pfs::Array2Df(IU[k2]->getCols(), IU[k2]->getRows());
-    prolongate( IU[k2+1], C );
-
-        // 13. add interpolated correction to initial sollution at level k2
-    add_correction( IU[k2], C );
-    delete C;
-
-//        fprintf( stderr, "Level: %d --------\n", k2 );
-
-        // 14. post-smoothing of current sollution using target function
-    for( i=0 ; i<SMOOTH_IT ; i++ )
-          smooth( IU[k2], VF[k2] );
-      }
-
-    } //--- end of V-cycle
-
-  } //--- end of nested iteration
-
-  // 15. final sollution
-  //     IU[0] contains the final sollution
-
-//   for( k=0 ; k<levels ; k++ ) {
-//     char name[200];
-//     sprintf( name, "u_%d.pfs", k );
-//     dumpPFS( name, IU[k], "Y" );
-//     sprintf( name, "rh_%d.pfs", k );
-//     dumpPFS( name, RHS[k], "Y" );
-//     sprintf( name, "v_%d.pfs", k );
-//     dumpPFS( name, VF[k], "Y" );
-//   }
-
-  pfs::copy( IU[0], U );
-
-  // further improvement of the solution
-  if(BCG_POST_IMPROVE) {
-    int iter;
-    float err;
-    //DEBUG_STR << "FMG: cg post improving ..., maxiter=" << BCG_POST_STEPS;
-    //DEBUG_STR << ", tol=" << BCG_POST_TOL << std::endl;
-    linbcg( xmax*ymax, F->data(), U->data(),
-               BCG_POST_TOL, BCG_POST_STEPS, &iter, &err,ymax,xmax);
-    //DEBUG_STR << "FMG: cg post improvement: iter=" << iter << ", err=" << err;
-    //DEBUG_STR << std::endl;
-  }
+        const float* c0 = C.data() + iy.first[y]*C.getCols();
+        const float* c1 = C.data() + iy.second[y]*C.getCols();
+        const float wy = iy.weight[y];
+        float* u = U.data() + y*cols;
 
+        for ( int x = 0; x < cols; x++ )
+        {
+            const int x0 = ix.first[x];
+            const int x1 = ix.second[x];
+            const float wx = ix.weight[x];
 
-  ph.setValue(90);
-
-  delete VF[0];
-  delete IU[0];
-
-  for( k=1 ; k<=levels ; k++ ) {
-    delete RHS[k];
-    delete IU[k];
-    delete VF[k];
-  }
-
-  delete[] RHS;
-  delete[] IU;
-  delete[] VF;
-
+            u[x] += wy*(wx*c0[x0] + (1.f - wx)*c0[x1]) +
+                    (1.f - wy)*(wx*c1[x0] + (1.f - wx)*c1[x1]);
+        }
+    }
 }
 
-
-//#define EPS 1.0e-14
-
-static void asolve(const float b[], float x[], int rows, int cols)
+class MultigridSolver
 {
-  for( int j = 0; j < rows*cols; j++)
-    x[j] = -4 * b[j];
-}
+public:
+    MultigridSolver(int cols, int rows, pfs::BufferArena* arena,
+                    const MultigridParams& params)
+        : m_params(params)
+    {
+        m_geometry.push_back(Geometry(cols, rows));
+        while ( cols*rows > COARSEST_SIZE )
+        {
+            m_geometry.push_back(m_geometry.back().coarser());
+            cols = m_geometry.back().widths.size();
+            rows = m_geometry.back().heights.size();
+        }
 
-#define idx(R,C) ((R)*cols+(C))
+        // the levels are never copied once the capacity is reserved; the
+        // first level solves for U itself
+        const size_t levels = m_geometry.size();
+        m_U.reserve(levels);
+        m_F.reserve(levels);
+        m_R.reserve(levels);
+        for ( size_t l = 0; l < levels; l++ )
+        {
+            cols = m_geometry[l].widths.size();
+            rows = m_geometry[l].heights.size();
 
-static void atimes(const float x[], float res[], int rows, int cols)
-{
-#pragma omp parallel for shared(x, res) if (rows*cols>OMP_THRESHOLD) schedule(static)
-  for( int r = 1; r < rows-1; r++ )
-    for( int c = 1; c < cols-1; c++ ) {
-      res[idx(r,c)] = x[idx(r-1,c)] + x[idx(r+1,c)] +
-        x[idx(r,c-1)] + x[idx(r,c+1)] - 4*x[idx(r,c)];
+            m_U.emplace_back(l == 0 ? 0 : cols, l == 0 ? 0 : rows, arena);
+            m_F.emplace_back(cols, rows, arena, false);
+            m_R.emplace_back(cols, rows, arena, false);
+        }
     }
 
-  for( int r = 1; r < rows-1; r++ ) {
-    res[idx(r,0)] = x[idx(r-1,0)] + x[idx(r+1,0)] +
-        x[idx(r,1)] - 3*x[idx(r,0)];
-    res[idx(r,cols-1)] = x[idx(r-1,cols-1)] + x[idx(r+1,cols-1)] +
-        x[idx(r,cols-2)] - 3*x[idx(r,cols-1)];
-  }
-
-  for( int c = 1; c < cols-1; c++ ) {
-    res[idx(0,c)] = x[idx(1,c)] +
-        x[idx(0,c-1)] + x[idx(0,c+1)] - 3*x[idx(0,c)];
-    res[idx(rows-1,c)] = x[idx(rows-2,c)] +
-        x[idx(rows-1,c-1)] + x[idx(rows-1,c+1)] - 3*x[idx(rows-1,c)];
-  }
-  res[idx(0,0)] = x[idx(1,0)] + x[idx(0,1)] - 2*x[idx(0,0)];
-  res[idx(rows-1,0)] = x[idx(rows-2,0)] + x[idx(rows-1,1)] - 2*x[idx(rows-1,0)];
-  res[idx(0,cols-1)] = x[idx(1,cols-1)] + x[idx(0,cols-2)] - 2*x[idx(0,cols-1)];
-  res[idx(rows-1,cols-1)] = x[idx(rows-2,cols-1)] + x[idx(rows-1,cols-2)]
-    - 2*x[idx(rows-1,cols-1)];
-}
+    //! \\return relative norm of the residual
+    float solve(const pfs::Array2Df& F, pfs::Array2Df& U, pfs::Progress& ph)
+    {
+        // the mean of F has no solution
+        std::copy(F.begin(), F.end(), m_F[0].begin());
+        remove_mean(m_F[0]);
 
-#undef idx
+        const float normF = std::sqrt(pfs::utils::dotProduct(m_F[0].data(), m_F[0].size()));
+        if ( normF == 0.f )
+        {
+            U.reset();
+            return 0.f;
+        }
 
-static float snrm(unsigned long n, const float sx[])
-{
-    float ans = 0.0f;
+        float error = residualNorm(U) / normF;
+        for ( int cycle = 0; cycle < m_params.maxCycles && error > m_params.tolerance; cycle++ )
+        {
+            this->cycle(0, U, m_params.cycle);
+            error = residualNorm(U) / normF;
 
-#pragma omp parallel for shared(sx) reduction(+:ans) if (n>OMP_THRESHOLD) schedule(static)
-    for (long i=0; i<static_cast<long>(n); i++)
-    {
-        ans += sx[i]*sx[i];
+            ph.setValue(20 + 70*(cycle+1)/m_params.maxCycles);
+            if ( ph.canceled() ) break;
+        }
+        return error;
     }
-    return sqrt(ans);
-}
 
-/**
- * Biconjugate Gradient Method
- * from Numerical Recipes in C
- */
-static void linbcg(unsigned long n, const float b[], float x[], float tol, int itmax, int *iter, float *err, int rows, int cols)
-{
-    float ak,akden,bk,bkden=1.0,bknum,bnrm=1.0;//zm1nrm,znrm;
-    float *p,*pp,*r,*rr,*z,*zz;
-
-    p=new float[n+1];
-    pp=new float[n+1];
-    r=new float[n+1];
-    rr=new float[n+1];
-    z=new float[n+1];
-    zz=new float[n+1];
-
-    *iter=0;
-    atimes(x,r, rows, cols);
-    for (unsigned long j=0;j<n;j++)
+private:
+    float residualNorm(const pfs::Array2Df& U)
     {
-        r[j]=b[j]-r[j];
+        calculate_defect(m_geometry[0], m_R[0], U, m_F[0]);
+        return std::sqrt(pfs::utils::dotProduct(m_R[0].data(), m_R[0].size()));
     }
-    for (unsigned long j=0;j<n;j++)
+
+    void cycle(size_t level, pfs::Array2Df& U, MultigridCycle type)
     {
-        rr[j]=r[j];
-    }
-    atimes(r,rr, rows, cols);       // minimum residual
-    //znrm=1.0;
-    bnrm=snrm(n,b);
-    asolve(r,z, rows, cols);
-
-    while (*iter <= itmax) {
-        ++(*iter);
-        //zm1nrm=znrm;
-        asolve(rr,zz, rows, cols);
-        bknum=0.0;
-#pragma omp parallel for shared(z, rr) reduction(+:bknum) if (n>OMP_THRESHOLD) schedule(static)
-        for (long j=0;j<static_cast<long>(n);j++)
+        const Geometry& g = m_geometry[level];
+        const pfs::Array2Df& F = m_F[level];
+        if ( level + 1 == m_geometry.size() )
         {
-            bknum += z[j]*rr[j];
-        }
-        if (*iter == 1) {
-            for (long j=0;j<static_cast<long>(n);j++)
-            {
-                p[j]=z[j];
-            }
-            for (long j=0;j<static_cast<long>(n);j++)
-            {
-                pp[j]=zz[j];
-            }
+            solveCoarsest(g, U, F);
+            return;
         }
-        else {
-            bk=bknum/bkden;
-            pfs::utils::vadds(z, bk, p, p, n);
-            pfs::utils::vadds(zz, bk, pp, pp, n);
+
+        for ( int i = 0; i < m_params.preSmoothing; i++ )
+            relax(g, U, F, m_params.omega);
+
+        // the coarse level solves for the correction of the error
+        calculate_defect(g, m_R[level], U, F);
+        restrict(m_R[level], m_F[level+1]);
+
+        pfs::Array2Df& C = m_U[level+1];
+        C.reset();
+        switch ( type )
+        {
+        case MULTIGRID_W_CYCLE:
+            cycle(level+1, C, MULTIGRID_W_CYCLE);
+            cycle(level+1, C, MULTIGRID_W_CYCLE);
+            break;
+        case MULTIGRID_F_CYCLE:
+            cycle(level+1, C, MULTIGRID_F_CYCLE);
+            cycle(level+1, C, MULTIGRID_V_CYCLE);
+            break;
+        case MULTIGRID_V_CYCLE:
+        default:
+            cycle(level+1, C, MULTIGRID_V_CYCLE);
+            break;
         }
-        bkden=bknum;
-        atimes(p,z,rows,cols);
-        akden=0.0;
-#pragma omp parallel for shared(z, pp) reduction(+:akden) if (n>OMP_THRESHOLD) schedule(static)
-        for (long j=0;j<static_cast<long>(n);j++)
+        add_correction(g, m_geometry[level+1], U, C);
+
+        for ( int i = 0; i < m_params.postSmoothing; i++ )
+            relax(g, U, F, m_params.omega);
+    }
+
+    // relaxation until convergence: the coarsest level has a few samples
+    void solveCoarsest(const Geometry& g, pfs::Array2Df& U, const pfs::Array2Df& F)
+    {
+        pfs::Array2Df& R = m_R.back();
+        const float normF = pfs::utils::dotProduct(F.data(), F.size());
+        const int size = U.getCols() + U.getRows();
+
+        for ( int i = 0; i < 4*size*size; i += 8 )
         {
-            akden += z[j]*pp[j];
+            for ( int j = 0; j < 8; j++ )
+                relax(g, U, F, m_params.omega);
+
+            calculate_defect(g, R, U, F);
+            if ( pfs::utils::dotProduct(R.data(), R.size()) <= COARSEST_TOL*COARSEST_TOL*normF )
+                break;
         }
-        ak=bknum/akden;
-        atimes(pp,zz,rows,cols);
-        pfs::utils::vadds(x, ak, p, x, n);
-        pfs::utils::vsubs(r, ak, z, r, n);
-        pfs::utils::vsubs(rr, ak, zz, rr, n);
-        asolve(r,z, rows, cols);
-        //znrm = 1.0f;
-        *err = snrm(n,r)/bnrm;
-//        fprintf( stderr, "iter=%4d err=%12.6f\n",*iter,*err);
-    if (*err <= tol) break;
+        remove_mean(U);
     }
 
-    delete [] p;
-    delete [] pp;
-    delete [] r;
-    delete [] rr;
-    delete [] z;
-    delete [] zz;
+    const MultigridParams m_params;
+
+    std::vector<Geometry> m_geometry;
+    // level 0 of m_U is not used, being the solution itself
+    std::vector<pfs::Array2Df> m_U;
+    std::vector<pfs::Array2Df> m_F;
+    std::vector<pfs::Array2Df> m_R;
+};
+}
+
+void solve_pde_multigrid(pfs::Array2Df *F, pfs::Array2Df *U, pfs::Progress &ph,
+                         pfs::BufferArena* arena, const MultigridParams& params)
+{
+  assert( F->getCols() == U->getCols() && F->getRows() == U->getRows() );
+
+  MultigridSolver solver(F->getCols(), F->getRows(), arena, params);
+  solver.solve(*F, *U, ph);
+
+  ph.setValue(90);
 }
-//#undef EPS
@@ -32,20 +32,64 @@
 #ifndef FMG_PDE_H
 #define FMG_PDE_H
 
+#include <cstddef>
 #include <Libpfs/array2d_fwd.h>
 
 namespace pfs
 {
+class BufferArena;
 class Progress;
 }
 
 /**
- * @brief solve pde using full multrigrid algorithm
+ * @brief recursion of the multigrid cycles
+ */
+enum MultigridCycle
+{
+    MULTIGRID_V_CYCLE = 0,  //!< one coarse grid correction per level
+    MULTIGRID_W_CYCLE = 1,  //!< two coarse grid corrections per level
+    MULTIGRID_F_CYCLE = 2   //!< an F-cycle followed by a V-cycle per level
+};
+
+/**
+ * @brief parameters of solve_pde_multigrid
+ */
+struct MultigridParams
+{
+    MultigridParams();
+
+    MultigridCycle cycle;
+    //! red-black relaxations before the coarse grid correction
+    int preSmoothing;
+    //! red-black relaxations after the coarse grid correction
+    int postSmoothing;
+    //! over-relaxation factor of the smoother (1: Gauss-Seidel)
+    float omega;
+    //! stops when norm(Laplace U - F) <= tolerance * norm(F)
+    float tolerance;
+    //! maximum number of cycles
+    int maxCycles;
+};
+
+/**
+ * @brief solve poisson pde (Laplace U = F) with Neumann boundaries using a
+ * multigrid algorithm with red-black SOR smoothing
+ *
+ * Any size is supported: every level halves the previous one, rounding up,
+ * down to a few samples that are solved by relaxation. The smoothing, the
+ * residuals and the transfers between levels run in parallel over the rows.
+ * The component of F that makes the problem singular (its mean) is ignored,
+ * and U is defined up to a constant.
  *
  * @param F array with divergence
- * @param U [out] sollution
+ * @param U [in] initial guess, [out] sollution
+ * @param arena arena supplying the levels (NULL: regular allocations): the
+ * storage is reused across calls on images of the same size
+ * @param params cycle, smoothing and stopping criterion
  */
-void solve_pde_multigrid(pfs::Array2Df *F, pfs::Array2Df *U, pfs::Progress &ph);
+void solve_pde_multigrid(pfs::Array2Df *F, pfs::Array2Df *U, pfs::Progress &ph,
+                         pfs::BufferArena* arena = NULL,
+                         const MultigridParams& params = MultigridParams());
 
 /**
  * @brief solve poisson pde (Laplace U = F) using discrete cosine transform
@@ -72,14 +72,12 @@
 #include <stdlib.h>
 #include "arch/math.h"
 #include <cassert>
-#ifdef _OPENMP
-#include <omp.h>
-#endif
 #include <vector>
 #include <fftw3.h>
 
 #include "Libpfs/progress.h"
 #include "Libpfs/array2d.h"
+#include "Libpfs/fftplancache.h"
 #include "pde.h"
 
 using namespace std;
@@ -125,11 +123,8 @@ void transform_ev2normal(pfs::Array2Df *A, pfs::Array2Df *T)
   // fftwf_free(in);
 
   // executes 2d discrete cosine transform
-  fftwf_plan p;
-  p=fftwf_plan_r2r_2d(height, width, A->data(), T->data(),
-                        FFTW_REDFT00, FFTW_REDFT00, FFTW_ESTIMATE);
-  fftwf_execute(p);
-  fftwf_destroy_plan(p);
+  pfs::FFTPlanCache::global().r2r(height, width, FFTW_REDFT00, FFTW_REDFT00,
+                                  A->data(), T->data());
 }
 
 
@@ -141,11 +136,8 @@ void transform_normal2ev(pfs::Array2Df *A, pfs::Array2Df *T)
   assert((int)T->getCols()==width && (int)T->getRows()==height);
 
   // executes 2d discrete cosine transform
-  fftwf_plan p;
-  p=fftwf_plan_r2r_2d(height, width, A->data(), T->data(),
-                        FFTW_REDFT00, FFTW_REDFT00, FFTW_ESTIMATE);
-  fftwf_execute(p);
-  fftwf_destroy_plan(p);
+  pfs::FFTPlanCache::global().r2r(height, width, FFTW_REDFT00, FFTW_REDFT00,
+                                  A->data(), T->data());
 
   // need to scale the output matrix to get the right transform
   for(int y=0 ; y<height ; y++ )
@@ -230,14 +222,6 @@ void solve_pde_fft(pfs::Array2Df *F, pfs::Array2Df *U, pfs::Progress &ph,
   int height = F->getRows();
   assert((int)U->getCols()==width && (int)U->getRows()==height);
 
-  // activate parallel execution of fft routines
-  fftwf_init_threads();
-#ifdef _OPENMP
-  fftwf_plan_with_nthreads( omp_get_max_threads() );
-#else
-  fftwf_plan_with_nthreads( 2 );
-#endif
-
   // in general there might not be a solution to the Poisson pde
   // with Neumann boundary conditions unless the boundary satisfies
   // an integral condition, this function modifies the boundary so that
@@ -304,9 +288,6 @@ void solve_pde_fft(pfs::Array2Df *F, pfs::Array2Df *U, pfs::Progress &ph,
     (*U)(i)-=max;
 
 
-  // fft parallel threads cleanup, better handled outside this function?
-  fftwf_cleanup_threads();
-
   ph.setValue(90);
   //DEBUG_STR << "solve_pde_fft: done" << std::endl;
 }
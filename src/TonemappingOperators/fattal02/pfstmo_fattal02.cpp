@@ -56,7 +56,8 @@ void pfstmo_fattal02(pfs::Frame& frame,
                      bool newfattal,
                      bool fftsolver,
                      int detail_level,
-                     pfs::Progress &ph)
+                     pfs::Progress &ph,
+                     pfs::BufferArena* arena)
 {
   if (fftsolver)
   {
@@ -94,15 +95,15 @@ void pfstmo_fattal02(pfs::Frame& frame,
   const int w = frame.getWidth();
   const int h = frame.getHeight();
 
-  pfs::Array2Df Yr(w,h);
-  pfs::Array2Df L(w,h);
+  pfs::Array2Df Yr(w,h,arena,false);
+  pfs::Array2Df L(w,h,arena,false);
 
   pfs::transformRGB2Y(R, G, B, &Yr);
 
   tmo_fattal02(w, h, Yr, L,
                opt_alpha, opt_beta, opt_noise, newfattal,
                fftsolver, detail_level,
-               ph);
+               ph, arena);
 
   if ( !ph.canceled() )
   {
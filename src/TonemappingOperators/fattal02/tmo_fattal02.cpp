@@ -41,8 +41,10 @@
 #include <assert.h>
 
 #include "Libpfs/array2d.h"
+#include "Libpfs/manip/pyramid.h"
 #include "Libpfs/progress.h"
 #include "Libpfs/utils/msec_timer.h"
+#include "Libpfs/utils/numeric.h"
 #include "TonemappingOperators/pfstmo.h"
 
 #include "pde.h"
@@ -76,98 +78,6 @@ using namespace utils;
 
 //--------------------------------------------------------------------
 
-void downSample(const pfs::Array2Df& A, pfs::Array2Df& B)
-{
-    const int width = B.getCols();
-    const int height = B.getRows();
-
-    // Note, I've uncommented all omp directives. They are all ok but are
-    // applied to too small problems and in total don't lead to noticable
-    // speed improvements. The main issue is the pde solver and in case of the
-    // fft solver uses optimised threaded fftw routines.
-    //#pragma omp parallel for
-    for ( int y=0 ; y<height ; y++ )
-    {
-        for ( int x=0 ; x<width ; x++ )
-        {
-            float p = A(2*x,2*y);
-            p += A(2*x+1,2*y);
-            p += A(2*x,2*y+1);
-            p += A(2*x+1,2*y+1);
-            B(x,y) = p * 0.25f; // p / 4.0f;
-        }
-    }
-}
-
-void gaussianBlur(const pfs::Array2Df& I, pfs::Array2Df& L)
-{
-    const int width = I.getCols();
-    const int height = I.getRows();
-
-    pfs::Array2Df T(width,height);
-
-    //--- X blur
-    //#pragma omp parallel for shared(I, T)
-    for ( int y=0 ; y<height ; y++ )
-    {
-        for ( int x=1 ; x<width-1 ; x++ )
-        {
-            float t = 2.f * I(x,y);
-            t += I(x-1,y);
-            t += I(x+1,y);
-            T(x,y) = t * 0.25f; // t / 4.f;
-        }
-        T(0,y) = ( 3.f * I(0,y)+ I(1,y) ) * 0.25f; // / 4.f;
-        T(width-1,y) = ( 3.f * I(width-1,y) + I(width-2,y) ) * 0.25f; // / 4.f;
-    }
-
-    //--- Y blur
-    //#pragma omp parallel for shared(T, L)
-    for ( int x=0 ; x<width ; x++ )
-    {
-        for ( int y=1 ; y<height-1 ; y++ )
-        {
-            float t = 2.f * T(x,y);
-            t += T(x,y-1);
-            t += T(x,y+1);
-            L(x,y) = t * 0.25f; // t/4.0f;
-        }
-        L(x,0) = ( 3.f * T(x,0) + T(x,1) ) * 0.25f; // / 4.0f;
-        L(x,height-1) = ( 3.f * T(x,height-1) + T(x,height-2) ) * 0.25f; // / 4.0f;
-    }
-}
-
-void createGaussianPyramids( pfs::Array2Df* H, pfs::Array2Df** pyramids, int nlevels)
-{
-  int width = H->getCols();
-  int height = H->getRows();
-  const int size = width*height;
-
-  pyramids[0] = new pfs::Array2Df(width,height);
-//#pragma omp parallel for shared(pyramids, H)
-  for( int i=0 ; i<size ; i++ )
-    (*pyramids[0])(i) = (*H)(i);
-
-  pfs::Array2Df* L = new pfs::Array2Df(width,height);
-  gaussianBlur( *pyramids[0], *L );
-
-  for ( int k=1 ; k<nlevels ; k++ )
-  {
-    width /= 2;
-    height /= 2;
-    pyramids[k] = new pfs::Array2Df(width,height);
-    downSample(*L, *pyramids[k]);
-
-    delete L;
-    L = new pfs::Array2Df(width,height);
-    gaussianBlur( *pyramids[k], *L );
-  }
-
-  delete L;
-}
-
-//--------------------------------------------------------------------
-
 float calculateGradients(pfs::Array2Df* H, pfs::Array2Df* G, int k)
 {
   const int width = H->getCols();
@@ -243,13 +153,14 @@ void upSample(const pfs::Array2Df& A, pfs::Array2Df& B)
 
 void calculateFiMatrix(pfs::Array2Df* FI, pfs::Array2Df* gradients[],
                        float avgGrad[], int nlevels, int detail_level,
-                       float alfa, float beta, float noise, bool newfattal)
+                       float alfa, float beta, float noise, bool newfattal,
+                       pfs::BufferArena* arena)
 {
     int width = gradients[nlevels-1]->getCols();
     int height = gradients[nlevels-1]->getRows();
     pfs::Array2Df** fi = new pfs::Array2Df*[nlevels];
 
-    fi[nlevels-1] = new pfs::Array2Df(width,height);
+    fi[nlevels-1] = new pfs::Array2Df(width,height,arena);
     if (newfattal)
     {
         //#pragma omp parallel for shared(fi)
@@ -294,7 +205,7 @@ void calculateFiMatrix(pfs::Array2Df* FI, pfs::Array2Df* gradients[],
         {
             width = gradients[k-1]->getCols();
             height = gradients[k-1]->getRows();
-            fi[k-1] = new pfs::Array2Df(width,height);
+            fi[k-1] = new pfs::Array2Df(width,height,arena);
         }
         else
             fi[0] = FI;                         // highest level -> result
@@ -302,7 +213,9 @@ void calculateFiMatrix(pfs::Array2Df* FI, pfs::Array2Df* gradients[],
         if ( k>0  && newfattal )
         {
             upSample(*fi[k], *fi[k-1]);           // upsample to next level
-            gaussianBlur(*fi[k-1], *fi[k-1]);
+            pfs::gaussianBlur(*fi[k-1], *fi[k-1],
+                              pfs::PyramidKernel::binomial(), pfs::BORDER_CLAMP,
+                              arena);
         }
     }
 
@@ -341,7 +254,8 @@ void tmo_fattal02(size_t width,
                   bool newfattal,
                   bool fftsolver,
                   int detail_level,
-                  pfs::Progress &ph)
+                  pfs::Progress &ph,
+                  pfs::BufferArena* arena)
 {
 #ifdef TIMER_PROFILING
     msec_timer stop_watch;
@@ -379,12 +293,11 @@ void tmo_fattal02(size_t width,
       minLum = ( Y(i) < minLum ) ? Y(i) : minLum;
       maxLum = ( Y(i) > maxLum ) ? Y(i) : maxLum;
   }
-  pfs::Array2Df* H = new pfs::Array2Df(width, height);
-  //#pragma omp parallel for private(i) shared(H, Y, maxLum)
-  for ( int i=0 ; i<size ; i++ )
-  {
-      (*H)(i) = logf( 100.0f* Y(i)/maxLum + 1e-4 );
-  }
+  pfs::Array2Df* H = new pfs::Array2Df(width, height, arena, false);
+  // H = log( 100*Y/maxLum + 1e-4 )
+  vsmul(Y.data(), 100.0f/maxLum, H->data(), size);
+  vsadd(H->data(), 1e-4f, H->data(), size);
+  vlog(H->data(), H->data(), size);
   ph.setValue(4);
 
   // create gaussian pyramids
@@ -399,8 +312,9 @@ void tmo_fattal02(size_t width,
   // The following lines solves a bug with images particularly small
   if (nlevels == 0) nlevels = 1;
 
-  pfs::Array2Df** pyramids = new pfs::Array2Df*[nlevels];
-  createGaussianPyramids(H, pyramids, nlevels);
+  // each level is blurred by [1 2 1]/4 and averaged on 2x2 blocks
+  pfs::GaussianPyramid pyramids(arena);
+  pyramids.build(*H, nlevels, pfs::PyramidKernel::binomialBox(), pfs::BORDER_CLAMP);
   ph.setValue(8);
 
   // calculate gradients and its average values on pyramid levels
@@ -408,21 +322,20 @@ void tmo_fattal02(size_t width,
   float* avgGrad = new float[nlevels];
   for ( int k=0 ; k<nlevels ; k++ )
   {
-    gradients[k] = new pfs::Array2Df(pyramids[k]->getCols(), pyramids[k]->getRows());
-    avgGrad[k] = calculateGradients(pyramids[k],gradients[k], k);
+    gradients[k] = new pfs::Array2Df(pyramids[k].getCols(), pyramids[k].getRows(), arena);
+    avgGrad[k] = calculateGradients(&pyramids[k],gradients[k], k);
   }
   ph.setValue(12);
 
   // calculate fi matrix
-  pfs::Array2Df* FI = new pfs::Array2Df(width, height);
-  calculateFiMatrix(FI, gradients, avgGrad, nlevels, detail_level, alfa, beta, noise, newfattal);
+  pfs::Array2Df* FI = new pfs::Array2Df(width, height, arena);
+  calculateFiMatrix(FI, gradients, avgGrad, nlevels, detail_level, alfa, beta, noise, newfattal, arena);
 //  dumpPFS( "FI.pfs", FI, "Y" );
+  pyramids.clear();
   for ( int i=0 ; i<nlevels ; i++ )
   {
-    delete pyramids[i];
     delete gradients[i];
   }
-  delete[] pyramids;
   delete[] gradients;
   delete[] avgGrad;
   ph.setValue(16);
@@ -434,8 +347,8 @@ void tmo_fattal02(size_t width,
 
 
   // attenuate gradients
-  pfs::Array2Df* Gx = new pfs::Array2Df(width, height);
-  pfs::Array2Df* Gy = new pfs::Array2Df(width, height);
+  pfs::Array2Df* Gx = new pfs::Array2Df(width, height, arena, false);
+  pfs::Array2Df* Gy = new pfs::Array2Df(width, height, arena, false);
 
   // the fft solver solves the Poisson pde but with slightly different
   // boundary conditions, so we need to adjust the assembly of the right hand
@@ -472,7 +385,7 @@ void tmo_fattal02(size_t width,
 //   dumpPFS( "Gy.pfs", Gy, "Y" );
 
   // calculate divergence
-  pfs::Array2Df DivG(width, height);
+  pfs::Array2Df DivG(width, height, arena, false);
   for ( size_t y = 0; y < height; ++y )
   {
       for ( size_t x = 0; x < width; ++x )
@@ -501,14 +414,14 @@ void tmo_fattal02(size_t width,
 
   // solve pde and exponentiate (ie recover compressed image)
   {
-  pfs::Array2Df U(width, height);
+  pfs::Array2Df U(width, height, arena);
   if (fftsolver)
   {
       solve_pde_fft(&DivG, &U, ph);
   }
   else
   {
-      solve_pde_multigrid(&DivG, &U, ph);
+      solve_pde_multigrid(&DivG, &U, ph, arena);
   }
 #ifndef NDEBUG
   printf("\npde residual error: %f\n", residual_pde(&U, &DivG));
@@ -519,10 +432,9 @@ void tmo_fattal02(size_t width,
       return;
   }
 
-  for ( size_t idx = 0 ; idx < height*width; ++idx )
-  {
-      L(idx) = expf( gamma * U(idx) );
-  }
+  // L = exp( gamma*U )
+  vsmul(U.data(), gamma, L.data(), height*width);
+  vexp(L.data(), L.data(), height*width);
   }
   ph.setValue(95);
 
@@ -38,6 +38,7 @@
 
 namespace pfs
 {
+class BufferArena;
 class Progress;
 }
 
@@ -53,6 +54,7 @@ class Progress;
 //! \param alfa parameter alfa (refer to the paper)
 //! \param beta parameter beta (refer to the paper)
 //! \param noise gradient level of noise (extra parameter)
+//! \param arena arena supplying the temporaries (NULL: regular allocations)
 //!
 void tmo_fattal02(size_t width, size_t height,
                   //const float* Y, float* L,
@@ -61,6 +63,7 @@ void tmo_fattal02(size_t width, size_t height,
                   float alfa, float beta,
                   float noise, bool newfattal,
                   bool fftsolver, int detail_level,
-                  pfs::Progress &ph);
+                  pfs::Progress &ph,
+                  pfs::BufferArena* arena = NULL);
 
 #endif
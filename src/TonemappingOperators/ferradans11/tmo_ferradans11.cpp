@@ -46,6 +46,7 @@
 
 #include "Libpfs/array2d.h"
 #include "Libpfs/progress.h"
+#include "Libpfs/fftplancache.h"
 #include <Libpfs/utils/numeric.h>
 #include "Libpfs/utils/msec_timer.h"
 #include "TonemappingOperators/pfstmo.h"
@@ -265,13 +266,8 @@ void tmo_ferradans11(pfs::Array2Df& imR, pfs::Array2Df& imG, pfs::Array2Df& imB,
     msec_timer stop_watch;
     stop_watch.start();
 #endif
-    // activate parallel execution of fft routines
-    fftwf_init_threads();
-#ifdef _OPENMP
-    fftwf_plan_with_nthreads(omp_get_max_threads());
-#else
-    fftwf_plan_with_nthreads( 2 );
-#endif
+    // plans are shared with any other user of the same frame size
+    pfs::FFTPlanCache& fft = pfs::FFTPlanCache::global();
 
     ph.setValue(0);
 
@@ -430,20 +426,13 @@ void tmo_ferradans11(pfs::Array2Df& imR, pfs::Array2Df& imG, pfs::Array2Df& imB,
     copy(RGB[0], RGB[0]+length, u7);
 
     fftwf_complex* U = (fftwf_complex*) fftwf_malloc(sizeof(fftwf_complex) * length);
-    fftwf_plan pU = fftwf_plan_dft_r2c_2d(fil, col, u0, U,FFTW_ESTIMATE);
     fftwf_complex* U2 = (fftwf_complex*) fftwf_malloc(sizeof(fftwf_complex) * length);
-    fftwf_plan pU2 = fftwf_plan_dft_r2c_2d(fil, col, u2, U2,FFTW_ESTIMATE);
     fftwf_complex* U3 = (fftwf_complex*) fftwf_malloc(sizeof(fftwf_complex) * length);
-    fftwf_plan pU3 = fftwf_plan_dft_r2c_2d(fil, col, u3, U3,FFTW_ESTIMATE);
     fftwf_complex* U4 = (fftwf_complex*) fftwf_malloc(sizeof(fftwf_complex) * length);
-    fftwf_plan pU4 = fftwf_plan_dft_r2c_2d(fil, col, u4, U4,FFTW_ESTIMATE);
 
     fftwf_complex* U5 = (fftwf_complex*) fftwf_malloc(sizeof(fftwf_complex) * length);
-    fftwf_plan pU5 = fftwf_plan_dft_r2c_2d(fil, col, u5, U5,FFTW_ESTIMATE);
     fftwf_complex* U6 = (fftwf_complex*) fftwf_malloc(sizeof(fftwf_complex) * length);
-    fftwf_plan pU6 = fftwf_plan_dft_r2c_2d(fil, col, u6, U6,FFTW_ESTIMATE);
     fftwf_complex* U7 = (fftwf_complex*) fftwf_malloc(sizeof(fftwf_complex) * length);
-    fftwf_plan pU7 = fftwf_plan_dft_r2c_2d(fil, col, u7, U7,FFTW_ESTIMATE);
 
     fftwf_complex* UG  = (fftwf_complex*) fftwf_malloc(sizeof(fftwf_complex) * length);
     fftwf_complex* U2G = (fftwf_complex*) fftwf_malloc(sizeof(fftwf_complex) * length);
@@ -454,25 +443,18 @@ void tmo_ferradans11(pfs::Array2Df& imR, pfs::Array2Df& imG, pfs::Array2Df& imB,
     fftwf_complex* U7G = (fftwf_complex*) fftwf_malloc(sizeof(fftwf_complex) * length);
 
     float *iu = fftwf_alloc_real(length);
-    fftwf_plan pinvU = fftwf_plan_dft_c2r_2d(fil, col, UG, iu, FFTW_ESTIMATE);
 
     float *iu2 = fftwf_alloc_real(length);
-    fftwf_plan pinvU2 = fftwf_plan_dft_c2r_2d(fil, col, U2G, iu2, FFTW_ESTIMATE);
 
     float *iu3 = fftwf_alloc_real(length);
-    fftwf_plan pinvU3 = fftwf_plan_dft_c2r_2d(fil, col, U3G, iu3, FFTW_ESTIMATE);
 
     float *iu4 = fftwf_alloc_real(length);
-    fftwf_plan pinvU4 = fftwf_plan_dft_c2r_2d(fil, col, U4G, iu4, FFTW_ESTIMATE);
 
     float *iu5 = fftwf_alloc_real(length);
-    fftwf_plan pinvU5 = fftwf_plan_dft_c2r_2d(fil, col, U5G, iu5, FFTW_ESTIMATE);
 
     float *iu6 = fftwf_alloc_real(length);
-    fftwf_plan pinvU6 = fftwf_plan_dft_c2r_2d(fil, col, U6G, iu6, FFTW_ESTIMATE);
 
     float *iu7 = fftwf_alloc_real(length);
-    fftwf_plan pinvU7 = fftwf_plan_dft_c2r_2d(fil, col, U7G, iu7, FFTW_ESTIMATE);
 
     float alpha=min(col,fil)/invalpha;
     float *g = fftwf_alloc_real(length);
@@ -488,9 +470,7 @@ void tmo_ferradans11(pfs::Array2Df& imR, pfs::Array2Df& imG, pfs::Array2Df& imB,
     vsmul(g, w, g, length);
 
     fftwf_complex* G = (fftwf_complex*) fftwf_malloc(sizeof(fftwf_complex) * length);
-    fftwf_plan pG = fftwf_plan_dft_r2c_2d(fil, col, g, G, FFTW_ESTIMATE);
-    fftwf_execute(pG);
-    fftwf_destroy_plan(pG);
+    fft.r2c(fil, col, g, G);
 
     fftwf_free(g);
 
@@ -502,21 +482,6 @@ void tmo_ferradans11(pfs::Array2Df& imR, pfs::Array2Df& imG, pfs::Array2Df& imB,
         delete[] RGB[0];
         delete[] RGB[1];
         delete[] RGB[2];
-        fftwf_destroy_plan(pU);
-        fftwf_destroy_plan(pU2);
-        fftwf_destroy_plan(pU3);
-        fftwf_destroy_plan(pU4);
-        fftwf_destroy_plan(pU5);
-        fftwf_destroy_plan(pU6);
-        fftwf_destroy_plan(pU7);
-
-        fftwf_destroy_plan(pinvU);
-        fftwf_destroy_plan(pinvU2);
-        fftwf_destroy_plan(pinvU3);
-        fftwf_destroy_plan(pinvU4);
-        fftwf_destroy_plan(pinvU5);
-        fftwf_destroy_plan(pinvU6);
-        fftwf_destroy_plan(pinvU7);
 
         fftwf_free(RGB0);
         fftwf_free(u0);
@@ -587,13 +552,13 @@ void tmo_ferradans11(pfs::Array2Df& imR, pfs::Array2Df& imG, pfs::Array2Df& imB,
             copy(u6, u6+length, u7);
             transform(u7, u7+length, u0, u7, multiplies<float>());
 
-            fftwf_execute(pU);
-            fftwf_execute(pU2);
-            fftwf_execute(pU3);
-            fftwf_execute(pU4);
-            fftwf_execute(pU5);
-            fftwf_execute(pU6);
-            fftwf_execute(pU7);
+            fft.r2c(fil, col, u0, U);
+            fft.r2c(fil, col, u2, U2);
+            fft.r2c(fil, col, u3, U3);
+            fft.r2c(fil, col, u4, U4);
+            fft.r2c(fil, col, u5, U5);
+            fft.r2c(fil, col, u6, U6);
+            fft.r2c(fil, col, u7, U7);
 
             producto(U,G,UG,fil,col);
             producto(U2,G,U2G,fil,col);
@@ -603,25 +568,25 @@ void tmo_ferradans11(pfs::Array2Df& imR, pfs::Array2Df& imG, pfs::Array2Df& imB,
             producto(U6,G,U6G,fil,col);
             producto(U7,G,U7G,fil,col);
 
-            fftwf_execute(pinvU);
+            fft.c2r(fil, col, UG, iu);
             vsmul(iu, norm, iu, length);
 
-            fftwf_execute(pinvU2);
+            fft.c2r(fil, col, U2G, iu2);
             vsmul(iu2, norm, iu2, length);
 
-            fftwf_execute(pinvU3);
+            fft.c2r(fil, col, U3G, iu3);
             vsmul(iu3, norm, iu3, length);
 
-            fftwf_execute(pinvU4);
+            fft.c2r(fil, col, U4G, iu4);
             vsmul(iu4, norm, iu4, length);
 
-            fftwf_execute(pinvU5);
+            fft.c2r(fil, col, U5G, iu5);
             vsmul(iu5, norm, iu5, length);
 
-            fftwf_execute(pinvU6);
+            fft.c2r(fil, col, U6G, iu6);
             vsmul(iu6, norm, iu6, length);
 
-            fftwf_execute(pinvU7);
+            fft.c2r(fil, col, U7G, iu7);
             vsmul(iu7, norm, iu7, length);
 
             #pragma omp parallel for
@@ -658,21 +623,6 @@ void tmo_ferradans11(pfs::Array2Df& imR, pfs::Array2Df& imG, pfs::Array2Df& imB,
         if (iteration > 1)
             ph.setValue(30+69/(steps+1));
     }
-    fftwf_destroy_plan(pU);
-    fftwf_destroy_plan(pU2);
-    fftwf_destroy_plan(pU3);
-    fftwf_destroy_plan(pU4);
-    fftwf_destroy_plan(pU5);
-    fftwf_destroy_plan(pU6);
-    fftwf_destroy_plan(pU7);
-
-    fftwf_destroy_plan(pinvU);
-    fftwf_destroy_plan(pinvU2);
-    fftwf_destroy_plan(pinvU3);
-    fftwf_destroy_plan(pinvU4);
-    fftwf_destroy_plan(pinvU5);
-    fftwf_destroy_plan(pinvU6);
-    fftwf_destroy_plan(pinvU7);
 
     fftwf_free(RGB0);
     fftwf_free(u0);
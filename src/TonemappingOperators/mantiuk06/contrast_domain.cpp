@@ -78,7 +78,6 @@
 
 #include "pyramid.h"
 
-#include "Libpfs/utils/sse.h"
 #include "Libpfs/utils/numeric.h"
 #include "Libpfs/utils/minmax.h"
 #include "Libpfs/utils/dotproduct.h"
@@ -100,7 +99,7 @@ void multiplyA(PyramidT& px, const PyramidT& pC,
     px.computeSumOfDivergence( sumOfDivG );
 }
 
-// conjugate linear equation solver overwrites pyramid!
+// conjugate linear equation solver
 //
 // This version is a slightly modified version by
 // Davide Anastasia <davideanastasia@users.sourceforge.net>
@@ -109,12 +108,67 @@ void multiplyA(PyramidT& px, const PyramidT& pC,
 namespace
 {
 const int NUM_BACKWARDS_CEILING = 3;
+
+// x = x + alpha*p and r = r - alpha*Ap in a single pass
+// \return r.r
+float updateSolution(float alpha, const Array2Df& p, const Array2Df& Ap,
+                     Array2Df& x, Array2Df& r)
+{
+    const int n = static_cast<int>(x.size());
+    const float* pd = p.data();
+    const float* apd = Ap.data();
+    float* xd = x.data();
+    float* rd = r.data();
+
+    double rdotr = 0.0;
+#pragma omp parallel for reduction(+:rdotr) schedule(static)
+    for (int i = 0; i < n; i++)
+    {
+        xd[i] += alpha*pd[i];
+        const float ri = rd[i] - alpha*apd[i];
+        rd[i] = ri;
+        rdotr += ri*ri;
+    }
+    return static_cast<float>(rdotr);
+}
+
+// r = b - Ax
+// \return r.r
+float computeResidual(const PyramidT& pC, const Array2Df& b,
+                      const Array2Df& x, Array2Df& r)
+{
+    pC.computeSumOfScaledDivergence(x, r);
+    utils::vsub(b.data(), r.data(), r.data(), r.size());
+    return utils::dotProduct(r.data(), r.size());
+}
+
+void warnNotConverged(bool maxIterations, float error, float tol)
+{
+    if (maxIterations)
+    {
+        std::cerr << std::endl << "pfstmo_mantiuk06: Warning: Not "\
+                     "converged (hit maximum iterations), error = "
+                  << error
+                  << " (should be below " << tol <<")"
+                  << std::endl;
+    }
+    else
+    {
+        std::cerr << std::endl
+                  << "pfstmo_mantiuk06: Warning: Not converged "\
+                     "(going unstable), error = "
+                  << error
+                  << " (should be below " << tol << ")"
+                  << std::endl;
+    }
+}
 }
 
-void lincg(PyramidT& pyramid, PyramidT& pC,
-           const Array2Df& b, Array2Df& x,
-           const int itmax, const float tol,
-           Progress &ph)
+//! \return number of iterations
+int lincg(const PyramidT& pC,
+          const Array2Df& b, Array2Df& x,
+          const int itmax, const float tol,
+          Progress &ph)
 {
     float rdotr_curr;
     float rdotr_prev;
@@ -122,25 +176,28 @@ void lincg(PyramidT& pyramid, PyramidT& pC,
     float alpha;
     float beta;
 
-    const size_t rows   = pyramid.getRows();
-    const size_t cols   = pyramid.getCols();
+    const size_t rows   = pC.getRows();
+    const size_t cols   = pC.getCols();
     const size_t n      = rows*cols;
     const float tol2    = tol*tol;
 
-    Array2Df x_best(cols, rows);
-    Array2Df r(cols, rows);
-    Array2Df p(cols, rows);
-    Array2Df Ap(cols, rows);
+    // all the temporaries are fully written before being read
+    Array2Df x_best(cols, rows, pC.arena(), false);
+    Array2Df r(cols, rows, pC.arena(), false);
+    Array2Df p(cols, rows, pC.arena(), false);
+    Array2Df Ap(cols, rows, pC.arena(), false);
 
     // bnrm2 = ||b||
     const float bnrm2 = utils::dotProduct(b.data(), n);
 
-    // r = b - Ax
-    multiplyA(pyramid, pC, x, r);     // r = A x
-    utils::vsub(b.data(), r.data(), r.data(), n);     // r = b - r
+    // r = b - Ax, rdotr = r.r
+    rdotr_best = rdotr_curr = computeResidual(pC, b, x, r);
 
-    // rdotr = r.r
-    rdotr_best = rdotr_curr = utils::dotProduct(r.data(), n);
+    // a warm start can already be within the tolerance
+    if (rdotr_curr/bnrm2 < tol2)
+    {
+        return 0;
+    }
 
     // Setup initial vector
     std::copy(r.begin(), r.end(), p.begin());   // p = r
@@ -164,26 +221,23 @@ void lincg(PyramidT& pyramid, PyramidT& pC,
         }
 
         // Ap = A p
-        multiplyA(pyramid, pC, p, Ap);
+        pC.computeSumOfScaledDivergence(p, Ap);
 
         // alpha = r.r / (p . Ap)
         alpha = rdotr_curr / utils::dotProduct(p.data(), Ap.data(), n);
 
-        // r = r - alpha Ap
-        utils::vsubs(r.data(), alpha, Ap.data(), r.data(), n);
-
-        // rdotr = r.r
+        // x = x + alpha * p, r = r - alpha Ap, rdotr = r.r
         rdotr_prev = rdotr_curr;
-        rdotr_curr = utils::dotProduct(r.data(), n);
+        rdotr_curr = updateSolution(alpha, p, Ap, x, r);
 
         // Have we gone unstable?
         if (rdotr_curr > rdotr_prev)
         {
-            // Save where we've got to
+            // Save where we've got to (x before this iteration)
             if (num_backwards == 0 && rdotr_prev < rdotr_best)
             {
                 rdotr_best = rdotr_prev;
-                std::copy(x.begin(), x.end(), x_best.begin());
+                utils::vsubs(x.data(), alpha, p.data(), x_best.data(), n);
             }
 
             num_backwards++;
@@ -193,9 +247,6 @@ void lincg(PyramidT& pyramid, PyramidT& pC,
             num_backwards = 0;
         }
 
-        // x = x + alpha * p
-        utils::vadds(x.data(), alpha, p.data(), x.data(), n);
-
         // Exit if we're done
         // fprintf(stderr, "iter:%d err:%f\n", iter+1, sqrtf(rdotr/bnrm2));
         if (rdotr_curr/bnrm2 < tol2)
@@ -207,14 +258,8 @@ void lincg(PyramidT& pyramid, PyramidT& pC,
             num_backwards = 0;
             std::copy(x_best.begin(), x_best.end(), x.begin());
 
-            // r = Ax
-            multiplyA(pyramid, pC, x, r);
-
-            // r = b - r
-            utils::vsub(b.data(), r.data(), r.data(), n);
-
-            // rdotr = r.r
-            rdotr_best = rdotr_curr = utils::dotProduct(r.data(), r.size());
+            // r = b - Ax, rdotr = r.r
+            rdotr_best = rdotr_curr = computeResidual(pC, b, x, r);
 
             // p = r
             std::copy(r.begin(), r.end(), p.begin());
@@ -240,24 +285,9 @@ void lincg(PyramidT& pyramid, PyramidT& pC,
         ph.setValue(
                     static_cast<int>(std::log(rdotr_curr/irdotr)*percent_sf)
                     );
-        if (iter == itmax)
-        {
-            std::cerr << std::endl << "pfstmo_mantiuk06: Warning: Not "\
-                         "converged (hit maximum iterations), error = "
-                      << std::sqrt(rdotr_curr/bnrm2)
-                      << " (should be below " << tol <<")"
-                      << std::endl;
-        }
-        else
-        {
-            std::cerr << std::endl
-                      << "pfstmo_mantiuk06: Warning: Not converged "\
-                         "(going unstable), error = "
-                      << std::sqrt(rdotr_curr/bnrm2)
-                      << " (should be below " << tol << ")"
-                      << std::endl;
-        }
+        warnNotConverged(iter == itmax, std::sqrt(rdotr_curr/bnrm2), tol);
     }
+    return iter;
 }
 
 void transformToLuminance(PyramidT& pp, Array2Df& Y,
@@ -272,13 +302,13 @@ void transformToLuminance(PyramidT& pp, Array2Df& Y,
     pp.multiply( pC );
 
     // size of the first level of the pyramid
-    Array2Df b( pp.getCols(), pp.getRows() );
+    Array2Df b( pp.getCols(), pp.getRows(), pp.arena(), false );
 
     // calculate the sum of divergences (equal to b)
     pp.computeSumOfDivergence( b );
 
     // calculate luminances from gradients
-    lincg(pp, pC, b, Y, itmax, tol, ph);
+    lincg(pC, b, Y, itmax, tol, ph);
 }
 
 struct HistData
@@ -397,8 +427,8 @@ void normalizeLuminanceAndRGB(Array2Df& R, Array2Df& G, Array2Df& B,
         R(idx) *= currY;
         G(idx) *= currY;
         B(idx) *= currY;
-        Y(idx) = std::log10( Y(idx) );
     }
+    utils::vlog10(Y.data(), Y.data(), Y.size());
 }
 
 /* Renormalize luminance */
@@ -446,16 +476,94 @@ T decode(const T& value)
 void denormalizeRGB(Array2Df& R, Array2Df& G, Array2Df& B, const Array2Df& Y,
                     float saturationFactor)
 {
-    const int size = static_cast<int>(Y.size());
+    const size_t size = Y.size();
+
+    std::vector<float> myY(size);
+    utils::vexp10(Y.data(), myY.data(), size);
+    utils::vpow(R.data(), saturationFactor, R.data(), size);
+    utils::vpow(G.data(), saturationFactor, G.data(), size);
+    utils::vpow(B.data(), saturationFactor, B.data(), size);
 
     /* Transform to sRGB */
 #pragma omp parallel for
-    for (int j = 0; j < size; j++)
+    for (int j = 0; j < static_cast<int>(size); j++)
+    {
+        R(j) = decode( R(j) * myY[j] );
+        G(j) = decode( G(j) * myY[j] );
+        B(j) = decode( B(j) * myY[j] );
+    }
+}
+}
+
+Mantiuk06Session::Mantiuk06Session()
+    : detailFactor(0.f)
+    , solved(false)
+    , contrastFactor(0.f)
+    , itmax(0)
+    , tol(0.f)
+    , solves(0)
+    , warmStarts(0)
+{}
+
+Mantiuk06Session::~Mantiuk06Session()
+{}
+
+void Mantiuk06Session::clear()
+{
+    Array2Df().swap(input);
+    gradients.reset();
+    transformed.reset();
+    Array2Df().swap(solution);
+    solved = false;
+}
+
+namespace
+{
+void copyLevels(const PyramidT& from, PyramidT& to)
+{
+    assert( from.numLevels() == to.numLevels() );
+
+    PyramidT::iterator itTo = to.begin();
+    for ( PyramidT::const_iterator itFrom = from.begin(), itEnd = from.end();
+          itFrom != itEnd;
+          ++itFrom, ++itTo )
+    {
+        std::copy(itFrom->begin(), itFrom->end(), itTo->begin());
+    }
+}
+
+// updates the stages of \a session that do not depend on the contrast
+// factor: the gradient pyramid and its transformation to R
+void updateSession(Mantiuk06Session& session, const Array2Df& Y,
+                   float detailfactor)
+{
+    const size_t r = Y.getRows();
+    const size_t c = Y.getCols();
+
+    // the stages are kept with regular allocations, since they outlive the
+    // arena of a single call
+    const bool sameInput = session.input.getCols() == c &&
+            session.input.getRows() == r &&
+            std::equal(Y.begin(), Y.end(), session.input.begin());
+    if ( !sameInput )
+    {
+        session.clear();
+        session.input.resize(c, r);
+        std::copy(Y.begin(), Y.end(), session.input.begin());
+    }
+
+    if ( !session.gradients )
+    {
+        session.gradients.reset( new PyramidT(r, c) );
+        session.gradients->computeGradients( Y );
+    }
+
+    if ( !session.transformed || session.detailFactor != detailfactor )
     {
-        float myY = std::pow( 10.f, Y(j) );
-        R(j) = decode( std::pow( R(j), saturationFactor ) * myY );
-        G(j) = decode( std::pow( G(j), saturationFactor ) * myY );
-        B(j) = decode( std::pow( B(j), saturationFactor ) * myY );
+        session.transformed.reset( new PyramidT(*session.gradients) );
+        session.transformed->transformToR( detailfactor );
+        session.detailFactor = detailfactor;
+        session.solved = false;
     }
 }
 }
@@ -468,7 +576,9 @@ int tmo_mantiuk06_contmap(Array2Df& R, Array2Df& G, Array2Df& B,
                           float detailfactor,
                           const int itmax,
                           const float tol,
-                          Progress &ph)
+                          Progress &ph,
+                          BufferArena* arena,
+                          Mantiuk06Session* session)
 {
     assert( R.getCols() == G.getCols() );
     assert( G.getCols() == B.getCols() );
@@ -484,11 +594,40 @@ int tmo_mantiuk06_contmap(Array2Df& R, Array2Df& G, Array2Df& B,
     normalizeLuminanceAndRGB(R, G, B, Y);
 
     // create pyramid
-    PyramidT pp(r, c);
-    // calculate gradients for pyramid (Y won't be changed)
-    pp.computeGradients( Y );
-    // transform gradients to R
-    pp.transformToR( detailfactor );
+    PyramidT pp(r, c, arena);
+    if ( session == NULL )
+    {
+        // calculate gradients for pyramid (Y won't be changed)
+        pp.computeGradients( Y );
+        // transform gradients to R
+        pp.transformToR( detailfactor );
+    }
+    else
+    {
+        updateSession(*session, Y, detailfactor);
+
+        if ( session->solved &&
+             session->contrastFactor == contrastFactor &&
+             session->itmax == itmax && session->tol == tol )
+        {
+            // only the saturation changed
+            std::copy(session->solution.begin(), session->solution.end(), Y.begin());
+
+            denormalizeLuminance(Y);
+            denormalizeRGB(R, G, B, Y, saturationFactor);
+
+            return PFSTMO_OK;
+        }
+
+        // starts from the previous solution instead of the input luminance
+        if ( session->solution.size() == Y.size() )
+        {
+            std::copy(session->solution.begin(), session->solution.end(), Y.begin());
+            session->warmStarts++;
+        }
+
+        copyLevels(*session->transformed, pp);
+    }
 
     // Contrast map
     if ( contrastFactor > 0.0f )
@@ -507,6 +646,17 @@ int tmo_mantiuk06_contmap(Array2Df& R, Array2Df& G, Array2Df& B,
     // transform gradients to luminance Y (pp -> Y)
     transformToLuminance(pp, Y, itmax, tol, ph);
 
+    if ( session != NULL )
+    {
+        session->solution.resize(c, r);
+        std::copy(Y.begin(), Y.end(), session->solution.begin());
+        session->solved = !ph.canceled();
+        session->contrastFactor = contrastFactor;
+        session->itmax = itmax;
+        session->tol = tol;
+        session->solves++;
+    }
+
     denormalizeLuminance(Y);
     denormalizeRGB(R, G, B, Y, saturationFactor);
 
@@ -37,8 +37,51 @@
 #ifndef CONTRAST_DOMAIN_H
 #define CONTRAST_DOMAIN_H
 
+#include <memory>
+
 #include "TonemappingOperators/pfstmo.h"
-#include <Libpfs/array2d_fwd.h>
+#include <Libpfs/array2d.h>
+
+class PyramidT;
+
+//! \brief Stages of tmo_mantiuk06_contmap() kept across the calls on the
+//! same frame, so that tweaking a parameter recomputes only the stages that
+//! depend on it:
+//! - the gradient pyramid depends on the input luminance only
+//! - the R pyramid also depends on the detail factor
+//! - the luminance also depends on the contrast factor and on the settings
+//! of the solver. When these change, the solver starts from the previous
+//! solution instead of the input luminance.
+//! The saturation is applied again on every call.
+//!
+//! A frame with a different luminance discards all the stages.
+struct Mantiuk06Session
+{
+    Mantiuk06Session();
+    ~Mantiuk06Session();
+
+    //! \brief discards all the stages
+    void clear();
+
+    //! \brief normalised log10 luminance of the last frame
+    pfs::Array2Df input;
+
+    std::unique_ptr<PyramidT> gradients;
+    std::unique_ptr<PyramidT> transformed;     //!< R pyramid
+    float detailFactor;
+
+    //! \brief log10 luminance computed by the last solve (empty if none)
+    pfs::Array2Df solution;
+    //! \brief parameters \c solution was solved for; a canceled solve only
+    //! leaves a starting point for the next one
+    bool solved;
+    float contrastFactor;
+    int itmax;
+    float tol;
+
+    size_t solves;      //!< calls that ran the solver
+    size_t warmStarts;  //!< solves started from a previous solution
+};
 
 //! \brief: Tone mapping algorithm [Mantiuk2006]
 //!
@@ -51,6 +94,9 @@
 //! \param itmax maximum number of iterations for convergence (typically 50)
 //! \param tol tolerence to get within for convergence (typically 1e-3)
 //! \param ph callback class that reports progress
+//! \param arena arena supplying the temporaries (NULL: regular allocations)
+//! \param session stages kept from the previous calls on the same frame, or
+//! NULL to compute all of them
 //! \return PFSTMO_OK if tone-mapping was sucessful, PFSTMO_ABORTED if
 //! it was stopped from a callback function and PFSTMO_ERROR if an
 //! error was encountered.
@@ -59,6 +105,8 @@ int tmo_mantiuk06_contmap( pfs::Array2Df& R, pfs::Array2Df& G, pfs::Array2Df& B,
                            pfs::Array2Df& Y,
                            float contrastFactor, float saturationFactor, float detailFactor,
                            int itmax /*= 200*/, float tol /*= 1e-3*/,
-                           pfs::Progress &ph);
+                           pfs::Progress &ph,
+                           pfs::BufferArena* arena = NULL,
+                           Mantiuk06Session* session = NULL);
 
 #endif
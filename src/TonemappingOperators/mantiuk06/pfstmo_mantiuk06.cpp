@@ -62,7 +62,9 @@ const float tol = 5e-3f;
 
 void pfstmo_mantiuk06(pfs::Frame& frame, float scaleFactor,
                       float saturationFactor, float detailFactor,
-                      bool cont_eq, pfs::Progress &ph)
+                      bool cont_eq, pfs::Progress &ph,
+                      pfs::BufferArena* arena,
+                      Mantiuk06Session* session)
 {
 #ifndef NDEBUG
     std::stringstream ss;
@@ -100,12 +102,12 @@ void pfstmo_mantiuk06(pfs::Frame& frame, float scaleFactor,
     const int cols = frame.getWidth();
     const int rows = frame.getHeight();
 
-    pfs::Array2Df inY( cols, rows );
+    pfs::Array2Df inY( cols, rows, arena, false );
     pfs::transformRGB2Y(inRed, inGreen, inBlue, &inY);
 
     tmo_mantiuk06_contmap(*inRed, *inGreen, *inBlue, inY,
                           scaleFactor, saturationFactor, detailFactor, itmax, tol,
-                          ph);
+                          ph, arena, session);
 
     frame.getTags().setTag("LUMINANCE", "RELATIVE");
     if ( !ph.canceled() )
@@ -40,7 +40,7 @@
 #endif
 
 #include "Libpfs/array2d.h"
-#include "Libpfs/utils/sse.h"
+#include "Libpfs/manip/pyramid.h"
 #include "Libpfs/utils/numeric.h"
 
 using namespace pfs;
@@ -59,14 +59,25 @@ namespace
 const size_t PYRAMID_MIN_PIXELS = 3;
 }
 
-PyramidT::PyramidT(size_t rows, size_t cols)
+PyramidT::PyramidT(size_t rows, size_t cols, pfs::BufferArena* arena)
     : m_rows(rows)
     , m_cols(cols)
+    , m_arena(arena)
 {
+    size_t numLevels = 0;
+    for (size_t referenceSize = std::min( rows, cols );
+         referenceSize >= PYRAMID_MIN_PIXELS;
+         referenceSize = downscaleBy2(referenceSize))
+    {
+        ++numLevels;
+    }
+    // the levels are built in place, so that they keep their arena
+    m_pyramid.reserve( numLevels );
+
     size_t referenceSize = std::min( rows, cols );
     while ( referenceSize >= PYRAMID_MIN_PIXELS )
     {
-        m_pyramid.push_back( PyramidS(cols, rows) );
+        m_pyramid.emplace_back( cols, rows, m_arena );
 
         rows = downscaleBy2(rows);                     // division by 2
         cols = downscaleBy2(cols);                     // division by 2
@@ -87,23 +98,23 @@ void PyramidT::computeGradients(const pfs::Array2Df& Y)
 #endif
 
     Array2Df buffer1(downscaleBy2(Y.getCols()),
-                     downscaleBy2(getRows()));
+                     downscaleBy2(getRows()), m_arena, false);
     Array2Df buffer2(downscaleBy2(buffer1.getCols()),
-                     downscaleBy2(buffer1.getRows()));
+                     downscaleBy2(buffer1.getRows()), m_arena, false);
 
     calculateGradients(Y.data(), m_pyramid[0]);
 
     if ( m_pyramid.size() > 1 )
     {
-        matrixDownsample(m_pyramid[0].getCols(), m_pyramid[0].getRows(),
-                         Y.data(), buffer1.data());
+        pfs::downsample(m_pyramid[0].getCols(), m_pyramid[0].getRows(),
+                        Y.data(), buffer1.data());
         calculateGradients(buffer1.data(), m_pyramid[1]);
     }
 
     for (size_t idx = 2; idx < m_pyramid.size(); ++idx)
     {
-        matrixDownsample(m_pyramid[idx-1].getCols(), m_pyramid[idx-1].getRows(),
-                         buffer1.data(), buffer2.data());
+        pfs::downsample(m_pyramid[idx-1].getCols(), m_pyramid[idx-1].getRows(),
+                        buffer1.data(), buffer2.data());
         calculateGradients(buffer2.data(), m_pyramid[idx]);
 
         buffer1.swap( buffer2 );
@@ -114,7 +125,8 @@ void PyramidT::computeSumOfDivergence(pfs::Array2Df& sumOfdivG)
 {
     // zero dimension Array2D
     pfs::Array2Df tempSumOfdivG( downscaleBy2(sumOfdivG.getCols()),
-                                 downscaleBy2(sumOfdivG.getRows()) );
+                                 downscaleBy2(sumOfdivG.getRows()),
+                                 m_arena, false );
 
     if ( (numLevels() % 2) )
     {
@@ -135,14 +147,70 @@ void PyramidT::computeSumOfDivergence(pfs::Array2Df& sumOfdivG)
 
     for (int idx = numLevels()-2; idx >= 0; idx--)
     {
-        matrixUpsample(m_pyramid[idx].getCols(), m_pyramid[idx].getRows(),
-                       sumOfdivG.data(), tempSumOfdivG.data());
+        pfs::upsample(m_pyramid[idx].getCols(), m_pyramid[idx].getRows(),
+                      sumOfdivG.data(), tempSumOfdivG.data());
         calculateAndAddDivergence(m_pyramid[idx],
                                   tempSumOfdivG.data());
         tempSumOfdivG.swap(sumOfdivG);
     }
 }
 
+void PyramidT::computeSumOfScaledDivergence(const pfs::Array2Df& x,
+                                            pfs::Array2Df& sumOfDivG) const
+{
+    assert( this->getCols() == x.getCols() );
+    assert( this->getRows() == x.getRows() );
+    assert( this->getCols() == sumOfDivG.getCols() );
+    assert( this->getRows() == sumOfDivG.getRows() );
+
+    if ( !m_pyramid.size() )
+    {
+        sumOfDivG.fill(0.0f);
+        return;
+    }
+
+    // x downsampled on every level but the first
+    std::vector<pfs::Array2Df> xLevels;
+    xLevels.reserve( m_pyramid.size() - 1 );
+
+    const float* xCurr = x.data();
+    for (size_t idx = 1; idx < m_pyramid.size(); ++idx)
+    {
+        xLevels.emplace_back(m_pyramid[idx].getCols(), m_pyramid[idx].getRows(),
+                             m_arena, false);
+        pfs::downsample(m_pyramid[idx-1].getCols(), m_pyramid[idx-1].getRows(),
+                        xCurr, xLevels.back().data());
+        xCurr = xLevels.back().data();
+    }
+
+    // the sums of the coarser levels alternate between two buffers
+    pfs::Array2Df buffer1(downscaleBy2(getCols()), downscaleBy2(getRows()),
+                          m_arena, false);
+    pfs::Array2Df buffer2(downscaleBy2(getCols()), downscaleBy2(getRows()),
+                          m_arena, false);
+
+    const float* coarserSum = NULL;
+    for (int idx = numLevels()-1; idx >= 0; idx--)
+    {
+        const PyramidS& C = m_pyramid[idx];
+        float* sum = (idx == 0) ? sumOfDivG.data()
+                                : ((idx % 2) ? buffer1.data() : buffer2.data());
+
+        if ( coarserSum )
+        {
+            pfs::upsample(C.getCols(), C.getRows(), coarserSum, sum);
+        }
+        else
+        {
+            std::fill(sum, sum + C.size(), 0.0f);
+        }
+
+        calculateAndAddScaledDivergence(idx ? xLevels[idx-1].data() : x.data(),
+                                        C, sum);
+        coarserSum = sum;
+    }
+}
+
 namespace
 {
 struct CalculateScaleFactor
@@ -272,191 +340,6 @@ void PyramidT::multiply(const PyramidT &other)
     }
 }
 
-// downsample the matrix
-void matrixDownsampleFull(size_t inCols, size_t inRows,
-                          const float* inputData, float* outputData)
-{
-    const size_t outRows = inRows / 2;
-    const size_t outCols = inCols / 2;
-
-    const float dx = static_cast<float>(inCols) / outCols;
-    const float dy = static_cast<float>(inRows) / outRows;
-    const float normalize = 1.0f/(dx*dy);
-
-    // New downsampling by Ed Brambley:
-    // Experimental downsampling that assumes pixels are square and
-    // integrates over each new pixel to find the average value of the
-    // underlying pixels.
-    //
-    // Consider the original pixels laid out, and the new (larger)
-    // pixels layed out over the top of them.  Then the new value for
-    // the larger pixels is just the integral over that pixel of what
-    // shows through; i.e., the values of the pixels underneath
-    // multiplied by how much of that pixel is showing.
-    //
-    // (ix1, iy1) is the coordinate of the top left visible pixel.
-    // (ix2, iy2) is the coordinate of the bottom right visible pixel.
-    // (fx1, fy1) is the fraction of the top left pixel showing.
-    // (fx2, fy2) is the fraction of the bottom right pixel showing.
-
-#pragma omp parallel for
-    for (int y = 0; y < static_cast<int>(outRows); y++)
-    {
-        const size_t iy1 = (  y   * inRows) / outRows;
-        const size_t iy2 = ((y+1) * inRows) / outRows;
-        const float fy1 = (iy1+1) - y * dy;
-        const float fy2 = (y+1) * dy - iy2;
-
-        for (size_t x = 0; x < outCols; x++)
-        {
-            const size_t ix1 = (  x   * inCols) / outCols;
-            const size_t ix2 = ((x+1) * inCols) / outCols;
-            const float fx1 = (ix1+1) - x * dx;
-            const float fx2 = (x+1) * dx - ix2;
-
-            float pixVal = 0.0f;
-            float factorx, factory;
-            for (size_t i = iy1; i <= iy2 && i < inRows; i++)
-            {
-                if (i == iy1)
-                    factory = fy1;  // We're just getting the bottom edge of this pixel
-                else if (i == iy2)
-                    factory = fy2;  // We're just gettting the top edge of this pixel
-                else
-                    factory = 1.0f; // We've got the full height of this pixel
-                for (size_t j = ix1; j <= ix2 && j < inCols; j++)
-                {
-                    if (j == ix1)
-                        factorx = fx1;  // We've just got the right edge of this pixel
-                    else if (j == ix2)
-                        factorx = fx2; // We've just got the left edge of this pixel
-                    else
-                        factorx = 1.0f; // We've got the full width of this pixel
-
-                    pixVal += inputData[j + i*inCols] * factorx * factory;
-                }
-            }
-
-            outputData[x + y * outCols] = pixVal * normalize;  // Normalize by the area of the new pixel
-        }
-    }
-}
-
-void matrixDownsampleSimple(size_t inCols, size_t inRows,
-                            const float* inputData, float* outputData)
-{
-    const size_t outRows = inRows / 2;
-    const size_t outCols = inCols / 2;
-
-    // Simplified downsampling by Bruce Guenter:
-    //
-    // Follows exactly the same math as the full downsampling above,
-    // except that inRows and inCols are known to be even.  This allows
-    // for all of the boundary cases to be eliminated, reducing the
-    // sampling to a simple average.
-
-#pragma omp parallel for
-    for (int y = 0; y < static_cast<int>(outRows); y++)
-    {
-        const int iy1 = y * 2;
-        const float* datap = inputData + iy1 * inCols;
-        float* resp = outputData + y * outCols;
-
-        for (size_t x = 0; x < outCols; x++)
-        {
-            const size_t ix1 = x*2;
-
-            resp[x] = ( datap[ix1] +
-                        datap[(ix1+1)] +
-                        datap[ix1     + inCols] +
-                        datap[(ix1+1) + inCols]) * 0.25f; // / 4.0f;
-        }
-    }
-}
-
-void matrixDownsample(size_t inCols, size_t inRows,
-                      const float* inputData, float* outputData)
-{
-    if ( !(inCols % 2) && !(inRows % 2) )
-    {
-        matrixDownsampleSimple(inCols, inRows, inputData, outputData);
-    }
-    else
-    {
-        matrixDownsampleFull(inCols, inRows, inputData, outputData);
-    }
-}
-
-// upsample the matrix
-// upsampled matrix is twice bigger in each direction than data[]
-// res should be a pointer to allocated memory for bigger matrix
-// cols and rows are the dimensions of the output matrix
-void matrixUpsampleFull(const size_t outCols, const size_t outRows,
-                        const float* inputData, float* outputData)
-{
-    const size_t inRows = outRows/2;
-    const size_t inCols = outCols/2;
-
-    // Transpose of experimental downsampling matrix (theoretically the correct thing to do)
-    const float dx = static_cast<float>(inCols)/outCols;
-    const float dy = static_cast<float>(inRows)/outRows;
-
-    // This gives a genuine upsampling matrix, not the transpose of the downsampling matrix
-    const float factor = 1.0f / (dx*dy);
-    // Theoretically, this should be the best.
-    // const float factor = 1.0f;
-
-#pragma omp parallel for
-    for (int y = 0; y < static_cast<int>(outRows); y++)
-    {
-        const float sy = y * dy;
-        const int iy1 =      (  y   * inRows) / outRows;
-        const int iy2 = std::min(((y+1) * inRows) / outRows, inRows-1);
-
-        for (size_t x = 0; x < outCols; x++)
-        {
-            const float sx = x * dx;
-            const int ix1 =      (  x   * inCols) / outCols;
-            const int ix2 = std::min(((x+1) * inCols) / outCols, inCols-1);
-
-            outputData[x + y*outCols] = (((ix1+1) - sx)*((iy1+1 - sy)) * inputData[ix1 + iy1*inCols] +
-                                         ((ix1+1) - sx)*(sy+dy - (iy1+1)) * inputData[ix1 + iy2*inCols] +
-                                         (sx+dx - (ix1+1))*((iy1+1 - sy)) * inputData[ix2 + iy1*inCols] +
-                                         (sx+dx - (ix1+1))*(sy+dx - (iy1+1)) * inputData[ix2 + iy2*inCols])*factor;
-        }
-    }
-}
-
-void matrixUpsampleSimple(const int outCols, const int outRows,
-                          const float* const inputData, float* const outputData)
-{
-#pragma omp parallel for
-    for (int y = 0; y < outRows; y++)
-    {
-        const int iy1 = y / 2;
-        float* outp = outputData + y*outCols;
-        const float* inp = inputData + iy1*(outCols/2);
-        for (int x = 0; x < outCols; x+=2)
-        {
-            const int ix1 = x / 2;
-            outp[x] = outp[x+1] = inp[ix1];
-        }
-    }
-}
-
-void matrixUpsample(size_t outCols, size_t outRows,
-                    const float* inputData, float* outputData)
-{
-    if ( !(outRows%2) && !(outCols%2) )
-    {
-        matrixUpsampleSimple(outCols, outRows, inputData, outputData);
-    }
-    else
-    {
-        matrixUpsampleFull(outCols, outRows, inputData, outputData);
-    }
-}
-
 // calculate gradients
 void calculateGradients(const float* inputData, PyramidS& gradient)
 {
@@ -659,6 +542,53 @@ void calculateAndAddDivergence(const PyramidS& G, float* divG)
     }
 }
 
+//! \brief same sum of calculateGradients(), scaling by \a C and
+//! calculateAndAddDivergence(), in a single pass over the data
+//! \note the gradients along x (y) of the last column (row) are zero, so
+//! that the missing neighbours are replaced by the sample itself
+void calculateAndAddScaledDivergence(const float* inputData,
+                                     const PyramidS& C, float* divG)
+{
+    const int ROWS = C.getRows();
+    const int COLS = C.getCols();
+
+#pragma omp parallel for
+    for (int ky = 0; ky < ROWS; ky++)
+    {
+        const float* currLum = inputData + ky*COLS;
+        const float* nextLum = (ky < ROWS-1) ? currLum + COLS : currLum;
+        const float* prevLum = (ky > 0) ? currLum - COLS : currLum;
+        const XYGradient* currC = C.data() + ky*COLS;
+        const XYGradient* prevC = (ky > 0) ? currC - COLS : currC;
+        float* currDivG = divG + ky*COLS;
+
+        // kx = 0
+        float divGx = (COLS > 1) ? currC[0].gX()*(currLum[1] - currLum[0]) : 0.0f;
+        float divGy = currC[0].gY()*(nextLum[0] - currLum[0]) -
+                prevC[0].gY()*(currLum[0] - prevLum[0]);
+        currDivG[0] += divGx + divGy;
+
+        for (int kx = 1; kx < COLS-1; kx++)
+        {
+            divGx = currC[kx].gX()*(currLum[kx + 1] - currLum[kx]) -
+                    currC[kx - 1].gX()*(currLum[kx] - currLum[kx - 1]);
+            divGy = currC[kx].gY()*(nextLum[kx] - currLum[kx]) -
+                    prevC[kx].gY()*(currLum[kx] - prevLum[kx]);
+            currDivG[kx] += divGx + divGy;
+        }
+
+        // kx = COLS - 1
+        if (COLS > 1)
+        {
+            const int kx = COLS - 1;
+            divGx = -currC[kx - 1].gX()*(currLum[kx] - currLum[kx - 1]);
+            divGy = currC[kx].gY()*(nextLum[kx] - currLum[kx]) -
+                    prevC[kx].gY()*(currLum[kx] - prevLum[kx]);
+            currDivG[kx] += divGx + divGy;
+        }
+    }
+}
+
 namespace
 {
 //  static const float GFIXATE = 0.1f;
@@ -102,7 +102,9 @@ public:
     const_iterator end() const      { return m_pyramid.end(); }
 
     // builds a Pyramid
-    PyramidT(size_t rows, size_t cols);
+    //! \param arena arena supplying the levels and the temporaries of the
+    //! \c PyramidT (NULL: regular allocations)
+    PyramidT(size_t rows, size_t cols, pfs::BufferArena* arena = NULL);
 
     inline
     size_t getRows() const      { return m_rows; }
@@ -114,6 +116,9 @@ public:
     inline
     size_t numLevels() const    { return m_pyramid.size(); }
 
+    inline
+    pfs::BufferArena* arena() const { return m_arena; }
+
     //! \brief fill all the levels of the pyramid based on the data inside
     //! the supplied vector (same size of the first level of the \c PyramidT)
     //! \param[in] data input vector of data
@@ -122,6 +127,15 @@ public:
     //! \param[out] data input vector of data
     void computeSumOfDivergence(pfs::Array2Df& sumOfDivG);
 
+    //! \brief sum of the divergences of the gradients of \a x, scaled by the
+    //! levels of this \c PyramidT. Same result as computeGradients(),
+    //! multiply() and computeSumOfDivergence() on another \c PyramidT, without
+    //! storing the gradients
+    //! \param[in] x input vector of data
+    //! \param[out] sumOfDivG output vector (same size of \a x)
+    void computeSumOfScaledDivergence(const pfs::Array2Df& x,
+                                      pfs::Array2Df& sumOfDivG) const;
+
     //! \param[out] result PyramidT structure that contains the scaling factors!
     void computeScaleFactors(PyramidT& result) const;
 
@@ -143,23 +157,19 @@ private:
     size_t m_cols;
     //! \brief container of PyramidS
     PyramidContainer m_pyramid;
+    //! \brief arena of the temporaries (copies share it)
+    pfs::BufferArena* m_arena;
 };
 
 // free functions (mostly in the header file to improve testability)
-//! \brief downsample the image contained in \a inputData and stores the result
-//! inside \a outputData
-void matrixDownsample(size_t inCols, size_t inRows,
-                      const float* inputData, float* outputData);
-
-//! \brief upsample the image contained in \a inputData and stores the result
-//! inside \a outputData
-void matrixUpsample(size_t outCols, size_t outRows,
-                    const float* inputData, float* outputData);
-
 //! \brief compute X and Y gradients from \a inputData into \a gradient
 void calculateGradients(const float* inputData, PyramidS& gradient);
 //
 void calculateAndAddDivergence(const PyramidS& G, float* divG);
+//! \brief add to \a divG the divergence of the gradients of \a inputData
+//! scaled by \a C, computing the gradients on the fly
+void calculateAndAddScaledDivergence(const float* inputData,
+                                     const PyramidS& C, float* divG);
 
 //! \brief compute a scale factor based on the input \a g value
 float calculateScaleFactor(float g);
@@ -52,7 +52,9 @@
 
 #include "Libpfs/progress.h"
 #include "Libpfs/array2d.h"
-#include "Libpfs/utils/sse.h"
+#include "Libpfs/bufferarena.h"
+#include "Libpfs/manip/pyramid.h"
+#include "Libpfs/utils/numeric.h"
 
 #ifdef BRANCH_PREDICTION
 #define likely(x)       __builtin_expect((x),1)
@@ -154,19 +156,6 @@ static inline float safe_log10( float x, const float min_x = MIN_PHVAL, const fl
   else return log10( x );
 }
 
-#ifdef LUMINANCE_USE_SSE
-
-#define LOG2_10 3.3219280948874f
-#define LOG2_10__1 (1.0f/LOG2_10)
-static inline v4sf safe_log10( v4sf x, const float min_x = MIN_PHVAL, const float max_x = MAX_PHVAL )
-{
-  x = _mm_max_ps(x, _mm_set1_ps(min_x));
-  x = _mm_min_ps(x, _mm_set1_ps(max_x));
-  return _mm_log2_ps(x) * _mm_set1_ps(LOG2_10__1);
-}
-
-#endif
-
 /**
  * Find the lowest non-zero value. Used to avoid log10(0).
  */
@@ -282,64 +271,13 @@ static void dumpPFS( const char *fileName, const int width, const int height, fl
 #endif
 
 
-static void compute_gaussian_level( const int width, const int height,
-                                    const pfs::Array2Df& in, pfs::Array2Df& out, int level, pfs::Array2Df& temp )
+static void compute_gaussian_level( const pfs::Array2Df& in, pfs::Array2Df& out, int level,
+                                    pfs::BufferArena* arena )
 {
-
-  const float kernel_a = 0.4f;
-
-  const int kernel_len = 5;
-  const int kernel_len_2 = kernel_len/2;
-  const float kernel[kernel_len] = { 0.25f - kernel_a/2.f,
-                                     0.25f,
-                                     kernel_a,
-                                     0.25f,
-                                     0.25f - kernel_a/2.f };
-
-  const int step = 1<<level;
-
-  // FIXME: without the following (with using operator () ) there
-  // seems to be a performance drop - need to investigate if gcc can
-  // be made to optimize this better.  If this can't be made faster
-  // with using the overloaded operator then this optimization should
-  // be applied to the other TMOs as well.
-  const float* in_raw = in.data();
-  float* temp_raw = temp.data();
-  float* out_raw = out.data();
-
-  // Filter rows
-#pragma omp parallel for default(none) shared(in_raw, temp_raw, kernel)
-  for( int r=0; r < height; r++ ) {
-    for( int c=0; c < width; c++ ) {
-      float sum = 0;
-      for( int j=0; j< kernel_len; j++ ) {
-        int l = (j-kernel_len_2)*step+c;
-        if( unlikely( l < 0 ) )
-          l = -l;
-        if( unlikely( l >= width ) )
-          l = 2*width - 2 - l;
-        sum += in_raw[r*width+l] * kernel[j];
-      }
-      temp_raw[r*width+c] = sum;
-    }
-  }
-
-  // Filter columns
-#pragma omp parallel for default(none) shared(temp_raw, out_raw, kernel)
-  for( int c=0; c < width; c++ ) {
-    for( int r=0; r < height; r++ ) {
-      float sum = 0;
-      for( int j=0; j< kernel_len; j++ ) {
-        int l = (j-kernel_len_2)*step+r;
-        if( unlikely(l < 0) )
-          l = -l;
-        if( unlikely(l >= height) )
-          l = 2*height - 2 - l;
-        sum += temp_raw[l*width+c] * kernel[j];
-      }
-      out_raw[r*width+c] = sum;
-    }
-  }
+  // a trous filter: the taps of the 5 samples kernel are 2^level apart, and
+  // the image is mirrored at the borders
+  pfs::separableFilter( in, out, pfs::PyramidKernel::burtAdelson( 0.4f ),
+                        pfs::BORDER_MIRROR, 1, size_t(1)<<level, arena );
 }
 
 static inline float clamp_channel( const float v )
@@ -358,7 +296,7 @@ class conditional_density: public datmoConditionalDensity
 {
 public:
   static const double l_min, l_max, delta;
-  static double x_scale[X_COUNT];    // input log luminance scale
+  const double *x_scale;    // input log luminance scale
   double *g_scale;    // contrast scale
   double *f_scale;    // frequency scale
 
@@ -392,10 +330,7 @@ public:
     C = new double[x_count*g_count*f_count];
     memset( C, 0, x_count*g_count*f_count*sizeof(double) );
 
-    if( x_scale[0] == 0 ) {
-      for( int i=0; i<x_count; i++ )
-        x_scale[i] = l_min + delta*i;
-    }
+    x_scale = input_scale();
 
     for( int i=0; i<g_count; i++ )
       g_scale[i] = -g_max + delta*i;
@@ -412,6 +347,10 @@ public:
     delete []f_scale;
   }
 
+  // the scale is shared by all the instances: the tone curves keep
+  // pointing to it after the conditional density is released
+  static const double* input_scale();
+
   double& operator()( int x, int g, int f )
   {
     assert( (x + g*x_count + f*x_count*g_count >= 0) && (x + g*x_count + f*x_count*g_count < x_count*g_count*f_count) );
@@ -425,7 +364,20 @@ datmoConditionalDensity::~datmoConditionalDensity()
 }
 
 const double conditional_density::l_min = -8.f, conditional_density::l_max = 8.f, conditional_density::delta = 0.1f;
-double conditional_density::x_scale[X_COUNT] = { 0 };    // input log luminance scale
+
+const double* conditional_density::input_scale()
+{
+  // initialized once, also when several threads get here at the same time
+  static const struct Scale {
+    Scale()
+    {
+      for( int i=0; i<X_COUNT; i++ )
+        x[i] = l_min + delta*i;
+    }
+    double x[X_COUNT];
+  } scale;
+  return scale.x;
+}
 
 
 std::unique_ptr<datmoConditionalDensity> datmo_compute_conditional_density( int width, int height, const float *L, pfs::Progress &ph)
@@ -434,7 +386,7 @@ std::unique_ptr<datmoConditionalDensity> datmo_compute_conditional_density( int
 
   pfs::Array2Df buf_1(width, height);
   pfs::Array2Df buf_2(width, height);
-  pfs::Array2Df temp(width, height);
+  pfs::BufferArena arena;
 
   std::unique_ptr<conditional_density> C(new conditional_density());
 
@@ -450,23 +402,16 @@ std::unique_ptr<datmoConditionalDensity> datmo_compute_conditional_density( int
 
   // Compute log10 of an image
 #pragma omp parallel for default(none) shared(LP_high_raw, L)
-#ifndef LUMINANCE_USE_SSE
   for( int i=0; i < pix_count; i++ )
-    LP_high_raw[i] = safe_log10( L[i], min_val );
-#else
-  for( int i=0; i < pix_count-3; i+=4 )
-    _mm_store_ps(&LP_high_raw[i], safe_log10( _mm_load_ps(&L[i]), min_val ));
-  // In case pix_count%4 > 0
-  for( int i=pix_count-3; i < pix_count; i++ )
-    LP_high_raw[i] = safe_log10( L[i], min_val );
-#endif
+    LP_high_raw[i] = std::min( std::max( L[i], min_val ), MAX_PHVAL );
+  pfs::utils::vlog10( LP_high_raw, LP_high_raw, pix_count );
 
   bool warn_out_of_range = false;
   C->total = 0;
 
   for( int f=0; f<C->f_count; f++ ) {
 
-    compute_gaussian_level( width, height, *LP_high, *LP_low, f, temp );
+    compute_gaussian_level( *LP_high, *LP_low, f, &arena );
 
 // For debug purposes only
 #ifdef DEBUG
@@ -1083,22 +1028,9 @@ int datmo_apply_tone_curve_cc( float *R_out, float *G_out, float *B_out, int wid
     float L_fix = clamp_channel(L_in[i]);
     const float L_out = tc_lut.interp( log10(L_fix) );
     const float s = cc_lut.interp( log10(L_fix) ); // color correction
-#ifdef LUMINANCE_USE_SSE
-    v4sf vec = _mm_set_ps(R_in[i], G_in[i], B_in[i], 0) / _mm_set1_ps(L_fix);
-    vec = _mm_max_ps(vec, _mm_set1_ps(MIN_PHVAL));
-    vec = _mm_pow_ps(vec, _mm_set1_ps(s));
-    vec = vec * _mm_set1_ps(L_out);
-    vec = df->inv_display(vec);
-    float tmp[4];
-    _mm_store_ps(tmp, vec);
-    R_out[i] = tmp[3];
-    G_out[i] = tmp[2];
-    B_out[i] = tmp[1];
-#else
     R_out[i] = df->inv_display(powf(clamp_channel(R_in[i]/L_fix), s) * L_out);
     G_out[i] = df->inv_display(powf(clamp_channel(G_in[i]/L_fix), s) * L_out);
     B_out[i] = df->inv_display(powf(clamp_channel(B_in[i]/L_fix), s) * L_out);
-#endif
   }
 
   return PFSTMO_OK;
@@ -1134,6 +1066,12 @@ datmoTCFilter::datmoTCFilter( float fps, float y_min, float y_max ) :
   sz = 0;
 }
 
+datmoSequenceState::datmoSequenceState( float fps ) :
+  fps( fps <= 27.5f ? 25.f : (fps <= 45.f ? 30.f : 60.f) ),
+  tc_x_i( NULL ), l_mean( 0 ), l_std( 0 ), frames_reused( 0 )
+{
+}
+
 datmoToneCurve *datmoTCFilter::getToneCurvePtr()
 {
   pos++;
@@ -29,6 +29,9 @@
  * $Id: display_adaptive_tmo.h,v 1.12 2009/02/23 18:46:36 rafm Exp $
  */
 
+#include <memory>
+#include <vector>
+
 #include "display_function.h"
 #include "display_size.h"
 
@@ -99,6 +102,33 @@ public:
 };
 
 
+/**
+ * State of pfstmo_mantiuk08() carried across the frames of a video
+ * sequence: the temporal filter of the tone-curves and the last computed
+ * tone-curve. The curve is reused, without analysing the frame again, as
+ * long as the log-luminance statistics of the scene stay close to the ones
+ * of the frame it was computed for.
+ */
+struct datmoSequenceState
+{
+  /**
+   * @param fps - frames per second of the sequence, rounded to the closest
+   * rate supported by datmoTCFilter
+   */
+  datmoSequenceState( float fps );
+
+  float fps;
+  std::unique_ptr<datmoTCFilter> tc_filter;
+
+  // tone-curve of the last analysed frame (empty if none) and statistics
+  // of that frame: mean and standard deviation of log10 luminance
+  std::vector<double> tc_y_i;
+  const double *tc_x_i;
+  double l_mean, l_std;
+
+  size_t frames_reused;   /* frames that reused the cached tone-curve */
+};
+
 class datmoConditionalDensity
 {
 public:
@@ -93,24 +93,6 @@ float DisplayFunctionGGBA::display( float pix )
   return pow( pix, gamma ) * (L_max-L_black) + L_offset;
 }
 
-#ifdef LUMINANCE_USE_SSE
-
-v4sf DisplayFunctionGGBA::inv_display( v4sf L )
-{
-  const v4sf voffset = _mm_set1_ps(L_offset);
-  const v4sf vmax = _mm_set1_ps(L_max);
-  L = _mm_max_ps(L, voffset);
-  L = _mm_min_ps(L, voffset+vmax);
-  return _mm_pow_ps((L - voffset)/(vmax-_mm_set1_ps(L_black)), _mm_set1_ps(1.0f/gamma));
-}
-
-v4sf DisplayFunctionGGBA::display( v4sf pix )
-{
-  return _mm_pow_ps(pix, _mm_set1_ps(gamma)) * (_mm_set1_ps(L_max)-_mm_set1_ps(L_black)) + _mm_set1_ps(L_offset);
-}
-
-#endif
-
 // ========== LUT Display Function ==============
 
 static const int max_lut_size = 4096;
@@ -35,7 +35,6 @@
 #include <cstdio>
 
 #include "arch/math.h"
-#include "Libpfs/utils/sse.h"
 #include <Libpfs/exception.h>
 
 class DisplayFunction
@@ -49,11 +48,6 @@ public:
    */
   virtual float display( float pix ) = 0;
 
-#ifdef LUMINANCE_USE_SSE
-  virtual v4sf inv_display( v4sf L ) = 0;
-  virtual v4sf display( v4sf L ) = 0;
-#endif
-
   virtual void print( FILE *fh ) = 0;
 
   virtual ~DisplayFunction()
@@ -77,11 +71,6 @@ public:
   float inv_display( float L );
   float display( float pix );
 
-#ifdef LUMINANCE_USE_SSE
-  virtual v4sf inv_display( v4sf L );
-  virtual v4sf display( v4sf L );
-#endif
-
   void print( FILE *fh );
 
 private:
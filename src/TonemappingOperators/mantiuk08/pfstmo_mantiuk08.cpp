@@ -29,6 +29,7 @@
  * $Id: pfstmo_mantiuk08.cpp,v 1.12 2009/02/23 18:46:36 rafm Exp $
  */
 
+#include <algorithm>
 #include <iostream>
 #include <memory>
 #include <stdio.h>
@@ -43,7 +44,31 @@
 
 using namespace std;
 
-void pfstmo_mantiuk08(pfs::Frame& frame, float saturation_factor, float contrast_enhance_factor, float white_y, bool setluminance, pfs::Progress &ph)
+namespace
+{
+// largest change (in log10 units) of the mean and standard deviation of the
+// log-luminance that lets a sequence reuse the tone-curve of a previous frame
+const double SEQUENCE_STATISTICS_THRESHOLD = 0.01;
+
+void logLuminanceStatistics( const pfs::Array2Df& Y, double& l_mean, double& l_std )
+{
+  const long size = Y.size();
+  double sum = 0;
+  double sum2 = 0;
+#pragma omp parallel for reduction(+:sum,sum2)
+  for( long i = 0; i < size; i++ )
+  {
+    const double l = log10( std::max( Y(i), 1e-8f ) );
+    sum += l;
+    sum2 += l*l;
+  }
+  l_mean = sum / size;
+  l_std = sqrt( std::max( sum2 / size - l_mean*l_mean, 0. ) );
+}
+}
+
+void pfstmo_mantiuk08(pfs::Frame& frame, float saturation_factor, float contrast_enhance_factor, float white_y, bool setluminance, pfs::Progress &ph,
+                      datmoSequenceState* sequence_state)
 {
   //--- default tone mapping parameters;
   //float contrast_enhance_factor = 1.f;
@@ -85,21 +110,23 @@ void pfstmo_mantiuk08(pfs::Frame& frame, float saturation_factor, float contrast
   ds->print( stderr );
 #endif
 
-  pfs::Channel *inX, *inY, *inZ;
-  frame.getXYZChannels(inX, inY, inZ);
+  pfs::Channel *inR, *inG, *inB;
+  frame.getXYZChannels(inR, inG, inB);
 
-  if ( !inX || !inY || !inZ )
+  if ( !inR || !inG || !inB )
   {
       if (df != NULL)
           delete df;
-      throw pfs::Exception( "Missing X, Y, Z channels in the PFS stream" );
+      throw pfs::Exception( "Missing R, G, B channels in the PFS stream" );
   }
 
   const int cols = frame.getWidth();
   const int rows = frame.getHeight();
 
-  pfs::Array2Df R( cols, rows );
-  pfs::transformColorSpace(pfs::CS_XYZ, inX, inY, inZ, pfs::CS_RGB, inX, &R, inZ);
+  // the tone curve is computed on luminance, but the frame is tone-mapped
+  // in RGB: only Y is derived, instead of converting the frame to XYZ and back
+  pfs::Array2Df Y( cols, rows );
+  pfs::transformRGB2Y(inR, inG, inB, &Y);
 
   if( white_y == -2.f )
   {
@@ -128,32 +155,72 @@ void pfstmo_mantiuk08(pfs::Frame& frame, float saturation_factor, float contrast
   }
 */
 
-  std::unique_ptr<datmoConditionalDensity> C = datmo_compute_conditional_density( cols, rows, inY->data(), ph);
-  if( C.get() == NULL )
+  // a sequence keeps filtering the tone-curves of its previous frames
+  std::unique_ptr<datmoTCFilter> still_filter;
+  datmoTCFilter *rc_filter;
+  if( sequence_state == NULL )
   {
-    delete df;
-    delete ds;
-    throw pfs::Exception("failed to analyse the image");
+    still_filter.reset( new datmoTCFilter( fps, log10(df->display(0)), log10(df->display(1)) ) );
+    rc_filter = still_filter.get();
+  }
+  else
+  {
+    if( sequence_state->tc_filter.get() == NULL )
+      sequence_state->tc_filter.reset( new datmoTCFilter( sequence_state->fps, log10(df->display(0)), log10(df->display(1)) ) );
+    rc_filter = sequence_state->tc_filter.get();
   }
-
-  datmoTCFilter rc_filter( fps, log10(df->display(0)), log10(df->display(1)) );
 
   //datmoToneCurve tc;
-  datmoToneCurve *tc = rc_filter.getToneCurvePtr();
+  datmoToneCurve *tc = rc_filter->getToneCurvePtr();
 
-  int res;
-  res = datmo_compute_tone_curve( tc, C.get(), df, ds, contrast_enhance_factor, white_y, visual_model, scene_l_adapt, ph);
-  if( res != PFSTMO_OK )
+  double l_mean = 0, l_std = 0;
+  bool reuse_tc = false;
+  if( sequence_state != NULL )
   {
-    delete df;
-    delete ds;
-    throw pfs::Exception( "failed to compute the tone-curve" );
+    logLuminanceStatistics( Y, l_mean, l_std );
+    reuse_tc = !sequence_state->tc_y_i.empty() &&
+      fabs( l_mean - sequence_state->l_mean ) < SEQUENCE_STATISTICS_THRESHOLD &&
+      fabs( l_std - sequence_state->l_std ) < SEQUENCE_STATISTICS_THRESHOLD;
+  }
+
+  if( reuse_tc )
+  {
+    tc->init( sequence_state->tc_y_i.size(), sequence_state->tc_x_i );
+    std::copy( sequence_state->tc_y_i.begin(), sequence_state->tc_y_i.end(), tc->y_i );
+    sequence_state->frames_reused++;
+  }
+  else
+  {
+    std::unique_ptr<datmoConditionalDensity> C = datmo_compute_conditional_density( cols, rows, Y.data(), ph);
+    if( C.get() == NULL )
+    {
+      delete df;
+      delete ds;
+      throw pfs::Exception("failed to analyse the image");
+    }
+
+    int res;
+    res = datmo_compute_tone_curve( tc, C.get(), df, ds, contrast_enhance_factor, white_y, visual_model, scene_l_adapt, ph);
+    if( res != PFSTMO_OK )
+    {
+      delete df;
+      delete ds;
+      throw pfs::Exception( "failed to compute the tone-curve" );
+    }
+
+    if( sequence_state != NULL )
+    {
+      sequence_state->tc_y_i.assign( tc->y_i, tc->y_i + tc->size );
+      sequence_state->tc_x_i = tc->x_i;
+      sequence_state->l_mean = l_mean;
+      sequence_state->l_std = l_std;
+    }
   }
 
-  datmoToneCurve *tc_filt = rc_filter.filterToneCurve();
+  datmoToneCurve *tc_filt = rc_filter->filterToneCurve();
 
-  res = datmo_apply_tone_curve_cc( inX->data(), R.data(), inZ->data(),
-          cols, rows, inX->data(), R.data(), inZ->data(), inY->data(), tc_filt, df, saturation_factor );
+  int res = datmo_apply_tone_curve_cc( inR->data(), inG->data(), inB->data(),
+          cols, rows, inR->data(), inG->data(), inB->data(), Y.data(), tc_filt, df, saturation_factor );
   if( res != PFSTMO_OK )
   {
     delete df;
@@ -161,7 +228,6 @@ void pfstmo_mantiuk08(pfs::Frame& frame, float saturation_factor, float contrast
     throw pfs::Exception( "failed to tone-map the image" );
   }
 
-  pfs::transformColorSpace( pfs::CS_RGB, inX, &R, inZ, pfs::CS_XYZ, inX, inY, inZ );
   frame.getTags().setTag("LUMINANCE", "DISPLAY");
 
   if ( !ph.canceled() )
@@ -36,6 +36,7 @@
 #include <iostream>
 #include <cmath>
 #include <algorithm>
+#include <memory>
 
 #include "Libpfs/frame.h"
 #include "Libpfs/colorspace/colorspace.h"
@@ -60,15 +61,18 @@ void multiplyChannels( pfs::Array2Df& X, pfs::Array2Df& Y, pfs::Array2Df& Z, flo
 void pfstmo_pattanaik00(pfs::Frame& frame,
                         bool local, float multiplier,
                         float Acone, float Arod, bool autolum,
-                        pfs::Progress &ph)
+                        pfs::Progress &ph,
+                        VisualAdaptationModel* sequence_model, float dt)
 {
     //--- default tone mapping parameters;
-    const bool timedependence = false;
     //bool local = false;
     //float multiplier = 1.0f;
     //Acone = -1.0f;
     //Arod  = -1.0f;
-    float fps = 16.0f; //not used
+    // the first frame of a sequence starts from the adaptation of a still
+    // image, the following ones adapt to the scene over dt seconds. Without
+    // autolum the adaptation is the one set by the user on every frame
+    const bool timedependence = (sequence_model != NULL && dt > 0.0f);
 
 #ifndef NDEBUG
     std::cout << "pfstmo_pattanaik00 (";
@@ -76,10 +80,17 @@ void pfstmo_pattanaik00(pfs::Frame& frame,
     std::cout << "multiplier: " << multiplier << ", ";
     std::cout << "Acone: " << Acone << ", ";
     std::cout << "Arod: " << Arod << ", ";
-    std::cout << "autolum: " << autolum << ")" << std::endl;
+    std::cout << "autolum: " << autolum << ", ";
+    std::cout << "dt: " << dt << ")" << std::endl;
 #endif
 
-    std::unique_ptr<VisualAdaptationModel> am(new VisualAdaptationModel());
+    std::unique_ptr<VisualAdaptationModel> still_model;
+    VisualAdaptationModel* am = sequence_model;
+    if ( am == NULL )
+    {
+        still_model.reset(new VisualAdaptationModel());
+        am = still_model.get();
+    }
 
     pfs::Channel *X, *Y, *Z;
     frame.getXYZChannels( X, Y, Z );
@@ -98,15 +109,12 @@ void pfstmo_pattanaik00(pfs::Frame& frame,
 
     if( !local )
     {
-        if( !timedependence )
-        {
-            if( !autolum )
-                am->setAdaptation(Acone, Arod);
-            else
-                am->setAdaptation(*Y);
-        }
+        if( !autolum )
+            am->setAdaptation(Acone, Arod);
+        else if( !timedependence )
+            am->setAdaptation(*Y);
         else
-            am->calculateAdaptation(*Y, 1.0f/fps);
+            am->calculateAdaptation(*Y, dt);
     }
     // tone mapping
     int w = Y->getWidth();
@@ -117,7 +125,7 @@ void pfstmo_pattanaik00(pfs::Frame& frame,
     pfs::Array2Df B(w,h);
 
     pfs::transformColorSpace( pfs::CS_XYZ, X, Y, Z, pfs::CS_RGB, &R, &G, &B );
-    tmo_pattanaik00( R, G, B, *Y, am.get(), local, ph );
+    tmo_pattanaik00( R, G, B, *Y, am, local, ph );
     pfs::transformColorSpace( pfs::CS_RGB, &R, &G, &B, pfs::CS_XYZ, X, Y, Z );
 
     if (!ph.canceled())
@@ -31,7 +31,9 @@
  * $Id: tmo_pattanaik00.cpp,v 1.3 2008/11/04 23:43:08 rafm Exp $
  */
 
+#include <algorithm>
 #include <cmath>
+#include <vector>
 
 #include "tmo_pattanaik00.h"
 
@@ -39,9 +41,10 @@
 #include "Libpfs/pfs.h"
 #include "Libpfs/array2d.h"
 #include "Libpfs/progress.h"
+#include "Libpfs/utils/numeric.h"
 
 /// sensitivity of human visual system
-float n = 0.73f;
+const float n = 0.73f;
 
 float sigma_response_rod(float I);
 float sigma_response_cone(float I);
@@ -51,54 +54,118 @@ namespace
 {
 const float LOG5 = std::log(5.f);
 
+//! size and range of the table of EdgeStoppingWeight
+const int WEIGHT_LUT_SIZE = 1024;
+const float WEIGHT_LUT_RANGE = 2.2f;
+
+//! \brief edge-stopping weight exp(-d^6) of the local adaptation, tabulated
+//! for d in [0, WEIGHT_LUT_RANGE[ and linearly interpolated. Beyond the
+//! range the weight underflows in single precision.
+class EdgeStoppingWeight
+{
+public:
+    EdgeStoppingWeight()
+        : m_lut(WEIGHT_LUT_SIZE + 2, 0.f)
+    {
+        for (int i = 0; i <= WEIGHT_LUT_SIZE; ++i)
+        {
+            m_lut[i] = std::exp(-std::pow(i*(WEIGHT_LUT_RANGE/WEIGHT_LUT_SIZE), 6.0f));
+        }
+    }
+
+    //! \param d absolute difference of log-luminance; NaN gives zero weight
+    float operator()(float d) const
+    {
+        if ( !(d < WEIGHT_LUT_RANGE) ) return 0.f;
+
+        const float p = d*(WEIGHT_LUT_SIZE/WEIGHT_LUT_RANGE);
+        const int i = static_cast<int>(p);
+        return m_lut[i] + (p - i)*(m_lut[i+1] - m_lut[i]);
+    }
+
+private:
+    std::vector<float> m_lut;
+};
+
 /**
- * @brief Calculate local adaptation for specified pixel coordinates
+ * @brief Calculate local adaptation for all the pixels
  *
  * Calculation based on article "Adaptive Gain Control" by Pattanaik
- * 2002.
+ * 2002: every pixel is adapted to the average of a disk of radius 4 around
+ * it, weighted by the similarity of the log-luminance.
+ *
+ * The log-luminance is computed once; each row accumulates the disk tap by
+ * tap over contiguous spans of pixels, and rows are processed in parallel.
  *
  * @param Y luminance map
- * @param x x-coordinate of pixel
- * @param y x-coordinate of pixel
- * @param Acone [out] calculated adaptation for cones
- * @param Arod [out] calculated adaptation for rods
+ * @param A [out] calculated adaptation for cones and rods
+ * @return false if the computation has been canceled
  */
-void calculateLocalAdaptation(const pfs::Array2Df& Y, int x, int y, float& Acone, float& Arod)
+bool calculateLocalAdaptation(const pfs::Array2Df& Y, pfs::Array2Df& A,
+                              pfs::Progress &ph)
 {
-    int width = Y.getCols();
-    int height = Y.getRows();
+    const int width = Y.getCols();
+    const int height = Y.getRows();
+    const int kernel_size = 4;
+    const int band = 64;
 
-    int kernel_size = 4;
+    static const EdgeStoppingWeight weight;
 
-    float logLc = std::log(Y(x,y))/LOG5;
+    pfs::Array2Df logY(width, height);
+    pfs::utils::vlog(Y.data(), logY.data(), Y.size());
+    pfs::utils::vsmul(logY.data(), 1.f/LOG5, logY.data(), Y.size());
 
-    float pix_num = 0.0;
-    float pix_sum = 0.0;
-    for ( int kx = -kernel_size ; kx <= kernel_size ; kx++ )
-        for ( int ky = -kernel_size ; ky <= kernel_size ; ky++ )
-            if ( (kx*kx+ky*ky)<=(kernel_size*kernel_size) &&
-                    x+kx>0 && x+kx<width && y+ky>0 && y+ky<height )
+    for ( int y0 = 0 ; y0 < height ; y0 += band )
+    {
+        ph.setValue(50*y0/height);
+        if (ph.canceled())
+            return false;
+
+        const int y1 = std::min(height, y0 + band);
+#pragma omp parallel
+        {
+            std::vector<float> pix_sum(width);
+            std::vector<float> pix_num(width);
+
+#pragma omp for schedule(static)
+            for ( int y = y0 ; y < y1 ; y++ )
             {
-                float L = Y(x+kx,y+ky);
-                float w = std::exp(
-                            -std::pow(
-                                std::fabs(
-                                    std::log(L)/LOG5-logLc
-                                    ), 6.0f
-                                )
-                            );
-                pix_sum +=  w*L;
-                pix_num +=  w;
+                std::fill(pix_sum.begin(), pix_sum.end(), 0.f);
+                std::fill(pix_num.begin(), pix_num.end(), 0.f);
+
+                const float* logLc = logY.data() + y*width;
+                for ( int ky = -kernel_size ; ky <= kernel_size ; ky++ )
+                {
+                    // the first row and column are left out of the disk
+                    if ( y+ky <= 0 || y+ky >= height )
+                        continue;
+
+                    for ( int kx = -kernel_size ; kx <= kernel_size ; kx++ )
+                    {
+                        if ( (kx*kx+ky*ky) > (kernel_size*kernel_size) )
+                            continue;
+
+                        const float* L = Y.data() + (y+ky)*width + kx;
+                        const float* logL = logY.data() + (y+ky)*width + kx;
+                        const int xBegin = std::max(0, 1 - kx);
+                        const int xEnd = std::min(width, width - kx);
+                        for ( int x = xBegin ; x < xEnd ; x++ )
+                        {
+                            const float w = weight(std::fabs(logL[x] - logLc[x]));
+                            pix_sum[x] += w*L[x];
+                            pix_num[x] += w;
+                        }
+                    }
+                }
+
+                for ( int x = 0 ; x < width ; x++ )
+                {
+                    A(x,y) = (pix_num[x] > 0.0f) ? (pix_sum[x] / pix_num[x]) : Y(x,y);
+                }
             }
-
-    if ( pix_num > 0.0 )
-    {
-        Acone = Arod = (pix_sum / pix_num);
-    }
-    else
-    {
-        Acone = Arod = Y(x,y);
+        }
     }
+    return true;
 }
 }
 
@@ -203,12 +270,24 @@ void tmo_pattanaik00(pfs::Array2Df& R, pfs::Array2Df& G, pfs::Array2Df& B,
 
     int im_width = Y.getCols();
     int im_height = Y.getRows();
-    for ( int x=0 ; x < im_width ; x++ )
+
+    /// local adaptation of cones and rods, precalculated for every pixel
+    pfs::Array2Df A;
+    int progress_offset = 0;
+    if ( local )
+    {
+        A.resize(im_width, im_height);
+        if ( !calculateLocalAdaptation(Y, A, ph) )
+            return;
+        progress_offset = 50;
+    }
+
+    for ( int y=0 ; y < im_height ; y++ )
     {
-        ph.setValue(100*x/im_width);
+        ph.setValue(progress_offset + (100-progress_offset)*y/im_height);
         if (ph.canceled())
             break;
-        for ( int y=0 ; y < im_height ; y++ )
+        for ( int x=0 ; x < im_width ; x++ )
         {
             float l = Y(x,y);
             float r = R(x,y)/l;
@@ -217,7 +296,7 @@ void tmo_pattanaik00(pfs::Array2Df& R, pfs::Array2Df& G, pfs::Array2Df& B,
 
             if ( local )
             {
-                calculateLocalAdaptation(Y,x,y,Acone,Arod);
+                Acone = Arod = A(x,y);
                 Bcone = 2e6/(2e6+Acone);
                 Brod = 0.04f/(0.04f+Arod);
 
@@ -29,12 +29,22 @@
 #ifndef PFSTMO_H
 #define PFSTMO_H
 
+#include <cstddef>
+
 namespace pfs
 {
+class BufferArena;
 class Frame;
 class Progress;
 }
 
+// state carried across the frames of a sequence
+class VisualAdaptationModel;
+struct Reinhard02TemporalState;
+struct datmoSequenceState;
+// stages kept across the calls on the same frame
+struct Mantiuk06Session;
+
 #ifdef BRANCH_PREDICTION
 #define likely(x)       __builtin_expect((x),1)
 #define unlikely(x)     __builtin_expect((x),0)
@@ -50,14 +60,14 @@ class Progress;
 
 void pfstmo_ashikhmin02(pfs::Frame& frame, bool simple_flag, float lc_value, int eq, pfs::Progress &ph);
 void pfstmo_drago03(pfs::Frame& frame, float biasValue, pfs::Progress& ph);
-void pfstmo_durand02(pfs::Frame& frame, float sigma_s, float sigma_r, float baseContrast, pfs::Progress &ph);
-void pfstmo_fattal02(pfs::Frame& frame, float opt_alpha, float opt_beta, float opt_saturation, float opt_noise, bool newfattal, bool fftsolver, int detail_level, pfs::Progress &ph);
+void pfstmo_durand02(pfs::Frame& frame, float sigma_s, float sigma_r, float baseContrast, pfs::Progress &ph, pfs::BufferArena* arena = NULL);
+void pfstmo_fattal02(pfs::Frame& frame, float opt_alpha, float opt_beta, float opt_saturation, float opt_noise, bool newfattal, bool fftsolver, int detail_level, pfs::Progress &ph, pfs::BufferArena* arena = NULL);
 void pfstmo_ferradans11(pfs::Frame& frame, float opt_rho, float opt_inv_alpha, pfs::Progress &ph);
 void pfstmo_mai11(pfs::Frame& frame, pfs::Progress &ph);
-void pfstmo_mantiuk06(pfs::Frame& frame, float scaleFactor, float saturationFactor, float detailFactor, bool cont_eq, pfs::Progress &ph);
-void pfstmo_mantiuk08(pfs::Frame& frame, float saturation_factor, float contrast_enhance_factor, float white_y, bool setluminance, pfs::Progress &ph);
-void pfstmo_pattanaik00(pfs::Frame& frame, bool local, float multiplier, float Acone, float Arod, bool autolum, pfs::Progress &ph);
-void pfstmo_reinhard02 (pfs::Frame& frame, float key, float phi, int num, int low, int high, bool use_scales, pfs::Progress &ph);
+void pfstmo_mantiuk06(pfs::Frame& frame, float scaleFactor, float saturationFactor, float detailFactor, bool cont_eq, pfs::Progress &ph, pfs::BufferArena* arena = NULL, Mantiuk06Session* session = NULL);
+void pfstmo_mantiuk08(pfs::Frame& frame, float saturation_factor, float contrast_enhance_factor, float white_y, bool setluminance, pfs::Progress &ph, datmoSequenceState* sequence_state = NULL);
+void pfstmo_pattanaik00(pfs::Frame& frame, bool local, float multiplier, float Acone, float Arod, bool autolum, pfs::Progress &ph, VisualAdaptationModel* sequence_model = NULL, float dt = 0.f);
+void pfstmo_reinhard02 (pfs::Frame& frame, float key, float phi, int num, int low, int high, bool use_scales, pfs::Progress &ph, Reinhard02TemporalState* temporal_state = NULL);
 void pfstmo_reinhard05(pfs::Frame& frame, float brightness, float chromaticadaptation, float lightadaptation, pfs::Progress &ph);
 
 #endif
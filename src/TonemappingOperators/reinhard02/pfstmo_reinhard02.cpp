@@ -40,7 +40,8 @@
 #include "Libpfs/progress.h"
 #include "tmo_reinhard02.h"
 
-void pfstmo_reinhard02(pfs::Frame& frame, float key, float phi, int num, int low, int high, bool use_scales, pfs::Progress &ph )
+void pfstmo_reinhard02(pfs::Frame& frame, float key, float phi, int num, int low, int high, bool use_scales, pfs::Progress &ph,
+                       Reinhard02TemporalState* temporal_state)
 {
   //--- default tone mapping parameters;
   //float key = 0.18;
@@ -49,7 +50,6 @@ void pfstmo_reinhard02(pfs::Frame& frame, float key, float phi, int num, int low
   //int low = 1;
   //int high = 43;
   //bool use_scales = false;
-  bool temporal_coherent = false;
 #ifndef NDEBUG
   std::cout << "pfstmo_reinhard02 (";
   std::cout << "key: " << key;
@@ -57,7 +57,8 @@ void pfstmo_reinhard02(pfs::Frame& frame, float key, float phi, int num, int low
   std::cout << ", range: " << num;
   std::cout << ", lower scale: " << low;
   std::cout << ", upper scale: " << high;
-  std::cout << ", use scales: " << use_scales << ")" << std::endl;
+  std::cout << ", use scales: " << use_scales;
+  std::cout << ", temporal coherent: " << (temporal_state != NULL) << ")" << std::endl;
 #endif
   pfs::Channel *X, *Y, *Z;
   frame.getXYZChannels( X, Y, Z );
@@ -73,7 +74,7 @@ void pfstmo_reinhard02(pfs::Frame& frame, float key, float phi, int num, int low
   size_t h = Y->getHeight();
   pfs::Array2Df L(w, h);
 
-  Reinhard02 tmoperator( Y, &L, use_scales, key, phi, num, low, high, temporal_coherent, ph );
+  Reinhard02 tmoperator( Y, &L, use_scales, key, phi, num, low, high, temporal_state, ph );
 
   tmoperator.tmo_reinhard02();
 
@@ -26,6 +26,7 @@
 
 #include "Libpfs/progress.h"
 #include "Libpfs/array2d.h"
+#include "Libpfs/manip/pyramid.h"
 #include "TonemappingOperators/pfstmo.h"
 
 #define SIGMA_I(i)       (m_sigma_0 + ((double)i/(double)m_range)*(m_sigma_1 - m_sigma_0))
@@ -107,9 +108,9 @@ void Reinhard02::tonemap_image ()
     Lmax2 = m_white * m_white;
   else
   {
-    if( m_temporal_coherent ) {
-      m_max_luminance.set( get_maxvalue() );
-      Lmax2 = m_max_luminance.get();
+    if( m_temporal_state ) {
+      m_temporal_state->max_luminance.set( get_maxvalue() );
+      Lmax2 = m_temporal_state->max_luminance.get();
     } else Lmax2  = get_maxvalue();
     Lmax2 *= Lmax2;
   }
@@ -173,9 +174,9 @@ void Reinhard02::scale_to_midtone ()
   int    hh          = m_cvts.ymax >> 1;
 
   double avg;
-  if( m_temporal_coherent ) {
-    m_avg_luminance.set( log_average() );
-    avg = m_avg_luminance.get();
+  if( m_temporal_state ) {
+    m_temporal_state->avg_luminance.set( log_average() );
+    avg = m_temporal_state->avg_luminance.get();
   } else avg = log_average();
 
   scale_factor = 1.0 / avg;
@@ -266,12 +267,15 @@ void Reinhard02::dynamic_range ()
  * @param num number of scales to use in computation (default: 8)
  * @param low size in pixels of smallest scale (should be kept at 1)
  * @param high size in pixels of largest scale (default 1.6^8 = 43)
+ * @param temporal_state statistics smoothed across a sequence, or NULL
  */
 Reinhard02::Reinhard02(const pfs::Array2Df *Y, pfs::Array2Df* L,
                        bool use_scales, float key, float phi,
-                       int num, int low, int high, bool temporal_coherent,
+                       int num, int low, int high,
+                       Reinhard02TemporalState* temporal_state,
                        pfs::Progress &ph)
-    : m_width(Y->getCols())
+    : m_temporal_state(temporal_state)
+    , m_width(Y->getCols())
     , m_height(Y->getRows())
     , m_use_scales(use_scales)
     , m_use_border(false)
@@ -281,7 +285,6 @@ Reinhard02::Reinhard02(const pfs::Array2Df *Y, pfs::Array2Df* L,
     , m_range(num)
     , m_scale_low(low)
     , m_scale_high(high)
-    , m_temporal_coherent(temporal_coherent)
     , m_alpha(2.)
     , m_threshold(0.05)
     , m_ph(ph)
@@ -388,59 +391,16 @@ double Reinhard02::V1( int x, int y, int level )
   x01 = (x0 == size-1 ? x0 : x0+1);
   y01 = (y0 == size-1 ? y0 : y0+1);
 
-  return((1-s)*(1-t)*Pyramid[level][y0][x0] + s*(1-t)*Pyramid[level][y0][x01]
-          + (1-s)*t*Pyramid[level][y01][x0] + s*t*Pyramid[level][y01][x01]);
+  const pfs::Array2Df& slice = Pyramid[level];
+  return((1-s)*(1-t)*slice(x0,y0) + s*(1-t)*slice(x01,y0)
+          + (1-s)*t*slice(x0,y01) + s*t*slice(x01,y01));
 }
 
-/* PRE:  */
-double Reinhard02::pyramid_lookup( unsigned int x, unsigned int y, int level )
+void Reinhard02::build_pyramid( double **luminance, int image_width, int image_height )
 {
-  // int n, s;
-
-  /* Level 0 is a special case, the value is just the image */
-  if (level == 0) {
-    if ( (x < 0) || (y < 0) || (x >= m_width) || (y >= m_height) )
-      return(0.0);
-    else
-      return(m_luminance[y][x]);
-  }
-
-  /* Compute the size of the slice */
-  level--;
-  // n = 1 << level;
-  unsigned int s = PyramidWidth0 >> level;
-
-  //x = x >> level;
-  //y = y >> level;
-
-  if ( (x < 0) || (y < 0) || (x >= s) || (y >= s) )
-    return(0.0);
-  else
-    return(Pyramid[level][y][x]);
-}
-
-void Reinhard02::build_pyramid( double **/*luminance*/, int image_width, int image_height )
-{
-  int k;
   int x, y;
-  int i, j;
   int width;
   int max_dim;
-//    int height, pyramid_height;
-
-  double sum = 0;
-
-  double a = 0.4;
-  double b = 0.25;
-  double c = b - a/2;
-  double w[5];
-
-  /* Compute the "filter kernel" */
-  w[0] = c;
-  w[1] = b;
-  w[2] = a;
-  w[3] = w[1];
-  w[4] = w[0];
 
   /* Build the pyramid slices.  The bottom of the pyramid is the luminace  */
   /* image, and is not in the Pyramid array.                               */
@@ -455,68 +415,31 @@ void Reinhard02::build_pyramid( double **/*luminance*/, int image_width, int ima
   width = 1 << (PyramidHeight - 1);
   PyramidWidth0 = width;
 
-//  fprintf(stderr, "max_dim %d   height %d\n", max_dim, PyramidHeight);
-
-  /* Allocate the outer Pyramid array */
-  Pyramid = (double***) calloc(PyramidHeight, sizeof(double**));
-  if (!Pyramid) {
-    fprintf(stderr, "Unable to allocate pyramid array.\n");
-    exit(1);
-  }
+  pfs::Array2Df bottom(image_width, image_height);
+  for (y = 0; y < image_height; y++)
+    for (x = 0; x < image_width; x++)
+      bottom(x,y) = luminance[y][x];
 
-  /* Allocate and assign the Pyramid slices */
-  k = 0;
+  /* Each slice is the level below filtered by the 5x5 kernel of Burt and  */
+  /* Adelson (a = 0.4) on its even pixels, the level being zero outside.   */
+  /* The capacity is reserved, so that the slices are never moved.         */
+  const pfs::PyramidKernel kernel = pfs::PyramidKernel::burtAdelson(0.4f);
+  const pfs::Array2Df* below = &bottom;
 
+  Pyramid.clear();
+  Pyramid.reserve(PyramidHeight);
   while (width) {
-
-//    fprintf(stderr, "level %d, width = %d\n", k, width);
-
-    /* Allocate the slice */
-    Pyramid[k] = (double**) calloc(width, sizeof(double*));
-    if (!Pyramid[k]) {
-      fprintf(stderr, "Unable to allocate pyramid array.\n");
-      exit(1);
-    }
-    for (y = 0; y < width; y++) {
-      Pyramid[k][y] = (double*) calloc(width, sizeof(double));
-      if (!Pyramid[k][y]) {
-        fprintf(stderr, "Unable to allocate pyramid array.\n");
-        exit(1);
-      }
-    }
-
-    /* Compute the values in the slice */
-    for (y = 0; y < width; y++) {
-      for (x = 0; x < width; x++) {
-
-        sum = 0;
-        for (i = 0; i < 5; i++) {
-          for (j = 0; j < 5; j++) {
-            sum += w[i]*w[j]*pyramid_lookup(2*x + i - 2, 2*y + j - 2, k);
-          }
-        }
-        Pyramid[k][y][x] = sum;
-      }
-    }
+    Pyramid.emplace_back(width, width);
+    pfs::gaussianReduce(*below, Pyramid.back(), kernel, pfs::BORDER_ZERO);
+    below = &Pyramid.back();
 
     /* compute the width of the next slice */
     width /= 2;
-    k++;
   }
 }
 
 void Reinhard02::clean_pyramid()
 {
-  int k=0;
-  int width = PyramidWidth0;
-  while(width)
-  {
-    for( int y=0 ; y<width ; y++ )
-      free(Pyramid[k][y]);
-    free(Pyramid[k]);
-    k++;
-    width /= 2;
-  }
-  free(Pyramid);
+  Pyramid.clear();
 }
 
@@ -11,7 +11,9 @@
 #ifndef TMO_REINHARD02_H
 #define TMO_REINHARD02_H
 
-#include <Libpfs/array2d_fwd.h>
+#include <vector>
+
+#include <Libpfs/array2d.h>
 
 namespace pfs
 {
@@ -56,6 +58,16 @@ public:
   }
 };
 
+/**
+ * Statistics smoothed across the frames of a sequence, owned by the caller
+ * so that they outlive a single Reinhard02 instance
+ */
+struct Reinhard02TemporalState
+{
+  TemporalSmoothVariable<double> avg_luminance;
+  TemporalSmoothVariable<double> max_luminance;
+};
+
 //--- from defines.h
 typedef struct {
   int     xmax, ymax;     /* image dimensions */
@@ -90,13 +102,16 @@ typedef double  COLOR[3];       /* red, green, blue (or X,Y,Z) */
  * @param num number of scales to use in computation (default: 8)
  * @param low size in pixels of smallest scale (should be kept at 1)
  * @param high size in pixels of largest scale (default 1.6^8 = 43)
+ * @param temporal_state statistics carried across the frames of a sequence,
+ * or NULL to tone map a still image
  */
 class Reinhard02
 {
 public:
     Reinhard02(const pfs::Array2Df *Y, pfs::Array2Df *L,
                bool use_scales, float key, float phi,
-               int num, int low, int high, bool temporal_coherent,
+               int num, int low, int high,
+               Reinhard02TemporalState* temporal_state,
                pfs::Progress &ph);
 
     ~Reinhard02()
@@ -105,7 +120,7 @@ public:
     void tmo_reinhard02();
 
 private:
-    TemporalSmoothVariable<double> m_avg_luminance, m_max_luminance;
+    Reinhard02TemporalState* m_temporal_state;
     CVTS m_cvts;
     COLOR   **m_image;
     double m_sigma_0, m_sigma_1;
@@ -117,13 +132,12 @@ private:
     bool m_use_border;
     double m_key, m_phi, m_white;
     int m_range, m_scale_low, m_scale_high;
-    bool  m_temporal_coherent;
     const double m_alpha;
     double m_bbeta;
     double m_threshold;
     pfs::Progress &m_ph;
 
-    double ***Pyramid;
+    std::vector<pfs::Array2Df> Pyramid;
     int       PyramidHeight;
     int       PyramidWidth0;
 
@@ -140,7 +154,6 @@ private:
     void deallocate_memory();
     void dynamic_range();
     double V1(int, int, int);
-    double pyramid_lookup(unsigned int, unsigned int, int);
     void build_pyramid(double **, int, int);
     void clean_pyramid();
 };
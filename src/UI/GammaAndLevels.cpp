@@ -32,6 +32,8 @@
 #include "UI/GammaAndLevels.h"
 #include "ui_GammaAndLevels.h"
 
+#include <Libpfs/utils/histogram.h>
+
 namespace
 {
 static inline
@@ -42,6 +44,26 @@ int clamp(const float& v, const float& minV, const float& maxV)
     return (int)(v + 0.5f);
 }
 
+// grey, red, green and blue of each pixel
+struct LevelsSamples
+{
+    explicit LevelsSamples(const QRgb* pixels)
+        : m_pixels(pixels)
+    {}
+
+    void operator()(size_t i, float* values) const
+    {
+        const QRgb pixel = m_pixels[i];
+        values[0] = qGray(pixel);
+        values[1] = qRed(pixel);
+        values[2] = qGreen(pixel);
+        values[3] = qBlue(pixel);
+    }
+
+private:
+    const QRgb* m_pixels;
+};
+
 }
 
 GammaAndLevels::GammaAndLevels(QWidget *parent,  const QImage& data) :
@@ -267,17 +289,17 @@ void HistogramLDR::setData(const QImage* data)
 
     if ( data->isNull() ) return;
 
-    // Build histogram
+    // Build histograms in a single pass
+    pfs::utils::Histogram hist[4];
+    for (int c = 0; c < 4; ++c) hist[c] = pfs::utils::Histogram(256, 0.f, 256.f);
+
     const QRgb* pixels = (const QRgb*)(data->bits());
-    const int ELEMS = data->width()*data->height();
-    for (int i = 0; i < ELEMS; ++i)
-    {
-        m_GreyHist[ qGray(pixels[i]) ] += 1.0f;
+    pfs::utils::computeHistograms(data->width()*data->height(), hist, 4, LevelsSamples(pixels));
 
-        m_RedHist[ qRed(pixels[i]) ] += 1.0f;
-        m_GreenHist[ qGreen(pixels[i]) ] += 1.0f;
-        m_BlueHist[ qBlue(pixels[i]) ] += 1.0f;
-    }
+    for (int i = 0; i < 256; ++i) m_GreyHist[i] = hist[0].count(i);
+    for (int i = 0; i < 256; ++i) m_RedHist[i] = hist[1].count(i);
+    for (int i = 0; i < 256; ++i) m_GreenHist[i] = hist[2].count(i);
+    for (int i = 0; i < 256; ++i) m_BlueHist[i] = hist[3].count(i);
 
     //find max
     float hist_max = m_GreyHist[0];
@@ -385,6 +385,7 @@ int GenericViewer::getHeight()
 
 void GenericViewer::setFrame(pfs::Frame *new_frame, TonemappingOptions* tmopts)
 {
+    frameAboutToBeReplaced();
     mFrame.reset(new_frame);
 
     // call virtual protected function
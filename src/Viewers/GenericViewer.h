@@ -180,6 +180,14 @@ protected:
     virtual void retranslateUi();
     virtual void changeEvent(QEvent* event);
 
+    //! \brief called by setFrame() before the current frame gets deleted, so
+    //! that derived classes can stop the jobs still reading it
+    virtual void frameAboutToBeReplaced() {}
+
+    //! \brief Calculate the current zoom factor
+    //! \return current zoom factor
+    float getScaleFactor();
+
     QToolBar* mToolBar;
     QToolButton* mCornerButton;
     PanIconWidget* mPanIconWidget;
@@ -201,10 +209,6 @@ private:
     //! \attention currently this function has an empty body
     void zoomToFactor(float factor);
 
-    //! \brief Calculate the current zoom factor
-    //! \return current zoom factor
-    float getScaleFactor();
-
     bool mNeedsSaving;
     std::unique_ptr<pfs::Frame> mFrame;
 
@@ -29,6 +29,10 @@
 
 #include <QFileInfo>
 #include <QDebug>
+#include <QGraphicsPixmapItem>
+#include <QtConcurrentRun>
+
+#include <boost/bind.hpp>
 
 #include <cmath>
 #include <cassert>
@@ -38,12 +42,13 @@
 
 #include "Fileformat/pfsoutldrimage.h"
 #include "Viewers/IGraphicsPixmapItem.h"
+#include "Viewers/IGraphicsView.h"
 #include "Viewers/LuminanceRangeWidget.h"
+#include "Viewers/PreviewPyramid.h"
 
 #include "Libpfs/array2d.h"
 #include "Libpfs/channel.h"
 #include "Libpfs/frame.h"
-#include "Libpfs/utils/sse.h"
 #include "Libpfs/utils/msec_timer.h"
 
 namespace // anonymous namespace
@@ -52,10 +57,11 @@ namespace // anonymous namespace
 // In this way, we let know the compiler it can mess up as much as it wants with the code,
 // because it will only used inside this compilation unit
 
-const pfs::Array2Df* getPrimaryChannel(const pfs::Frame& frame)
-{
-    return frame.getChannel("Y");
-}
+// smaller frames are mapped at once
+const int PROGRESSIVE_MIN_PIXELS = 4*1024*1024;
+
+// time without range or mapping changes before the whole frame is mapped
+const int REFINEMENT_DELAY_MSEC = 150;
 
 } // end anonymous namespace
 
@@ -64,21 +70,22 @@ HdrViewer::HdrViewer(pfs::Frame* frame, QWidget *parent, bool ns)
     , m_mappingMethod(MAP_GAMMA2_2)
     , m_minValue(0.f)
     , m_maxValue(1.f)
+    , m_refinementPending(false)
 {
     initUi();
 
     // I prefer to do everything by hand, so the flow of the calls is clear
     m_lumRange->blockSignals(true);
 
-    m_lumRange->setHistogramImage(getPrimaryChannel(*getFrame()));
+    m_lumRange->setHistogramFrame(getFrame());
     m_lumRange->fitToDynamicRange();
 
     m_mappingMethod = static_cast<RGBMappingType>( m_mappingMethodCB->currentIndex() );
     m_minValue = powf( 10.0f, m_lumRange->getRangeWindowMin() );
     m_maxValue = powf( 10.0f, m_lumRange->getRangeWindowMax() );
 
-    QScopedPointer<QImage> qImage(mapFrameToImage(getFrame()));
-    mPixmap->setPixmap(QPixmap::fromImage(*qImage));
+    buildPyramid();
+    mPixmap->setPixmap(QPixmap::fromImage(mapFrameToImage(0, QRect(0, 0, getWidth(), getHeight()))));
 
     updateView();
     m_lumRange->blockSignals(false);
@@ -102,6 +109,16 @@ void HdrViewer::initUi()
     connect( m_lumRange, SIGNAL( updateRangeWindow() ), this, SLOT( updateRangeWindow() ) );
     mToolBar->setSizePolicy(QSizePolicy::Preferred,QSizePolicy::Fixed);
 
+    m_previewItem = new QGraphicsPixmapItem(mPixmap);
+    m_previewItem->setTransformationMode(Qt::SmoothTransformation);
+    m_previewItem->setAcceptedMouseButtons(Qt::NoButton);
+    m_previewItem->hide();
+
+    m_refinementTimer.setSingleShot(true);
+    m_refinementTimer.setInterval(REFINEMENT_DELAY_MSEC);
+    connect(&m_refinementTimer, SIGNAL(timeout()), this, SLOT(startRefinement()));
+    connect(&m_refinement, SIGNAL(finished()), this, SLOT(refinementFinished()));
+
     retranslateUi();
 }
 
@@ -132,12 +149,97 @@ void HdrViewer::retranslateUi()
 
 void HdrViewer::refreshPixmap()
 {
-    setCursor( Qt::WaitCursor );
+    const QRect frameRect(0, 0, getWidth(), getHeight());
+    if ( getWidth()*getHeight() <= PROGRESSIVE_MIN_PIXELS )
+    {
+        setCursor( Qt::WaitCursor );
+        mPixmap->setPixmap(QPixmap::fromImage(mapFrameToImage(0, frameRect)));
+        unsetCursor();
+        return;
+    }
+
+    // maps what is on screen at the resolution it is shown...
+    const int level = m_pyramid->levelForScale(getScaleFactor());
+    const QRect region = m_pyramid->levelRegion(level, visibleRegion());
+
+    m_previewItem->setPixmap(QPixmap::fromImage(mapFrameToImage(level, region)));
+    m_previewItem->setScale(1 << level);
+    m_previewItem->setPos(region.topLeft()*(1 << level));
+    m_previewItem->show();
+
+    // ... and the whole frame when the changes settle
+    m_refinementTimer.start();
+}
+
+void HdrViewer::startRefinement()
+{
+    if ( m_refinement.isRunning() )
+    {
+        // starts again when the current one finishes
+        m_refinementPending = true;
+        return;
+    }
+
+    m_refinement.setFuture(
+                QtConcurrent::run(boost::bind(&PreviewPyramid::render, m_pyramid.data(),
+                                              0, QRect(0, 0, getWidth(), getHeight()),
+                                              m_minValue, m_maxValue, m_mappingMethod)));
+}
+
+void HdrViewer::refinementFinished()
+{
+    if ( m_refinementPending )
+    {
+        m_refinementPending = false;
+        startRefinement();
+        return;
+    }
+    if ( m_refinementTimer.isActive() || m_refinement.isCanceled() )
+    {
+        return;
+    }
+
+    mPixmap->setPixmap(QPixmap::fromImage(m_refinement.result()));
+    m_previewItem->hide();
+}
+
+void HdrViewer::buildPyramid()
+{
+    stopBackgroundJobs();
+    m_pyramid.reset(new PreviewPyramid(*getFrame()));
+    if ( getWidth()*getHeight() > PROGRESSIVE_MIN_PIXELS )
+    {
+        m_pyramidFuture = QtConcurrent::run(m_pyramid.data(), &PreviewPyramid::build);
+    }
+}
+
+void HdrViewer::stopBackgroundJobs()
+{
+    m_refinementTimer.stop();
+    m_refinementPending = false;
+    m_refinement.waitForFinished();
+    // drops the notification of the stale result, if still queued
+    m_refinement.setFuture(QFuture<QImage>());
+
+    if ( m_pyramid )
+    {
+        m_pyramid->cancel();
+        m_pyramidFuture.waitForFinished();
+    }
+    m_previewItem->hide();
+}
 
-    QScopedPointer<QImage> qImage(mapFrameToImage(getFrame()));
-    mPixmap->setPixmap(QPixmap::fromImage(*qImage));
+void HdrViewer::frameAboutToBeReplaced()
+{
+    stopBackgroundJobs();
+    m_pyramid.reset();
+}
 
-    unsetCursor();
+QRect HdrViewer::visibleRegion()
+{
+    const QRectF scene = mView->mapToScene(mView->viewport()->rect()).boundingRect();
+    return mPixmap->mapFromScene(scene).boundingRect().toAlignedRect()
+            & QRect(0, 0, getWidth(), getHeight());
 }
 
 void HdrViewer::updatePixmap()
@@ -148,10 +250,14 @@ void HdrViewer::updatePixmap()
 
     m_lumRange->blockSignals(true);
 
-    refreshPixmap();
+    // the frame changed (new one or in place): maps it at once, as the
+    // pyramid is not ready yet
+    getFrame()->invalidateCache();
+    buildPyramid();
+    mPixmap->setPixmap(QPixmap::fromImage(mapFrameToImage(0, QRect(0, 0, getWidth(), getHeight()))));
 
     // I need to set the histogram again during the setFrame function
-    m_lumRange->setHistogramImage(getPrimaryChannel(*getFrame()));
+    m_lumRange->setHistogramFrame(getFrame());
     m_lumRange->fitToDynamicRange();
     m_lumRange->blockSignals(false);
 }
@@ -188,9 +294,10 @@ void HdrViewer::setLumMappingMethod( int method )
     refreshPixmap();
 }
 
-//! empty dtor
 HdrViewer::~HdrViewer()
-{}
+{
+    stopBackgroundJobs();
+}
 
 QString HdrViewer::getFileNamePostFix()
 {
@@ -219,9 +326,9 @@ RGBMappingType HdrViewer::getLuminanceMappingMethod()
     return m_mappingMethod;
 }
 
-QImage* HdrViewer::mapFrameToImage(pfs::Frame* in_frame)
+QImage HdrViewer::mapFrameToImage(int level, const QRect& region)
 {
-    return fromLDRPFStoQImage(in_frame, m_minValue, m_maxValue, m_mappingMethod);
+    return m_pyramid->render(level, region, m_minValue, m_maxValue, m_mappingMethod);
 }
 
 void HdrViewer::keyPressEvent(QKeyEvent *event)
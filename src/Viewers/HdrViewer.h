@@ -37,6 +37,9 @@
 #include <QLabel>
 #include <QScopedPointer>
 #include <QKeyEvent>
+#include <QFuture>
+#include <QFutureWatcher>
+#include <QTimer>
 
 #include "GenericViewer.h"
 
@@ -47,6 +50,8 @@ class Frame;
 }
 
 class LuminanceRangeWidget;
+class PreviewPyramid;
+class QGraphicsPixmapItem;
 
 class HdrViewer : public GenericViewer
 {
@@ -81,11 +86,16 @@ public Q_SLOTS:
 protected Q_SLOTS:
     virtual void updatePixmap();
 
+private Q_SLOTS:
+    void startRefinement();
+    void refinementFinished();
+
 protected:
     // Methods
     virtual void retranslateUi();
     void setRangeWindow(float min, float max);
     void keyPressEvent(QKeyEvent *event);
+    void frameAboutToBeReplaced();
 
     // UI
     LuminanceRangeWidget* m_lumRange;
@@ -97,11 +107,27 @@ private:
     void initUi();
     void refreshPixmap();
 
+    //! \brief (re)starts the construction of the preview pyramid of the frame
+    void buildPyramid();
+    //! \brief waits for the jobs reading the frame
+    void stopBackgroundJobs();
+    //! \brief part of the frame shown by the view, in pixels of the frame
+    QRect visibleRegion();
+    QImage mapFrameToImage(int level, const QRect& region);
+
     RGBMappingType m_mappingMethod;
     float m_minValue;
     float m_maxValue;
 
-    QImage* mapFrameToImage(pfs::Frame* in_frame);
+    // range and mapping changes of large frames show the visible region at
+    // the resolution of the screen first, the whole frame is mapped in the
+    // background once they settle
+    QScopedPointer<PreviewPyramid> m_pyramid;
+    QFuture<void> m_pyramidFuture;
+    QFutureWatcher<QImage> m_refinement;
+    bool m_refinementPending;
+    QTimer m_refinementTimer;
+    QGraphicsPixmapItem* m_previewItem;
 };
 
 inline bool HdrViewer::isHDR()
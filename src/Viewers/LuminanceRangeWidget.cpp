@@ -37,10 +37,12 @@
 #include <stdlib.h>
 #include <QMouseEvent>
 #include <cassert>
+#include <algorithm>
+#include <vector>
 
 #include <Libpfs/array2d.h>
-
-#include "Histogram.h"
+#include <Libpfs/frame.h>
+#include <Libpfs/utils/histogram.h>
 
 static const float exposureStep = 0.25f;
 static const float shrinkStep = 0.1f;
@@ -48,11 +50,16 @@ static const float minWindowSize = 0.1f;
 
 static const int dragZoneMargin = 5; // How many pizels from the range window border should draging be activated
 
+// The histogram is computed once per frame with these bins, from about this
+// many pixels, and resampled to the width of the widget
+static const size_t histogramBins = 2048;
+static const size_t histogramSamples = 1 << 20;
+
 #define min(x,y) ( (x)<(y) ? (x) : (y) )
 #define max(x,y) ( (x)>(y) ? (x) : (y) )
 
 LuminanceRangeWidget::LuminanceRangeWidget( QWidget *parent ):
-  QFrame( parent ), dragMode(DRAG_NO), showVP( false ), valuePointer(0.f), histogram( NULL ), histogramImage( NULL )
+  QFrame( parent ), dragMode(DRAG_NO), showVP( false ), valuePointer(0.f), histogramFrame( NULL )
 
 {
   setFrameStyle( QFrame::Panel|QFrame::Sunken );
@@ -70,8 +77,6 @@ LuminanceRangeWidget::LuminanceRangeWidget( QWidget *parent ):
 
 LuminanceRangeWidget::~LuminanceRangeWidget()
 {
-  delete histogram;
-
 }
 
 
@@ -102,24 +107,26 @@ void LuminanceRangeWidget::paintEvent( QPaintEvent */*pe */)
   }
 
   // Paint histogram
-  if( histogramImage != NULL ) {
-    if( histogram == NULL || histogram->getBins() != fRect.width() ) {
-      delete histogram;
-      // Build histogram from at least 5000 pixels
-      int accuracy = histogramImage->getRows()*histogramImage->getCols()/5000;
-//       int accuracy =1;
-      if( accuracy < 1 ) accuracy = 1;
-      histogram = new Histogram( fRect.width(), accuracy );
-      histogram->computeLog( histogramImage, minValue, maxValue );
-    }
-
-    float maxP = histogram->getMaxP();
-    int i = 0;
-    p.setPen( Qt::green );
-    for( int x = fRect.left(); i < histogram->getBins(); x++, i++ ) {
-      if( histogram->getP(i) > 0 ) {
-        int barSize = (int)((float)fRect.height() * histogram->getP(i)/maxP);
-        p.drawLine( x, fRect.bottom(), x, fRect.bottom() - barSize );
+  if( histogramFrame != NULL ) {
+    const size_t step = max( histogramFrame->size()/histogramSamples, (size_t)1 );
+    std::shared_ptr<const pfs::utils::Histogram> histogram =
+      histogramFrame->getHistogram( "Y", histogramBins, minValue, maxValue,
+                                    pfs::utils::HISTOGRAM_LOG10, step );
+
+    if( histogram && histogram->total() > 0 ) {
+      const size_t width = fRect.width();
+      std::vector<size_t> columns( width, 0 );
+      for( size_t b = 0; b < histogram->bins(); b++ )
+        columns[b*width/histogram->bins()] += histogram->count(b);
+
+      const float maxP = (float)*std::max_element( columns.begin(), columns.end() );
+      p.setPen( Qt::green );
+      for( size_t i = 0; i < width; i++ ) {
+        if( columns[i] > 0 ) {
+          int x = fRect.left() + (int)i;
+          int barSize = (int)((float)fRect.height() * columns[i]/maxP);
+          p.drawLine( x, fRect.bottom(), x, fRect.bottom() - barSize );
+        }
       }
     }
   }
@@ -267,16 +274,16 @@ void LuminanceRangeWidget::shrinkRange()
   emit updateRangeWindow();
 }
 
-void LuminanceRangeWidget::setHistogramImage( const pfs::Array2Df *image )
+void LuminanceRangeWidget::setHistogramFrame( const pfs::Frame *frame )
 {
-  histogramImage = image;
-  delete histogram;
-  histogram = NULL;
+  histogramFrame = frame;
   update();
 }
 
 void LuminanceRangeWidget::fitToDynamicRange()
 {
+  const pfs::Array2Df *histogramImage =
+    histogramFrame != NULL ? histogramFrame->getChannel( "Y" ) : NULL;
   if( histogramImage != NULL ) {
     float min = 99999999.0f;
     float max = -99999999.0f;
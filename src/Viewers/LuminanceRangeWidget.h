@@ -28,8 +28,11 @@
 #define LUMINANCERANGE_WIDGET_H
 
 #include <QFrame>
-#include "Viewers/Histogram.h"
-#include "Libpfs/array2d_fwd.h"
+
+namespace pfs
+{
+class Frame;
+}
 
 class LuminanceRangeWidget : public QFrame {
   Q_OBJECT
@@ -79,8 +82,7 @@ private:
   bool showVP;
   float valuePointer;
 
-  Histogram *histogram;
-  const pfs::Array2Df *histogramImage;
+  const pfs::Frame *histogramFrame;
 
   QRect getPaintRect() const;
 
@@ -96,7 +98,9 @@ public:
 
   void setRangeWindowMinMax( float min, float max );
 
-  void setHistogramImage( const pfs::Array2Df *image );
+  //! \brief shows the histogram of the luminance of \a frame, that is
+  //! cached by the frame itself
+  void setHistogramFrame( const pfs::Frame *frame );
 
   void showValuePointer( float value );
   void hideValuePointer();
@@ -0,0 +1,174 @@
+/*
+ * This file is a part of Luminance HDR package
+ * ----------------------------------------------------------------------
+ * Copyright (C) 2017 Luminance HDR developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+#include "Viewers/PreviewPyramid.h"
+
+#include <algorithm>
+
+#include "Fileformat/pfsoutldrimage.h"
+#include "Libpfs/array2d.h"
+#include "Libpfs/frame.h"
+
+namespace
+{
+// the coarsest level is the first one that fits in this size
+const size_t MIN_LEVEL_SIZE = 256;
+
+//! \brief 2x2 box filter, the last row and column of odd sizes are repeated
+void reduce(const pfs::Array2Df& src, pfs::Array2Df& dst, const QAtomicInt& canceled)
+{
+    const size_t srcCols = src.getCols();
+    const size_t srcRows = src.getRows();
+    const int dstRows = static_cast<int>(dst.getRows());
+    const size_t dstCols = dst.getCols();
+
+#pragma omp parallel for
+    for (int y = 0; y < dstRows; ++y)
+    {
+        if ( canceled.load() ) continue;
+
+        const float* row0 = src.data() + 2*y*srcCols;
+        const float* row1 = src.data() + std::min<size_t>(2*y + 1, srcRows - 1)*srcCols;
+        float* out = dst.data() + y*dstCols;
+        for (size_t x = 0; x < dstCols; ++x)
+        {
+            const size_t x0 = 2*x;
+            const size_t x1 = std::min(x0 + 1, srcCols - 1);
+            out[x] = 0.25f*(row0[x0] + row0[x1] + row1[x0] + row1[x1]);
+        }
+    }
+}
+}
+
+PreviewPyramid::PreviewPyramid(pfs::Frame& frame)
+    : m_ready(1)
+    , m_canceled(0)
+{
+    pfs::Channel *X, *Y, *Z;
+    frame.getXYZChannels(X, Y, Z);
+
+    Level level = { X, Y, Z };
+    m_levels.push_back(level);
+
+    // only allocates the levels, build() fills them
+    size_t cols = X->getCols();
+    size_t rows = X->getRows();
+    while ( std::max(cols, rows) > MIN_LEVEL_SIZE )
+    {
+        cols = (cols + 1)/2;
+        rows = (rows + 1)/2;
+        for (int c = 0; c < 3; ++c)
+        {
+            m_storage.push_back(std::unique_ptr<pfs::Array2Df>(new pfs::Array2Df(cols, rows)));
+        }
+        const size_t last = m_storage.size();
+        Level reduced = { m_storage[last - 3].get(),
+                          m_storage[last - 2].get(),
+                          m_storage[last - 1].get() };
+        m_levels.push_back(reduced);
+    }
+}
+
+PreviewPyramid::~PreviewPyramid()
+{}
+
+void PreviewPyramid::build()
+{
+    for (size_t l = 1; l < m_levels.size(); ++l)
+    {
+        const Level& src = m_levels[l - 1];
+        const Level& dst = m_levels[l];
+        reduce(*src.R, *dst.R, m_canceled);
+        reduce(*src.G, *dst.G, m_canceled);
+        reduce(*src.B, *dst.B, m_canceled);
+
+        if ( m_canceled.load() ) return;
+        m_ready.storeRelease(static_cast<int>(l + 1));
+    }
+}
+
+void PreviewPyramid::cancel()
+{
+    m_canceled.store(1);
+}
+
+int PreviewPyramid::levels() const
+{
+    return m_ready.loadAcquire();
+}
+
+int PreviewPyramid::levelForScale(float scale) const
+{
+    int level = 0;
+    while ( level + 1 < levels() && scale*(2 << level) <= 1.f )
+    {
+        ++level;
+    }
+    return level;
+}
+
+QSize PreviewPyramid::size(int level) const
+{
+    return QSize(static_cast<int>(m_levels[level].R->getCols()),
+                 static_cast<int>(m_levels[level].R->getRows()));
+}
+
+QRect PreviewPyramid::levelRegion(int level, const QRect& region) const
+{
+    const int x0 = region.left() >> level;
+    const int y0 = region.top() >> level;
+    const int x1 = (region.right() >> level) + 1;
+    const int y1 = (region.bottom() >> level) + 1;
+
+    return QRect(x0, y0, x1 - x0, y1 - y0) & QRect(QPoint(0, 0), size(level));
+}
+
+QImage PreviewPyramid::render(int level, const QRect& levelRegion,
+                              float minLuminance, float maxLuminance,
+                              RGBMappingType mappingMethod) const
+{
+    const Level& src = m_levels[level];
+    const QRect region = levelRegion & QRect(QPoint(0, 0), size(level));
+
+    QImage image(region.size(), QImage::Format_RGB32);
+    if ( image.isNull() ) return image;
+
+    const QRgbRemapper remapper(minLuminance, maxLuminance, mappingMethod);
+    const int rows = region.height();
+    const int cols = region.width();
+    uchar* bits = image.bits();
+    const int bytesPerLine = image.bytesPerLine();
+
+#pragma omp parallel for
+    for (int y = 0; y < rows; ++y)
+    {
+        const size_t offset = (region.top() + y)*src.R->getCols() + region.left();
+        const float* r = src.R->data() + offset;
+        const float* g = src.G->data() + offset;
+        const float* b = src.B->data() + offset;
+        QRgb* out = reinterpret_cast<QRgb*>(bits + y*bytesPerLine);
+        for (int x = 0; x < cols; ++x)
+        {
+            remapper(r[x], g[x], b[x], out[x]);
+        }
+    }
+    return image;
+}
@@ -0,0 +1,95 @@
+/*
+ * This file is a part of Luminance HDR package
+ * ----------------------------------------------------------------------
+ * Copyright (C) 2017 Luminance HDR developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+//! \brief Reduced resolution copies of an HDR frame, used by HdrViewer to
+//! map only what is on screen at the resolution it is shown
+
+#ifndef PREVIEWPYRAMID_H
+#define PREVIEWPYRAMID_H
+
+#include <memory>
+#include <vector>
+
+#include <QAtomicInt>
+#include <QImage>
+#include <QRect>
+
+#include <Libpfs/array2d_fwd.h>
+#include <Libpfs/colorspace/rgbremapper_fwd.h>
+
+namespace pfs
+{
+class Frame;
+}
+
+class PreviewPyramid
+{
+public:
+    //! \brief the pyramid refers to the channels of \a frame, that must
+    //! outlive it
+    explicit PreviewPyramid(pfs::Frame& frame);
+    ~PreviewPyramid();
+
+    //! \brief builds the reduced levels, each one half the size of the
+    //! previous one. A level can be rendered as soon as it is complete.
+    //! \note meant to run in a worker thread
+    void build();
+
+    //! \brief stops a running build()
+    void cancel();
+
+    //! \brief number of levels that can be rendered. Level 0 is the frame
+    //! itself, so it is always available
+    int levels() const;
+
+    //! \brief coarsest available level that still has at least one pixel
+    //! per pixel on screen when the frame is shown at \a scale
+    int levelForScale(float scale) const;
+
+    //! \brief size of \a level
+    QSize size(int level) const;
+
+    //! \brief smallest rectangle of \a level covering \a region, that is
+    //! expressed in pixels of the frame
+    QRect levelRegion(int level, const QRect& region) const;
+
+    //! \brief maps \a levelRegion of \a level to an 8 bit image
+    //! \note thread safe
+    QImage render(int level, const QRect& levelRegion,
+                  float minLuminance, float maxLuminance,
+                  RGBMappingType mappingMethod) const;
+
+private:
+    struct Level
+    {
+        pfs::Array2Df* R;
+        pfs::Array2Df* G;
+        pfs::Array2Df* B;
+    };
+
+    std::vector<Level> m_levels;
+    std::vector< std::unique_ptr<pfs::Array2Df> > m_storage;
+
+    QAtomicInt m_ready;
+    QAtomicInt m_canceled;
+};
+
+#endif // PREVIEWPYRAMID_H
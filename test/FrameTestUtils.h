@@ -0,0 +1,71 @@
+/*
+ * This file is a part of Luminance HDR package
+ * ----------------------------------------------------------------------
+ * Copyright (C) 2017 Luminance HDR developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+#ifndef FRAMETESTUTILS_H
+#define FRAMETESTUTILS_H
+
+#include <gtest/gtest.h>
+#include <cstddef>
+#include <cstdlib>
+
+#include <Libpfs/frame.h>
+
+//! \brief fills \a frame with \a width times \a height random XYZ pixels,
+//! the same for every call
+inline void fillFrame(pfs::Frame& frame, size_t width, size_t height)
+{
+    pfs::Frame temp(width, height);
+    pfs::Channel* X;
+    pfs::Channel* Y;
+    pfs::Channel* Z;
+    temp.createXYZChannels(X, Y, Z);
+
+    srand(42);
+    for (size_t idx = 0; idx < width*height; ++idx)
+    {
+        (*X)(idx) = 0.01f + 10.f*float(rand())/RAND_MAX;
+        (*Y)(idx) = 0.01f + 10.f*float(rand())/RAND_MAX;
+        (*Z)(idx) = 0.01f + 10.f*float(rand())/RAND_MAX;
+    }
+
+    frame.swap(temp);
+}
+
+inline void compareFrames(const pfs::Frame& expected, const pfs::Frame& actual)
+{
+    ASSERT_EQ(expected.getWidth(), actual.getWidth());
+    ASSERT_EQ(expected.getHeight(), actual.getHeight());
+    ASSERT_EQ(expected.getChannels().size(), actual.getChannels().size());
+
+    for (size_t c = 0; c < expected.getChannels().size(); ++c)
+    {
+        const pfs::Channel* e = expected.getChannels()[c];
+        const pfs::Channel* a = actual.getChannel(e->getName());
+        ASSERT_TRUE(a != NULL);
+
+        for (size_t idx = 0; idx < e->size(); ++idx)
+        {
+            ASSERT_EQ((*e)(idx), (*a)(idx)) << e->getName() << " at " << idx;
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,64 @@
+/*
+ * This file is a part of Luminance HDR package
+ * ----------------------------------------------------------------------
+ * Copyright (C) 2017 Luminance HDR developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+#ifndef SYNTHETICEXPOSURES_H
+#define SYNTHETICEXPOSURES_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+#include <Libpfs/frame.h>
+#include <HdrCreation/fusionoperator.h>
+
+// exposures of a smooth synthetic scene through a gamma camera
+inline std::vector<libhdr::fusion::FrameEnhanced> buildExposures(size_t width, size_t height)
+{
+    const float exposures[] = { 0.25f, 1.f, 4.f };
+
+    std::vector<libhdr::fusion::FrameEnhanced> frames;
+    for (size_t e = 0; e < 3; ++e)
+    {
+        pfs::FramePtr frame(new pfs::Frame(width, height));
+        pfs::Channel* R;
+        pfs::Channel* G;
+        pfs::Channel* B;
+        frame->createXYZChannels(R, G, B);
+
+        srand(7);
+        for (size_t y = 0; y < height; ++y)
+        {
+            for (size_t x = 0; x < width; ++x)
+            {
+                const float noise = 0.01f*(rand() % 100)/100.f;
+                const float radiance = 0.02f + float(x*y)/float(width*height) + noise;
+                (*R)(x, y) = std::min(1.f, std::pow(exposures[e]*radiance, 1.f/2.2f));
+                (*G)(x, y) = std::min(1.f, std::pow(exposures[e]*0.8f*radiance, 1.f/2.2f));
+                (*B)(x, y) = std::min(1.f, std::pow(exposures[e]*0.6f*radiance, 1.f/2.2f));
+            }
+        }
+        frames.push_back(libhdr::fusion::FrameEnhanced(frame, exposures[e]));
+    }
+    return frames;
+}
+
+#endif
@@ -0,0 +1,154 @@
+/*
+ * This file is a part of Luminance HDR package
+ * ----------------------------------------------------------------------
+ * Copyright (C) 2017 Luminance HDR developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+#include <gtest/gtest.h>
+
+#include <Libpfs/array2d.h>
+#include <Libpfs/bufferarena.h>
+
+TEST(BufferArena, ReusesReleasedBuffer)
+{
+    pfs::BufferArena arena;
+
+    std::vector<float> a;
+    arena.acquire(1000, a);
+    ASSERT_EQ(a.size(), 1000u);
+    const float* storage = a.data();
+
+    arena.release(a);
+    EXPECT_TRUE(a.empty());
+    EXPECT_EQ(arena.bytes(), 1000*sizeof(float));
+
+    std::vector<float> b;
+    arena.acquire(800, b);
+    EXPECT_EQ(b.size(), 800u);
+    EXPECT_EQ(b.data(), storage);
+    EXPECT_EQ(arena.bytes(), 0u);
+    EXPECT_EQ(arena.hits(), 1u);
+    EXPECT_EQ(arena.misses(), 1u);
+
+    // too large for the released buffer
+    arena.release(b);
+    std::vector<float> c;
+    arena.acquire(2000, c);
+    EXPECT_EQ(arena.hits(), 1u);
+    EXPECT_EQ(arena.misses(), 2u);
+    EXPECT_EQ(arena.bytes(), 1000*sizeof(float));
+}
+
+TEST(BufferArena, PicksSmallestFittingBuffer)
+{
+    pfs::BufferArena arena;
+
+    std::vector<float> small, large;
+    arena.acquire(100, small);
+    arena.acquire(10000, large);
+    const float* smallStorage = small.data();
+    const float* largeStorage = large.data();
+
+    arena.release(large);
+    arena.release(small);
+
+    std::vector<float> a;
+    arena.acquire(50, a);
+    EXPECT_EQ(a.data(), smallStorage);
+
+    std::vector<float> b;
+    arena.acquire(50, b);
+    EXPECT_EQ(b.data(), largeStorage);
+}
+
+TEST(BufferArena, TypesDoNotMix)
+{
+    pfs::BufferArena arena;
+
+    std::vector<float> f;
+    arena.acquire(100, f);
+    arena.release(f);
+
+    std::vector<double> d;
+    arena.acquire(10, d);
+    EXPECT_EQ(arena.hits(), 0u);
+    EXPECT_EQ(arena.misses(), 2u);
+}
+
+TEST(BufferArena, Budget)
+{
+    pfs::BufferArena arena(1500*sizeof(float));
+
+    std::vector<float> a, b;
+    arena.acquire(1000, a);
+    arena.acquire(1000, b);
+    arena.release(a);
+    arena.release(b);
+    EXPECT_EQ(arena.bytes(), 1000*sizeof(float));
+
+    arena.clear();
+    EXPECT_EQ(arena.bytes(), 0u);
+}
+
+TEST(BufferArena, Array2DGivesStorageBack)
+{
+    pfs::BufferArena arena;
+
+    const float* storage;
+    {
+        pfs::Array2Df first(64, 32, &arena);
+        storage = first.data();
+        for (size_t i = 0; i < first.size(); ++i)
+        {
+            first(i) = 1.f;
+        }
+    }
+    EXPECT_EQ(arena.bytes(), 64*32*sizeof(float));
+
+    {
+        pfs::Array2Df second(32, 32, &arena);
+        EXPECT_EQ(second.data(), storage);
+        EXPECT_EQ(second.getCols(), 32u);
+        EXPECT_EQ(second.getRows(), 32u);
+        // initialized by default
+        for (size_t i = 0; i < second.size(); ++i)
+        {
+            ASSERT_EQ(second(i), 0.f);
+        }
+        second(0) = 5.f;
+    }
+
+    {
+        pfs::Array2Df third(32, 32, &arena, false);
+        EXPECT_EQ(third.data(), storage);
+        EXPECT_EQ(third(0), 5.f);
+    }
+    EXPECT_EQ(arena.hits(), 2u);
+}
+
+TEST(BufferArena, CopyDoesNotShareArena)
+{
+    pfs::BufferArena arena;
+    {
+        pfs::Array2Df a(16, 16, &arena);
+        pfs::Array2Df b(a);
+        EXPECT_NE(a.data(), b.data());
+    }
+    // only the storage of the original goes back to the arena
+    EXPECT_EQ(arena.bytes(), 16*16*sizeof(float));
+}
@@ -0,0 +1,158 @@
+/*
+ * This file is a part of Luminance HDR package
+ * ----------------------------------------------------------------------
+ * Copyright (C) 2017 Luminance HDR developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+#include <Libpfs/array2d.h>
+#include <Libpfs/colorspace/colorspace.h>
+#include <Libpfs/colorspace/convert.h>
+#include <Libpfs/colorspace/pipeline.h>
+
+namespace
+{
+const pfs::ColorSpace s_colorSpaces[] = {
+    pfs::CS_XYZ, pfs::CS_RGB, pfs::CS_SRGB, pfs::CS_YUV, pfs::CS_Yxy
+};
+const size_t s_numColorSpaces = sizeof(s_colorSpaces)/sizeof(s_colorSpaces[0]);
+
+// more than one block of the pipeline, with a partial last block
+const size_t s_cols = 3*pfs::colorspace::PIPELINE_BLOCK_SIZE + 17;
+
+void fillRGB(pfs::Array2Df& R, pfs::Array2Df& G, pfs::Array2Df& B)
+{
+    srand(42);
+    for (size_t idx = 0; idx < R.size(); ++idx)
+    {
+        R(idx) = 0.05f + 0.9f*rand()/RAND_MAX;
+        G(idx) = 0.05f + 0.9f*rand()/RAND_MAX;
+        B(idx) = 0.05f + 0.9f*rand()/RAND_MAX;
+    }
+}
+
+void expectNear(const pfs::Array2Df& ref, const pfs::Array2Df& value)
+{
+    for (size_t idx = 0; idx < ref.size(); ++idx)
+    {
+        ASSERT_NEAR(ref(idx), value(idx), 1e-4f*std::max(1.f, std::fabs(ref(idx))));
+    }
+}
+}
+
+TEST(TestColorSpace, RoundTripAllPairs)
+{
+    pfs::Array2Df R(s_cols, 1), G(s_cols, 1), B(s_cols, 1);
+    fillRGB(R, G, B);
+
+    pfs::Array2Df X(s_cols, 1), Y(s_cols, 1), Z(s_cols, 1);
+    pfs::transformColorSpace(pfs::CS_RGB, &R, &G, &B, pfs::CS_XYZ, &X, &Y, &Z);
+
+    for (size_t i = 0; i < s_numColorSpaces; ++i)
+    {
+        for (size_t o = 0; o < s_numColorSpaces; ++o)
+        {
+            SCOPED_TRACE(testing::Message() << "from " << s_colorSpaces[i]
+                         << " to " << s_colorSpaces[o]);
+
+            pfs::Array2Df C1(s_cols, 1), C2(s_cols, 1), C3(s_cols, 1);
+            pfs::transformColorSpace(pfs::CS_XYZ, &X, &Y, &Z,
+                                     s_colorSpaces[i], &C1, &C2, &C3);
+            // in-place
+            pfs::transformColorSpace(s_colorSpaces[i], &C1, &C2, &C3,
+                                     s_colorSpaces[o], &C1, &C2, &C3);
+            pfs::transformColorSpace(s_colorSpaces[o], &C1, &C2, &C3,
+                                     pfs::CS_XYZ, &C1, &C2, &C3);
+
+            expectNear(X, C1);
+            expectNear(Y, C2);
+            expectNear(Z, C3);
+        }
+    }
+}
+
+TEST(TestColorSpace, FusedMatchesSteps)
+{
+    pfs::Array2Df R(s_cols, 1), G(s_cols, 1), B(s_cols, 1);
+    fillRGB(R, G, B);
+
+    pfs::Array2Df Y(s_cols, 1), x(s_cols, 1), y(s_cols, 1);
+    pfs::transformColorSpace(pfs::CS_RGB, &R, &G, &B, pfs::CS_Yxy, &Y, &x, &y);
+
+    // Yxy -> XYZ -> RGB -> sRGB, one step at a time
+    pfs::Array2Df S1(s_cols, 1), S2(s_cols, 1), S3(s_cols, 1);
+    pfs::transformYxy2XYZ(&Y, &x, &y, &S1, &S2, &S3);
+    pfs::transformXYZ2SRGB(&S1, &S2, &S3, &S1, &S2, &S3);
+
+    pfs::Array2Df F1(s_cols, 1), F2(s_cols, 1), F3(s_cols, 1);
+    pfs::transformColorSpace(pfs::CS_Yxy, &Y, &x, &y, pfs::CS_SRGB, &F1, &F2, &F3);
+
+    for (size_t idx = 0; idx < s_cols; ++idx)
+    {
+        ASSERT_NEAR(S1(idx), F1(idx), 10e-6);
+        ASSERT_NEAR(S2(idx), F2(idx), 10e-6);
+        ASSERT_NEAR(S3(idx), F3(idx), 10e-6);
+    }
+}
+
+TEST(TestColorSpace, Quantize)
+{
+    pfs::Array2Df R(s_cols, 1), G(s_cols, 1), B(s_cols, 1);
+    fillRGB(R, G, B);
+    // out of range values are clamped
+    R(0) = -0.5f;
+    G(1) = 3.f;
+    B(2) = 1.5f;
+
+    pfs::Array2Df S1(s_cols, 1), S2(s_cols, 1), S3(s_cols, 1);
+    pfs::transformColorSpace(pfs::CS_RGB, &R, &G, &B, pfs::CS_SRGB, &S1, &S2, &S3);
+
+    std::vector<uint8_t> out8(3*s_cols);
+    std::vector<uint16_t> out16(3*s_cols);
+    pfs::transformColorSpace(pfs::CS_RGB, &R, &G, &B, pfs::CS_SRGB, out8.data());
+    pfs::transformColorSpace(pfs::CS_RGB, &R, &G, &B, pfs::CS_SRGB, out16.data());
+
+    EXPECT_EQ(0, out8[0]);
+    EXPECT_EQ(255, out8[4]);
+    EXPECT_EQ(65535, out16[8]);
+
+    const pfs::Array2Df* channels[] = { &S1, &S2, &S3 };
+    for (size_t idx = 0; idx < s_cols; ++idx)
+    {
+        for (size_t c = 0; c < 3; ++c)
+        {
+            const float value = std::min(std::max((*channels[c])(idx), 0.f), 1.f);
+            ASSERT_NEAR(pfs::colorspace::convertSample<uint8_t>(value), out8[3*idx + c], 1);
+            ASSERT_NEAR(pfs::colorspace::convertSample<uint16_t>(value), out16[3*idx + c], 1);
+        }
+    }
+}
+
+TEST(TestColorSpace, Unsupported)
+{
+    pfs::Array2Df C(1, 1);
+    EXPECT_THROW(pfs::transformColorSpace(static_cast<pfs::ColorSpace>(42), &C, &C, &C,
+                                          pfs::CS_XYZ, &C, &C, &C),
+                 pfs::Exception);
+}
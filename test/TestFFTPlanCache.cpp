@@ -0,0 +1,157 @@
+/*
+ * This file is a part of Luminance HDR package
+ * ----------------------------------------------------------------------
+ * Copyright (C) 2017 Luminance HDR developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include <Libpfs/fftplancache.h>
+
+using namespace pfs;
+
+TEST(TestFFTPlanCache, RoundTripReusesPlans)
+{
+    const int rows = 17;
+    const int cols = 23;
+
+    FFTPlanCache cache;
+
+    float* in = fftwf_alloc_real(rows*cols);
+    float* out = fftwf_alloc_real(rows*cols);
+    fftwf_complex* freq = static_cast<fftwf_complex*>(
+                fftwf_malloc(sizeof(fftwf_complex)*rows*(cols/2 + 1)));
+
+    for (int iter = 0; iter < 3; ++iter)
+    {
+        for (int idx = 0; idx < rows*cols; ++idx)
+        {
+            in[idx] = static_cast<float>(std::rand())/RAND_MAX;
+        }
+
+        cache.r2c(rows, cols, in, freq);
+        cache.c2r(rows, cols, freq, out);
+
+        // the backward transform is not normalized
+        for (int idx = 0; idx < rows*cols; ++idx)
+        {
+            ASSERT_NEAR(in[idx], out[idx]/(rows*cols), 1e-5f);
+        }
+        EXPECT_EQ(cache.size(), 2u);
+    }
+
+    cache.setPlanningRigor(FFTPlanCache::PLAN_MEASURE);
+    EXPECT_EQ(cache.size(), 0u);
+
+    fftwf_free(freq);
+    fftwf_free(out);
+    fftwf_free(in);
+}
+
+TEST(TestFFTPlanCache, UnalignedDCT)
+{
+    const int rows = 9;
+    const int cols = 12;
+
+    FFTPlanCache cache;
+
+    std::vector<float> buffer(2*rows*cols + 2);
+    // second element of an aligned buffer is never aligned for SIMD
+    float* aligned = fftwf_alloc_real(rows*cols + 1);
+    float* in = aligned + 1;
+    float* tr = &buffer[1];
+    float* out = &buffer[rows*cols + 1];
+
+    for (int idx = 0; idx < rows*cols; ++idx)
+    {
+        in[idx] = static_cast<float>(idx % 7);
+    }
+
+    cache.r2r(rows, cols, FFTW_REDFT00, FFTW_REDFT00, in, tr);
+    cache.r2r(rows, cols, FFTW_REDFT00, FFTW_REDFT00, tr, out);
+
+    // DCT-I is its own inverse, up to a factor 2(n - 1) for each dimension
+    const float scale = 4.f*(rows - 1)*(cols - 1);
+    for (int idx = 0; idx < rows*cols; ++idx)
+    {
+        ASSERT_NEAR(in[idx], out[idx]/scale, 1e-4f);
+    }
+    EXPECT_EQ(cache.size(), 1u);
+
+    fftwf_free(aligned);
+}
+
+TEST(TestFFTPlanCache, ClearWhileTransforming)
+{
+    const int rows = 16;
+    const int cols = 20;
+    const float scale = 4.f*(rows - 1)*(cols - 1);
+
+    FFTPlanCache cache;
+    std::atomic<bool> done(false);
+    std::atomic<int> errors(0);
+
+    // discards the plans while the other threads are executing them
+    std::thread cleaner([&]()
+    {
+        while ( !done )
+        {
+            cache.clear();
+            std::this_thread::yield();
+        }
+    });
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < 4; ++t)
+    {
+        workers.push_back(std::thread([&, t]()
+        {
+            std::vector<float> in(rows*cols);
+            std::vector<float> tr(rows*cols);
+            std::vector<float> out(rows*cols);
+            for (int idx = 0; idx < rows*cols; ++idx)
+            {
+                in[idx] = static_cast<float>((idx + t) % 5);
+            }
+
+            for (int iter = 0; iter < 1000; ++iter)
+            {
+                cache.r2r(rows, cols, FFTW_REDFT00, FFTW_REDFT00, in.data(), tr.data());
+                cache.r2r(rows, cols, FFTW_REDFT00, FFTW_REDFT00, tr.data(), out.data());
+                for (int idx = 0; idx < rows*cols; ++idx)
+                {
+                    if ( std::abs(in[idx] - out[idx]/scale) > 1e-4f ) ++errors;
+                }
+            }
+        }));
+    }
+    for (size_t t = 0; t < workers.size(); ++t)
+    {
+        workers[t].join();
+    }
+    done = true;
+    cleaner.join();
+
+    EXPECT_EQ(errors, 0);
+}
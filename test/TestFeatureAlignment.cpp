@@ -0,0 +1,216 @@
+/*
+ * This file is a part of Luminance HDR package
+ * ----------------------------------------------------------------------
+ * Copyright (C) 2017 Luminance HDR developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+#include <boost/cstdint.hpp>
+
+#include <Libpfs/frame.h>
+#include <HdrCreation/feature_alignment.h>
+
+using libhdr::Homography;
+
+namespace
+{
+// random rectangles and disks over a smooth background
+void fillScene(pfs::Frame& frame)
+{
+    pfs::Channel* R;
+    pfs::Channel* G;
+    pfs::Channel* B;
+    frame.createXYZChannels(R, G, B);
+
+    const int width = frame.getWidth();
+    const int height = frame.getHeight();
+    for (int y = 0; y < height; ++y)
+    {
+        for (int x = 0; x < width; ++x)
+        {
+            (*R)(x, y) = 0.2f + 0.1f*std::sin(0.01f*x)*std::cos(0.013f*y);
+        }
+    }
+
+    boost::uint32_t state = 12345u;
+    for (int shape = 0; shape < width*height/800; ++shape)
+    {
+        state = state*1664525u + 1013904223u;
+        const int cx = (state >> 8) % width;
+        state = state*1664525u + 1013904223u;
+        const int cy = (state >> 8) % height;
+        state = state*1664525u + 1013904223u;
+        const int size = 3 + (state >> 8) % 12;
+        state = state*1664525u + 1013904223u;
+        const float value = 0.02f + ((state >> 8) % 1000)*1e-3f;
+        const bool disk = (state >> 20) & 1;
+
+        for (int y = std::max(cy - size, 0); y < std::min(cy + size, height); ++y)
+        {
+            for (int x = std::max(cx - size, 0); x < std::min(cx + size, width); ++x)
+            {
+                if ( disk && (x - cx)*(x - cx) + (y - cy)*(y - cy) > size*size ) continue;
+                (*R)(x, y) = value;
+            }
+        }
+    }
+
+    for (size_t i = 0; i < frame.size(); ++i)
+    {
+        (*G)(i) = 0.9f*(*R)(i);
+        (*B)(i) = 0.8f*(*R)(i);
+    }
+}
+
+// different exposure and response
+void changeExposure(pfs::Frame& frame)
+{
+    pfs::Channel* R;
+    pfs::Channel* G;
+    pfs::Channel* B;
+    frame.getXYZChannels(R, G, B);
+    for (size_t i = 0; i < frame.size(); ++i)
+    {
+        (*R)(i) = 0.25f*std::pow((*R)(i), 0.9f);
+        (*G)(i) = 0.25f*std::pow((*G)(i), 0.9f);
+        (*B)(i) = 0.25f*std::pow((*B)(i), 0.9f);
+    }
+}
+
+Homography makeTransform(double angle, double tx, double ty, double px, double py)
+{
+    const double c = std::cos(angle);
+    const double s = std::sin(angle);
+    const double h[9] = { c, -s, tx, s, c, ty, px, py, 1. };
+    return Homography(h);
+}
+
+double maxDistance(const Homography& H1, const Homography& H2, int width, int height)
+{
+    double maxDist = 0.;
+    for (int y = 0; y <= height; y += height/8)
+    {
+        for (int x = 0; x <= width; x += width/8)
+        {
+            double u1, v1, u2, v2;
+            H1.apply(x, y, u1, v1);
+            H2.apply(x, y, u2, v2);
+            maxDist = std::max(maxDist, std::sqrt((u1 - u2)*(u1 - u2) + (v1 - v2)*(v1 - v2)));
+        }
+    }
+    return maxDist;
+}
+}
+
+TEST(TestFeatureAlignment, HomographyAlgebra)
+{
+    const Homography H = makeTransform(0.1, 5., -3., 1e-5, -2e-5);
+    Homography inv;
+    ASSERT_TRUE(H.inverse(inv));
+
+    double u, v, x, y;
+    H.apply(100., 50., u, v);
+    inv.apply(u, v, x, y);
+    EXPECT_NEAR(x, 100., 1e-9);
+    EXPECT_NEAR(y, 50., 1e-9);
+
+    const Homography identity = H*inv;
+    EXPECT_LT(maxDistance(identity, Homography(), 1000, 1000), 1e-9);
+}
+
+TEST(TestFeatureAlignment, EstimatesTransform)
+{
+    const int width = 1024;
+    const int height = 768;
+    pfs::Frame reference(width, height);
+    fillScene(reference);
+
+    const Homography truth[] = {
+        makeTransform(0., 7.5, -4.25, 0., 0.),
+        makeTransform(0.01, -12.3, 6.8, 0., 0.),
+        makeTransform(-0.005, 3.2, 9.7, 2e-6, -3e-6)
+    };
+
+    for (size_t t = 0; t < sizeof(truth)/sizeof(truth[0]); ++t)
+    {
+        // moved(H(p)) = reference(p)
+        Homography inv;
+        ASSERT_TRUE(truth[t].inverse(inv));
+        pfs::Frame moved;
+        libhdr::warpFrame(reference, inv, moved);
+        changeExposure(moved);
+
+        Homography H;
+        ASSERT_TRUE(libhdr::estimateTransform(reference, moved, H));
+        EXPECT_LT(maxDistance(H, truth[t], width, height), 0.5) << "transform " << t;
+
+        Homography A;
+        ASSERT_TRUE(libhdr::estimateTransform(reference, moved, A, libhdr::FEATURE_ALIGN_AFFINE));
+        if ( truth[t](2, 0) == 0. && truth[t](2, 1) == 0. )
+        {
+            EXPECT_LT(maxDistance(A, truth[t], width, height), 0.5) << "transform " << t;
+        }
+    }
+}
+
+TEST(TestFeatureAlignment, AlignsBracket)
+{
+    const int width = 800;
+    const int height = 600;
+    pfs::FramePtr reference(new pfs::Frame(width, height));
+    fillScene(*reference);
+
+    std::vector<pfs::FramePtr> frames;
+    frames.push_back(reference);
+    Homography inv;
+    ASSERT_TRUE(makeTransform(0.004, 6., -2., 0., 0.).inverse(inv));
+    frames.push_back(pfs::FramePtr(new pfs::Frame));
+    libhdr::warpFrame(*reference, inv, *frames.back());
+    ASSERT_TRUE(makeTransform(-0.003, -3., 5., 0., 0.).inverse(inv));
+    frames.push_back(pfs::FramePtr(new pfs::Frame));
+    libhdr::warpFrame(*reference, inv, *frames.back());
+
+    ASSERT_TRUE(libhdr::feature_alignment(frames));
+
+    const pfs::Channel* R;
+    const pfs::Channel* G;
+    const pfs::Channel* B;
+    reference->getXYZChannels(R, G, B);
+    for (size_t i = 1; i < frames.size(); ++i)
+    {
+        const pfs::Channel* X;
+        const pfs::Channel* Y;
+        const pfs::Channel* Z;
+        frames[i]->getXYZChannels(X, Y, Z);
+
+        double error = 0.;
+        double energy = 0.;
+        for (int y = 20; y < height - 20; ++y)
+        {
+            for (int x = 20; x < width - 20; ++x)
+            {
+                error += std::fabs((*X)(x, y) - (*R)(x, y));
+                energy += std::fabs((*R)(x, y));
+            }
+        }
+        EXPECT_LT(error/energy, 0.05) << "frame " << i;
+    }
+}
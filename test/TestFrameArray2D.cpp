@@ -22,6 +22,7 @@
 #include <gtest/gtest.h>
 
 #include <Libpfs/array2d.h>
+#include <Libpfs/array2dview.h>
 #include <Libpfs/frame.h>
 
 #include "SeqInt.h"
@@ -126,3 +127,29 @@ TEST(TestArray2D, Ctor)
         compareVectors(array2d_v2.data(), array2d_2.data(), array2d.size());
     }
 }
+
+TEST(TestArray2DView, StridedCopyOnWrite)
+{
+    // interleaved samples: the view picks the second component of each pair
+    std::shared_ptr< std::vector<int> > storage(new std::vector<int>(2*3*4));
+    std::generate(storage->begin(), storage->end(), SeqInt());
+
+    pfs::Array2DView<int> view(storage->data() + 1, 3, 4, 2, storage);
+
+    EXPECT_TRUE(view.isShared());
+    EXPECT_EQ(view.getCols(), 3u);
+    EXPECT_EQ(view.getRows(), 4u);
+
+    const pfs::Array2DView<int>& cview = view;
+    EXPECT_EQ(cview(0, 0), 1);
+    EXPECT_EQ(cview(2, 1), 11);
+    EXPECT_TRUE(view.isShared());
+
+    // first mutation makes a private, contiguous copy
+    view(2, 1) = -1;
+    EXPECT_FALSE(view.isShared());
+    EXPECT_TRUE(view.isContiguous());
+    EXPECT_EQ(cview(2, 1), -1);
+    EXPECT_EQ(cview(3), 7);
+    EXPECT_EQ((*storage)[11], 11);
+}
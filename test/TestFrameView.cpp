@@ -0,0 +1,245 @@
+/*
+ * This file is a part of Luminance HDR package
+ * ----------------------------------------------------------------------
+ * Copyright (C) 2017 Luminance HDR developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+#include <Libpfs/frame.h>
+#include <Libpfs/frameview.h>
+#include <Libpfs/manip/cut.h>
+#include <Libpfs/manip/resize.h>
+#include <Libpfs/io/framereader.h>
+#include <Libpfs/io/pfsreader.h>
+#include <Libpfs/io/pfswriter.h>
+#include <Libpfs/io/rgbereader.h>
+#include <Libpfs/io/rgbewriter.h>
+
+#include "FrameTestUtils.h"
+
+using namespace pfs;
+
+namespace
+{
+bool allShared(const FrameView& frame)
+{
+    for (size_t c = 0; c < frame.getChannels().size(); ++c)
+    {
+        if ( !frame.getChannels()[c]->isShared() ) return false;
+    }
+    return true;
+}
+}
+
+TEST(TestFrameView, Channels)
+{
+    FrameView frame(4, 3);
+
+    ChannelView* X;
+    ChannelView* Y;
+    ChannelView* Z;
+    frame.getXYZChannels(X, Y, Z);
+    EXPECT_TRUE(X == NULL && Y == NULL && Z == NULL);
+
+    frame.createXYZChannels(X, Y, Z);
+    EXPECT_EQ(frame.getChannels().size(), 3u);
+    EXPECT_EQ(frame.getChannel("Y"), Y);
+    EXPECT_EQ(frame.createChannel("Y"), Y);
+
+    frame.removeChannel("Y");
+    EXPECT_TRUE(frame.getChannel("Y") == NULL);
+    EXPECT_EQ(frame.getChannels().size(), 2u);
+
+    frame.getXYZChannels(X, Y, Z);
+    EXPECT_TRUE(X == NULL && Y == NULL && Z == NULL);
+}
+
+TEST(TestFrameView, MappedPfsIsNotDetached)
+{
+    const std::string filename = "TestFrameView.pfs";
+
+    // the header of a 100x71 XYZ frame leaves the data aligned to floats
+    Frame resident;
+    fillFrame(resident, 100, 71);
+    io::PfsWriter writer(filename);
+    ASSERT_TRUE(writer.write(resident, Params()));
+
+    FrameView mapped;
+    {
+        io::PfsReader reader(filename);
+        static_cast<io::FrameReader&>(reader).read(mapped, Params());
+    }
+    ASSERT_TRUE(allShared(mapped));
+
+    std::unique_ptr<Frame> expected(cut(&resident, 5, 9, 60, 70));
+    std::unique_ptr<Frame> actual(cut(mapped, 5, 9, 60, 70));
+    compareFrames(*expected, *actual);
+
+    const int sizes[] = { 31, 50, 100, 150 };
+    for (size_t s = 0; s < sizeof(sizes)/sizeof(sizes[0]); ++s)
+    {
+        expected.reset(resize(&resident, sizes[s], BilinearInterp));
+        actual.reset(resize(mapped, sizes[s], BilinearInterp));
+        compareFrames(*expected, *actual);
+    }
+
+    // none of the above modified the channels
+    EXPECT_TRUE(allShared(mapped));
+
+    Frame copy;
+    mapped.copyTo(copy);
+    compareFrames(resident, copy);
+
+    std::remove(filename.c_str());
+}
+
+TEST(TestFrameView, ResidentFormatsAreAdopted)
+{
+    const std::string filename = "TestFrameView.hdr";
+
+    Frame input;
+    fillFrame(input, 40, 30);
+    io::RGBEWriter writer(filename);
+    ASSERT_TRUE(writer.write(input, Params()));
+
+    Frame expected;
+    {
+        io::RGBEReader reader(filename);
+        reader.read(expected, Params());
+    }
+
+    FrameView view;
+    {
+        io::RGBEReader reader(filename);
+        reader.read(view, Params());
+    }
+    EXPECT_FALSE(allShared(view));
+
+    Frame actual;
+    view.copyTo(actual);
+    compareFrames(expected, actual);
+
+    std::remove(filename.c_str());
+}
+
+TEST(TestFrameView, MoveToHandsOverResidentChannels)
+{
+    Frame input;
+    fillFrame(input, 40, 30);
+    Frame expected;
+    fillFrame(expected, 40, 30);
+    const float* data = input.getChannel("Y")->data();
+
+    FrameView view;
+    view.adopt(input);
+
+    Frame actual;
+    view.moveTo(actual);
+    EXPECT_FALSE(view.isValid());
+    EXPECT_TRUE(view.getChannels().empty());
+    compareFrames(expected, actual);
+    // adopted channels are not copied
+    EXPECT_EQ(data, actual.getChannel("Y")->data());
+}
+
+TEST(TestFrameView, MappedPfsIsWrittenFromView)
+{
+    const std::string filename = "TestFrameView.pfs";
+    const std::string copyFilename = "TestFrameViewCopy.pfs";
+
+    Frame resident;
+    fillFrame(resident, 100, 71);
+    {
+        io::PfsWriter writer(filename);
+        ASSERT_TRUE(writer.write(resident, Params()));
+    }
+
+    FrameView mapped;
+    {
+        io::PfsReader reader(filename);
+        static_cast<io::FrameReader&>(reader).read(mapped, Params());
+    }
+    ASSERT_TRUE(allShared(mapped));
+
+    io::PfsWriter writer(copyFilename);
+    ASSERT_TRUE(writer.write(mapped, Params()));
+    EXPECT_TRUE(allShared(mapped));
+
+    Frame actual;
+    {
+        io::PfsReader reader(copyFilename);
+        reader.read(actual, Params());
+    }
+    compareFrames(resident, actual);
+
+    // mapped channels are copied into the frame
+    mapped.moveTo(actual);
+    EXPECT_FALSE(mapped.isValid());
+    compareFrames(resident, actual);
+
+    std::remove(filename.c_str());
+    std::remove(copyFilename.c_str());
+}
+
+TEST(TestFrameView, StridedViewIsWritten)
+{
+    const std::string filename = "TestFrameView.pfs";
+    const size_t width = 13;
+    const size_t height = 9;
+
+    Frame resident;
+    fillFrame(resident, width, height);
+
+    // interleaved XYZ pixels, like the scanlines of a float TIFF
+    std::shared_ptr<std::vector<float> > pixels(new std::vector<float>(3*width*height));
+    const char* names[] = { "X", "Y", "Z" };
+    for (size_t c = 0; c < 3; ++c)
+    {
+        const Channel* channel = resident.getChannel(names[c]);
+        for (size_t idx = 0; idx < width*height; ++idx)
+        {
+            (*pixels)[3*idx + c] = (*channel)(idx);
+        }
+    }
+
+    FrameView strided(width, height);
+    for (size_t c = 0; c < 3; ++c)
+    {
+        Array2DViewf view(pixels->data() + c, width, height, 3, pixels);
+        strided.createChannel(names[c])->setView(view);
+    }
+
+    io::PfsWriter writer(filename);
+    ASSERT_TRUE(writer.write(strided, Params()));
+    EXPECT_TRUE(allShared(strided));
+
+    Frame actual;
+    {
+        io::PfsReader reader(filename);
+        reader.read(actual, Params());
+    }
+    compareFrames(resident, actual);
+
+    std::remove(filename.c_str());
+}
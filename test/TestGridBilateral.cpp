@@ -0,0 +1,107 @@
+/*
+ * This file is a part of Luminance HDR package
+ * ----------------------------------------------------------------------
+ * Copyright (C) 2017 Luminance HDR developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <limits>
+
+#include <Libpfs/array2d.h>
+#include <Libpfs/progress.h>
+#include <TonemappingOperators/durand02/bilateral.h>
+#include <TonemappingOperators/durand02/gridbilateral.h>
+
+namespace
+{
+// log-luminance of a smooth gradient split by a strong vertical edge
+void fillEdge(pfs::Array2Df& I)
+{
+    for (size_t y = 0; y < I.getRows(); ++y)
+    {
+        for (size_t x = 0; x < I.getCols(); ++x)
+        {
+            float v = 0.01f*x + 0.02f*std::sin(0.3f*y);
+            I(x, y) = (x < I.getCols()/2) ? v - 3.f : v + 3.f;
+        }
+    }
+}
+
+float meanAbsDiff(const pfs::Array2Df& A, const pfs::Array2Df& B)
+{
+    double sum = 0.0;
+    for (size_t i = 0; i < A.size(); ++i)
+    {
+        sum += std::fabs(A(i) - B(i));
+    }
+    return static_cast<float>(sum/A.size());
+}
+}
+
+TEST(GridBilateral, MatchesBruteForce)
+{
+    pfs::Array2Df I(120, 90);
+    pfs::Array2Df J(120, 90);
+    pfs::Array2Df reference(120, 90);
+    fillEdge(I);
+
+    pfs::Progress ph;
+    bilateralFilter(&I, &reference, 6.f, 0.4f, ph);
+    gridBilateralFilter(I, J, 6.f, 0.4f, ph);
+
+    EXPECT_LT(meanAbsDiff(J, reference), 0.05f);
+}
+
+TEST(GridBilateral, PreservesEdges)
+{
+    pfs::Array2Df I(200, 50);
+    pfs::Array2Df J(200, 50);
+    fillEdge(I);
+
+    pfs::Progress ph;
+    gridBilateralFilter(I, J, 40.f, 0.4f, ph);
+
+    // the range kernel keeps the two sides of the edge apart
+    for (size_t y = 0; y < J.getRows(); ++y)
+    {
+        EXPECT_LT(J(99, y), -1.f);
+        EXPECT_GT(J(100, y), 1.f);
+    }
+}
+
+TEST(GridBilateral, Constant)
+{
+    pfs::Array2Df I(33, 17);
+    pfs::Array2Df J(33, 17);
+    I.fill(1.5f);
+    I(3, 4) = std::numeric_limits<float>::infinity();
+
+    pfs::Progress ph;
+    gridBilateralFilter(I, J, 4.f, 0.4f, ph);
+
+    for (size_t i = 0; i < J.size(); ++i)
+    {
+        if (i != 4*33 + 3)
+        {
+            EXPECT_NEAR(J(i), 1.5f, 1e-4f);
+        }
+        ASSERT_TRUE(std::isfinite(J(i)));
+    }
+}
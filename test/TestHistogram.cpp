@@ -0,0 +1,117 @@
+/*
+ * This file is a part of Luminance HDR package
+ * ----------------------------------------------------------------------
+ * Copyright (C) 2017 Luminance HDR developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+
+#include <Libpfs/array2d.h>
+#include <Libpfs/frame.h>
+#include <Libpfs/utils/histogram.h>
+
+using namespace pfs;
+using namespace pfs::utils;
+
+namespace
+{
+// ramp of the values [0, size[
+void fillRamp(Array2Df& data)
+{
+    for (size_t i = 0; i < data.size(); ++i)
+    {
+        data(i) = static_cast<float>(i);
+    }
+}
+}
+
+TEST(Histogram, Binning)
+{
+    Histogram hist(10, 0.f, 10.f);
+
+    EXPECT_EQ(hist.bin(0.f), 0u);
+    EXPECT_EQ(hist.bin(4.5f), 4u);
+    // the upper bound belongs to the last bin
+    EXPECT_EQ(hist.bin(10.f), 9u);
+    EXPECT_EQ(hist.bin(-0.1f), hist.bins());
+    EXPECT_EQ(hist.bin(10.1f), hist.bins());
+    EXPECT_EQ(hist.bin(std::nan("")), hist.bins());
+
+    Histogram logHist(8, -2.f, 6.f, HISTOGRAM_LOG10);
+    EXPECT_EQ(logHist.bin(0.f), logHist.bins());
+    EXPECT_EQ(logHist.bin(-1.f), logHist.bins());
+    EXPECT_EQ(logHist.bin(1.f), 2u);
+    EXPECT_FLOAT_EQ(logHist.sample(3), 10.f);
+}
+
+TEST(Histogram, ParallelPassMatchesSerial)
+{
+    Array2Df data(333, 211);
+    fillRamp(data);
+
+    Histogram reference(100, 0.f, data.size() - 1.f);
+    for (size_t i = 0; i < data.size(); i += 3)
+    {
+        reference.add(data(i));
+    }
+
+    Histogram hist(100, 0.f, data.size() - 1.f);
+    computeHistogram(data, hist, 3);
+
+    EXPECT_EQ(hist.total(), reference.total());
+    EXPECT_EQ(hist.counts(), reference.counts());
+}
+
+TEST(Histogram, Quantiles)
+{
+    Array2Df data(100, 100);
+    fillRamp(data);
+
+    Histogram hist(1000, 0.f, 10000.f);
+    computeHistogram(data, hist);
+
+    EXPECT_FLOAT_EQ(hist.quantile(0.f), 0.f);
+    EXPECT_NEAR(hist.quantile(0.5f), 5000.f, 10.f);
+    EXPECT_NEAR(hist.quantile(0.99f), 9900.f, 10.f);
+    EXPECT_NEAR(hist.quantile(1.f), 9990.f, 10.f);
+}
+
+TEST(Histogram, FrameCache)
+{
+    Frame frame(64, 32);
+    Channel *X, *Y, *Z;
+    frame.createXYZChannels(X, Y, Z);
+    fillRamp(*Y);
+
+    std::shared_ptr<const Histogram> first = frame.getHistogram("Y", 16, 0.f, 2048.f);
+    ASSERT_TRUE(first != NULL);
+    EXPECT_EQ(first->total(), Y->size());
+    EXPECT_EQ(frame.getHistogram("Y", 16, 0.f, 2048.f), first);
+    EXPECT_TRUE(frame.getHistogram("W", 16, 0.f, 2048.f) == NULL);
+
+    // changes in place are visible only after the cache is invalidated
+    std::fill(Y->begin(), Y->end(), -1.f);
+    frame.invalidateCache();
+    std::shared_ptr<const Histogram> second = frame.getHistogram("Y", 16, 0.f, 2048.f);
+    EXPECT_NE(second, first);
+    EXPECT_EQ(second->total(), 0u);
+    EXPECT_EQ(first->total(), Y->size());
+}
@@ -1,8 +1,160 @@
 #include <gtest/gtest.h>
 
+#include <cmath>
+#include <cstdlib>
+
+#include <Libpfs/frame.h>
+#include <Libpfs/manip/shift.h>
 #include <HdrCreation/mtb_alignment.h>
+#include <HdrCreation/packedbitmap.h>
+
+using libhdr::PackedBitmap;
+
+namespace
+{
+void fillRandom(PackedBitmap& bitmap, int seed)
+{
+    srand(seed);
+    for (size_t y = 0; y < bitmap.getRows(); ++y)
+    {
+        for (size_t x = 0; x < bitmap.getCols(); ++x)
+        {
+            bitmap.set(x, y, rand() % 2);
+        }
+    }
+}
+
+void fillFrame(pfs::Frame& frame)
+{
+    pfs::Channel* R;
+    pfs::Channel* G;
+    pfs::Channel* B;
+    frame.createXYZChannels(R, G, B);
+
+    for (size_t y = 0; y < frame.getHeight(); ++y)
+    {
+        for (size_t x = 0; x < frame.getWidth(); ++x)
+        {
+            float v = 128.f + 60.f*std::sin(0.07f*x + 0.02f*y)
+                    + 60.f*std::cos(0.05f*y - 0.03f*x) + 2.f*((x*7 + y*13) % 5);
+            (*R)(x, y) = v;
+            (*G)(x, y) = v;
+            (*B)(x, y) = v;
+        }
+    }
+}
+}
 
 TEST(TestMTB, getLum)
 {
 
 }
+
+TEST(TestMTB, PackedBitmapShift)
+{
+    PackedBitmap in(150, 20);
+    fillRandom(in, 42);
+
+    const int shifts[] = { -130, -65, -64, -17, -1, 0, 1, 3, 63, 64, 70, 149, 150 };
+    PackedBitmap out(150, 20);
+    for (size_t sx = 0; sx < sizeof(shifts)/sizeof(shifts[0]); ++sx)
+    {
+        for (int dy = -3; dy <= 3; ++dy)
+        {
+            const int dx = shifts[sx];
+            libhdr::shift(in, dx, dy, out);
+
+            for (int y = 0; y < 20; ++y)
+            {
+                for (int x = 0; x < 150; ++x)
+                {
+                    const int ix = x + dx;
+                    const int iy = y + dy;
+                    const bool expected = (ix >= 0 && ix < 150 && iy >= 0 && iy < 20)
+                            ? in.get(ix, iy) : false;
+                    ASSERT_EQ(out.get(x, y), expected) << "dx=" << dx << " dy=" << dy
+                                                       << " x=" << x << " y=" << y;
+                }
+                // bits past the last column stay clear
+                ASSERT_EQ(out.row(y)[2] & ~out.lastWordMask(), 0u);
+            }
+        }
+    }
+}
+
+TEST(TestMTB, PackedBitmapCountDifferences)
+{
+    PackedBitmap img1(100, 7), mask1(100, 7), img2(100, 7), mask2(100, 7);
+    fillRandom(img1, 1);
+    fillRandom(mask1, 2);
+    fillRandom(img2, 3);
+    fillRandom(mask2, 4);
+
+    size_t expected = 0;
+    for (size_t y = 0; y < 7; ++y)
+    {
+        for (size_t x = 0; x < 100; ++x)
+        {
+            expected += (img1.get(x, y) != img2.get(x, y)) && mask1.get(x, y) && mask2.get(x, y);
+        }
+    }
+    EXPECT_EQ(libhdr::countDifferences(img1, mask1, img2, mask2), expected);
+}
+
+TEST(TestMTB, FindsTranslation)
+{
+    const int width = 512;
+    const int height = 384;
+    pfs::Frame reference(width, height);
+    fillFrame(reference);
+
+    const int shifts[][2] = { {5, -3}, {-12, 7}, {0, 0}, {14, -9} };
+    for (size_t i = 0; i < sizeof(shifts)/sizeof(shifts[0]); ++i)
+    {
+        // moved(x, y) = reference(x - dx, y - dy)
+        pfs::FramePtr moved( pfs::shift(reference, shifts[i][0], shifts[i][1]) );
+
+        int shift_x = 0;
+        int shift_y = 0;
+        libhdr::mtbalign(reference, *moved, 0.5, 4, 3, shift_x, shift_y);
+
+        EXPECT_EQ(shift_x, shifts[i][0]);
+        EXPECT_EQ(shift_y, shifts[i][1]);
+    }
+}
+
+TEST(TestMTB, AlignsBracket)
+{
+    const int width = 512;
+    const int height = 384;
+    pfs::FramePtr reference(new pfs::Frame(width, height));
+    fillFrame(*reference);
+
+    std::vector<pfs::FramePtr> frames;
+    frames.push_back(reference);
+    frames.push_back(pfs::FramePtr(pfs::shift(*reference, -5, 3)));
+    frames.push_back(pfs::FramePtr(pfs::shift(*reference, -2, 6)));
+
+    libhdr::mtb_alignment(frames);
+
+    const pfs::Channel* R;
+    const pfs::Channel* G;
+    const pfs::Channel* B;
+    reference->getXYZChannels(R, G, B);
+    for (size_t i = 1; i < frames.size(); ++i)
+    {
+        const pfs::Channel* X;
+        const pfs::Channel* Y;
+        const pfs::Channel* Z;
+        frames[i]->getXYZChannels(X, Y, Z);
+
+        // the borders are filled with zeros
+        for (int y = 16; y < height - 16; ++y)
+        {
+            for (int x = 16; x < width - 16; ++x)
+            {
+                ASSERT_EQ((*X)(x, y), (*R)(x, y)) << "frame " << i;
+            }
+        }
+    }
+}
@@ -34,6 +34,7 @@
 
 #include "mantiuk06/contrast_domain.h"
 #include "TonemappingOperators/mantiuk06/pyramid.h"
+#include "Libpfs/manip/pyramid.h"
 
 struct RandZeroOne
 {
@@ -120,8 +121,8 @@ TEST_P(TestMantiuk06, Upsample)
     test_mantiuk06::matrix_upsample(outputCols, outputRows,
                                     origin.data(), referenceOutput.data());
 
-    matrixUpsample(outputCols, outputRows,
-                   origin.data(), testOutput.data());
+    pfs::upsample(outputCols, outputRows,
+                  origin.data(), testOutput.data());
 
     compareVectors(referenceOutput.data(), testOutput.data(),
                    testOutput.size());
@@ -146,9 +147,9 @@ TEST_P(TestMantiuk06, DownsampleFull)
     test_mantiuk06::matrix_downsample(inputCols, inputRows,
                                       origin.data(),
                                       referenceOutput.data());
-    matrixDownsample(inputCols, inputRows,
-                     origin.data(),
-                     testOutput.data());
+    pfs::downsample(inputCols, inputRows,
+                    origin.data(),
+                    testOutput.data());
 
     compareVectors(referenceOutput.data(), testOutput.data(),
                    testOutput.size());
@@ -370,6 +370,21 @@ TEST_P(TestDualPyramidT, multiplyA)
     compareVectors(frame2.data(), frame4.data(), size());
 }
 
+TEST_P(TestDualPyramidT, computeSumOfScaledDivergence)
+{
+    pfs::Array2Df frame(cols(), rows());
+    pfs::Array2Df reference(cols(), rows());
+    pfs::Array2Df result(cols(), rows());
+
+    std::generate(frame.begin(), frame.end(), RandZeroOne());
+    std::generate(result.begin(), result.end(), RandZeroOne());
+
+    multiplyA(newPyramid1_, newPyramid2_, frame, reference);
+    newPyramid2_.computeSumOfScaledDivergence(frame, result);
+
+    compareVectors(reference.data(), result.data(), size());
+}
+
 INSTANTIATE_TEST_CASE_P(Mantiuk06,
                         TestDualPyramidT,
                         Combine(Values(765, 320, 96),
@@ -0,0 +1,147 @@
+/*
+ * This file is a part of Luminance HDR package
+ * ----------------------------------------------------------------------
+ * Copyright (C) 2017 Luminance HDR developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+#include <Libpfs/array2d.h>
+#include <Libpfs/progress.h>
+#include <TonemappingOperators/mantiuk06/contrast_domain.h>
+
+namespace
+{
+const int COLS = 96;
+const int ROWS = 72;
+const int ITMAX = 200;
+const float TOL = 5e-3f;
+
+struct Image
+{
+    explicit Image(float scale = 1.f)
+        : R(COLS, ROWS), G(COLS, ROWS), B(COLS, ROWS), Y(COLS, ROWS)
+    {
+        for (int y = 0; y < ROWS; ++y)
+        {
+            for (int x = 0; x < COLS; ++x)
+            {
+                const float l = scale*std::exp(3.f*std::sin(0.13f*x)*std::cos(0.07f*y) +
+                                               0.002f*x*y);
+                R(x, y) = 1.2f*l;
+                G(x, y) = l;
+                B(x, y) = 0.7f*l;
+                Y(x, y) = l;
+            }
+        }
+    }
+
+    pfs::Array2Df R, G, B, Y;
+};
+
+int tonemap(Image& image, float contrast, float saturation, float detail,
+            Mantiuk06Session* session)
+{
+    pfs::Progress ph;
+    return tmo_mantiuk06_contmap(image.R, image.G, image.B, image.Y,
+                                 contrast, saturation, detail, ITMAX, TOL,
+                                 ph, NULL, session);
+}
+
+float maxDifference(const pfs::Array2Df& a, const pfs::Array2Df& b)
+{
+    float result = 0.f;
+    for (size_t i = 0; i < a.size(); ++i)
+    {
+        result = std::max(result, std::fabs(a(i) - b(i)));
+    }
+    return result;
+}
+}
+
+TEST(Mantiuk06Session, FirstCallMatchesStill)
+{
+    Image still;
+    tonemap(still, 0.3f, 0.8f, 1.f, NULL);
+
+    Mantiuk06Session session;
+    Image image;
+    EXPECT_EQ(PFSTMO_OK, tonemap(image, 0.3f, 0.8f, 1.f, &session));
+
+    EXPECT_EQ(0.f, maxDifference(still.Y, image.Y));
+    EXPECT_EQ(0.f, maxDifference(still.R, image.R));
+    EXPECT_EQ(1u, session.solves);
+    EXPECT_EQ(0u, session.warmStarts);
+}
+
+TEST(Mantiuk06Session, SaturationSkipsSolve)
+{
+    Mantiuk06Session session;
+    Image first;
+    tonemap(first, 0.3f, 0.8f, 1.f, &session);
+
+    Image second;
+    tonemap(second, 0.3f, 0.5f, 1.f, &session);
+    EXPECT_EQ(1u, session.solves);
+
+    Image still;
+    tonemap(still, 0.3f, 0.5f, 1.f, NULL);
+    EXPECT_EQ(0.f, maxDifference(still.Y, second.Y));
+    EXPECT_EQ(0.f, maxDifference(still.G, second.G));
+}
+
+TEST(Mantiuk06Session, ContrastWarmStarts)
+{
+    Mantiuk06Session session;
+    Image first;
+    tonemap(first, 0.3f, 0.8f, 1.f, &session);
+
+    Image second;
+    tonemap(second, 0.2f, 0.8f, 1.f, &session);
+    EXPECT_EQ(2u, session.solves);
+    EXPECT_EQ(1u, session.warmStarts);
+
+    Image still;
+    tonemap(still, 0.2f, 0.8f, 1.f, NULL);
+    // both are within the tolerance of the solver
+    EXPECT_LT(maxDifference(still.Y, second.Y), 0.05f);
+
+    // the detail factor invalidates the R pyramid, but not the warm start
+    Image third;
+    tonemap(third, 0.2f, 0.8f, 2.f, &session);
+    EXPECT_EQ(3u, session.solves);
+    EXPECT_EQ(2u, session.warmStarts);
+}
+
+TEST(Mantiuk06Session, NewFrameStartsOver)
+{
+    Mantiuk06Session session;
+    Image first;
+    tonemap(first, 0.3f, 0.8f, 1.f, &session);
+
+    Image brighter(2.f);
+    tonemap(brighter, 0.3f, 0.8f, 1.f, &session);
+    EXPECT_EQ(2u, session.solves);
+    EXPECT_EQ(0u, session.warmStarts);
+
+    Image still(2.f);
+    tonemap(still, 0.3f, 0.8f, 1.f, NULL);
+    EXPECT_EQ(0.f, maxDifference(still.Y, brighter.Y));
+}
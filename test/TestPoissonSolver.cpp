@@ -22,11 +22,47 @@
 #include <gtest/gtest.h>
 
 #include <Libpfs/array2d.h>
+#include <Libpfs/bufferarena.h>
+#include <Libpfs/progress.h>
 #include <TonemappingOperators/fattal02/pde.h>
 #include <HdrWizard/AutoAntighosting.h>
 
 #include <cmath>
 
+namespace
+{
+// Laplace U with reflected boundaries, as solved by solve_pde_multigrid
+float laplace(const Array2Df& U, int x, int y)
+{
+    const int cols = U.getCols();
+    const int rows = U.getRows();
+
+    float sum = 0.f;
+    if ( x > 0 )        sum += U(x-1, y) - U(x, y);
+    if ( x+1 < cols )   sum += U(x+1, y) - U(x, y);
+    if ( y > 0 )        sum += U(x, y-1) - U(x, y);
+    if ( y+1 < rows )   sum += U(x, y+1) - U(x, y);
+    return sum;
+}
+
+// relative norm of Laplace U - F
+double relativeResidual(const Array2Df& U, const Array2Df& F)
+{
+    double residual = 0.0;
+    double norm = 0.0;
+    for (size_t y = 0; y < U.getRows(); y++)
+    {
+        for (size_t x = 0; x < U.getCols(); x++)
+        {
+            const double r = laplace(U, x, y) - F(x, y);
+            residual += r*r;
+            norm += F(x, y)*F(x, y);
+        }
+    }
+    return std::sqrt(residual/norm);
+}
+}
+
 TEST(solve_pde_dct, Test1)
 {
     Array2Df U(100,100);
@@ -48,3 +84,70 @@ TEST(solve_pde_dct, Test1)
     ASSERT_LE(residual, 1e-2);
 }
 
+
+TEST(solve_pde_multigrid, Cycles)
+{
+    // not a power of two, with odd sizes on some levels
+    const int cols = 157;
+    const int rows = 61;
+
+    Array2Df expected(cols, rows);
+    for (int y = 0; y < rows; y++)
+    {
+        for (int x = 0; x < cols; x++)
+        {
+            expected(x, y) = std::sin(0.05f*x)*std::cos(0.11f*y) +
+                    0.1f*std::sin(1.3f*x + 0.7f*y);
+        }
+    }
+
+    Array2Df F(cols, rows);
+    for (int y = 0; y < rows; y++)
+    {
+        for (int x = 0; x < cols; x++)
+        {
+            F(x, y) = laplace(expected, x, y);
+        }
+    }
+
+    const MultigridCycle cycles[] = {
+        MULTIGRID_V_CYCLE, MULTIGRID_W_CYCLE, MULTIGRID_F_CYCLE
+    };
+
+    BufferArena arena;
+    for (int c = 0; c < 3; c++)
+    {
+        MultigridParams params;
+        params.cycle = cycles[c];
+
+        Array2Df U(cols, rows);
+        pfs::Progress ph;
+        solve_pde_multigrid(&F, &U, ph, &arena, params);
+
+        EXPECT_LE(relativeResidual(U, F), 2*params.tolerance) << "cycle " << c;
+
+        // the solution is defined up to a constant
+        const float offset = U(0, 0) - expected(0, 0);
+        for (int i = 0; i < cols*rows; i++)
+        {
+            ASSERT_NEAR(U(i) - offset, expected(i), 1e-2f) << "cycle " << c;
+        }
+    }
+}
+
+TEST(solve_pde_multigrid, Incompatible)
+{
+    // the mean of F has no solution with reflected boundaries, and is ignored
+    Array2Df F(64, 48);
+    F.fill(1.f);
+    F(10, 10) = 5.f;
+
+    Array2Df U(64, 48);
+    pfs::Progress ph;
+    solve_pde_multigrid(&F, &U, ph);
+
+    for (size_t i = 0; i < U.size(); i++)
+    {
+        ASSERT_TRUE(std::isfinite(U(i)));
+    }
+}
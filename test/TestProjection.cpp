@@ -0,0 +1,123 @@
+/*
+ * This file is a part of Luminance HDR package
+ * ----------------------------------------------------------------------
+ * Copyright (C) 2017 Luminance HDR developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+#include <Libpfs/array2d.h>
+#include <Libpfs/manip/projection.h>
+
+namespace
+{
+void fillSmooth(pfs::Array2Df& in)
+{
+    for (size_t y = 0; y < in.getRows(); ++y)
+    {
+        for (size_t x = 0; x < in.getCols(); ++x)
+        {
+            in(x, y) = 2.f + std::cos(0.05f*y) + 0.5f*std::sin(0.1f*x);
+        }
+    }
+}
+}
+
+TEST(Projection, SeparableDirectionsMatchPerSample)
+{
+    const Projection* projections[] = {
+        &CylindricalProjection::singleton,
+        &PolarProjection::singleton
+    };
+
+    double u[16];
+    for (int i = 0; i < 16; ++i)
+    {
+        u[i] = (i + 0.25)/16.;
+    }
+
+    for (int p = 0; p < 2; ++p)
+    {
+        ColumnTable table;
+        projections[p]->prepareColumns(u, 16, table);
+        ASSERT_EQ(table.size(), 16u);
+
+        for (double v = 0.05; v < 1.; v += 0.1)
+        {
+            Vector3D directions[16];
+            projections[p]->uvToDirections(u, 16, v, table, directions);
+
+            for (int i = 0; i < 16; ++i)
+            {
+                Vector3D d = projections[p]->uvToDirection(u[i], v);
+                EXPECT_NEAR(directions[i].x, d.x, 1e-12);
+                EXPECT_NEAR(directions[i].y, d.y, 1e-12);
+                EXPECT_NEAR(directions[i].z, d.z, 1e-12);
+            }
+        }
+    }
+}
+
+TEST(Projection, FullTurnIsIdentity)
+{
+    pfs::Array2Df in(128, 64);
+    pfs::Array2Df reference(128, 64);
+    pfs::Array2Df out(128, 64);
+    fillSmooth(in);
+
+    TransformInfo info;
+    info.srcProjection = &PolarProjection::singleton;
+    info.dstProjection = &PolarProjection::singleton;
+    transformArray(&in, &reference, &info);
+
+    info.xRotate = 360;
+    info.yRotate = -360;
+    info.zRotate = 720;
+    transformArray(&in, &out, &info);
+
+    for (size_t i = 0; i < in.size(); ++i)
+    {
+        EXPECT_NEAR(out(i), reference(i), 1e-3f);
+    }
+}
+
+TEST(Projection, MirrorBallOversampling)
+{
+    pfs::Array2Df in(128, 64);
+    pfs::Array2Df out(64, 64);
+    fillSmooth(in);
+    out.fill(0.f);
+
+    TransformInfo info;
+    info.srcProjection = &CylindricalProjection::singleton;
+    info.dstProjection = &MirrorBallProjection::singleton;
+    info.oversampleFactor = 3;
+
+    transformArray(&in, &out, &info);
+
+    for (size_t i = 0; i < out.size(); ++i)
+    {
+        ASSERT_TRUE(std::isfinite(out(i)));
+    }
+    // the centre of the ball sees the whole image
+    EXPECT_GT(out(32, 32), 0.5f);
+    // corners are outside of the ball
+    EXPECT_EQ(out(0, 0), 0.f);
+}
@@ -0,0 +1,224 @@
+/*
+ * This file is a part of Luminance HDR package
+ * ----------------------------------------------------------------------
+ * Copyright (C) 2017 Luminance HDR developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdlib>
+
+#include <Libpfs/array2d.h>
+#include <Libpfs/bufferarena.h>
+#include <Libpfs/manip/pyramid.h>
+
+using namespace pfs;
+
+namespace
+{
+void fillRandom(Array2Df& data)
+{
+    srand(42);
+    for (size_t i = 0; i < data.size(); ++i)
+    {
+        data(i) = static_cast<float>(rand()) / RAND_MAX;
+    }
+}
+
+// straightforward 2D convolution with the outer product of the kernel
+float referenceSample(const Array2Df& in, long x, long y,
+                      const PyramidKernel& kernel, PyramidBorder border,
+                      long step, long dilation)
+{
+    const long cols = in.getCols();
+    const long rows = in.getRows();
+
+    double sum = 0.0;
+    for (size_t j = 0; j < kernel.taps.size(); ++j)
+    {
+        for (size_t i = 0; i < kernel.taps.size(); ++i)
+        {
+            long sx = step*x + dilation*(kernel.origin + static_cast<long>(i));
+            long sy = step*y + dilation*(kernel.origin + static_cast<long>(j));
+            if ( border == BORDER_ZERO )
+            {
+                if ( sx < 0 || sy < 0 || sx >= cols || sy >= rows ) continue;
+            }
+            else if ( border == BORDER_CLAMP )
+            {
+                sx = std::min(std::max(sx, 0L), cols - 1);
+                sy = std::min(std::max(sy, 0L), rows - 1);
+            }
+            else
+            {
+                while ( sx < 0 || sx >= cols )
+                    sx = (sx < 0) ? -sx : 2*(cols - 1) - sx;
+                while ( sy < 0 || sy >= rows )
+                    sy = (sy < 0) ? -sy : 2*(rows - 1) - sy;
+            }
+            sum += kernel.taps[i]*kernel.taps[j]*in(sx, sy);
+        }
+    }
+    return static_cast<float>(sum);
+}
+
+void checkFilter(const Array2Df& in, size_t outCols, size_t outRows,
+                 const PyramidKernel& kernel, PyramidBorder border,
+                 size_t step, size_t dilation)
+{
+    Array2Df out(outCols, outRows);
+    separableFilter(in, out, kernel, border, step, dilation);
+
+    for (size_t y = 0; y < outRows; ++y)
+    {
+        for (size_t x = 0; x < outCols; ++x)
+        {
+            ASSERT_NEAR(out(x, y),
+                        referenceSample(in, x, y, kernel, border, step, dilation),
+                        1e-5f)
+                    << "x = " << x << ", y = " << y << ", border = " << border
+                    << ", step = " << step << ", dilation = " << dilation;
+        }
+    }
+}
+}
+
+TEST(Pyramid, SeparableFilter)
+{
+    Array2Df in(37, 23);
+    fillRandom(in);
+
+    const PyramidBorder borders[] = { BORDER_CLAMP, BORDER_MIRROR, BORDER_ZERO };
+    for (int b = 0; b < 3; ++b)
+    {
+        checkFilter(in, 37, 23, PyramidKernel::binomial(), borders[b], 1, 1);
+        checkFilter(in, 37, 23, PyramidKernel::burtAdelson(), borders[b], 1, 1);
+        checkFilter(in, 37, 23, PyramidKernel::burtAdelson(), borders[b], 1, 4);
+        checkFilter(in, 18, 11, PyramidKernel::binomialBox(), borders[b], 2, 1);
+        checkFilter(in, 18, 11, PyramidKernel::burtAdelson(), borders[b], 2, 1);
+    }
+    // kernels wider than the image are reflected more than once
+    checkFilter(in, 37, 23, PyramidKernel::burtAdelson(), BORDER_MIRROR, 1, 32);
+    // output larger than the reduced image, padded with zeros
+    checkFilter(in, 32, 32, PyramidKernel::burtAdelson(), BORDER_ZERO, 2, 1);
+}
+
+TEST(Pyramid, InPlaceBlur)
+{
+    BufferArena arena;
+    Array2Df in(64, 48);
+    fillRandom(in);
+
+    Array2Df out(64, 48);
+    gaussianBlur(in, out, PyramidKernel::binomial(), BORDER_CLAMP, &arena);
+    gaussianBlur(in, in, PyramidKernel::binomial(), BORDER_CLAMP, &arena);
+
+    for (size_t i = 0; i < in.size(); ++i)
+    {
+        ASSERT_EQ(in(i), out(i));
+    }
+}
+
+TEST(Pyramid, BinomialBoxReduce)
+{
+    // binomialBox() is the [1 2 1]/4 blur followed by the average of 2x2
+    // blocks, as used by the gradient domain compression of Fattal et al.
+    Array2Df in(41, 30);
+    fillRandom(in);
+
+    Array2Df blurred(41, 30);
+    gaussianBlur(in, blurred, PyramidKernel::binomial(), BORDER_CLAMP);
+
+    Array2Df reduced(20, 15);
+    gaussianReduce(in, reduced, PyramidKernel::binomialBox(), BORDER_CLAMP);
+
+    for (size_t y = 0; y < reduced.getRows(); ++y)
+    {
+        for (size_t x = 0; x < reduced.getCols(); ++x)
+        {
+            const float box = (blurred(2*x, 2*y) + blurred(2*x+1, 2*y) +
+                               blurred(2*x, 2*y+1) + blurred(2*x+1, 2*y+1)) * 0.25f;
+            ASSERT_NEAR(reduced(x, y), box, 1e-5f);
+        }
+    }
+}
+
+TEST(Pyramid, GaussianPyramid)
+{
+    BufferArena arena;
+    Array2Df in(100, 61);
+    fillRandom(in);
+
+    GaussianPyramid pyramid(&arena);
+    pyramid.build(in, 4, PyramidKernel::burtAdelson(), BORDER_CLAMP);
+
+    ASSERT_EQ(pyramid.levels(), 4u);
+    EXPECT_EQ(pyramid[0].getCols(), 100u);
+    EXPECT_EQ(pyramid[0].getRows(), 61u);
+    EXPECT_EQ(pyramid[3].getCols(), 12u);
+    EXPECT_EQ(pyramid[3].getRows(), 7u);
+    for (size_t i = 0; i < in.size(); ++i)
+    {
+        ASSERT_EQ(pyramid[0](i), in(i));
+    }
+
+    Array2Df expected(50, 30);
+    gaussianReduce(in, expected, PyramidKernel::burtAdelson(), BORDER_CLAMP);
+    for (size_t i = 0; i < expected.size(); ++i)
+    {
+        ASSERT_EQ(pyramid[1](i), expected(i));
+    }
+
+    // a new image of the same size is built in the same storage
+    const float* storage = pyramid[2].data();
+    pyramid.build(in, 4, PyramidKernel::burtAdelson(), BORDER_ZERO);
+    EXPECT_EQ(pyramid[2].data(), storage);
+
+    pyramid.build(expected, 3, PyramidKernel::burtAdelson(), BORDER_CLAMP);
+    ASSERT_EQ(pyramid.levels(), 3u);
+    EXPECT_EQ(pyramid[0].getCols(), 50u);
+    EXPECT_EQ(pyramid[2].getRows(), 7u);
+}
+
+TEST(Pyramid, DownsampleUpsample)
+{
+    const size_t sizes[][2] = { { 64, 48 }, { 65, 49 } };
+    for (int s = 0; s < 2; ++s)
+    {
+        const size_t cols = sizes[s][0];
+        const size_t rows = sizes[s][1];
+
+        Array2Df in(cols, rows);
+        in.fill(3.f);
+
+        Array2Df small(cols/2, rows/2);
+        downsample(cols, rows, in.data(), small.data());
+        for (size_t i = 0; i < small.size(); ++i)
+        {
+            ASSERT_NEAR(small(i), 3.f, 1e-4f);
+        }
+
+        Array2Df big(cols, rows);
+        upsample(cols, rows, small.data(), big.data());
+        for (size_t i = 0; i < big.size(); ++i)
+        {
+            ASSERT_TRUE(std::isfinite(big(i)));
+        }
+    }
+}
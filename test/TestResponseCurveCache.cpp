@@ -0,0 +1,143 @@
+/*
+ * This file is a part of Luminance HDR package
+ * ----------------------------------------------------------------------
+ * Copyright (C) 2017 Luminance HDR developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <Libpfs/frame.h>
+#include <HdrCreation/responsecache.h>
+
+#include "SyntheticExposures.h"
+
+using namespace libhdr::fusion;
+
+namespace
+{
+// curves are stored in the temporary directory, not in the current one
+std::string cacheDirectory()
+{
+    std::string directory = ::testing::TempDir();
+    if ( !directory.empty() && directory[directory.size() - 1] == '/' )
+    {
+        directory.erase(directory.size() - 1);
+    }
+    return directory;
+}
+}
+
+TEST(TestResponseCurveCache, Key)
+{
+    EXPECT_EQ(ResponseCurveCache::key("Canon", "Canon EOS 5D Mark III", 100.f, "JPEG8"),
+              "Canon_Canon_EOS_5D_Mark_III_ISO100_JPEG8");
+    EXPECT_EQ(ResponseCurveCache::key("NIKON CORPORATION", "NIKON D810/ ", 399.6f, "RAW"),
+              "NIKON_CORPORATION_NIKON_D810_ISO400_RAW");
+    EXPECT_EQ(ResponseCurveCache::key("", "X100F", 200.f, "TIFF16"), "X100F_ISO200_TIFF16");
+    EXPECT_TRUE(ResponseCurveCache::key("Canon", "", 100.f, "JPEG8").empty());
+    EXPECT_TRUE(ResponseCurveCache::key("Canon", "EOS 80D", 100.f, "").empty());
+
+    // the curves of brackets decoded differently are kept apart
+    EXPECT_NE(ResponseCurveCache::key("Canon", "EOS 80D", 100.f, "JPEG8"),
+              ResponseCurveCache::key("Canon", "EOS 80D", 100.f, "TIFF16"));
+    EXPECT_NE(ResponseCurveCache::key("Canon", "EOS 80D", 100.f, "TIFF16"),
+              ResponseCurveCache::key("Canon", "EOS 80D", 100.f, "RAW"));
+}
+
+TEST(TestResponseCurveCache, StoreAndLoad)
+{
+    ResponseCurveCache cache(cacheDirectory());
+    const std::string key = ResponseCurveCache::key("Test", "StoreAndLoad", 100.f, "JPEG8");
+
+    ResponseCurve gamma(RESPONSE_GAMMA);
+    cache.store(key, gamma);
+
+    // a second instance reads the curve from disk
+    ResponseCurveCache otherCache(cacheDirectory());
+    ResponseCurve loaded(RESPONSE_LINEAR);
+    ASSERT_TRUE(otherCache.load(key, loaded));
+    EXPECT_EQ(loaded.getType(), RESPONSE_CUSTOM);
+    for (size_t i = 0; i < ResponseCurve::NUM_BINS; i += 97)
+    {
+        EXPECT_NEAR(loaded.get(RESPONSE_CHANNEL_RED)[i],
+                    gamma.get(RESPONSE_CHANNEL_RED)[i],
+                    1e-4f*gamma.get(RESPONSE_CHANNEL_RED)[i]);
+    }
+
+    // storing again replaces the curve on disk
+    ResponseCurve linear(RESPONSE_LINEAR);
+    cache.store(key, linear);
+    ResponseCurveCache thirdCache(cacheDirectory());
+    ASSERT_TRUE(thirdCache.load(key, loaded));
+    for (size_t i = 0; i < ResponseCurve::NUM_BINS; i += 97)
+    {
+        EXPECT_NEAR(loaded.get(RESPONSE_CHANNEL_RED)[i],
+                    linear.get(RESPONSE_CHANNEL_RED)[i],
+                    1e-4f*linear.get(RESPONSE_CHANNEL_RED)[i]);
+    }
+
+    ResponseCurve missing(RESPONSE_LINEAR);
+    EXPECT_FALSE(otherCache.load(ResponseCurveCache::key("Test", "Missing", 100.f, "JPEG8"), missing));
+    EXPECT_EQ(missing.getType(), RESPONSE_LINEAR);
+
+    std::remove(cache.fileName(key).c_str());
+}
+
+TEST(TestResponseCurveCache, ReuseSkipsCalibration)
+{
+    ResponseCurveCache cache(cacheDirectory());
+    const std::string key = ResponseCurveCache::key("Test", "Reuse", 100.f, "JPEG8");
+    std::remove(cache.fileName(key).c_str());
+
+    std::vector<FrameEnhanced> frames = buildExposures(64, 48);
+    WeightFunction weight(WEIGHT_GAUSSIAN);
+
+    // first merge calibrates and stores the curve
+    ResponseCurve calibrated(RESPONSE_LINEAR);
+    std::unique_ptr<pfs::Frame> first(
+                cache.computeFusion(key, RESPONSE_CACHE_REUSE, ROBERTSON_AUTO,
+                                    calibrated, weight, frames));
+
+    ResponseCurve stored(RESPONSE_LINEAR);
+    ASSERT_TRUE(cache.load(key, stored));
+
+    // second merge only applies it
+    ResponseCurve reused(RESPONSE_LINEAR);
+    std::unique_ptr<pfs::Frame> second(
+                cache.computeFusion(key, RESPONSE_CACHE_REUSE, ROBERTSON_AUTO,
+                                    reused, weight, frames));
+    EXPECT_EQ(reused.get(RESPONSE_CHANNEL_GREEN), stored.get(RESPONSE_CHANNEL_GREEN));
+
+    ResponseCurve applied(stored);
+    std::unique_ptr<pfs::Frame> expected(
+                IFusionOperator::build(ROBERTSON)->computeFusion(applied, weight, frames));
+
+    const pfs::Channel* secondY = second->getChannel("Y");
+    const pfs::Channel* expectedY = expected->getChannel("Y");
+    for (size_t i = 0; i < expectedY->size(); ++i)
+    {
+        EXPECT_FLOAT_EQ((*expectedY)(i), (*secondY)(i));
+    }
+
+    std::remove(cache.fileName(key).c_str());
+}
@@ -0,0 +1,97 @@
+/*
+ * This file is a part of Luminance HDR package
+ * ----------------------------------------------------------------------
+ * Copyright (C) 2017 Luminance HDR developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+#include <Libpfs/frame.h>
+#include <HdrCreation/fusionoperator.h>
+#include <HdrCreation/robertson02.h>
+
+#include "SyntheticExposures.h"
+
+using namespace libhdr::fusion;
+
+using namespace libhdr::fusion;
+
+TEST(TestRobertsonCalibration, SampledMatchesFullCalibration)
+{
+    const size_t width = 640;
+    const size_t height = 480;
+    std::vector<FrameEnhanced> frames = buildExposures(width, height);
+
+    ResponseCurve fullResponse(RESPONSE_LINEAR);
+    ResponseCurve sampledResponse(RESPONSE_LINEAR);
+    WeightFunction weight(WEIGHT_GAUSSIAN);
+
+    FusionOperatorPtr fullOperator = std::make_shared<RobertsonOperatorAuto>(0);
+    FusionOperatorPtr sampledOperator = std::make_shared<RobertsonOperatorAuto>(width*height/8);
+
+    std::unique_ptr<pfs::Frame> full(fullOperator->computeFusion(fullResponse, weight, frames));
+    std::unique_ptr<pfs::Frame> sampled(sampledOperator->computeFusion(sampledResponse, weight, frames));
+
+    // the two responses agree where the images have samples
+    for (size_t i = 64; i < ResponseCurve::NUM_BINS - 64; i += 64)
+    {
+        const float sample = float(i)/(ResponseCurve::NUM_BINS - 1);
+        const float f = fullResponse(sample, RESPONSE_CHANNEL_GREEN);
+        const float s = sampledResponse(sample, RESPONSE_CHANNEL_GREEN);
+        EXPECT_NEAR(s, f, 0.05f*f + 1e-4f) << "bin " << i;
+    }
+
+    const pfs::Channel* fullG = full->getChannel("Y");
+    const pfs::Channel* sampledG = sampled->getChannel("Y");
+    ASSERT_TRUE(fullG != NULL);
+    ASSERT_TRUE(sampledG != NULL);
+
+    double error = 0.;
+    for (size_t i = 0; i < fullG->size(); ++i)
+    {
+        error += std::abs((*sampledG)(i) - (*fullG)(i)) / ((*fullG)(i) + 1e-6f);
+    }
+    EXPECT_LT(error/fullG->size(), 0.02);
+}
+
+TEST(TestRobertsonCalibration, SmallImageUsesAllPixels)
+{
+    std::vector<FrameEnhanced> frames = buildExposures(64, 48);
+
+    ResponseCurve fullResponse(RESPONSE_LINEAR);
+    ResponseCurve sampledResponse(RESPONSE_LINEAR);
+    WeightFunction weight(WEIGHT_GAUSSIAN);
+
+    FusionOperatorPtr fullOperator = std::make_shared<RobertsonOperatorAuto>(0);
+    FusionOperatorPtr sampledOperator = std::make_shared<RobertsonOperatorAuto>();
+
+    std::unique_ptr<pfs::Frame> full(fullOperator->computeFusion(fullResponse, weight, frames));
+    std::unique_ptr<pfs::Frame> sampled(sampledOperator->computeFusion(sampledResponse, weight, frames));
+
+    const pfs::Channel* fullG = full->getChannel("Y");
+    const pfs::Channel* sampledG = sampled->getChannel("Y");
+    for (size_t i = 0; i < fullG->size(); ++i)
+    {
+        EXPECT_FLOAT_EQ((*fullG)(i), (*sampledG)(i));
+    }
+}
@@ -0,0 +1,215 @@
+/*
+ * This file is a part of Luminance HDR package
+ * ----------------------------------------------------------------------
+ * Copyright (C) 2017 Luminance HDR developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+#include <Libpfs/utils/simd.h>
+#include <Libpfs/utils/numeric.h>
+#include <Libpfs/utils/dotproduct.h>
+
+using namespace pfs::utils;
+
+namespace
+{
+// odd size, to exercise the scalar tails of every instruction set
+const size_t SIZE = 1031;
+
+float uniform(float lo, float hi)
+{
+    return lo + (hi - lo)*static_cast<float>(std::rand())/RAND_MAX;
+}
+
+std::vector<float> randomVector(float lo, float hi)
+{
+    std::vector<float> v(SIZE);
+    for (size_t i = 0; i < SIZE; ++i) v[i] = uniform(lo, hi);
+    return v;
+}
+
+std::vector<SimdInstructionSet> supportedInstructionSets()
+{
+    std::vector<SimdInstructionSet> sets;
+    for (int isa = SIMD_SCALAR; isa <= simdSupportedInstructionSet(); ++isa)
+    {
+        sets.push_back(static_cast<SimdInstructionSet>(isa));
+    }
+    return sets;
+}
+
+void expectRelativeNear(const std::vector<float>& expected,
+                        const std::vector<float>& computed,
+                        float tolerance)
+{
+    for (size_t i = 0; i < expected.size(); ++i)
+    {
+        ASSERT_NEAR(expected[i], computed[i],
+                    tolerance*std::max(1.f, std::fabs(expected[i])))
+                << "at index " << i;
+    }
+}
+}
+
+TEST(TestSimd, ArithmeticMatchesScalar)
+{
+    const std::vector<float> a = randomVector(-10.f, 10.f);
+    const std::vector<float> b = randomVector(0.5f, 10.f);
+    const float s = 3.14159f;
+
+    const simd::Kernels& ref = simd::kernels(SIMD_SCALAR);
+    std::vector<float> expected(SIZE);
+    std::vector<float> computed(SIZE);
+
+    const std::vector<SimdInstructionSet> sets = supportedInstructionSets();
+    for (size_t i = 0; i < sets.size(); ++i)
+    {
+        SCOPED_TRACE(simdInstructionSetName(sets[i]));
+        const simd::Kernels& k = simd::kernels(sets[i]);
+
+        ref.add(a.data(), b.data(), expected.data(), SIZE);
+        k.add(a.data(), b.data(), computed.data(), SIZE);
+        expectRelativeNear(expected, computed, 1e-6f);
+
+        ref.sub(a.data(), b.data(), expected.data(), SIZE);
+        k.sub(a.data(), b.data(), computed.data(), SIZE);
+        expectRelativeNear(expected, computed, 1e-6f);
+
+        ref.mul(a.data(), b.data(), expected.data(), SIZE);
+        k.mul(a.data(), b.data(), computed.data(), SIZE);
+        expectRelativeNear(expected, computed, 1e-6f);
+
+        ref.div(a.data(), b.data(), expected.data(), SIZE);
+        k.div(a.data(), b.data(), computed.data(), SIZE);
+        expectRelativeNear(expected, computed, 1e-6f);
+
+        ref.sadd(a.data(), s, expected.data(), SIZE);
+        k.sadd(a.data(), s, computed.data(), SIZE);
+        expectRelativeNear(expected, computed, 1e-6f);
+
+        ref.smul(a.data(), s, expected.data(), SIZE);
+        k.smul(a.data(), s, computed.data(), SIZE);
+        expectRelativeNear(expected, computed, 1e-6f);
+
+        ref.adds(a.data(), s, b.data(), expected.data(), SIZE);
+        k.adds(a.data(), s, b.data(), computed.data(), SIZE);
+        expectRelativeNear(expected, computed, 1e-5f);
+
+        EXPECT_NEAR(ref.dot(a.data(), b.data(), SIZE),
+                    k.dot(a.data(), b.data(), SIZE), 1e-6);
+        EXPECT_NEAR(ref.dotSelf(a.data(), SIZE),
+                    k.dotSelf(a.data(), SIZE), 1e-6);
+    }
+}
+
+TEST(TestSimd, TranscendentalMatchesScalar)
+{
+    const std::vector<float> a = randomVector(1e-6f, 1e6f);
+    const std::vector<float> e = randomVector(-40.f, 40.f);
+
+    const simd::Kernels& ref = simd::kernels(SIMD_SCALAR);
+    std::vector<float> expected(SIZE);
+    std::vector<float> computed(SIZE);
+
+    const std::vector<SimdInstructionSet> sets = supportedInstructionSets();
+    for (size_t i = 0; i < sets.size(); ++i)
+    {
+        SCOPED_TRACE(simdInstructionSetName(sets[i]));
+        const simd::Kernels& k = simd::kernels(sets[i]);
+
+        ref.log2s(a.data(), 0.5f, expected.data(), SIZE);
+        k.log2s(a.data(), 0.5f, computed.data(), SIZE);
+        expectRelativeNear(expected, computed, 1e-5f);
+
+        ref.exp2s(e.data(), 1.5f, expected.data(), SIZE);
+        k.exp2s(e.data(), 1.5f, computed.data(), SIZE);
+        expectRelativeNear(expected, computed, 1e-5f);
+
+        ref.pow(a.data(), 0.45f, expected.data(), SIZE);
+        k.pow(a.data(), 0.45f, computed.data(), SIZE);
+        expectRelativeNear(expected, computed, 1e-5f);
+    }
+}
+
+TEST(TestSimd, PowOfNonPositiveIsZero)
+{
+    std::vector<float> a(SIZE, -1.f);
+    a[0] = 0.f;
+    std::vector<float> b(SIZE, 1.f);
+
+    const std::vector<SimdInstructionSet> sets = supportedInstructionSets();
+    for (size_t i = 0; i < sets.size(); ++i)
+    {
+        SCOPED_TRACE(simdInstructionSetName(sets[i]));
+        simd::kernels(sets[i]).pow(a.data(), 2.2f, b.data(), SIZE);
+        for (size_t j = 0; j < SIZE; ++j)
+        {
+            ASSERT_EQ(0.f, b[j]);
+        }
+    }
+}
+
+TEST(TestSimd, SelectInstructionSet)
+{
+    const SimdInstructionSet supported = simdSupportedInstructionSet();
+
+    EXPECT_EQ(SIMD_SCALAR, setSimdInstructionSet(SIMD_SCALAR));
+    EXPECT_EQ(SIMD_SCALAR, simdInstructionSet());
+    // requests above the hardware capabilities are lowered
+    EXPECT_EQ(supported, setSimdInstructionSet(SIMD_AVX512));
+    EXPECT_EQ(supported, simdInstructionSet());
+}
+
+TEST(TestSimd, ParallelVectorFunctions)
+{
+    // larger than one chunk, so that the work is split among threads
+    const size_t size = 100003;
+    std::vector<float> a(size);
+    std::vector<float> out(size);
+    for (size_t i = 0; i < size; ++i) a[i] = uniform(0.01f, 100.f);
+
+    vlog(a.data(), out.data(), size);
+    for (size_t i = 0; i < size; ++i)
+    {
+        ASSERT_NEAR(std::log(a[i]), out[i], 1e-5f*std::max(1.f, std::fabs(out[i])));
+    }
+
+    vexp(out.data(), out.data(), size);
+    for (size_t i = 0; i < size; ++i)
+    {
+        ASSERT_NEAR(a[i], out[i], 1e-4f*a[i]);
+    }
+
+    vlog10(a.data(), out.data(), size);
+    vexp10(out.data(), out.data(), size);
+    for (size_t i = 0; i < size; ++i)
+    {
+        ASSERT_NEAR(a[i], out[i], 1e-4f*a[i]);
+    }
+
+    double expected = 0.0;
+    for (size_t i = 0; i < size; ++i) expected += a[i]*a[i];
+    EXPECT_NEAR(expected, dotProduct(a.data(), size), 1e-6*expected);
+    EXPECT_NEAR(expected, dotProduct(a.data(), a.data(), size), 1e-6*expected);
+}
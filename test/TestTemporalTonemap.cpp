@@ -0,0 +1,158 @@
+/*
+ * This file is a part of Luminance HDR package
+ * ----------------------------------------------------------------------
+ * Copyright (C) 2017 Luminance HDR developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+#include <gtest/gtest.h>
+
+#include <Libpfs/frame.h>
+#include <Libpfs/progress.h>
+#include <TonemappingOperators/pfstmo.h>
+#include <TonemappingOperators/mantiuk08/display_adaptive_tmo.h>
+#include <TonemappingOperators/pattanaik00/tmo_pattanaik00.h>
+#include <TonemappingOperators/reinhard02/tmo_reinhard02.h>
+
+namespace
+{
+// gray frame with a soft horizontal gradient around \a luminance
+void fillFrame(pfs::Frame& frame, float luminance)
+{
+    pfs::Channel *X, *Y, *Z;
+    frame.createXYZChannels(X, Y, Z);
+    for (size_t y = 0; y < frame.getHeight(); ++y)
+    {
+        for (size_t x = 0; x < frame.getWidth(); ++x)
+        {
+            const float v = luminance*(0.5f + float(x)/frame.getWidth());
+            (*X)(x, y) = v;
+            (*Y)(x, y) = v;
+            (*Z)(x, y) = v;
+        }
+    }
+}
+
+float meanLuminance(pfs::Frame& frame)
+{
+    pfs::Channel *X, *Y, *Z;
+    frame.getXYZChannels(X, Y, Z);
+    double sum = 0.0;
+    for (size_t i = 0; i < Y->size(); ++i)
+    {
+        sum += (*Y)(i);
+    }
+    return static_cast<float>(sum/Y->size());
+}
+}
+
+TEST(TemporalTonemap, Pattanaik00AdaptsGradually)
+{
+    pfs::Progress ph;
+    VisualAdaptationModel sequence;
+
+    pfs::Frame dark(64, 48);
+    fillFrame(dark, 1.f);
+    pfstmo_pattanaik00(dark, false, 1.f, -1.f, -1.f, true, ph, &sequence, 0.f);
+    const float darkAcone = sequence.getAcone();
+
+    pfs::Frame bright(64, 48);
+    fillFrame(bright, 1000.f);
+    pfstmo_pattanaik00(bright, false, 1.f, -1.f, -1.f, true, ph, &sequence, 1.f/25);
+
+    VisualAdaptationModel still;
+    pfs::Frame reference(64, 48);
+    fillFrame(reference, 1000.f);
+    still.setAdaptation(*reference.getChannel("Y"));
+
+    EXPECT_GT(sequence.getAcone(), darkAcone);
+    EXPECT_LT(sequence.getAcone(), still.getAcone());
+}
+
+TEST(TemporalTonemap, Pattanaik00KeepsUserAdaptation)
+{
+    pfs::Progress ph;
+    VisualAdaptationModel sequence;
+
+    // without autolum every frame uses the adaptation set by the user
+    pfs::Frame dark(64, 48);
+    fillFrame(dark, 1.f);
+    pfstmo_pattanaik00(dark, false, 1.f, 50.f, 20.f, false, ph, &sequence, 0.f);
+
+    pfs::Frame bright(64, 48);
+    fillFrame(bright, 1000.f);
+    pfstmo_pattanaik00(bright, false, 1.f, 50.f, 20.f, false, ph, &sequence, 1.f/25);
+
+    VisualAdaptationModel still;
+    still.setAdaptation(50.f, 20.f);
+    EXPECT_FLOAT_EQ(sequence.getAcone(), still.getAcone());
+    EXPECT_FLOAT_EQ(sequence.getArod(), still.getArod());
+}
+
+TEST(TemporalTonemap, Mantiuk08ReusesToneCurve)
+{
+    pfs::Progress ph;
+    datmoSequenceState state(25.f);
+
+    pfs::Frame first(64, 48);
+    fillFrame(first, 10.f);
+    pfstmo_mantiuk08(first, 1.f, 1.f, 0.f, false, ph, &state);
+    ASSERT_FALSE(state.tc_y_i.empty());
+    EXPECT_EQ(state.frames_reused, 0u);
+    const double firstMean = state.l_mean;
+
+    // 1% brighter: the log-luminance moves by less than the threshold
+    pfs::Frame similar(64, 48);
+    fillFrame(similar, 10.1f);
+    pfstmo_mantiuk08(similar, 1.f, 1.f, 0.f, false, ph, &state);
+    EXPECT_EQ(state.frames_reused, 1u);
+    EXPECT_EQ(state.l_mean, firstMean);
+
+    // 10 times brighter: the curve is computed again for the new frame
+    pfs::Frame brighter(64, 48);
+    fillFrame(brighter, 100.f);
+    pfstmo_mantiuk08(brighter, 1.f, 1.f, 0.f, false, ph, &state);
+    EXPECT_EQ(state.frames_reused, 1u);
+    EXPECT_NEAR(state.l_mean, firstMean + 1., 1e-3);
+}
+
+TEST(TemporalTonemap, Reinhard02SmoothsStatistics)
+{
+    pfs::Progress ph;
+    Reinhard02TemporalState state;
+
+    pfs::Frame dark(64, 48);
+    fillFrame(dark, 1.f);
+    pfstmo_reinhard02(dark, 0.18f, 1.f, 8, 1, 43, false, ph, &state);
+    const double darkAverage = state.avg_luminance.get();
+
+    pfs::Frame bright(64, 48);
+    fillFrame(bright, 1000.f);
+    pfstmo_reinhard02(bright, 0.18f, 1.f, 8, 1, 43, false, ph, &state);
+
+    // the average luminance moves by 1% of the mean of the old and new
+    // values at most per frame...
+    const double brightAverage = 1000.*darkAverage;
+    EXPECT_NEAR(state.avg_luminance.get(),
+                darkAverage + 0.005*(darkAverage + brightAverage), 1e-3*darkAverage);
+
+    // ... so the bright frame is rendered brighter than a still image
+    pfs::Frame still(64, 48);
+    fillFrame(still, 1000.f);
+    pfstmo_reinhard02(still, 0.18f, 1.f, 8, 1, 43, false, ph);
+    EXPECT_GT(meanLuminance(bright), meanLuminance(still));
+}
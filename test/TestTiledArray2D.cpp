@@ -0,0 +1,104 @@
+/*
+ * This file is a part of Luminance HDR package
+ * ----------------------------------------------------------------------
+ * Copyright (C) 2017 Luminance HDR developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+#include <gtest/gtest.h>
+
+#include <Libpfs/array2d.h>
+#include <Libpfs/tilecache.h>
+#include <Libpfs/tiledarray2d.h>
+
+#include "SeqInt.h"
+
+using namespace pfs;
+
+TEST(TestTiledArray2D, StripLayout)
+{
+    TileCache cache;
+    TiledArray2Df array(100, 130, 64, cache);
+
+    EXPECT_EQ(array.getCols(), 100u);
+    EXPECT_EQ(array.getRows(), 130u);
+    EXPECT_EQ(array.getStripCount(), 3u);
+    EXPECT_EQ(array.stripOf(129), 2u);
+
+    TiledArray2Df::Strip last = array.strip(2);
+    EXPECT_EQ(last.firstRow(), 128u);
+    EXPECT_EQ(last.getRows(), 2u);
+}
+
+TEST(TestTiledArray2D, RoundTrip)
+{
+    TileCache cache;
+
+    Array2D<int> input(37, 91);
+    std::generate(input.begin(), input.end(), SeqInt());
+
+    TiledArray2D<int> tiled(37, 91, 8, cache);
+    tiled.copyFrom(input);
+
+    Array2D<int> output;
+    tiled.copyTo(output);
+
+    ASSERT_EQ(output.getCols(), input.getCols());
+    ASSERT_EQ(output.getRows(), input.getRows());
+    EXPECT_TRUE(std::equal(input.begin(), input.end(), output.begin()));
+}
+
+TEST(TestTiledArray2D, SpillToDisk)
+{
+    // a budget of two strips forces most strips into the swap file
+    const size_t cols = 64;
+    const size_t stripRows = 4;
+    TileCache cache(2*cols*stripRows*sizeof(int));
+
+    Array2D<int> input(cols, 100);
+    std::generate(input.begin(), input.end(), SeqInt());
+
+    TiledArray2D<int> tiled(cols, 100, stripRows, cache);
+    tiled.copyFrom(input);
+
+    EXPECT_LE(cache.residentBytes(), cache.memoryBudget());
+    EXPECT_GT(cache.spilledBytes(), 0u);
+
+    Array2D<int> output;
+    tiled.copyTo(output);
+    EXPECT_TRUE(std::equal(input.begin(), input.end(), output.begin()));
+}
+
+TEST(TestTiledArray2D, ReleaseReusesCache)
+{
+    TileCache cache(1024);
+    {
+        TiledArray2Df array(16, 64, 4, cache);
+        array.fill(1.f);
+        EXPECT_GT(cache.spilledBytes(), 0u);
+    }
+    EXPECT_EQ(cache.residentBytes(), 0u);
+    EXPECT_EQ(cache.spilledBytes(), 0u);
+
+    TiledArray2Df array(16, 64, 4, cache);
+    TiledArray2Df::Strip strip = array.strip(0);
+    // new tiles are zero-initialised, even if they reuse swap space
+    for (size_t idx = 0; idx < strip.size(); ++idx)
+    {
+        EXPECT_EQ(strip.data()[idx], 0.f);
+    }
+}
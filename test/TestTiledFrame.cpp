@@ -0,0 +1,185 @@
+/*
+ * This file is a part of Luminance HDR package
+ * ----------------------------------------------------------------------
+ * Copyright (C) 2017 Luminance HDR developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ * ----------------------------------------------------------------------
+ */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <memory>
+
+#include <Libpfs/frame.h>
+#include <Libpfs/tilecache.h>
+#include <Libpfs/tiledframe.h>
+#include <Libpfs/colorspace/colorspace.h>
+#include <Libpfs/manip/cut.h>
+#include <Libpfs/manip/resize.h>
+#include <Libpfs/io/pfsreader.h>
+#include <Libpfs/io/pfswriter.h>
+#include <Libpfs/io/rgbereader.h>
+#include <Libpfs/io/rgbewriter.h>
+
+#include "FrameTestUtils.h"
+
+using namespace pfs;
+
+namespace
+{
+// strips of 16 rows, so that the frames below span several of them
+const size_t STRIP_ROWS = 16;
+}
+
+TEST(TestTiledFrame, ResizeMatchesResident)
+{
+    TileCache cache;
+    Frame resident;
+    fillFrame(resident, 123, 201);
+
+    TiledFrame tiled(0, 0, STRIP_ROWS, cache);
+    tiled.copyFrom(resident);
+
+    const int sizes[] = { 57, 100, 123, 200 };
+    for (size_t s = 0; s < sizeof(sizes)/sizeof(sizes[0]); ++s)
+    {
+        std::unique_ptr<Frame> expected(resize(&resident, sizes[s], BilinearInterp));
+        std::unique_ptr<Frame> actual(resize(tiled, sizes[s], BilinearInterp));
+
+        compareFrames(*expected, *actual);
+    }
+}
+
+TEST(TestTiledFrame, CutMatchesResident)
+{
+    TileCache cache;
+    Frame resident;
+    fillFrame(resident, 80, 70);
+
+    TiledFrame tiled(0, 0, STRIP_ROWS, cache);
+    tiled.copyFrom(resident);
+
+    // inside a strip, across strips and past the border of the frame
+    std::unique_ptr<Frame> expected(cut(&resident, 3, 2, 40, 10));
+    std::unique_ptr<Frame> actual(cut(tiled, 3, 2, 40, 10));
+    compareFrames(*expected, *actual);
+
+    expected.reset(cut(&resident, 10, 15, 79, 50));
+    actual.reset(cut(tiled, 10, 15, 79, 50));
+    compareFrames(*expected, *actual);
+
+    expected.reset(cut(&resident, 0, 33, 100, 100));
+    actual.reset(cut(tiled, 0, 33, 100, 100));
+    compareFrames(*expected, *actual);
+}
+
+TEST(TestTiledFrame, ColorSpaceMatchesResident)
+{
+    TileCache cache;
+    Frame resident;
+    fillFrame(resident, 47, 53);
+
+    TiledFrame tiled(0, 0, STRIP_ROWS, cache);
+    tiled.copyFrom(resident);
+
+    Channel* X;
+    Channel* Y;
+    Channel* Z;
+    resident.getXYZChannels(X, Y, Z);
+    transformColorSpace(CS_XYZ, X, Y, Z, CS_SRGB, X, Y, Z);
+
+    TiledChannel* tX;
+    TiledChannel* tY;
+    TiledChannel* tZ;
+    tiled.getXYZChannels(tX, tY, tZ);
+    transformColorSpace(CS_XYZ, tX, tY, tZ, CS_SRGB);
+
+    Frame actual;
+    tiled.copyTo(actual);
+    compareFrames(resident, actual);
+}
+
+TEST(TestTiledFrame, PfsWriteStreamsStrips)
+{
+    const std::string filename = "TestTiledFrame.pfs";
+    const std::string residentFilename = "TestTiledFrameResident.pfs";
+
+    TileCache cache;
+    Frame resident;
+    fillFrame(resident, 64, 77);
+
+    TiledFrame tiled(0, 0, STRIP_ROWS, cache);
+    tiled.copyFrom(resident);
+
+    io::PfsWriter writer(filename);
+    ASSERT_TRUE(writer.write(tiled, Params()));
+
+    Frame actual;
+    io::PfsReader reader(filename);
+    reader.read(actual, Params());
+    reader.close();
+
+    compareFrames(resident, actual);
+
+    // same file of the resident writer
+    io::PfsWriter residentWriter(residentFilename);
+    ASSERT_TRUE(residentWriter.write(resident, Params()));
+
+    std::ifstream tiledFile(filename.c_str(), std::ios::binary);
+    std::ifstream residentFile(residentFilename.c_str(), std::ios::binary);
+    EXPECT_TRUE(std::equal(std::istreambuf_iterator<char>(tiledFile),
+                           std::istreambuf_iterator<char>(),
+                           std::istreambuf_iterator<char>(residentFile)));
+
+    std::remove(filename.c_str());
+    std::remove(residentFilename.c_str());
+}
+
+TEST(TestTiledFrame, RgbeReadStreamsStrips)
+{
+    const std::string filename = "TestTiledFrame.hdr";
+
+    Frame input;
+    fillFrame(input, 90, 45);
+    io::RGBEWriter writer(filename);
+    ASSERT_TRUE(writer.write(input, Params()));
+
+    Frame expected;
+    {
+        io::RGBEReader reader(filename);
+        reader.read(expected, Params());
+    }
+
+    TileCache cache;
+    TiledFrame tiled(0, 0, STRIP_ROWS, cache);
+    {
+        io::RGBEReader reader(filename);
+        reader.read(tiled, Params());
+    }
+    EXPECT_EQ(tiled.getStripRows(), STRIP_ROWS);
+    EXPECT_EQ(&tiled.cache(), &cache);
+
+    Frame actual;
+    tiled.copyTo(actual);
+    compareFrames(expected, actual);
+
+    std::remove(filename.c_str());
+}
@@ -62,7 +62,6 @@
 #include "arch/math.h"
 #include "TonemappingOperators/pfstmo.h"
 
-#include "Libpfs/utils/sse.h"
 #include "Libpfs/utils/numeric.h"
 #include "Libpfs/utils/dotproduct.h"
 #include "Libpfs/utils/msec_timer.h"